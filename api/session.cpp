@@ -0,0 +1,308 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "api/session.hpp"
+
+#include <mutex>
+
+#include "engine/atf.hpp"
+#include "engine/kyuafile.hpp"
+#include "engine/plain.hpp"
+#include "engine/scheduler.hpp"
+#include "engine/tap.hpp"
+#include "store/layout.hpp"
+#include "utils/config/tree.ipp"
+#include "utils/format/macros.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/optional.ipp"
+#include "utils/sanity.hpp"
+
+namespace config = utils::config;
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace layout = store::layout;
+namespace run_tests = drivers::run_tests;
+namespace scheduler = engine::scheduler;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Registers the scheduler interfaces known to Kyua, only once.
+///
+/// A program that embeds the library does not go through cli::main(), which is
+/// where kyua(1) does this.
+static void
+register_scheduler_interfaces(void)
+{
+    static std::once_flag registered;
+    std::call_once(registered, [] {
+        scheduler::register_interface(
+            "atf", std::shared_ptr< scheduler::interface >(
+                new engine::atf_interface()));
+        scheduler::register_interface(
+            "plain", std::shared_ptr< scheduler::interface >(
+                new engine::plain_interface()));
+        scheduler::register_interface(
+            "tap", std::shared_ptr< scheduler::interface >(
+                new engine::tap_interface()));
+    });
+}
+
+
+/// Hooks that record the results of a run and forward them to the caller.
+class collecting_hooks : public run_tests::base_hooks {
+    /// The hooks provided by the caller.
+    run_tests::base_hooks& _hooks;
+
+    /// The test programs being run, to recover shared pointers to them.
+    const model::test_programs_vector& _test_programs;
+
+    /// Gets the shared pointer to a test program being run.
+    ///
+    /// \param test_program The test program to look for.
+    ///
+    /// \return The pointer to the test program.
+    model::test_program_ptr
+    find_test_program(const model::test_program& test_program) const
+    {
+        for (model::test_programs_vector::const_iterator
+                 iter = _test_programs.begin(); iter != _test_programs.end();
+             ++iter) {
+            if ((*iter).get() == &test_program)
+                return *iter;
+        }
+        UNREACHABLE_MSG(F("Got result for unknown test program %s") %
+                        test_program.relative_path());
+    }
+
+public:
+    /// Results of the test cases seen so far.
+    api::outcomes_vector outcomes;
+
+    /// Constructor.
+    ///
+    /// \param hooks The hooks provided by the caller.
+    /// \param test_programs The test programs being run.
+    collecting_hooks(run_tests::base_hooks& hooks,
+                     const model::test_programs_vector& test_programs) :
+        _hooks(hooks), _test_programs(test_programs)
+    {
+    }
+
+    /// Called when the processing of a test case begins.
+    ///
+    /// \param test_program The test program containing the test case.
+    /// \param test_case_name The name of the test case being executed.
+    void
+    got_test_case(const model::test_program& test_program,
+                  const std::string& test_case_name)
+    {
+        _hooks.got_test_case(test_program, test_case_name);
+    }
+
+    /// Called when a result of a test case becomes available.
+    ///
+    /// \param test_program The test program containing the test case.
+    /// \param test_case_name The name of the executed test case.
+    /// \param result The result of the execution of the test case.
+    /// \param duration The time it took to run the test.
+    void
+    got_result(const model::test_program& test_program,
+               const std::string& test_case_name,
+               const model::test_result& result,
+               const datetime::delta& duration)
+    {
+        outcomes.push_back(api::test_case_outcome(
+            find_test_program(test_program), test_case_name, result,
+            duration));
+        _hooks.got_result(test_program, test_case_name, result, duration);
+    }
+};
+
+
+}  // anonymous namespace
+
+
+/// Constructor.
+///
+/// \param test_program_ The test program containing the test case.
+/// \param test_case_name_ The name of the test case.
+/// \param result_ The result of the test case.
+/// \param duration_ The time it took to run the test case.
+api::test_case_outcome::test_case_outcome(
+    const model::test_program_ptr test_program_,
+    const std::string& test_case_name_,
+    const model::test_result& result_,
+    const datetime::delta& duration_) :
+    test_program(test_program_),
+    test_case_name(test_case_name_),
+    result(result_),
+    duration(duration_)
+{
+}
+
+
+/// Internal implementation for session.
+struct api::session::impl : utils::noncopyable {
+    /// The user configuration to run the tests with.
+    const config::tree user_config;
+
+    /// The scheduler that loaded the Kyuafile and that runs the tests.
+    ///
+    /// This must outlive kyuafile because the test programs in the latter
+    /// refer to the scheduler to lazily load their test cases.
+    scheduler::scheduler_handle handle;
+
+    /// The loaded Kyuafile.
+    const engine::kyuafile kyuafile;
+
+    /// Whether close() has been called.
+    bool closed;
+
+    /// Constructor.
+    ///
+    /// \param kyuafile_path The path to the Kyuafile to load.
+    /// \param build_root If not none, path to the built test programs.
+    /// \param user_config_ The user configuration to run the tests with.
+    impl(const fs::path& kyuafile_path, const optional< fs::path >& build_root,
+         const config::tree& user_config_) :
+        user_config(user_config_),
+        handle(scheduler::setup()),
+        kyuafile(engine::kyuafile::load(kyuafile_path, build_root,
+                                        user_config, handle)),
+        closed(false)
+    {
+    }
+};
+
+
+/// Loads a Kyuafile to run its tests.
+///
+/// \param kyuafile_path The path to the Kyuafile to load.
+/// \param build_root If not none, path to the built test programs.
+/// \param user_config The user configuration to run the tests with, as
+///     returned by engine::default_config() or engine::load_config().
+///
+/// \throw engine::load_error If the Kyuafile cannot be loaded.
+api::session::session(const fs::path& kyuafile_path,
+                      const optional< fs::path >& build_root,
+                      const config::tree& user_config)
+{
+    register_scheduler_interfaces();
+    _pimpl.reset(new impl(kyuafile_path, build_root, user_config));
+}
+
+
+/// Destructor.
+///
+/// The caller should use close() on its own to get a chance to see errors.
+api::session::~session(void)
+{
+    if (!_pimpl->closed) {
+        try {
+            close();
+        } catch (const std::exception& e) {
+            LW(F("Failed to close session: %s") % e.what());
+        }
+    }
+}
+
+
+/// Gets the loaded Kyuafile.
+///
+/// \return The Kyuafile, whose test programs can be inspected to build
+/// filters.
+const engine::kyuafile&
+api::session::kyuafile(void) const
+{
+    return _pimpl->kyuafile;
+}
+
+
+/// Runs a subset of the test cases into a new results file.
+///
+/// The results file is placed in the default store with an automatically
+/// generated name, as kyua-test(1) does by default.
+///
+/// \param filters The test case filters; an empty set runs all test cases.
+/// \param hooks The hooks for this execution.
+///
+/// \return The results of the run.
+///
+/// \throw store::error If the results file cannot be created.
+api::run_result
+api::session::run(const std::set< engine::test_filter >& filters,
+                  run_tests::base_hooks& hooks)
+{
+    const layout::results_id_file_pair results = layout::new_db(
+        layout::results_auto_create_name, _pimpl->kyuafile.source_root());
+    return run(filters, results.second, hooks);
+}
+
+
+/// Runs a subset of the test cases into a given results file.
+///
+/// \param filters The test case filters; an empty set runs all test cases.
+/// \param store_path The path to the results file to create.
+/// \param hooks The hooks for this execution.
+///
+/// \return The results of the run.
+///
+/// \throw store::error If the results file cannot be created.
+api::run_result
+api::session::run(const std::set< engine::test_filter >& filters,
+                  const fs::path& store_path,
+                  run_tests::base_hooks& hooks)
+{
+    PRE(!_pimpl->closed);
+
+    collecting_hooks collector(hooks, _pimpl->kyuafile.test_programs());
+    const run_tests::result result = run_tests::drive(
+        _pimpl->handle, _pimpl->kyuafile, store_path, none, filters, none,
+        _pimpl->user_config, collector);
+    return run_result(store_path, collector.outcomes, result.unused_filters);
+}
+
+
+/// Releases the resources held by the session.
+///
+/// \pre The session must not have been closed yet.  No further runs are
+/// possible once this returns.
+///
+/// \throw engine::error If the cleanup of the scheduler fails.
+void
+api::session::close(void)
+{
+    PRE(!_pimpl->closed);
+    _pimpl->closed = true;
+    _pimpl->handle.cleanup();
+}
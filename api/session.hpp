@@ -0,0 +1,139 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file api/session.hpp
+/// Embeddable interface to run tests from within another program.
+///
+/// This module, together with the headers it includes, is the stable interface
+/// of the installed libkyua library.  It lets a program load a Kyuafile once
+/// and then run subsets of its test cases as many times as needed without the
+/// cost of spawning kyua(1), reloading the Kyuafile or relisting the test cases
+/// of the test programs.  The results of every run are recorded in a results
+/// file, as kyua-test(1) does, and are also returned as in-memory objects.
+///
+/// Programs using this library must not run more than one session at a time
+/// because the executor of test cases is a process-wide resource.
+
+#if !defined(API_SESSION_HPP)
+#define API_SESSION_HPP
+
+#include "api/session_fwd.hpp"
+
+#include <memory>
+#include <set>
+#include <string>
+
+#include "drivers/run_tests.hpp"
+#include "engine/filters.hpp"
+#include "engine/kyuafile_fwd.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "utils/config/tree_fwd.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/optional_fwd.hpp"
+
+namespace api {
+
+
+/// Result of the execution of a single test case.
+struct test_case_outcome {
+    /// The test program containing the test case.
+    model::test_program_ptr test_program;
+
+    /// The name of the test case.
+    std::string test_case_name;
+
+    /// The result of the test case.
+    model::test_result result;
+
+    /// The time it took to run the test case.
+    utils::datetime::delta duration;
+
+    test_case_outcome(const model::test_program_ptr, const std::string&,
+                      const model::test_result&,
+                      const utils::datetime::delta&);
+};
+
+
+/// Tuple containing the results of a run.
+class run_result {
+public:
+    /// Path to the results file that holds the results of the run.
+    utils::fs::path store_path;
+
+    /// Results of the test cases, in the order in which they completed.
+    outcomes_vector outcomes;
+
+    /// Filters that did not match any available test case.
+    std::set< engine::test_filter > unused_filters;
+
+    /// Initializer for the tuple's fields.
+    ///
+    /// \param store_path_ Path to the results file of the run.
+    /// \param outcomes_ Results of the test cases.
+    /// \param unused_filters_ The filters that did not match any test case.
+    run_result(const utils::fs::path& store_path_,
+               const outcomes_vector& outcomes_,
+               const std::set< engine::test_filter >& unused_filters_) :
+        store_path(store_path_), outcomes(outcomes_),
+        unused_filters(unused_filters_)
+    {
+    }
+};
+
+
+/// Test suite loaded once and run as many times as needed.
+class session : utils::noncopyable {
+    struct impl;
+
+    /// Pointer to the internal implementation.
+    std::auto_ptr< impl > _pimpl;
+
+public:
+    session(const utils::fs::path&,
+            const utils::optional< utils::fs::path >&,
+            const utils::config::tree&);
+    ~session(void);
+
+    const engine::kyuafile& kyuafile(void) const;
+
+    run_result run(const std::set< engine::test_filter >&,
+                   drivers::run_tests::base_hooks&);
+    run_result run(const std::set< engine::test_filter >&,
+                   const utils::fs::path&,
+                   drivers::run_tests::base_hooks&);
+
+    void close(void);
+};
+
+
+}  // namespace api
+
+#endif  // !defined(API_SESSION_HPP)
@@ -0,0 +1,254 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "api/session.hpp"
+
+extern "C" {
+#include <sys/stat.h>
+}
+
+#include <fstream>
+#include <set>
+#include <string>
+
+#include <atf-c++.hpp>
+
+#include "engine/config.hpp"
+#include "engine/filters.hpp"
+#include "engine/kyuafile.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "utils/config/tree.ipp"
+#include "utils/env.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+
+using utils::none;
+
+
+namespace {
+
+
+/// Hooks that record the test cases seen by a run.
+class capture_hooks : public drivers::run_tests::base_hooks {
+public:
+    /// Test cases that started, in program:test_case form.
+    std::set< std::string > started;
+
+    /// Test cases that finished, in program:test_case form.
+    std::set< std::string > finished;
+
+    /// Called when the processing of a test case begins.
+    ///
+    /// \param test_program The test program containing the test case.
+    /// \param test_case_name The name of the test case being executed.
+    void
+    got_test_case(const model::test_program& test_program,
+                  const std::string& test_case_name)
+    {
+        started.insert(F("%s:%s") % test_program.relative_path() %
+                       test_case_name);
+    }
+
+    /// Called when a result of a test case becomes available.
+    ///
+    /// \param test_program The test program containing the test case.
+    /// \param test_case_name The name of the executed test case.
+    void
+    got_result(const model::test_program& test_program,
+               const std::string& test_case_name,
+               const model::test_result& /* result */,
+               const datetime::delta& /* duration */)
+    {
+        finished.insert(F("%s:%s") % test_program.relative_path() %
+                        test_case_name);
+    }
+};
+
+
+/// Creates a test suite with a passing and a failing plain test program.
+///
+/// The test programs record every execution in a file named after them so
+/// that tests can verify how many times they ran.
+static void
+create_test_suite(void)
+{
+    std::ofstream kyuafile("Kyuafile");
+    kyuafile << "syntax(2)\n"
+             << "test_suite('api')\n"
+             << "plain_test_program{name='pass'}\n"
+             << "plain_test_program{name='fail'}\n";
+    kyuafile.close();
+
+    const fs::path log = fs::current_path() / "runs.log";
+    const char* const programs[][2] = {{"pass", "0"}, {"fail", "1"}};
+    for (std::size_t i = 0; i < 2; ++i) {
+        std::ofstream program(programs[i][0]);
+        program << "#! /bin/sh\n"
+                << "echo " << programs[i][0] << " >>" << log << "\n"
+                << "exit " << programs[i][1] << "\n";
+        program.close();
+        ATF_REQUIRE(::chmod(programs[i][0], 0755) != -1);
+    }
+}
+
+
+/// Counts the lines in a file.
+///
+/// \param file The file to read.
+///
+/// \return The number of lines in the file.
+static std::size_t
+count_lines(const fs::path& file)
+{
+    std::ifstream input(file.c_str());
+    std::size_t count = 0;
+    std::string line;
+    while (std::getline(input, line).good())
+        ++count;
+    return count;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(session__kyuafile);
+ATF_TEST_CASE_BODY(session__kyuafile)
+{
+    create_test_suite();
+
+    api::session session(fs::path("Kyuafile"), none, engine::default_config());
+    ATF_REQUIRE_EQ(2, session.kyuafile().test_programs().size());
+    session.close();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(run__all);
+ATF_TEST_CASE_BODY(run__all)
+{
+    create_test_suite();
+
+    api::session session(fs::path("Kyuafile"), none, engine::default_config());
+    capture_hooks hooks;
+    const api::run_result result = session.run(
+        std::set< engine::test_filter >(), fs::path("results.db"), hooks);
+    session.close();
+
+    ATF_REQUIRE_EQ(fs::path("results.db"), result.store_path);
+    ATF_REQUIRE(fs::exists(result.store_path));
+    ATF_REQUIRE(result.unused_filters.empty());
+
+    ATF_REQUIRE_EQ(2, result.outcomes.size());
+    for (api::outcomes_vector::const_iterator iter = result.outcomes.begin();
+         iter != result.outcomes.end(); ++iter) {
+        ATF_REQUIRE_EQ("main", (*iter).test_case_name);
+        if ((*iter).test_program->relative_path() == fs::path("pass"))
+            ATF_REQUIRE((*iter).result.good());
+        else
+            ATF_REQUIRE_EQ(model::test_result_failed, (*iter).result.type());
+    }
+
+    std::set< std::string > exp_test_cases;
+    exp_test_cases.insert("pass:main");
+    exp_test_cases.insert("fail:main");
+    ATF_REQUIRE(exp_test_cases == hooks.started);
+    ATF_REQUIRE(exp_test_cases == hooks.finished);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(run__repeated_subsets);
+ATF_TEST_CASE_BODY(run__repeated_subsets)
+{
+    create_test_suite();
+
+    api::session session(fs::path("Kyuafile"), none, engine::default_config());
+
+    for (int i = 0; i < 3; ++i) {
+        std::set< engine::test_filter > filters;
+        filters.insert(engine::test_filter(fs::path("pass"), ""));
+        capture_hooks hooks;
+        const api::run_result result = session.run(
+            filters, fs::path(F("results.%s.db") % i), hooks);
+        ATF_REQUIRE_EQ(1, result.outcomes.size());
+        ATF_REQUIRE_EQ(fs::path("pass"),
+                       result.outcomes[0].test_program->relative_path());
+        ATF_REQUIRE(result.outcomes[0].result.good());
+        ATF_REQUIRE(fs::exists(result.store_path));
+    }
+    ATF_REQUIRE_EQ(3, count_lines(fs::path("runs.log")));
+
+    std::set< engine::test_filter > filters;
+    filters.insert(engine::test_filter(fs::path("fail"), ""));
+    filters.insert(engine::test_filter(fs::path("missing"), ""));
+    capture_hooks hooks;
+    const api::run_result result = session.run(
+        filters, fs::path("results.fail.db"), hooks);
+    ATF_REQUIRE_EQ(1, result.outcomes.size());
+    ATF_REQUIRE_EQ(model::test_result_failed,
+                   result.outcomes[0].result.type());
+    ATF_REQUIRE_EQ(1, result.unused_filters.size());
+    ATF_REQUIRE_EQ(fs::path("missing"),
+                   (*result.unused_filters.begin()).test_program);
+
+    session.close();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(run__default_store);
+ATF_TEST_CASE_BODY(run__default_store)
+{
+    create_test_suite();
+    utils::setenv("HOME", (fs::current_path() / "home").str());
+
+    api::session session(fs::path("Kyuafile"), none, engine::default_config());
+    capture_hooks hooks;
+    const api::run_result result = session.run(
+        std::set< engine::test_filter >(), hooks);
+    session.close();
+
+    ATF_REQUIRE_EQ(2, result.outcomes.size());
+    ATF_REQUIRE(fs::exists(result.store_path));
+    ATF_REQUIRE_EQ(fs::current_path() / "home/.kyua/store",
+                   result.store_path.branch_path());
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, session__kyuafile);
+
+    ATF_ADD_TEST_CASE(tcs, run__all);
+    ATF_ADD_TEST_CASE(tcs, run__repeated_subsets);
+    ATF_ADD_TEST_CASE(tcs, run__default_store);
+}
@@ -28,23 +28,33 @@
 
 #include "cli/cmd_report.hpp"
 
+extern "C" {
+#include <stdint.h>
+}
+
 #include <algorithm>
 #include <cstddef>
 #include <cstdlib>
 #include <map>
 #include <ostream>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "cli/common.ipp"
 #include "drivers/scan_results.hpp"
+#include "engine/filters.hpp"
 #include "model/context.hpp"
 #include "model/metadata.hpp"
 #include "model/test_case.hpp"
 #include "model/test_program.hpp"
 #include "model/test_result.hpp"
 #include "model/types.hpp"
+#include "store/exceptions.hpp"
 #include "store/layout.hpp"
+#include "store/output_index.hpp"
+#include "store/read_backend.hpp"
 #include "store/read_transaction.hpp"
 #include "utils/cmdline/exceptions.hpp"
 #include "utils/cmdline/options.hpp"
@@ -81,6 +91,9 @@ class report_console_hooks : public drivers::scan_results::base_hooks {
     /// Whether to include details in the report or not.
     const bool _verbose;
 
+    /// Whether to collapse failures with the same signature into one line.
+    const bool _group_failures;
+
     /// Collection of result types to include in the report.
     const cli::result_types& _results_filters;
 
@@ -111,18 +124,23 @@ class report_console_hooks : public drivers::scan_results::base_hooks {
         /// The duration of the test case execution.
         utils::datetime::delta duration;
 
+        /// The signature of the failure; empty if not needed.
+        std::string signature;
+
         /// Constructs a new results data.
         ///
         /// \param binary_path_ The relative path to the test program.
         /// \param test_case_name_ The name of the test case.
         /// \param result_ The result of the test case.
         /// \param duration_ The duration of the test case execution.
+        /// \param signature_ The signature of the failure, if any.
         result_data(const utils::fs::path& binary_path_,
                     const std::string& test_case_name_,
                     const model::test_result& result_,
-                    const utils::datetime::delta& duration_) :
+                    const utils::datetime::delta& duration_,
+                    const std::string& signature_) :
             binary_path(binary_path_), test_case_name(test_case_name_),
-            result(result_), duration(duration_)
+            result(result_), duration(duration_), signature(signature_)
         {
         }
     };
@@ -133,6 +151,9 @@ class report_console_hooks : public drivers::scan_results::base_hooks {
     /// memory may be too much.
     std::map< model::test_result_type, std::vector< result_data > > _results;
 
+    /// Descriptions of the test cases suspected of suffering from interference.
+    std::vector< std::string > _interference;
+
     /// Pretty-prints the value of an environment variable.
     ///
     /// \param indent Prefix for the lines to print.  Continuation lines
@@ -244,6 +265,59 @@ class report_console_hooks : public drivers::scan_results::base_hooks {
             return (*iter).second.size();
     }
 
+    /// Prints a set of failures grouped by their signature.
+    ///
+    /// Groups are sorted by decreasing size so that the most common cause of
+    /// failure comes first, and each group is represented by its first member.
+    ///
+    /// \param all The results to print.
+    void
+    print_grouped_results(const std::vector< result_data >& all)
+    {
+        typedef std::vector< std::pair< std::size_t,
+                                        std::vector< result_data >::size_type > >
+            groups_vector;
+        groups_vector groups;  // (members, index of first member) pairs.
+
+        std::map< std::string, groups_vector::size_type > group_by_signature;
+        for (std::vector< result_data >::size_type i = 0; i < all.size(); ++i) {
+            const std::map< std::string, groups_vector::size_type >::iterator
+                match = group_by_signature.find(all[i].signature);
+            if (match == group_by_signature.end()) {
+                group_by_signature[all[i].signature] = groups.size();
+                groups.push_back(std::make_pair(1, i));
+            } else {
+                ++groups[(*match).second].first;
+            }
+        }
+
+        std::stable_sort(groups.begin(), groups.end(), bigger_group_first);
+
+        for (groups_vector::const_iterator iter = groups.begin();
+             iter != groups.end(); ++iter) {
+            const result_data& first = all[(*iter).second];
+            _output << F("[%s test case%s] %s:%s  ->  %s  [%s]\n") %
+                (*iter).first % ((*iter).first == 1 ? "" : "s") %
+                first.binary_path % first.test_case_name %
+                cli::format_result(first.result) %
+                cli::format_delta(first.duration);
+        }
+    }
+
+    /// Sorting predicate to order groups of failures by decreasing size.
+    ///
+    /// \param a The first group to compare.
+    /// \param b The second group to compare.
+    ///
+    /// \return True if \p a has more members than \p b.
+    static bool
+    bigger_group_first(
+        const std::pair< std::size_t, std::vector< result_data >::size_type >& a,
+        const std::pair< std::size_t, std::vector< result_data >::size_type >& b)
+    {
+        return a.first > b.first;
+    }
+
     /// Prints a set of results.
     ///
     /// \param type Test result type to print results for.
@@ -260,6 +334,11 @@ class report_console_hooks : public drivers::scan_results::base_hooks {
         const std::vector< result_data >& all = (*iter2).second;
 
         _output << F("===> %s\n") % title;
+        if (_group_failures && (type == model::test_result_broken ||
+                                type == model::test_result_failed)) {
+            print_grouped_results(all);
+            return;
+        }
         for (std::vector< result_data >::const_iterator iter = all.begin();
              iter != all.end(); iter++) {
             _output << F("%s:%s  ->  %s  [%s]\n") % (*iter).binary_path %
@@ -274,14 +353,17 @@ public:
     ///
     /// \param [out] output_ Stream to which to write the report.
     /// \param verbose_ Whether to include details in the output or not.
+    /// \param group_failures_ Whether to group failures by their signature.
     /// \param results_filters_ The result types to include in the report.
     ///     Cannot be empty.
     /// \param results_file_ Path to the results file being read.
     report_console_hooks(std::ostream& output_, const bool verbose_,
+                         const bool group_failures_,
                          const cli::result_types& results_filters_,
                          const fs::path& results_file_) :
         _output(output_),
         _verbose(verbose_),
+        _group_failures(group_failures_),
         _results_filters(results_filters_),
         _results_file(results_file_)
     {
@@ -315,7 +397,21 @@ public:
         const model::test_result result = iter.result();
         _results[result.type()].push_back(
             result_data(iter.test_program()->relative_path(),
-                        iter.test_case_name(), iter.result(), duration));
+                        iter.test_case_name(), iter.result(), duration,
+                        _group_failures ? iter.failure_signature() : ""));
+
+        const optional< model::test_result > concurrent_result =
+            iter.interference();
+        if (concurrent_result) {
+            const std::vector< std::string > overlapping =
+                iter.interfering_tests();
+            _interference.push_back(
+                F("%s:%s  ->  %s when run alongside %s") %
+                iter.test_program()->relative_path() % iter.test_case_name() %
+                cli::format_result(concurrent_result.get()) %
+                (overlapping.empty() ? std::string("no other test cases") :
+                 text::join(overlapping, ", ")));
+        }
 
         if (_verbose) {
             // TODO(jmmv): _results_filters is a list and is small enough for
@@ -357,6 +453,14 @@ public:
             model::test_result_expected_failure);
         const std::size_t total = broken + failed + passed + skipped + xfail;
 
+        if (!_interference.empty()) {
+            _output << "===> Interference suspected\n";
+            for (std::vector< std::string >::const_iterator
+                     iter = _interference.begin(); iter != _interference.end();
+                 ++iter)
+                _output << *iter << "\n";
+        }
+
         _output << "===> Summary\n";
         _output << F("Results read from %s\n") % _results_file;
         _output << F("Test cases: %s total, %s skipped, %s expected failures, "
@@ -374,6 +478,90 @@ public:
 };
 
 
+/// Gets a user-friendly name for the source of an output match.
+///
+/// \param source The source as stored in the output index.
+///
+/// \return The name of the source to print.
+static std::string
+format_source(const std::string& source)
+{
+    if (source == "__STDOUT__")
+        return "stdout";
+    else if (source == "__STDERR__")
+        return "stderr";
+    else if (source == store::detail::reason_source)
+        return "reason";
+    else
+        return source;
+}
+
+
+/// Prints the test cases whose output matches a query.
+///
+/// \param ui Object to interact with the I/O of the program.
+/// \param output Stream to which to write the report.
+/// \param results_file Path to the results file to query.
+/// \param query The query to search for, in the syntax of FTS5 queries.
+/// \param raw_filters The test case filters as provided by the user.
+///
+/// \return True if the search succeeded and all the filters matched at least
+/// one test case; false otherwise.
+static bool
+report_matches(cmdline::ui* ui, std::ostream& output,
+               const fs::path& results_file, const std::string& query,
+               const std::set< engine::test_filter >& raw_filters)
+{
+    engine::filters_state filters(raw_filters);
+
+    std::vector< store::output_match > matches;
+    try {
+        store::read_backend db =
+            store::read_backend::open_ro_immutable(results_file);
+        store::read_transaction tx = db.start_read();
+        if (!tx.has_output_index()) {
+            cmdline::print_error(ui, F("Results file %s has no output index; "
+                                       "run 'kyua db-index' first.") %
+                                 results_file);
+            return false;
+        }
+        matches = tx.search_output(query);
+    } catch (const store::error& e) {
+        cmdline::print_error(ui, F("%s.") % e.what());
+        return false;
+    }
+
+    std::size_t num_matches = 0;
+    std::set< int64_t > test_case_ids;
+    output << F("===> Matches for '%s'\n") % query;
+    for (std::vector< store::output_match >::const_iterator
+             iter = matches.begin(); iter != matches.end(); ++iter) {
+        const store::output_match& match = *iter;
+        if (!filters.match_test_program(match.test_program) ||
+            !filters.match_test_case(match.test_program,
+                                     match.test_case_name))
+            continue;
+
+        std::string snippet = match.snippet;
+        std::replace(snippet.begin(), snippet.end(), '\n', ' ');
+        std::replace(snippet.begin(), snippet.end(), '\t', ' ');
+        snippet.erase(snippet.find_last_not_of(' ') + 1);
+        output << F("%s:%s (%s): %s\n") % match.test_program %
+            match.test_case_name % format_source(match.source) % snippet;
+
+        ++num_matches;
+        test_case_ids.insert(match.test_case_id);
+    }
+
+    output << "===> Summary\n";
+    output << F("Results read from %s\n") % results_file;
+    output << F("Matches: %s in %s test cases\n") % num_matches %
+        test_case_ids.size();
+
+    return !cli::report_unused_filters(filters.unused(), ui);
+}
+
+
 }  // anonymous namespace
 
 
@@ -389,6 +577,12 @@ cmd_report::cmd_report(void) : cli_command(
     add_option(cmdline::path_option("output", "Path to the output file", "path",
                                     "/dev/stdout"));
     add_option(results_filter_option);
+    add_option(cmdline::string_option(
+        "grep", "Only list the test cases whose output matches a query; "
+        "requires an output index", "query"));
+    add_option(cmdline::bool_option(
+        "group-failures", "Collapse broken and failed test cases with the "
+        "same failure signature into a single line"));
 }
 
 
@@ -410,8 +604,16 @@ cmd_report::run(cmdline::ui* ui,
     const fs::path results_file = layout::find_results(
         results_file_open(cmdline));
 
+    if (cmdline.has_option("grep")) {
+        return report_matches(
+            ui, *output.get(), results_file,
+            cmdline.get_option< cmdline::string_option >("grep"),
+            parse_filters(cmdline.arguments())) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     const result_types types = get_result_types(cmdline);
     report_console_hooks hooks(*output.get(), cmdline.has_option("verbose"),
+                               cmdline.has_option("group-failures"),
                                types, results_file);
     const drivers::scan_results::result result = drivers::scan_results::drive(
         results_file, parse_filters(cmdline.arguments()), hooks);
@@ -0,0 +1,529 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "cli/cmd_report_serve.hpp"
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include "cli/common.ipp"
+#include "drivers/serve_results.hpp"
+#include "model/context.hpp"
+#include "model/metadata.hpp"
+#include "model/test_case.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/layout.hpp"
+#include "store/read_transaction.hpp"
+#include "utils/cmdline/exceptions.hpp"
+#include "utils/cmdline/options.hpp"
+#include "utils/cmdline/parser.ipp"
+#include "utils/cmdline/ui.hpp"
+#include "utils/datetime.hpp"
+#include "utils/env.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+#include "utils/sanity.hpp"
+#include "utils/text/exceptions.hpp"
+#include "utils/text/operations.ipp"
+#include "utils/text/templates.hpp"
+
+namespace cmdline = utils::cmdline;
+namespace config = utils::config;
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace layout = store::layout;
+namespace serve_results = drivers::serve_results;
+namespace text = utils::text;
+
+using utils::optional;
+
+
+namespace {
+
+
+/// Maximum number of bytes of stdout and stderr to embed in test case pages.
+///
+/// Anything longer than this is truncated and must be fetched separately.
+static const int64_t max_inline_output = 1024 * 1024;
+
+
+/// Parses the value of the --listen flag.
+///
+/// \param raw The value to parse, in the address:port form.
+///
+/// \return The address and the port.
+///
+/// \throw cmdline::usage_error If the value is invalid.
+static std::pair< std::string, int >
+parse_listen(const std::string& raw)
+{
+    const std::string::size_type colon = raw.rfind(':');
+    if (colon == std::string::npos || colon == 0)
+        throw cmdline::usage_error(F("Invalid value '%s' passed to --listen; "
+                                     "must be of the form address:port") % raw);
+
+    int port;
+    try {
+        port = text::to_type< int >(raw.substr(colon + 1));
+    } catch (const text::value_error& e) {
+        port = -1;
+    }
+    if (port < 0 || port > 65535)
+        throw cmdline::usage_error(F("Invalid port in --listen value '%s'") %
+                                   raw);
+
+    return std::make_pair(raw.substr(0, colon), port);
+}
+
+
+/// Adds a string to string map to the templates.
+///
+/// \param [in,out] templates The templates to add the map to.
+/// \param props The map to add to the templates.
+/// \param key_vector Name of the template vector that holds the keys.
+/// \param value_vector Name of the template vector that holds the values.
+static void
+add_map(text::templates_def& templates, const config::properties_map& props,
+        const std::string& key_vector, const std::string& value_vector)
+{
+    templates.add_vector(key_vector);
+    templates.add_vector(value_vector);
+
+    for (config::properties_map::const_iterator iter = props.begin();
+         iter != props.end(); ++iter) {
+        templates.add_to_vector(key_vector, (*iter).first);
+        templates.add_to_vector(value_vector, (*iter).second);
+    }
+}
+
+
+/// Gets the template vectors that hold the test cases of a given result type.
+///
+/// \param type The result type to query.
+///
+/// \return The name of the vector with the test case names and the name of the
+/// vector with the links to their pages.  Keep in sync with index.html.
+static std::pair< std::string, std::string >
+summary_vectors(const model::test_result_type type)
+{
+    switch (type) {
+    case model::test_result_broken:
+        return std::make_pair("broken_test_cases", "broken_test_cases_file");
+    case model::test_result_expected_failure:
+        return std::make_pair("xfail_test_cases", "xfail_test_cases_file");
+    case model::test_result_failed:
+        return std::make_pair("failed_test_cases", "failed_test_cases_file");
+    case model::test_result_passed:
+        return std::make_pair("passed_test_cases", "passed_test_cases_file");
+    case model::test_result_skipped:
+        return std::make_pair("skipped_test_cases", "skipped_test_cases_file");
+    }
+    UNREACHABLE;
+}
+
+
+/// Serves an HTML report on demand.
+///
+/// Pages are rendered with the same templates used by report-html, but only
+/// when requested and by querying just the data they need.
+class serve_hooks : public serve_results::base_hooks {
+    /// User interface object where to report progress.
+    cmdline::ui* _ui;
+
+    /// The results file being served, for informational purposes.
+    const fs::path _results_file;
+
+    /// Default collection of result types to include in the summary.
+    const cli::result_types _results_filters;
+
+    /// Generates a common set of templates for all of our pages.
+    ///
+    /// \return A new templates object with common parameters.
+    static text::templates_def
+    common_templates(void)
+    {
+        text::templates_def templates;
+        templates.add_variable("css", "report.css");
+        return templates;
+    }
+
+    /// Gets the contents of a file shipped with Kyua.
+    ///
+    /// \param name The name of the file within the installed directory.
+    ///
+    /// \return The contents of the file.
+    ///
+    /// \throw std::runtime_error If the file cannot be read.
+    static std::string
+    read_misc_file(const std::string& name)
+    {
+        const fs::path miscdir(utils::getenv_with_default(
+             "KYUA_MISCDIR", KYUA_MISCDIR));
+        const fs::path file = miscdir / name;
+        std::ifstream input(file.c_str());
+        if (!input)
+            throw std::runtime_error(F("Cannot open %s") % file);
+        std::ostringstream output;
+        output << input.rdbuf();
+        return output.str();
+    }
+
+    /// Instantiates a template to generate an HTML page.
+    ///
+    /// \param templates The templates to use.
+    /// \param template_name The name of the template.  This is automatically
+    ///     searched for in the installed directory, so do not provide a path.
+    ///
+    /// \return A response with the generated page.
+    ///
+    /// \throw text::error If there is any problem applying the templates.
+    static serve_results::response
+    generate(const text::templates_def& templates,
+             const std::string& template_name)
+    {
+        std::istringstream input(read_misc_file(template_name));
+        std::ostringstream output;
+        text::instantiate(templates, input, output);
+        return serve_results::response(200, "text/html; charset=utf-8",
+                                       output.str());
+    }
+
+    /// Generates the summary page.
+    ///
+    /// \param tx The transaction to query the results file from.
+    /// \param req The request being served.  The optional results-filter
+    ///     parameter overrides the default result types to list.
+    ///
+    /// \return The response to send.
+    serve_results::response
+    index(store::read_transaction& tx, const serve_results::request& req)
+    {
+        cli::result_types types = _results_filters;
+        const serve_results::request::query_map::const_iterator filter =
+            req.query.find("results-filter");
+        if (filter != req.query.end()) {
+            try {
+                types = cli::parse_result_types(
+                    text::split((*filter).second, ','));
+            } catch (const std::runtime_error& e) {
+                return serve_results::response(400, "text/plain",
+                                               F("%s\n") % e.what());
+            }
+            if (types.empty())
+                types = cli::parse_result_types(text::split(
+                    "passed,skipped,xfail,broken,failed", ','));
+        }
+
+        text::templates_def templates = common_templates();
+        for (cli::result_types::const_iterator iter = types.begin();
+             iter != types.end(); ++iter) {
+            const std::pair< std::string, std::string > vectors =
+                summary_vectors(*iter);
+            templates.add_vector(vectors.first);
+            templates.add_vector(vectors.second);
+        }
+        // Keep in sync with index.html: all vectors must exist.
+        const model::test_result_type all_types[] = {
+            model::test_result_broken, model::test_result_expected_failure,
+            model::test_result_failed, model::test_result_passed,
+            model::test_result_skipped };
+        for (std::size_t i = 0; i < sizeof(all_types) / sizeof(all_types[0]);
+             ++i) {
+            const std::pair< std::string, std::string > vectors =
+                summary_vectors(all_types[i]);
+            if (!templates.exists(vectors.first)) {
+                templates.add_vector(vectors.first);
+                templates.add_vector(vectors.second);
+            }
+        }
+
+        optional< datetime::timestamp > start_time;
+        optional< datetime::timestamp > end_time;
+        datetime::delta runtime;
+        store::results_iterator iter = tx.get_results(
+            std::set< model::test_result_type >(types.begin(), types.end()));
+        for (; iter; ++iter) {
+            const std::pair< std::string, std::string > vectors =
+                summary_vectors(iter.result().type());
+            templates.add_to_vector(
+                vectors.first,
+                cli::format_test_case_id(*iter.test_program(),
+                                         iter.test_case_name()));
+            templates.add_to_vector(vectors.second,
+                                    F("test-%s.html") % iter.test_case_id());
+
+            if (!start_time || start_time.get() > iter.start_time())
+                start_time = iter.start_time();
+            if (!end_time || end_time.get() < iter.end_time())
+                end_time = iter.end_time();
+            runtime += iter.end_time() - iter.start_time();
+        }
+
+        if (start_time) {
+            INV(end_time);
+            templates.add_variable("start_time",
+                                   start_time.get().to_iso8601_in_utc());
+            templates.add_variable("end_time",
+                                   end_time.get().to_iso8601_in_utc());
+        } else {
+            templates.add_variable("start_time", "No tests run");
+            templates.add_variable("end_time", "No tests run");
+        }
+        templates.add_variable("duration", cli::format_delta(runtime));
+
+        std::map< model::test_result_type, std::size_t > counts =
+            tx.count_results();
+        templates.add_variable("passed_tests_count",
+                               F("%s") % counts[model::test_result_passed]);
+        templates.add_variable("failed_tests_count",
+                               F("%s") % counts[model::test_result_failed]);
+        templates.add_variable("skipped_tests_count",
+                               F("%s") % counts[model::test_result_skipped]);
+        templates.add_variable(
+            "xfail_tests_count",
+            F("%s") % counts[model::test_result_expected_failure]);
+        templates.add_variable("broken_tests_count",
+                               F("%s") % counts[model::test_result_broken]);
+        templates.add_variable(
+            "bad_tests_count",
+            F("%s") % (counts[model::test_result_broken] +
+                       counts[model::test_result_failed]));
+
+        return generate(templates, "index.html");
+    }
+
+    /// Generates the page describing the execution context.
+    ///
+    /// \param tx The transaction to query the results file from.
+    ///
+    /// \return The response to send.
+    serve_results::response
+    context(store::read_transaction& tx)
+    {
+        const model::context context = tx.get_context();
+
+        text::templates_def templates = common_templates();
+        templates.add_variable("cwd", context.cwd().str());
+        add_map(templates, context.env(), "env_var", "env_var_value");
+        return generate(templates, "context.html");
+    }
+
+    /// Adds the output of a test case to the templates.
+    ///
+    /// \param [in,out] templates The templates to add the output to.
+    /// \param tx The transaction to query the results file from.
+    /// \param test_case_id The test case whose output to add.
+    /// \param name The name of the output: stdout or stderr.
+    /// \param file_name The name of the test case file holding the output.
+    static void
+    add_output(text::templates_def& templates, store::read_transaction& tx,
+               const int64_t test_case_id, const std::string& name,
+               const std::string& file_name)
+    {
+        const optional< int64_t > size = tx.get_test_case_file_size(
+            test_case_id, file_name);
+        if (!size || size.get() == 0)
+            return;
+
+        std::string contents = tx.get_test_case_file_chunk(
+            test_case_id, file_name, 0, max_inline_output);
+        if (size.get() > max_inline_output)
+            contents += F("\n[... truncated; %s bytes in total ...]\n") %
+                size.get();
+        templates.add_variable(name, text::escape_xml(contents));
+        templates.add_variable(name + "_file",
+                               F("test-%s.%s") % test_case_id % name);
+    }
+
+    /// Generates the page describing a test case.
+    ///
+    /// \param tx The transaction to query the results file from.
+    /// \param test_case_id The identifier of the test case to describe.
+    ///
+    /// \return The response to send.
+    serve_results::response
+    test_case(store::read_transaction& tx, const int64_t test_case_id)
+    {
+        store::results_iterator iter = tx.get_result(test_case_id);
+        if (!iter)
+            return serve_results::response(
+                404, "text/plain", F("No test case with identifier %s\n") %
+                test_case_id);
+
+        const model::test_program_ptr test_program = iter.test_program();
+        const std::string& test_case_name = iter.test_case_name();
+        const datetime::delta duration = iter.end_time() - iter.start_time();
+
+        text::templates_def templates = common_templates();
+        templates.add_variable("test_case",
+                               cli::format_test_case_id(*test_program,
+                                                        test_case_name));
+        templates.add_variable("test_program",
+                               test_program->absolute_path().str());
+        templates.add_variable("result", cli::format_result(iter.result()));
+        templates.add_variable("start_time",
+                               iter.start_time().to_iso8601_in_utc());
+        templates.add_variable("end_time",
+                               iter.end_time().to_iso8601_in_utc());
+        templates.add_variable("duration", cli::format_delta(duration));
+
+        const model::test_case& test_case = test_program->find(test_case_name);
+        add_map(templates, test_case.get_metadata().to_properties(),
+                "metadata_var", "metadata_value");
+
+        add_output(templates, tx, test_case_id, "stdout", "__STDOUT__");
+        add_output(templates, tx, test_case_id, "stderr", "__STDERR__");
+
+        return generate(templates, "test_result.html");
+    }
+
+public:
+    /// Constructor for the hooks.
+    ///
+    /// \param ui_ User interface object where to report progress.
+    /// \param results_file_ The results file being served.
+    /// \param results_filters_ The result types to list in the summary by
+    ///     default.  Cannot be empty.
+    serve_hooks(cmdline::ui* ui_, const fs::path& results_file_,
+                const cli::result_types& results_filters_) :
+        _ui(ui_),
+        _results_file(results_file_),
+        _results_filters(results_filters_)
+    {
+        PRE(!results_filters_.empty());
+    }
+
+    /// Callback executed once the server is ready to accept connections.
+    ///
+    /// \param address The address the server is listening on.
+    /// \param port The port the server is listening on.
+    void
+    listening(const std::string& address, const int port)
+    {
+        _ui->out(F("Serving %s at http://%s:%s/") % _results_file % address %
+                 port);
+        _ui->out("Press Ctrl+C to stop");
+    }
+
+    /// Callback executed for every request.
+    ///
+    /// \param tx Transaction to query the results file from.
+    /// \param req The request to answer.
+    ///
+    /// \return The response to send to the client.
+    serve_results::response
+    got_request(store::read_transaction& tx, const serve_results::request& req)
+    {
+        if (req.path == "/" || req.path == "/index.html") {
+            return index(tx, req);
+        } else if (req.path == "/context.html") {
+            return context(tx);
+        } else if (req.path == "/report.css") {
+            return serve_results::response(200, "text/css",
+                                           read_misc_file("report.css"));
+        } else if (req.path.compare(0, 6, "/test-") == 0) {
+            const std::string::size_type dot = req.path.find('.');
+            const std::string extension = dot == std::string::npos ?
+                "" : req.path.substr(dot + 1);
+            int64_t test_case_id;
+            try {
+                test_case_id = text::to_type< int64_t >(
+                    req.path.substr(6, dot - 6));
+            } catch (const text::value_error& e) {
+                test_case_id = -1;
+            }
+
+            if (test_case_id != -1) {
+                if (extension == "html")
+                    return test_case(tx, test_case_id);
+                else if (extension == "stdout")
+                    return serve_results::response::file(
+                        test_case_id, "__STDOUT__",
+                        "text/plain; charset=utf-8");
+                else if (extension == "stderr")
+                    return serve_results::response::file(
+                        test_case_id, "__STDERR__",
+                        "text/plain; charset=utf-8");
+            }
+        }
+
+        return serve_results::response(404, "text/plain",
+                                       F("No page %s\n") % req.path);
+    }
+};
+
+
+}  // anonymous namespace
+
+
+/// Default constructor for cmd_report_serve.
+cli::cmd_report_serve::cmd_report_serve(void) : cli_command(
+    "report-serve", "", 0, 0,
+    "Serves an HTML report with the result of a test suite run over HTTP")
+{
+    add_option(results_file_open_option);
+    add_option(cmdline::string_option(
+        "listen", "The address and port to listen on", "address:port",
+        "127.0.0.1:8080"));
+    add_option(results_filter_option);
+}
+
+
+/// Entry point for the "report-serve" subcommand.
+///
+/// \param ui Object to interact with the I/O of the program.
+/// \param cmdline Representation of the command line to the subcommand.
+///
+/// \return This only returns when interrupted, in which case the exit code
+/// is decided by the caller.
+int
+cli::cmd_report_serve::run(cmdline::ui* ui,
+                           const cmdline::parsed_cmdline& cmdline,
+                           const config::tree& /* user_config */)
+{
+    const result_types types = get_result_types(cmdline);
+    const std::pair< std::string, int > listen = parse_listen(
+        cmdline.get_option< cmdline::string_option >("listen"));
+
+    const fs::path results_file = layout::find_results(
+        results_file_open(cmdline));
+
+    serve_hooks hooks(ui, results_file, types);
+    serve_results::drive(results_file, listen.first, listen.second, hooks);
+
+    return EXIT_SUCCESS;
+}
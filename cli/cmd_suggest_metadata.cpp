@@ -0,0 +1,181 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "cli/cmd_suggest_metadata.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "cli/common.ipp"
+#include "drivers/suggest_metadata.hpp"
+#include "store/exceptions.hpp"
+#include "store/layout.hpp"
+#include "utils/cmdline/exceptions.hpp"
+#include "utils/cmdline/options.hpp"
+#include "utils/cmdline/parser.ipp"
+#include "utils/cmdline/ui.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+
+namespace cmdline = utils::cmdline;
+namespace config = utils::config;
+namespace fs = utils::fs;
+namespace layout = store::layout;
+namespace suggest_metadata = drivers::suggest_metadata;
+
+using cli::cmd_suggest_metadata;
+
+
+namespace {
+
+
+/// Gets a positive integer option from the command line.
+///
+/// \param cmdline Representation of the command line to the subcommand.
+/// \param name Name of the option to query.
+/// \param allow_zero Whether 0 is a valid value.
+///
+/// \return The value of the option.
+///
+/// \throw cmdline::usage_error If the value is out of range.
+static unsigned int
+get_count_option(const cmdline::parsed_cmdline& cmdline, const char* name,
+                 const bool allow_zero)
+{
+    const int value = cmdline.get_option< cmdline::int_option >(name);
+    if (value < (allow_zero ? 0 : 1))
+        throw cmdline::usage_error(F("Invalid value %s for --%s; must be %s") %
+                                   value % name %
+                                   (allow_zero ? "positive or 0" : "positive"));
+    return static_cast< unsigned int >(value);
+}
+
+
+/// Locates the results files to analyze.
+///
+/// \param cmdline Representation of the command line to the subcommand.
+/// \param max_runs Maximum number of results files to consider when they are
+///     looked up automatically.
+///
+/// \return The results files named in the command line, if any, or the most
+/// recent results files of the test suite in the current directory otherwise.
+///
+/// \throw store::error If any of the explicitly-named results files does not
+///     exist.
+static std::vector< fs::path >
+find_results_files(const cmdline::parsed_cmdline& cmdline,
+                   const std::size_t max_runs)
+{
+    const cmdline::args_vector& args = cmdline.arguments();
+    if (args.empty())
+        return layout::find_history(
+            layout::test_suite_for_path(fs::current_path()), max_runs);
+
+    std::vector< fs::path > files;
+    for (cmdline::args_vector::const_iterator iter = args.begin();
+         iter != args.end(); ++iter)
+        files.push_back(layout::find_results(*iter));
+    return files;
+}
+
+
+}  // anonymous namespace
+
+
+/// Default constructor for cmd_suggest_metadata.
+cmd_suggest_metadata::cmd_suggest_metadata(void) : cli_command(
+    "suggest-metadata", "[results-file-id ...]", 0, -1,
+    "Suggests metadata for the test cases based on their past executions")
+{
+    add_option(cmdline::int_option(
+        "runs", "Number of recent runs to analyze when no results files "
+        "are given", "count", "10"));
+    add_option(cmdline::int_option(
+        "min-samples", "Minimum number of executions of a test case to "
+        "suggest values for it", "count", "3"));
+    add_option(cmdline::int_option(
+        "timeout-factor", "Multiplier for the 99th percentile of the "
+        "durations to compute timeouts", "factor", "3"));
+    add_option(cmdline::int_option(
+        "memory-headroom", "Percentage to add to the peak memory usage to "
+        "compute memory requirements", "percent", "25"));
+}
+
+
+/// Entry point for the "suggest-metadata" subcommand.
+///
+/// \param ui Object to interact with the I/O of the program.
+/// \param cmdline Representation of the command line to the subcommand.
+///
+/// \return 0 if everything is OK, 1 if there are no results to analyze.
+///
+/// \throw cmdline::usage_error If the arguments are invalid.
+int
+cmd_suggest_metadata::run(cmdline::ui* ui,
+                          const cmdline::parsed_cmdline& cmdline,
+                          const config::tree& /* user_config */)
+{
+    suggest_metadata::options opts;
+    const unsigned int max_runs = get_count_option(cmdline, "runs", false);
+    opts.min_samples = get_count_option(cmdline, "min-samples", false);
+    opts.timeout_factor = get_count_option(cmdline, "timeout-factor", false);
+    opts.memory_headroom = get_count_option(cmdline, "memory-headroom", true);
+
+    std::vector< fs::path > files;
+    try {
+        files = find_results_files(cmdline, max_runs);
+    } catch (const store::error& e) {
+        cmdline::print_error(ui, F("Cannot find results: %s.") % e.what());
+        return EXIT_FAILURE;
+    }
+    if (files.empty()) {
+        cmdline::print_error(ui, "No previous runs to analyze.");
+        return EXIT_FAILURE;
+    }
+
+    std::vector< suggest_metadata::run > runs;
+    for (std::vector< fs::path >::const_iterator iter = files.begin();
+         iter != files.end(); ++iter) {
+        try {
+            runs.push_back(suggest_metadata::load_run(*iter));
+        } catch (const store::error& e) {
+            cmdline::print_warning(ui, F("Ignoring results file %s: %s") %
+                                   *iter % e.what());
+        }
+    }
+
+    const suggest_metadata::suggestions_vector suggestions =
+        suggest_metadata::suggest(runs, opts);
+    for (suggest_metadata::suggestions_vector::const_iterator
+             iter = suggestions.begin(); iter != suggestions.end(); ++iter)
+        ui->out(suggest_metadata::format(*iter));
+
+    return EXIT_SUCCESS;
+}
@@ -35,6 +35,7 @@
 #include "model/test_program.hpp"
 #include "model/test_result.hpp"
 #include "store/layout.hpp"
+#include "utils/cmdline/exceptions.hpp"
 #include "utils/cmdline/options.hpp"
 #include "utils/cmdline/parser.ipp"
 #include "utils/cmdline/ui.hpp"
@@ -42,14 +43,20 @@
 #include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+#include "utils/text/exceptions.hpp"
+#include "utils/text/operations.ipp"
 
 namespace cmdline = utils::cmdline;
 namespace config = utils::config;
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
 namespace layout = store::layout;
+namespace text = utils::text;
 
 using cli::cmd_test;
+using utils::none;
+using utils::optional;
 
 
 namespace {
@@ -124,6 +131,76 @@ public:
 };
 
 
+/// Computes how the results file has to be written from the command line.
+///
+/// \param cmdline Representation of the command line to the subcommand.
+///
+/// \return The time between saves of the results file if it has to be staged
+/// in memory, or none if it has to be written to directly.
+///
+/// \throw cmdline::usage_error If the arguments are invalid.
+static optional< datetime::delta >
+staging_interval(const cmdline::parsed_cmdline& cmdline)
+{
+    const std::string mode = cmdline.get_option< cmdline::string_option >(
+        "store-mode");
+    const int interval_secs = cmdline.get_option< cmdline::int_option >(
+        "store-flush-interval");
+    if (interval_secs < 1)
+        throw cmdline::usage_error(F("Invalid flush interval %s; must be at "
+                                     "least 1") % interval_secs);
+
+    if (mode == "direct")
+        return none;
+    else if (mode == "staged")
+        return utils::make_optional(datetime::delta(interval_secs, 0));
+    else
+        throw cmdline::usage_error(F("Invalid store mode '%s'; must be direct "
+                                     "or staged") % mode);
+}
+
+
+/// Parses the value of the --time-budget flag.
+///
+/// \param cmdline Representation of the command line to the subcommand.
+///
+/// \return The time budget, or none if the flag was not given.
+///
+/// \throw cmdline::usage_error If the value is invalid.
+static optional< datetime::delta >
+time_budget(const cmdline::parsed_cmdline& cmdline)
+{
+    if (!cmdline.has_option("time-budget"))
+        return none;
+    const std::string raw = cmdline.get_option< cmdline::string_option >(
+        "time-budget");
+
+    std::string number = raw;
+    int64_t multiplier = 1;
+    if (!raw.empty()) {
+        const char unit = raw[raw.length() - 1];
+        if (unit == 'm')
+            multiplier = 60;
+        else if (unit == 'h')
+            multiplier = 60 * 60;
+        if (unit == 's' || unit == 'm' || unit == 'h')
+            number.erase(number.length() - 1);
+    }
+
+    int64_t value;
+    try {
+        value = text::to_type< int64_t >(number);
+    } catch (const text::value_error& e) {
+        value = 0;
+    }
+    if (value <= 0)
+        throw cmdline::usage_error(F("Invalid time budget '%s'; must be a "
+                                     "positive number of seconds optionally "
+                                     "followed by s, m or h") % raw);
+    return utils::make_optional(datetime::delta(value * multiplier, 0));
+}
+
+
 }  // anonymous namespace
 
 
@@ -134,6 +211,15 @@ cmd_test::cmd_test(void) : cli_command(
     add_option(build_root_option);
     add_option(kyuafile_option);
     add_option(results_file_create_option);
+    add_option(cmdline::string_option(
+        "store-mode", "How to write the results file: direct or staged",
+        "mode", "direct"));
+    add_option(cmdline::int_option(
+        "store-flush-interval", "Number of seconds between saves of the "
+        "results file in staged mode", "seconds", "30"));
+    add_option(cmdline::string_option(
+        "time-budget", "Only run the test cases predicted to complete within "
+        "this time, such as 600s, 10m or 1h", "duration"));
 }
 
 
@@ -144,10 +230,16 @@ cmd_test::cmd_test(void) : cli_command(
 /// \param user_config The runtime configuration of the program.
 ///
 /// \return 0 if all tests passed, 1 otherwise.
+///
+/// \throw cmdline::usage_error If the arguments are invalid.
 int
 cmd_test::run(cmdline::ui* ui, const cmdline::parsed_cmdline& cmdline,
               const config::tree& user_config)
 {
+    const optional< datetime::delta > store_interval = staging_interval(
+        cmdline);
+    const optional< datetime::delta > budget = time_budget(cmdline);
+
     const layout::results_id_file_pair results = layout::new_db(
         results_file_create(cmdline), kyuafile_path(cmdline).branch_path());
 
@@ -157,7 +249,8 @@ cmd_test::run(cmdline::ui* ui, const cmdline::parsed_cmdline& cmdline,
     print_hooks hooks(ui, parallel);
     const drivers::run_tests::result result = drivers::run_tests::drive(
         kyuafile_path(cmdline), build_root_path(cmdline), results.second,
-        parse_filters(cmdline.arguments()), user_config, hooks);
+        store_interval, parse_filters(cmdline.arguments()), budget,
+        user_config, hooks);
 
     int exit_code;
     if (hooks.good_count > 0 || hooks.bad_count > 0) {
@@ -0,0 +1,306 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "cli/cmd_top.hpp"
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+#include "cli/common.ipp"
+#include "drivers/run_status.hpp"
+#include "engine/exceptions.hpp"
+#include "store/exceptions.hpp"
+#include "store/layout.hpp"
+#include "utils/cmdline/exceptions.hpp"
+#include "utils/cmdline/options.hpp"
+#include "utils/cmdline/parser.ipp"
+#include "utils/cmdline/ui.hpp"
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+#include "utils/process/usage.hpp"
+#include "utils/signals/exceptions.hpp"
+#include "utils/signals/interrupts.hpp"
+#include "utils/units.hpp"
+
+namespace cmdline = utils::cmdline;
+namespace config = utils::config;
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace layout = store::layout;
+namespace process = utils::process;
+namespace run_status = drivers::run_status;
+namespace signals = utils::signals;
+namespace units = utils::units;
+
+using cli::cmd_top;
+using utils::optional;
+
+
+namespace {
+
+
+/// Granularity of the sleeps between refreshes, in microseconds.
+///
+/// We sleep in small chunks so that interrupts are processed promptly.
+static const useconds_t sleep_chunk_usec = 100000;
+
+
+/// Escape sequence to move the cursor home and clear the terminal.
+static const char* const clear_screen = "\033[H\033[2J";
+
+
+/// Sleeps for the given amount of time while honoring interrupts.
+///
+/// \param delay The time to sleep for.
+///
+/// \throw signals::interrupted_error If the user asks us to terminate.
+static void
+interruptible_sleep(const datetime::delta& delay)
+{
+    int64_t left = delay.to_microseconds();
+    while (left > 0) {
+        signals::check_interrupt();
+        const useconds_t chunk = static_cast< useconds_t >(
+            std::min(left, static_cast< int64_t >(sleep_chunk_usec)));
+        ::usleep(chunk);
+        left -= chunk;
+    }
+    signals::check_interrupt();
+}
+
+
+/// Formats an optional amount of bytes for the table.
+///
+/// \param value The value to format.
+///
+/// \return The formatted value, or a dash if unknown.
+static std::string
+format_optional_bytes(const optional< units::bytes >& value)
+{
+    return value ? value.get().format() : "-";
+}
+
+
+/// Renders one snapshot of the run in progress.
+///
+/// \param ui Object to interact with the I/O of the program.
+/// \param status The status published by the run.
+/// \param usage Resource usage of the running tests.
+/// \param previous_usage Resource usage at the previous refresh, if any.
+/// \param interval Time between the previous refresh and this one.
+static void
+render(cmdline::ui* ui, const run_status::status& status,
+       const process::group_usage_map& usage,
+       const process::group_usage_map& previous_usage,
+       const datetime::delta& interval)
+{
+    const datetime::timestamp now = datetime::timestamp::now();
+    const datetime::delta elapsed = now - status.start_time;
+
+    const double elapsed_secs = elapsed.to_microseconds() / 1000000.0;
+    const double throughput = elapsed_secs > 0 ?
+        status.done / elapsed_secs : 0;
+    ui->out(F("Run by PID %s, elapsed %s, %.2s test cases/s") % status.pid %
+            cli::format_delta(elapsed) % throughput);
+    ui->out(F("%s done (%s failed), %s running, %s test programs pending, "
+              "%s deferred") % status.done % status.failed %
+            status.running.size() % status.pending_test_programs %
+            status.deferred);
+    ui->out("");
+
+    // Show the longest-running tests first as they are the most likely to be
+    // the ones that hold up the run.
+    std::vector< std::pair< datetime::timestamp, int > > order;
+    for (run_status::running_tests_map::const_iterator
+             iter = status.running.begin(); iter != status.running.end();
+         ++iter)
+        order.push_back(std::make_pair((*iter).second.start_time,
+                                       (*iter).first));
+    std::sort(order.begin(), order.end());
+
+    ui->out(F("%8s %10s %10s %6s %10s %10s %10s  %s") % "PID" % "ELAPSED" %
+            "TIMEOUT" % "CPU%" % "RSS" % "READ" % "WRITE" % "TEST CASE");
+    for (std::vector< std::pair< datetime::timestamp, int > >::const_iterator
+             iter = order.begin(); iter != order.end(); ++iter) {
+        const int pid = (*iter).second;
+        const run_status::running_test& test =
+            (*status.running.find(pid)).second;
+        const datetime::delta test_elapsed = now - test.start_time;
+
+        std::string cpu = "-";
+        std::string rss = "-";
+        std::string read_bytes = "-";
+        std::string write_bytes = "-";
+        const process::group_usage_map::const_iterator current =
+            usage.find(pid);
+        if (current != usage.end()) {
+            const process::group_usage& data = (*current).second;
+
+            // The CPU usage is computed over the last refresh interval when
+            // possible and over the whole life of the test otherwise.
+            int64_t cpu_usec = data.cpu_time.to_microseconds();
+            int64_t wall_usec = test_elapsed.to_microseconds();
+            const process::group_usage_map::const_iterator previous =
+                previous_usage.find(pid);
+            if (previous != previous_usage.end() &&
+                data.cpu_time >= (*previous).second.cpu_time) {
+                cpu_usec -= (*previous).second.cpu_time.to_microseconds();
+                wall_usec = interval.to_microseconds();
+            }
+            if (wall_usec > 0)
+                cpu = F("%.1s") % (cpu_usec * 100.0 / wall_usec);
+
+            rss = data.rss.format();
+            read_bytes = format_optional_bytes(data.read_bytes);
+            write_bytes = format_optional_bytes(data.write_bytes);
+        }
+
+        ui->out(F("%8s %10s %10s %6s %10s %10s %10s  %s:%s") % pid %
+                cli::format_delta(test_elapsed) %
+                cli::format_delta(test.timeout) % cpu % rss % read_bytes %
+                write_bytes % test.test_program % test.test_case_name);
+    }
+}
+
+
+}  // anonymous namespace
+
+
+/// Default constructor for cmd_top.
+cmd_top::cmd_top(void) : cli_command(
+    "top", "", 0, 0,
+    "Shows the test cases being executed by an in-progress run and their "
+    "resource usage")
+{
+    add_option(results_file_open_option);
+    add_option(cmdline::int_option(
+        "interval", "Number of seconds between refreshes", "seconds", "1"));
+    add_option(cmdline::int_option(
+        "iterations", "Number of refreshes to show before exiting; 0 means "
+        "until the run finishes", "count", "0"));
+}
+
+
+/// Entry point for the "top" subcommand.
+///
+/// \param ui Object to interact with the I/O of the program.
+/// \param cmdline Representation of the command line to the subcommand.
+///
+/// \return 0 if everything is OK, 1 if there is no run to monitor.
+///
+/// \throw cmdline::usage_error If the arguments are invalid.
+int
+cmd_top::run(cmdline::ui* ui, const cmdline::parsed_cmdline& cmdline,
+             const config::tree& /* user_config */)
+{
+    const int interval_secs = cmdline.get_option< cmdline::int_option >(
+        "interval");
+    if (interval_secs < 1)
+        throw cmdline::usage_error(F("Invalid interval %s; must be at "
+                                     "least 1") % interval_secs);
+    const int iterations = cmdline.get_option< cmdline::int_option >(
+        "iterations");
+    if (iterations < 0)
+        throw cmdline::usage_error(F("Invalid iterations %s; must be "
+                                     "positive or 0") % iterations);
+
+    fs::path status_file("unused");
+    try {
+        status_file = run_status::status_file(layout::find_results(
+            results_file_open(cmdline)));
+    } catch (const store::error& e) {
+        cmdline::print_error(ui, F("Cannot find run: %s.") % e.what());
+        return EXIT_FAILURE;
+    }
+    if (!fs::exists(status_file)) {
+        cmdline::print_error(ui, F("No run in progress for %s.") %
+                             status_file);
+        return EXIT_FAILURE;
+    }
+
+    if (!process::usage_supported())
+        cmdline::print_warning(ui, "Resource usage is not available on this "
+                               "platform.");
+
+    const bool interactive = ::isatty(STDOUT_FILENO);
+    const datetime::delta interval(interval_secs, 0);
+
+    signals::interrupts_handler interrupts;
+    try {
+        process::group_usage_map previous_usage;
+        datetime::timestamp previous_time = datetime::timestamp::now();
+        for (int i = 0; iterations == 0 || i < iterations; ++i) {
+            if (i > 0)
+                interruptible_sleep(interval);
+
+            run_status::status status(0, previous_time);
+            try {
+                status = run_status::read(status_file);
+            } catch (const engine::error& e) {
+                // The file goes away as soon as the run finishes, so a read
+                // failure after the first check is the normal way out.
+                if (fs::exists(status_file))
+                    throw;
+                ui->out("Run finished.");
+                break;
+            }
+
+            std::set< int > pids;
+            for (run_status::running_tests_map::const_iterator
+                     iter = status.running.begin();
+                 iter != status.running.end(); ++iter)
+                pids.insert((*iter).first);
+            const process::group_usage_map usage =
+                process::sample_groups_usage(pids);
+            const datetime::timestamp now = datetime::timestamp::now();
+
+            if (interactive)
+                ui->out(clear_screen, false);
+            else if (i > 0)
+                ui->out("");
+            render(ui, status, usage, previous_usage, now - previous_time);
+
+            previous_usage = usage;
+            previous_time = now;
+        }
+    } catch (const signals::interrupted_error& e) {
+        interrupts.unprogram();
+        throw;
+    }
+
+    return EXIT_SUCCESS;
+}
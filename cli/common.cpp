@@ -138,37 +138,6 @@ get_historical_db(void)
 }
 
 
-/// Converts a set of result type names to identifiers.
-///
-/// \param names The collection of names to process; may be empty.
-///
-/// \return The result type identifiers corresponding to the input names.
-///
-/// \throw std::runtime_error If any name in the input names is invalid.
-static cli::result_types
-parse_types(const std::vector< std::string >& names)
-{
-    typedef std::map< std::string, model::test_result_type > types_map;
-    types_map valid_types;
-    valid_types["broken"] = model::test_result_broken;
-    valid_types["failed"] = model::test_result_failed;
-    valid_types["passed"] = model::test_result_passed;
-    valid_types["skipped"] = model::test_result_skipped;
-    valid_types["xfail"] = model::test_result_expected_failure;
-
-    cli::result_types types;
-    for (std::vector< std::string >::const_iterator iter = names.begin();
-         iter != names.end(); ++iter) {
-        const types_map::const_iterator match = valid_types.find(*iter);
-        if (match == valid_types.end())
-            throw std::runtime_error(F("Unknown result type '%s'") % *iter);
-        else
-            types.push_back((*match).second);
-    }
-    return types;
-}
-
-
 }  // anonymous namespace
 
 
@@ -273,7 +242,7 @@ cli::results_file_open(const cmdline::parsed_cmdline& cmdline)
 cli::result_types
 cli::get_result_types(const utils::cmdline::parsed_cmdline& cmdline)
 {
-    result_types types = parse_types(
+    result_types types = parse_result_types(
         cmdline.get_option< cmdline::list_option >("results-filter"));
     if (types.empty()) {
         types.push_back(model::test_result_passed);
@@ -286,6 +255,37 @@ cli::get_result_types(const utils::cmdline::parsed_cmdline& cmdline)
 }
 
 
+/// Converts a set of result type names to identifiers.
+///
+/// \param names The collection of names to process; may be empty.
+///
+/// \return The result type identifiers corresponding to the input names.
+///
+/// \throw std::runtime_error If any name in the input names is invalid.
+cli::result_types
+cli::parse_result_types(const std::vector< std::string >& names)
+{
+    typedef std::map< std::string, model::test_result_type > types_map;
+    types_map valid_types;
+    valid_types["broken"] = model::test_result_broken;
+    valid_types["failed"] = model::test_result_failed;
+    valid_types["passed"] = model::test_result_passed;
+    valid_types["skipped"] = model::test_result_skipped;
+    valid_types["xfail"] = model::test_result_expected_failure;
+
+    cli::result_types types;
+    for (std::vector< std::string >::const_iterator iter = names.begin();
+         iter != names.end(); ++iter) {
+        const types_map::const_iterator match = valid_types.find(*iter);
+        if (match == valid_types.end())
+            throw std::runtime_error(F("Unknown result type '%s'") % *iter);
+        else
+            types.push_back((*match).second);
+    }
+    return types;
+}
+
+
 /// Parses a set of command-line arguments to construct test filters.
 ///
 /// \param args The command-line arguments representing test filters.
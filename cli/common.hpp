@@ -85,6 +85,7 @@ std::string results_file_create(const utils::cmdline::parsed_cmdline&);
 std::string results_file_open(const utils::cmdline::parsed_cmdline&);
 result_types get_result_types(const utils::cmdline::parsed_cmdline&);
 
+result_types parse_result_types(const std::vector< std::string >&);
 std::set< engine::test_filter > parse_filters(
     const utils::cmdline::args_vector&);
 bool report_unused_filters(const std::set< engine::test_filter >&,
@@ -45,6 +45,7 @@ extern "C" {
 #include "cli/cmd_about.hpp"
 #include "cli/cmd_config.hpp"
 #include "cli/cmd_db_exec.hpp"
+#include "cli/cmd_db_index.hpp"
 #include "cli/cmd_db_migrate.hpp"
 #include "cli/cmd_debug.hpp"
 #include "cli/cmd_help.hpp"
@@ -52,10 +53,14 @@ extern "C" {
 #include "cli/cmd_report.hpp"
 #include "cli/cmd_report_html.hpp"
 #include "cli/cmd_report_junit.hpp"
+#include "cli/cmd_report_serve.hpp"
+#include "cli/cmd_suggest_metadata.hpp"
 #include "cli/cmd_test.hpp"
+#include "cli/cmd_top.hpp"
 #include "cli/common.ipp"
 #include "cli/config.hpp"
 #include "engine/atf.hpp"
+#include "engine/config.hpp"
 #include "engine/plain.hpp"
 #include "engine/scheduler.hpp"
 #include "engine/tap.hpp"
@@ -71,6 +76,7 @@ extern "C" {
 #include "utils/format/macros.hpp"
 #include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/heap_stats.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/logging/operations.hpp"
 #include "utils/optional.ipp"
@@ -80,6 +86,7 @@ extern "C" {
 namespace cmdline = utils::cmdline;
 namespace config = utils::config;
 namespace fs = utils::fs;
+namespace heap_stats = utils::heap_stats;
 namespace logging = utils::logging;
 namespace signals = utils::signals;
 namespace scheduler = engine::scheduler;
@@ -91,6 +98,45 @@ using utils::optional;
 namespace {
 
 
+/// Names of the commands that do not use the user configuration.
+///
+/// The configuration is not loaded for these commands, which saves the cost of
+/// bringing up the Lua interpreter.  This list must be kept in sync with the
+/// commands that ignore the user_config argument of their run() method.
+static const char* const commands_without_config[] = {
+    "about",
+    "db-exec",
+    "db-index",
+    "db-migrate",
+    "help",
+    "report",
+    "report-html",
+    "report-junit",
+    "report-serve",
+    "suggest-metadata",
+    "top",
+    NULL,
+};
+
+
+/// Checks if a command needs the user configuration to run.
+///
+/// \param name The name of the command to check.
+///
+/// \return True if the configuration has to be loaded before running the
+/// command; false otherwise.
+static bool
+needs_config(const std::string& name)
+{
+    for (const char* const* iter = commands_without_config; *iter != NULL;
+         ++iter) {
+        if (name == *iter)
+            return false;
+    }
+    return true;
+}
+
+
 /// Registers all valid scheduler interfaces.
 ///
 /// This is part of Kyua's setup but it is a bit strange to find it here.  I am
@@ -111,6 +157,29 @@ register_scheduler_interfaces(void)
 }
 
 
+/// Prints the heap usage of the program by phase.
+///
+/// \param ui Object to interact with the I/O of the program.
+static void
+print_heap_stats(cmdline::ui* ui)
+{
+    if (!heap_stats::available()) {
+        cmdline::print_warning(ui, "Heap statistics are not available; "
+                               "rebuild with --enable-heap-stats");
+        return;
+    }
+
+    ui->err("Heap usage by phase:");
+    for (std::size_t i = 0; i < heap_stats::num_phases; ++i) {
+        const heap_stats::phase phase = static_cast< heap_stats::phase >(i);
+        const heap_stats::counters counters = heap_stats::get(phase);
+        ui->err(F("    %s: %s allocations, %s bytes, %s bytes peak") %
+                heap_stats::name(phase) % counters.allocations %
+                counters.bytes % counters.peak);
+    }
+}
+
+
 /// Executes the given subcommand with proper usage_error reporting.
 ///
 /// \param ui Object to interact with the I/O of the program.
@@ -180,22 +249,29 @@ safe_main(cmdline::ui* ui, int argc, const char* const argv[],
         "logfile", "Path to the log file", "file",
         cli::detail::default_log_name().c_str());
     options.push_back(&logfile_option);
+    const cmdline::bool_option stats_option(
+        "stats", "Print heap usage statistics on exit");
+    options.push_back(&stats_option);
 
     cmdline::commands_map< cli::cli_command > commands;
 
     commands.insert(new cli::cmd_about());
     commands.insert(new cli::cmd_config());
     commands.insert(new cli::cmd_db_exec());
+    commands.insert(new cli::cmd_db_index());
     commands.insert(new cli::cmd_db_migrate());
     commands.insert(new cli::cmd_help(&options, &commands));
 
     commands.insert(new cli::cmd_debug(), "Workspace");
     commands.insert(new cli::cmd_list(), "Workspace");
     commands.insert(new cli::cmd_test(), "Workspace");
+    commands.insert(new cli::cmd_top(), "Workspace");
 
     commands.insert(new cli::cmd_report(), "Reporting");
     commands.insert(new cli::cmd_report_html(), "Reporting");
     commands.insert(new cli::cmd_report_junit(), "Reporting");
+    commands.insert(new cli::cmd_report_serve(), "Reporting");
+    commands.insert(new cli::cmd_suggest_metadata(), "Reporting");
 
     if (mock_command.get() != NULL)
         commands.insert(mock_command);
@@ -208,8 +284,16 @@ safe_main(cmdline::ui* ui, int argc, const char* const argv[],
     LD(F("Log file is %s") % logfile);
     utils::install_crash_handlers(logfile.str());
     try {
-        logging::set_persistency(cmdline.get_option< cmdline::string_option >(
-            "loglevel"), logfile);
+        const std::string loglevel =
+            cmdline.get_option< cmdline::string_option >("loglevel");
+        // Unless the user asked for a specific log, only create the default one
+        // if there is something worth looking at in it.  Most invocations run
+        // cleanly and would otherwise leave an uninteresting file behind.
+        if (loglevel == loglevel_option.default_value() &&
+            logfile.str() == logfile_option.default_value())
+            logging::set_persistency_on_demand(loglevel, logfile);
+        else
+            logging::set_persistency(loglevel, logfile);
     } catch (const std::range_error& e) {
         throw cmdline::usage_error(e.what());
     }
@@ -218,14 +302,21 @@ safe_main(cmdline::ui* ui, int argc, const char* const argv[],
         throw cmdline::usage_error("No command provided");
     const std::string cmdname = cmdline.arguments()[0];
 
-    const config::tree user_config = cli::load_config(cmdline,
-                                                      cmdname != "help");
-
     cli::cli_command* command = commands.find(cmdname);
     if (command == NULL)
         throw cmdline::usage_error(F("Unknown command '%s'") % cmdname);
-    register_scheduler_interfaces();
-    return run_subcommand(ui, command, cmdline.arguments(), user_config);
+
+    const config::tree user_config = needs_config(cmdname) ?
+        cli::load_config(cmdline, true) : engine::default_config();
+
+    // The interfaces are only needed once a command sets up the scheduler, so
+    // defer their registration until then.
+    scheduler::register_interfaces_loader(register_scheduler_interfaces);
+    const int exit_code = run_subcommand(ui, command, cmdline.arguments(),
+                                         user_config);
+    if (cmdline.has_option("stats"))
+        print_heap_stats(ui);
+    return exit_code;
 }
 
 
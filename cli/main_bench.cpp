@@ -0,0 +1,219 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file cli/main_bench.cpp
+/// Benchmark for the startup cost of the kyua binary.
+///
+/// This program runs every cheap subcommand of a built kyua binary a
+/// configurable number of times (20 by default) and reports how long each
+/// invocation takes.  These commands do little work of their own, so their run
+/// time is dominated by the initialization of the program.
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "model/context.hpp"
+#include "model/metadata.hpp"
+#include "model/test_case.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/env.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/auto_cleaners.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/process/child.ipp"
+#include "utils/process/operations_fwd.hpp"
+#include "utils/process/status.hpp"
+#include "utils/stream.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace logging = utils::logging;
+namespace process = utils::process;
+
+
+namespace {
+
+
+/// Default number of times to run every subcommand.
+static const int default_rounds = 20;
+
+
+/// Populates a small results file for the reporting commands to read.
+///
+/// \param file The results file to create.
+static void
+populate(const fs::path& file)
+{
+    store::write_backend backend = store::write_backend::open_rw(file);
+    store::write_transaction tx = backend.start_write();
+
+    tx.put_context(model::context(fs::path("/bench"),
+                                  std::map< std::string, std::string >()));
+
+    const datetime::timestamp start_time =
+        datetime::timestamp::from_values(2026, 1, 1, 0, 0, 0, 0);
+    const datetime::timestamp end_time = start_time + datetime::delta(1, 0);
+
+    const model::test_program program(
+        "plain", fs::path("program"), fs::path("/bench/root"), "bench",
+        model::metadata_builder().build(),
+        model::test_cases_map_builder().add("main").build());
+    const int64_t program_id = tx.put_test_program(program);
+    const int64_t case_id = tx.put_test_case(program, "main", program_id);
+    tx.put_result(model::test_result(model::test_result_passed), case_id,
+                  start_time, end_time);
+
+    tx.commit();
+    backend.close();
+}
+
+
+/// Runs a command repeatedly and prints how long it takes.
+///
+/// \param kyua Path to the kyua binary to run.
+/// \param args The arguments to the binary, starting with the subcommand name.
+/// \param rounds The number of times to run the command.
+/// \param output File to send the output of the command to.
+///
+/// \return True if all invocations of the command succeeded; false otherwise.
+static bool
+measure(const fs::path& kyua, const process::args_vector& args,
+        const int rounds, const fs::path& output)
+{
+    int64_t total = 0;
+    int64_t best = 0;
+    for (int i = 0; i < rounds; ++i) {
+        const datetime::timestamp start = datetime::timestamp::now();
+        const process::status status = process::child::spawn_files(
+            kyua, args, output, output)->wait();
+        const int64_t usecs = (datetime::timestamp::now() - start)
+            .to_microseconds();
+        if (!status.exited() || status.exitstatus() != EXIT_SUCCESS) {
+            std::cerr << F("%s: command failed: %s\n") % args[0]
+                % utils::read_file(output);
+            return false;
+        }
+
+        total += usecs;
+        if (i == 0 || usecs < best)
+            best = usecs;
+    }
+    std::cout << F("%s: mean %s us, min %s us over %s runs\n")
+        % args[0] % (total / rounds) % best % rounds;
+    return true;
+}
+
+
+}  // anonymous namespace
+
+
+/// Program entry point.
+///
+/// \param argc Number of command-line arguments.
+/// \param argv The command-line arguments.  The first optional argument is the
+///     number of times to run every subcommand.  The second optional argument
+///     is the path to the kyua binary to measure, which defaults to the one in
+///     the current directory.
+///
+/// \return An exit code.
+int
+main(const int argc, const char* const* const argv)
+{
+    logging::set_persistency("warning", fs::path("/dev/null"));
+
+    int rounds = default_rounds;
+    if (argc > 1)
+        rounds = std::atoi(argv[1]);
+    fs::path kyua(argc > 2 ? argv[2] : "kyua");
+    if (!kyua.is_absolute())
+        kyua = kyua.to_absolute();
+
+    const fs::auto_directory work = fs::auto_directory::mkdtemp_public(
+        "kyua.main_bench.XXXXXX");
+    const fs::path& dir = work.directory();
+
+    // Point HOME to an empty directory so that the configuration and the logs
+    // of the user running the benchmark do not affect the results.
+    utils::setenv("HOME", dir.str());
+
+    const fs::path results = dir / "results.db";
+    populate(results);
+    const fs::path kyuafile = dir / "Kyuafile";
+    {
+        std::ofstream output(kyuafile.c_str());
+        output << "syntax(2)\n"
+               << "test_suite('bench')\n"
+               << "plain_test_program{name='program'}\n";
+    }
+    {
+        std::ofstream output((dir / "program").c_str());
+    }
+
+    std::vector< process::args_vector > commands;
+    commands.push_back(process::args_vector(1, "about"));
+    commands.push_back(process::args_vector(1, "help"));
+    commands.push_back(process::args_vector(1, "config"));
+    {
+        process::args_vector args(1, "db-exec");
+        args.push_back(F("--results-file=%s") % results);
+        args.push_back("SELECT * FROM metadata");
+        commands.push_back(args);
+    }
+    {
+        process::args_vector args(1, "report");
+        args.push_back(F("--results-file=%s") % results);
+        commands.push_back(args);
+    }
+    {
+        process::args_vector args(1, "report-junit");
+        args.push_back(F("--results-file=%s") % results);
+        commands.push_back(args);
+    }
+    {
+        process::args_vector args(1, "list");
+        args.push_back(F("--kyuafile=%s") % kyuafile);
+        commands.push_back(args);
+    }
+
+    bool ok = true;
+    for (std::vector< process::args_vector >::const_iterator
+             iter = commands.begin(); iter != commands.end(); ++iter) {
+        ok &= measure(kyua, *iter, rounds, dir / "output.txt");
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
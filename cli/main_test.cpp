@@ -257,6 +257,24 @@ ATF_TEST_CASE_BODY(main__logfile__default)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(main__logfile__default_on_demand);
+ATF_TEST_CASE_BODY(main__logfile__default_on_demand)
+{
+    logging::set_inmemory();
+    datetime::set_mock_now(2011, 2, 21, 21, 30, 00, 0);
+    cmdline::init("progname");
+
+    const int argc = 2;
+    const char* const argv[] = {"progname", "mock_write", NULL};
+
+    cmdline::ui_mock ui;
+    ATF_REQUIRE_EQ(EXIT_FAILURE,
+                   cli::main(&ui, argc, argv,
+                             cli::cli_command_ptr(new cmd_mock_write())));
+    ATF_REQUIRE(!fs::exists(fs::path(
+        ".kyua/logs/progname.20110221-213000.log")));
+}
+
 ATF_TEST_CASE_WITHOUT_HEAD(main__logfile__override);
 ATF_TEST_CASE_BODY(main__logfile__override)
 {
@@ -385,6 +403,24 @@ ATF_TEST_CASE_BODY(main__subcommand__ok)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(main__stats__unavailable);
+ATF_TEST_CASE_BODY(main__stats__unavailable)
+{
+    logging::set_inmemory();
+    cmdline::init("progname");
+
+    const int argc = 3;
+    const char* const argv[] = {"progname", "--stats", "mock_write", NULL};
+
+    cmdline::ui_mock ui;
+    ATF_REQUIRE_EQ(EXIT_FAILURE,
+                   cli::main(&ui, argc, argv,
+                             cli::cli_command_ptr(new cmd_mock_write())));
+    ATF_REQUIRE_EQ(1, ui.out_log().size());
+    ATF_REQUIRE(atf::utils::grep_collection(
+        "Heap statistics are not available", ui.err_log()));
+}
+
 ATF_TEST_CASE_WITHOUT_HEAD(main__subcommand__invalid_args);
 ATF_TEST_CASE_BODY(main__subcommand__invalid_args)
 {
@@ -476,12 +512,14 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, main__no_args);
     ATF_ADD_TEST_CASE(tcs, main__unknown_command);
     ATF_ADD_TEST_CASE(tcs, main__logfile__default);
+    ATF_ADD_TEST_CASE(tcs, main__logfile__default_on_demand);
     ATF_ADD_TEST_CASE(tcs, main__logfile__override);
     ATF_ADD_TEST_CASE(tcs, main__loglevel__default);
     ATF_ADD_TEST_CASE(tcs, main__loglevel__higher);
     ATF_ADD_TEST_CASE(tcs, main__loglevel__lower);
     ATF_ADD_TEST_CASE(tcs, main__loglevel__error);
     ATF_ADD_TEST_CASE(tcs, main__subcommand__ok);
+    ATF_ADD_TEST_CASE(tcs, main__stats__unavailable);
     ATF_ADD_TEST_CASE(tcs, main__subcommand__invalid_args);
     ATF_ADD_TEST_CASE(tcs, main__subcommand__runtime_error);
     ATF_ADD_TEST_CASE(tcs, main__subcommand__unhandled_exception);
@@ -92,6 +92,13 @@ drivers::debug_test::drive(const fs::path& kyuafile_path,
     const model::test_program_ptr test_program = match.get().first;
     const std::string& test_case_name = match.get().second;
 
+    const bool has_fixture = scheduler::has_fixture(*test_program);
+    if (has_fixture && !handle.setup_fixture(test_program, user_config)) {
+        // Nothing else is running, so the next process to complete is the
+        // setup command of the fixture.
+        handle.wait_any()->cleanup();
+    }
+
     scheduler::result_handle_ptr result_handle = handle.debug_test(
         test_program, test_case_name, user_config,
         stdout_path, stderr_path);
@@ -101,6 +108,9 @@ drivers::debug_test::drive(const fs::path& kyuafile_path,
     const model::test_result test_result = test_result_handle->test_result();
     result_handle->cleanup();
 
+    if (has_fixture)
+        handle.teardown_fixture(test_program);
+
     handle.check_interrupt();
     handle.cleanup();
 
@@ -224,8 +224,9 @@ drivers::report_junit_hooks::got_result(store::results_iterator& iter)
 
     const std::string stdout_contents = iter.stdout_contents();
     if (!stdout_contents.empty()) {
-        _output << F("<system-out>%s</system-out>\n")
-            % text::escape_xml(stdout_contents);
+        _output << "<system-out>";
+        text::escape_xml(_output, stdout_contents);
+        _output << "</system-out>\n";
     }
 
     {
@@ -243,8 +244,9 @@ drivers::report_junit_hooks::got_result(store::results_iterator& iter)
             stderr_contents += real_stderr_contents;
         }
     }
-    _output << "<system-err>" << text::escape_xml(stderr_contents)
-            << "</system-err>\n";
+    _output << "<system-err>";
+    text::escape_xml(_output, stderr_contents);
+    _output << "</system-err>\n";
 
     _output << "</testcase>\n";
 }
@@ -0,0 +1,381 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "drivers/run_status.hpp"
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "engine/exceptions.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/exceptions.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/sanity.hpp"
+#include "utils/text/exceptions.hpp"
+#include "utils/text/operations.ipp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace run_status = drivers::run_status;
+namespace text = utils::text;
+
+
+namespace {
+
+
+/// Magic line that starts all status files, including the format version.
+static const char* const magic = "kyua-run-status\t1";
+
+
+/// Parses an integral field of the status file.
+///
+/// \param file The file being parsed, for error reporting purposes.
+/// \param field The name of the field being parsed.
+/// \param value The textual value of the field.
+///
+/// \return The parsed value.
+///
+/// \throw engine::error If the value is not valid.
+template< typename Type >
+static Type
+parse_field(const fs::path& file, const std::string& field,
+            const std::string& value)
+{
+    try {
+        return text::to_type< Type >(value);
+    } catch (const text::value_error& e) {
+        throw engine::error(F("Invalid %s '%s' in status file %s") % field %
+                            value % file);
+    }
+}
+
+
+}  // anonymous namespace
+
+
+/// Constructor for a running test.
+///
+/// \param test_program_ Relative path to the test program.
+/// \param test_case_name_ Name of the test case.
+/// \param start_time_ Time at which the test case was started.
+/// \param timeout_ Maximum time the test case is allowed to run for.
+run_status::running_test::running_test(
+    const std::string& test_program_, const std::string& test_case_name_,
+    const datetime::timestamp& start_time_, const datetime::delta& timeout_) :
+    test_program(test_program_), test_case_name(test_case_name_),
+    start_time(start_time_), timeout(timeout_)
+{
+}
+
+
+/// Equality comparator.
+///
+/// \param other The other object to compare this one to.
+///
+/// \return True if the two objects are equal; false otherwise.
+bool
+run_status::running_test::operator==(const running_test& other) const
+{
+    return (test_program == other.test_program &&
+            test_case_name == other.test_case_name &&
+            start_time == other.start_time && timeout == other.timeout);
+}
+
+
+/// Constructor for an empty status.
+///
+/// \param pid_ PID of the process driving the run.
+/// \param start_time_ Time at which the run started.
+run_status::status::status(const int pid_,
+                           const datetime::timestamp& start_time_) :
+    pid(pid_), start_time(start_time_), done(0), failed(0),
+    pending_test_programs(0), deferred(0)
+{
+}
+
+
+/// Equality comparator.
+///
+/// \param other The other object to compare this one to.
+///
+/// \return True if the two objects are equal; false otherwise.
+bool
+run_status::status::operator==(const status& other) const
+{
+    return (pid == other.pid && start_time == other.start_time &&
+            done == other.done && failed == other.failed &&
+            pending_test_programs == other.pending_test_programs &&
+            deferred == other.deferred && running == other.running);
+}
+
+
+/// Computes the path to the status file of a results file.
+///
+/// \param results_file Path to the results file being written by the run.
+///
+/// \return The path to the status file.
+fs::path
+run_status::status_file(const fs::path& results_file)
+{
+    return fs::path(results_file.str() + ".status");
+}
+
+
+/// Atomically writes a status file.
+///
+/// The contents are first written to a temporary file which is then renamed
+/// over the target so that readers never observe a partially-written file.
+///
+/// \param status The status to write.
+/// \param file The status file to create or replace.
+///
+/// \throw fs::system_error If the file cannot be written.
+void
+run_status::write(const status& status, const fs::path& file)
+{
+    const fs::path temp(file.str() + ".tmp");
+    {
+        std::ofstream output(temp.c_str());
+        if (!output)
+            throw fs::system_error(F("Cannot create %s") % temp, errno);
+
+        output << magic << '\n';
+        output << "pid\t" << status.pid << '\n';
+        output << "start_time\t" << status.start_time.to_microseconds()
+               << '\n';
+        output << "done\t" << status.done << '\n';
+        output << "failed\t" << status.failed << '\n';
+        output << "pending_test_programs\t" << status.pending_test_programs
+               << '\n';
+        output << "deferred\t" << status.deferred << '\n';
+        for (running_tests_map::const_iterator iter = status.running.begin();
+             iter != status.running.end(); ++iter) {
+            const running_test& test = (*iter).second;
+            output << "test\t" << (*iter).first << '\t'
+                   << test.start_time.to_microseconds() << '\t'
+                   << test.timeout.to_microseconds() << '\t'
+                   << test.test_program << '\t' << test.test_case_name << '\n';
+        }
+
+        output.flush();
+        if (!output)
+            throw fs::system_error(F("Cannot write to %s") % temp, errno);
+    }
+
+    if (::rename(temp.c_str(), file.c_str()) == -1) {
+        const int original_errno = errno;
+        ::unlink(temp.c_str());
+        throw fs::system_error(F("Cannot rename %s to %s") % temp % file,
+                               original_errno);
+    }
+}
+
+
+/// Reads a status file.
+///
+/// \param file The status file to read.
+///
+/// \return The status stored in the file.
+///
+/// \throw engine::error If the file cannot be opened or is invalid.
+run_status::status
+run_status::read(const fs::path& file)
+{
+    std::ifstream input(file.c_str());
+    if (!input)
+        throw engine::error(F("Cannot open status file %s: %s") % file %
+                            std::strerror(errno));
+
+    std::string line;
+    if (!std::getline(input, line) || line != magic)
+        throw engine::error(F("Invalid header in status file %s") % file);
+
+    status result(0, datetime::timestamp::from_microseconds(0));
+    while (std::getline(input, line)) {
+        const std::vector< std::string > fields = text::split(line, '\t');
+        if (fields.size() == 6 && fields[0] == "test") {
+            const int pid = parse_field< int >(file, "pid", fields[1]);
+            result.running.insert(running_tests_map::value_type(
+                pid, running_test(
+                    fields[4], fields[5],
+                    datetime::timestamp::from_microseconds(
+                        parse_field< int64_t >(file, "start time", fields[2])),
+                    datetime::delta::from_microseconds(
+                        parse_field< int64_t >(file, "timeout", fields[3])))));
+        } else if (fields.size() != 2) {
+            throw engine::error(F("Malformed line '%s' in status file %s") %
+                                line % file);
+        } else if (fields[0] == "pid") {
+            result.pid = parse_field< int >(file, fields[0], fields[1]);
+        } else if (fields[0] == "start_time") {
+            result.start_time = datetime::timestamp::from_microseconds(
+                parse_field< int64_t >(file, fields[0], fields[1]));
+        } else if (fields[0] == "done") {
+            result.done = parse_field< std::size_t >(file, fields[0],
+                                                     fields[1]);
+        } else if (fields[0] == "failed") {
+            result.failed = parse_field< std::size_t >(file, fields[0],
+                                                       fields[1]);
+        } else if (fields[0] == "pending_test_programs") {
+            result.pending_test_programs = parse_field< std::size_t >(
+                file, fields[0], fields[1]);
+        } else if (fields[0] == "deferred") {
+            result.deferred = parse_field< std::size_t >(file, fields[0],
+                                                         fields[1]);
+        } else {
+            // Ignore unknown keys so that newer writers can add fields
+            // without breaking older readers.
+            LD(F("Ignoring unknown key '%s' in status file %s") % fields[0] %
+               file);
+        }
+    }
+    return result;
+}
+
+
+/// Internal implementation for the publisher.
+struct run_status::publisher::impl : utils::noncopyable {
+    /// Path to the status file.
+    const fs::path file;
+
+    /// Current status of the run.
+    run_status::status status;
+
+    /// Whether publishing is still enabled.
+    ///
+    /// This is cleared on the first write error to avoid flooding the log
+    /// with the same problem over and over again.
+    bool enabled;
+
+    /// Constructor.
+    ///
+    /// \param file_ Path to the status file.
+    impl(const fs::path& file_) :
+        file(file_),
+        status(::getpid(), datetime::timestamp::now()),
+        enabled(true)
+    {
+    }
+
+    /// Rewrites the status file with the current status.
+    void
+    publish(void)
+    {
+        if (!enabled)
+            return;
+        try {
+            run_status::write(status, file);
+        } catch (const fs::error& e) {
+            LW(F("Cannot publish run status; giving up: %s") % e.what());
+            enabled = false;
+        }
+    }
+};
+
+
+/// Starts publishing the status of a run.
+///
+/// \param results_file Path to the results file being written by the run.
+run_status::publisher::publisher(const fs::path& results_file) :
+    _pimpl(new impl(status_file(results_file)))
+{
+    _pimpl->publish();
+}
+
+
+/// Withdraws the status of the run.
+run_status::publisher::~publisher(void)
+{
+    if (::unlink(_pimpl->file.c_str()) == -1 && errno != ENOENT) {
+        const int original_errno = errno;
+        LW(F("Failed to remove status file %s: %s") % _pimpl->file %
+           std::strerror(original_errno));
+    }
+}
+
+
+/// Records that a test case has started.
+///
+/// \param pid PID of the process group of the test case.
+/// \param test_program Relative path to the test program.
+/// \param test_case_name Name of the test case.
+/// \param timeout Maximum time the test case is allowed to run for.
+void
+run_status::publisher::test_started(const int pid,
+                                    const std::string& test_program,
+                                    const std::string& test_case_name,
+                                    const datetime::delta& timeout)
+{
+    _pimpl->status.running.erase(pid);
+    _pimpl->status.running.insert(running_tests_map::value_type(
+        pid, running_test(test_program, test_case_name,
+                          datetime::timestamp::now(), timeout)));
+    _pimpl->publish();
+}
+
+
+/// Records that a test case has finished.
+///
+/// \param pid PID of the process group of the test case.
+/// \param failed Whether the test case did not pass.
+void
+run_status::publisher::test_finished(const int pid, const bool failed)
+{
+    PRE(_pimpl->status.running.find(pid) != _pimpl->status.running.end());
+    _pimpl->status.running.erase(pid);
+    ++_pimpl->status.done;
+    if (failed)
+        ++_pimpl->status.failed;
+    _pimpl->publish();
+}
+
+
+/// Updates the amount of work left to do.
+///
+/// \param pending_test_programs Number of test programs that may still have
+///     test cases to run.
+/// \param deferred Number of test cases held back to run after all others.
+void
+run_status::publisher::set_pending(const std::size_t pending_test_programs,
+                                   const std::size_t deferred)
+{
+    if (_pimpl->status.pending_test_programs == pending_test_programs &&
+        _pimpl->status.deferred == deferred)
+        return;
+    _pimpl->status.pending_test_programs = pending_test_programs;
+    _pimpl->status.deferred = deferred;
+    _pimpl->publish();
+}
@@ -0,0 +1,140 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file drivers/run_status.hpp
+/// Live status of an in-progress test run.
+///
+/// While a run is in progress, the run_tests driver publishes a small status
+/// file next to the results file describing which test cases are executing
+/// and how much work is left.  This module implements the format of such file
+/// so that other processes, like the top command, can follow the run without
+/// having to access the results file, which is locked for writing.
+
+#if !defined(DRIVERS_RUN_STATUS_HPP)
+#define DRIVERS_RUN_STATUS_HPP
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/noncopyable.hpp"
+
+namespace drivers {
+namespace run_status {
+
+
+/// Representation of a test case that is currently executing.
+class running_test {
+public:
+    /// Relative path to the test program.
+    std::string test_program;
+
+    /// Name of the test case.
+    std::string test_case_name;
+
+    /// Time at which the test case was started.
+    utils::datetime::timestamp start_time;
+
+    /// Maximum time the test case is allowed to run for.
+    utils::datetime::delta timeout;
+
+    running_test(const std::string&, const std::string&,
+                 const utils::datetime::timestamp&,
+                 const utils::datetime::delta&);
+
+    bool operator==(const running_test&) const;
+};
+
+
+/// Collection of running test cases keyed by the PID of their process group.
+typedef std::map< int, running_test > running_tests_map;
+
+
+/// Snapshot of the progress of a test run.
+class status {
+public:
+    /// PID of the process driving the run.
+    int pid;
+
+    /// Time at which the run started.
+    utils::datetime::timestamp start_time;
+
+    /// Number of test cases that have completed.
+    std::size_t done;
+
+    /// Number of completed test cases that did not pass.
+    std::size_t failed;
+
+    /// Number of test programs that may still have test cases to run.
+    std::size_t pending_test_programs;
+
+    /// Number of test cases held back to run after all others.
+    std::size_t deferred;
+
+    /// The test cases that are currently executing.
+    running_tests_map running;
+
+    status(const int, const utils::datetime::timestamp&);
+
+    bool operator==(const status&) const;
+};
+
+
+utils::fs::path status_file(const utils::fs::path&);
+void write(const status&, const utils::fs::path&);
+status read(const utils::fs::path&);
+
+
+/// Publishes the status of a run and withdraws it on destruction.
+///
+/// Failures to update the status file are logged but otherwise ignored: the
+/// status file is a debugging aid and must never cause a run to fail.
+class publisher : utils::noncopyable {
+    struct impl;
+
+    /// Pointer to the shared internal implementation.
+    std::auto_ptr< impl > _pimpl;
+
+public:
+    explicit publisher(const utils::fs::path&);
+    ~publisher(void);
+
+    void test_started(const int, const std::string&, const std::string&,
+                      const utils::datetime::delta&);
+    void test_finished(const int, const bool);
+    void set_pending(const std::size_t, const std::size_t);
+};
+
+
+}  // namespace run_status
+}  // namespace drivers
+
+#endif  // !defined(DRIVERS_RUN_STATUS_HPP)
@@ -0,0 +1,199 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "drivers/run_status.hpp"
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <atf-c++.hpp>
+
+#include "engine/exceptions.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace run_status = drivers::run_status;
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(status_file);
+ATF_TEST_CASE_BODY(status_file)
+{
+    ATF_REQUIRE_EQ(fs::path("/a/b/results.db.status"),
+                   run_status::status_file(fs::path("/a/b/results.db")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(write_read__empty);
+ATF_TEST_CASE_BODY(write_read__empty)
+{
+    const run_status::status status(
+        1234, datetime::timestamp::from_microseconds(987654321));
+    run_status::write(status, fs::path("status"));
+    ATF_REQUIRE(!fs::exists(fs::path("status.tmp")));
+    ATF_REQUIRE(status == run_status::read(fs::path("status")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(write_read__some);
+ATF_TEST_CASE_BODY(write_read__some)
+{
+    run_status::status status(
+        1234, datetime::timestamp::from_microseconds(987654321));
+    status.done = 15;
+    status.failed = 3;
+    status.pending_test_programs = 4;
+    status.deferred = 2;
+    status.running.insert(run_status::running_tests_map::value_type(
+        50, run_status::running_test(
+            "dir/foo_test", "first",
+            datetime::timestamp::from_microseconds(1000),
+            datetime::delta(300, 0))));
+    status.running.insert(run_status::running_tests_map::value_type(
+        60, run_status::running_test(
+            "path with spaces/bar_test", "second",
+            datetime::timestamp::from_microseconds(2000),
+            datetime::delta(5, 500))));
+
+    run_status::write(status, fs::path("status"));
+    ATF_REQUIRE(status == run_status::read(fs::path("status")));
+
+    status.running.erase(50);
+    run_status::write(status, fs::path("status"));
+    ATF_REQUIRE(status == run_status::read(fs::path("status")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read__missing);
+ATF_TEST_CASE_BODY(read__missing)
+{
+    ATF_REQUIRE_THROW_RE(engine::error, "Cannot open status file missing",
+                         run_status::read(fs::path("missing")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read__bad_header);
+ATF_TEST_CASE_BODY(read__bad_header)
+{
+    atf::utils::create_file("status", "kyua-run-status\t2\npid\t5\n");
+    ATF_REQUIRE_THROW_RE(engine::error, "Invalid header",
+                         run_status::read(fs::path("status")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read__malformed_line);
+ATF_TEST_CASE_BODY(read__malformed_line)
+{
+    atf::utils::create_file("status", "kyua-run-status\t1\npid 5\n");
+    ATF_REQUIRE_THROW_RE(engine::error, "Malformed line 'pid 5'",
+                         run_status::read(fs::path("status")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read__invalid_value);
+ATF_TEST_CASE_BODY(read__invalid_value)
+{
+    atf::utils::create_file("status", "kyua-run-status\t1\ndone\tabc\n");
+    ATF_REQUIRE_THROW_RE(engine::error, "Invalid done 'abc'",
+                         run_status::read(fs::path("status")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read__unknown_keys);
+ATF_TEST_CASE_BODY(read__unknown_keys)
+{
+    atf::utils::create_file("status", "kyua-run-status\t1\npid\t5\n"
+                            "future\tvalue\n");
+    ATF_REQUIRE_EQ(5, run_status::read(fs::path("status")).pid);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(publisher__lifecycle);
+ATF_TEST_CASE_BODY(publisher__lifecycle)
+{
+    const fs::path file("results.db.status");
+    {
+        run_status::publisher publisher(fs::path("results.db"));
+        run_status::status status = run_status::read(file);
+        ATF_REQUIRE_EQ(::getpid(), status.pid);
+        ATF_REQUIRE(status.running.empty());
+
+        publisher.set_pending(3, 1);
+        publisher.test_started(100, "dir/prog", "first",
+                               datetime::delta(60, 0));
+        publisher.test_started(200, "dir/prog", "second",
+                               datetime::delta(30, 0));
+        status = run_status::read(file);
+        ATF_REQUIRE_EQ(3, status.pending_test_programs);
+        ATF_REQUIRE_EQ(1, status.deferred);
+        ATF_REQUIRE_EQ(2, status.running.size());
+        ATF_REQUIRE_EQ("first", (*status.running.find(100)).second
+                       .test_case_name);
+        ATF_REQUIRE(datetime::delta(30, 0) ==
+                    (*status.running.find(200)).second.timeout);
+
+        publisher.test_finished(100, false);
+        publisher.test_finished(200, true);
+        status = run_status::read(file);
+        ATF_REQUIRE_EQ(2, status.done);
+        ATF_REQUIRE_EQ(1, status.failed);
+        ATF_REQUIRE(status.running.empty());
+    }
+    ATF_REQUIRE(!fs::exists(file));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(publisher__write_error);
+ATF_TEST_CASE_BODY(publisher__write_error)
+{
+    // Publishing failures must not propagate to the caller.
+    run_status::publisher publisher(fs::path("missing/dir/results.db"));
+    publisher.test_started(100, "prog", "case", datetime::delta(60, 0));
+    publisher.test_finished(100, true);
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, status_file);
+
+    ATF_ADD_TEST_CASE(tcs, write_read__empty);
+    ATF_ADD_TEST_CASE(tcs, write_read__some);
+
+    ATF_ADD_TEST_CASE(tcs, read__missing);
+    ATF_ADD_TEST_CASE(tcs, read__bad_header);
+    ATF_ADD_TEST_CASE(tcs, read__malformed_line);
+    ATF_ADD_TEST_CASE(tcs, read__invalid_value);
+    ATF_ADD_TEST_CASE(tcs, read__unknown_keys);
+
+    ATF_ADD_TEST_CASE(tcs, publisher__lifecycle);
+    ATF_ADD_TEST_CASE(tcs, publisher__write_error);
+}
@@ -28,9 +28,17 @@
 
 #include "drivers/run_tests.hpp"
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "drivers/run_status.hpp"
+#include "engine/budget.hpp"
 #include "engine/config.hpp"
+#include "engine/contention.hpp"
 #include "engine/filters.hpp"
 #include "engine/kyuafile.hpp"
 #include "engine/scanner.hpp"
@@ -40,24 +48,42 @@
 #include "model/test_case.hpp"
 #include "model/test_program.hpp"
 #include "model/test_result.hpp"
+#include "store/exceptions.hpp"
+#include "store/layout.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
 #include "store/write_backend.hpp"
 #include "store/write_transaction.hpp"
 #include "utils/config/tree.ipp"
 #include "utils/datetime.hpp"
 #include "utils/defs.hpp"
+#include "utils/env.hpp"
 #include "utils/format/macros.hpp"
+#include "utils/fs/auto_cleaners.hpp"
+#include "utils/fs/exceptions.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/heap_stats.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/noncopyable.hpp"
 #include "utils/optional.ipp"
 #include "utils/passwd.hpp"
+#include "utils/process/jobserver.hpp"
+#include "utils/signals/exceptions.hpp"
 #include "utils/text/operations.ipp"
+#include "utils/units.hpp"
 
 namespace config = utils::config;
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
+namespace heap_stats = utils::heap_stats;
 namespace passwd = utils::passwd;
+namespace process = utils::process;
+namespace run_status = drivers::run_status;
 namespace scheduler = engine::scheduler;
+namespace signals = utils::signals;
 namespace text = utils::text;
+namespace units = utils::units;
 
 using utils::none;
 using utils::optional;
@@ -81,6 +107,1132 @@ typedef std::map< int, int64_t > pid_to_id_map;
 typedef pid_to_id_map::value_type pid_and_id_pair;
 
 
+/// Maximum number of past results files to predict durations from.
+static const std::size_t max_history_files = 10;
+
+
+/// Maximum number of past results files to classify test cases from.
+static const std::size_t max_usage_files = 3;
+
+
+/// Number of test cases per slot to consider when balancing resources.
+static const std::size_t lookahead_per_slot = 2;
+
+
+/// Maximum number of test cases per slot to consider when balancing resources
+/// if none of the first ones can run.
+static const std::size_t max_lookahead_per_slot = 8;
+
+
+/// Time to wait for a jobserver token between checks for completed tests.
+static const datetime::delta jobserver_poll_interval(0, 20000);
+
+
+/// Reason of the results of the test cases that do not fit in the time budget.
+static const char* const deferred_reason =
+    "Deferred: does not fit in the time budget";
+
+
+/// Reason of the results of the test cases whose dependencies did not pass.
+static const char* const dependency_reason = "Dependency %s did not pass";
+
+
+/// Keeps track of the test programs that have their fixture set up.
+///
+/// A fixture is set up right before the first test case of its test program
+/// is dispatched and torn down as soon as the scanner has moved past the test
+/// program and none of its test cases are running or held back.  The setup
+/// command runs in the background: the test cases of its test program are held
+/// back until it completes while other test programs keep running.
+class fixture_tracker : utils::noncopyable {
+    /// State of an active fixture.
+    struct state {
+        /// The test program owning the fixture.
+        model::test_program_ptr test_program;
+
+        /// Number of test cases that are running or held back.
+        std::size_t users;
+
+        /// Whether the scanner has yielded all test cases of the program.
+        bool scanned;
+
+        /// Whether the setup command has completed.
+        bool ready;
+
+        /// Test cases waiting for the setup command to complete.
+        std::vector< engine::scan_result > held;
+
+        /// Constructor.
+        ///
+        /// \param test_program_ The test program owning the fixture.
+        /// \param scanned_ Whether the scanner is already past the program.
+        /// \param ready_ Whether the fixture is ready for use.
+        state(const model::test_program_ptr test_program_,
+              const bool scanned_, const bool ready_) :
+            test_program(test_program_), users(0), scanned(scanned_),
+            ready(ready_)
+        {
+        }
+    };
+
+    /// Collection of active fixtures keyed by the relative path of their
+    /// test programs.
+    typedef std::map< fs::path, state > states_map;
+
+    /// Scheduler that owns the fixtures.
+    scheduler::scheduler_handle& _handle;
+
+    /// The end-user configuration properties.
+    const config::tree& _user_config;
+
+    /// The active fixtures.
+    states_map _states;
+
+    /// The test program the scanner is yielding test cases from, if any.
+    optional< fs::path > _scanning;
+
+    /// Whether the scanner has yielded all test cases.
+    bool _scan_done;
+
+    /// Number of fixtures whose setup command is running.
+    std::size_t _setting_up;
+
+    /// Number of test cases waiting for a setup command to complete.
+    std::size_t _held;
+
+    /// Tears down a fixture if it is not needed any longer.
+    ///
+    /// \param iter The fixture to check.  Invalidated if torn down.
+    void
+    maybe_teardown(const states_map::iterator iter)
+    {
+        const state& data = (*iter).second;
+        if (data.scanned && data.users == 0) {
+            _handle.teardown_fixture(data.test_program);
+            _states.erase(iter);
+        }
+    }
+
+public:
+    /// Constructor.
+    ///
+    /// \param handle Scheduler that owns the fixtures.
+    /// \param user_config The end-user configuration properties.
+    fixture_tracker(scheduler::scheduler_handle& handle,
+                    const config::tree& user_config) :
+        _handle(handle), _user_config(user_config), _scan_done(false),
+        _setting_up(0), _held(0)
+    {
+    }
+
+    /// Notifies that the scanner has yielded a test case.
+    ///
+    /// This marks any other test programs as fully scanned.
+    ///
+    /// \param test_program The test program of the test case.
+    void
+    yielded(const model::test_program_ptr test_program)
+    {
+        const fs::path& key = test_program->relative_path();
+        for (states_map::iterator iter = _states.begin();
+             iter != _states.end(); ) {
+            states_map::iterator current = iter++;
+            if ((*current).first != key && !(*current).second.scanned) {
+                (*current).second.scanned = true;
+                maybe_teardown(current);
+            }
+        }
+        _scanning = key;
+    }
+
+    /// Registers a test case that is about to be dispatched.
+    ///
+    /// This sets up the fixture of the test program the first time it is
+    /// needed.  If the setup command is still running, the test case is held
+    /// back until set_up() is called for the fixture.
+    ///
+    /// \param match Test program and test case to register.
+    ///
+    /// \return True if the test case can be dispatched right away; false if it
+    /// has been held back.
+    bool
+    acquire(const engine::scan_result& match)
+    {
+        const model::test_program_ptr test_program = match.first;
+        if (!scheduler::has_fixture(*test_program))
+            return true;
+        const fs::path& key = test_program->relative_path();
+        states_map::iterator iter = _states.find(key);
+        if (iter == _states.end()) {
+            const bool ready = _handle.setup_fixture(test_program,
+                                                     _user_config);
+            if (!ready)
+                ++_setting_up;
+            const bool scanned = _scan_done || !_scanning ||
+                _scanning.get() != key;
+            iter = _states.insert(states_map::value_type(
+                key, state(test_program, scanned, ready))).first;
+        }
+        state& data = (*iter).second;
+        ++data.users;
+        if (!data.ready) {
+            data.held.push_back(match);
+            ++_held;
+        }
+        return data.ready;
+    }
+
+    /// Processes the completion of the setup command of a fixture.
+    ///
+    /// \param result_handle The completion handle of the setup command.
+    ///
+    /// \return The test cases that were held back until now.
+    std::vector< engine::scan_result >
+    set_up(const scheduler::fixture_result_handle& result_handle)
+    {
+        const states_map::iterator iter = _states.find(
+            result_handle.test_program()->relative_path());
+        INV(iter != _states.end() && !(*iter).second.ready);
+        state& data = (*iter).second;
+        data.ready = true;
+        --_setting_up;
+        _held -= data.held.size();
+
+        std::vector< engine::scan_result > released;
+        released.swap(data.held);
+        return released;
+    }
+
+    /// Returns the number of fixtures whose setup command is running.
+    ///
+    /// \return A count of fixtures.
+    std::size_t
+    setting_up(void) const
+    {
+        return _setting_up;
+    }
+
+    /// Returns the number of test cases waiting for a setup command.
+    ///
+    /// \return A count of test cases.
+    std::size_t
+    held(void) const
+    {
+        return _held;
+    }
+
+    /// Unregisters a test case that has completed.
+    ///
+    /// \param test_program The test program of the test case.
+    void
+    release(const model::test_program_ptr test_program)
+    {
+        const states_map::iterator iter = _states.find(
+            test_program->relative_path());
+        if (iter == _states.end())
+            return;
+        INV((*iter).second.users > 0);
+        --(*iter).second.users;
+        maybe_teardown(iter);
+    }
+
+    /// Notifies that the scanner has yielded all test cases.
+    void
+    scan_done(void)
+    {
+        _scan_done = true;
+        for (states_map::iterator iter = _states.begin();
+             iter != _states.end(); ) {
+            states_map::iterator current = iter++;
+            (*current).second.scanned = true;
+            maybe_teardown(current);
+        }
+    }
+};
+
+
+/// Keeps track of the dependencies between the test programs being run.
+///
+/// A test program is complete once the scanner has moved past it and none of
+/// its test cases are pending.  The test cases of a test program are held back
+/// until all of its prerequisites are complete, and are skipped if any test
+/// case of the prerequisites did not pass.  Prerequisites that are not part of
+/// the run are ignored.
+class dependency_tracker : utils::noncopyable {
+    /// State of a test program.
+    struct state {
+        /// Prerequisites of the test program that are part of the run.
+        std::vector< fs::path > prerequisites;
+
+        /// Number of test cases yielded by the scanner that have not
+        /// completed yet.
+        std::size_t pending;
+
+        /// Whether the scanner has yielded all test cases of the program.
+        bool scanned;
+
+        /// Whether any test case of the program did not pass.
+        bool failed;
+
+        /// Constructor.
+        state(void) : pending(0), scanned(false), failed(false)
+        {
+        }
+    };
+
+    /// Collection of test programs keyed by their relative paths.
+    typedef std::map< fs::path, state > states_map;
+
+    /// The test programs being run.
+    states_map _states;
+
+    /// The test programs being run, in the order in which they are scanned.
+    std::vector< states_map::iterator > _scan_order;
+
+    /// Index in _scan_order of the test program being scanned.
+    std::size_t _scan_position;
+
+    /// Test cases held back until their prerequisites complete.
+    std::vector< engine::scan_result > _blocked;
+
+    /// Gets the state of a test program.
+    ///
+    /// \param test_program The test program to query.
+    ///
+    /// \return The state of the test program.
+    state&
+    lookup(const model::test_program_ptr test_program)
+    {
+        const states_map::iterator iter = _states.find(
+            test_program->relative_path());
+        INV(iter != _states.end());
+        return (*iter).second;
+    }
+
+    /// Checks whether all prerequisites of a test program have completed.
+    ///
+    /// \param data The state of the test program.
+    ///
+    /// \return True if the test cases of the program can be dispatched.
+    bool
+    ready(const state& data) const
+    {
+        for (std::vector< fs::path >::const_iterator
+                 iter = data.prerequisites.begin();
+             iter != data.prerequisites.end(); ++iter) {
+            const state& prerequisite = (*_states.find(*iter)).second;
+            if (!prerequisite.scanned || prerequisite.pending > 0)
+                return false;
+        }
+        return true;
+    }
+
+public:
+    /// Constructor.
+    ///
+    /// \param test_programs The test programs to run, in scanning order.
+    explicit dependency_tracker(
+        const model::test_programs_vector& test_programs) :
+        _scan_position(0)
+    {
+        for (model::test_programs_vector::const_iterator
+                 iter = test_programs.begin(); iter != test_programs.end();
+             ++iter) {
+            _scan_order.push_back(_states.insert(states_map::value_type(
+                (*iter)->relative_path(), state())).first);
+        }
+
+        for (model::test_programs_vector::const_iterator
+                 iter = test_programs.begin(); iter != test_programs.end();
+             ++iter) {
+            const model::strings_set depends_on =
+                (*iter)->get_metadata().depends_on();
+            state& data = lookup(*iter);
+            for (model::strings_set::const_iterator dep = depends_on.begin();
+                 dep != depends_on.end(); ++dep) {
+                const fs::path prerequisite(*dep);
+                if (_states.find(prerequisite) != _states.end())
+                    data.prerequisites.push_back(prerequisite);
+            }
+        }
+    }
+
+    /// Notifies that the scanner has yielded a test case.
+    ///
+    /// The scanner processes test programs in order, so this marks all the
+    /// test programs before the given one as fully scanned.
+    ///
+    /// \param test_program The test program of the test case.
+    void
+    yielded(const model::test_program_ptr test_program)
+    {
+        const states_map::iterator iter = _states.find(
+            test_program->relative_path());
+        INV(iter != _states.end());
+        while (_scan_position < _scan_order.size() &&
+               _scan_order[_scan_position] != iter) {
+            (*_scan_order[_scan_position]).second.scanned = true;
+            ++_scan_position;
+        }
+        ++(*iter).second.pending;
+    }
+
+    /// Notifies that the scanner has yielded all test cases.
+    void
+    scan_done(void)
+    {
+        for (; _scan_position < _scan_order.size(); ++_scan_position)
+            (*_scan_order[_scan_position]).second.scanned = true;
+    }
+
+    /// Checks whether the test cases of a test program can be dispatched.
+    ///
+    /// \param test_program The test program to query.
+    ///
+    /// \return True if all prerequisites of the test program have completed.
+    bool
+    ready(const model::test_program_ptr test_program)
+    {
+        return ready(lookup(test_program));
+    }
+
+    /// Looks for a completed prerequisite that did not pass.
+    ///
+    /// \param test_program The test program to query.
+    ///
+    /// \return The name of the first failed prerequisite, if any.
+    optional< fs::path >
+    failed_prerequisite(const model::test_program_ptr test_program)
+    {
+        const state& data = lookup(test_program);
+        for (std::vector< fs::path >::const_iterator
+                 iter = data.prerequisites.begin();
+             iter != data.prerequisites.end(); ++iter) {
+            if ((*_states.find(*iter)).second.failed)
+                return utils::make_optional(*iter);
+        }
+        return none;
+    }
+
+    /// Holds back a test case until its prerequisites complete.
+    ///
+    /// \param match The test case to hold back.
+    void
+    block(const engine::scan_result& match)
+    {
+        _blocked.push_back(match);
+    }
+
+    /// Notifies that a test case yielded by the scanner has completed.
+    ///
+    /// \param test_program The test program of the test case.
+    /// \param good Whether the test case passed.
+    void
+    done(const model::test_program_ptr test_program, const bool good)
+    {
+        state& data = lookup(test_program);
+        INV(data.pending > 0);
+        --data.pending;
+        if (!good)
+            data.failed = true;
+    }
+
+    /// Releases the held back test cases whose prerequisites have completed.
+    ///
+    /// \return The released test cases, in the order they were held back.
+    std::vector< engine::scan_result >
+    unblock(void)
+    {
+        std::vector< engine::scan_result > released;
+        std::vector< engine::scan_result > still_blocked;
+        for (std::vector< engine::scan_result >::const_iterator
+                 iter = _blocked.begin(); iter != _blocked.end(); ++iter) {
+            if (ready(lookup((*iter).first)))
+                released.push_back(*iter);
+            else
+                still_blocked.push_back(*iter);
+        }
+        _blocked.swap(still_blocked);
+        return released;
+    }
+
+    /// Gets the number of test cases held back.
+    ///
+    /// \return A count of test cases.
+    std::size_t
+    blocked(void) const
+    {
+        return _blocked.size();
+    }
+};
+
+
+/// Limits the number of running tests to the tokens of a make jobserver.
+///
+/// Like any other client of a jobserver, we can run one test case for free
+/// and need to hold a token for every additional test case that runs
+/// concurrently.  Test cases inherit MAKEFLAGS, so any make they run draws
+/// from the same pool of tokens.
+class jobserver_slots : utils::noncopyable {
+    /// Directory holding the FIFO of the jobserver we created, if any.
+    std::auto_ptr< fs::auto_directory > _directory;
+
+    /// The jobserver we are a client of, if any.
+    std::auto_ptr< process::jobserver > _jobserver;
+
+    /// Value of MAKEFLAGS to restore, if we replaced it.
+    optional< optional< std::string > > _old_makeflags;
+
+public:
+    /// Constructor.
+    ///
+    /// \param user_config The end-user configuration properties.
+    /// \param slots Maximum number of test cases to run concurrently.
+    ///
+    /// \throw process::error If the jobserver cannot be joined or created.
+    jobserver_slots(const config::tree& user_config, const std::size_t slots)
+    {
+        const std::string mode = user_config.is_set("jobserver") ?
+            user_config.lookup< engine::jobserver_node >("jobserver") :
+            "auto";
+        if (mode == "none")
+            return;
+
+        const optional< std::string > makeflags = utils::getenv("MAKEFLAGS");
+        if (makeflags) {
+            _jobserver = process::jobserver::join(makeflags.get());
+            if (_jobserver.get() != NULL || mode == "auto")
+                return;
+        } else if (mode == "auto") {
+            return;
+        }
+
+        INV(mode == "serve");
+        _directory.reset(new fs::auto_directory(
+            fs::auto_directory::mkdtemp_public("kyua.XXXXXX")));
+        _jobserver = process::jobserver::create(
+            _directory->directory() / "jobserver", slots - 1);
+        _old_makeflags = makeflags;
+        utils::setenv("MAKEFLAGS", _jobserver->makeflags());
+    }
+
+    /// Destructor; returns any held tokens and restores the environment.
+    ~jobserver_slots(void)
+    {
+        if (_old_makeflags) {
+            if (_old_makeflags.get())
+                utils::setenv("MAKEFLAGS", _old_makeflags.get().get());
+            else
+                utils::unsetenv("MAKEFLAGS");
+        }
+        _jobserver.reset();
+    }
+
+    /// Acquires the tokens needed to spawn one more test case.
+    ///
+    /// \param in_flight Number of test cases currently running.
+    /// \param timeout Maximum time to wait for every missing token.
+    ///
+    /// \return True if a new test case can be spawned; false otherwise.
+    bool
+    reserve(const std::size_t in_flight,
+            const datetime::delta& timeout = datetime::delta())
+    {
+        if (_jobserver.get() == NULL)
+            return true;
+        while (_jobserver->held() < in_flight) {
+            if (!_jobserver->try_acquire(timeout))
+                return false;
+        }
+        return true;
+    }
+
+    /// Returns the tokens not needed by the running test cases.
+    ///
+    /// \param in_flight Number of test cases currently running.
+    void
+    trim(const std::size_t in_flight)
+    {
+        if (_jobserver.get() == NULL)
+            return;
+        const std::size_t needed = in_flight == 0 ? 0 : in_flight - 1;
+        while (_jobserver->held() > needed)
+            _jobserver->release();
+    }
+};
+
+
+/// Periodically saves the results of a staged store to its backing file.
+///
+/// In staged mode, results are written to an in-memory database and only
+/// reach the results file when it is flushed.  Flushing at regular intervals
+/// bounds the amount of results lost if the run is killed abruptly.
+class staged_store_saver : utils::noncopyable {
+    /// The store being written to.
+    store::write_backend& _backend;
+
+    /// Time between saves, or none if the store is not staged.
+    const optional< datetime::delta > _interval;
+
+    /// Time after which the next save has to happen.
+    datetime::timestamp _deadline;
+
+public:
+    /// Constructor.
+    ///
+    /// \param backend The store being written to.
+    /// \param interval Time between saves, or none if the store is not staged.
+    staged_store_saver(store::write_backend& backend,
+                       const optional< datetime::delta >& interval) :
+        _backend(backend),
+        _interval(interval),
+        _deadline(datetime::timestamp::now())
+    {
+        if (_interval)
+            _deadline += _interval.get();
+    }
+
+    /// Saves the store if the interval since the previous save has elapsed.
+    ///
+    /// \param [in,out] tx The open transaction.  It is committed and replaced
+    ///     by a new one if the store is saved.
+    ///
+    /// \throw store::error If the results cannot be committed or saved.
+    void
+    maybe_save(store::write_transaction& tx)
+    {
+        if (!_interval)
+            return;
+        const datetime::timestamp now = datetime::timestamp::now();
+        if (now < _deadline)
+            return;
+
+        tx.commit();
+        _backend.flush();
+        tx = _backend.start_write();
+        _deadline = now + _interval.get();
+    }
+};
+
+
+/// Balances the resources used by the test cases that run concurrently.
+///
+/// Balancing only makes sense if several test cases run at once and if there is
+/// something to tell test cases apart: explicit resource classes, past resource
+/// usage or per-class limits.  Otherwise, test cases run in scanning order.
+class contention_tracker : utils::noncopyable {
+    /// The resources used by past executions of test cases.
+    const engine::usage_map _usage;
+
+    /// The balancer of the running test cases.
+    engine::contention_balancer _balancer;
+
+    /// Whether balancing is enabled.
+    bool _enabled;
+
+    /// Number of execution slots.
+    const std::size_t _slots;
+
+    /// Classifies a test case.
+    ///
+    /// \param test_program The test program of the test case.
+    /// \param test_case_name The name of the test case.
+    ///
+    /// \return The resource class of the test case.  Exclusive test cases are
+    /// not classified because they run on their own.
+    engine::resource_class
+    classify(const model::test_program& test_program,
+             const std::string& test_case_name) const
+    {
+        if (!_enabled || test_program.find(test_case_name).get_metadata()
+            .is_exclusive())
+            return engine::class_none;
+        return engine::classify(test_program, test_case_name, _usage);
+    }
+
+    /// Gets the per-class limits from the configuration.
+    ///
+    /// \param user_config The end-user configuration properties.
+    ///
+    /// \return The maximum number of concurrent test cases per class.
+    static std::map< engine::resource_class, std::size_t >
+    get_caps(const config::tree& user_config)
+    {
+        static const struct {
+            const char* name;
+            engine::resource_class resource;
+        } vars[] = {
+            { "max_cpu_tests", engine::class_cpu },
+            { "max_io_tests", engine::class_io },
+            { "max_memory_tests", engine::class_memory },
+        };
+
+        std::map< engine::resource_class, std::size_t > caps;
+        for (std::size_t i = 0; i < sizeof(vars) / sizeof(vars[0]); ++i) {
+            if (user_config.is_set(vars[i].name))
+                caps[vars[i].resource] =
+                    user_config.lookup< config::positive_int_node >(
+                        vars[i].name);
+        }
+        return caps;
+    }
+
+public:
+    /// Constructor.
+    ///
+    /// \param test_programs The test programs to run.
+    /// \param usage The resources used by past executions of test cases.
+    /// \param slots Number of execution slots.
+    /// \param user_config The end-user configuration properties.
+    contention_tracker(const model::test_programs_vector& test_programs,
+                       const engine::usage_map& usage,
+                       const std::size_t slots,
+                       const config::tree& user_config) :
+        _usage(usage),
+        _balancer(get_caps(user_config)),
+        _enabled(false),
+        _slots(slots)
+    {
+        if (slots == 1)
+            return;
+
+        _enabled = !_usage.empty() || !get_caps(user_config).empty();
+        for (model::test_programs_vector::const_iterator
+                 iter = test_programs.begin();
+             !_enabled && iter != test_programs.end(); ++iter) {
+            _enabled = !(*iter)->get_metadata().resource_class().empty();
+        }
+        LI(F("Resource balancing is %s") % (_enabled ? "enabled" : "disabled"));
+    }
+
+    /// Gets the number of ready test cases to choose from.
+    ///
+    /// \return A count of test cases.
+    std::size_t
+    lookahead(void) const
+    {
+        return _enabled ? _slots * lookahead_per_slot : 1;
+    }
+
+    /// Gets the number of ready test cases to choose from if none of the
+    /// first lookahead() ones can run.
+    ///
+    /// \return A count of test cases.
+    std::size_t
+    max_lookahead(void) const
+    {
+        return _enabled ? _slots * max_lookahead_per_slot : 1;
+    }
+
+    /// Picks the test case to run next.
+    ///
+    /// \param ready_tests The test cases ready to be dispatched, in order.
+    ///
+    /// \return The index of the test case to run, or none if none of them can
+    /// run until other test cases finish.
+    optional< std::size_t >
+    pick(const std::deque< engine::scan_result >& ready_tests) const
+    {
+        if (!_enabled)
+            return ready_tests.empty() ? none : utils::make_optional(
+                std::size_t(0));
+
+        std::vector< engine::resource_class > classes;
+        for (std::deque< engine::scan_result >::const_iterator
+                 iter = ready_tests.begin(); iter != ready_tests.end(); ++iter)
+            classes.push_back(classify(*(*iter).first, (*iter).second));
+        return _balancer.pick(classes);
+    }
+
+    /// Notifies that a test case has started.
+    ///
+    /// \param test_program The test program of the test case.
+    /// \param test_case_name The name of the test case.
+    void
+    started(const model::test_program& test_program,
+            const std::string& test_case_name)
+    {
+        _balancer.started(classify(test_program, test_case_name));
+    }
+
+    /// Notifies that a test case has finished.
+    ///
+    /// \param test_program The test program of the test case.
+    /// \param test_case_name The name of the test case.
+    void
+    finished(const model::test_program& test_program,
+             const std::string& test_case_name)
+    {
+        _balancer.finished(classify(test_program, test_case_name));
+    }
+};
+
+
+/// Re-runs on their own the test cases that fail while running concurrently.
+///
+/// Some test cases only fail when they run at the same time as others, for
+/// example because they compete for a fixed port or a shared file.  When
+/// enabled, the results of the test cases that fail in the parallel phase are
+/// held back until all other test cases have run, at which point they are
+/// re-run one at a time.  Those that pass on their own are recorded as
+/// suspected of suffering from interference along with the test cases that
+/// overlapped with the failing execution.
+class interference_checker : utils::noncopyable {
+public:
+    /// A failed execution whose result is held back until it is re-checked.
+    struct failure {
+        /// The test program of the test case.
+        model::test_program_ptr test_program;
+
+        /// The name of the test case.
+        std::string test_case_name;
+
+        /// Identifier of the test case in the store.
+        int64_t test_case_id;
+
+        /// The result of the execution.
+        model::test_result result;
+
+        /// The time the execution started at.
+        datetime::timestamp start_time;
+
+        /// The time the execution ended at.
+        datetime::timestamp end_time;
+
+        /// Constructor.
+        ///
+        /// \param test_program_ The test program of the test case.
+        /// \param test_case_name_ The name of the test case.
+        /// \param test_case_id_ Identifier of the test case in the store.
+        /// \param result_ The result of the execution.
+        /// \param start_time_ The time the execution started at.
+        /// \param end_time_ The time the execution ended at.
+        failure(const model::test_program_ptr test_program_,
+                const std::string& test_case_name_,
+                const int64_t test_case_id_,
+                const model::test_result& result_,
+                const datetime::timestamp& start_time_,
+                const datetime::timestamp& end_time_) :
+            test_program(test_program_), test_case_name(test_case_name_),
+            test_case_id(test_case_id_), result(result_),
+            start_time(start_time_), end_time(end_time_)
+        {
+        }
+    };
+
+private:
+    /// An execution of a test case in the parallel phase.
+    struct execution {
+        /// Identifier of the test case in the form program:case.
+        std::string id;
+
+        /// The time the execution started at.
+        datetime::timestamp start_time;
+
+        /// The time the execution ended at.
+        datetime::timestamp end_time;
+    };
+
+    /// Whether failures are re-checked.
+    bool _enabled;
+
+    /// All executions seen so far, in completion order.
+    std::vector< execution > _executions;
+
+    /// The failures pending a re-check, in completion order.
+    std::deque< failure > _held;
+
+    /// Formats the identifier of a test case.
+    ///
+    /// \param test_program The test program of the test case.
+    /// \param test_case_name The name of the test case.
+    ///
+    /// \return The identifier in the form program:case.
+    static std::string
+    format_id(const model::test_program& test_program,
+              const std::string& test_case_name)
+    {
+        return F("%s:%s") % test_program.relative_path() % test_case_name;
+    }
+
+public:
+    /// Constructor.
+    ///
+    /// \param slots Number of execution slots.
+    /// \param user_config The end-user configuration properties.
+    interference_checker(const std::size_t slots,
+                         const config::tree& user_config) :
+        _enabled(slots > 1 && user_config.is_set("recheck_failures") &&
+                 user_config.lookup< config::bool_node >("recheck_failures"))
+    {
+    }
+
+    /// Records the execution of a test case and holds its result if it failed.
+    ///
+    /// Exclusive test cases run on their own already, so their failures cannot
+    /// be caused by interference and are never held.
+    ///
+    /// \param handle The completion handle of the test case.
+    /// \param test_case_id Identifier of the test case in the store.
+    ///
+    /// \return True if the result is held back and must not be stored yet.
+    bool
+    finished(const scheduler::test_result_handle& handle,
+             const int64_t test_case_id)
+    {
+        if (!_enabled)
+            return false;
+
+        const model::test_program_ptr test_program = handle.test_program();
+        const std::string& test_case_name = handle.test_case_name();
+
+        const execution data = {
+            format_id(*test_program, test_case_name),
+            handle.start_time(), handle.end_time() };
+        _executions.push_back(data);
+
+        const model::test_result& result = handle.test_result();
+        if (result.good() || test_program->find(test_case_name)
+            .get_metadata().is_exclusive())
+            return false;
+
+        _held.push_back(failure(test_program, test_case_name, test_case_id,
+                                result, handle.start_time(),
+                                handle.end_time()));
+        return true;
+    }
+
+    /// Checks whether there are failures pending a re-check.
+    ///
+    /// \return True if there are no held failures.
+    bool
+    empty(void) const
+    {
+        return _held.empty();
+    }
+
+    /// Gets the number of failures pending a re-check.
+    ///
+    /// \return A count of held failures.
+    std::size_t
+    size(void) const
+    {
+        return _held.size();
+    }
+
+    /// Gets the oldest failure pending a re-check.
+    ///
+    /// \pre There are held failures.
+    ///
+    /// \return The failure.
+    const failure&
+    front(void) const
+    {
+        PRE(!_held.empty());
+        return _held.front();
+    }
+
+    /// Discards the oldest failure pending a re-check once it is stored.
+    ///
+    /// \pre There are held failures.
+    void
+    pop(void)
+    {
+        PRE(!_held.empty());
+        _held.pop_front();
+    }
+
+    /// Computes the test cases that ran concurrently with a failure.
+    ///
+    /// \param target The failure to check.
+    ///
+    /// \return The identifiers of the test cases whose executions overlapped
+    /// with the failing one, in completion order.
+    std::vector< std::string >
+    overlapping(const failure& target) const
+    {
+        const std::string target_id = format_id(*target.test_program,
+                                                target.test_case_name);
+
+        std::vector< std::string > ids;
+        for (std::vector< execution >::const_iterator
+                 iter = _executions.begin(); iter != _executions.end();
+             ++iter) {
+            if ((*iter).id != target_id &&
+                (*iter).start_time < target.end_time &&
+                target.start_time < (*iter).end_time)
+                ids.push_back((*iter).id);
+        }
+        return ids;
+    }
+
+    /// Stores the held failures without re-checking them.
+    ///
+    /// This is used when the run is interrupted so that the failures are not
+    /// lost.
+    ///
+    /// \param [in,out] tx Writable transaction to put the test results.
+    void
+    flush(store::write_transaction& tx)
+    {
+        for (std::deque< failure >::const_iterator iter = _held.begin();
+             iter != _held.end(); ++iter) {
+            tx.put_result((*iter).result, (*iter).test_case_id,
+                          (*iter).start_time, (*iter).end_time);
+        }
+        _held.clear();
+    }
+};
+
+
+/// Loads the past executions of the test cases of a test suite.
+///
+/// \param test_suite Identifier of the test suite.
+/// \param [out] last_run Start time of the most recent run, if any.
+///
+/// \return The executions recorded in the most recent results files of the
+/// test suite.  Results files that cannot be read are ignored.
+static engine::history_map
+load_history(const std::string& test_suite,
+             optional< datetime::timestamp >& last_run)
+{
+    engine::history_map history;
+    last_run = none;
+
+    const std::vector< fs::path > files = store::layout::find_history(
+        test_suite, max_history_files);
+    for (std::vector< fs::path >::const_iterator iter = files.begin();
+         iter != files.end(); ++iter) {
+        try {
+            store::read_backend backend =
+                store::read_backend::open_ro_immutable(*iter);
+            store::read_transaction tx = backend.start_read();
+            for (store::results_iterator result = tx.get_results(); result;
+                 ++result) {
+                const model::test_result test_result = result.result();
+                if (test_result.type() == model::test_result_skipped &&
+                    test_result.reason() == deferred_reason)
+                    continue;
+
+                if (iter == files.begin() &&
+                    (!last_run || result.start_time() < last_run.get()))
+                    last_run = result.start_time();
+                history[engine::test_case_key(
+                    result.test_program()->relative_path(),
+                    result.test_case_name())].add(
+                        test_result.good(),
+                        result.end_time() - result.start_time());
+            }
+            tx.finish();
+            backend.close();
+        } catch (const store::error& e) {
+            LW(F("Ignoring past results in %s: %s") % *iter % e.what());
+        }
+    }
+    return history;
+}
+
+
+/// Loads the resources used by past executions of the test cases of a suite.
+///
+/// \param test_suite Identifier of the test suite.
+///
+/// \return The resource usage recorded in the most recent results files of the
+/// test suite.  Results files that cannot be read or that predate the
+/// recording of resource usage are ignored.
+static engine::usage_map
+load_usage(const std::string& test_suite)
+{
+    engine::usage_map usage;
+
+    const std::vector< fs::path > files = store::layout::find_history(
+        test_suite, max_usage_files);
+    for (std::vector< fs::path >::const_iterator iter = files.begin();
+         iter != files.end(); ++iter) {
+        try {
+            store::read_backend backend =
+                store::read_backend::open_ro_immutable(*iter);
+            store::read_transaction tx = backend.start_read();
+            for (store::results_iterator result = tx.get_results(); result;
+                 ++result) {
+                const optional< datetime::delta > cpu_time =
+                    result.cpu_time();
+                const optional< units::bytes > max_rss = result.max_rss();
+                if (!cpu_time || !max_rss)
+                    continue;
+                usage[engine::test_case_key(
+                    result.test_program()->relative_path(),
+                    result.test_case_name())].add(
+                        result.end_time() - result.start_time(),
+                        cpu_time.get(), max_rss.get());
+            }
+            tx.finish();
+            backend.close();
+        } catch (const store::error& e) {
+            LW(F("Ignoring past resource usage in %s: %s") % *iter % e.what());
+        }
+    }
+    return usage;
+}
+
+
+/// Selects the test cases to run within a time budget.
+///
+/// \param test_programs The test programs defined by the Kyuafile.
+/// \param filters The test case filters as provided by the user.
+/// \param test_suite Identifier of the test suite, to locate its past runs.
+/// \param budget The maximum predicted wall time of the execution.
+/// \param slots The number of test cases that run concurrently.
+/// \param [out] unused_filters The filters that did not match any test case.
+///
+/// \return The test cases to run and the test cases to defer.
+static engine::budget_selection
+apply_time_budget(const model::test_programs_vector& test_programs,
+                  const std::set< engine::test_filter >& filters,
+                  const std::string& test_suite,
+                  const datetime::delta& budget,
+                  const std::size_t slots,
+                  std::set< engine::test_filter >& unused_filters)
+{
+    std::vector< engine::scan_result > candidates;
+    {
+        engine::scanner scanner(test_programs, filters);
+        for (;;) {
+            const optional< engine::scan_result > match = scanner.yield();
+            if (!match)
+                break;
+            candidates.push_back(match.get());
+        }
+        unused_filters = scanner.unused_filters();
+    }
+
+    optional< datetime::timestamp > last_run;
+    const engine::history_map history = load_history(test_suite, last_run);
+
+    // Test programs modified since the last run get priority as they are the
+    // most likely to have been affected by the changes being tested.
+    std::set< fs::path > changed;
+    if (last_run) {
+        for (std::vector< engine::scan_result >::const_iterator
+                 iter = candidates.begin(); iter != candidates.end(); ++iter) {
+            const model::test_program& program = *(*iter).first;
+            if (changed.find(program.relative_path()) != changed.end())
+                continue;
+            try {
+                if (fs::modification_time(program.absolute_path()) >=
+                    last_run.get())
+                    changed.insert(program.relative_path());
+            } catch (const fs::error& e) {
+                changed.insert(program.relative_path());
+            }
+        }
+    }
+
+    return engine::select_within_budget(candidates, history, changed, budget,
+                                        slots);
+}
+
+
 /// Puts a test program in the store and returns its identifier.
 ///
 /// This function is idempotent: we maintain a side cache of already-put test
@@ -111,21 +1263,62 @@ find_test_program_id(const model::test_program_ptr test_program,
 }
 
 
-/// Stores the result of an execution in the database.
+/// Records that a test case does not run.
+///
+/// \param match Test program and test case to skip.
+/// \param reason Why the test case does not run.
+/// \param [in,out] tx Writable transaction to put the test results.
+/// \param [in,out] ids_cache Cache of already-put test cases.
+/// \param hooks The hooks for this execution.
+static void
+put_skipped(const engine::scan_result& match,
+            const std::string& reason,
+            store::write_transaction& tx,
+            path_to_id_map& ids_cache,
+            drivers::run_tests::base_hooks& hooks)
+{
+    const model::test_program_ptr test_program = match.first;
+    const std::string& test_case_name = match.second;
+
+    hooks.got_test_case(*test_program, test_case_name);
+
+    const int64_t test_case_id = tx.put_test_case(
+        *test_program, test_case_name,
+        find_test_program_id(test_program, tx, ids_cache));
+    const model::test_result result(model::test_result_skipped, reason);
+    const datetime::timestamp now = datetime::timestamp::now();
+    tx.put_result(result, test_case_id, now, now);
+
+    hooks.got_result(*test_program, test_case_name, result, datetime::delta());
+}
+
+
+/// Stores the outputs and the resource usage of an execution in the database.
+///
+/// The result itself is not stored so that the caller can hold it back.  The
+/// outputs must be stored first because the failure signature computed when
+/// storing the result depends on the contents of stderr.
 ///
 /// \param test_case_id Identifier of the test case in the database.
 /// \param result The result of the execution.
 /// \param [in,out] tx Writable transaction where to store the result data.
 static void
-put_test_result(const int64_t test_case_id,
-                const scheduler::test_result_handle& result,
-                store::write_transaction& tx)
+put_test_outputs(const int64_t test_case_id,
+                 const scheduler::test_result_handle& result,
+                 store::write_transaction& tx)
 {
-    tx.put_result(result.test_result(), test_case_id,
-                  result.start_time(), result.end_time());
     tx.put_test_case_file("__STDOUT__", result.stdout_file(), test_case_id);
     tx.put_test_case_file("__STDERR__", result.stderr_file(), test_case_id);
+    for (std::map< std::string, fs::path >::const_iterator
+             iter = result.wrapper_files().begin();
+         iter != result.wrapper_files().end(); ++iter) {
+        tx.put_test_case_file((*iter).first, (*iter).second, test_case_id);
+    }
 
+    const optional< datetime::delta > cpu_time = result.cpu_time();
+    const optional< units::bytes > max_rss = result.max_rss();
+    if (cpu_time && max_rss)
+        tx.put_resource_usage(test_case_id, cpu_time.get(), max_rss.get());
 }
 
 
@@ -158,6 +1351,8 @@ safe_cleanup(scheduler::test_result_handle handle) throw()
 /// \param [in,out] ids_cache Cache of already-put test cases.
 /// \param user_config The end-user configuration properties.
 /// \param hooks The hooks for this execution.
+/// \param [in,out] status Publisher of the live status of the run.
+/// \param [in,out] contention Balancer of the resources of running tests.
 ///
 /// \returns The PID for the started test and the test case's identifier in the
 /// store.
@@ -167,7 +1362,9 @@ start_test(scheduler::scheduler_handle& handle,
            store::write_transaction& tx,
            path_to_id_map& ids_cache,
            const config::tree& user_config,
-           drivers::run_tests::base_hooks& hooks)
+           drivers::run_tests::base_hooks& hooks,
+           run_status::publisher& status,
+           contention_tracker& contention)
 {
     const model::test_program_ptr test_program = match.first;
     const std::string& test_case_name = match.second;
@@ -181,6 +1378,10 @@ start_test(scheduler::scheduler_handle& handle,
 
     const scheduler::exec_handle exec_handle = handle.spawn_test(
         test_program, test_case_name, user_config);
+    status.test_started(
+        exec_handle, test_program->relative_path().str(), test_case_name,
+        test_program->find(test_case_name).get_metadata().timeout());
+    contention.started(*test_program, test_case_name);
     return std::make_pair(exec_handle, test_case_id);
 }
 
@@ -191,26 +1392,301 @@ start_test(scheduler::scheduler_handle& handle,
 /// \param test_case_id Identifier of the test case as returned by start_test().
 /// \param [in,out] tx Writable transaction to put the test results.
 /// \param hooks The hooks for this execution.
+/// \param [in,out] status Publisher of the live status of the run.
+/// \param [in,out] fixtures Tracker of the test program fixtures.
+/// \param [in,out] dependencies Tracker of the test program dependencies.
+/// \param [in,out] contention Balancer of the resources of running tests.
+/// \param [in,out] interference Checker of the failures due to interference.
 ///
 /// \post result_handle is cleaned up.  The caller cannot clean it up again.
 void
 finish_test(scheduler::result_handle_ptr result_handle,
             const int64_t test_case_id,
             store::write_transaction& tx,
-            drivers::run_tests::base_hooks& hooks)
+            drivers::run_tests::base_hooks& hooks,
+            run_status::publisher& status,
+            fixture_tracker& fixtures,
+            dependency_tracker& dependencies,
+            contention_tracker& contention,
+            interference_checker& interference)
 {
     const scheduler::test_result_handle* test_result_handle =
         dynamic_cast< const scheduler::test_result_handle* >(
             result_handle.get());
 
-    put_test_result(test_case_id, *test_result_handle, tx);
+    put_test_outputs(test_case_id, *test_result_handle, tx);
+    const bool held = interference.finished(*test_result_handle,
+                                            test_case_id);
+    if (!held)
+        tx.put_result(test_result_handle->test_result(), test_case_id,
+                      test_result_handle->start_time(),
+                      test_result_handle->end_time());
 
     const model::test_result test_result = safe_cleanup(*test_result_handle);
-    hooks.got_result(
-        *test_result_handle->test_program(),
-        test_result_handle->test_case_name(),
-        test_result_handle->test_result(),
-        result_handle->end_time() - result_handle->start_time());
+    status.test_finished(result_handle->original_pid(), !test_result.good());
+    fixtures.release(test_result_handle->test_program());
+    dependencies.done(test_result_handle->test_program(), test_result.good());
+    contention.finished(*test_result_handle->test_program(),
+                        test_result_handle->test_case_name());
+    if (!held)
+        hooks.got_result(
+            *test_result_handle->test_program(),
+            test_result_handle->test_case_name(),
+            test_result_handle->test_result(),
+            result_handle->end_time() - result_handle->start_time());
+}
+
+
+/// Processes the completion of the setup command of a fixture.
+///
+/// \param [in,out] result_handle The completion handle of a subprocess.
+/// \param [in,out] fixtures Tracker of the test program fixtures.
+/// \param [in,out] ready_tests Queue of test cases ready to be dispatched.
+///
+/// \return True if result_handle belonged to a setup command, in which case
+/// the test cases of its test program are moved to the ready queue and
+/// result_handle is cleaned up; false otherwise.
+static bool
+finish_fixture(scheduler::result_handle_ptr result_handle,
+               fixture_tracker& fixtures,
+               std::deque< engine::scan_result >& ready_tests)
+{
+    const scheduler::fixture_result_handle* fixture_result_handle =
+        dynamic_cast< const scheduler::fixture_result_handle* >(
+            result_handle.get());
+    if (fixture_result_handle == NULL)
+        return false;
+
+    const std::vector< engine::scan_result > released = fixtures.set_up(
+        *fixture_result_handle);
+    ready_tests.insert(ready_tests.end(), released.begin(), released.end());
+    try {
+        result_handle->cleanup();
+    } catch (const std::exception& e) {
+        LW(F("Failed to clean up after the setup of %s: %s") %
+           fixture_result_handle->test_program()->relative_path() % e.what());
+    }
+    return true;
+}
+
+
+/// Re-runs on their own the test cases whose failures were held back.
+///
+/// The test cases that pass on their own are stored and reported with the
+/// result of this execution, and are recorded as suspected of suffering from
+/// interference in the interference table only.  The rest keep the result of
+/// their original execution.  In both cases, the
+/// outputs and the times of the original execution are the ones kept.
+///
+/// \param handle Scheduler handle.
+/// \param [in,out] interference Checker holding the failures to re-run.
+/// \param [in,out] tx Writable transaction to put the test results.
+/// \param user_config The end-user configuration properties.
+/// \param hooks The hooks for this execution.
+/// \param [in,out] status Publisher of the live status of the run.
+/// \param [in,out] fixtures Tracker of the test program fixtures.
+/// \param [in,out] saver Saver of the staged store.
+void
+recheck_failures(scheduler::scheduler_handle& handle,
+                 interference_checker& interference,
+                 store::write_transaction& tx,
+                 const config::tree& user_config,
+                 drivers::run_tests::base_hooks& hooks,
+                 run_status::publisher& status,
+                 fixture_tracker& fixtures,
+                 staged_store_saver& saver)
+{
+    while (!interference.empty()) {
+        const interference_checker::failure failure = interference.front();
+        const model::test_program_ptr test_program = failure.test_program;
+        const std::string& test_case_name = failure.test_case_name;
+
+        status.set_pending(0, interference.size() - 1);
+        if (!fixtures.acquire(engine::scan_result(test_program,
+                                                  test_case_name))) {
+            // Nothing else is running, so the next process to complete is the
+            // setup command of the fixture.
+            std::deque< engine::scan_result > released;
+            const bool set_up = finish_fixture(handle.wait_any(), fixtures,
+                                               released);
+            INV(set_up && released.size() == 1);
+        }
+        const scheduler::exec_handle exec_handle = handle.spawn_test(
+            test_program, test_case_name, user_config);
+        status.test_started(
+            exec_handle, test_program->relative_path().str(), test_case_name,
+            test_program->find(test_case_name).get_metadata().timeout());
+        scheduler::result_handle_ptr result_handle = handle.wait_any();
+        const scheduler::test_result_handle* test_result_handle =
+            dynamic_cast< const scheduler::test_result_handle* >(
+                result_handle.get());
+        const model::test_result solo_result = safe_cleanup(
+            *test_result_handle);
+        status.test_finished(result_handle->original_pid(),
+                             !solo_result.good());
+        fixtures.release(test_program);
+
+        model::test_result result = failure.result;
+        if (solo_result.good()) {
+            const std::vector< std::string > overlapping =
+                interference.overlapping(failure);
+            const std::string overlapping_text = overlapping.empty() ?
+                std::string("no other test cases") :
+                text::join(overlapping, ", ");
+            LI(F("%s:%s passed on its own; suspecting interference from %s") %
+               test_program->relative_path() % test_case_name %
+               overlapping_text);
+
+            tx.put_result(solo_result, failure.test_case_id,
+                          failure.start_time, failure.end_time);
+            tx.put_interference(failure.test_case_id, failure.result,
+                                overlapping);
+            result = solo_result;
+        } else {
+            tx.put_result(failure.result, failure.test_case_id,
+                          failure.start_time, failure.end_time);
+        }
+        interference.pop();
+
+        hooks.got_result(*test_program, test_case_name, result,
+                         failure.end_time - failure.start_time);
+        saver.maybe_save(tx);
+    }
+}
+
+
+/// Skips a test case if any of the prerequisites of its program did not pass.
+///
+/// \param match Test program and test case to check.
+/// \param [in,out] dependencies Tracker of the test program dependencies.
+/// \param [in,out] tx Writable transaction to put the test results.
+/// \param [in,out] ids_cache Cache of already-put test cases.
+/// \param hooks The hooks for this execution.
+///
+/// \return True if the test case was skipped; false if it has to run.
+static bool
+maybe_skip_test(const engine::scan_result& match,
+                dependency_tracker& dependencies,
+                store::write_transaction& tx,
+                path_to_id_map& ids_cache,
+                drivers::run_tests::base_hooks& hooks)
+{
+    const optional< fs::path > failed = dependencies.failed_prerequisite(
+        match.first);
+    if (!failed)
+        return false;
+    put_skipped(match, F(dependency_reason) % failed.get(), tx, ids_cache,
+                hooks);
+    // A skipped test case makes its program fail so that the test programs
+    // that depend on it are skipped as well.
+    dependencies.done(match.first, false);
+    return true;
+}
+
+
+/// Moves the test cases whose prerequisites have completed to the ready queue.
+///
+/// \param [in,out] dependencies Tracker of the test program dependencies.
+/// \param [in,out] fixtures Tracker of the test program fixtures.
+/// \param [in,out] ready_tests Queue of test cases ready to be dispatched.
+/// \param [in,out] tx Writable transaction to put the test results.
+/// \param [in,out] ids_cache Cache of already-put test cases.
+/// \param hooks The hooks for this execution.
+static void
+unblock_tests(dependency_tracker& dependencies,
+              fixture_tracker& fixtures,
+              std::deque< engine::scan_result >& ready_tests,
+              store::write_transaction& tx,
+              path_to_id_map& ids_cache,
+              drivers::run_tests::base_hooks& hooks)
+{
+    // Skipping test cases can complete further test programs, so keep going
+    // until no more test cases are released.
+    std::vector< engine::scan_result > released = dependencies.unblock();
+    while (!released.empty()) {
+        for (std::vector< engine::scan_result >::const_iterator
+                 iter = released.begin(); iter != released.end(); ++iter) {
+            if (!maybe_skip_test(*iter, dependencies, tx, ids_cache, hooks) &&
+                fixtures.acquire(*iter))
+                ready_tests.push_back(*iter);
+        }
+        released = dependencies.unblock();
+    }
+}
+
+
+/// Gets the next test case to dispatch.
+///
+/// The ready queue is first filled with test cases yielded by the scanner until
+/// it holds as many test cases as the contention tracker wants to choose from.
+/// Test cases yielded by the scanner are held back if their prerequisites have
+/// not completed yet and skipped if any of them did not pass.
+///
+/// \param [in,out] scanner The scanner of the test cases to run.
+/// \param [in,out] ready_tests Queue of test cases ready to be dispatched.
+/// \param [in,out] dependencies Tracker of the test program dependencies.
+/// \param [in,out] fixtures Tracker of the test program fixtures.
+/// \param contention Balancer of the resources of running tests.
+/// \param [in,out] tx Writable transaction to put the test results.
+/// \param [in,out] ids_cache Cache of already-put test cases.
+/// \param hooks The hooks for this execution.
+///
+/// \return The next test case, with its fixture acquired, or none if there are
+/// no more test cases that can be dispatched at this point.
+static optional< engine::scan_result >
+next_test(engine::scanner& scanner,
+          std::deque< engine::scan_result >& ready_tests,
+          dependency_tracker& dependencies,
+          fixture_tracker& fixtures,
+          const contention_tracker& contention,
+          store::write_transaction& tx,
+          path_to_id_map& ids_cache,
+          drivers::run_tests::base_hooks& hooks)
+{
+    std::size_t lookahead = contention.lookahead();
+    bool scan_done = false;
+    for (;;) {
+        if (scan_done || ready_tests.size() >= lookahead) {
+            const optional< std::size_t > index = contention.pick(ready_tests);
+            if (index) {
+                const engine::scan_result match = ready_tests[index.get()];
+                ready_tests.erase(ready_tests.begin() + index.get());
+                return utils::make_optional(match);
+            }
+            // Look further ahead for a test case that can run right away
+            // instead of leaving the slot idle.
+            if (scan_done || ready_tests.size() >= contention.max_lookahead())
+                return none;
+            lookahead = ready_tests.size() + 1;
+        }
+
+        const optional< engine::scan_result > match = scanner.yield();
+        if (!match) {
+            // The last test programs are complete once their test cases
+            // finish, so let their dependents run as soon as that happens.
+            fixtures.scan_done();
+            dependencies.scan_done();
+            unblock_tests(dependencies, fixtures, ready_tests, tx, ids_cache,
+                          hooks);
+            scan_done = true;
+            continue;
+        }
+        const model::test_program_ptr test_program = match.get().first;
+
+        fixtures.yielded(test_program);
+        dependencies.yielded(test_program);
+        if (!dependencies.ready(test_program)) {
+            dependencies.block(match.get());
+        } else if (!maybe_skip_test(match.get(), dependencies, tx, ids_cache,
+                                    hooks) &&
+                   fixtures.acquire(match.get())) {
+            ready_tests.push_back(match.get());
+        }
+        // The scanner may have moved past a test program that other test
+        // programs were waiting for.
+        unblock_tests(dependencies, fixtures, ready_tests, tx, ids_cache,
+                      hooks);
+    }
 }
 
 
@@ -240,105 +1716,287 @@ drivers::run_tests::base_hooks::~base_hooks(void)
 }
 
 
-/// Executes the operation.
+/// Executes the operation on an already-loaded Kyuafile.
 ///
-/// \param kyuafile_path The path to the Kyuafile to be loaded.
-/// \param build_root If not none, path to the built test programs.
+/// This allows running several subsets of the same test suite without
+/// reloading the Kyuafile nor relisting the test cases of its test programs.
+///
+/// \param handle The scheduler used to load the Kyuafile.  The caller is
+///     responsible for cleaning it up once done with it.
+/// \param kyuafile The loaded Kyuafile.
 /// \param store_path The path to the store to be used.
+/// \param staging_interval If not none, keep the store in memory and save it
+///     to store_path whenever this much time has passed since the last save.
 /// \param filters The test case filters as provided by the user.
+/// \param time_budget If not none, only run the test cases predicted to
+///     complete within this time and defer the rest.
 /// \param user_config The end-user configuration properties.
 /// \param hooks The hooks for this execution.
 ///
 /// \returns A structure with all results computed by this driver.
 drivers::run_tests::result
-drivers::run_tests::drive(const fs::path& kyuafile_path,
-                          const optional< fs::path > build_root,
+drivers::run_tests::drive(scheduler::scheduler_handle& handle,
+                          const engine::kyuafile& kyuafile,
                           const fs::path& store_path,
+                          const optional< datetime::delta >& staging_interval,
                           const std::set< engine::test_filter >& filters,
+                          const optional< datetime::delta >& time_budget,
                           const config::tree& user_config,
                           base_hooks& hooks)
 {
-    scheduler::scheduler_handle handle = scheduler::setup();
+    heap_stats::scoped_phase phase(heap_stats::phase_schedule);
 
-    const engine::kyuafile kyuafile = engine::kyuafile::load(
-        kyuafile_path, build_root, user_config, handle);
-    store::write_backend db = store::write_backend::open_rw(store_path);
+    const std::size_t slots = user_config.lookup< config::positive_int_node >(
+        "parallelism");
+    INV(slots >= 1);
+
+    model::test_programs_vector test_programs = kyuafile.test_programs();
+    std::set< engine::test_filter > scan_filters = filters;
+    std::vector< engine::scan_result > deferred_tests;
+    optional< std::set< engine::test_filter > > unused_filters;
+    if (time_budget) {
+        std::set< engine::test_filter > unused;
+        const engine::budget_selection selection = apply_time_budget(
+            test_programs, filters,
+            store::layout::test_suite_for_path(kyuafile.source_root()),
+            time_budget.get(), slots, unused);
+        // The selection already honors the filters, so the scanner below
+        // must not apply them again.
+        test_programs = selection.selected;
+        scan_filters.clear();
+        deferred_tests = selection.deferred;
+        unused_filters = unused;
+    }
+
+    store::write_backend db = staging_interval ?
+        store::write_backend::open_staged(store_path) :
+        store::write_backend::open_rw(store_path);
+    if (user_config.is_set("index_output") &&
+        user_config.lookup< config::bool_node >("index_output")) {
+        try {
+            db.create_output_index();
+        } catch (const store::error& e) {
+            // The index is an optional feature, so do not prevent the tests
+            // from running if SQLite does not support it.
+            LW(F("Not indexing the output of the test cases: %s") % e.what());
+        }
+    }
     store::write_transaction tx = db.start_write();
+    staged_store_saver saver(db, staging_interval);
 
     {
         const model::context context = scheduler::current_context();
         (void)tx.put_context(context);
     }
 
-    engine::scanner scanner(kyuafile.test_programs(), filters);
-
     path_to_id_map ids_cache;
+    for (std::vector< engine::scan_result >::const_iterator
+             iter = deferred_tests.begin(); iter != deferred_tests.end();
+         ++iter) {
+        put_skipped(*iter, deferred_reason, tx, ids_cache, hooks);
+    }
+
+    engine::scanner scanner(test_programs, scan_filters);
+    run_status::publisher status(store_path);
+    fixture_tracker fixtures(handle, user_config);
+    dependency_tracker dependencies(test_programs);
+    contention_tracker contention(
+        test_programs,
+        slots > 1 ? load_usage(store::layout::test_suite_for_path(
+                        kyuafile.source_root())) : engine::usage_map(),
+        slots, user_config);
+    interference_checker interference(slots, user_config);
+
     pid_to_id_map in_flight;
+    std::deque< engine::scan_result > ready_tests;
     std::vector< engine::scan_result > exclusive_tests;
 
-    const std::size_t slots = user_config.lookup< config::positive_int_node >(
-        "parallelism");
-    INV(slots >= 1);
-    do {
-        INV(in_flight.size() <= slots);
-
-        // Spawn as many jobs as needed to fill our execution slots.  We do this
-        // first with the assumption that the spawning is faster than any single
-        // job, so we want to keep as many jobs in the background as possible.
-        while (in_flight.size() < slots) {
-            optional< engine::scan_result > match = scanner.yield();
-            if (!match)
-                break;
-            const model::test_program_ptr test_program = match.get().first;
-            const std::string& test_case_name = match.get().second;
-
-            const model::test_case& test_case = test_program->find(
-                test_case_name);
-            if (test_case.get_metadata().is_exclusive()) {
-                // Exclusive tests get processed later, separately.
-                exclusive_tests.push_back(match.get());
-                continue;
-            }
+    jobserver_slots jobserver(user_config, slots);
+    try {
+        for (;;) {
+            do {
+                INV(in_flight.size() <= slots);
 
-            const pid_and_id_pair pid_id = start_test(
-                handle, match.get(), tx, ids_cache, user_config, hooks);
-            INV_MSG(in_flight.find(pid_id.first) == in_flight.end(),
-                    F("Spawned test has PID of still-tracked process %s") %
-                    pid_id.first);
-            in_flight.insert(pid_id);
-        }
+                // Spawn as many jobs as needed to fill our execution slots.  We
+                // do this first with the assumption that the spawning is faster
+                // than any single job, so we want to keep as many jobs in the
+                // background as possible.
+                bool starved = false;
+                while (in_flight.size() < slots) {
+                    optional< engine::scan_result > match = next_test(
+                        scanner, ready_tests, dependencies, fixtures,
+                        contention, tx, ids_cache, hooks);
+                    if (!match)
+                        break;
+                    const model::test_program_ptr test_program =
+                        match.get().first;
+                    const std::string& test_case_name = match.get().second;
+
+                    const model::test_case& test_case = test_program->find(
+                        test_case_name);
+                    if (test_case.get_metadata().is_exclusive()) {
+                        // Exclusive tests get processed later, separately.
+                        exclusive_tests.push_back(match.get());
+                        continue;
+                    }
+
+                    if (!jobserver.reserve(in_flight.size())) {
+                        // Dispatch this test case first once a token shows up.
+                        ready_tests.push_front(match.get());
+                        starved = true;
+                        break;
+                    }
+
+                    const pid_and_id_pair pid_id = start_test(
+                        handle, match.get(), tx, ids_cache, user_config, hooks,
+                        status, contention);
+                    INV_MSG(in_flight.find(pid_id.first) == in_flight.end(),
+                            F("Spawned test has PID of still-tracked process "
+                              "%s") % pid_id.first);
+                    in_flight.insert(pid_id);
+                }
+                jobserver.trim(in_flight.size());
+
+                // If there are any used slots, consume any at random and return
+                // the result.  We consume slots one at a time to give
+                // preference to the spawning of new tests as detailed above.
+                //
+                // If we ran out of jobserver tokens, other clients may return
+                // some before any of our tests completes, so keep polling the
+                // jobserver instead of blocking until then.
+                scheduler::result_handle_ptr result_handle;
+                if (!in_flight.empty() || fixtures.setting_up() > 0) {
+                    if (!starved) {
+                        result_handle = handle.wait_any();
+                    } else {
+                        // A token acquired here stays reserved for the test
+                        // case we could not spawn above.
+                        result_handle = handle.try_wait_any();
+                        if (!result_handle)
+                            (void)jobserver.reserve(in_flight.size(),
+                                                    jobserver_poll_interval);
+                    }
+                }
+                if (result_handle &&
+                    !finish_fixture(result_handle, fixtures, ready_tests)) {
+                    const pid_to_id_map::iterator iter = in_flight.find(
+                        result_handle->original_pid());
+                    INV_MSG(iter != in_flight.end(),
+                            F("Lost track of in-flight PID %s; tracking %s") %
+                            result_handle->original_pid() %
+                            format_pids(in_flight));
+                    const int64_t test_case_id = (*iter).second;
+                    in_flight.erase(iter);
 
-        // If there are any used slots, consume any at random and return the
-        // result.  We consume slots one at a time to give preference to the
-        // spawning of new tests as detailed above.
-        if (!in_flight.empty()) {
-            scheduler::result_handle_ptr result_handle = handle.wait_any();
+                    finish_test(result_handle, test_case_id, tx, hooks, status,
+                                fixtures, dependencies, contention,
+                                interference);
+                    unblock_tests(dependencies, fixtures, ready_tests, tx,
+                                  ids_cache, hooks);
+                    jobserver.trim(in_flight.size());
+                    saver.maybe_save(tx);
+                }
 
-            const pid_to_id_map::iterator iter = in_flight.find(
-                result_handle->original_pid());
-            INV_MSG(iter != in_flight.end(),
-                    F("Lost track of in-flight PID %s; tracking %s") %
-                    result_handle->original_pid() % format_pids(in_flight));
-            const int64_t test_case_id = (*iter).second;
-            in_flight.erase(iter);
+                status.set_pending(scanner.pending_test_programs(),
+                                   exclusive_tests.size() + ready_tests.size() +
+                                   fixtures.held() + dependencies.blocked());
+            } while (!in_flight.empty() || fixtures.setting_up() > 0 ||
+                     !ready_tests.empty() || !scanner.done());
+            fixtures.scan_done();
+            dependencies.scan_done();
+            unblock_tests(dependencies, fixtures, ready_tests, tx, ids_cache,
+                          hooks);
+            if (!ready_tests.empty() || fixtures.setting_up() > 0)
+                continue;
+            if (exclusive_tests.empty())
+                break;
 
-            finish_test(result_handle, test_case_id, tx, hooks);
+            // Run any exclusive tests that we spotted earlier sequentially.
+            // They may release test cases that depend on them, in which case
+            // we go back to running tests in parallel.
+            std::vector< engine::scan_result > batch;
+            batch.swap(exclusive_tests);
+            for (std::vector< engine::scan_result >::const_iterator
+                     iter = batch.begin(); iter != batch.end(); ++iter) {
+                status.set_pending(0, batch.end() - iter - 1 +
+                                   ready_tests.size() + fixtures.held() +
+                                   dependencies.blocked());
+                const pid_and_id_pair data = start_test(
+                    handle, *iter, tx, ids_cache, user_config, hooks, status,
+                    contention);
+                // The test cases released by earlier exclusive tests may have
+                // started setting up their fixtures in the meantime.
+                scheduler::result_handle_ptr result_handle = handle.wait_any();
+                while (finish_fixture(result_handle, fixtures, ready_tests))
+                    result_handle = handle.wait_any();
+                finish_test(result_handle, data.second, tx, hooks, status,
+                            fixtures, dependencies, contention, interference);
+                unblock_tests(dependencies, fixtures, ready_tests, tx,
+                              ids_cache, hooks);
+                saver.maybe_save(tx);
+            }
         }
-    } while (!in_flight.empty() || !scanner.done());
+        INV(dependencies.blocked() == 0);
 
-    // Run any exclusive tests that we spotted earlier sequentially.
-    for (std::vector< engine::scan_result >::const_iterator
-             iter = exclusive_tests.begin(); iter != exclusive_tests.end();
-             ++iter) {
-        const pid_and_id_pair data = start_test(
-            handle, *iter, tx, ids_cache, user_config, hooks);
-        scheduler::result_handle_ptr result_handle = handle.wait_any();
-        finish_test(result_handle, data.second, tx, hooks);
+        recheck_failures(handle, interference, tx, user_config, hooks, status,
+                         fixtures, saver);
+    } catch (const signals::interrupted_error& unused_error) {
+        // Keep the results of the tests that completed before the interrupt.
+        // This has to happen before the scheduler is torn down, which kills
+        // the tests in flight and deletes their work directories.
+        try {
+            interference.flush(tx);
+            tx.commit();
+            db.flush();
+        } catch (const store::error& e) {
+            LW(F("Failed to save partial results: %s") % e.what());
+        }
+        throw;
     }
 
     tx.commit();
+    db.flush();
+
+    return result(unused_filters ? unused_filters.get() :
+                  scanner.unused_filters());
+}
+
+
+/// Executes the operation.
+///
+/// \param kyuafile_path The path to the Kyuafile to be loaded.
+/// \param build_root If not none, path to the built test programs.
+/// \param store_path The path to the store to be used.
+/// \param staging_interval If not none, keep the store in memory and save it
+///     to store_path whenever this much time has passed since the last save.
+/// \param filters The test case filters as provided by the user.
+/// \param time_budget If not none, only run the test cases predicted to
+///     complete within this time and defer the rest.
+/// \param user_config The end-user configuration properties.
+/// \param hooks The hooks for this execution.
+///
+/// \returns A structure with all results computed by this driver.
+drivers::run_tests::result
+drivers::run_tests::drive(const fs::path& kyuafile_path,
+                          const optional< fs::path > build_root,
+                          const fs::path& store_path,
+                          const optional< datetime::delta >& staging_interval,
+                          const std::set< engine::test_filter >& filters,
+                          const optional< datetime::delta >& time_budget,
+                          const config::tree& user_config,
+                          base_hooks& hooks)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+    handle.reclaim_orphans();
+
+    const engine::kyuafile kyuafile = engine::kyuafile::load(
+        kyuafile_path, build_root, user_config, handle);
+
+    const result driver_result = drive(handle, kyuafile, store_path,
+                                       staging_interval, filters, time_budget,
+                                       user_config, hooks);
 
     handle.cleanup();
 
-    return result(scanner.unused_filters());
+    return driver_result;
 }
@@ -40,6 +40,8 @@
 #include <string>
 
 #include "engine/filters.hpp"
+#include "engine/kyuafile_fwd.hpp"
+#include "engine/scheduler_fwd.hpp"
 #include "model/test_program.hpp"
 #include "model/test_result_fwd.hpp"
 #include "utils/config/tree_fwd.hpp"
@@ -95,8 +97,17 @@ public:
 };
 
 
+result drive(engine::scheduler::scheduler_handle&, const engine::kyuafile&,
+             const utils::fs::path&,
+             const utils::optional< utils::datetime::delta >&,
+             const std::set< engine::test_filter >&,
+             const utils::optional< utils::datetime::delta >&,
+             const utils::config::tree&, base_hooks&);
 result drive(const utils::fs::path&, const utils::optional< utils::fs::path >,
-             const utils::fs::path&, const std::set< engine::test_filter >&,
+             const utils::fs::path&,
+             const utils::optional< utils::datetime::delta >&,
+             const std::set< engine::test_filter >&,
+             const utils::optional< utils::datetime::delta >&,
              const utils::config::tree&, base_hooks&);
 
 
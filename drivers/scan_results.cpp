@@ -35,8 +35,10 @@
 #include "store/read_backend.hpp"
 #include "store/read_transaction.hpp"
 #include "utils/defs.hpp"
+#include "utils/heap_stats.hpp"
 
 namespace fs = utils::fs;
+namespace heap_stats = utils::heap_stats;
 
 
 /// Pure abstract destructor.
@@ -71,9 +73,11 @@ drivers::scan_results::drive(const fs::path& store_path,
                              const std::set< engine::test_filter >& raw_filters,
                              base_hooks& hooks)
 {
+    heap_stats::scoped_phase phase(heap_stats::phase_report);
+
     engine::filters_state filters(raw_filters);
 
-    store::read_backend db = store::read_backend::open_ro(store_path);
+    store::read_backend db = store::read_backend::open_ro_immutable(store_path);
     store::read_transaction tx = db.start_read();
 
     hooks.begin();
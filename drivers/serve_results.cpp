@@ -0,0 +1,756 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "drivers/serve_results.hpp"
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+}
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/noncopyable.hpp"
+#include "utils/optional.ipp"
+#include "utils/sanity.hpp"
+#include "utils/signals/exceptions.hpp"
+#include "utils/signals/interrupts.hpp"
+#include "utils/text/exceptions.hpp"
+#include "utils/text/operations.ipp"
+
+namespace fs = utils::fs;
+namespace serve_results = drivers::serve_results;
+namespace signals = utils::signals;
+namespace text = utils::text;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Maximum size of the head of a request we are willing to process.
+static const std::size_t max_request_head_size = 16 * 1024;
+
+
+/// Amount of seconds to wait for a client to send or accept data.
+static const int io_timeout = 10;
+
+
+/// Milliseconds to wait for new connections before checking for interrupts.
+static const int poll_timeout_ms = 500;
+
+
+/// Size of the pieces in which to stream test case files.
+static const int64_t file_chunk_size = 1024 * 1024;
+
+
+/// Error raised when a request cannot be processed.
+class http_error : public std::runtime_error {
+    /// The HTTP status code to return to the client.
+    int _status;
+
+public:
+    /// Constructor.
+    ///
+    /// \param status_ The HTTP status code to return to the client.
+    /// \param message The reason for the error.
+    http_error(const int status_, const std::string& message) :
+        std::runtime_error(message), _status(status_)
+    {
+    }
+
+    /// Gets the HTTP status code to return to the client.
+    ///
+    /// \return A status code.
+    int
+    status(void) const
+    {
+        return _status;
+    }
+};
+
+
+/// RAII wrapper for a socket.
+class socket_holder : utils::noncopyable {
+    /// The file descriptor of the socket.
+    int _fd;
+
+public:
+    /// Constructor.
+    ///
+    /// \param fd_ The file descriptor to own.
+    explicit socket_holder(const int fd_) : _fd(fd_)
+    {
+    }
+
+    /// Destructor; closes the socket.
+    ~socket_holder(void)
+    {
+        ::close(_fd);
+    }
+
+    /// Gets the file descriptor of the socket.
+    ///
+    /// \return A file descriptor.
+    int
+    fd(void) const
+    {
+        return _fd;
+    }
+};
+
+
+/// Gets the reason phrase for an HTTP status code.
+///
+/// \param status The status code.
+///
+/// \return A textual representation of the status.
+static const char*
+status_text(const int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 416: return "Range Not Satisfiable";
+    case 500: return "Internal Server Error";
+    default: return "Unknown";
+    }
+}
+
+
+/// Decodes a percent-encoded URL component.
+///
+/// \param raw The string to decode.
+/// \param plus_is_space Whether to decode '+' as a space, as is done in query
+///     strings.
+///
+/// \return The decoded string.
+///
+/// \throw http_error If the input is malformed.
+static std::string
+url_decode(const std::string& raw, const bool plus_is_space)
+{
+    std::string decoded;
+    for (std::string::size_type i = 0; i < raw.length(); ++i) {
+        if (raw[i] == '%') {
+            if (i + 2 >= raw.length() ||
+                !std::isxdigit(static_cast< unsigned char >(raw[i + 1])) ||
+                !std::isxdigit(static_cast< unsigned char >(raw[i + 2])))
+                throw http_error(400, "Invalid percent-encoding in URL");
+            decoded.push_back(static_cast< char >(
+                std::strtol(raw.substr(i + 1, 2).c_str(), NULL, 16)));
+            i += 2;
+        } else if (raw[i] == '+' && plus_is_space) {
+            decoded.push_back(' ');
+        } else {
+            decoded.push_back(raw[i]);
+        }
+    }
+    return decoded;
+}
+
+
+/// Parses a query string.
+///
+/// \param raw The query string, without the leading question mark.
+///
+/// \return The decoded parameters.  Parameters without a value are given an
+/// empty value.
+///
+/// \throw http_error If the input is malformed.
+static serve_results::request::query_map
+parse_query(const std::string& raw)
+{
+    serve_results::request::query_map query;
+
+    std::string::size_type start = 0;
+    while (start < raw.length()) {
+        std::string::size_type end = raw.find('&', start);
+        if (end == std::string::npos)
+            end = raw.length();
+
+        const std::string param = raw.substr(start, end - start);
+        if (!param.empty()) {
+            const std::string::size_type equal = param.find('=');
+            if (equal == std::string::npos)
+                query[url_decode(param, true)] = "";
+            else
+                query[url_decode(param.substr(0, equal), true)] =
+                    url_decode(param.substr(equal + 1), true);
+        }
+
+        start = end + 1;
+    }
+
+    return query;
+}
+
+
+/// Representation of the interesting bits of the head of a request.
+struct request_head {
+    /// The request method.
+    std::string method;
+
+    /// The request target, still encoded.
+    std::string target;
+
+    /// The value of the Range header, if any.
+    optional< std::string > range;
+};
+
+
+/// Parses the head of a request.
+///
+/// \param raw The request line and headers, without the final empty line.
+///
+/// \return The parsed request head.
+///
+/// \throw http_error If the request is malformed.
+static request_head
+parse_request_head(const std::string& raw)
+{
+    request_head head;
+
+    std::string::size_type line_start = 0;
+    bool first = true;
+    while (line_start < raw.length()) {
+        std::string::size_type line_end = raw.find("\r\n", line_start);
+        if (line_end == std::string::npos)
+            line_end = raw.length();
+        const std::string line = raw.substr(line_start, line_end - line_start);
+        line_start = line_end + 2;
+
+        if (first) {
+            const std::string::size_type space1 = line.find(' ');
+            const std::string::size_type space2 = line.rfind(' ');
+            if (space1 == std::string::npos || space1 == space2 ||
+                line.compare(space2 + 1, 5, "HTTP/") != 0)
+                throw http_error(400, "Malformed request line");
+            head.method = line.substr(0, space1);
+            head.target = line.substr(space1 + 1, space2 - space1 - 1);
+            first = false;
+            continue;
+        }
+
+        const std::string::size_type colon = line.find(':');
+        if (colon == std::string::npos)
+            throw http_error(400, "Malformed header");
+        std::string name = line.substr(0, colon);
+        for (std::string::iterator iter = name.begin(); iter != name.end();
+             ++iter)
+            *iter = static_cast< char >(
+                std::tolower(static_cast< unsigned char >(*iter)));
+        if (name == "range") {
+            std::string::size_type value_start = colon + 1;
+            while (value_start < line.length() && line[value_start] == ' ')
+                ++value_start;
+            head.range = line.substr(value_start);
+        }
+    }
+    if (first)
+        throw http_error(400, "Empty request");
+
+    return head;
+}
+
+
+/// Parses a byte position of a Range header.
+///
+/// \param digits The position, which must only contain digits.
+///
+/// \return The position, or the largest representable position if it does
+/// not fit in an int64_t.  Saturating gives the same outcome as the real
+/// value would: such positions are past the end of any file.
+static int64_t
+parse_range_position(const std::string& digits)
+{
+    PRE(!digits.empty());
+    try {
+        return text::to_type< int64_t >(digits);
+    } catch (const text::value_error& e) {
+        return std::numeric_limits< int64_t >::max();
+    }
+}
+
+
+/// Parses the value of a Range header.
+///
+/// Only single byte ranges are supported.  Any other kind of range is ignored
+/// as allowed by the HTTP specification, which results in the whole file being
+/// returned.
+///
+/// \param raw The value of the Range header.
+/// \param size The size of the file being requested.
+///
+/// \return The first byte and the number of bytes to return, or none if the
+/// range cannot be handled and must be ignored.
+///
+/// \throw http_error If the range is syntactically valid but cannot be
+///     satisfied.
+static optional< std::pair< int64_t, int64_t > >
+parse_range(const std::string& raw, const int64_t size)
+{
+    if (raw.compare(0, 6, "bytes=") != 0)
+        return none;
+    const std::string spec = raw.substr(6);
+    const std::string::size_type dash = spec.find('-');
+    if (dash == std::string::npos ||
+        spec.find_first_not_of("0123456789-") != std::string::npos ||
+        spec.find('-', dash + 1) != std::string::npos)
+        return none;
+
+    const std::string first = spec.substr(0, dash);
+    const std::string last = spec.substr(dash + 1);
+    if (first.empty() && last.empty())
+        return none;
+
+    int64_t start, end;
+    if (first.empty()) {
+        const int64_t suffix = parse_range_position(last);
+        if (suffix == 0)
+            throw http_error(416, "Empty suffix range");
+        start = suffix > size ? 0 : size - suffix;
+        end = size - 1;
+    } else {
+        start = parse_range_position(first);
+        end = last.empty() ? size - 1 : parse_range_position(last);
+        if (!last.empty() && end < start)
+            return none;
+        if (start >= size)
+            throw http_error(416, F("Range starts past the end of the file "
+                                    "(%s bytes)") % size);
+        if (end >= size)
+            end = size - 1;
+    }
+
+    return utils::make_optional(std::make_pair(start, end - start + 1));
+}
+
+
+/// Writes data to a client.
+///
+/// \param fd The socket connected to the client.
+/// \param data The data to write.
+///
+/// \throw std::runtime_error If the write fails.
+static void
+send_all(const int fd, const std::string& data)
+{
+#if defined(MSG_NOSIGNAL)
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+
+    std::string::size_type sent = 0;
+    while (sent < data.length()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.length() - sent,
+                                 flags);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(F("Failed to send data to client: %s") %
+                                     std::strerror(errno));
+        }
+        sent += n;
+    }
+}
+
+
+/// Reads the head of a request from a client.
+///
+/// \param fd The socket connected to the client.
+///
+/// \return The request line and headers, without the terminating empty line.
+///
+/// \throw http_error If the request is too large or the client goes away.
+static std::string
+receive_head(const int fd)
+{
+    std::string data;
+    std::string::size_type end;
+    while ((end = data.find("\r\n\r\n")) == std::string::npos) {
+        if (data.length() > max_request_head_size)
+            throw http_error(400, "Request too large");
+
+        char buffer[4096];
+        const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw http_error(400, "Connection closed before the end of the "
+                             "request");
+        data.append(buffer, n);
+    }
+    return data.substr(0, end);
+}
+
+
+/// Formats the head of a response.
+///
+/// \param status The HTTP status code.
+/// \param content_type The MIME type of the body.
+/// \param content_length The size of the body.
+/// \param extra_headers Additional headers, each terminated by CRLF.
+///
+/// \return The formatted status line and headers, including the terminating
+/// empty line.
+static std::string
+response_head(const int status, const std::string& content_type,
+              const int64_t content_length, const std::string& extra_headers)
+{
+    return F("HTTP/1.1 %s %s\r\n"
+             "Content-Type: %s\r\n"
+             "Content-Length: %s\r\n"
+             "%s"
+             "Connection: close\r\n"
+             "\r\n") % status % status_text(status) % content_type %
+        content_length % extra_headers;
+}
+
+
+/// Sends a test case file to the client, honoring range requests.
+///
+/// \param fd The socket connected to the client.
+/// \param tx The transaction to read the file from.
+/// \param resp The response describing the file to send.
+/// \param range The value of the Range header of the request, if any.
+/// \param send_body Whether to send the body or only the head.
+///
+/// \throw http_error If the file does not exist or the range is invalid.
+static void
+send_file(const int fd, store::read_transaction& tx,
+          const serve_results::response& resp,
+          const optional< std::string >& range, const bool send_body)
+{
+    PRE(resp.test_case_file);
+    const int64_t test_case_id = resp.test_case_file.get().first;
+    const std::string& name = resp.test_case_file.get().second;
+
+    const optional< int64_t > size = tx.get_test_case_file_size(
+        test_case_id, name);
+    if (!size)
+        throw http_error(404, F("Test case %s has no file %s") %
+                         test_case_id % name);
+
+    int status = resp.status;
+    int64_t start = 0;
+    int64_t length = size.get();
+    std::string extra_headers = "Accept-Ranges: bytes\r\n";
+    if (range) {
+        try {
+            const optional< std::pair< int64_t, int64_t > > bytes =
+                parse_range(range.get(), size.get());
+            if (bytes) {
+                status = 206;
+                start = bytes.get().first;
+                length = bytes.get().second;
+                extra_headers += F("Content-Range: bytes %s-%s/%s\r\n") %
+                    start % (start + length - 1) % size.get();
+            }
+        } catch (const http_error& e) {
+            const std::string body = F("%s\n") % e.what();
+            send_all(fd, response_head(
+                e.status(), "text/plain",
+                body.length(), F("Content-Range: bytes */%s\r\n") %
+                size.get()) + (send_body ? body : ""));
+            return;
+        }
+    }
+
+    send_all(fd, response_head(status, resp.content_type, length,
+                               extra_headers));
+    if (!send_body)
+        return;
+
+    const int64_t end = start + length;
+    for (int64_t offset = start; offset < end; offset += file_chunk_size) {
+        const int64_t chunk_length = std::min(file_chunk_size, end - offset);
+        const std::string chunk = tx.get_test_case_file_chunk(
+            test_case_id, name, offset, chunk_length);
+        if (chunk.empty())
+            throw std::runtime_error(F("File %s of test case %s shrank while "
+                                       "being read") % name % test_case_id);
+        send_all(fd, chunk);
+    }
+}
+
+
+/// Processes a single connection.
+///
+/// Connections handle a single request each: we do not support keep-alive.
+///
+/// \param fd The socket connected to the client.
+/// \param backend The results file to serve.
+/// \param hooks The hooks to render the responses.
+static void
+handle_connection(const int fd, store::read_backend& backend,
+                  serve_results::base_hooks& hooks)
+{
+    bool send_body = true;
+    try {
+        const request_head head = parse_request_head(receive_head(fd));
+        if (head.method == "HEAD")
+            send_body = false;
+        else if (head.method != "GET")
+            throw http_error(405, F("Unsupported method %s") % head.method);
+
+        const std::string::size_type question = head.target.find('?');
+        const std::string path = url_decode(head.target.substr(0, question),
+                                            false);
+        if (path.empty() || path[0] != '/')
+            throw http_error(400, "Invalid request target");
+        const serve_results::request req(
+            path, question == std::string::npos ?
+            serve_results::request::query_map() :
+            parse_query(head.target.substr(question + 1)));
+
+        store::read_transaction tx = backend.start_read();
+        const serve_results::response resp = hooks.got_request(tx, req);
+        LI(F("%s %s: %s") % head.method % head.target % resp.status);
+        if (resp.test_case_file) {
+            send_file(fd, tx, resp, head.range, send_body);
+        } else {
+            send_all(fd, response_head(resp.status, resp.content_type,
+                                       resp.body.length(), "") +
+                     (send_body ? resp.body : ""));
+        }
+        tx.finish();
+    } catch (const http_error& e) {
+        LI(F("Request failed with status %s: %s") % e.status() % e.what());
+        const std::string body = F("%s\n") % e.what();
+        send_all(fd, response_head(e.status(), "text/plain", body.length(),
+                                   "") + (send_body ? body : ""));
+    } catch (const std::runtime_error& e) {
+        LW(F("Failed to process request: %s") % e.what());
+        const std::string body = F("%s\n") % e.what();
+        send_all(fd, response_head(500, "text/plain", body.length(), "") +
+                 (send_body ? body : ""));
+    }
+}
+
+
+/// Creates the listening socket.
+///
+/// \param address The IPv4 address to listen on.
+/// \param port The port to listen on; 0 to choose any available one.
+///
+/// \return The file descriptor of the listening socket and the port it was
+/// bound to.
+///
+/// \throw std::runtime_error If the socket cannot be set up.
+static std::pair< int, int >
+create_listener(const std::string& address, const int port)
+{
+    PRE(port >= 0 && port <= 65535);
+
+    struct ::sockaddr_in sin;
+    std::memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(static_cast< uint16_t >(port));
+    if (::inet_pton(AF_INET, address.c_str(), &sin.sin_addr) != 1)
+        throw std::runtime_error(F("Invalid IPv4 address '%s'") % address);
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1)
+        throw std::runtime_error(F("Failed to create socket: %s") %
+                                 std::strerror(errno));
+
+    const int on = 1;
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1)
+        LW(F("Failed to set SO_REUSEADDR: %s") % std::strerror(errno));
+
+    socklen_t length = sizeof(sin);
+    if (::bind(fd, reinterpret_cast< struct ::sockaddr* >(&sin),
+               sizeof(sin)) == -1 ||
+        ::listen(fd, 16) == -1 ||
+        ::getsockname(fd, reinterpret_cast< struct ::sockaddr* >(&sin),
+                      &length) == -1) {
+        const int original_errno = errno;
+        ::close(fd);
+        throw std::runtime_error(F("Failed to listen on %s:%s: %s") %
+                                 address % port %
+                                 std::strerror(original_errno));
+    }
+
+    return std::make_pair(fd, static_cast< int >(ntohs(sin.sin_port)));
+}
+
+
+
+/// Accepts and processes connections until interrupted.
+///
+/// \param listen_fd The listening socket.
+/// \param backend The results file to serve.
+/// \param hooks The hooks to render the responses.
+///
+/// \throw signals::interrupted_error If the server is asked to terminate.
+static void
+serve_forever(const int listen_fd, store::read_backend& backend,
+              serve_results::base_hooks& hooks)
+{
+    for (;;) {
+        signals::check_interrupt();
+
+        // The handlers installed by interrupts_handler use SA_RESTART, so we
+        // cannot rely on accept(2) returning EINTR.  Instead, wait for
+        // connections with a timeout so that we notice interrupts even if they
+        // arrive right before we start waiting.
+        struct ::pollfd pfd;
+        pfd.fd = listen_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        const int ready = ::poll(&pfd, 1, poll_timeout_ms);
+        if (ready == -1) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(F("poll failed: %s") %
+                                     std::strerror(errno));
+        } else if (ready == 0) {
+            continue;
+        }
+
+        const int fd = ::accept(listen_fd, NULL, NULL);
+        if (fd == -1) {
+            LW(F("Failed to accept connection: %s") % std::strerror(errno));
+            continue;
+        }
+        socket_holder client(fd);
+
+        struct ::timeval timeout;
+        timeout.tv_sec = io_timeout;
+        timeout.tv_usec = 0;
+        (void)::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                           sizeof(timeout));
+        (void)::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                           sizeof(timeout));
+#if defined(SO_NOSIGPIPE)
+        const int on = 1;
+        (void)::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+        try {
+            handle_connection(fd, backend, hooks);
+        } catch (const std::runtime_error& e) {
+            LW(F("Dropping connection: %s") % e.what());
+        }
+    }
+}
+
+
+}  // anonymous namespace
+
+
+/// Constructs a response that streams a test case file.
+///
+/// \param test_case_id The identifier of the test case owning the file.
+/// \param name The name of the file within the test case; for example,
+///     __STDOUT__ or __STDERR__.
+/// \param content_type The MIME type of the file.
+///
+/// \return A new response.
+serve_results::response
+serve_results::response::file(const int64_t test_case_id,
+                              const std::string& name,
+                              const std::string& content_type)
+{
+    response resp(200, content_type, "");
+    resp.test_case_file = std::make_pair(test_case_id, name);
+    return resp;
+}
+
+
+/// Pure abstract destructor.
+serve_results::base_hooks::~base_hooks(void)
+{
+}
+
+
+/// Callback executed once the server is ready to accept connections.
+///
+/// \param address The address the server is listening on.
+/// \param port The port the server is listening on.
+void
+serve_results::base_hooks::listening(const std::string& /* address */,
+                                     const int /* port */)
+{
+}
+
+
+/// Executes the operation.
+///
+/// The server processes one connection at a time and only returns when an
+/// interrupt signal is received.
+///
+/// \param store_path The path to the results file to serve.
+/// \param address The IPv4 address to listen on.
+/// \param port The port to listen on; 0 to choose any available one.
+/// \param hooks The hooks for this execution.
+///
+/// \throw signals::interrupted_error If the server is asked to terminate.
+/// \throw std::runtime_error If the server cannot be set up.
+void
+serve_results::drive(const fs::path& store_path, const std::string& address,
+                     const int port, base_hooks& hooks)
+{
+    store::read_backend backend = store::read_backend::open_ro(store_path);
+
+    signals::interrupts_handler interrupts;
+
+    const std::pair< int, int > listener = create_listener(address, port);
+    socket_holder listen_socket(listener.first);
+    hooks.listening(address, listener.second);
+
+    try {
+        serve_forever(listen_socket.fd(), backend, hooks);
+    } catch (const signals::interrupted_error& e) {
+        interrupts.unprogram();
+        throw;
+    }
+}
@@ -0,0 +1,139 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/// \file drivers/serve_results.hpp
+/// Driver to serve the contents of a results file over HTTP.
+///
+/// This driver module implements a minimal HTTP server that answers requests
+/// on demand by querying a results file.  The presentation of the data is left
+/// to the hooks; the driver takes care of the network protocol and of streaming
+/// the potentially-huge files attached to test cases.
+
+#if !defined(DRIVERS_SERVE_RESULTS_HPP)
+#define DRIVERS_SERVE_RESULTS_HPP
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "store/read_transaction_fwd.hpp"
+#include "utils/fs/path_fwd.hpp"
+#include "utils/optional.hpp"
+
+namespace drivers {
+namespace serve_results {
+
+
+/// Representation of an HTTP request.
+class request {
+public:
+    /// Collection of query parameters, already decoded.
+    typedef std::map< std::string, std::string > query_map;
+
+    /// The requested path, already decoded; always starts with a slash.
+    std::string path;
+
+    /// The parameters given in the query string, if any.
+    query_map query;
+
+    /// Initializer for the tuple's fields.
+    ///
+    /// \param path_ The requested path.
+    /// \param query_ The parameters given in the query string.
+    request(const std::string& path_, const query_map& query_) :
+        path(path_), query(query_)
+    {
+    }
+};
+
+
+/// Representation of the response to an HTTP request.
+class response {
+public:
+    /// The HTTP status code.
+    int status;
+
+    /// The MIME type of the body.
+    std::string content_type;
+
+    /// The body of the response, unless test_case_file is set.
+    std::string body;
+
+    /// File to be streamed as the body of the response, if any.
+    ///
+    /// This is a pair of a test case identifier and the name of one of its
+    /// files.  Files are served in pieces and honor range requests so that
+    /// they can be of any size.
+    utils::optional< std::pair< int64_t, std::string > > test_case_file;
+
+    /// Initializer for the tuple's fields for an in-memory response.
+    ///
+    /// \param status_ The HTTP status code.
+    /// \param content_type_ The MIME type of the body.
+    /// \param body_ The body of the response.
+    response(const int status_, const std::string& content_type_,
+             const std::string& body_) :
+        status(status_), content_type(content_type_), body(body_)
+    {
+    }
+
+    static response file(const int64_t, const std::string&,
+                         const std::string&);
+};
+
+
+/// Abstract definition of the hooks for this driver.
+class base_hooks {
+public:
+    virtual ~base_hooks(void) = 0;
+
+    virtual void listening(const std::string&, const int);
+
+    /// Callback executed for every request.
+    ///
+    /// \param tx Transaction to query the results file from.  The transaction
+    ///     is only valid for the duration of the request.
+    /// \param req The request to answer.
+    ///
+    /// \return The response to send to the client.
+    virtual response got_request(store::read_transaction& tx,
+                                 const request& req) = 0;
+};
+
+
+void drive(const utils::fs::path&, const std::string&, const int,
+           base_hooks&);
+
+
+}  // namespace serve_results
+}  // namespace drivers
+
+#endif  // !defined(DRIVERS_SERVE_RESULTS_HPP)
@@ -0,0 +1,356 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "drivers/serve_results.hpp"
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <signal.h>
+#include <unistd.h>
+}
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include <atf-c++.hpp>
+
+#include "model/context.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/read_transaction.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace serve_results = drivers::serve_results;
+
+
+namespace {
+
+
+/// Hooks that serve trivial pages for testing purposes.
+class test_hooks : public serve_results::base_hooks {
+public:
+    /// Records the port the server is listening on.
+    ///
+    /// \param port The port the server is listening on.
+    void
+    listening(const std::string& /* address */, const int port)
+    {
+        {
+            std::ofstream output("port.tmp");
+            output << port << '\n';
+        }
+        ATF_REQUIRE(::rename("port.tmp", "port") != -1);
+    }
+
+    /// Serves a request.
+    ///
+    /// \param tx The transaction to query the results file from.
+    /// \param req The request to answer.
+    ///
+    /// \return A greeting, the stdout of the first test case or an error.
+    serve_results::response
+    got_request(store::read_transaction& tx, const serve_results::request& req)
+    {
+        if (req.path == "/hello") {
+            const serve_results::request::query_map::const_iterator iter =
+                req.query.find("name");
+            return serve_results::response(
+                200, "text/plain", F("Hello, %s!") %
+                (iter == req.query.end() ? "stranger" : (*iter).second));
+        } else if (req.path == "/stdout") {
+            store::results_iterator iter = tx.get_results();
+            return serve_results::response::file(iter.test_case_id(),
+                                                 "__STDOUT__", "text/plain");
+        } else if (req.path == "/stderr") {
+            store::results_iterator iter = tx.get_results();
+            return serve_results::response::file(iter.test_case_id(),
+                                                 "__STDERR__", "text/plain");
+        } else {
+            return serve_results::response(404, "text/plain",
+                                           F("No page %s") % req.path);
+        }
+    }
+};
+
+
+/// Creates a results file with a single test case.
+///
+/// \param file The results file to create.
+/// \param stdout_contents The stdout of the test case.
+static void
+populate(const fs::path& file, const std::string& stdout_contents)
+{
+    store::write_backend backend = store::write_backend::open_rw(file);
+    store::write_transaction tx = backend.start_write();
+
+    tx.put_context(model::context(fs::path("/root"),
+                                  std::map< std::string, std::string >()));
+
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("prog"), fs::path("/root"), "suite")
+        .add_test_case("main")
+        .build();
+    const int64_t tp_id = tx.put_test_program(test_program);
+    const int64_t tc_id = tx.put_test_case(test_program, "main", tp_id);
+    atf::utils::create_file("out.txt", stdout_contents);
+    tx.put_test_case_file("__STDOUT__", fs::path("out.txt"), tc_id);
+    tx.put_result(model::test_result(model::test_result_passed), tc_id,
+                  datetime::timestamp::from_microseconds(1000000),
+                  datetime::timestamp::from_microseconds(2000000));
+
+    tx.commit();
+    backend.close();
+}
+
+
+/// Runs the server in a subprocess for the lifetime of the object.
+class server {
+    /// PID of the subprocess running the server.
+    pid_t _pid;
+
+    /// Port the server is listening on.
+    int _port;
+
+public:
+    /// Starts the server and waits until it is ready.
+    ///
+    /// \param results_file The results file to serve.
+    server(const fs::path& results_file) : _pid(::fork()), _port(-1)
+    {
+        ATF_REQUIRE(_pid != -1);
+        if (_pid == 0) {
+            try {
+                test_hooks hooks;
+                serve_results::drive(results_file, "127.0.0.1", 0, hooks);
+            } catch (...) {
+                // Expected when we terminate the server.
+            }
+            std::exit(EXIT_SUCCESS);
+        }
+
+        for (int i = 0; i < 1000 && _port == -1; ++i) {
+            std::ifstream input("port");
+            if (!(input >> _port)) {
+                _port = -1;
+                ::usleep(10000);
+            }
+        }
+        ATF_REQUIRE(_port != -1);
+    }
+
+    /// Terminates the server.
+    ~server(void)
+    {
+        ::kill(_pid, SIGTERM);
+        int status;
+        (void)::waitpid(_pid, &status, 0);
+    }
+
+    /// Sends a raw request to the server.
+    ///
+    /// \param raw_request The request to send, including the final empty line.
+    ///
+    /// \return The raw response sent by the server.
+    std::string
+    send(const std::string& raw_request) const
+    {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        ATF_REQUIRE(fd != -1);
+
+        struct ::sockaddr_in sin;
+        std::memset(&sin, 0, sizeof(sin));
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons(static_cast< uint16_t >(_port));
+        sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ATF_REQUIRE(::connect(fd, reinterpret_cast< struct ::sockaddr* >(&sin),
+                              sizeof(sin)) != -1);
+
+        ATF_REQUIRE(::write(fd, raw_request.c_str(), raw_request.length()) ==
+                    static_cast< ssize_t >(raw_request.length()));
+
+        std::string response;
+        char buffer[1024];
+        ssize_t n;
+        while ((n = ::read(fd, buffer, sizeof(buffer))) > 0)
+            response.append(buffer, n);
+        ::close(fd);
+        return response;
+    }
+
+    /// Sends a GET request to the server.
+    ///
+    /// \param target The target of the request.
+    /// \param extra_headers Additional headers, each terminated by CRLF.
+    ///
+    /// \return The raw response sent by the server.
+    std::string
+    get(const std::string& target, const std::string& extra_headers = "") const
+    {
+        return send(F("GET %s HTTP/1.1\r\nHost: localhost\r\n%s\r\n") %
+                    target % extra_headers);
+    }
+};
+
+
+/// Checks that a response has a specific status and body.
+///
+/// \param exp_status The expected status line, without the protocol version.
+/// \param exp_body The expected body.
+/// \param response The raw response to validate.
+static void
+check_response(const std::string& exp_status, const std::string& exp_body,
+               const std::string& response)
+{
+    std::cout << "Response: " << response << '\n';
+    ATF_REQUIRE_EQ("HTTP/1.1 " + exp_status + "\r\n",
+                   response.substr(0, response.find("\r\n") + 2));
+    const std::string::size_type body_start = response.find("\r\n\r\n");
+    ATF_REQUIRE(body_start != std::string::npos);
+    ATF_REQUIRE_EQ(exp_body, response.substr(body_start + 4));
+    ATF_REQUIRE(response.find(F("\r\nContent-Length: %s\r\n") %
+                              exp_body.length()) != std::string::npos);
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(pages);
+ATF_TEST_CASE_BODY(pages)
+{
+    populate(fs::path("test.db"), "");
+    const server srv(fs::path("test.db"));
+
+    check_response("200 OK", "Hello, stranger!", srv.get("/hello"));
+    check_response("200 OK", "Hello, a b&c!",
+                   srv.get("/hello?foo&name=a+b%26c"));
+    check_response("404 Not Found", "No page /a b", srv.get("/a%20b"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(files);
+ATF_TEST_CASE_BODY(files)
+{
+    populate(fs::path("test.db"), "0123456789");
+    const server srv(fs::path("test.db"));
+
+    check_response("200 OK", "0123456789", srv.get("/stdout"));
+    check_response("404 Not Found", "Test case 1 has no file __STDERR__\n",
+                   srv.get("/stderr"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(files__ranges);
+ATF_TEST_CASE_BODY(files__ranges)
+{
+    populate(fs::path("test.db"), "0123456789");
+    const server srv(fs::path("test.db"));
+
+    std::string response = srv.get("/stdout", "Range: bytes=2-4\r\n");
+    check_response("206 Partial Content", "234", response);
+    ATF_REQUIRE(response.find("\r\nContent-Range: bytes 2-4/10\r\n") !=
+                std::string::npos);
+
+    check_response("206 Partial Content", "789",
+                   srv.get("/stdout", "range: bytes=7-\r\n"));
+    check_response("206 Partial Content", "6789",
+                   srv.get("/stdout", "Range: bytes=-4\r\n"));
+    check_response("206 Partial Content", "89",
+                   srv.get("/stdout", "Range: bytes=8-100\r\n"));
+    check_response("200 OK", "0123456789",
+                   srv.get("/stdout", "Range: bytes=1-2,4-5\r\n"));
+
+    response = srv.get("/stdout", "Range: bytes=10-\r\n");
+    ATF_REQUIRE_MATCH("^HTTP/1.1 416 ", response);
+    ATF_REQUIRE(response.find("\r\nContent-Range: bytes */10\r\n") !=
+                std::string::npos);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(files__ranges__overflow);
+ATF_TEST_CASE_BODY(files__ranges__overflow)
+{
+    populate(fs::path("test.db"), "0123456789");
+    const server srv(fs::path("test.db"));
+
+    check_response("206 Partial Content", "89",
+                   srv.get("/stdout",
+                           "Range: bytes=8-99999999999999999999\r\n"));
+    check_response("206 Partial Content", "0123456789",
+                   srv.get("/stdout",
+                           "Range: bytes=-99999999999999999999\r\n"));
+    ATF_REQUIRE_MATCH("^HTTP/1.1 416 ", srv.get(
+        "/stdout", "Range: bytes=99999999999999999999-\r\n"));
+    ATF_REQUIRE_MATCH("^HTTP/1.1 416 ", srv.get(
+        "/stdout", "Range: bytes=18446744073709551617-\r\n"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(methods);
+ATF_TEST_CASE_BODY(methods)
+{
+    populate(fs::path("test.db"), "0123456789");
+    const server srv(fs::path("test.db"));
+
+    const std::string response = srv.send(
+        "HEAD /stdout HTTP/1.1\r\n\r\n");
+    ATF_REQUIRE_MATCH("^HTTP/1.1 200 OK\r\n", response);
+    ATF_REQUIRE(response.find("\r\nContent-Length: 10\r\n") !=
+                std::string::npos);
+    ATF_REQUIRE_MATCH("\r\n\r\n$", response);
+
+    check_response("405 Method Not Allowed", "Unsupported method POST\n",
+                   srv.send("POST /hello HTTP/1.1\r\n\r\n"));
+    check_response("400 Bad Request", "Malformed request line\n",
+                   srv.send("GET /hello\r\n\r\n"));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, pages);
+    ATF_ADD_TEST_CASE(tcs, files);
+    ATF_ADD_TEST_CASE(tcs, files__ranges);
+    ATF_ADD_TEST_CASE(tcs, files__ranges__overflow);
+    ATF_ADD_TEST_CASE(tcs, methods);
+}
@@ -0,0 +1,524 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "drivers/suggest_metadata.hpp"
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "model/test_case.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+#include "utils/sanity.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace suggest_metadata = drivers::suggest_metadata;
+namespace units = utils::units;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Minimum number of failures for a test case to be checked for interference.
+static const std::size_t min_interference_failures = 2;
+
+
+/// Maximum number of interfering test cases to report for every test case.
+static const std::size_t max_interference_reports = 5;
+
+
+/// Counters of the outcomes of the executions of a test case.
+struct outcome_counts {
+    /// Number of executions that passed.
+    std::size_t passes;
+
+    /// Number of executions that failed.
+    std::size_t failures;
+
+    /// Constructor.
+    outcome_counts(void) : passes(0), failures(0)
+    {
+    }
+
+    /// Accounts for an execution.
+    ///
+    /// \param good Whether the execution passed.
+    void
+    add(const bool good)
+    {
+        if (good)
+            ++passes;
+        else
+            ++failures;
+    }
+};
+
+
+/// Aggregated data of all the executions of a single test case.
+struct test_case_stats {
+    /// Metadata of the most recent execution of the test case.
+    optional< model::metadata > metadata;
+
+    /// Outcomes of all the executions of the test case.
+    outcome_counts outcomes;
+
+    /// Durations of the passing executions, in microseconds.
+    std::vector< int64_t > durations;
+
+    /// Peak memory usage across all executions, if recorded at all.
+    optional< units::bytes > max_rss;
+
+    /// Number of executions with a recorded memory usage.
+    std::size_t rss_samples;
+
+    /// Accumulated CPU time of the passing executions that recorded it.
+    int64_t cpu_usecs;
+
+    /// Accumulated wall time of the passing executions that recorded CPU time.
+    int64_t wall_usecs;
+
+    /// Number of passing executions with a recorded CPU time.
+    std::size_t cpu_samples;
+
+    /// Constructor.
+    test_case_stats(void) :
+        rss_samples(0), cpu_usecs(0), wall_usecs(0), cpu_samples(0)
+    {
+    }
+};
+
+
+/// Mapping of test case identifiers to their aggregated data.
+typedef std::map< std::string, test_case_stats > stats_map;
+
+
+/// Rounds a duration up to a number of seconds suitable for a timeout.
+///
+/// The coarser granularity of longer timeouts keeps the suggestions stable
+/// across analyses of slightly different sets of runs.
+///
+/// \param usecs The duration to round, in microseconds.
+///
+/// \return A number of seconds larger than or equal to the duration.
+static int64_t
+round_up_timeout(const int64_t usecs)
+{
+    const int64_t secs = std::max(static_cast< int64_t >(1),
+                                  (usecs + 999999) / 1000000);
+    const int64_t step = secs <= 10 ? 1 : secs <= 60 ? 5 : secs <= 600 ? 30 : 60;
+    return (secs + step - 1) / step * step;
+}
+
+
+/// Formats an amount of memory as accepted by the required_memory property.
+///
+/// \param value The amount of memory to format.
+///
+/// \return The amount in the largest unit that represents it exactly.
+static std::string
+format_memory(const units::bytes& value)
+{
+    const uint64_t count = value;
+    if (count == 0)
+        return "0";
+    else if (count % units::TB == 0)
+        return F("%sT") % (count / units::TB);
+    else if (count % units::GB == 0)
+        return F("%sG") % (count / units::GB);
+    else if (count % units::MB == 0)
+        return F("%sM") % (count / units::MB);
+    else if (count % units::KB == 0)
+        return F("%sK") % (count / units::KB);
+    else
+        return F("%s") % count;
+}
+
+
+/// Computes the 99th percentile of a collection of durations.
+///
+/// \pre The collection is not empty.
+///
+/// \param durations The durations to analyze.  Reordered on return.
+///
+/// \return The smallest duration not exceeded by 99% of the samples.
+static int64_t
+percentile_99(std::vector< int64_t >& durations)
+{
+    PRE(!durations.empty());
+    std::sort(durations.begin(), durations.end());
+    const std::size_t rank = (durations.size() * 99 + 99) / 100;
+    return durations[rank - 1];
+}
+
+
+/// Aggregates the executions of all runs by test case.
+///
+/// \param runs The runs to aggregate, sorted from the most recent.
+///
+/// \return The aggregated data of every test case.
+static stats_map
+aggregate(const std::vector< suggest_metadata::run >& runs)
+{
+    stats_map stats;
+    for (std::vector< suggest_metadata::run >::const_iterator
+             run = runs.begin(); run != runs.end(); ++run) {
+        for (suggest_metadata::run::const_iterator iter = (*run).begin();
+             iter != (*run).end(); ++iter) {
+            const suggest_metadata::execution& exec = *iter;
+            test_case_stats& data = stats[exec.test_case];
+
+            if (!data.metadata)
+                data.metadata = exec.metadata;
+            data.outcomes.add(exec.good);
+
+            if (exec.max_rss) {
+                if (!data.max_rss || data.max_rss.get() < exec.max_rss.get())
+                    data.max_rss = exec.max_rss;
+                ++data.rss_samples;
+            }
+
+            if (!exec.good)
+                continue;
+            const int64_t wall_usecs =
+                (exec.end_time - exec.start_time).to_microseconds();
+            data.durations.push_back(wall_usecs);
+            if (exec.cpu_time && wall_usecs > 0) {
+                data.cpu_usecs += exec.cpu_time.get().to_microseconds();
+                data.wall_usecs += wall_usecs;
+                ++data.cpu_samples;
+            }
+        }
+    }
+    return stats;
+}
+
+
+/// Checks whether failures correlate with the presence of a condition.
+///
+/// \param with Outcomes of the executions in which the condition held.
+/// \param total Outcomes of all executions.
+///
+/// \return A positive failure rate under the condition if failures are at
+/// least twice as likely under it and happen in at least half of the
+/// executions that meet it; 0 otherwise.
+static double
+correlation(const outcome_counts& with, const outcome_counts& total)
+{
+    const std::size_t with_count = with.passes + with.failures;
+    const std::size_t without_count =
+        total.passes + total.failures - with_count;
+    if (with.failures < min_interference_failures || without_count == 0)
+        return 0;
+
+    const double rate_with = static_cast< double >(with.failures) / with_count;
+    const double rate_without =
+        static_cast< double >(total.failures - with.failures) / without_count;
+    if (rate_with >= 0.5 && rate_with >= 2 * rate_without)
+        return rate_with;
+    else
+        return 0;
+}
+
+
+/// Looks for test cases whose failures correlate with other test cases.
+///
+/// \param runs The runs to analyze.
+/// \param stats The aggregated data of every test case.
+/// \param [in,out] suggestions The collection to which to add the findings.
+static void
+find_interference(const std::vector< suggest_metadata::run >& runs,
+                  const stats_map& stats,
+                  suggest_metadata::suggestions_vector& suggestions)
+{
+    for (stats_map::const_iterator iter = stats.begin(); iter != stats.end();
+         ++iter) {
+        const std::string& test_case = (*iter).first;
+        const test_case_stats& data = (*iter).second;
+        // Test cases that always fail are broken, not victims of others.
+        if (data.outcomes.passes == 0 ||
+            data.outcomes.failures < min_interference_failures)
+            continue;
+
+        outcome_counts concurrent;
+        std::map< std::string, outcome_counts > overlapping;
+        for (std::vector< suggest_metadata::run >::const_iterator
+                 run = runs.begin(); run != runs.end(); ++run) {
+            for (suggest_metadata::run::const_iterator exec = (*run).begin();
+                 exec != (*run).end(); ++exec) {
+                if ((*exec).test_case != test_case)
+                    continue;
+
+                std::set< std::string > others;
+                for (suggest_metadata::run::const_iterator
+                         other = (*run).begin(); other != (*run).end();
+                     ++other) {
+                    if ((*other).test_case != test_case &&
+                        (*other).start_time < (*exec).end_time &&
+                        (*exec).start_time < (*other).end_time)
+                        others.insert((*other).test_case);
+                }
+
+                if (!others.empty())
+                    concurrent.add((*exec).good);
+                for (std::set< std::string >::const_iterator
+                         other = others.begin(); other != others.end();
+                     ++other)
+                    overlapping[*other].add((*exec).good);
+            }
+        }
+
+        if (correlation(concurrent, data.outcomes) > 0 &&
+            !data.metadata.get().is_exclusive())
+            suggestions.push_back(suggest_metadata::suggestion(
+                test_case, "is_exclusive", "true",
+                utils::make_optional(std::string("false"))));
+
+        std::vector< std::pair< double, std::string > > culprits;
+        for (std::map< std::string, outcome_counts >::const_iterator
+                 other = overlapping.begin(); other != overlapping.end();
+             ++other) {
+            const double rate = correlation((*other).second, data.outcomes);
+            if (rate > 0)
+                culprits.push_back(std::make_pair(-rate, (*other).first));
+        }
+        std::sort(culprits.begin(), culprits.end());
+        if (culprits.size() > max_interference_reports)
+            culprits.resize(max_interference_reports);
+        for (std::vector< std::pair< double, std::string > >::const_iterator
+                 culprit = culprits.begin(); culprit != culprits.end();
+             ++culprit)
+            suggestions.push_back(suggest_metadata::suggestion(
+                test_case, "interferes_with", (*culprit).second, none));
+    }
+}
+
+
+}  // anonymous namespace
+
+
+/// Constructor.
+///
+/// \param test_case_ Identifier of the test case, as test_program:test_case.
+/// \param good_ Whether the test case passed or not.
+/// \param start_time_ Time at which the test case started.
+/// \param end_time_ Time at which the test case finished.
+/// \param metadata_ The metadata the test case had in this execution.
+suggest_metadata::execution::execution(const std::string& test_case_,
+                                       const bool good_,
+                                       const datetime::timestamp& start_time_,
+                                       const datetime::timestamp& end_time_,
+                                       const model::metadata& metadata_) :
+    test_case(test_case_),
+    good(good_),
+    start_time(start_time_),
+    end_time(end_time_),
+    metadata(metadata_)
+{
+}
+
+
+/// Constructor with the default knobs.
+suggest_metadata::options::options(void) :
+    min_samples(3),
+    timeout_factor(3),
+    memory_headroom(25)
+{
+}
+
+
+/// Constructor.
+///
+/// \param test_case_ Identifier of the test case, as test_program:test_case.
+/// \param property_ Name of the property.
+/// \param value_ The suggested value.
+/// \param current_ The current value, or none if the property has no
+///     equivalent.
+suggest_metadata::suggestion::suggestion(
+    const std::string& test_case_, const std::string& property_,
+    const std::string& value_, const optional< std::string >& current_) :
+    test_case(test_case_),
+    property(property_),
+    value(value_),
+    current(current_)
+{
+}
+
+
+/// Equality comparator.
+///
+/// \param other The object to compare to.
+///
+/// \return True if the two objects are equal; false otherwise.
+bool
+suggest_metadata::suggestion::operator==(const suggestion& other) const
+{
+    return test_case == other.test_case && property == other.property &&
+        value == other.value && current == other.current;
+}
+
+
+/// Less-than comparator to sort suggestions in the order they are reported.
+///
+/// \param other The object to compare to.
+///
+/// \return True if this object sorts before the other one.
+bool
+suggest_metadata::suggestion::operator<(const suggestion& other) const
+{
+    if (test_case != other.test_case)
+        return test_case < other.test_case;
+    if (property != other.property)
+        return property < other.property;
+    return value < other.value;
+}
+
+
+/// Loads the executions recorded in a results file.
+///
+/// Skipped test cases are ignored as they carry no information about how the
+/// test cases behave.
+///
+/// \param file The results file to load.
+///
+/// \return The executions in the results file.
+///
+/// \throw store::error If the results file cannot be read.
+suggest_metadata::run
+suggest_metadata::load_run(const fs::path& file)
+{
+    run executions;
+
+    store::read_backend backend = store::read_backend::open_ro_immutable(file);
+    store::read_transaction tx = backend.start_read();
+    for (store::results_iterator iter = tx.get_results(); iter; ++iter) {
+        const model::test_result result = iter.result();
+        if (result.type() == model::test_result_skipped)
+            continue;
+
+        const model::test_program_ptr test_program = iter.test_program();
+        const std::string test_case_name = iter.test_case_name();
+        execution exec(
+            F("%s:%s") % test_program->relative_path() % test_case_name,
+            result.good(), iter.start_time(), iter.end_time(),
+            test_program->find(test_case_name).get_metadata());
+        exec.cpu_time = iter.cpu_time();
+        exec.max_rss = iter.max_rss();
+        executions.push_back(exec);
+    }
+    tx.finish();
+    backend.close();
+
+    return executions;
+}
+
+
+/// Derives metadata values from past executions.
+///
+/// \param runs The executions of the runs to analyze, sorted from the most
+///     recent to the oldest.  The current values of the properties are taken
+///     from the most recent execution of every test case.
+/// \param opts Knobs to tune the suggestions.
+///
+/// \return The suggestions, sorted by test case and property.
+suggest_metadata::suggestions_vector
+suggest_metadata::suggest(const std::vector< run >& runs, const options& opts)
+{
+    suggestions_vector suggestions;
+
+    stats_map stats = aggregate(runs);
+    for (stats_map::iterator iter = stats.begin(); iter != stats.end();
+         ++iter) {
+        const std::string& test_case = (*iter).first;
+        test_case_stats& data = (*iter).second;
+        const model::metadata& md = data.metadata.get();
+
+        if (data.durations.size() >= opts.min_samples) {
+            const int64_t timeout = round_up_timeout(
+                percentile_99(data.durations) * opts.timeout_factor);
+            suggestions.push_back(suggestion(
+                test_case, "timeout", F("%s") % timeout,
+                utils::make_optional(
+                    (F("%s") % md.timeout().seconds).str())));
+        }
+
+        if (data.rss_samples >= opts.min_samples) {
+            const uint64_t peak = data.max_rss.get();
+            const uint64_t wanted = peak + peak * opts.memory_headroom / 100;
+            const units::bytes memory(
+                (wanted + units::MB - 1) / units::MB * units::MB);
+            suggestions.push_back(suggestion(
+                test_case, "required_memory", format_memory(memory),
+                utils::make_optional(format_memory(md.required_memory()))));
+        }
+
+        if (data.cpu_samples >= opts.min_samples) {
+            // Round up unless the excess over a whole CPU is small enough to
+            // be accounted for by measurement noise.
+            const int64_t cpus = std::max(
+                static_cast< int64_t >(1),
+                (data.cpu_usecs + data.wall_usecs * 3 / 4) / data.wall_usecs);
+            suggestions.push_back(suggestion(
+                test_case, "required_cpus", F("%s") % cpus, none));
+        }
+    }
+
+    find_interference(runs, stats, suggestions);
+
+    std::sort(suggestions.begin(), suggestions.end());
+    return suggestions;
+}
+
+
+/// Formats a suggestion as a line of the report.
+///
+/// \param s The suggestion to format.
+///
+/// \return A textual representation of the suggestion, without a newline.
+std::string
+suggest_metadata::format(const suggestion& s)
+{
+    std::string line = F("%s: %s = %s") % s.test_case % s.property % s.value;
+    if (s.current && s.current.get() != s.value)
+        line += F(" (current: %s)") % s.current.get();
+    return line;
+}
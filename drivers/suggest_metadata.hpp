@@ -0,0 +1,141 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file drivers/suggest_metadata.hpp
+/// Mining of past executions to suggest test case metadata.
+///
+/// The scheduler relies on the metadata of the test cases (their timeout, the
+/// memory they need and whether they can run concurrently with others) to make
+/// good decisions, but such metadata is written by hand and tends to go stale.
+/// This module inspects the results files of recent runs and derives values
+/// for these properties from what the test cases actually did.
+
+#if !defined(DRIVERS_SUGGEST_METADATA_HPP)
+#define DRIVERS_SUGGEST_METADATA_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "model/metadata.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path_fwd.hpp"
+#include "utils/optional.hpp"
+#include "utils/units.hpp"
+
+namespace drivers {
+namespace suggest_metadata {
+
+
+/// Representation of one past execution of a test case.
+class execution {
+public:
+    /// Identifier of the test case, as test_program:test_case.
+    std::string test_case;
+
+    /// Whether the test case passed or not.
+    bool good;
+
+    /// Time at which the test case started.
+    utils::datetime::timestamp start_time;
+
+    /// Time at which the test case finished.
+    utils::datetime::timestamp end_time;
+
+    /// The CPU time consumed by the test case, if recorded.
+    utils::optional< utils::datetime::delta > cpu_time;
+
+    /// The peak resident memory of the test case, if recorded.
+    utils::optional< utils::units::bytes > max_rss;
+
+    /// The metadata the test case had in this execution.
+    model::metadata metadata;
+
+    execution(const std::string&, const bool,
+              const utils::datetime::timestamp&,
+              const utils::datetime::timestamp&,
+              const model::metadata&);
+};
+
+
+/// The executions recorded in a single results file.
+typedef std::vector< execution > run;
+
+
+/// Knobs to tune the suggestions.
+class options {
+public:
+    /// Minimum number of passing executions to suggest anything for a test.
+    std::size_t min_samples;
+
+    /// Multiplier to apply to the 99th percentile of the durations.
+    unsigned int timeout_factor;
+
+    /// Percentage of the peak memory usage to add as headroom.
+    unsigned int memory_headroom;
+
+    options(void);
+};
+
+
+/// A recommended value for one property of one test case.
+class suggestion {
+public:
+    /// Identifier of the test case, as test_program:test_case.
+    std::string test_case;
+
+    /// Name of the property.
+    std::string property;
+
+    /// The suggested value.
+    std::string value;
+
+    /// The current value, or none if the property has no equivalent.
+    utils::optional< std::string > current;
+
+    suggestion(const std::string&, const std::string&, const std::string&,
+               const utils::optional< std::string >&);
+
+    bool operator==(const suggestion&) const;
+    bool operator<(const suggestion&) const;
+};
+
+
+/// Collection of suggestions.
+typedef std::vector< suggestion > suggestions_vector;
+
+
+run load_run(const utils::fs::path&);
+suggestions_vector suggest(const std::vector< run >&, const options&);
+std::string format(const suggestion&);
+
+
+}  // namespace suggest_metadata
+}  // namespace drivers
+
+#endif  // !defined(DRIVERS_SUGGEST_METADATA_HPP)
@@ -0,0 +1,339 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "drivers/suggest_metadata.hpp"
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "model/context.hpp"
+#include "model/metadata.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
+#include "utils/units.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace logging = utils::logging;
+namespace suggest_metadata = drivers::suggest_metadata;
+namespace units = utils::units;
+
+using utils::none;
+
+
+namespace {
+
+
+/// Computes a timestamp relative to a fixed origin.
+///
+/// \param secs Number of seconds since the origin.
+///
+/// \return A timestamp.
+static datetime::timestamp
+at(const int secs)
+{
+    return datetime::timestamp::from_values(2026, 1, 1, 0, 0, 0, 0) +
+        datetime::delta(secs, 0);
+}
+
+
+/// Creates an execution with default metadata.
+///
+/// \param test_case Identifier of the test case.
+/// \param good Whether the execution passed.
+/// \param start Start time of the execution, in seconds since the origin.
+/// \param end End time of the execution, in seconds since the origin.
+///
+/// \return The new execution.
+static suggest_metadata::execution
+make_execution(const std::string& test_case, const bool good, const int start,
+               const int end)
+{
+    return suggest_metadata::execution(test_case, good, at(start), at(end),
+                                       model::metadata_builder().build());
+}
+
+
+/// Formats all suggestions as a report.
+///
+/// \param suggestions The suggestions to format.
+///
+/// \return The lines of the report, newline-terminated.
+static std::string
+report(const suggest_metadata::suggestions_vector& suggestions)
+{
+    std::string text;
+    for (suggest_metadata::suggestions_vector::const_iterator
+             iter = suggestions.begin(); iter != suggestions.end(); ++iter)
+        text += suggest_metadata::format(*iter) + "\n";
+    return text;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(suggest__no_runs);
+ATF_TEST_CASE_BODY(suggest__no_runs)
+{
+    ATF_REQUIRE(suggest_metadata::suggest(
+        std::vector< suggest_metadata::run >(),
+        suggest_metadata::options()).empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(suggest__not_enough_samples);
+ATF_TEST_CASE_BODY(suggest__not_enough_samples)
+{
+    std::vector< suggest_metadata::run > runs(2);
+    runs[0].push_back(make_execution("p:a", true, 0, 1));
+    runs[1].push_back(make_execution("p:a", true, 0, 1));
+
+    ATF_REQUIRE(suggest_metadata::suggest(
+        runs, suggest_metadata::options()).empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(suggest__timeout);
+ATF_TEST_CASE_BODY(suggest__timeout)
+{
+    std::vector< suggest_metadata::run > runs(4);
+    runs[0].push_back(make_execution("p:a", true, 0, 1));
+    runs[1].push_back(make_execution("p:a", true, 0, 2));
+    runs[2].push_back(make_execution("p:a", true, 0, 4));
+    runs[3].push_back(make_execution("p:a", false, 0, 100));
+
+    runs[0].push_back(suggest_metadata::execution(
+        "p:b", true, at(0), at(1),
+        model::metadata_builder().set_timeout(datetime::delta(3, 0)).build()));
+    runs[1].push_back(make_execution("p:b", true, 0, 1));
+    runs[2].push_back(make_execution("p:b", true, 0, 1));
+
+    ATF_REQUIRE_EQ("p:a: timeout = 15 (current: 300)\n"
+                   "p:b: timeout = 3\n",
+                   report(suggest_metadata::suggest(
+                       runs, suggest_metadata::options())));
+
+    suggest_metadata::options opts;
+    opts.timeout_factor = 100;
+    ATF_REQUIRE_EQ("p:a: timeout = 420 (current: 300)\n"
+                   "p:b: timeout = 120 (current: 3)\n",
+                   report(suggest_metadata::suggest(runs, opts)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(suggest__resource_usage);
+ATF_TEST_CASE_BODY(suggest__resource_usage)
+{
+    std::vector< suggest_metadata::run > runs(3);
+    for (int i = 0; i < 3; ++i) {
+        suggest_metadata::execution single = make_execution("p:single", true,
+                                                            0, 10);
+        single.cpu_time = datetime::delta(11, 0);
+        single.max_rss = units::bytes((10 + i) * units::MB);
+        runs[i].push_back(single);
+
+        suggest_metadata::execution multi = make_execution("p:multi", true,
+                                                           0, 10);
+        multi.cpu_time = datetime::delta(35, 0);
+        multi.max_rss = units::bytes(800 * units::MB + 1);
+        runs[i].push_back(multi);
+    }
+
+    suggest_metadata::options opts;
+    opts.min_samples = 3;
+    opts.timeout_factor = 1;
+    ATF_REQUIRE_EQ("p:multi: required_cpus = 4\n"
+                   "p:multi: required_memory = 1001M (current: 0)\n"
+                   "p:multi: timeout = 10 (current: 300)\n"
+                   "p:single: required_cpus = 1\n"
+                   "p:single: required_memory = 15M (current: 0)\n"
+                   "p:single: timeout = 10 (current: 300)\n",
+                   report(suggest_metadata::suggest(runs, opts)));
+
+    opts.memory_headroom = 0;
+    opts.min_samples = 4;
+    ATF_REQUIRE(suggest_metadata::suggest(runs, opts).empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(suggest__interference);
+ATF_TEST_CASE_BODY(suggest__interference)
+{
+    std::vector< suggest_metadata::run > runs(4);
+
+    // The victim fails whenever it overlaps with the culprit and passes
+    // otherwise.  The bystander overlaps with the victim in all runs.
+    runs[0].push_back(make_execution("p:victim", false, 0, 10));
+    runs[0].push_back(make_execution("p:culprit", true, 5, 15));
+    runs[1].push_back(make_execution("p:victim", false, 0, 10));
+    runs[1].push_back(make_execution("p:culprit", true, 2, 3));
+    runs[2].push_back(make_execution("p:victim", true, 0, 10));
+    runs[2].push_back(make_execution("p:culprit", true, 10, 20));
+    runs[3].push_back(make_execution("p:victim", true, 0, 10));
+    runs[3].push_back(make_execution("p:culprit", true, 20, 30));
+    for (int i = 0; i < 4; ++i)
+        runs[i].push_back(make_execution("p:bystander", true, 1, 2));
+
+    // Test cases that always fail are not reported.
+    for (int i = 0; i < 4; ++i)
+        runs[i].push_back(make_execution("p:broken", false, 0, 30));
+
+    suggest_metadata::options opts;
+    opts.min_samples = 100;
+    ATF_REQUIRE_EQ("p:victim: interferes_with = p:culprit\n",
+                   report(suggest_metadata::suggest(runs, opts)));
+
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(suggest__exclusive);
+ATF_TEST_CASE_BODY(suggest__exclusive)
+{
+    std::vector< suggest_metadata::run > runs(3);
+
+    // The victim fails whenever it runs concurrently with anything.
+    runs[0].push_back(make_execution("p:victim", false, 0, 10));
+    runs[0].push_back(make_execution("p:other", true, 5, 15));
+    runs[1].push_back(make_execution("p:victim", false, 0, 10));
+    runs[1].push_back(make_execution("p:other", true, 2, 3));
+    runs[2].push_back(make_execution("p:victim", true, 0, 10));
+
+    suggest_metadata::options opts;
+    opts.min_samples = 100;
+    ATF_REQUIRE_EQ("p:victim: interferes_with = p:other\n"
+                   "p:victim: is_exclusive = true (current: false)\n",
+                   report(suggest_metadata::suggest(runs, opts)));
+
+    // The current metadata comes from the most recent run.
+    runs[0][0] = suggest_metadata::execution(
+        "p:victim", false, at(0), at(10),
+        model::metadata_builder().set_is_exclusive(true).build());
+    ATF_REQUIRE_EQ("p:victim: interferes_with = p:other\n",
+                   report(suggest_metadata::suggest(runs, opts)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(format);
+ATF_TEST_CASE_BODY(format)
+{
+    ATF_REQUIRE_EQ("a:b: timeout = 5", suggest_metadata::format(
+        suggest_metadata::suggestion("a:b", "timeout", "5",
+                                     utils::make_optional(std::string("5")))));
+    ATF_REQUIRE_EQ("a:b: timeout = 5 (current: 10)", suggest_metadata::format(
+        suggest_metadata::suggestion("a:b", "timeout", "5",
+                                     utils::make_optional(std::string("10")))));
+    ATF_REQUIRE_EQ("a:b: required_cpus = 2", suggest_metadata::format(
+        suggest_metadata::suggestion("a:b", "required_cpus", "2", none)));
+}
+
+
+ATF_TEST_CASE(load_run);
+ATF_TEST_CASE_HEAD(load_run)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(load_run)
+{
+    {
+        store::write_backend backend = store::write_backend::open_rw(
+            fs::path("test.db"));
+        store::write_transaction tx = backend.start_write();
+        tx.put_context(model::context(fs::path("/root"),
+                                      std::map< std::string, std::string >()));
+
+        const model::test_program test_program = model::test_program_builder(
+            "plain", fs::path("dir/prog"), fs::path("/root"), "suite")
+            .add_test_case("first", model::metadata_builder()
+                           .set_timeout(datetime::delta(7, 0)).build())
+            .add_test_case("second").add_test_case("third").build();
+        const int64_t tp_id = tx.put_test_program(test_program);
+
+        const int64_t first_id = tx.put_test_case(test_program, "first", tp_id);
+        tx.put_result(model::test_result(model::test_result_passed),
+                      first_id, at(0), at(1));
+        tx.put_resource_usage(first_id, datetime::delta(1, 0),
+                              units::bytes(units::MB));
+
+        const int64_t second_id = tx.put_test_case(test_program, "second",
+                                                   tp_id);
+        tx.put_result(model::test_result(model::test_result_failed, "Oops"),
+                      second_id, at(1), at(3));
+
+        const int64_t third_id = tx.put_test_case(test_program, "third", tp_id);
+        tx.put_result(model::test_result(model::test_result_skipped, "No"),
+                      third_id, at(3), at(3));
+
+        tx.commit();
+        backend.close();
+    }
+
+    const suggest_metadata::run run = suggest_metadata::load_run(
+        fs::path("test.db"));
+    ATF_REQUIRE_EQ(2, run.size());
+
+    ATF_REQUIRE_EQ("dir/prog:first", run[0].test_case);
+    ATF_REQUIRE(run[0].good);
+    ATF_REQUIRE_EQ(at(0), run[0].start_time);
+    ATF_REQUIRE_EQ(at(1), run[0].end_time);
+    ATF_REQUIRE_EQ(datetime::delta(1, 0), run[0].cpu_time.get());
+    ATF_REQUIRE_EQ(units::bytes(units::MB), run[0].max_rss.get());
+    ATF_REQUIRE_EQ(datetime::delta(7, 0), run[0].metadata.timeout());
+
+    ATF_REQUIRE_EQ("dir/prog:second", run[1].test_case);
+    ATF_REQUIRE(!run[1].good);
+    ATF_REQUIRE(!run[1].cpu_time);
+    ATF_REQUIRE(!run[1].max_rss);
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, suggest__no_runs);
+    ATF_ADD_TEST_CASE(tcs, suggest__not_enough_samples);
+    ATF_ADD_TEST_CASE(tcs, suggest__timeout);
+    ATF_ADD_TEST_CASE(tcs, suggest__resource_usage);
+    ATF_ADD_TEST_CASE(tcs, suggest__interference);
+    ATF_ADD_TEST_CASE(tcs, suggest__exclusive);
+    ATF_ADD_TEST_CASE(tcs, format);
+    ATF_ADD_TEST_CASE(tcs, load_run);
+}
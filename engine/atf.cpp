@@ -174,11 +174,14 @@ engine::atf_interface::parse_list(const optional< process::status >& status,
 /// \param vars User-provided variables to pass to the test program.
 /// \param control_directory Directory where the interface may place control
 ///     files.
+/// \param wrapper Command with which to wrap the execution of the test
+///     program, or an empty vector to run it directly.
 void
 engine::atf_interface::exec_test(const model::test_program& test_program,
                                  const std::string& test_case_name,
                                  const config::properties_map& vars,
-                                 const fs::path& control_directory) const
+                                 const fs::path& control_directory,
+                                 const process::args_vector& wrapper) const
 {
     utils::setenv("__RUNNING_INSIDE_ATF_RUN", "internal-yes-value");
 
@@ -190,7 +193,7 @@ engine::atf_interface::exec_test(const model::test_program& test_program,
 
     args.push_back(F("-r%s") % (control_directory / result_name));
     args.push_back(test_case_name);
-    process::exec(test_program.absolute_path(), args);
+    process::exec(test_program.absolute_path(), args, wrapper);
 }
 
 
@@ -50,7 +50,8 @@ public:
 
     void exec_test(const model::test_program&, const std::string&,
                    const utils::config::properties_map&,
-                   const utils::fs::path&) const
+                   const utils::fs::path&,
+                   const utils::process::args_vector&) const
         UTILS_NORETURN;
 
     void exec_cleanup(const model::test_program&, const std::string&,
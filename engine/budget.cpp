@@ -0,0 +1,323 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "engine/budget.hpp"
+
+#include <algorithm>
+
+#include "model/metadata.hpp"
+#include "model/test_case.hpp"
+#include "model/test_program.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/optional.ipp"
+#include "utils/sanity.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Lower bound for the predicted duration of a test case, in microseconds.
+///
+/// Prevents test cases that ran in no measurable time from getting an infinite
+/// priority.
+static const int64_t min_cost = 1000;
+
+
+/// A test case that is a candidate for selection.
+struct candidate {
+    /// Position of the test case in the scanning order.
+    std::size_t index;
+
+    /// Whether the test case has to be prioritized regardless of its history
+    /// because it is new or its test program changed.
+    bool changed;
+
+    /// Predicted duration of the test case, in microseconds.
+    int64_t duration;
+
+    /// Predicted cost of the test case, in microseconds of a single slot.
+    int64_t cost;
+
+    /// Likelihood of the test case failing per microsecond of cost.
+    double score;
+
+    /// Orders candidates by their priority, highest first.
+    ///
+    /// \param other The candidate to compare to.
+    ///
+    /// \return True if this candidate has to be considered before other.
+    bool
+    operator<(const candidate& other) const
+    {
+        if (changed != other.changed)
+            return changed;
+        if (score != other.score)
+            return score > other.score;
+        return index < other.index;
+    }
+};
+
+
+/// Computes the default duration of test cases that have never run.
+///
+/// \param candidates The test cases to select from.
+/// \param history The past executions of test cases.
+///
+/// \return The mean of the durations of the test cases with history, in
+/// microseconds, or none if there are no such test cases.
+static optional< int64_t >
+default_duration(const std::vector< engine::scan_result >& candidates,
+                 const engine::history_map& history)
+{
+    int64_t total = 0;
+    std::size_t known = 0;
+    for (std::vector< engine::scan_result >::const_iterator
+             iter = candidates.begin(); iter != candidates.end(); ++iter) {
+        const engine::history_map::const_iterator entry = history.find(
+            engine::test_case_key((*iter).first->relative_path(),
+                                  (*iter).second));
+        if (entry != history.end() && (*entry).second.runs() > 0) {
+            total += (*entry).second.mean_duration().to_microseconds();
+            ++known;
+        }
+    }
+    if (known == 0)
+        return none;
+    return utils::make_optional(total / static_cast< int64_t >(known));
+}
+
+
+/// Restricts test programs to a subset of their test cases.
+///
+/// \param candidates The test cases to select from, in scanning order.
+/// \param selected Whether each candidate was selected.
+///
+/// \return The test programs with at least one selected test case, in scanning
+/// order, and with only their selected test cases.
+static model::test_programs_vector
+restrict_test_programs(const std::vector< engine::scan_result >& candidates,
+                       const std::vector< bool >& selected)
+{
+    model::test_programs_vector programs;
+    std::vector< model::test_cases_map > test_cases;
+    std::map< model::test_program_ptr, std::size_t > positions;
+
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        if (!selected[i])
+            continue;
+        const model::test_program_ptr program = candidates[i].first;
+        std::map< model::test_program_ptr, std::size_t >::const_iterator
+            position = positions.find(program);
+        if (position == positions.end()) {
+            position = positions.insert(std::make_pair(
+                program, programs.size())).first;
+            programs.push_back(program);
+            test_cases.push_back(model::test_cases_map());
+        }
+        test_cases[(*position).second].insert(
+            model::test_cases_map::value_type(
+                candidates[i].second, program->find(candidates[i].second)));
+    }
+
+    for (std::size_t i = 0; i < programs.size(); ++i) {
+        const model::test_program_ptr program = programs[i];
+        programs[i] = model::test_program_ptr(new model::test_program(
+            program->interface_name(), program->relative_path(),
+            program->root(), program->test_suite_name(),
+            program->get_metadata(), test_cases[i]));
+    }
+    return programs;
+}
+
+
+}  // anonymous namespace
+
+
+/// Constructs an empty history.
+engine::test_case_history::test_case_history(void) :
+    _runs(0),
+    _failures(0)
+{
+}
+
+
+/// Records a past execution of the test case.
+///
+/// \param good Whether the execution had a good result.
+/// \param duration The time the execution took.
+void
+engine::test_case_history::add(const bool good,
+                               const datetime::delta& duration)
+{
+    ++_runs;
+    if (!good)
+        ++_failures;
+    _total_duration += duration;
+}
+
+
+/// Returns the number of recorded executions.
+///
+/// \return A count of executions.
+std::size_t
+engine::test_case_history::runs(void) const
+{
+    return _runs;
+}
+
+
+/// Returns the number of recorded executions with a bad result.
+///
+/// \return A count of executions.
+std::size_t
+engine::test_case_history::failures(void) const
+{
+    return _failures;
+}
+
+
+/// Returns the mean duration of the recorded executions.
+///
+/// \pre There is at least one recorded execution.
+///
+/// \return A time delta.
+datetime::delta
+engine::test_case_history::mean_duration(void) const
+{
+    PRE(_runs > 0);
+    return datetime::delta::from_microseconds(
+        _total_duration.to_microseconds() / static_cast< int64_t >(_runs));
+}
+
+
+/// Selects the test cases that fit in a time budget.
+///
+/// The duration of a test case is predicted as the mean of its past durations,
+/// or as the mean of all known test cases if it has never run.  Test cases that
+/// have never run or that belong to changed test programs are considered first.
+/// The rest are considered in decreasing order of their likelihood to fail per
+/// second of execution, and each one is selected if it fits in what remains of
+/// the budget.
+///
+/// Non-exclusive test cases share the budget across all the execution slots,
+/// whereas exclusive test cases occupy all of them.
+///
+/// \param candidates The test cases to select from, in scanning order.
+/// \param history The past executions of test cases.
+/// \param changed Relative paths to the test programs that changed since they
+///     last ran.
+/// \param budget The maximum predicted wall time of the execution.
+/// \param parallelism The number of test cases that run concurrently.
+///
+/// \return The selected and deferred test cases.  If none of the candidates
+/// has any history, they are all selected as there is no basis to predict
+/// their durations.
+engine::budget_selection
+engine::select_within_budget(const std::vector< scan_result >& candidates,
+                             const history_map& history,
+                             const std::set< fs::path >& changed,
+                             const datetime::delta& budget,
+                             const std::size_t parallelism)
+{
+    PRE(parallelism >= 1);
+
+    budget_selection selection;
+
+    const optional< int64_t > unknown_duration = default_duration(
+        candidates, history);
+    if (!unknown_duration) {
+        LW("No past durations known for the selected test cases; ignoring the "
+           "time budget");
+        selection.selected = restrict_test_programs(
+            candidates, std::vector< bool >(candidates.size(), true));
+        return selection;
+    }
+
+    std::vector< candidate > ranking;
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        const model::test_program_ptr program = candidates[i].first;
+        const model::test_case& test_case = program->find(candidates[i].second);
+
+        candidate entry;
+        entry.index = i;
+        entry.changed = changed.find(program->relative_path()) != changed.end();
+
+        double failure_rate;
+        const history_map::const_iterator past = history.find(
+            test_case_key(program->relative_path(), candidates[i].second));
+        if (past == history.end() || (*past).second.runs() == 0) {
+            entry.changed = true;
+            entry.duration = unknown_duration.get();
+            failure_rate = 0.5;
+        } else {
+            const test_case_history& data = (*past).second;
+            entry.duration = data.mean_duration().to_microseconds();
+            // Smooth the rate so that test cases that never failed still get
+            // some chance, in inverse proportion to their cost.
+            failure_rate = (data.failures() + 1.0) / (data.runs() + 2.0);
+        }
+        entry.duration = std::max(entry.duration, min_cost);
+        entry.cost = entry.duration;
+        if (test_case.get_metadata().is_exclusive())
+            entry.cost *= static_cast< int64_t >(parallelism);
+        entry.score = failure_rate / entry.cost;
+
+        ranking.push_back(entry);
+    }
+    std::sort(ranking.begin(), ranking.end());
+
+    const int64_t capacity = budget.to_microseconds() *
+        static_cast< int64_t >(parallelism);
+    int64_t used = 0;
+    std::vector< bool > selected(candidates.size(), false);
+    for (std::vector< candidate >::const_iterator iter = ranking.begin();
+         iter != ranking.end(); ++iter) {
+        if (used + (*iter).cost <= capacity &&
+            (*iter).duration <= budget.to_microseconds()) {
+            used += (*iter).cost;
+            selected[(*iter).index] = true;
+        }
+    }
+    LI(F("Predicted %s us of work for %s slots within the time budget") %
+       used % parallelism);
+
+    selection.selected = restrict_test_programs(candidates, selected);
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        if (!selected[i])
+            selection.deferred.push_back(candidates[i]);
+    }
+    return selection;
+}
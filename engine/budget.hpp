@@ -0,0 +1,105 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file engine/budget.hpp
+/// Selection of the test cases that fit in a time budget.
+///
+/// The selection predicts the duration of every test case from its past runs
+/// and picks the test cases most likely to uncover a problem per second of
+/// execution until the budget is exhausted.  Test cases that are not selected
+/// are deferred: they do not run in this execution.
+
+#if !defined(ENGINE_BUDGET_HPP)
+#define ENGINE_BUDGET_HPP
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engine/scanner_fwd.hpp"
+#include "model/test_program_fwd.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path_fwd.hpp"
+
+namespace engine {
+
+
+/// Summary of the past executions of a test case.
+class test_case_history {
+    /// Number of recorded executions.
+    std::size_t _runs;
+
+    /// Number of recorded executions with a bad result.
+    std::size_t _failures;
+
+    /// Sum of the durations of all recorded executions.
+    utils::datetime::delta _total_duration;
+
+public:
+    test_case_history(void);
+
+    void add(const bool, const utils::datetime::delta&);
+
+    std::size_t runs(void) const;
+    std::size_t failures(void) const;
+    utils::datetime::delta mean_duration(void) const;
+};
+
+
+/// Identifier of a test case: the relative path to its test program and its
+/// name.
+typedef std::pair< utils::fs::path, std::string > test_case_key;
+
+
+/// Collection of the past executions of test cases.
+typedef std::map< test_case_key, test_case_history > history_map;
+
+
+/// Outcome of the selection of test cases within a time budget.
+struct budget_selection {
+    /// The test programs to run, restricted to their selected test cases.
+    model::test_programs_vector selected;
+
+    /// The test cases that do not fit in the budget, in scanning order.
+    std::vector< scan_result > deferred;
+};
+
+
+budget_selection select_within_budget(
+    const std::vector< scan_result >&, const history_map&,
+    const std::set< utils::fs::path >&, const utils::datetime::delta&,
+    const std::size_t);
+
+
+}  // namespace engine
+
+
+#endif  // !defined(ENGINE_BUDGET_HPP)
@@ -0,0 +1,374 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "engine/budget.hpp"
+
+#include <set>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "engine/filters.hpp"
+#include "engine/scanner.hpp"
+#include "model/metadata.hpp"
+#include "model/test_case.hpp"
+#include "model/test_program.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+
+
+namespace {
+
+
+/// Instantiates a test program with various test cases.
+///
+/// \param relative_path Relative path to the test program.
+/// \param names Names of the test cases to add to the test program.
+/// \param exclusive Whether the test cases are exclusive.
+///
+/// \return A constructed test program.
+static model::test_program_ptr
+new_test_program(const char* relative_path,
+                 const std::vector< std::string >& names,
+                 const bool exclusive = false)
+{
+    model::test_program_builder builder(
+        "plain", fs::path(relative_path), fs::path("/the/root"), "the-suite");
+    const model::metadata metadata = model::metadata_builder()
+        .set_is_exclusive(exclusive).build();
+    for (std::vector< std::string >::const_iterator iter = names.begin();
+         iter != names.end(); ++iter)
+        builder.add_test_case(*iter, metadata);
+    return builder.build_ptr();
+}
+
+
+/// Expands the test cases of some test programs in scanning order.
+///
+/// \param programs The test programs to expand.
+///
+/// \return The (test program, test case name) pairs.
+static std::vector< engine::scan_result >
+scan_all(const model::test_programs_vector& programs)
+{
+    std::vector< engine::scan_result > results;
+    engine::scanner scanner(programs, std::set< engine::test_filter >());
+    for (;;) {
+        const utils::optional< engine::scan_result > result = scanner.yield();
+        if (!result)
+            break;
+        results.push_back(result.get());
+    }
+    return results;
+}
+
+
+/// Adds a past execution of a test case to a history.
+///
+/// \param [in,out] history The history to extend.
+/// \param program Relative path to the test program.
+/// \param name Name of the test case.
+/// \param good Whether the execution had a good result.
+/// \param seconds Duration of the execution.
+static void
+add_run(engine::history_map& history, const char* program, const char* name,
+        const bool good, const int64_t seconds)
+{
+    history[engine::test_case_key(fs::path(program), name)].add(
+        good, datetime::delta(seconds, 0));
+}
+
+
+/// Flattens the test cases in a selection.
+///
+/// \param programs The selected test programs.
+///
+/// \return The selected test cases as program:case strings, in order.
+static std::vector< std::string >
+flatten(const model::test_programs_vector& programs)
+{
+    std::vector< std::string > names;
+    const std::vector< engine::scan_result > results = scan_all(programs);
+    for (std::vector< engine::scan_result >::const_iterator
+             iter = results.begin(); iter != results.end(); ++iter)
+        names.push_back((*iter).first->relative_path().str() + ":" +
+                        (*iter).second);
+    return names;
+}
+
+
+/// Flattens a list of scan results.
+///
+/// \param results The results to flatten.
+///
+/// \return The test cases as program:case strings, in order.
+static std::vector< std::string >
+flatten(const std::vector< engine::scan_result >& results)
+{
+    std::vector< std::string > names;
+    for (std::vector< engine::scan_result >::const_iterator
+             iter = results.begin(); iter != results.end(); ++iter)
+        names.push_back((*iter).first->relative_path().str() + ":" +
+                        (*iter).second);
+    return names;
+}
+
+
+/// Shorthand to build a vector of strings.
+///
+/// \param a First string.
+/// \param b Second string, if not empty.
+/// \param c Third string, if not empty.
+///
+/// \return A vector with the non-empty strings.
+static std::vector< std::string >
+strings(const char* a, const char* b = "", const char* c = "")
+{
+    std::vector< std::string > v;
+    v.push_back(a);
+    if (b[0] != '\0')
+        v.push_back(b);
+    if (c[0] != '\0')
+        v.push_back(c);
+    return v;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(test_case_history__empty);
+ATF_TEST_CASE_BODY(test_case_history__empty)
+{
+    const engine::test_case_history history;
+    ATF_REQUIRE_EQ(0, history.runs());
+    ATF_REQUIRE_EQ(0, history.failures());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(test_case_history__add);
+ATF_TEST_CASE_BODY(test_case_history__add)
+{
+    engine::test_case_history history;
+    history.add(true, datetime::delta(1, 0));
+    history.add(false, datetime::delta(2, 0));
+    history.add(true, datetime::delta(6, 0));
+    ATF_REQUIRE_EQ(3, history.runs());
+    ATF_REQUIRE_EQ(1, history.failures());
+    ATF_REQUIRE_EQ(datetime::delta(3, 0), history.mean_duration());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_within_budget__no_history);
+ATF_TEST_CASE_BODY(select_within_budget__no_history)
+{
+    model::test_programs_vector programs;
+    programs.push_back(new_test_program("a", strings("one", "two")));
+    programs.push_back(new_test_program("b", strings("three")));
+
+    const engine::budget_selection selection = engine::select_within_budget(
+        scan_all(programs), engine::history_map(), std::set< fs::path >(),
+        datetime::delta(1, 0), 1);
+    ATF_REQUIRE(strings("a:one", "a:two", "b:three") ==
+                flatten(selection.selected));
+    ATF_REQUIRE(selection.deferred.empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_within_budget__all_fit);
+ATF_TEST_CASE_BODY(select_within_budget__all_fit)
+{
+    model::test_programs_vector programs;
+    programs.push_back(new_test_program("a", strings("one", "two")));
+    programs.push_back(new_test_program("b", strings("three")));
+
+    engine::history_map history;
+    add_run(history, "a", "one", true, 3);
+    add_run(history, "a", "two", true, 3);
+    add_run(history, "b", "three", true, 4);
+
+    const engine::budget_selection selection = engine::select_within_budget(
+        scan_all(programs), history, std::set< fs::path >(),
+        datetime::delta(10, 0), 1);
+    ATF_REQUIRE(strings("a:one", "a:two", "b:three") ==
+                flatten(selection.selected));
+    ATF_REQUIRE(selection.deferred.empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_within_budget__prefer_failing);
+ATF_TEST_CASE_BODY(select_within_budget__prefer_failing)
+{
+    model::test_programs_vector programs;
+    programs.push_back(new_test_program("a", strings("one", "two", "three")));
+
+    engine::history_map history;
+    add_run(history, "a", "one", true, 5);
+    add_run(history, "a", "one", true, 5);
+    add_run(history, "a", "two", false, 5);
+    add_run(history, "a", "two", false, 5);
+    add_run(history, "a", "three", true, 5);
+    add_run(history, "a", "three", false, 5);
+
+    const engine::budget_selection selection = engine::select_within_budget(
+        scan_all(programs), history, std::set< fs::path >(),
+        datetime::delta(10, 0), 1);
+    ATF_REQUIRE(strings("a:three", "a:two") == flatten(selection.selected));
+    ATF_REQUIRE(strings("a:one") == flatten(selection.deferred));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_within_budget__prefer_cheap);
+ATF_TEST_CASE_BODY(select_within_budget__prefer_cheap)
+{
+    model::test_programs_vector programs;
+    programs.push_back(new_test_program("a", strings("one", "two", "three")));
+
+    engine::history_map history;
+    add_run(history, "a", "one", true, 8);
+    add_run(history, "a", "two", true, 1);
+    add_run(history, "a", "three", true, 2);
+
+    const engine::budget_selection selection = engine::select_within_budget(
+        scan_all(programs), history, std::set< fs::path >(),
+        datetime::delta(5, 0), 1);
+    ATF_REQUIRE(strings("a:three", "a:two") == flatten(selection.selected));
+    ATF_REQUIRE(strings("a:one") == flatten(selection.deferred));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_within_budget__prefer_changed);
+ATF_TEST_CASE_BODY(select_within_budget__prefer_changed)
+{
+    model::test_programs_vector programs;
+    programs.push_back(new_test_program("a", strings("one")));
+    programs.push_back(new_test_program("b", strings("two")));
+    programs.push_back(new_test_program("c", strings("three")));
+
+    engine::history_map history;
+    add_run(history, "a", "one", false, 4);
+    add_run(history, "b", "two", true, 4);
+
+    std::set< fs::path > changed;
+    changed.insert(fs::path("b"));
+
+    // c:three has no history so it is predicted to take 4 seconds, the mean of
+    // the known test cases, and is considered first along with b:two.
+    const engine::budget_selection selection = engine::select_within_budget(
+        scan_all(programs), history, changed, datetime::delta(9, 0), 1);
+    ATF_REQUIRE(strings("b:two", "c:three") == flatten(selection.selected));
+    ATF_REQUIRE(strings("a:one") == flatten(selection.deferred));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_within_budget__parallelism);
+ATF_TEST_CASE_BODY(select_within_budget__parallelism)
+{
+    model::test_programs_vector programs;
+    programs.push_back(new_test_program("a", strings("one", "two", "three")));
+    programs.push_back(new_test_program("b", strings("four")));
+
+    engine::history_map history;
+    add_run(history, "a", "one", true, 5);
+    add_run(history, "a", "two", true, 5);
+    add_run(history, "a", "three", true, 5);
+    add_run(history, "b", "four", true, 20);
+
+    const engine::budget_selection selection = engine::select_within_budget(
+        scan_all(programs), history, std::set< fs::path >(),
+        datetime::delta(10, 0), 2);
+    ATF_REQUIRE(strings("a:one", "a:three", "a:two") ==
+                flatten(selection.selected));
+    ATF_REQUIRE(strings("b:four") == flatten(selection.deferred));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_within_budget__exclusive);
+ATF_TEST_CASE_BODY(select_within_budget__exclusive)
+{
+    model::test_programs_vector programs;
+    programs.push_back(new_test_program("a", strings("one", "two")));
+    programs.push_back(new_test_program("b", strings("three"), true));
+
+    engine::history_map history;
+    add_run(history, "a", "one", true, 4);
+    add_run(history, "a", "two", true, 4);
+    add_run(history, "b", "three", true, 4);
+
+    // Two test cases of 4 seconds fit in a budget of 5 seconds with 2 slots,
+    // but not when one of them is exclusive as it occupies both slots.
+    const engine::budget_selection selection = engine::select_within_budget(
+        scan_all(programs), history, std::set< fs::path >(),
+        datetime::delta(5, 0), 2);
+    ATF_REQUIRE(strings("a:one", "a:two") == flatten(selection.selected));
+    ATF_REQUIRE(strings("b:three") == flatten(selection.deferred));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(select_within_budget__keeps_properties);
+ATF_TEST_CASE_BODY(select_within_budget__keeps_properties)
+{
+    model::test_programs_vector programs;
+    programs.push_back(new_test_program("dir/a", strings("one", "two")));
+
+    engine::history_map history;
+    add_run(history, "dir/a", "one", true, 4);
+    add_run(history, "dir/a", "two", true, 40);
+
+    const engine::budget_selection selection = engine::select_within_budget(
+        scan_all(programs), history, std::set< fs::path >(),
+        datetime::delta(5, 0), 1);
+    ATF_REQUIRE_EQ(1, selection.selected.size());
+    const model::test_program& program = *selection.selected[0];
+    ATF_REQUIRE_EQ("plain", program.interface_name());
+    ATF_REQUIRE_EQ(fs::path("/the/root"), program.root());
+    ATF_REQUIRE_EQ(fs::path("dir/a"), program.relative_path());
+    ATF_REQUIRE_EQ("the-suite", program.test_suite_name());
+    ATF_REQUIRE_EQ(1, program.test_cases().size());
+    ATF_REQUIRE_EQ(programs[0]->find("one"), program.find("one"));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, test_case_history__empty);
+    ATF_ADD_TEST_CASE(tcs, test_case_history__add);
+
+    ATF_ADD_TEST_CASE(tcs, select_within_budget__no_history);
+    ATF_ADD_TEST_CASE(tcs, select_within_budget__all_fit);
+    ATF_ADD_TEST_CASE(tcs, select_within_budget__prefer_failing);
+    ATF_ADD_TEST_CASE(tcs, select_within_budget__prefer_cheap);
+    ATF_ADD_TEST_CASE(tcs, select_within_budget__prefer_changed);
+    ATF_ADD_TEST_CASE(tcs, select_within_budget__parallelism);
+    ATF_ADD_TEST_CASE(tcs, select_within_budget__exclusive);
+    ATF_ADD_TEST_CASE(tcs, select_within_budget__keeps_properties);
+}
@@ -41,11 +41,13 @@
 #include "utils/passwd.hpp"
 #include "utils/text/exceptions.hpp"
 #include "utils/text/operations.ipp"
+#include "utils/units.hpp"
 
 namespace config = utils::config;
 namespace fs = utils::fs;
 namespace passwd = utils::passwd;
 namespace text = utils::text;
+namespace units = utils::units;
 
 
 namespace {
@@ -59,8 +61,20 @@ static void
 init_tree(config::tree& tree)
 {
     tree.define< config::string_node >("architecture");
+    tree.define_dynamic("execution_wrappers");
+    tree.define< config::bool_node >("index_output");
+    tree.define< engine::jobserver_node >("jobserver");
+    tree.define< config::positive_int_node >("max_cpu_tests");
+    tree.define< engine::bytes_node >("max_file_size");
+    tree.define< config::positive_int_node >("max_io_tests");
+    tree.define< config::positive_int_node >("max_memory_tests");
+    tree.define< config::positive_int_node >("max_open_files");
+    tree.define< config::positive_int_node >("max_processes");
+    tree.define< config::positive_int_node >("memory_limit_factor");
     tree.define< config::positive_int_node >("parallelism");
     tree.define< config::string_node >("platform");
+    tree.define< config::bool_node >("recheck_failures");
+    tree.define< config::bool_node >("resource_limits");
     tree.define< engine::user_node >("unprivileged_user");
     tree.define_dynamic("test_suites");
 }
@@ -208,6 +222,59 @@ engine::user_node::to_string(void) const
 }
 
 
+/// Copies the node.
+///
+/// \return A dynamically-allocated node.
+config::detail::base_node*
+engine::jobserver_node::deep_copy(void) const
+{
+    std::auto_ptr< jobserver_node > new_node(new jobserver_node());
+    new_node->_value = _value;
+    return new_node.release();
+}
+
+
+/// Checks a new value for the node.
+///
+/// \param new_value The value to check.
+///
+/// \throw value_error If the value is not a known jobserver mode.
+void
+engine::jobserver_node::validate(const value_type& new_value) const
+{
+    if (new_value != "auto" && new_value != "none" && new_value != "serve")
+        throw config::value_error("Must be one of auto, none or serve");
+}
+
+
+/// Copies the node.
+///
+/// \return A dynamically-allocated node.
+config::detail::base_node*
+engine::bytes_node::deep_copy(void) const
+{
+    std::auto_ptr< bytes_node > new_node(new bytes_node());
+    new_node->_value = _value;
+    return new_node.release();
+}
+
+
+/// Checks a new value for the node.
+///
+/// \param new_value The value to check.
+///
+/// \throw value_error If the value is not a valid amount of bytes.
+void
+engine::bytes_node::validate(const value_type& new_value) const
+{
+    try {
+        (void)units::bytes::parse(new_value);
+    } catch (const std::runtime_error& e) {
+        throw config::value_error(e.what());
+    }
+}
+
+
 /// Constructs a config with the built-in settings.
 ///
 /// \return A default test suite configuration.
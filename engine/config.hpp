@@ -55,6 +55,26 @@ public:
 };
 
 
+/// Tree node to hold the mode of interaction with a make jobserver.
+class jobserver_node : public utils::config::string_node {
+public:
+    virtual base_node* deep_copy(void) const;
+
+private:
+    virtual void validate(const value_type&) const;
+};
+
+
+/// Tree node to hold an amount of bytes, such as 10m.
+class bytes_node : public utils::config::string_node {
+public:
+    virtual base_node* deep_copy(void) const;
+
+private:
+    virtual void validate(const value_type&) const;
+};
+
+
 utils::config::tree default_config(void);
 utils::config::tree empty_config(void);
 utils::config::tree load_config(const utils::fs::path&);
@@ -78,6 +78,10 @@ validate_defaults(const config::tree& config)
         KYUA_ARCHITECTURE,
         config.lookup< config::string_node >("architecture"));
 
+    ATF_REQUIRE(!config.is_set("index_output"));
+
+    ATF_REQUIRE(!config.is_set("jobserver"));
+
     ATF_REQUIRE_EQ(
         1,
         config.lookup< config::positive_int_node >("parallelism"));
@@ -117,6 +121,81 @@ ATF_TEST_CASE_BODY(config__set__parallelism)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(config__set__resource_limits);
+ATF_TEST_CASE_BODY(config__set__resource_limits)
+{
+    config::tree user_config = engine::default_config();
+    ATF_REQUIRE(!user_config.is_set("resource_limits"));
+    user_config.set_string("resource_limits", "true");
+    ATF_REQUIRE(user_config.lookup< config::bool_node >("resource_limits"));
+
+    user_config.set_string("memory_limit_factor", "3");
+    user_config.set_string("max_open_files", "256");
+    user_config.set_string("max_processes", "64");
+    ATF_REQUIRE_THROW_RE(
+        config::error, "memory_limit_factor.*Must be a positive integer",
+        user_config.set_string("memory_limit_factor", "0"));
+    ATF_REQUIRE_THROW_RE(
+        config::error, "max_open_files.*Must be a positive integer",
+        user_config.set_string("max_open_files", "-1"));
+
+    user_config.set_string("max_file_size", "10m");
+    ATF_REQUIRE_EQ("10m",
+                   user_config.lookup< engine::bytes_node >("max_file_size"));
+    ATF_REQUIRE_THROW_RE(
+        config::error, "max_file_size.*Invalid bytes quantity",
+        user_config.set_string("max_file_size", "10 apples"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(config__set__class_caps);
+ATF_TEST_CASE_BODY(config__set__class_caps)
+{
+    config::tree user_config = engine::default_config();
+    ATF_REQUIRE(!user_config.is_set("max_cpu_tests"));
+    ATF_REQUIRE(!user_config.is_set("max_io_tests"));
+    ATF_REQUIRE(!user_config.is_set("max_memory_tests"));
+
+    user_config.set_string("max_cpu_tests", "4");
+    user_config.set_string("max_io_tests", "1");
+    user_config.set_string("max_memory_tests", "2");
+    ATF_REQUIRE_EQ(1, user_config.lookup< config::positive_int_node >(
+        "max_io_tests"));
+    ATF_REQUIRE_THROW_RE(
+        config::error, "max_io_tests.*Must be a positive integer",
+        user_config.set_string("max_io_tests", "0"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(config__set__recheck_failures);
+ATF_TEST_CASE_BODY(config__set__recheck_failures)
+{
+    config::tree user_config = engine::default_config();
+    ATF_REQUIRE(!user_config.is_set("recheck_failures"));
+    user_config.set_string("recheck_failures", "true");
+    ATF_REQUIRE(user_config.lookup< config::bool_node >("recheck_failures"));
+    ATF_REQUIRE_THROW_RE(
+        config::error, "recheck_failures",
+        user_config.set_string("recheck_failures", "sometimes"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(config__set__jobserver);
+ATF_TEST_CASE_BODY(config__set__jobserver)
+{
+    config::tree user_config = engine::default_config();
+    user_config.set_string("jobserver", "auto");
+    user_config.set_string("jobserver", "none");
+    user_config.set_string("jobserver", "serve");
+    ATF_REQUIRE_EQ("serve", user_config.lookup_string("jobserver"));
+    ATF_REQUIRE_THROW_RE(
+        config::error, "jobserver.*Must be one of auto, none or serve",
+        user_config.set_string("jobserver", "yes"));
+    ATF_REQUIRE_EQ("serve", user_config.deep_copy().lookup_string(
+        "jobserver"));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(config__load__defaults);
 ATF_TEST_CASE_BODY(config__load__defaults)
 {
@@ -136,6 +215,8 @@ ATF_TEST_CASE_BODY(config__load__overrides)
         "config",
         "syntax(2)\n"
         "architecture = 'test-architecture'\n"
+        "index_output = true\n"
+        "jobserver = 'serve'\n"
         "parallelism = 16\n"
         "platform = 'test-platform'\n"
         "unprivileged_user = 'user2'\n"
@@ -145,6 +226,8 @@ ATF_TEST_CASE_BODY(config__load__overrides)
 
     ATF_REQUIRE_EQ("test-architecture",
                    user_config.lookup_string("architecture"));
+    ATF_REQUIRE(user_config.lookup< config::bool_node >("index_output"));
+    ATF_REQUIRE_EQ("serve", user_config.lookup_string("jobserver"));
     ATF_REQUIRE_EQ("16",
                    user_config.lookup_string("parallelism"));
     ATF_REQUIRE_EQ("test-platform",
@@ -195,6 +278,10 @@ ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, config__defaults);
     ATF_ADD_TEST_CASE(tcs, config__set__parallelism);
+    ATF_ADD_TEST_CASE(tcs, config__set__jobserver);
+    ATF_ADD_TEST_CASE(tcs, config__set__resource_limits);
+    ATF_ADD_TEST_CASE(tcs, config__set__class_caps);
+    ATF_ADD_TEST_CASE(tcs, config__set__recheck_failures);
     ATF_ADD_TEST_CASE(tcs, config__load__defaults);
     ATF_ADD_TEST_CASE(tcs, config__load__overrides);
     ATF_ADD_TEST_CASE(tcs, config__load__lua_error);
@@ -0,0 +1,289 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "engine/contention.hpp"
+
+#include <limits>
+
+#include "engine/exceptions.hpp"
+#include "model/metadata.hpp"
+#include "model/test_case.hpp"
+#include "model/test_program.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+#include "utils/sanity.hpp"
+
+namespace datetime = utils::datetime;
+namespace units = utils::units;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Peak resident memory from which a test case is considered memory-bound.
+static const uint64_t memory_threshold = 256 * 1024 * 1024;
+
+
+/// Minimum mean duration of a test case to be classified, in microseconds.
+///
+/// Test cases that complete quickly do not occupy a slot long enough to
+/// contend with others, and their resource usage is too noisy to classify.
+static const int64_t min_duration = 100000;
+
+
+/// Fraction of the wall time spent on the CPU from which a test case is
+/// considered CPU-bound.
+static const double cpu_threshold = 0.5;
+
+
+}  // anonymous namespace
+
+
+/// Parses the textual representation of a resource class.
+///
+/// \param name One of cpu, io, memory or empty.
+///
+/// \return The resource class; class_none if the name is empty.
+///
+/// \throw engine::error If the name is not valid.
+engine::resource_class
+engine::parse_resource_class(const std::string& name)
+{
+    if (name.empty())
+        return class_none;
+    else if (name == "cpu")
+        return class_cpu;
+    else if (name == "io")
+        return class_io;
+    else if (name == "memory")
+        return class_memory;
+    else
+        throw engine::error(F("Invalid resource class '%s'") % name);
+}
+
+
+/// Gets the textual representation of a resource class.
+///
+/// \param resource The resource class to represent.
+///
+/// \return One of cpu, io, memory or none.
+const char*
+engine::resource_class_name(const resource_class resource)
+{
+    switch (resource) {
+    case class_none: return "none";
+    case class_cpu: return "cpu";
+    case class_io: return "io";
+    case class_memory: return "memory";
+    }
+    UNREACHABLE;
+}
+
+
+/// Constructs an empty usage summary.
+engine::test_case_usage::test_case_usage(void) :
+    _runs(0)
+{
+}
+
+
+/// Records the resources used by a past execution of the test case.
+///
+/// \param duration The wall time the execution took.
+/// \param cpu_time The user and system CPU time consumed by the execution.
+/// \param max_rss The peak resident memory of the execution.
+void
+engine::test_case_usage::add(const datetime::delta& duration,
+                             const datetime::delta& cpu_time,
+                             const units::bytes& max_rss)
+{
+    ++_runs;
+    _total_duration += duration;
+    _total_cpu_time += cpu_time;
+    if (max_rss > _max_rss)
+        _max_rss = max_rss;
+}
+
+
+/// Returns the number of recorded executions.
+///
+/// \return A count of executions.
+std::size_t
+engine::test_case_usage::runs(void) const
+{
+    return _runs;
+}
+
+
+/// Classifies the test case by the resources used in its past executions.
+///
+/// A test case whose peak memory is large is memory-bound regardless of how it
+/// used its time.  Otherwise, a test case is CPU-bound if it spent at least
+/// half of its wall time running and I/O-bound if it spent most of it waiting.
+/// The resource usage does not tell apart waiting for the disk from waiting for
+/// other events, such as timers, so the latter count as I/O as well.
+///
+/// \return The resource class of the test case; class_none if there is no
+/// history or if the test case runs too quickly to contend with others.
+engine::resource_class
+engine::test_case_usage::classify(void) const
+{
+    if (_runs == 0)
+        return class_none;
+
+    if (_max_rss >= units::bytes(memory_threshold))
+        return class_memory;
+
+    const int64_t duration = _total_duration.to_microseconds();
+    if (duration < min_duration * static_cast< int64_t >(_runs))
+        return class_none;
+    if (_total_cpu_time.to_microseconds() >= duration * cpu_threshold)
+        return class_cpu;
+    else
+        return class_io;
+}
+
+
+/// Classifies a test case by the resource that bounds its execution.
+///
+/// \param program The test program containing the test case.
+/// \param test_case_name The name of the test case.
+/// \param usage The resources used by past executions of test cases.
+///
+/// \return The resource class given in the metadata of the test case, if any,
+/// or the one derived from its past executions otherwise.
+engine::resource_class
+engine::classify(const model::test_program& program,
+                 const std::string& test_case_name,
+                 const usage_map& usage)
+{
+    const model::test_case& test_case = program.find(test_case_name);
+    const std::string explicit_class =
+        test_case.get_metadata().resource_class();
+    if (!explicit_class.empty())
+        return parse_resource_class(explicit_class);
+
+    const usage_map::const_iterator iter = usage.find(
+        test_case_key(program.relative_path(), test_case_name));
+    if (iter == usage.end())
+        return class_none;
+    return (*iter).second.classify();
+}
+
+
+/// Constructs a balancer with no running test cases.
+///
+/// \param caps Maximum number of concurrent test cases per class.  Classes
+///     without an entry are not limited.  Limits must be positive.
+engine::contention_balancer::contention_balancer(
+    const std::map< resource_class, std::size_t >& caps) :
+    _caps(caps)
+{
+    PRE(_caps.find(class_none) == _caps.end());
+}
+
+
+/// Gets the number of running test cases of a class.
+///
+/// \param resource The class to query.
+///
+/// \return A count of test cases.
+std::size_t
+engine::contention_balancer::running(const resource_class resource) const
+{
+    const std::map< resource_class, std::size_t >::const_iterator iter =
+        _running.find(resource);
+    return iter == _running.end() ? 0 : (*iter).second;
+}
+
+
+/// Picks the test case to run next among a set of candidates.
+///
+/// The candidate whose class has the fewest running test cases wins, and ties
+/// are broken in favor of the earliest candidate so that the order in which
+/// test cases are provided is kept when there is nothing to balance.
+/// Unclassified candidates do not contend with anything, so they are treated as
+/// if their class had no running test cases.  Candidates whose class has
+/// reached its limit are never picked.
+///
+/// \param candidates The classes of the candidates, in preference order.
+///
+/// \return The index of the candidate to run, or none if all candidates belong
+/// to classes that have reached their limits.
+optional< std::size_t >
+engine::contention_balancer::pick(
+    const std::vector< resource_class >& candidates) const
+{
+    optional< std::size_t > best;
+    std::size_t best_running = std::numeric_limits< std::size_t >::max();
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        const resource_class candidate = candidates[i];
+        if (candidate == class_none)
+            return best && best_running == 0 ? best : utils::make_optional(i);
+
+        const std::size_t count = running(candidate);
+        const std::map< resource_class, std::size_t >::const_iterator cap =
+            _caps.find(candidate);
+        if (cap != _caps.end() && count >= (*cap).second)
+            continue;
+        if (count < best_running) {
+            best = i;
+            best_running = count;
+        }
+    }
+    return best;
+}
+
+
+/// Records that a test case has started.
+///
+/// \param resource The class of the test case.
+void
+engine::contention_balancer::started(const resource_class resource)
+{
+    if (resource != class_none)
+        ++_running[resource];
+}
+
+
+/// Records that a test case has finished.
+///
+/// \param resource The class of the test case.
+void
+engine::contention_balancer::finished(const resource_class resource)
+{
+    if (resource == class_none)
+        return;
+    PRE(running(resource) > 0);
+    --_running[resource];
+}
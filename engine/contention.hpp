@@ -0,0 +1,133 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file engine/contention.hpp
+/// Balancing of the resources used by the test cases that run concurrently.
+///
+/// Test cases are classified by the resource that bounds their execution,
+/// either explicitly through their metadata or from the resources they used in
+/// past runs.  The scheduling of test cases then avoids running too many test
+/// cases of the same class at once, which would only make them compete for the
+/// same resource while others sit idle.
+
+#if !defined(ENGINE_CONTENTION_HPP)
+#define ENGINE_CONTENTION_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "engine/budget.hpp"
+#include "model/test_program_fwd.hpp"
+#include "utils/datetime.hpp"
+#include "utils/optional_fwd.hpp"
+#include "utils/units.hpp"
+
+namespace engine {
+
+
+/// Resource that bounds the execution of a test case.
+enum resource_class {
+    /// The test case is not known to be bound by any resource.
+    class_none,
+
+    /// The test case spends most of its time running on the CPU.
+    class_cpu,
+
+    /// The test case spends most of its time waiting, typically for I/O.
+    class_io,
+
+    /// The test case uses large amounts of memory.
+    class_memory,
+};
+
+
+resource_class parse_resource_class(const std::string&);
+const char* resource_class_name(const resource_class);
+
+
+/// Summary of the resources used by the past executions of a test case.
+class test_case_usage {
+    /// Number of recorded executions.
+    std::size_t _runs;
+
+    /// Sum of the wall times of all recorded executions.
+    utils::datetime::delta _total_duration;
+
+    /// Sum of the CPU times of all recorded executions.
+    utils::datetime::delta _total_cpu_time;
+
+    /// Largest peak resident memory of all recorded executions.
+    utils::units::bytes _max_rss;
+
+public:
+    test_case_usage(void);
+
+    void add(const utils::datetime::delta&, const utils::datetime::delta&,
+             const utils::units::bytes&);
+
+    std::size_t runs(void) const;
+    resource_class classify(void) const;
+};
+
+
+/// Collection of the resources used by the past executions of test cases.
+typedef std::map< test_case_key, test_case_usage > usage_map;
+
+
+resource_class classify(const model::test_program&, const std::string&,
+                        const usage_map&);
+
+
+/// Tracks the classes of the running test cases to pick the next one to run.
+class contention_balancer {
+    /// Maximum number of concurrent test cases per class.  Classes without an
+    /// entry are not limited.
+    std::map< resource_class, std::size_t > _caps;
+
+    /// Number of running test cases per class.
+    std::map< resource_class, std::size_t > _running;
+
+    std::size_t running(const resource_class) const;
+
+public:
+    explicit contention_balancer(
+        const std::map< resource_class, std::size_t >&);
+
+    utils::optional< std::size_t > pick(
+        const std::vector< resource_class >&) const;
+    void started(const resource_class);
+    void finished(const resource_class);
+};
+
+
+}  // namespace engine
+
+
+#endif  // !defined(ENGINE_CONTENTION_HPP)
@@ -0,0 +1,232 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "engine/contention.hpp"
+
+#include <atf-c++.hpp>
+
+#include "engine/exceptions.hpp"
+#include "model/metadata.hpp"
+#include "model/test_program.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
+#include "utils/units.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace units = utils::units;
+
+
+namespace {
+
+
+/// Constructs the usage summary of a single execution.
+///
+/// \param wall_ms Wall time of the execution, in milliseconds.
+/// \param cpu_ms CPU time of the execution, in milliseconds.
+/// \param rss_mb Peak resident memory of the execution, in megabytes.
+///
+/// \return A usage summary.
+static engine::test_case_usage
+one_run(const int64_t wall_ms, const int64_t cpu_ms, const uint64_t rss_mb)
+{
+    engine::test_case_usage usage;
+    usage.add(datetime::delta::from_microseconds(wall_ms * 1000),
+              datetime::delta::from_microseconds(cpu_ms * 1000),
+              units::bytes(rss_mb * units::MB));
+    return usage;
+}
+
+
+/// Constructs a list of candidate classes.
+///
+/// \param first The class of the first candidate.
+/// \param second The class of the second candidate.
+/// \param third The class of the third candidate.
+///
+/// \return The candidate classes.
+static std::vector< engine::resource_class >
+candidates(const engine::resource_class first,
+           const engine::resource_class second,
+           const engine::resource_class third)
+{
+    std::vector< engine::resource_class > classes;
+    classes.push_back(first);
+    classes.push_back(second);
+    classes.push_back(third);
+    return classes;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(parse_resource_class);
+ATF_TEST_CASE_BODY(parse_resource_class)
+{
+    ATF_REQUIRE_EQ(engine::class_none, engine::parse_resource_class(""));
+    ATF_REQUIRE_EQ(engine::class_cpu, engine::parse_resource_class("cpu"));
+    ATF_REQUIRE_EQ(engine::class_io, engine::parse_resource_class("io"));
+    ATF_REQUIRE_EQ(engine::class_memory,
+                   engine::parse_resource_class("memory"));
+    ATF_REQUIRE_THROW_RE(engine::error, "Invalid resource class 'disk'",
+                         engine::parse_resource_class("disk"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(test_case_usage__classify);
+ATF_TEST_CASE_BODY(test_case_usage__classify)
+{
+    ATF_REQUIRE_EQ(engine::class_none, engine::test_case_usage().classify());
+    ATF_REQUIRE_EQ(engine::class_cpu, one_run(1000, 900, 10).classify());
+    ATF_REQUIRE_EQ(engine::class_cpu, one_run(1000, 3000, 10).classify());
+    ATF_REQUIRE_EQ(engine::class_io, one_run(1000, 100, 10).classify());
+    ATF_REQUIRE_EQ(engine::class_memory, one_run(1000, 900, 512).classify());
+    ATF_REQUIRE_EQ(engine::class_memory, one_run(10, 10, 512).classify());
+    ATF_REQUIRE_EQ(engine::class_none, one_run(10, 1, 10).classify());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(test_case_usage__many_runs);
+ATF_TEST_CASE_BODY(test_case_usage__many_runs)
+{
+    engine::test_case_usage usage;
+    usage.add(datetime::delta(1, 0), datetime::delta(1, 0),
+              units::bytes(10 * units::MB));
+    usage.add(datetime::delta(3, 0), datetime::delta(0, 0),
+              units::bytes(20 * units::MB));
+    ATF_REQUIRE_EQ(2, usage.runs());
+    ATF_REQUIRE_EQ(engine::class_io, usage.classify());
+
+    usage.add(datetime::delta(1, 0), datetime::delta(1, 0),
+              units::bytes(300 * units::MB));
+    ATF_REQUIRE_EQ(engine::class_memory, usage.classify());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(classify__metadata_and_history);
+ATF_TEST_CASE_BODY(classify__metadata_and_history)
+{
+    const model::test_program program = model::test_program_builder(
+        "plain", fs::path("dir/program"), fs::path("/the/root"), "the-suite")
+        .add_test_case("explicit", model::metadata_builder()
+                       .set_resource_class("memory").build())
+        .add_test_case("measured")
+        .add_test_case("unknown")
+        .build();
+
+    engine::usage_map usage;
+    usage[engine::test_case_key(fs::path("dir/program"), "explicit")] =
+        one_run(1000, 1000, 10);
+    usage[engine::test_case_key(fs::path("dir/program"), "measured")] =
+        one_run(1000, 10, 10);
+
+    ATF_REQUIRE_EQ(engine::class_memory,
+                   engine::classify(program, "explicit", usage));
+    ATF_REQUIRE_EQ(engine::class_io,
+                   engine::classify(program, "measured", usage));
+    ATF_REQUIRE_EQ(engine::class_none,
+                   engine::classify(program, "unknown", usage));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(contention_balancer__keeps_order);
+ATF_TEST_CASE_BODY(contention_balancer__keeps_order)
+{
+    const std::map< engine::resource_class, std::size_t > no_caps;
+    engine::contention_balancer balancer(no_caps);
+    ATF_REQUIRE_EQ(0, balancer.pick(candidates(
+        engine::class_none, engine::class_none, engine::class_none)).get());
+    ATF_REQUIRE_EQ(0, balancer.pick(candidates(
+        engine::class_io, engine::class_cpu, engine::class_none)).get());
+    ATF_REQUIRE(!balancer.pick(std::vector< engine::resource_class >()));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(contention_balancer__balances);
+ATF_TEST_CASE_BODY(contention_balancer__balances)
+{
+    const std::map< engine::resource_class, std::size_t > no_caps;
+    engine::contention_balancer balancer(no_caps);
+    balancer.started(engine::class_io);
+    ATF_REQUIRE_EQ(1, balancer.pick(candidates(
+        engine::class_io, engine::class_cpu, engine::class_io)).get());
+    ATF_REQUIRE_EQ(2, balancer.pick(candidates(
+        engine::class_io, engine::class_io, engine::class_none)).get());
+
+    balancer.started(engine::class_cpu);
+    ATF_REQUIRE_EQ(2, balancer.pick(candidates(
+        engine::class_io, engine::class_cpu, engine::class_memory)).get());
+    balancer.started(engine::class_memory);
+    ATF_REQUIRE_EQ(0, balancer.pick(candidates(
+        engine::class_io, engine::class_cpu, engine::class_memory)).get());
+
+    balancer.finished(engine::class_io);
+    ATF_REQUIRE_EQ(2, balancer.pick(candidates(
+        engine::class_cpu, engine::class_memory, engine::class_io)).get());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(contention_balancer__caps);
+ATF_TEST_CASE_BODY(contention_balancer__caps)
+{
+    std::map< engine::resource_class, std::size_t > caps;
+    caps[engine::class_io] = 1;
+    engine::contention_balancer balancer(caps);
+
+    ATF_REQUIRE_EQ(0, balancer.pick(candidates(
+        engine::class_io, engine::class_io, engine::class_io)).get());
+    balancer.started(engine::class_io);
+    ATF_REQUIRE(!balancer.pick(candidates(
+        engine::class_io, engine::class_io, engine::class_io)));
+    ATF_REQUIRE_EQ(2, balancer.pick(candidates(
+        engine::class_io, engine::class_io, engine::class_none)).get());
+
+    balancer.started(engine::class_cpu);
+    balancer.started(engine::class_cpu);
+    ATF_REQUIRE_EQ(1, balancer.pick(candidates(
+        engine::class_io, engine::class_cpu, engine::class_io)).get());
+
+    balancer.finished(engine::class_io);
+    ATF_REQUIRE_EQ(0, balancer.pick(candidates(
+        engine::class_io, engine::class_cpu, engine::class_io)).get());
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, parse_resource_class);
+    ATF_ADD_TEST_CASE(tcs, test_case_usage__classify);
+    ATF_ADD_TEST_CASE(tcs, test_case_usage__many_runs);
+    ATF_ADD_TEST_CASE(tcs, classify__metadata_and_history);
+    ATF_ADD_TEST_CASE(tcs, contention_balancer__keeps_order);
+    ATF_ADD_TEST_CASE(tcs, contention_balancer__balances);
+    ATF_ADD_TEST_CASE(tcs, contention_balancer__caps);
+}
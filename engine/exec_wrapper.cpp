@@ -0,0 +1,146 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "engine/exec_wrapper.hpp"
+
+#include <vector>
+
+#include "utils/config/tree.ipp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/process/operations.hpp"
+
+namespace config = utils::config;
+namespace fs = utils::fs;
+namespace process = utils::process;
+
+
+namespace {
+
+
+/// Gets the command template configured for a test suite.
+///
+/// \param user_config The user configuration.
+/// \param test_suite Name of the test suite.
+///
+/// \return The words of the command template, which may be empty if there is
+/// no wrapper for the test suite.
+static std::vector< std::string >
+get_template(const config::tree& user_config, const std::string& test_suite)
+{
+    const std::string key = F("execution_wrappers.%s") % test_suite;
+    if (!user_config.is_set(key))
+        return std::vector< std::string >();
+    const std::string raw_template = user_config.lookup_string(key);
+
+    std::vector< std::string > words;
+    std::string::size_type pos = raw_template.find_first_not_of(" \t\n");
+    while (pos != std::string::npos) {
+        const std::string::size_type end = raw_template.find_first_of(
+            " \t\n", pos);
+        words.push_back(raw_template.substr(pos, end == std::string::npos ?
+                                            std::string::npos : end - pos));
+        pos = raw_template.find_first_not_of(" \t\n", end);
+    }
+    return words;
+}
+
+
+}  // anonymous namespace
+
+
+/// Placeholder in wrapper templates that expands to the control directory.
+const char* const engine::exec_wrapper_control_placeholder = "{control}";
+
+
+/// Computes the command with which to wrap the execution of a test case.
+///
+/// The command template is taken from the execution_wrappers.<test_suite>
+/// configuration variable and is split into words at whitespace; there is no
+/// support for quoting.  Any occurrence of the {control} placeholder is
+/// replaced by the control directory of the test case.
+///
+/// \param user_config The user configuration.
+/// \param test_suite Name of the test suite the test case belongs to.
+/// \param control_directory Control directory of the test case.
+///
+/// \return The command to prepend to the execution of the test case, or an
+/// empty vector if the test suite has no wrapper.
+process::args_vector
+engine::exec_wrapper(const config::tree& user_config,
+                     const std::string& test_suite,
+                     const fs::path& control_directory)
+{
+    const std::string placeholder = exec_wrapper_control_placeholder;
+    const std::string& control = control_directory.str();
+
+    process::args_vector args = get_template(user_config, test_suite);
+    for (process::args_vector::iterator iter = args.begin();
+         iter != args.end(); ++iter) {
+        std::string::size_type pos = (*iter).find(placeholder);
+        while (pos != std::string::npos) {
+            (*iter).replace(pos, placeholder.length(), control);
+            pos = (*iter).find(placeholder, pos + control.length());
+        }
+    }
+    return args;
+}
+
+
+/// Gets the names of the files that the wrapper of a test suite generates.
+///
+/// Any word of the command template that ends with a reference to a file
+/// directly within the control directory, as in {control}/perf.txt, declares
+/// an output file of the wrapper.
+///
+/// \param user_config The user configuration.
+/// \param test_suite Name of the test suite.
+///
+/// \return The names of the files, relative to the control directory of every
+/// test case.
+std::set< std::string >
+engine::exec_wrapper_files(const config::tree& user_config,
+                           const std::string& test_suite)
+{
+    const std::string prefix = F("%s/") % exec_wrapper_control_placeholder;
+
+    std::set< std::string > files;
+    const std::vector< std::string > words = get_template(user_config,
+                                                          test_suite);
+    for (std::vector< std::string >::const_iterator iter = words.begin();
+         iter != words.end(); ++iter) {
+        const std::string::size_type pos = (*iter).rfind(prefix);
+        if (pos == std::string::npos)
+            continue;
+
+        const std::string name = (*iter).substr(pos + prefix.length());
+        if (!name.empty() && name.find_first_of("/{}") == std::string::npos)
+            files.insert(name);
+    }
+    return files;
+}
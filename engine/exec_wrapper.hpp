@@ -0,0 +1,63 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file engine/exec_wrapper.hpp
+/// Wrapping of the execution of test cases with user-provided commands.
+///
+/// Users can configure a command template per test suite that is prepended to
+/// the execution of every test case of the suite, which allows running whole
+/// test suites under tools like profilers, valgrind or taskset without having
+/// to modify the test programs or their Kyuafiles.
+
+#if !defined(ENGINE_EXEC_WRAPPER_HPP)
+#define ENGINE_EXEC_WRAPPER_HPP
+
+#include <set>
+#include <string>
+
+#include "utils/config/tree_fwd.hpp"
+#include "utils/fs/path_fwd.hpp"
+#include "utils/process/operations_fwd.hpp"
+
+namespace engine {
+
+
+extern const char* const exec_wrapper_control_placeholder;
+
+
+utils::process::args_vector exec_wrapper(const utils::config::tree&,
+                                         const std::string&,
+                                         const utils::fs::path&);
+std::set< std::string > exec_wrapper_files(const utils::config::tree&,
+                                           const std::string&);
+
+
+}  // namespace engine
+
+
+#endif  // !defined(ENGINE_EXEC_WRAPPER_HPP)
@@ -0,0 +1,136 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "engine/exec_wrapper.hpp"
+
+#include <atf-c++.hpp>
+
+#include "engine/config.hpp"
+#include "utils/config/tree.ipp"
+#include "utils/fs/path.hpp"
+#include "utils/process/operations.hpp"
+
+namespace config = utils::config;
+namespace fs = utils::fs;
+namespace process = utils::process;
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(exec_wrapper__none);
+ATF_TEST_CASE_BODY(exec_wrapper__none)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set_string("execution_wrappers.other", "nice");
+
+    ATF_REQUIRE(engine::exec_wrapper(user_config, "suite",
+                                     fs::path("/ctl")).empty());
+    ATF_REQUIRE(engine::exec_wrapper_files(user_config, "suite").empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(exec_wrapper__empty);
+ATF_TEST_CASE_BODY(exec_wrapper__empty)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set_string("execution_wrappers.suite", "  \t ");
+
+    ATF_REQUIRE(engine::exec_wrapper(user_config, "suite",
+                                     fs::path("/ctl")).empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(exec_wrapper__words);
+ATF_TEST_CASE_BODY(exec_wrapper__words)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set_string("execution_wrappers.suite",
+                           " taskset\t-c 0  nice -n 10 ");
+
+    process::args_vector exp_args;
+    exp_args.push_back("taskset");
+    exp_args.push_back("-c");
+    exp_args.push_back("0");
+    exp_args.push_back("nice");
+    exp_args.push_back("-n");
+    exp_args.push_back("10");
+    ATF_REQUIRE(exp_args == engine::exec_wrapper(user_config, "suite",
+                                                 fs::path("/ctl")));
+    ATF_REQUIRE(engine::exec_wrapper_files(user_config, "suite").empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(exec_wrapper__control_placeholder);
+ATF_TEST_CASE_BODY(exec_wrapper__control_placeholder)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set_string(
+        "execution_wrappers.suite",
+        "perf stat -x, -o {control}/perf.txt -- "
+        "valgrind --massif-out-file={control}/massif.out --log-dir={control} "
+        "{control}{control}");
+
+    process::args_vector exp_args;
+    exp_args.push_back("perf");
+    exp_args.push_back("stat");
+    exp_args.push_back("-x,");
+    exp_args.push_back("-o");
+    exp_args.push_back("/the/ctl/perf.txt");
+    exp_args.push_back("--");
+    exp_args.push_back("valgrind");
+    exp_args.push_back("--massif-out-file=/the/ctl/massif.out");
+    exp_args.push_back("--log-dir=/the/ctl");
+    exp_args.push_back("/the/ctl/the/ctl");
+    ATF_REQUIRE(exp_args == engine::exec_wrapper(user_config, "suite",
+                                                 fs::path("/the/ctl")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(exec_wrapper_files);
+ATF_TEST_CASE_BODY(exec_wrapper_files)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set_string(
+        "execution_wrappers.suite",
+        "perf stat -o {control}/perf.txt -- "
+        "valgrind --massif-out-file={control}/massif.out --log-dir={control} "
+        "--a={control}/sub/file --b={control}/ --c={control}/{x}");
+
+    std::set< std::string > exp_files;
+    exp_files.insert("massif.out");
+    exp_files.insert("perf.txt");
+    ATF_REQUIRE(exp_files == engine::exec_wrapper_files(user_config, "suite"));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, exec_wrapper__none);
+    ATF_ADD_TEST_CASE(tcs, exec_wrapper__empty);
+    ATF_ADD_TEST_CASE(tcs, exec_wrapper__words);
+    ATF_ADD_TEST_CASE(tcs, exec_wrapper__control_placeholder);
+    ATF_ADD_TEST_CASE(tcs, exec_wrapper_files);
+}
@@ -30,7 +30,9 @@
 
 #include <algorithm>
 #include <iterator>
+#include <map>
 #include <stdexcept>
+#include <vector>
 
 #include <lutok/exceptions.hpp>
 #include <lutok/operations.hpp>
@@ -47,15 +49,19 @@
 #include "utils/format/macros.hpp"
 #include "utils/fs/lua_module.hpp"
 #include "utils/fs/operations.hpp"
+#include "utils/heap_stats.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/noncopyable.hpp"
 #include "utils/optional.ipp"
 #include "utils/sanity.hpp"
+#include "utils/text/operations.ipp"
 
 namespace config = utils::config;
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
+namespace heap_stats = utils::heap_stats;
 namespace scheduler = engine::scheduler;
+namespace text = utils::text;
 
 using utils::none;
 using utils::optional;
@@ -84,6 +90,7 @@ namespace {
 static int lua_current_kyuafile(lutok::state&);
 static int lua_generic_test_program(lutok::state&);
 static int lua_include(lutok::state&);
+static int lua_include_tree(lutok::state&);
 static int lua_syntax(lutok::state&);
 static int lua_test_suite(lutok::state&);
 
@@ -106,6 +113,118 @@ relativize(const fs::path& root, const fs::path& file)
 }
 
 
+/// Resolves the name of a dependency of a test program.
+///
+/// \param directory Directory of the Kyuafile declaring the dependency,
+///     relative to the root of the test suite.
+/// \param raw_name Name of the dependency as given in the Kyuafile.
+/// \param program Name of the test program, for error reporting purposes.
+///
+/// \return The name of the dependency relative to the root of the test suite.
+///
+/// \throw std::runtime_error If the name is absolute or points outside of the
+///     test suite.
+static std::string
+resolve_dependency(const fs::path& directory, const std::string& raw_name,
+                   const fs::path& program)
+{
+    const fs::path raw_path(raw_name);
+    if (raw_path.is_absolute())
+        throw std::runtime_error(F("Got unexpected absolute path for "
+                                   "dependency '%s' of test program '%s'") %
+                                 raw_path % program);
+
+    std::vector< std::string > components;
+    const std::vector< std::string > words = text::split(
+        relativize(directory, raw_path).str(), '/');
+    for (std::vector< std::string >::const_iterator iter = words.begin();
+         iter != words.end(); ++iter) {
+        if (*iter == "..") {
+            if (components.empty())
+                throw std::runtime_error(F("Dependency '%s' of test program "
+                                           "'%s' is outside of the test "
+                                           "suite") % raw_path % program);
+            components.pop_back();
+        } else if (*iter != "." && !(*iter).empty()) {
+            components.push_back(*iter);
+        }
+    }
+    return text::join(components, "/");
+}
+
+
+/// Visits a test program and its dependencies looking for cycles.
+///
+/// \param file The Kyuafile being loaded, for error reporting purposes.
+/// \param dependencies The dependencies of every test program.
+/// \param program The test program to visit.
+/// \param [in,out] visited Test programs already visited.  The value is false
+///     while the test program's own dependencies are being visited and true
+///     once they have all been.
+///
+/// \throw engine::load_error If the test program depends on itself.
+static void
+check_cycles(const fs::path& file,
+             const std::map< std::string, model::strings_set >& dependencies,
+             const std::string& program,
+             std::map< std::string, bool >& visited)
+{
+    const std::map< std::string, bool >::const_iterator iter =
+        visited.find(program);
+    if (iter != visited.end()) {
+        if (!(*iter).second)
+            throw engine::load_error(file, F("Test program '%s' depends on "
+                                             "itself") % program);
+        return;
+    }
+
+    visited[program] = false;
+    const model::strings_set& prerequisites = (*dependencies.find(
+        program)).second;
+    for (model::strings_set::const_iterator dep = prerequisites.begin();
+         dep != prerequisites.end(); ++dep)
+        check_cycles(file, dependencies, *dep, visited);
+    visited[program] = true;
+}
+
+
+/// Ensures that the dependencies between test programs are sound.
+///
+/// \param file The Kyuafile being loaded, for error reporting purposes.
+/// \param test_programs The test programs defined by the Kyuafile.
+///
+/// \throw engine::load_error If a test program depends on an unknown test
+///     program or if there are cyclic dependencies.
+static void
+check_dependencies(const fs::path& file,
+                   const model::test_programs_vector& test_programs)
+{
+    std::map< std::string, model::strings_set > dependencies;
+    for (model::test_programs_vector::const_iterator iter =
+             test_programs.begin(); iter != test_programs.end(); ++iter) {
+        dependencies[(*iter)->relative_path().str()] =
+            (*iter)->get_metadata().depends_on();
+    }
+
+    for (std::map< std::string, model::strings_set >::const_iterator iter =
+             dependencies.begin(); iter != dependencies.end(); ++iter) {
+        for (model::strings_set::const_iterator dep = (*iter).second.begin();
+             dep != (*iter).second.end(); ++dep) {
+            if (dependencies.find(*dep) == dependencies.end())
+                throw engine::load_error(file, F("Test program '%s' depends "
+                                                 "on unknown test program "
+                                                 "'%s'") % (*iter).first %
+                                         *dep);
+        }
+    }
+
+    std::map< std::string, bool > visited;
+    for (std::map< std::string, model::strings_set >::const_iterator iter =
+             dependencies.begin(); iter != dependencies.end(); ++iter)
+        check_cycles(file, dependencies, (*iter).first, visited);
+}
+
+
 /// Implementation of a parser for Kyuafiles.
 ///
 /// The main purpose of having this as a class is to keep track of global state
@@ -204,6 +323,12 @@ public:
         _state.push_cxx_closure(lua_include, 2);
         _state.set_global("include");
 
+        *_state.new_userdata< const config::tree* >() = &user_config;
+        *_state.new_userdata< scheduler::scheduler_handle* >() =
+            &scheduler_handle;
+        _state.push_cxx_closure(lua_include_tree, 2);
+        _state.set_global("include_tree");
+
         _state.push_cxx_function(lua_test_suite);
         _state.set_global("test_suite");
 
@@ -282,6 +407,45 @@ public:
                   std::back_inserter(_test_programs));
     }
 
+    /// Callback for the Kyuafile include_tree() function.
+    ///
+    /// \post _test_programs is extended with the test programs defined by all
+    /// the Kyuafiles found in the subdirectories of the given directory.
+    ///
+    /// \param raw_dir Path to the directory to scan, relative to the directory
+    ///     containing the current Kyuafile.
+    /// \param max_depth Maximum number of directory levels to descend into, if
+    ///     any.
+    /// \param user_config User configuration holding any test suite properties
+    ///     to be passed to the list operation.
+    /// \param scheduler_handle Scheduler context to run test programs in.
+    ///
+    /// \throw std::runtime_error If the directory is invalid.
+    void
+    callback_include_tree(const fs::path& raw_dir,
+                          const optional< int >& max_depth,
+                          const config::tree& user_config,
+                          scheduler::scheduler_handle& scheduler_handle)
+    {
+        if (raw_dir.is_absolute())
+            throw std::runtime_error(F("Directory '%s' passed to "
+                                       "include_tree must be relative") %
+                                     raw_dir);
+        if (max_depth && max_depth.get() < 0)
+            throw std::runtime_error(F("Invalid max_depth %s passed to "
+                                       "include_tree") % max_depth.get());
+
+        const fs::path dir = relativize(_source_root, relativize(
+            _relative_filename.branch_path(), raw_dir));
+        const std::vector< fs::path > files = fs::find_in_subdirectories(
+            dir, "Kyuafile", max_depth);
+        for (std::vector< fs::path >::const_iterator iter = files.begin();
+             iter != files.end(); ++iter) {
+            callback_include(relativize(raw_dir, *iter), user_config,
+                             scheduler_handle);
+        }
+    }
+
     /// Callback for the Kyuafile syntax() function.
     ///
     /// \post _version is set to the requested version.
@@ -343,12 +507,32 @@ public:
             throw std::runtime_error(F("Non-existent test program '%s'") %
                                      path);
 
+        // Manifests use the list format of ATF test programs, which cannot
+        // describe the test cases of the other interfaces.
+        if (!metadata.manifest().empty() && interface != "atf")
+            throw std::runtime_error(F("Test program '%s' cannot have a "
+                                       "manifest because it does not use the "
+                                       "atf interface") % path);
+
         const std::string test_suite = get_test_suite(test_suite_override);
 
+        // Dependencies are written relative to the Kyuafile that declares
+        // them, just like the test program names.
+        const model::strings_set raw_depends_on = metadata.depends_on();
+        model::strings_set depends_on;
+        for (model::strings_set::const_iterator iter = raw_depends_on.begin();
+             iter != raw_depends_on.end(); ++iter) {
+            depends_on.insert(resolve_dependency(
+                _relative_filename.branch_path(), *iter, path));
+        }
+
         _test_programs.push_back(model::test_program_ptr(
-            new scheduler::lazy_test_program(interface, path, _build_root,
-                                             test_suite, metadata, user_config,
-                                             scheduler_handle)));
+            new scheduler::lazy_test_program(
+                interface, path, _build_root, test_suite,
+                depends_on.empty() ? metadata :
+                model::metadata_builder(metadata)
+                    .set_depends_on(depends_on).build(),
+                user_config, scheduler_handle)));
     }
 
     /// Callback for the Kyuafile test_suite() function.
@@ -399,6 +583,38 @@ public:
 };
 
 
+/// Flattens a table of strings into a list of words.
+///
+/// This allows set-valued metadata properties, such as depends_on, to be
+/// written as Lua tables in addition to whitespace-separated strings.
+///
+/// \pre state(-1) The table to flatten.
+///
+/// \param state The Lua state holding the table.
+/// \param property The name of the property being set, for error reporting.
+/// \param path The name of the test program, for error reporting.
+///
+/// \return The values of the table separated by spaces.
+///
+/// \throw std::runtime_error If the table contains any non-string value.
+static std::string
+join_table(lutok::state& state, const std::string& property,
+           const fs::path& path)
+{
+    std::vector< std::string > words;
+    state.push_nil();
+    while (state.next(-2)) {
+        if (!state.is_string(-1))
+            throw std::runtime_error(
+                F("Found non-string value in the %s property of test program "
+                  "'%s'") % property % path);
+        words.push_back(state.to_string(-1));
+        state.pop(1);
+    }
+    return text::join(words, " ");
+}
+
+
 /// Glue to invoke parser::callback_test_program() from Lua.
 ///
 /// This is a helper function for the various *_test_program() calls, as they
@@ -484,6 +700,8 @@ lua_generic_test_program(lutok::state& state)
                 value = F("%s") % state.to_integer(-1);
             } else if (state.is_string(-1)) {
                 value = state.to_string(-1);
+            } else if (state.is_table(-1)) {
+                value = join_table(state, property, path);
             } else {
                 throw std::runtime_error(
                     F("Metadata property '%s' in test program '%s' cannot be "
@@ -547,6 +765,70 @@ lua_include(lutok::state& state)
 }
 
 
+/// Glue to invoke parser::callback_include_tree() from Lua.
+///
+/// \param state The Lua state that executed the function.
+///
+/// \pre state(upvalue 1) User configuration with the per-test suite settings.
+/// \pre state(upvalue 2) Scheduler context to run test programs in.
+///
+/// \return Number of return values left on the Lua stack.
+static int
+lua_include_tree(lutok::state& state)
+{
+    if (!state.is_userdata(state.upvalue_index(1)))
+        throw std::runtime_error("Found corrupt state for include_tree "
+                                 "function");
+    const config::tree* user_config = *state.to_userdata< const config::tree* >(
+        state.upvalue_index(1));
+
+    if (!state.is_userdata(state.upvalue_index(2)))
+        throw std::runtime_error("Found corrupt state for include_tree "
+                                 "function");
+    scheduler::scheduler_handle* scheduler_handle =
+        *state.to_userdata< scheduler::scheduler_handle* >(
+            state.upvalue_index(2));
+
+    if (state.get_top() < 1 || state.get_top() > 2 || !state.is_string(1))
+        throw std::runtime_error("include_tree expects a directory name and "
+                                 "an optional table of options");
+    const fs::path dir(state.to_string(1));
+
+    optional< int > max_depth;
+    if (state.get_top() == 2 && !state.is_nil(2)) {
+        if (!state.is_table(2))
+            throw std::runtime_error("The options to include_tree must be "
+                                     "given as a table");
+
+        lutok::stack_cleaner cleaner(state);
+
+        state.push_nil();
+        while (state.next(2)) {
+            if (!state.is_string(-2))
+                throw std::runtime_error("Found non-string option name in "
+                                         "include_tree");
+            const std::string option = state.to_string(-2);
+
+            if (option == "max_depth") {
+                if (!state.is_number(-1))
+                    throw std::runtime_error("The max_depth option of "
+                                             "include_tree must be a number");
+                max_depth = static_cast< int >(state.to_integer(-1));
+            } else {
+                throw std::runtime_error(F("Unknown option '%s' in "
+                                           "include_tree") % option);
+            }
+
+            state.pop(1);
+        }
+    }
+
+    parser::get_from_state(state)->callback_include_tree(
+        dir, max_depth, *user_config, *scheduler_handle);
+    return 0;
+}
+
+
 /// Glue to invoke parser::callback_syntax() from Lua.
 ///
 /// \pre state(-2) The syntax format name, if a v1 file.
@@ -645,6 +927,8 @@ engine::kyuafile::load(const fs::path& file,
                        const config::tree& user_config,
                        scheduler::scheduler_handle& scheduler_handle)
 {
+    heap_stats::scoped_phase phase(heap_stats::phase_load);
+
     const fs::path source_root_ = file.branch_path();
     const fs::path build_root_ = user_build_root ?
         user_build_root.get() : source_root_;
@@ -657,10 +941,11 @@ engine::kyuafile::load(const fs::path& file,
     const fs::path abs_build_root = build_root_.is_absolute() ?
         build_root_ : build_root_.to_absolute();
 
-    return kyuafile(source_root_, build_root_,
-                    parser(source_root_, abs_build_root,
-                           fs::path(file.leaf_name()), user_config,
-                           scheduler_handle).parse());
+    const model::test_programs_vector test_programs =
+        parser(source_root_, abs_build_root, fs::path(file.leaf_name()),
+               user_config, scheduler_handle).parse();
+    check_dependencies(file, test_programs);
+    return kyuafile(source_root_, build_root_, test_programs);
 }
 
 
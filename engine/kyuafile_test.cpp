@@ -239,6 +239,59 @@ ATF_TEST_CASE_BODY(kyuafile__load__metadata)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__depends_on);
+ATF_TEST_CASE_BODY(kyuafile__load__depends_on)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    fs::mkdir(fs::path("root"), 0755);
+    atf::utils::create_file(
+        "root/config",
+        "syntax(2)\n"
+        "test_suite('abc')\n"
+        "atf_test_program{name='one'}\n"
+        "atf_test_program{name='two', depends_on={'one', 'dir/three'}}\n"
+        "include('dir/config')\n");
+
+    fs::mkdir(fs::path("root/dir"), 0755);
+    atf::utils::create_file(
+        "root/dir/config",
+        "syntax(2)\n"
+        "test_suite('abc')\n"
+        "atf_test_program{name='three', depends_on='../one'}\n"
+        "atf_test_program{name='four', depends_on={'three'}}\n");
+
+    atf::utils::create_file("root/one", "");
+    atf::utils::create_file("root/two", "");
+    atf::utils::create_file("root/dir/three", "");
+    atf::utils::create_file("root/dir/four", "");
+
+    const engine::kyuafile suite = engine::kyuafile::load(
+        fs::path("root/config"), none, config::tree(), handle);
+    ATF_REQUIRE_EQ(4, suite.test_programs().size());
+
+    ATF_REQUIRE(suite.test_programs()[0]->get_metadata().depends_on().empty());
+
+    model::strings_set exp_two;
+    exp_two.insert("one");
+    exp_two.insert("dir/three");
+    ATF_REQUIRE(exp_two == suite.test_programs()[1]->get_metadata()
+                .depends_on());
+
+    model::strings_set exp_three;
+    exp_three.insert("one");
+    ATF_REQUIRE(exp_three == suite.test_programs()[2]->get_metadata()
+                .depends_on());
+
+    model::strings_set exp_four;
+    exp_four.insert("dir/three");
+    ATF_REQUIRE(exp_four == suite.test_programs()[3]->get_metadata()
+                .depends_on());
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__current_directory);
 ATF_TEST_CASE_BODY(kyuafile__load__current_directory)
 {
@@ -442,6 +495,76 @@ ATF_TEST_CASE_BODY(kyuafile__load__fs_calls_are_relative)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__include_tree);
+ATF_TEST_CASE_BODY(kyuafile__load__include_tree)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    atf::utils::create_file(
+        "Kyuafile",
+        "syntax(2)\n"
+        "include_tree('.')\n");
+    fs::mkdir_p(fs::path("b/nested"), 0755);
+    atf::utils::create_file(
+        "b/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='two', test_suite='first'}\n");
+    atf::utils::create_file("b/two", "");
+    atf::utils::create_file(
+        "b/nested/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='ignored', test_suite='first'}\n");
+    fs::mkdir_p(fs::path("a/deep/dir"), 0755);
+    atf::utils::create_file(
+        "a/deep/dir/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='one', test_suite='first'}\n");
+    atf::utils::create_file("a/deep/dir/one", "");
+    fs::mkdir(fs::path("c"), 0755);
+
+    const engine::kyuafile suite = engine::kyuafile::load(
+        fs::path("Kyuafile"), none, config::tree(), handle);
+    ATF_REQUIRE_EQ(2, suite.test_programs().size());
+    ATF_REQUIRE_EQ(fs::path("a/deep/dir/one"),
+                   suite.test_programs()[0]->relative_path());
+    ATF_REQUIRE_EQ(fs::path("b/two"),
+                   suite.test_programs()[1]->relative_path());
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__include_tree__options);
+ATF_TEST_CASE_BODY(kyuafile__load__include_tree__options)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    fs::mkdir(fs::path("root"), 0755);
+    atf::utils::create_file(
+        "root/Kyuafile",
+        "syntax(2)\n"
+        "include_tree('tests', {max_depth=1})\n");
+    fs::mkdir_p(fs::path("root/tests/a/b"), 0755);
+    atf::utils::create_file(
+        "root/tests/a/b/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='too-deep', test_suite='first'}\n");
+    fs::mkdir(fs::path("root/tests/c"), 0755);
+    atf::utils::create_file(
+        "root/tests/c/Kyuafile",
+        "syntax(2)\n"
+        "plain_test_program{name='one', test_suite='first'}\n");
+    atf::utils::create_file("root/tests/c/one", "");
+
+    const engine::kyuafile suite = engine::kyuafile::load(
+        fs::path("root/Kyuafile"), none, config::tree(), handle);
+    ATF_REQUIRE_EQ(1, suite.test_programs().size());
+    ATF_REQUIRE_EQ(fs::path("tests/c/one"),
+                   suite.test_programs()[0]->relative_path());
+
+    handle.cleanup();
+}
+
 /// Verifies that load raises a load_error on a given input.
 ///
 /// \param file Name of the file to load.
@@ -472,6 +595,24 @@ ATF_TEST_CASE_BODY(kyuafile__load__test_program_not_basename)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__include_tree__bad_arguments);
+ATF_TEST_CASE_BODY(kyuafile__load__include_tree__bad_arguments)
+{
+    atf::utils::create_file("absolute", "syntax(2)\ninclude_tree('/')\n");
+    do_load_error_test("absolute", "include_tree must be relative");
+
+    atf::utils::create_file("unknown",
+                            "syntax(2)\ninclude_tree('.', {foo=1})\n");
+    do_load_error_test("unknown", "Unknown option 'foo' in include_tree");
+
+    atf::utils::create_file("depth",
+                            "syntax(2)\ninclude_tree('.', {max_depth=-1})\n");
+    do_load_error_test("depth", "Invalid max_depth -1");
+
+    atf::utils::create_file("missing", "syntax(2)\ninclude_tree('foo')\n");
+    do_load_error_test("missing", "open\\(foo\\) failed");
+}
+
 ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__lua_error);
 ATF_TEST_CASE_BODY(kyuafile__load__lua_error)
 {
@@ -572,6 +713,68 @@ ATF_TEST_CASE_BODY(kyuafile__load__missing_test_program)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__manifest__not_atf);
+ATF_TEST_CASE_BODY(kyuafile__load__manifest__not_atf)
+{
+    atf::utils::create_file(
+        "config",
+        "syntax(2)\n"
+        "test_suite('abc')\n"
+        "atf_test_program{name='one', manifest='one.tcs'}\n"
+        "plain_test_program{name='two', manifest='two.tcs'}\n");
+
+    atf::utils::create_file("one", "");
+    atf::utils::create_file("two", "");
+    do_load_error_test("config", "'two' cannot have a manifest.*atf");
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__depends_on__unknown);
+ATF_TEST_CASE_BODY(kyuafile__load__depends_on__unknown)
+{
+    atf::utils::create_file(
+        "config",
+        "syntax(2)\n"
+        "test_suite('abc')\n"
+        "atf_test_program{name='one', depends_on='two'}\n");
+
+    atf::utils::create_file("one", "");
+    do_load_error_test("config", "'one' depends on unknown test program 'two'");
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__depends_on__cycle);
+ATF_TEST_CASE_BODY(kyuafile__load__depends_on__cycle)
+{
+    atf::utils::create_file(
+        "config",
+        "syntax(2)\n"
+        "test_suite('abc')\n"
+        "atf_test_program{name='one', depends_on='three'}\n"
+        "atf_test_program{name='two', depends_on='one'}\n"
+        "atf_test_program{name='three', depends_on='two'}\n");
+
+    atf::utils::create_file("one", "");
+    atf::utils::create_file("two", "");
+    atf::utils::create_file("three", "");
+    do_load_error_test("config", "'(one|two|three)' depends on itself");
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(kyuafile__load__depends_on__outside_suite);
+ATF_TEST_CASE_BODY(kyuafile__load__depends_on__outside_suite)
+{
+    atf::utils::create_file(
+        "config",
+        "syntax(2)\n"
+        "test_suite('abc')\n"
+        "atf_test_program{name='one', depends_on='../one'}\n");
+
+    atf::utils::create_file("one", "");
+    do_load_error_test("config", "'../one'.*outside of the test suite");
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     scheduler::register_interface(
@@ -588,12 +791,16 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__real_interfaces);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__mock_interfaces);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__metadata);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__depends_on);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__current_directory);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__other_directory);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__build_directory);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__absolute_paths_are_stable);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__fs_calls_are_relative);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__include_tree);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__include_tree__options);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__test_program_not_basename);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__include_tree__bad_arguments);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__lua_error);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__syntax__not_called);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__syntax__deprecated_format);
@@ -603,4 +810,8 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__test_suite__twice);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__missing_file);
     ATF_ADD_TEST_CASE(tcs, kyuafile__load__missing_test_program);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__manifest__not_atf);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__depends_on__unknown);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__depends_on__cycle);
+    ATF_ADD_TEST_CASE(tcs, kyuafile__load__depends_on__outside_suite);
 }
@@ -89,12 +89,15 @@ engine::plain_interface::parse_list(
 /// \param test_program The test program to execute.
 /// \param test_case_name Name of the test case to invoke.
 /// \param vars User-provided variables to pass to the test program.
+/// \param wrapper Command with which to wrap the execution of the test
+///     program, or an empty vector to run it directly.
 void
 engine::plain_interface::exec_test(
     const model::test_program& test_program,
     const std::string& test_case_name,
     const config::properties_map& vars,
-    const fs::path& /* control_directory */) const
+    const fs::path& /* control_directory */,
+    const process::args_vector& wrapper) const
 {
     PRE(test_case_name == "main");
 
@@ -104,7 +107,7 @@ engine::plain_interface::exec_test(
     }
 
     process::args_vector args;
-    process::exec(test_program.absolute_path(), args);
+    process::exec(test_program.absolute_path(), args, wrapper);
 }
 
 
@@ -206,6 +206,25 @@ engine::scanner::done(void)
 }
 
 
+/// Returns the number of test programs that may still yield test cases.
+///
+/// This includes the active test program, if it has test cases left, and all
+/// test programs that have not been looked at yet.  Because filters are only
+/// applied lazily, this is an upper bound of the work left to do.
+///
+/// \return A count of test programs.
+std::size_t
+engine::scanner::pending_test_programs(void) const
+{
+    std::size_t count = _pimpl->pending_test_programs.size();
+    if (_pimpl->first_test_cases && _pimpl->first_test_cases.get().empty()) {
+        INV(count > 0);
+        --count;
+    }
+    return count;
+}
+
+
 /// Returns the list of test filters that did not match any test case.
 ///
 /// \return The collection of unmatched test filters.
@@ -34,6 +34,7 @@
 
 #include "engine/scanner_fwd.hpp"
 
+#include <cstddef>
 #include <memory>
 #include <set>
 
@@ -64,6 +65,7 @@ public:
     ~scanner(void);
 
     bool done(void);
+    std::size_t pending_test_programs(void) const;
     utils::optional< scan_result > yield(void);
 
     std::set< test_filter > unused_filters(void) const;
@@ -460,6 +460,33 @@ ATF_TEST_CASE_BODY(scanner__with_filters__verify_lazy_loads)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(scanner__pending_test_programs);
+ATF_TEST_CASE_BODY(scanner__pending_test_programs)
+{
+    const model::test_program_ptr test_program1 = new_test_program(
+        "dir/program1", "foo_test", "bar_test", NULL);
+    const model::test_program_ptr test_program2 = new_test_program(
+        "program2", "baz_test", NULL);
+
+    model::test_programs_vector test_programs;
+    test_programs.push_back(test_program1);
+    test_programs.push_back(test_program2);
+
+    const std::set< engine::test_filter > filters;
+
+    engine::scanner scanner(test_programs, filters);
+    ATF_REQUIRE_EQ(2, scanner.pending_test_programs());
+    ATF_REQUIRE(scanner.yield());
+    ATF_REQUIRE_EQ(2, scanner.pending_test_programs());
+    ATF_REQUIRE(scanner.yield());
+    ATF_REQUIRE_EQ(1, scanner.pending_test_programs());
+    ATF_REQUIRE(scanner.yield());
+    ATF_REQUIRE_EQ(0, scanner.pending_test_programs());
+    ATF_REQUIRE(!scanner.yield());
+    ATF_REQUIRE_EQ(0, scanner.pending_test_programs());
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, scanner__no_filters__no_tests);
@@ -473,4 +500,6 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, scanner__with_filters__no_matches);
     ATF_ADD_TEST_CASE(tcs, scanner__with_filters__some_matches);
     ATF_ADD_TEST_CASE(tcs, scanner__with_filters__verify_lazy_loads);
+
+    ATF_ADD_TEST_CASE(tcs, scanner__pending_test_programs);
 }
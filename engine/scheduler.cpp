@@ -29,17 +29,29 @@
 #include "engine/scheduler.hpp"
 
 extern "C" {
+#include <sys/stat.h>
+
+#include <signal.h>
 #include <unistd.h>
 }
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <functional>
+#include <map>
 #include <memory>
+#include <set>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
+#include "engine/atf_list.hpp"
 #include "engine/config.hpp"
 #include "engine/exceptions.hpp"
+#include "engine/exec_wrapper.hpp"
 #include "engine/requirements.hpp"
 #include "model/context.hpp"
 #include "model/metadata.hpp"
@@ -55,26 +67,32 @@ extern "C" {
 #include "utils/fs/exceptions.hpp"
 #include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/heap_stats.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/noncopyable.hpp"
 #include "utils/optional.ipp"
 #include "utils/passwd.hpp"
 #include "utils/process/executor.ipp"
+#include "utils/process/isolation.hpp"
+#include "utils/process/operations.hpp"
 #include "utils/process/status.hpp"
 #include "utils/sanity.hpp"
 #include "utils/stacktrace.hpp"
 #include "utils/stream.hpp"
 #include "utils/text/operations.ipp"
+#include "utils/units.hpp"
 
 namespace config = utils::config;
 namespace datetime = utils::datetime;
 namespace executor = utils::process::executor;
 namespace fs = utils::fs;
+namespace heap_stats = utils::heap_stats;
 namespace logging = utils::logging;
 namespace passwd = utils::passwd;
 namespace process = utils::process;
 namespace scheduler = engine::scheduler;
 namespace text = utils::text;
+namespace units = utils::units;
 
 using utils::none;
 using utils::optional;
@@ -94,6 +112,13 @@ datetime::delta scheduler::cleanup_timeout(60, 0);
 datetime::delta scheduler::list_timeout(300, 0);
 
 
+/// Name of the environment variable that points to the fixture directory.
+///
+/// This is set for the test cases and the setup and teardown commands of any
+/// test program that defines a fixture.
+const char* const scheduler::fixture_directory_variable = "KYUA_FIXTURE_DIR";
+
+
 namespace {
 
 
@@ -113,6 +138,10 @@ static const int exit_skipped = 84;
 static const char* skipped_cookie = "skipped.txt";
 
 
+/// Maximum number of bytes of the stderr of a failed fixture command to log.
+static const std::size_t max_fixture_stderr = 4096;
+
+
 /// Mapping of interface names to interface definitions.
 typedef std::map< std::string, std::shared_ptr< scheduler::interface > >
     interfaces_map;
@@ -124,6 +153,26 @@ typedef std::map< std::string, std::shared_ptr< scheduler::interface > >
 static interfaces_map interfaces;
 
 
+/// Function to register the interfaces on first use, if any.
+///
+/// Use register_interfaces_loader() to set this.
+static std::function< void (void) > interfaces_loader;
+
+
+/// Runs the pending interfaces loader, if any.
+///
+/// This must be called before any access to the interfaces table.
+static void
+load_interfaces(void)
+{
+    if (interfaces_loader) {
+        const std::function< void (void) > loader = interfaces_loader;
+        interfaces_loader = nullptr;
+        loader();
+    }
+}
+
+
 /// Scans the contents of a directory and appends the file listing to a file.
 ///
 /// \param dir_path The directory to scan.
@@ -173,13 +222,20 @@ struct exec_data : utils::noncopyable {
     /// Name of the test case.
     const std::string test_case_name;
 
+    /// Names of the files generated by the execution wrapper of the test.
+    const std::set< std::string > wrapper_files;
+
     /// Constructor.
     ///
     /// \param test_program_ Test program data for this test case.
     /// \param test_case_name_ Name of the test case.
+    /// \param wrapper_files_ Names of the files generated by the execution
+    ///     wrapper of the test, relative to its control directory.
     exec_data(const model::test_program_ptr test_program_,
-              const std::string& test_case_name_) :
-        test_program(test_program_), test_case_name(test_case_name_)
+              const std::string& test_case_name_,
+              const std::set< std::string >& wrapper_files_) :
+        test_program(test_program_), test_case_name(test_case_name_),
+        wrapper_files(wrapper_files_)
     {
     }
 
@@ -213,21 +269,34 @@ struct test_exec_data : public exec_data {
     /// as indicated by needs_cleanup.
     optional< executor::exit_handle > exit_handle;
 
+    /// Result to report instead of running the test, if any.
+    ///
+    /// This is set when the fixture or the work template of the test program
+    /// could not be set up, in which case the test case is never run.
+    const optional< model::test_result > fixture_result;
+
     /// Constructor.
     ///
     /// \param test_program_ Test program data for this test case.
     /// \param test_case_name_ Name of the test case.
     /// \param interface_ Test program-specific execution interface.
     /// \param user_config_ User configuration passed to the test.
+    /// \param fixture_result_ If not none, the result to report for the test
+    ///     because its test program fixture or work template is broken.
     test_exec_data(const model::test_program_ptr test_program_,
                    const std::string& test_case_name_,
                    const std::shared_ptr< scheduler::interface > interface_,
-                   const config::tree& user_config_) :
-        exec_data(test_program_, test_case_name_),
-        interface(interface_), user_config(user_config_)
+                   const config::tree& user_config_,
+                   const optional< model::test_result >& fixture_result_) :
+        exec_data(test_program_, test_case_name_,
+                  engine::exec_wrapper_files(
+                      user_config_, test_program_->test_suite_name())),
+        interface(interface_), user_config(user_config_),
+        fixture_result(fixture_result_)
     {
         const model::test_case& test_case = test_program->find(test_case_name);
-        needs_cleanup = test_case.get_metadata().has_cleanup();
+        needs_cleanup = !fixture_result &&
+            test_case.get_metadata().has_cleanup();
     }
 };
 
@@ -251,21 +320,36 @@ struct cleanup_exec_data : public exec_data {
     ///
     /// \param test_program_ Test program data for this test case.
     /// \param test_case_name_ Name of the test case.
+    /// \param wrapper_files_ Names of the files generated by the execution
+    ///     wrapper of the body.
     /// \param body_exit_handle_ If not none, exit handle of the body
     ///     corresponding to the cleanup routine represented by this exec_data.
     /// \param body_result_ If not none, result of the body corresponding to the
     ///     cleanup routine represented by this exec_data.
     cleanup_exec_data(const model::test_program_ptr test_program_,
                       const std::string& test_case_name_,
+                      const std::set< std::string >& wrapper_files_,
                       const executor::exit_handle& body_exit_handle_,
                       const model::test_result& body_result_) :
-        exec_data(test_program_, test_case_name_),
+        exec_data(test_program_, test_case_name_, wrapper_files_),
         body_exit_handle(body_exit_handle_), body_result(body_result_)
     {
     }
 };
 
 
+/// Maintenance data held while the setup command of a fixture is executed.
+struct fixture_exec_data : public exec_data {
+    /// Constructor.
+    ///
+    /// \param test_program_ The test program owning the fixture.
+    fixture_exec_data(const model::test_program_ptr test_program_) :
+        exec_data(test_program_, "", std::set< std::string >())
+    {
+    }
+};
+
+
 /// Shared pointer to exec_data.
 ///
 /// We require this because we want exec_data to not be copyable, and thus we
@@ -277,6 +361,179 @@ typedef std::shared_ptr< exec_data > exec_data_ptr;
 typedef std::map< int, exec_data_ptr > exec_data_map;
 
 
+/// Maintenance data held while the fixture of a test program exists.
+struct fixture_data {
+    /// The test program owning the fixture.
+    model::test_program_ptr test_program;
+
+    /// User configuration passed to the setup command, to reuse at teardown.
+    config::tree user_config;
+
+    /// Directory shared by the setup and teardown commands and the test cases.
+    fs::path directory;
+
+    /// Whether the setup command, if any, has completed.
+    bool ready;
+
+    /// If not none, the reason why the setup command failed.
+    optional< std::string > error;
+
+    /// Constructor.
+    ///
+    /// \param test_program_ The test program owning the fixture.
+    /// \param user_config_ User configuration passed to the setup command.
+    /// \param directory_ Directory to hold the fixture.
+    fixture_data(const model::test_program_ptr test_program_,
+                 const config::tree& user_config_,
+                 const fs::path& directory_) :
+        test_program(test_program_), user_config(user_config_),
+        directory(directory_), ready(false)
+    {
+    }
+};
+
+
+/// Mapping of test program absolute paths to their fixtures.
+typedef std::map< fs::path, fixture_data > fixtures_map;
+
+
+/// Mapping of work template directories to the errors found in them, if any.
+typedef std::map< fs::path, optional< std::string > > work_templates_map;
+
+
+/// Splits a fixture command into its words.
+///
+/// \param command The command line as given in the Kyuafile.
+/// \param program_directory Directory containing the test program, used to
+///     resolve the command if it is relative.
+///
+/// \return The path to the binary to execute and its arguments.
+static std::pair< fs::path, process::args_vector >
+parse_fixture_command(const std::string& command,
+                      const fs::path& program_directory)
+{
+    process::args_vector words;
+    std::string::size_type pos = command.find_first_not_of(" \t\n");
+    while (pos != std::string::npos) {
+        const std::string::size_type end = command.find_first_of(" \t\n",
+                                                                 pos);
+        words.push_back(command.substr(pos, end == std::string::npos ?
+                                       std::string::npos : end - pos));
+        pos = command.find_first_not_of(" \t\n", end);
+    }
+    PRE(!words.empty());
+
+    fs::path binary(words[0]);
+    if (!binary.is_absolute())
+        binary = program_directory / binary;
+    words.erase(words.begin());
+    return std::make_pair(binary, words);
+}
+
+
+/// Reads the beginning of the stderr of a fixture command for logging.
+///
+/// \param file The file holding the stderr of the command.
+///
+/// \return The contents of the file, truncated to max_fixture_stderr bytes.
+static std::string
+read_fixture_stderr(const fs::path& file)
+{
+    std::ifstream input(file.c_str());
+    if (!input)
+        return "";
+    std::vector< char > buffer(max_fixture_stderr);
+    input.read(&buffer[0], buffer.size());
+    std::string contents(&buffer[0], input.gcount());
+    if (input && input.peek() != std::ifstream::traits_type::eof())
+        contents += "\n[... truncated ...]";
+    return contents;
+}
+
+
+/// Adds or removes the write permissions of a directory tree.
+///
+/// Errors are logged and otherwise ignored: the permissions are a safety net
+/// against test cases accidentally modifying the fixture, not a requirement.
+///
+/// \param dir The directory to process.
+/// \param writable Whether to add or remove the write permissions.
+static void
+set_tree_writable(const fs::path& dir, const bool writable)
+{
+    // Directories must be made writable before descending into them so that
+    // any later removal works, and read-only after processing their contents
+    // so that we do not lose access to them halfway through.
+    struct ::stat sb;
+    if (::lstat(dir.c_str(), &sb) == -1 || !S_ISDIR(sb.st_mode))
+        return;
+    const mode_t write_bits = S_IWUSR | S_IWGRP | S_IWOTH;
+    if (writable)
+        (void)::chmod(dir.c_str(), (sb.st_mode & 07777) | S_IWUSR);
+
+    try {
+        const fs::directory entries(dir);
+        for (fs::directory::const_iterator iter = entries.begin();
+             iter != entries.end(); ++iter) {
+            if (iter->name == "." || iter->name == "..")
+                continue;
+            const fs::path entry = dir / iter->name;
+            struct ::stat esb;
+            if (::lstat(entry.c_str(), &esb) == -1)
+                continue;
+            if (S_ISDIR(esb.st_mode)) {
+                set_tree_writable(entry, writable);
+            } else if (S_ISREG(esb.st_mode)) {
+                const mode_t mode = writable ?
+                    (esb.st_mode & 07777) | S_IWUSR :
+                    (esb.st_mode & 07777) & ~write_bits;
+                (void)::chmod(entry.c_str(), mode);
+            }
+        }
+    } catch (const fs::error& e) {
+        LW(F("Cannot change permissions of fixture %s: %s") % dir % e.what());
+    }
+
+    if (!writable)
+        (void)::chmod(dir.c_str(), (sb.st_mode & 07777) & ~write_bits);
+}
+
+
+/// Ensures that a work template can be copied into the work directory of tests.
+///
+/// \param directory The template directory to check.
+///
+/// \throw engine::error If the template or any of its entries cannot be copied.
+static void
+check_work_template(const fs::path& directory)
+{
+    struct ::stat sb;
+    if (::lstat(directory.c_str(), &sb) == -1 || !S_ISDIR(sb.st_mode))
+        throw engine::error(F("%s is not a directory") % directory);
+    if (::access(directory.c_str(), R_OK | X_OK) == -1)
+        throw engine::error(F("%s is not readable") % directory);
+
+    const fs::directory entries(directory);
+    for (fs::directory::const_iterator iter = entries.begin();
+         iter != entries.end(); ++iter) {
+        if (iter->name == "." || iter->name == "..")
+            continue;
+        const fs::path entry = directory / iter->name;
+        if (::lstat(entry.c_str(), &sb) == -1)
+            throw engine::error(F("Cannot stat %s") % entry);
+        if (S_ISDIR(sb.st_mode)) {
+            check_work_template(entry);
+        } else if (S_ISREG(sb.st_mode)) {
+            if (::access(entry.c_str(), R_OK) == -1)
+                throw engine::error(F("%s is not readable") % entry);
+        } else if (!S_ISLNK(sb.st_mode)) {
+            throw engine::error(F("%s is not a regular file, a directory nor "
+                                  "a symlink") % entry);
+        }
+    }
+}
+
+
 /// Enforces a test program to hold an absolute path.
 ///
 /// TODO(jmmv): This function (which is a pretty ugly hack) exists because we
@@ -309,6 +566,46 @@ force_absolute_paths(const model::test_program program)
 }
 
 
+/// Functor to run the setup or teardown command of a test program.
+class run_fixture_command {
+    /// Binary to execute.
+    const fs::path _binary;
+
+    /// Arguments to the binary, not including argv[0].
+    const process::args_vector _args;
+
+    /// Directory holding the fixture.
+    const fs::path _fixture_directory;
+
+public:
+    /// Constructor.
+    ///
+    /// \param command Binary to execute and its arguments.
+    /// \param fixture_directory Directory holding the fixture.
+    run_fixture_command(
+        const std::pair< fs::path, process::args_vector >& command,
+        const fs::path& fixture_directory) :
+        _binary(command.first), _args(command.second),
+        _fixture_directory(fixture_directory)
+    {
+    }
+
+    /// Body of the subprocess.
+    void
+    operator()(const fs::path& /* control_directory */)
+    {
+        utils::setenv(scheduler::fixture_directory_variable,
+                      _fixture_directory.str());
+        if (::chdir(_fixture_directory.c_str()) == -1) {
+            std::perror((F("Failed to enter %s") %
+                         _fixture_directory).str().c_str());
+            std::abort();
+        }
+        process::exec(_binary, _args);
+    }
+};
+
+
 /// Functor to list the test cases of a test program.
 class list_test_cases {
     /// Interface of the test program to execute.
@@ -347,6 +644,108 @@ public:
 };
 
 
+/// Default multiplier of the required memory of a test to limit its memory.
+static const int default_memory_limit_factor = 2;
+
+
+/// Lower bound of the memory limit of a test, in bytes.
+///
+/// Tests that require very little memory would otherwise not have enough
+/// address space to even load their dynamic libraries.
+static const uint64_t min_memory_limit = 256 * 1024 * 1024;
+
+
+/// Checks if the user wants to limit the resources of the test cases.
+///
+/// \param user_config User-provided configuration variables.
+///
+/// \return True if resource limits are enabled; false otherwise.
+static bool
+resource_limits_enabled(const config::tree& user_config)
+{
+    return user_config.is_set("resource_limits") &&
+        user_config.lookup< config::bool_node >("resource_limits");
+}
+
+
+/// Computes the resource limits to apply to a test case.
+///
+/// The CPU time is not limited: the timeout already bounds the duration of the
+/// test case, and a CPU time limit would kill multithreaded test cases well
+/// before their timeout.
+///
+/// The file size limit comes from the max_file_size setting and not from the
+/// required_disk_space of the test case, which is the free disk space that the
+/// test case needs and not the size of any single file.  The limit also applies
+/// to the files that capture the stdout and stderr of the test case.
+///
+/// \param md The metadata of the test case.
+/// \param user_config User-provided configuration variables.
+/// \param wrapped Whether the test case runs under an execution wrapper.  The
+///     memory of wrapped test cases is not limited because wrappers like
+///     Valgrind or the sanitizers reserve large amounts of address space.
+///
+/// \return The limits to apply, which are all unset if the user did not enable
+/// them.
+static process::resource_limits
+compute_resource_limits(const model::metadata& md,
+                        const config::tree& user_config, const bool wrapped)
+{
+    process::resource_limits limits;
+    if (!resource_limits_enabled(user_config))
+        return limits;
+
+    if (md.required_memory() > 0 && !wrapped) {
+        const int factor = user_config.is_set("memory_limit_factor") ?
+            user_config.lookup< config::positive_int_node >(
+                "memory_limit_factor") : default_memory_limit_factor;
+        limits.memory = std::max(
+            md.required_memory() * static_cast< uint64_t >(factor),
+            min_memory_limit);
+    }
+    if (user_config.is_set("max_file_size"))
+        limits.file_size = units::bytes::parse(
+            user_config.lookup< engine::bytes_node >("max_file_size"));
+    if (user_config.is_set("max_open_files"))
+        limits.open_files = user_config.lookup< config::positive_int_node >(
+            "max_open_files");
+    if (user_config.is_set("max_processes"))
+        limits.processes = user_config.lookup< config::positive_int_node >(
+            "max_processes");
+    return limits;
+}
+
+
+/// Computes the result of a test case that exceeded its resource limits.
+///
+/// Only the limits that the kernel enforces by sending a signal can be told
+/// apart from other failures, and the file size limit is the only such limit
+/// that is set.  Test cases that exhaust their memory, processes or open files
+/// just see their allocations or system calls fail.
+///
+/// \param status The termination status of the test case, or none if it timed
+///     out.
+///
+/// \return The broken result to report if the test case was terminated for
+/// exceeding a limit; none otherwise.
+static optional< model::test_result >
+resource_limit_result(const optional< process::status >& status)
+{
+    if (!status || !status.get().signaled())
+        return none;
+
+    switch (status.get().termsig()) {
+    case SIGXFSZ:
+        return utils::make_optional(model::test_result(
+            model::test_result_broken,
+            "Test case exceeded its file size limit (max_file_size), which "
+            "also applies to its stdout and stderr"));
+    default:
+        return none;
+    }
+}
+
+
 /// Functor to execute a test program in a child process.
 class run_test_program {
     /// Interface of the test program to execute.
@@ -361,6 +760,12 @@ class run_test_program {
     /// User-provided configuration variables.
     const config::tree& _user_config;
 
+    /// Directory holding the fixture of the test program, if any.
+    const optional< fs::path > _fixture_directory;
+
+    /// Whether the test must not run because its fixture is broken.
+    const bool _fixture_failed;
+
     /// Verifies if the test case needs to be skipped or not.
     ///
     /// We could very well run this on the scheduler parent process before
@@ -410,15 +815,23 @@ public:
     /// \param test_program Test program to execute.
     /// \param test_case_name Name of the test case to execute.
     /// \param user_config User-provided configuration variables.
+    /// \param fixture_directory Directory holding the fixture of the test
+    ///     program, if any.
+    /// \param fixture_failed Whether the fixture of the test program is
+    ///     broken, in which case the test is not run.
     run_test_program(
         const std::shared_ptr< scheduler::interface > interface,
         const model::test_program_ptr test_program,
         const std::string& test_case_name,
-        const config::tree& user_config) :
+        const config::tree& user_config,
+        const optional< fs::path >& fixture_directory,
+        const bool fixture_failed) :
         _interface(interface),
         _test_program(force_absolute_paths(*test_program)),
         _test_case_name(test_case_name),
-        _user_config(user_config)
+        _user_config(user_config),
+        _fixture_directory(fixture_directory),
+        _fixture_failed(fixture_failed)
     {
     }
 
@@ -431,15 +844,23 @@ public:
     {
         const model::test_case& test_case = _test_program.find(
             _test_case_name);
-        if (test_case.fake_result())
+        if (test_case.fake_result() || _fixture_failed)
             ::_exit(EXIT_SUCCESS);
 
         do_requirements_check(control_directory / skipped_cookie);
 
+        if (_fixture_directory)
+            utils::setenv(scheduler::fixture_directory_variable,
+                          _fixture_directory.get().str());
+
         const config::properties_map vars = scheduler::generate_config(
             _user_config, _test_program.test_suite_name());
+        const process::args_vector wrapper = engine::exec_wrapper(
+            _user_config, _test_program.test_suite_name(), control_directory);
+        process::limit_resources(compute_resource_limits(
+            test_case.get_metadata(), _user_config, !wrapper.empty()));
         _interface->exec_test(_test_program, _test_case_name, vars,
-                              control_directory);
+                              control_directory, wrapper);
     }
 };
 
@@ -500,12 +921,62 @@ public:
 std::shared_ptr< scheduler::interface >
 find_interface(const std::string& name)
 {
+    load_interfaces();
     const interfaces_map::const_iterator iter = interfaces.find(name);
     PRE(interfaces.find(name) != interfaces.end());
     return (*iter).second;
 }
 
 
+/// Loads the test cases of a test program from its manifest.
+///
+/// The manifest is a file generated at build time that contains the list of
+/// test cases in the same format as the list operation of ATF test programs.
+/// Using it saves running the test program to query its test cases, which is
+/// the bulk of the cost of loading a test suite.
+///
+/// \param test_program The test program whose manifest to load.
+///
+/// \return The loaded list of test cases, or none if the test program has no
+/// manifest or if it cannot be used, in which case the caller has to list the
+/// test cases by running the test program.
+static optional< model::test_cases_map >
+load_manifest(const model::test_program& test_program)
+{
+    const std::string manifest_name = test_program.get_metadata().manifest();
+    if (manifest_name.empty())
+        return none;
+
+    const fs::path binary = test_program.absolute_path();
+    fs::path manifest(manifest_name);
+    if (!manifest.is_absolute())
+        manifest = binary.branch_path() / manifest;
+
+    try {
+        // A manifest generated right after its binary has the same
+        // modification time on file systems with coarse timestamps.
+        if (fs::modification_time(manifest) <
+            fs::modification_time(binary)) {
+            LI(F("Ignoring manifest %s because it is older than %s") %
+               manifest % binary);
+            return none;
+        }
+
+        std::ifstream input(manifest.c_str());
+        if (!input)
+            throw engine::load_error(manifest, "Cannot open file for read");
+        const model::test_cases_map test_cases = engine::parse_atf_list(input);
+        LD(F("Loaded %s test cases from manifest %s") % test_cases.size() %
+           manifest);
+        return utils::make_optional(test_cases);
+    } catch (const std::runtime_error& e) {
+        LW(F("Cannot use manifest %s; listing test cases from %s instead: "
+             "%s") % manifest % binary % e.what());
+        return none;
+    }
+}
+
+
 }  // anonymous namespace
 
 
@@ -573,7 +1044,7 @@ scheduler::lazy_test_program::lazy_test_program(
 }
 
 
-/// Gets or loads the list of test cases from the test program.
+/// Gets or loads the list of test cases from the test program or its manifest.
 ///
 /// \return The list of test cases provided by the test program.
 const model::test_cases_map&
@@ -582,8 +1053,10 @@ scheduler::lazy_test_program::test_cases(void) const
     _pimpl->_scheduler_handle.check_interrupt();
 
     if (!_pimpl->_loaded) {
-        const model::test_cases_map tcs = _pimpl->_scheduler_handle.list_tests(
-            this, _pimpl->_user_config);
+        heap_stats::scoped_phase phase(heap_stats::phase_list);
+        const optional< model::test_cases_map > manifest = load_manifest(*this);
+        const model::test_cases_map tcs = manifest ? manifest.get() :
+            _pimpl->_scheduler_handle.list_tests(this, _pimpl->_user_config);
 
         // Due to the restrictions on when set_test_cases() may be called (as a
         // way to lazily initialize the test cases list before it is ever
@@ -724,6 +1197,30 @@ scheduler::result_handle::stderr_file(void) const
 }
 
 
+/// Returns the CPU time consumed by the test.
+///
+/// \return The user and system CPU time, or none if unknown (e.g. because the
+/// test timed out and was killed).
+optional< datetime::delta >
+scheduler::result_handle::cpu_time(void) const
+{
+    const optional< process::status >& status = _pbimpl->generic.status();
+    return status ? status.get().cpu_time() : none;
+}
+
+
+/// Returns the peak resident memory used by the test.
+///
+/// \return The maximum resident set size, or none if unknown (e.g. because
+/// the test timed out and was killed).
+optional< units::bytes >
+scheduler::result_handle::max_rss(void) const
+{
+    const optional< process::status >& status = _pbimpl->generic.status();
+    return status ? status.get().max_rss() : none;
+}
+
+
 /// Internal implementation for the test_result_handle class.
 struct engine::scheduler::test_result_handle::impl : utils::noncopyable {
     /// Test program data for this test case.
@@ -735,17 +1232,24 @@ struct engine::scheduler::test_result_handle::impl : utils::noncopyable {
     /// The actual result of the test execution.
     const model::test_result test_result;
 
+    /// The files generated by the execution wrapper of the test.
+    const std::map< std::string, fs::path > wrapper_files;
+
     /// Constructor.
     ///
     /// \param test_program_ Test program data for this test case.
     /// \param test_case_name_ Name of the test case.
     /// \param test_result_ The actual result of the test execution.
+    /// \param wrapper_files_ The files generated by the execution wrapper of
+    ///     the test.
     impl(const model::test_program_ptr test_program_,
          const std::string& test_case_name_,
-         const model::test_result& test_result_) :
+         const model::test_result& test_result_,
+         const std::map< std::string, fs::path >& wrapper_files_) :
         test_program(test_program_),
         test_case_name(test_case_name_),
-        test_result(test_result_)
+        test_result(test_result_),
+        wrapper_files(wrapper_files_)
     {
     }
 };
@@ -798,6 +1302,77 @@ scheduler::test_result_handle::test_result(void) const
 }
 
 
+/// Returns the files generated by the execution wrapper of the test.
+///
+/// Only the files declared by the wrapper that were actually created are
+/// returned.  See engine::exec_wrapper_files() for details.
+///
+/// \return A mapping of file names to the paths of the files, which exist
+/// until cleanup() is called.
+const std::map< std::string, fs::path >&
+scheduler::test_result_handle::wrapper_files(void) const
+{
+    return _pimpl->wrapper_files;
+}
+
+
+/// Internal implementation for the fixture_result_handle class.
+struct engine::scheduler::fixture_result_handle::impl : utils::noncopyable {
+    /// The test program owning the fixture.
+    model::test_program_ptr test_program;
+
+    /// If not none, the reason why the setup command failed.
+    const optional< std::string > error;
+
+    /// Constructor.
+    ///
+    /// \param test_program_ The test program owning the fixture.
+    /// \param error_ If not none, the reason why the setup command failed.
+    impl(const model::test_program_ptr test_program_,
+         const optional< std::string >& error_) :
+        test_program(test_program_), error(error_)
+    {
+    }
+};
+
+
+/// Constructor.
+///
+/// \param pbimpl Constructed internal implementation for the base object.
+/// \param pimpl Constructed internal implementation.
+scheduler::fixture_result_handle::fixture_result_handle(
+    std::shared_ptr< bimpl > pbimpl, std::shared_ptr< impl > pimpl) :
+    result_handle(pbimpl), _pimpl(pimpl)
+{
+}
+
+
+/// Destructor.
+scheduler::fixture_result_handle::~fixture_result_handle(void)
+{
+}
+
+
+/// Returns the test program whose fixture was set up.
+///
+/// \return A test program.
+const model::test_program_ptr
+scheduler::fixture_result_handle::test_program(void) const
+{
+    return _pimpl->test_program;
+}
+
+
+/// Returns the reason why the setup command failed, if it did.
+///
+/// \return A failure description, or none if the fixture is usable.
+const optional< std::string >&
+scheduler::fixture_result_handle::error(void) const
+{
+    return _pimpl->error;
+}
+
+
 /// Internal implementation for the scheduler_handle.
 struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
     /// Generic executor instance encapsulated by this one.
@@ -806,11 +1381,20 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
     /// Mapping of exec handles to the data required at run time.
     exec_data_map all_exec_data;
 
+    /// Fixtures of the test programs that are currently set up.
+    fixtures_map fixtures;
+
+    /// Sequence number to name the next fixture directory.
+    unsigned int next_fixture_id;
+
+    /// Work templates already validated during this run.
+    work_templates_map work_templates;
+
     /// Collection of test_exec_data objects.
     typedef std::vector< const test_exec_data* > test_exec_data_vector;
 
     /// Constructor.
-    impl(void) : generic(executor::setup())
+    impl(void) : generic(executor::setup()), next_fixture_id(0)
     {
     }
 
@@ -835,6 +1419,142 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
                    % test_data->test_case_name);
             }
         }
+
+        try {
+            teardown_all_fixtures();
+        } catch (const std::runtime_error& e) {
+            LW(F("Failed to tear down fixtures on abrupt termination: %s") %
+               e.what());
+        }
+    }
+
+    /// Spawns the setup or teardown command of a test program.
+    ///
+    /// \param fixture The fixture to operate on.
+    /// \param command The command line to execute.
+    /// \param what Name of the operation, for reporting purposes.
+    ///
+    /// \return The handle of the spawned command.
+    executor::exec_handle
+    spawn_fixture(const fixture_data& fixture, const std::string& command,
+                  const char* what)
+    {
+        const model::test_program_ptr test_program = fixture.test_program;
+
+        LI(F("Running %s of %s: %s") % what % test_program->absolute_path() %
+           command);
+
+        optional< passwd::user > unprivileged_user;
+        if (fixture.user_config.is_set("unprivileged_user") &&
+            test_program->get_metadata().required_user() == "unprivileged") {
+            unprivileged_user = fixture.user_config.lookup< engine::user_node >(
+                "unprivileged_user");
+        }
+
+        return generic.spawn(
+            run_fixture_command(
+                parse_fixture_command(
+                    command, test_program->absolute_path().branch_path()),
+                fixture.directory),
+            test_program->get_metadata().timeout(), unprivileged_user);
+    }
+
+    /// Computes the outcome of a setup or teardown command.
+    ///
+    /// \param test_program The test program owning the fixture.
+    /// \param exit_handle The exit handle of the command.
+    /// \param what Name of the operation, for reporting purposes.
+    ///
+    /// \return None if the command succeeded; otherwise, a description of the
+    /// failure.
+    static optional< std::string >
+    fixture_error(const model::test_program_ptr test_program,
+                  const executor::exit_handle& exit_handle, const char* what)
+    {
+        optional< std::string > error;
+        const optional< process::status >& status = exit_handle.status();
+        if (!status) {
+            error = F("Test program %s timed out") % what;
+        } else if (status.get().exited()) {
+            if (status.get().exitstatus() != EXIT_SUCCESS)
+                error = F("Test program %s returned non-success exit status "
+                          "%s") % what % status.get().exitstatus();
+        } else {
+            error = F("Test program %s received signal %s") % what %
+                status.get().termsig();
+        }
+        if (error) {
+            LW(F("%s for %s; stderr was: %s") % error.get() %
+               test_program->absolute_path() %
+               read_fixture_stderr(exit_handle.stderr_file()));
+        }
+        return error;
+    }
+
+    /// Tears down the fixture of a test program and forgets about it.
+    ///
+    /// \param iter Iterator to the fixture within the fixtures collection.
+    ///     Invalidated by this call.
+    void
+    teardown(fixtures_map::iterator iter)
+    {
+        const fixture_data fixture = (*iter).second;
+        fixtures.erase(iter);
+
+        set_tree_writable(fixture.directory, true);
+
+        // Mirror what test frameworks do at the test case level: if the
+        // setup did not complete successfully, there is nothing to tear down.
+        const std::string command = fixture.test_program->get_metadata()
+            .teardown();
+        if (fixture.ready && !fixture.error && !command.empty()) {
+            executor::exit_handle exit_handle = generic.wait(
+                spawn_fixture(fixture, command, "teardown"));
+            (void)fixture_error(fixture.test_program, exit_handle, "teardown");
+            exit_handle.cleanup();
+        }
+
+        try {
+            fs::rm_r(fixture.directory);
+        } catch (const fs::error& e) {
+            LW(F("Failed to remove fixture directory %s: %s") %
+               fixture.directory % e.what());
+        }
+    }
+
+    /// Tears down all the fixtures that are still set up.
+    void
+    teardown_all_fixtures(void)
+    {
+        while (!fixtures.empty())
+            teardown(fixtures.begin());
+    }
+
+    /// Validates a work template, only once per run.
+    ///
+    /// Templates are meant to be large and shared by many test cases, so
+    /// walking them for every test would defeat their purpose.
+    ///
+    /// \param directory The template directory to check.
+    ///
+    /// \return An error message if the template is unusable; none otherwise.
+    const optional< std::string >&
+    check_template(const fs::path& directory)
+    {
+        work_templates_map::const_iterator iter = work_templates.find(
+            directory);
+        if (iter == work_templates.end()) {
+            optional< std::string > error;
+            try {
+                check_work_template(directory);
+            } catch (const std::runtime_error& e) {
+                error = F("Invalid work template: %s") % e.what();
+                LW(error.get());
+            }
+            iter = work_templates.insert(
+                work_templates_map::value_type(directory, error)).first;
+        }
+        return (*iter).second;
     }
 
     /// Finds any pending exec_datas that correspond to tests needing cleanup.
@@ -880,8 +1600,8 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
 
         const executor::exec_handle cleanup_handle = spawn_cleanup(
             test_data->test_program, test_data->test_case_name,
-            test_data->user_config, test_data->exit_handle.get(),
-            result);
+            test_data->user_config, test_data->wrapper_files,
+            test_data->exit_handle.get(), result);
         generic.wait(cleanup_handle);
     }
 
@@ -890,6 +1610,9 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
     /// \param test_program The container test program.
     /// \param test_case_name The name of the test case to run.
     /// \param user_config User-provided configuration variables.
+    /// \param wrapper_files Names of the files generated by the execution
+    ///     wrapper of the test case's corresponding body, as computed when the
+    ///     body was spawned.
     /// \param body_handle The exit handle of the test case's corresponding
     ///     body.  The cleanup will be executed in the same context.
     /// \param body_result The result of the test case's corresponding body.
@@ -900,6 +1623,7 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
     spawn_cleanup(const model::test_program_ptr test_program,
                   const std::string& test_case_name,
                   const config::tree& user_config,
+                  const std::set< std::string >& wrapper_files,
                   const executor::exit_handle& body_handle,
                   const model::test_result& body_result)
     {
@@ -917,7 +1641,8 @@ struct engine::scheduler::scheduler_handle::impl : utils::noncopyable {
             body_handle, cleanup_timeout);
 
         const exec_data_ptr data(new cleanup_exec_data(
-            test_program, test_case_name, body_handle, body_result));
+            test_program, test_case_name, wrapper_files, body_handle,
+            body_result));
         LD(F("Inserting %s into all_exec_data (cleanup)") % handle.pid());
         INV_MSG(all_exec_data.find(handle.pid()) == all_exec_data.end(),
                 F("PID %s already in all_exec_data; not properly cleaned "
@@ -951,6 +1676,17 @@ scheduler::scheduler_handle::root_work_directory(void) const
 }
 
 
+/// Deletes the work directories left behind by dead instances of Kyua.
+///
+/// This is just a wrapper over executor_handle::reclaim_orphans(); see its
+/// documentation for details.
+void
+scheduler::scheduler_handle::reclaim_orphans(void)
+{
+    _pimpl->generic.reclaim_orphans();
+}
+
+
 /// Cleans up the scheduler state.
 ///
 /// This function should be called explicitly as it provides the means to
@@ -961,6 +1697,7 @@ scheduler::scheduler_handle::root_work_directory(void) const
 void
 scheduler::scheduler_handle::cleanup(void)
 {
+    _pimpl->teardown_all_fixtures();
     _pimpl->generic.cleanup();
 }
 
@@ -973,6 +1710,7 @@ scheduler::scheduler_handle::cleanup(void)
 void
 scheduler::ensure_valid_interface(const std::string& name)
 {
+    load_interfaces();
     if (interfaces.find(name) == interfaces.end())
         throw engine::error(F("Unsupported test interface '%s'") % name);
 }
@@ -991,12 +1729,30 @@ scheduler::register_interface(const std::string& name,
 }
 
 
+/// Registers a function to register interfaces on first use.
+///
+/// Instantiating the interfaces has a cost that programs running commands that
+/// never execute tests should not pay.  The loader runs the first time that
+/// the interfaces are needed, which is at the latest when the scheduler is set
+/// up, and then never again.
+///
+/// \param loader Function that calls register_interface() for all the
+///     interfaces to support.
+void
+scheduler::register_interfaces_loader(
+    const std::function< void (void) >& loader)
+{
+    interfaces_loader = loader;
+}
+
+
 /// Returns the names of all registered interfaces.
 ///
 /// \return A collection of interface names.
 std::set< std::string >
 scheduler::registered_interface_names(void)
 {
+    load_interfaces();
     std::set< std::string > names;
     for (interfaces_map::const_iterator iter = interfaces.begin();
          iter != interfaces.end(); ++iter) {
@@ -1015,6 +1771,7 @@ scheduler::registered_interface_names(void)
 scheduler::scheduler_handle
 scheduler::setup(void)
 {
+    load_interfaces();
     return scheduler_handle();
 }
 
@@ -1108,14 +1865,68 @@ scheduler::scheduler_handle::spawn_test(
             "unprivileged_user");
     }
 
-    const executor::exec_handle handle = _pimpl->generic.spawn(
-        run_test_program(interface, test_program, test_case_name,
-                         user_config),
-        test_case.get_metadata().timeout(),
-        unprivileged_user);
+    optional< fs::path > fixture_directory;
+    optional< model::test_result > fixture_result;
+    const fixtures_map::const_iterator fixture = _pimpl->fixtures.find(
+        test_program->absolute_path());
+    if (fixture != _pimpl->fixtures.end()) {
+        PRE_MSG((*fixture).second.ready,
+                F("Fixture for %s still being set up") %
+                test_program->absolute_path());
+        if ((*fixture).second.error)
+            fixture_result = model::test_result(
+                model::test_result_broken, (*fixture).second.error.get());
+        else
+            fixture_directory = (*fixture).second.directory;
+    }
+
+    optional< fs::path > work_template;
+    const std::string template_name =
+        test_program->get_metadata().work_template();
+    if (!template_name.empty() && !fixture_result) {
+        fs::path directory(template_name);
+        if (!directory.is_absolute())
+            directory = test_program->absolute_path().branch_path() /
+                directory;
+        const optional< std::string >& error = _pimpl->check_template(
+            directory);
+        if (error)
+            fixture_result = model::test_result(model::test_result_broken,
+                                                error.get());
+        else
+            work_template = directory;
+    }
+
+    optional< executor::exec_handle > spawned;
+    if (work_template) {
+        try {
+            spawned = _pimpl->generic.spawn(
+                run_test_program(interface, test_program, test_case_name,
+                                 user_config, fixture_directory, false),
+                test_case.get_metadata().timeout(),
+                unprivileged_user, none, none, work_template);
+        } catch (const fs::error& e) {
+            // The template passed validation but may have changed since, or
+            // the copy may have run into a transient problem like a full disk.
+            // Only this test case is affected.
+            fixture_result = model::test_result(
+                model::test_result_broken,
+                F("Cannot populate work directory from template %s: %s") %
+                work_template.get() % e.what());
+        }
+    }
+    if (!spawned) {
+        spawned = _pimpl->generic.spawn(
+            run_test_program(interface, test_program, test_case_name,
+                             user_config, fixture_directory,
+                             static_cast< bool >(fixture_result)),
+            test_case.get_metadata().timeout(), unprivileged_user);
+    }
+    const executor::exec_handle handle = spawned.get();
 
     const exec_data_ptr data(new test_exec_data(
-        test_program, test_case_name, interface, user_config));
+        test_program, test_case_name, interface, user_config,
+        fixture_result));
     LD(F("Inserting %s into all_exec_data") % handle.pid());
     INV_MSG(
         _pimpl->all_exec_data.find(handle.pid()) == _pimpl->all_exec_data.end(),
@@ -1127,25 +1938,44 @@ scheduler::scheduler_handle::spawn_test(
 }
 
 
-/// Waits for completion of any forked test case.
+/// Processes the termination of a subprocess spawned by the scheduler.
 ///
 /// Note that if the terminated test case has a cleanup routine, this function
 /// is the one in charge of spawning the cleanup routine asynchronously.
 ///
-/// \return The result of the execution of a subprocess.  This is a dynamically
-/// allocated object because the scheduler can spawn subprocesses of various
-/// types and, at wait time, we don't know upfront what we are going to get.
+/// \param handle The exit handle of the terminated subprocess.
+///
+/// \return The result of the execution of the subprocess, or an empty pointer
+/// if the caller must not know about the termination of the subprocess because
+/// it was handled internally.
 scheduler::result_handle_ptr
-scheduler::scheduler_handle::wait_any(void)
+scheduler::scheduler_handle::process_exit(executor::exit_handle handle)
 {
-    _pimpl->generic.check_interrupt();
-
-    executor::exit_handle handle = _pimpl->generic.wait_any();
-
     const exec_data_map::iterator iter = _pimpl->all_exec_data.find(
         handle.original_pid());
     exec_data_ptr data = (*iter).second;
 
+    if (dynamic_cast< const fixture_exec_data* >(data.get()) != NULL) {
+        LD(F("Got %s from all_exec_data (fixture)") % handle.original_pid());
+
+        const fixtures_map::iterator fixture = _pimpl->fixtures.find(
+            data->test_program->absolute_path());
+        INV(fixture != _pimpl->fixtures.end());
+        fixture_data& setup = (*fixture).second;
+        setup.error = impl::fixture_error(setup.test_program, handle, "setup");
+        setup.ready = true;
+        if (!setup.error)
+            set_tree_writable(setup.directory, false);
+
+        std::shared_ptr< result_handle::bimpl > result_handle_bimpl(
+            new result_handle::bimpl(handle, _pimpl->all_exec_data));
+        std::shared_ptr< fixture_result_handle::impl >
+            fixture_result_handle_impl(new fixture_result_handle::impl(
+                setup.test_program, setup.error));
+        return result_handle_ptr(new fixture_result_handle(
+            result_handle_bimpl, fixture_result_handle_impl));
+    }
+
     utils::dump_stacktrace_if_available(data->test_program->absolute_path(),
                                         _pimpl->generic, handle);
 
@@ -1161,6 +1991,8 @@ scheduler::scheduler_handle::wait_any(void)
             test_data->test_case_name);
 
         result = test_case.fake_result();
+        if (!result)
+            result = test_data->fixture_result;
 
         if (!result && handle.status() && handle.status().get().exited() &&
             handle.status().get().exitstatus() == exit_skipped) {
@@ -1187,6 +2019,8 @@ scheduler::scheduler_handle::wait_any(void)
                 test_data->needs_cleanup = false;
             }
         }
+        if (!result && resource_limits_enabled(test_data->user_config))
+            result = resource_limit_result(handle.status());
         if (!result) {
             result = test_data->interface->compute_result(
                 handle.status(),
@@ -1208,15 +2042,11 @@ scheduler::scheduler_handle::wait_any(void)
             // completion.  The caller never knows about cleanup routines.
             _pimpl->spawn_cleanup(test_data->test_program,
                                   test_data->test_case_name,
-                                  test_data->user_config, handle, result.get());
+                                  test_data->user_config,
+                                  test_data->wrapper_files, handle,
+                                  result.get());
             test_data->needs_cleanup = false;
-
-            // TODO(jmmv): Chaining this call is ugly.  We'd be better off by
-            // looping over terminated processes until we got a result suitable
-            // for user consumption.  For the time being this is good enough and
-            // not a problem because the call chain won't get big: the majority
-            // of test cases do not have cleanup routines.
-            return wait_any();
+            return result_handle_ptr();
         }
     } catch (const std::bad_cast& e) {
         const cleanup_exec_data* cleanup_data =
@@ -1260,16 +2090,162 @@ scheduler::scheduler_handle::wait_any(void)
     }
     INV(result);
 
+    std::map< std::string, fs::path > wrapper_files;
+    for (std::set< std::string >::const_iterator
+             iter = data->wrapper_files.begin();
+         iter != data->wrapper_files.end(); ++iter) {
+        const fs::path file = handle.control_directory() / *iter;
+        if (fs::exists(file))
+            wrapper_files.insert(std::make_pair(*iter, file));
+    }
+
     std::shared_ptr< result_handle::bimpl > result_handle_bimpl(
         new result_handle::bimpl(handle, _pimpl->all_exec_data));
     std::shared_ptr< test_result_handle::impl > test_result_handle_impl(
         new test_result_handle::impl(
-            data->test_program, data->test_case_name, result.get()));
+            data->test_program, data->test_case_name, result.get(),
+            wrapper_files));
     return result_handle_ptr(new test_result_handle(result_handle_bimpl,
                                                     test_result_handle_impl));
 }
 
 
+/// Waits for completion of any forked test case.
+///
+/// \return The result of the execution of a subprocess.  This is a dynamically
+/// allocated object because the scheduler can spawn subprocesses of various
+/// types and, at wait time, we don't know upfront what we are going to get.
+scheduler::result_handle_ptr
+scheduler::scheduler_handle::wait_any(void)
+{
+    for (;;) {
+        _pimpl->generic.check_interrupt();
+        const result_handle_ptr result_handle = process_exit(
+            _pimpl->generic.wait_any());
+        if (result_handle)
+            return result_handle;
+    }
+}
+
+
+/// Checks for the completion of any forked test case without blocking.
+///
+/// \return The result of the execution of a subprocess, or an empty pointer if
+/// no test case has completed yet.
+scheduler::result_handle_ptr
+scheduler::scheduler_handle::try_wait_any(void)
+{
+    for (;;) {
+        _pimpl->generic.check_interrupt();
+        const optional< executor::exit_handle > handle =
+            _pimpl->generic.try_wait_any();
+        if (!handle)
+            return result_handle_ptr();
+        const result_handle_ptr result_handle = process_exit(handle.get());
+        if (result_handle)
+            return result_handle;
+    }
+}
+
+
+/// Sets up the fixture of a test program.
+///
+/// This creates a directory to hold the fixture and spawns the setup command
+/// of the test program, if any.  Once the setup command completes, wait_any()
+/// returns a fixture_result_handle for it; the caller must not spawn any test
+/// cases of the test program until then.  The directory is made read-only
+/// afterwards and is passed to all test cases of the test program through the
+/// fixture_directory_variable environment variable.
+///
+/// If the setup command fails, all test cases of the test program spawned
+/// later on are reported as broken without being run.
+///
+/// \pre The fixture of the test program is not yet set up.
+///
+/// \param test_program The test program to set up the fixture for.
+/// \param user_config User-provided configuration variables.
+///
+/// \return True if the fixture is ready for use; false if its setup command
+/// is running.
+///
+/// \throw engine::error If the fixture directory cannot be created.
+bool
+scheduler::scheduler_handle::setup_fixture(
+    const model::test_program_ptr test_program,
+    const config::tree& user_config)
+{
+    _pimpl->generic.check_interrupt();
+
+    const fs::path key = test_program->absolute_path();
+    PRE_MSG(_pimpl->fixtures.find(key) == _pimpl->fixtures.end(),
+            F("Fixture for %s already set up") % key);
+
+    fixture_data fixture(
+        test_program, user_config,
+        _pimpl->generic.root_work_directory() /
+        (F("fixture.%s") % _pimpl->next_fixture_id++).str());
+    try {
+        fs::mkdir(fixture.directory, 0755);
+        if (user_config.is_set("unprivileged_user") &&
+            test_program->get_metadata().required_user() == "unprivileged" &&
+            passwd::current_user().is_root()) {
+            const passwd::user& user = user_config.lookup< engine::user_node >(
+                "unprivileged_user");
+            if (::chown(fixture.directory.c_str(), user.uid, user.gid) == -1)
+                throw fs::system_error(F("Cannot change owner of %s") %
+                                       fixture.directory, errno);
+        }
+    } catch (const fs::error& e) {
+        throw engine::error(F("Failed to create fixture for %s: %s") % key %
+                            e.what());
+    }
+
+    const std::string command = test_program->get_metadata().setup();
+    if (command.empty()) {
+        fixture.ready = true;
+        set_tree_writable(fixture.directory, false);
+    } else {
+        const executor::exec_handle handle = _pimpl->spawn_fixture(
+            fixture, command, "setup");
+        LD(F("Inserting %s into all_exec_data (fixture)") % handle.pid());
+        INV_MSG(_pimpl->all_exec_data.find(handle.pid()) ==
+                _pimpl->all_exec_data.end(),
+                F("PID %s already in all_exec_data; not properly cleaned "
+                  "up or reused too fast") % handle.pid());
+        _pimpl->all_exec_data.insert(exec_data_map::value_type(
+            handle.pid(), exec_data_ptr(new fixture_exec_data(test_program))));
+    }
+
+    _pimpl->fixtures.insert(fixtures_map::value_type(key, fixture));
+    return fixture.ready;
+}
+
+
+/// Tears down the fixture of a test program.
+///
+/// This runs the teardown command of the test program, if any, synchronously
+/// and then deletes the fixture directory.  Failures are logged but otherwise
+/// ignored because the results of the test cases are already known.
+///
+/// \pre The fixture of the test program was set up with setup_fixture(), its
+/// setup command has completed and none of its test cases are running.
+///
+/// \param test_program The test program to tear down the fixture for.
+void
+scheduler::scheduler_handle::teardown_fixture(
+    const model::test_program_ptr test_program)
+{
+    const fixtures_map::iterator iter = _pimpl->fixtures.find(
+        test_program->absolute_path());
+    PRE_MSG(iter != _pimpl->fixtures.end(),
+            F("Fixture for %s not set up") % test_program->absolute_path());
+    PRE_MSG((*iter).second.ready,
+            F("Fixture for %s still being set up") %
+            test_program->absolute_path());
+    _pimpl->teardown(iter);
+}
+
+
 /// Forks and executes a test case synchronously for debugging.
 ///
 /// \pre No other processes should be in execution by the scheduler.
@@ -1332,6 +2308,19 @@ scheduler::scheduler_handle::check_interrupt(void) const
 }
 
 
+/// Checks whether a test program requires a fixture.
+///
+/// \param test_program The test program to check.
+///
+/// \return True if the test program defines a setup or a teardown command.
+bool
+scheduler::has_fixture(const model::test_program& test_program)
+{
+    const model::metadata& md = test_program.get_metadata();
+    return !md.setup().empty() || !md.teardown().empty();
+}
+
+
 /// Queries the current execution context.
 ///
 /// \return The queried context.
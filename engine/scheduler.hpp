@@ -57,6 +57,8 @@
 
 #include "engine/scheduler_fwd.hpp"
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -72,7 +74,9 @@
 #include "utils/fs/path_fwd.hpp"
 #include "utils/optional.hpp"
 #include "utils/process/executor_fwd.hpp"
+#include "utils/process/operations_fwd.hpp"
 #include "utils/process/status_fwd.hpp"
+#include "utils/units_fwd.hpp"
 
 namespace engine {
 namespace scheduler {
@@ -124,10 +128,13 @@ public:
     /// \param vars User-provided variables to pass to the test program.
     /// \param control_directory Directory where the interface may place control
     ///     files.
+    /// \param wrapper Command with which to wrap the execution of the test
+    ///     program, or an empty vector to run it directly.
     virtual void exec_test(const model::test_program& test_program,
                            const std::string& test_case_name,
                            const utils::config::properties_map& vars,
-                           const utils::fs::path& control_directory)
+                           const utils::fs::path& control_directory,
+                           const utils::process::args_vector& wrapper)
         const UTILS_NORETURN = 0;
 
     /// Executes a test cleanup routine of the test program.
@@ -207,6 +214,8 @@ public:
     utils::fs::path work_directory(void) const;
     const utils::fs::path& stdout_file(void) const;
     const utils::fs::path& stderr_file(void) const;
+    utils::optional< utils::datetime::delta > cpu_time(void) const;
+    utils::optional< utils::units::bytes > max_rss(void) const;
 };
 
 
@@ -225,6 +234,24 @@ public:
     const model::test_program_ptr test_program(void) const;
     const std::string& test_case_name(void) const;
     const model::test_result& test_result(void) const;
+    const std::map< std::string, utils::fs::path >& wrapper_files(void) const;
+};
+
+
+/// Container for the termination data of the setup command of a fixture.
+class fixture_result_handle : public result_handle {
+    struct impl;
+    /// Pointer to internal implementation.
+    std::shared_ptr< impl > _pimpl;
+
+    friend class scheduler_handle;
+    fixture_result_handle(std::shared_ptr< bimpl >, std::shared_ptr< impl >);
+
+public:
+    ~fixture_result_handle(void);
+
+    const model::test_program_ptr test_program(void) const;
+    const utils::optional< std::string >& error(void) const;
 };
 
 
@@ -235,13 +262,17 @@ class scheduler_handle {
     std::shared_ptr< impl > _pimpl;
 
     friend scheduler_handle setup(void);
+
     scheduler_handle(void);
 
+    result_handle_ptr process_exit(utils::process::executor::exit_handle);
+
 public:
     ~scheduler_handle(void);
 
     const utils::fs::path& root_work_directory(void) const;
 
+    void reclaim_orphans(void);
     void cleanup(void);
 
     model::test_cases_map list_tests(const model::test_program*,
@@ -250,6 +281,11 @@ public:
                            const std::string&,
                            const utils::config::tree&);
     result_handle_ptr wait_any(void);
+    result_handle_ptr try_wait_any(void);
+
+    bool setup_fixture(const model::test_program_ptr,
+                       const utils::config::tree&);
+    void teardown_fixture(const model::test_program_ptr);
 
     result_handle_ptr debug_test(const model::test_program_ptr,
                                  const std::string&,
@@ -263,13 +299,17 @@ public:
 
 extern utils::datetime::delta cleanup_timeout;
 extern utils::datetime::delta list_timeout;
+extern const char* const fixture_directory_variable;
 
 
 void ensure_valid_interface(const std::string&);
 void register_interface(const std::string&, const std::shared_ptr< interface >);
+void register_interfaces_loader(const std::function< void (void) >&);
 std::set< std::string > registered_interface_names(void);
 scheduler_handle setup(void);
 
+bool has_fixture(const model::test_program&);
+
 model::context current_context(void);
 utils::config::properties_map generate_config(const utils::config::tree&,
                                               const std::string&);
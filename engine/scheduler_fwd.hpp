@@ -47,6 +47,7 @@ typedef int exec_handle;
 
 class scheduler_handle;
 class interface;
+class fixture_result_handle;
 class result_handle;
 class test_result_handle;
 
@@ -30,6 +30,9 @@
 
 extern "C" {
 #include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 
 #include <signal.h>
 #include <unistd.h>
@@ -38,6 +41,7 @@ extern "C" {
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <string>
 
 #include <atf-c++.hpp>
@@ -59,6 +63,7 @@ extern "C" {
 #include "utils/fs/path.hpp"
 #include "utils/optional.ipp"
 #include "utils/passwd.hpp"
+#include "utils/process/operations.hpp"
 #include "utils/process/status.hpp"
 #include "utils/sanity.hpp"
 #include "utils/stacktrace.hpp"
@@ -66,6 +71,7 @@ extern "C" {
 #include "utils/test_utils.ipp"
 #include "utils/text/exceptions.hpp"
 #include "utils/text/operations.ipp"
+#include "utils/units.hpp"
 
 namespace config = utils::config;
 namespace datetime = utils::datetime;
@@ -74,6 +80,7 @@ namespace passwd = utils::passwd;
 namespace process = utils::process;
 namespace scheduler = engine::scheduler;
 namespace text = utils::text;
+namespace units = utils::units;
 
 using utils::none;
 using utils::optional;
@@ -166,6 +173,44 @@ class mock_interface : public scheduler::interface {
         do_exit(exit_code);
     }
 
+    /// Executes a test case that runs an external binary.
+    ///
+    /// The binary prints the value of the WRAPPED environment variable and
+    /// writes to the file named by the FILE environment variable, if any,
+    /// which allows checking the effects of execution wrappers.
+    ///
+    /// \param wrapper Command with which to wrap the execution of the binary.
+    void
+    exec_external(const process::args_vector& wrapper) const UTILS_NORETURN
+    {
+        process::args_vector args;
+        args.push_back("-c");
+        args.push_back("echo \"wrapped: ${WRAPPED}\"; "
+                       "[ -z \"${FILE}\" ] || echo data >\"${FILE}\"");
+        process::exec(fs::path("/bin/sh"), args, wrapper);
+    }
+
+    /// Executes a test case that prints the contents of the fixture.
+    void
+    exec_read_fixture(void) const UTILS_NORETURN
+    {
+        process::args_vector args;
+        args.push_back("-c");
+        args.push_back("cat \"${KYUA_FIXTURE_DIR}/data\"");
+        process::exec(fs::path("/bin/sh"), args);
+    }
+
+    /// Executes a test case that prints and modifies a file in its work
+    /// directory, as populated from a work template.
+    void
+    exec_read_work(void) const UTILS_NORETURN
+    {
+        process::args_vector args;
+        args.push_back("-c");
+        args.push_back("cat data && echo modified >data");
+        process::exec(fs::path("/bin/sh"), args);
+    }
+
     /// Executes a test case that returns a specific exit code.
     ///
     /// \param exit_code Exit status to terminate the program with.
@@ -175,6 +220,38 @@ class mock_interface : public scheduler::interface {
         do_exit(exit_code);
     }
 
+    /// Executes a test case that prints its data segment size limit.
+    void
+    exec_print_memory_limit(void) const UTILS_NORETURN
+    {
+        struct ::rlimit rl;
+        if (::getrlimit(RLIMIT_DATA, &rl) == -1)
+            do_exit(EXIT_FAILURE);
+        std::cout << rl.rlim_cur << '\n';
+        do_exit(EXIT_SUCCESS);
+    }
+
+    /// Executes a test case that creates a 64KB file in its work directory.
+    void
+    exec_write_big_file(void) const UTILS_NORETURN
+    {
+        std::ofstream output("big");
+        for (int i = 0; i < 64 * 1024; ++i)
+            output << 'x';
+        output.close();
+        do_exit(output ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    /// Executes a test case that prints 64KB to its stdout.
+    void
+    exec_print_big_output(void) const UTILS_NORETURN
+    {
+        for (int i = 0; i < 64 * 1024; ++i)
+            std::cout << 'x';
+        std::cout.flush();
+        do_exit(std::cout ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
     /// Executes a test case that just fails.
     void
     exec_fail(void) const UTILS_NORETURN
@@ -308,11 +385,14 @@ public:
     /// \param vars User-provided variables to pass to the test program.
     /// \param control_directory Directory where the interface may place control
     ///     files.
+    /// \param wrapper Command with which to wrap the execution of the test
+    ///     program, or an empty vector to run it directly.
     void
     exec_test(const model::test_program& test_program,
               const std::string& test_case_name,
               const config::properties_map& vars,
-              const fs::path& control_directory) const
+              const fs::path& control_directory,
+              const process::args_vector& wrapper) const
     {
         const fs::path cookie = control_directory / "exec_test_was_called";
         std::ofstream control_file(cookie.c_str());
@@ -333,6 +413,12 @@ public:
             exec_delete_all();
         } else if (starts_with(test_case_name, "exit ")) {
             exec_exit(suffix_to_int(test_case_name, "exit "));
+        } else if (test_case_name == "external") {
+            exec_external(wrapper);
+        } else if (starts_with(test_case_name, "read_fixture")) {
+            exec_read_fixture();
+        } else if (starts_with(test_case_name, "read_work")) {
+            exec_read_work();
         } else if (starts_with(test_case_name, "fail")) {
             exec_fail();
         } else if (starts_with(test_case_name, "fail_body_fail_cleanup")) {
@@ -341,10 +427,16 @@ public:
             exec_fail();
         } else if (starts_with(test_case_name, "pass_body_fail_cleanup")) {
             exec_exit(EXIT_SUCCESS);
+        } else if (test_case_name == "print_memory_limit") {
+            exec_print_memory_limit();
+        } else if (test_case_name == "print_big_output") {
+            exec_print_big_output();
         } else if (starts_with(test_case_name, "print_params")) {
             exec_print_params(test_program, test_case_name, vars);
         } else if (starts_with(test_case_name, "skip_body_pass_cleanup")) {
             exec_exit(EXIT_SUCCESS);
+        } else if (test_case_name == "write_big_file") {
+            exec_write_big_file();
         } else {
             std::cerr << "Unknown test case " << test_case_name << '\n';
             std::abort();
@@ -559,6 +651,121 @@ ATF_TEST_CASE_BODY(integration__list_empty)
 }
 
 
+/// Creates a test program with a manifest that lists its test cases.
+///
+/// The test program is check_i_exist, which lists a single test case named
+/// found when its test cases are queried by running it.
+///
+/// \param handle The scheduler to load the test cases with.
+/// \param contents The contents of the manifest.
+/// \param stale Whether to make the manifest older than the test program.
+///
+/// \return The lazy test program.  The test cases it yields reference its
+/// metadata, so it must be kept alive for as long as they are used.
+static model::test_program_ptr
+create_manifest_program(scheduler::scheduler_handle& handle,
+                        const std::string& contents, const bool stale)
+{
+    atf::utils::create_file("check_i_exist", "");
+    atf::utils::create_file("check_i_exist.tcs", contents);
+    if (stale) {
+        const struct ::timeval times[2] = { { 1, 0 }, { 1, 0 } };
+        ATF_REQUIRE(::utimes("check_i_exist.tcs", times) != -1);
+    }
+
+    return model::test_program_ptr(new scheduler::lazy_test_program(
+        "mock", fs::path("check_i_exist"), fs::current_path(), "the-suite",
+        model::metadata_builder().set_manifest("check_i_exist.tcs").build(),
+        engine::empty_config(), handle));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__list_manifest__ok);
+ATF_TEST_CASE_BODY(integration__list_manifest__ok)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+    const model::test_program_ptr program = create_manifest_program(
+        handle,
+        "Content-Type: application/X-atf-tp; version=\"1\"\n"
+        "\n"
+        "ident: first\n"
+        "\n"
+        "ident: second\n"
+        "timeout: 20\n", false);
+
+    const model::test_cases_map& test_cases = program->test_cases();
+    ATF_REQUIRE_EQ(2, test_cases.size());
+    ATF_REQUIRE(test_cases.find("first") != test_cases.end());
+    ATF_REQUIRE(datetime::delta(20, 0) ==
+                program->find("second").get_metadata().timeout());
+    ATF_REQUIRE_EQ("check_i_exist.tcs",
+                   program->find("first").get_metadata().manifest());
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__list_manifest__stale);
+ATF_TEST_CASE_BODY(integration__list_manifest__stale)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+    const model::test_program_ptr program = create_manifest_program(
+        handle,
+        "Content-Type: application/X-atf-tp; version=\"1\"\n"
+        "\n"
+        "ident: first\n", true);
+
+    const model::test_cases_map& test_cases = program->test_cases();
+    ATF_REQUIRE_EQ(1, test_cases.size());
+    ATF_REQUIRE(test_cases.find("found") != test_cases.end());
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__list_manifest__stale_subsecond);
+ATF_TEST_CASE_BODY(integration__list_manifest__stale_subsecond)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+    const model::test_program_ptr program = create_manifest_program(
+        handle,
+        "Content-Type: application/X-atf-tp; version=\"1\"\n"
+        "\n"
+        "ident: first\n", false);
+
+    const struct ::timeval binary_times[2] = { { 1000, 600000 },
+                                               { 1000, 600000 } };
+    ATF_REQUIRE(::utimes("check_i_exist", binary_times) != -1);
+    const struct ::timeval manifest_times[2] = { { 1000, 200000 },
+                                                 { 1000, 200000 } };
+    ATF_REQUIRE(::utimes("check_i_exist.tcs", manifest_times) != -1);
+    if (fs::modification_time(fs::path("check_i_exist")) ==
+        fs::modification_time(fs::path("check_i_exist.tcs")))
+        ATF_SKIP("The file system does not support sub-second timestamps");
+
+    const model::test_cases_map& test_cases = program->test_cases();
+    ATF_REQUIRE_EQ(1, test_cases.size());
+    ATF_REQUIRE(test_cases.find("found") != test_cases.end());
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__list_manifest__invalid);
+ATF_TEST_CASE_BODY(integration__list_manifest__invalid)
+{
+    scheduler::scheduler_handle handle = scheduler::setup();
+    const model::test_program_ptr program = create_manifest_program(
+        handle, "first\nsecond\n", false);
+
+    const model::test_cases_map& test_cases = program->test_cases();
+    ATF_REQUIRE_EQ(1, test_cases.size());
+    ATF_REQUIRE(test_cases.find("found") != test_cases.end());
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__run_one);
 ATF_TEST_CASE_BODY(integration__run_one)
 {
@@ -772,6 +979,381 @@ ATF_TEST_CASE_BODY(integration__parameters_and_output)
 }
 
 
+/// Runs a test case that executes an external binary and checks its output.
+///
+/// \param user_config The configuration to run the test case with.
+/// \param exp_stdout The expected contents of stdout.
+/// \param exp_wrapper_files The expected files generated by the execution
+///     wrapper of the test case, as a map of names to their contents.
+static void
+do_check_exec_wrapper(
+    const config::tree& user_config, const std::string& exp_stdout,
+    const std::map< std::string, std::string >& exp_wrapper_files)
+{
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("external").build_ptr();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    (void)handle.spawn_test(program, "external", user_config);
+
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    const scheduler::test_result_handle* test_result_handle =
+        dynamic_cast< const scheduler::test_result_handle* >(
+            result_handle.get());
+    ATF_REQUIRE_EQ(model::test_result(model::test_result_passed, "Exit 0"),
+                   test_result_handle->test_result());
+    ATF_REQUIRE(atf::utils::compare_file(
+        result_handle->stdout_file().str(), exp_stdout));
+
+    const std::map< std::string, fs::path >& wrapper_files =
+        test_result_handle->wrapper_files();
+    ATF_REQUIRE_EQ(exp_wrapper_files.size(), wrapper_files.size());
+    for (std::map< std::string, std::string >::const_iterator
+             iter = exp_wrapper_files.begin(); iter != exp_wrapper_files.end();
+         ++iter) {
+        const std::map< std::string, fs::path >::const_iterator file =
+            wrapper_files.find((*iter).first);
+        ATF_REQUIRE(file != wrapper_files.end());
+        ATF_REQUIRE(atf::utils::compare_file((*file).second.str(),
+                                             (*iter).second));
+    }
+
+    result_handle->cleanup();
+    result_handle.reset();
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__exec_wrapper__none);
+ATF_TEST_CASE_BODY(integration__exec_wrapper__none)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set_string("execution_wrappers.other-suite",
+                           "env WRAPPED=yes");
+
+    do_check_exec_wrapper(user_config, "wrapped: \n",
+                          std::map< std::string, std::string >());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__exec_wrapper__some);
+ATF_TEST_CASE_BODY(integration__exec_wrapper__some)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set_string(
+        "execution_wrappers.the-suite",
+        "env WRAPPED=yes FILE={control}/out.txt UNUSED={control}/unused.txt");
+
+    std::map< std::string, std::string > exp_wrapper_files;
+    exp_wrapper_files["out.txt"] = "data\n";
+    do_check_exec_wrapper(user_config, "wrapped: yes\n", exp_wrapper_files);
+}
+
+
+/// Creates a mock test program with a fixture.
+///
+/// The setup command stores its arguments in the fixture and the teardown
+/// command records its execution in the current directory.  If the first
+/// argument of the setup command is "wait", it does not complete until a file
+/// named "go" appears in the current directory.
+///
+/// \param setup_command The setup command to use, relative to the current
+///     directory.
+///
+/// \return The new test program.
+static model::test_program_ptr
+fixture_program(const std::string& setup_command)
+{
+    atf::utils::create_file("setup.sh",
+                            "#! /bin/sh\n"
+                            "echo \"fixture $*\" >data\n"
+                            "[ \"${1}\" != fail ] || exit 3\n"
+                            "[ \"${1}\" != wait ] || "
+                            "while [ ! -f \"$(dirname \"${0}\")/go\" ]; do\n"
+                            "    sleep 1\n"
+                            "done\n");
+    ATF_REQUIRE(::chmod("setup.sh", 0755) != -1);
+    atf::utils::create_file("teardown.sh",
+                            "#! /bin/sh\n"
+                            "cat data >\"$(dirname \"${0}\")/teardown.log\"\n");
+    ATF_REQUIRE(::chmod("teardown.sh", 0755) != -1);
+
+    return model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("read_fixture_1")
+        .add_test_case("read_fixture_2")
+        .set_metadata(model::metadata_builder()
+                      .set_setup(setup_command)
+                      .set_teardown((fs::current_path() / "teardown.sh").str())
+                      .build())
+        .build_ptr();
+}
+
+
+/// Waits for the completion of the setup command of a fixture.
+///
+/// \param handle The scheduler running the setup command.
+/// \param program The test program owning the fixture.
+///
+/// \return The reason why the setup command failed, if it did.
+static optional< std::string >
+wait_fixture(scheduler::scheduler_handle& handle,
+             const model::test_program_ptr program)
+{
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    const scheduler::fixture_result_handle* fixture_result_handle =
+        dynamic_cast< const scheduler::fixture_result_handle* >(
+            result_handle.get());
+    ATF_REQUIRE(fixture_result_handle != NULL);
+    ATF_REQUIRE_EQ(program, fixture_result_handle->test_program());
+    const optional< std::string > error = fixture_result_handle->error();
+    result_handle->cleanup();
+    return error;
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__fixture__ok);
+ATF_TEST_CASE_BODY(integration__fixture__ok)
+{
+    const model::test_program_ptr program = fixture_program("setup.sh a b");
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+    ATF_REQUIRE(!handle.setup_fixture(program, user_config));
+    ATF_REQUIRE(!wait_fixture(handle, program));
+
+    (void)handle.spawn_test(program, "read_fixture_1", user_config);
+    (void)handle.spawn_test(program, "read_fixture_2", user_config);
+    for (int i = 0; i < 2; ++i) {
+        scheduler::result_handle_ptr result_handle = handle.wait_any();
+        const scheduler::test_result_handle* test_result_handle =
+            dynamic_cast< const scheduler::test_result_handle* >(
+                result_handle.get());
+        ATF_REQUIRE_EQ(model::test_result(model::test_result_passed, "Exit 0"),
+                       test_result_handle->test_result());
+        ATF_REQUIRE(atf::utils::compare_file(
+            result_handle->stdout_file().str(), "fixture a b\n"));
+        result_handle->cleanup();
+    }
+    ATF_REQUIRE(!fs::exists(fs::path("teardown.log")));
+
+    handle.teardown_fixture(program);
+    ATF_REQUIRE(atf::utils::compare_file("teardown.log", "fixture a b\n"));
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__fixture__setup_fails);
+ATF_TEST_CASE_BODY(integration__fixture__setup_fails)
+{
+    const model::test_program_ptr program = fixture_program("setup.sh fail");
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+    ATF_REQUIRE(!handle.setup_fixture(program, user_config));
+    const optional< std::string > error = wait_fixture(handle, program);
+    ATF_REQUIRE(error);
+    ATF_REQUIRE_EQ("Test program setup returned non-success exit status 3",
+                   error.get());
+
+    (void)handle.spawn_test(program, "read_fixture_1", user_config);
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    const scheduler::test_result_handle* test_result_handle =
+        dynamic_cast< const scheduler::test_result_handle* >(
+            result_handle.get());
+    ATF_REQUIRE_EQ(model::test_result(
+                       model::test_result_broken,
+                       "Test program setup returned non-success exit "
+                       "status 3"),
+                   test_result_handle->test_result());
+    result_handle->cleanup();
+    result_handle.reset();
+
+    handle.teardown_fixture(program);
+    ATF_REQUIRE(!fs::exists(fs::path("teardown.log")));
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__fixture__cleanup);
+ATF_TEST_CASE_BODY(integration__fixture__cleanup)
+{
+    const model::test_program_ptr program = fixture_program("setup.sh x");
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+    ATF_REQUIRE(!handle.setup_fixture(program, user_config));
+    ATF_REQUIRE(!wait_fixture(handle, program));
+    handle.cleanup();
+
+    ATF_REQUIRE(atf::utils::compare_file("teardown.log", "fixture x\n"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__fixture__async);
+ATF_TEST_CASE_BODY(integration__fixture__async)
+{
+    const model::test_program_ptr program = fixture_program("setup.sh wait");
+    const model::test_program_ptr other = model::test_program_builder(
+        "mock", fs::path("the-other"), fs::current_path(), "the-suite")
+        .add_test_case("exit 0").build_ptr();
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+    ATF_REQUIRE(!handle.setup_fixture(program, user_config));
+
+    // Other test programs can run while the setup command is in progress.
+    const scheduler::exec_handle exec_handle = handle.spawn_test(
+        other, "exit 0", user_config);
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    ATF_REQUIRE_EQ(exec_handle, result_handle->original_pid());
+    result_handle->cleanup();
+    result_handle.reset();
+    ATF_REQUIRE(!handle.try_wait_any());
+
+    atf::utils::create_file("go", "");
+    ATF_REQUIRE(!wait_fixture(handle, program));
+
+    (void)handle.spawn_test(program, "read_fixture_1", user_config);
+    result_handle = handle.wait_any();
+    ATF_REQUIRE(atf::utils::compare_file(
+        result_handle->stdout_file().str(), "fixture wait\n"));
+    result_handle->cleanup();
+    result_handle.reset();
+
+    handle.teardown_fixture(program);
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__fixture__cleanup_during_setup);
+ATF_TEST_CASE_BODY(integration__fixture__cleanup_during_setup)
+{
+    const model::test_program_ptr program = fixture_program("setup.sh wait");
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+    ATF_REQUIRE(!handle.setup_fixture(program, user_config));
+    handle.cleanup();
+
+    ATF_REQUIRE(!fs::exists(fs::path("teardown.log")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__work_template__ok);
+ATF_TEST_CASE_BODY(integration__work_template__ok)
+{
+    fs::mkdir(fs::path("tree"), 0755);
+    atf::utils::create_file("tree/data", "template\n");
+
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("read_work_1")
+        .add_test_case("read_work_2")
+        .set_metadata(model::metadata_builder()
+                      .set_work_template("tree")
+                      .build())
+        .build_ptr();
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    (void)handle.spawn_test(program, "read_work_1", user_config);
+    (void)handle.spawn_test(program, "read_work_2", user_config);
+    for (int i = 0; i < 2; ++i) {
+        scheduler::result_handle_ptr result_handle = handle.wait_any();
+        const scheduler::test_result_handle* test_result_handle =
+            dynamic_cast< const scheduler::test_result_handle* >(
+                result_handle.get());
+        ATF_REQUIRE_EQ(model::test_result(model::test_result_passed, "Exit 0"),
+                       test_result_handle->test_result());
+        ATF_REQUIRE(atf::utils::compare_file(
+            result_handle->stdout_file().str(), "template\n"));
+        result_handle->cleanup();
+    }
+    ATF_REQUIRE(atf::utils::compare_file("tree/data", "template\n"));
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__work_template__invalid);
+ATF_TEST_CASE_BODY(integration__work_template__invalid)
+{
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("read_work")
+        .set_metadata(model::metadata_builder()
+                      .set_work_template("missing")
+                      .build())
+        .build_ptr();
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    (void)handle.spawn_test(program, "read_work", user_config);
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    const scheduler::test_result_handle* test_result_handle =
+        dynamic_cast< const scheduler::test_result_handle* >(
+            result_handle.get());
+    ATF_REQUIRE_EQ(model::test_result_broken,
+                   test_result_handle->test_result().type());
+    ATF_REQUIRE_MATCH("Invalid work template: .*/missing is not a directory",
+                      test_result_handle->test_result().reason());
+    ATF_REQUIRE(atf::utils::compare_file(
+        result_handle->stdout_file().str(), ""));
+    result_handle->cleanup();
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__work_template__copy_fails);
+ATF_TEST_CASE_BODY(integration__work_template__copy_fails)
+{
+    fs::mkdir(fs::path("tree"), 0755);
+    atf::utils::create_file("tree/data", "template\n");
+
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("read_work_1")
+        .add_test_case("read_work_2")
+        .set_metadata(model::metadata_builder()
+                      .set_work_template("tree")
+                      .build())
+        .build_ptr();
+    const config::tree user_config = engine::empty_config();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    (void)handle.spawn_test(program, "read_work_1", user_config);
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    result_handle->cleanup();
+
+    // The template was validated by the first spawn, so make it disappear to
+    // simulate a copy failure during the second one.
+    fs::rm_r(fs::path("tree"));
+
+    (void)handle.spawn_test(program, "read_work_2", user_config);
+    result_handle = handle.wait_any();
+    const scheduler::test_result_handle* test_result_handle =
+        dynamic_cast< const scheduler::test_result_handle* >(
+            result_handle.get());
+    ATF_REQUIRE_EQ(model::test_result_broken,
+                   test_result_handle->test_result().type());
+    ATF_REQUIRE_MATCH("Cannot populate work directory from template .*/tree",
+                      test_result_handle->test_result().reason());
+    result_handle->cleanup();
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__fake_result);
 ATF_TEST_CASE_BODY(integration__fake_result)
 {
@@ -954,6 +1536,182 @@ ATF_TEST_CASE_BODY(integration__check_requirements)
 }
 
 
+/// Runs a mock test case that writes 64KB with a small disk space requirement.
+///
+/// \param user_config User-provided configuration variables.
+/// \param test_case_name Name of the mock test case to run.
+///
+/// \return The result of the test case.
+static model::test_result
+run_big_writer(const config::tree& user_config,
+               const char* test_case_name = "write_big_file")
+{
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case(test_case_name)
+        .set_metadata(model::metadata_builder()
+                      .set_required_disk_space(units::bytes(4096)).build())
+        .build_ptr();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    (void)handle.spawn_test(program, test_case_name, user_config);
+
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    const scheduler::test_result_handle* test_result_handle =
+        dynamic_cast< const scheduler::test_result_handle* >(
+            result_handle.get());
+    const model::test_result result = test_result_handle->test_result();
+    result_handle->cleanup();
+    result_handle.reset();
+
+    handle.cleanup();
+    return result;
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__resource_limits__disabled);
+ATF_TEST_CASE_BODY(integration__resource_limits__disabled)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set_string("max_file_size", "4k");
+
+    ATF_REQUIRE_EQ(model::test_result(model::test_result_passed, "Exit 0"),
+                   run_big_writer(user_config));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__resource_limits__disk_space);
+ATF_TEST_CASE_BODY(integration__resource_limits__disk_space)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set< config::bool_node >("resource_limits", true);
+
+    ATF_REQUIRE_EQ(model::test_result(model::test_result_passed, "Exit 0"),
+                   run_big_writer(user_config));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__resource_limits__exceeded);
+ATF_TEST_CASE_BODY(integration__resource_limits__exceeded)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set< config::bool_node >("resource_limits", true);
+    user_config.set_string("max_file_size", "4k");
+
+    ATF_REQUIRE_EQ(model::test_result(
+                       model::test_result_broken,
+                       "Test case exceeded its file size limit "
+                       "(max_file_size), which also applies to its stdout "
+                       "and stderr"),
+                   run_big_writer(user_config));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__resource_limits__exceeded_output);
+ATF_TEST_CASE_BODY(integration__resource_limits__exceeded_output)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set< config::bool_node >("resource_limits", true);
+    user_config.set_string("max_file_size", "4k");
+
+    ATF_REQUIRE_EQ(model::test_result_broken,
+                   run_big_writer(user_config, "print_big_output").type());
+}
+
+
+/// Runs a test case that prints its memory limit.
+///
+/// \param user_config User-provided configuration variables.
+/// \param required_memory The memory required by the test case.
+///
+/// \return The printed limit.
+static std::string
+run_print_memory_limit(const config::tree& user_config,
+                       const units::bytes& required_memory)
+{
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("print_memory_limit")
+        .set_metadata(model::metadata_builder()
+                      .set_required_memory(required_memory)
+                      .build())
+        .build_ptr();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    (void)handle.spawn_test(program, "print_memory_limit", user_config);
+
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    const std::string limit = utils::read_file(result_handle->stdout_file());
+    result_handle->cleanup();
+    result_handle.reset();
+
+    handle.cleanup();
+    return limit;
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__resource_limits__memory);
+ATF_TEST_CASE_BODY(integration__resource_limits__memory)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set< config::bool_node >("resource_limits", true);
+
+    ATF_REQUIRE_EQ((F("%s\n") % (1024UL * 1024 * 1024)).str(),
+                   run_print_memory_limit(user_config,
+                                          units::bytes(512 * 1024 * 1024)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__resource_limits__memory_minimum);
+ATF_TEST_CASE_BODY(integration__resource_limits__memory_minimum)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set< config::bool_node >("resource_limits", true);
+
+    ATF_REQUIRE_EQ((F("%s\n") % (256UL * 1024 * 1024)).str(),
+                   run_print_memory_limit(user_config,
+                                          units::bytes(1024 * 1024)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__resource_limits__memory_wrapped);
+ATF_TEST_CASE_BODY(integration__resource_limits__memory_wrapped)
+{
+    config::tree user_config = engine::empty_config();
+    user_config.set< config::bool_node >("resource_limits", true);
+    user_config.set_string("execution_wrappers.the-suite", "valgrind");
+
+    ATF_REQUIRE(run_print_memory_limit(user_config,
+                                       units::bytes(512 * 1024 * 1024)) !=
+                (F("%s\n") % (1024UL * 1024 * 1024)).str());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__resource_usage);
+ATF_TEST_CASE_BODY(integration__resource_usage)
+{
+    const model::test_program_ptr program = model::test_program_builder(
+        "mock", fs::path("the-program"), fs::current_path(), "the-suite")
+        .add_test_case("write_big_file").build_ptr();
+
+    scheduler::scheduler_handle handle = scheduler::setup();
+
+    (void)handle.spawn_test(program, "write_big_file",
+                            engine::empty_config());
+
+    scheduler::result_handle_ptr result_handle = handle.wait_any();
+    ATF_REQUIRE(result_handle->cpu_time());
+    ATF_REQUIRE(result_handle->max_rss());
+    ATF_REQUIRE(result_handle->max_rss().get() > units::bytes(0));
+    result_handle->cleanup();
+    result_handle.reset();
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__stacktrace);
 ATF_TEST_CASE_BODY(integration__stacktrace)
 {
@@ -1142,6 +1900,45 @@ ATF_TEST_CASE_BODY(registered_interface_names)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(register_interfaces_loader);
+ATF_TEST_CASE_BODY(register_interfaces_loader)
+{
+    int calls = 0;
+    scheduler::register_interfaces_loader([&calls] {
+        ++calls;
+        scheduler::register_interface(
+            "mock2", std::shared_ptr< scheduler::interface >(
+                new mock_interface()));
+    });
+    ATF_REQUIRE_EQ(0, calls);
+
+    scheduler::ensure_valid_interface("mock2");
+    ATF_REQUIRE_EQ(1, calls);
+
+    std::set< std::string > exp_names;
+    exp_names.insert("mock");
+    exp_names.insert("mock2");
+    ATF_REQUIRE_EQ(exp_names, scheduler::registered_interface_names());
+    ATF_REQUIRE_EQ(1, calls);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(has_fixture);
+ATF_TEST_CASE_BODY(has_fixture)
+{
+    ATF_REQUIRE(!scheduler::has_fixture(model::test_program_builder(
+        "mock", fs::path("p"), fs::path("/root"), "s").build()));
+    ATF_REQUIRE(scheduler::has_fixture(model::test_program_builder(
+        "mock", fs::path("p"), fs::path("/root"), "s")
+        .set_metadata(model::metadata_builder().set_setup("a").build())
+        .build()));
+    ATF_REQUIRE(scheduler::has_fixture(model::test_program_builder(
+        "mock", fs::path("p"), fs::path("/root"), "s")
+        .set_metadata(model::metadata_builder().set_teardown("b").build())
+        .build()));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(current_context);
 ATF_TEST_CASE_BODY(current_context)
 {
@@ -1209,6 +2006,10 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, integration__list_timeout);
     ATF_ADD_TEST_CASE(tcs, integration__list_fail);
     ATF_ADD_TEST_CASE(tcs, integration__list_empty);
+    ATF_ADD_TEST_CASE(tcs, integration__list_manifest__ok);
+    ATF_ADD_TEST_CASE(tcs, integration__list_manifest__stale);
+    ATF_ADD_TEST_CASE(tcs, integration__list_manifest__stale_subsecond);
+    ATF_ADD_TEST_CASE(tcs, integration__list_manifest__invalid);
 
     ATF_ADD_TEST_CASE(tcs, integration__run_one);
     ATF_ADD_TEST_CASE(tcs, integration__run_many);
@@ -1216,6 +2017,16 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, integration__run_check_paths);
     ATF_ADD_TEST_CASE(tcs, integration__parameters_and_output);
 
+    ATF_ADD_TEST_CASE(tcs, integration__exec_wrapper__none);
+    ATF_ADD_TEST_CASE(tcs, integration__exec_wrapper__some);
+    ATF_ADD_TEST_CASE(tcs, integration__fixture__ok);
+    ATF_ADD_TEST_CASE(tcs, integration__fixture__setup_fails);
+    ATF_ADD_TEST_CASE(tcs, integration__fixture__cleanup);
+    ATF_ADD_TEST_CASE(tcs, integration__fixture__async);
+    ATF_ADD_TEST_CASE(tcs, integration__fixture__cleanup_during_setup);
+    ATF_ADD_TEST_CASE(tcs, integration__work_template__ok);
+    ATF_ADD_TEST_CASE(tcs, integration__work_template__invalid);
+    ATF_ADD_TEST_CASE(tcs, integration__work_template__copy_fails);
     ATF_ADD_TEST_CASE(tcs, integration__fake_result);
     ATF_ADD_TEST_CASE(tcs, integration__cleanup__head_skips);
     ATF_ADD_TEST_CASE(tcs, integration__cleanup__body_skips);
@@ -1224,6 +2035,14 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, integration__cleanup__body_bad__cleanup_bad);
     ATF_ADD_TEST_CASE(tcs, integration__cleanup__timeout);
     ATF_ADD_TEST_CASE(tcs, integration__check_requirements);
+    ATF_ADD_TEST_CASE(tcs, integration__resource_limits__disabled);
+    ATF_ADD_TEST_CASE(tcs, integration__resource_limits__disk_space);
+    ATF_ADD_TEST_CASE(tcs, integration__resource_limits__exceeded);
+    ATF_ADD_TEST_CASE(tcs, integration__resource_limits__exceeded_output);
+    ATF_ADD_TEST_CASE(tcs, integration__resource_limits__memory);
+    ATF_ADD_TEST_CASE(tcs, integration__resource_limits__memory_minimum);
+    ATF_ADD_TEST_CASE(tcs, integration__resource_limits__memory_wrapped);
+    ATF_ADD_TEST_CASE(tcs, integration__resource_usage);
     ATF_ADD_TEST_CASE(tcs, integration__stacktrace);
     ATF_ADD_TEST_CASE(tcs, integration__list_files_on_failure__none);
     ATF_ADD_TEST_CASE(tcs, integration__list_files_on_failure__some);
@@ -1233,6 +2052,9 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, ensure_valid_interface);
     ATF_ADD_TEST_CASE(tcs, registered_interface_names);
+    ATF_ADD_TEST_CASE(tcs, register_interfaces_loader);
+
+    ATF_ADD_TEST_CASE(tcs, has_fixture);
 
     ATF_ADD_TEST_CASE(tcs, current_context);
 
@@ -238,6 +238,14 @@ config_flag__explicit__bad_file_body() {
 }
 
 
+utils_test_case config_flag__explicit__unused
+config_flag__explicit__unused_body() {
+    touch custom
+    atf_check -s exit:0 -o ignore -e empty kyua --config=custom about
+    atf_check -s exit:0 -o ignore -e empty kyua --config=foo about
+}
+
+
 utils_test_case variable_flag__no_config
 variable_flag__no_config_body() {
     atf_check -s exit:0 \
@@ -346,6 +354,7 @@ atf_init_test_cases() {
     atf_add_test_case config_flag__explicit__disable
     atf_add_test_case config_flag__explicit__missing_file
     atf_add_test_case config_flag__explicit__bad_file
+    atf_add_test_case config_flag__explicit__unused
 
     atf_add_test_case variable_flag__no_config
     atf_add_test_case variable_flag__override_default_config
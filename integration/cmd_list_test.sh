@@ -539,6 +539,34 @@ EOF
 }
 
 
+utils_test_case manifest
+manifest_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="fresh", manifest="fresh.tcs"}
+atf_test_program{name="stale", manifest="stale.tcs"}
+EOF
+    utils_cp_helper bad_test_program fresh
+    utils_cp_helper bad_test_program stale
+    cat >fresh.tcs <<EOF
+Content-Type: application/X-atf-tp; version="1"
+
+ident: first
+
+ident: second
+EOF
+    cp fresh.tcs stale.tcs
+    touch -t 200001010000 stale.tcs
+
+    cat >expout <<EOF
+fresh:first
+fresh:second
+stale:__test_cases_list__
+EOF
+    atf_check -s exit:0 -o file:expout -e empty kyua list
+}
+
 utils_test_case missing_test_program
 missing_test_program_body() {
     cat >Kyuafile <<EOF
@@ -596,5 +624,6 @@ atf_init_test_cases() {
 
     atf_add_test_case bogus_kyuafile
     atf_add_test_case bogus_test_program
+    atf_add_test_case manifest
     atf_add_test_case missing_test_program
 }
@@ -359,6 +359,111 @@ EOF
 }
 
 
+utils_test_case grep__no_index
+grep__no_index_body() {
+    run_tests unused_mock dbfile_name
+
+    cat >experr <<EOF
+kyua: E: Results file $(cat dbfile_name) has no output index; run 'kyua db-index' first.
+EOF
+    atf_check -s exit:1 -o empty -e file:experr kyua report --grep=stderr
+}
+
+
+utils_test_case grep__db_index
+grep__db_index_body() {
+    run_tests unused_mock dbfile_name
+
+    atf_check -s exit:0 -o match:"Indexed 5 new entries" -e empty \
+        kyua db-index
+
+    cat >expout <<EOF
+===> Matches for 'stderr'
+simple_all_pass:pass (stderr): This is the [stderr] of pass
+simple_all_pass:skip (stderr): This is the [stderr] of skip
+===> Summary
+Results read from $(cat dbfile_name)
+Matches: 2 in 2 test cases
+EOF
+    atf_check -s exit:0 -o file:expout -e empty kyua report --grep=stderr
+
+    cat >expout <<EOF
+===> Matches for 'stdout'
+simple_all_pass:skip (stdout): This is the [stdout] of skip
+===> Summary
+Results read from $(cat dbfile_name)
+Matches: 1 in 1 test cases
+EOF
+    atf_check -s exit:0 -o file:expout -e empty kyua report --grep=stdout \
+        simple_all_pass:skip
+}
+
+
+utils_test_case grep__write_time
+grep__write_time_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="simple_all_pass"}
+EOF
+    utils_cp_helper simple_all_pass .
+    atf_check -s exit:0 -o save:stdout -e empty \
+        kyua -v index_output=true test
+    grep '^Results saved to ' stdout | cut -d ' ' -f 4 >dbfile_name
+
+    cat >expout <<EOF
+===> Matches for 'reason skipping'
+simple_all_pass:skip (reason): The [reason] for [skipping] is this
+===> Summary
+Results read from $(cat dbfile_name)
+Matches: 1 in 1 test cases
+EOF
+    atf_check -s exit:0 -o file:expout -e empty \
+        kyua report --grep='reason skipping'
+
+    atf_check -s exit:0 -o match:"Indexed 0 new entries" -e empty \
+        kyua db-index
+}
+
+
+utils_test_case grep__bad_query
+grep__bad_query_body() {
+    run_tests unused_mock dbfile_name
+    atf_check -s exit:0 -o ignore -e empty kyua db-index
+
+    atf_check -s exit:1 -o empty \
+        -e match:"kyua: E: Cannot search output for 'foo AND'" \
+        kyua report --grep='foo AND'
+}
+
+
+utils_test_case group_failures
+group_failures_body() {
+    utils_install_times_wrapper
+
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="first"}
+atf_test_program{name="second"}
+EOF
+    utils_cp_helper simple_some_fail first
+    utils_cp_helper simple_some_fail second
+    atf_check -s exit:1 -o save:stdout -e empty kyua test
+    grep '^Results saved to ' stdout | cut -d ' ' -f 4 >dbfile_name
+
+    cat >expout <<EOF
+===> Failed tests
+[2 test cases] first:fail  ->  failed: This fails on purpose  [S.UUUs]
+===> Summary
+Results read from $(cat dbfile_name)
+Test cases: 4 total, 0 skipped, 0 expected failures, 0 broken, 2 failed
+Total time: S.UUUs
+EOF
+    atf_check -s exit:0 -o file:expout -e empty kyua report --group-failures
+}
+
+
 atf_init_test_cases() {
     atf_add_test_case default_behavior__ok
     atf_add_test_case default_behavior__no_store
@@ -378,4 +483,11 @@ atf_init_test_cases() {
     atf_add_test_case results_filter__one
     atf_add_test_case results_filter__multiple_all_match
     atf_add_test_case results_filter__multiple_some_match
+
+    atf_add_test_case grep__no_index
+    atf_add_test_case grep__db_index
+    atf_add_test_case grep__write_time
+    atf_add_test_case grep__bad_query
+
+    atf_add_test_case group_failures
 }
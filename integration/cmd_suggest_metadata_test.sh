@@ -0,0 +1,108 @@
+# Copyright 2026 The Kyua Authors.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+# * Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimer in the
+#   documentation and/or other materials provided with the distribution.
+# * Neither the name of Google Inc. nor the names of its contributors
+#   may be used to endorse or promote products derived from this software
+#   without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+utils_test_case no_results
+no_results_body() {
+    atf_check -s exit:1 -o empty -e match:"No previous runs to analyze" \
+        kyua suggest-metadata
+}
+
+
+utils_test_case missing_results_file
+missing_results_file_body() {
+    atf_check -s exit:1 -o empty -e match:"Cannot find results" \
+        kyua suggest-metadata foo.db
+}
+
+
+utils_test_case invalid_options
+invalid_options_body() {
+    atf_check -s exit:3 -o empty -e match:"Invalid value 0 for --runs" \
+        kyua suggest-metadata --runs=0
+    atf_check -s exit:3 -o empty \
+        -e match:"Invalid value 0 for --timeout-factor" \
+        kyua suggest-metadata --timeout-factor=0
+    atf_check -s exit:3 -o empty \
+        -e match:"Invalid value -1 for --memory-headroom" \
+        kyua suggest-metadata --memory-headroom=-1
+}
+
+
+utils_test_case ignores_config
+ignores_config_body() {
+    mkdir "${HOME}/.kyua"
+    echo "this is not valid lua" >"${HOME}/.kyua/kyua.conf"
+
+    atf_check -s exit:1 -o empty -e match:"No previous runs to analyze" \
+        kyua suggest-metadata
+}
+
+
+utils_test_case not_enough_samples
+not_enough_samples_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="simple_all_pass"}
+EOF
+    utils_cp_helper simple_all_pass .
+    atf_check -s exit:0 -o ignore -e empty kyua test
+    atf_check -s exit:0 -o ignore -e empty kyua test
+
+    atf_check -s exit:0 -o empty -e empty kyua suggest-metadata
+}
+
+
+utils_test_case timeout
+timeout_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+atf_test_program{name="simple_all_pass"}
+EOF
+    utils_cp_helper simple_all_pass .
+    for i in 1 2 3; do
+        atf_check -s exit:0 -o ignore -e empty kyua test
+    done
+
+    atf_check -s exit:0 \
+        -o match:"simple_all_pass:pass: timeout = 1 \(current: 300\)" \
+        -e empty kyua suggest-metadata
+    atf_check -s exit:0 -o empty -e empty \
+        kyua suggest-metadata --min-samples=4
+}
+
+
+atf_init_test_cases() {
+    atf_add_test_case no_results
+    atf_add_test_case missing_results_file
+    atf_add_test_case invalid_options
+    atf_add_test_case ignores_config
+    atf_add_test_case not_enough_samples
+    atf_add_test_case timeout
+}
@@ -680,6 +680,91 @@ EOF
 }
 
 
+
+utils_test_case store_mode__staged
+store_mode__staged_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+atf_test_program{name="simple_some_fail", test_suite="integration"}
+EOF
+    utils_cp_helper simple_some_fail .
+
+    atf_check -s exit:1 -o match:"1/2 passed" -e empty \
+        kyua test --store-mode=staged --store-flush-interval=1 -r results.db
+
+    cat >expout <<EOF
+fail,failed
+pass,passed
+EOF
+    atf_check -s exit:0 -o file:expout -e empty \
+        kyua db-exec -r results.db --no-headers \
+        "SELECT test_cases.name, test_results.result_type " \
+        "FROM test_cases " \
+        "     JOIN test_results " \
+        "     ON test_cases.test_case_id = test_results.test_case_id " \
+        "ORDER BY test_cases.name"
+}
+
+
+utils_test_case store_mode__invalid
+store_mode__invalid_body() {
+    echo 'syntax(2)' >Kyuafile
+
+    atf_check -s exit:3 -o empty -e match:"Invalid store mode 'foo'" \
+        kyua test --store-mode=foo
+    atf_check -s exit:3 -o empty -e match:"Invalid flush interval 0" \
+        kyua test --store-mode=staged --store-flush-interval=0
+}
+
+
+utils_test_case time_budget__defer
+time_budget__defer_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="fast"}
+plain_test_program{name="slow"}
+EOF
+    echo 'exit 0' >fast
+    printf 'sleep 3\nexit 0\n' >slow
+    chmod +x fast slow
+
+    atf_check -s exit:0 -o match:"2/2 passed" -e empty kyua test
+    # Make sure the test programs do not look modified since the last run.
+    touch -t 200001010000 fast slow
+
+    atf_check -s exit:0 \
+        -o match:"fast:main  ->  passed" \
+        -o match:"slow:main  ->  skipped: Deferred: does not fit in the time budget" \
+        -e empty kyua test --time-budget=2s
+}
+
+
+utils_test_case time_budget__no_history
+time_budget__no_history_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="program"}
+EOF
+    echo 'exit 0' >program
+    chmod +x program
+
+    atf_check -s exit:0 -o match:"program:main  ->  passed" -e empty \
+        kyua test --time-budget=1s
+}
+
+
+utils_test_case time_budget__invalid
+time_budget__invalid_body() {
+    echo 'syntax(2)' >Kyuafile
+
+    for value in 0 10x -5m; do
+        atf_check -s exit:3 -o empty -e match:"Invalid time budget" \
+            kyua test --time-budget="${value}"
+    done
+}
+
 utils_test_case build_root_flag
 build_root_flag_body() {
     utils_install_stable_test_wrapper
@@ -854,6 +939,217 @@ EOF
 }
 
 
+utils_test_case fixture__ok
+fixture__ok_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="first", setup="setup.sh", teardown="teardown.sh"}
+plain_test_program{name="second", setup="setup.sh", teardown="teardown.sh"}
+EOF
+    cat >setup.sh <<EOF
+#! /bin/sh
+echo setup >>$(pwd)/log
+echo "fixture data" >data
+EOF
+    cat >teardown.sh <<EOF
+#! /bin/sh
+echo teardown >>$(pwd)/log
+EOF
+    cat >first <<EOF
+#! /bin/sh
+grep 'fixture data' "\${KYUA_FIXTURE_DIR}/data" >/dev/null
+EOF
+    cp first second
+    chmod +x setup.sh teardown.sh first second
+
+    atf_check -s exit:0 -o match:"2/2 passed" -e empty kyua test
+    cat >expout <<EOF
+setup
+teardown
+setup
+teardown
+EOF
+    atf_check -s exit:0 -o file:expout -e empty cat log
+}
+
+
+utils_test_case fixture__setup_fails
+fixture__setup_fails_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="program", setup="setup.sh", teardown="teardown.sh"}
+EOF
+    cat >setup.sh <<EOF
+#! /bin/sh
+exit 1
+EOF
+    cat >teardown.sh <<EOF
+#! /bin/sh
+touch $(pwd)/teardown-ran
+EOF
+    echo 'exit 0' >program
+    chmod +x setup.sh teardown.sh program
+
+    atf_check -s exit:1 \
+        -o match:"program:main  ->  broken: Test program setup returned" \
+        -e empty kyua test
+    [ ! -f teardown-ran ] || atf_fail 'Teardown run after a failed setup'
+}
+
+utils_test_case depends_on__order
+depends_on__order_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="second", depends_on={"first"}}
+plain_test_program{name="first"}
+EOF
+    cat >first <<EOF
+#! /bin/sh
+sleep 1
+echo first >>$(pwd)/log
+EOF
+    cat >second <<EOF
+#! /bin/sh
+echo second >>$(pwd)/log
+EOF
+    chmod +x first second
+
+    atf_check -s exit:0 -o match:"2/2 passed" -e empty \
+        kyua -v parallelism=2 test
+    cat >expout <<EOF
+first
+second
+EOF
+    atf_check -s exit:0 -o file:expout -e empty cat log
+}
+
+
+utils_test_case depends_on__failure
+depends_on__failure_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="first"}
+plain_test_program{name="second", depends_on="first"}
+plain_test_program{name="third", depends_on="second"}
+EOF
+    echo 'exit 1' >first
+    echo 'exit 0' >second
+    echo 'exit 0' >third
+    chmod +x first second third
+
+    atf_check -s exit:1 \
+        -o match:"second:main  ->  skipped: Dependency first did not pass" \
+        -o match:"third:main  ->  skipped: Dependency second did not pass" \
+        -e empty kyua test
+}
+
+
+utils_test_case depends_on__unknown
+depends_on__unknown_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="first", depends_on="missing"}
+EOF
+    echo 'exit 0' >first
+    chmod +x first
+
+    atf_check -s exit:2 -o empty \
+        -e match:"'first' depends on unknown test program 'missing'" kyua test
+}
+
+
+utils_test_case resource_class__caps
+resource_class__caps_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="io1", resource_class="io"}
+plain_test_program{name="io2", resource_class="io"}
+plain_test_program{name="cpu", resource_class="cpu"}
+EOF
+    for name in io1 io2 cpu; do
+        cat >${name} <<EOF
+#! /bin/sh
+echo "start ${name}" >>$(pwd)/log
+sleep 1
+echo "end ${name}" >>$(pwd)/log
+EOF
+        chmod +x ${name}
+    done
+
+    atf_check -s exit:0 -o match:"3/3 passed" -e empty \
+        kyua -v parallelism=2 -v max_io_tests=1 test
+    # The I/O-bound test programs never overlap, and the CPU-bound one runs
+    # alongside the first of them instead of waiting for both.
+    head -n 2 log | sort >first
+    atf_check -s exit:0 -o inline:"start cpu\nstart io1\n" -e empty cat first
+    sed -n '/end io1/,$p' log >after
+    atf_check -s exit:0 -o match:"start io2" -e empty cat after
+}
+
+
+utils_test_case resource_class__invalid
+resource_class__invalid_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="program", resource_class="disk"}
+EOF
+    echo 'exit 0' >program
+    chmod +x program
+
+    atf_check -s exit:2 -o empty -e match:"Invalid resource class" kyua test
+}
+
+
+utils_test_case recheck_failures
+recheck_failures_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="holder"}
+plain_test_program{name="victim"}
+plain_test_program{name="broken"}
+EOF
+    cat >holder <<EOF
+#! /bin/sh
+touch $(pwd)/lock
+sleep 2
+rm -f $(pwd)/lock
+EOF
+    cat >victim <<EOF
+#! /bin/sh
+sleep 1
+[ ! -f $(pwd)/lock ]
+EOF
+    cat >broken <<EOF
+#! /bin/sh
+exit 1
+EOF
+    chmod +x holder victim broken
+
+    atf_check -s exit:1 \
+        -o match:"victim:main  ->  passed  \[" \
+        -o not-match:"Interference" \
+        -o match:"broken:main  ->  failed" \
+        -e empty kyua -v parallelism=3 -v recheck_failures=true test
+
+    atf_check -s exit:0 -o save:stdout -e empty kyua report
+    atf_check -s exit:0 \
+        -o match:"===> Interference suspected" \
+        -o match:"victim:main  ->  failed: .* when run alongside" \
+        -o match:"alongside .*holder:main" \
+        -e empty cat stdout
+    sed -n '/===> Interference suspected/,/===> Summary/p' stdout >section
+    atf_check -s exit:1 -o empty -e empty grep broken section
+}
+
+
 utils_test_case no_test_program_match
 no_test_program_match_body() {
     utils_install_stable_test_wrapper
@@ -1047,6 +1343,11 @@ atf_init_test_cases() {
     atf_add_test_case results_file__ok
     atf_add_test_case results_file__fail
     atf_add_test_case results_file__reuse
+    atf_add_test_case store_mode__staged
+    atf_add_test_case store_mode__invalid
+    atf_add_test_case time_budget__defer
+    atf_add_test_case time_budget__no_history
+    atf_add_test_case time_budget__invalid
 
     atf_add_test_case build_root_flag
 
@@ -1056,6 +1357,14 @@ atf_init_test_cases() {
     atf_add_test_case interrupt
 
     atf_add_test_case exclusive_tests
+    atf_add_test_case fixture__ok
+    atf_add_test_case fixture__setup_fails
+    atf_add_test_case depends_on__order
+    atf_add_test_case depends_on__failure
+    atf_add_test_case depends_on__unknown
+    atf_add_test_case resource_class__caps
+    atf_add_test_case resource_class__invalid
+    atf_add_test_case recheck_failures
 
     atf_add_test_case no_test_program_match
     atf_add_test_case no_test_case_match
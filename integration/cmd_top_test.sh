@@ -0,0 +1,87 @@
+# Copyright 2026 The Kyua Authors.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+# * Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimer in the
+#   documentation and/or other materials provided with the distribution.
+# * Neither the name of Google Inc. nor the names of its contributors
+#   may be used to endorse or promote products derived from this software
+#   without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+utils_test_case no_run
+no_run_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+EOF
+    atf_check -s exit:0 -o ignore -e empty kyua test
+
+    atf_check -s exit:1 -o empty -e match:"No run in progress" kyua top
+}
+
+
+utils_test_case no_results
+no_results_body() {
+    atf_check -s exit:1 -o empty -e match:"No previous results" kyua top
+}
+
+
+utils_test_case invalid_interval
+invalid_interval_body() {
+    atf_check -s exit:3 -o empty -e match:"Invalid interval 0" \
+        kyua top --interval=0
+}
+
+
+utils_test_case running_test
+running_test_body() {
+    cat >Kyuafile <<EOF
+syntax(2)
+test_suite("integration")
+plain_test_program{name="slow"}
+EOF
+    cat >slow <<EOF
+#! /bin/sh
+touch "$(pwd)/started"
+while [ ! -f "$(pwd)/finish" ]; do sleep 1; done
+EOF
+    chmod +x slow
+
+    kyua test >test.out 2>test.err &
+    pid=${!}
+    while [ ! -f started ]; do sleep 1; done
+
+    atf_check -s exit:0 -o match:"0 done \(0 failed\), 1 running" \
+        -o match:"slow:main" -e ignore kyua top --iterations=1
+
+    touch finish
+    wait "${pid}" || atf_fail "kyua test failed"
+    atf_check -s exit:0 -o match:"slow:main.*passed" -e empty cat test.out
+
+    atf_check -s exit:1 -o empty -e match:"No run in progress" kyua top
+}
+
+
+atf_init_test_cases() {
+    atf_add_test_case no_run
+    atf_add_test_case no_results
+    atf_add_test_case invalid_interval
+    atf_add_test_case running_test
+}
@@ -68,6 +68,15 @@ logfile__default_body() {
 }
 
 
+utils_test_case logfile__default_clean_run
+logfile__default_clean_run_body() {
+    atf_check -s exit:0 -o ignore -e empty kyua about
+    if ls .kyua/logs/* >/dev/null 2>&1; then
+        atf_fail "Log file created although nothing went wrong"
+    fi
+}
+
+
 utils_test_case logfile__override
 logfile__override_body() {
     atf_check -s exit:0 test ! -f test.log
@@ -135,6 +144,7 @@ atf_init_test_cases() {
     atf_add_test_case unknown_command
 
     atf_add_test_case logfile__default
+    atf_add_test_case logfile__default_clean_run
     atf_add_test_case logfile__override
 
     atf_add_test_case loglevel__default
@@ -0,0 +1,63 @@
+dnl Copyright 2026 The Kyua Authors.
+dnl All rights reserved.
+dnl
+dnl Redistribution and use in source and binary forms, with or without
+dnl modification, are permitted provided that the following conditions are
+dnl met:
+dnl
+dnl * Redistributions of source code must retain the above copyright
+dnl   notice, this list of conditions and the following disclaimer.
+dnl * Redistributions in binary form must reproduce the above copyright
+dnl   notice, this list of conditions and the following disclaimer in the
+dnl   documentation and/or other materials provided with the distribution.
+dnl * Neither the name of Google Inc. nor the names of its contributors
+dnl   may be used to endorse or promote products derived from this software
+dnl   without specific prior written permission.
+dnl
+dnl THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+dnl "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+dnl LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+dnl A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+dnl OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+dnl SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+dnl LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+dnl DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+dnl THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+dnl (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+dnl OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+dnl Determines the flags required to build programs that use threads.
+dnl
+dnl Tries to link a program that starts a std::thread with the default
+dnl flags first and, if that fails, with -pthread.  Adds the necessary
+dnl flags, if any, to CXXFLAGS and LIBS.
+AC_DEFUN([KYUA_THREADS], [
+    AC_CACHE_CHECK([for the flags to use threads], [kyua_cv_threads_flags], [
+        kyua_cv_threads_flags=unknown
+        for flags in "" "-pthread"; do
+            kyua_save_CXXFLAGS="${CXXFLAGS}"
+            kyua_save_LIBS="${LIBS}"
+            CXXFLAGS="${CXXFLAGS} ${flags}"
+            LIBS="${LIBS} ${flags}"
+            AC_LINK_IFELSE([AC_LANG_PROGRAM([#include <thread>], [
+    std::thread thread([] {});
+    thread.join();
+])], [kyua_cv_threads_flags="${flags:-none}"])
+            CXXFLAGS="${kyua_save_CXXFLAGS}"
+            LIBS="${kyua_save_LIBS}"
+            test x"${kyua_cv_threads_flags}" = x"unknown" || break
+        done
+    ])
+    case "${kyua_cv_threads_flags}" in
+    none)
+        ;;
+    unknown)
+        AC_MSG_ERROR([Cannot find how to build programs that use threads])
+        ;;
+    *)
+        CXXFLAGS="${CXXFLAGS} ${kyua_cv_threads_flags}"
+        LIBS="${LIBS} ${kyua_cv_threads_flags}"
+        ;;
+    esac
+])
@@ -184,6 +184,38 @@ class user_node : public config::string_node {
 };
 
 
+/// A leaf node that holds a "resource class" property.
+///
+/// This node is just a string, but it provides validation of the only allowed
+/// values.
+class resource_class_node : public config::string_node {
+    /// Copies the node.
+    ///
+    /// \return A dynamically-allocated node.
+    virtual base_node*
+    deep_copy(void) const
+    {
+        std::auto_ptr< resource_class_node > new_node(
+            new resource_class_node());
+        new_node->_value = _value;
+        return new_node.release();
+    }
+
+    /// Checks a given resource class textual representation for validity.
+    ///
+    /// \param resource_class The value to validate.
+    ///
+    /// \throw config::value_error If the value is not valid.
+    void
+    validate(const value_type& resource_class) const
+    {
+        if (!resource_class.empty() && resource_class != "cpu" &&
+            resource_class != "io" && resource_class != "memory")
+            throw config::value_error("Invalid resource class value");
+    }
+};
+
+
 /// A leaf node that holds a set of paths.
 ///
 /// This node type is used to represent the value of the required files and
@@ -246,16 +278,22 @@ init_tree(config::tree& tree)
     tree.define< config::strings_set_node >("allowed_architectures");
     tree.define< config::strings_set_node >("allowed_platforms");
     tree.define_dynamic("custom");
+    tree.define< config::strings_set_node >("depends_on");
     tree.define< config::string_node >("description");
     tree.define< config::bool_node >("has_cleanup");
     tree.define< config::bool_node >("is_exclusive");
+    tree.define< config::string_node >("manifest");
     tree.define< config::strings_set_node >("required_configs");
     tree.define< bytes_node >("required_disk_space");
     tree.define< paths_set_node >("required_files");
     tree.define< bytes_node >("required_memory");
     tree.define< paths_set_node >("required_programs");
     tree.define< user_node >("required_user");
+    tree.define< resource_class_node >("resource_class");
+    tree.define< config::string_node >("setup");
+    tree.define< config::string_node >("teardown");
     tree.define< delta_node >("timeout");
+    tree.define< config::string_node >("work_template");
 }
 
 
@@ -279,6 +317,10 @@ set_defaults(config::tree& tree)
     tree.set< bytes_node >("required_memory", units::bytes(0));
     tree.set< paths_set_node >("required_programs", model::paths_set());
     tree.set< user_node >("required_user", "");
+    // The dependencies, the manifest, the resource class, the setup and
+    // teardown commands and the work template are intentionally left unset:
+    // they are rarely used and having them in to_properties() would only add
+    // noise.
     // TODO(jmmv): We shouldn't be setting a default timeout like this.  See
     // Issue 5 for details.
     tree.set< delta_node >("timeout", datetime::delta(300, 0));
@@ -343,6 +385,8 @@ set(config::tree& tree, const std::string& key,
         tree.set< NodeType >(key, value);
     } catch (const config::unknown_key_error& e) {
         throw model::error(F("Unknown metadata property %s") % key);
+    } catch (const config::invalid_key_value& e) {
+        throw model::error(e.what());
     } catch (const config::value_error& e) {
         throw model::error(F("Invalid value for metadata property %s: %s") %
                             key % e.what());
@@ -450,6 +494,20 @@ model::metadata::custom(void) const
 }
 
 
+/// Returns the test programs that must complete before this one starts.
+///
+/// \return Set of test program names, relative to the root of the test suite.
+model::strings_set
+model::metadata::depends_on(void) const
+{
+    if (_pimpl->props.is_set("depends_on")) {
+        return _pimpl->props.lookup< config::strings_set_node >("depends_on");
+    } else {
+        return model::strings_set();
+    }
+}
+
+
 /// Returns the description of the test.
 ///
 /// \return Textual description; may be empty.
@@ -493,6 +551,20 @@ model::metadata::is_exclusive(void) const
 }
 
 
+/// Returns the file that lists the test cases of the test program.
+///
+/// \return The path to the manifest, possibly relative to the directory of the
+/// test program; empty if the test cases have to be queried from the program.
+std::string
+model::metadata::manifest(void) const
+{
+    if (_pimpl->props.is_set("manifest")) {
+        return _pimpl->props.lookup< config::string_node >("manifest");
+    } else {
+        return "";
+    }
+}
+
 /// Returns the list of configuration variables needed by the test.
 ///
 /// \return Set of configuration variables.
@@ -579,6 +651,48 @@ model::metadata::required_user(void) const
 }
 
 
+/// Returns the resource the test is known to be bound by.
+///
+/// \return One of cpu, io, memory or empty if unknown.
+std::string
+model::metadata::resource_class(void) const
+{
+    if (_pimpl->props.is_set("resource_class")) {
+        return _pimpl->props.lookup< resource_class_node >("resource_class");
+    } else {
+        return "";
+    }
+}
+
+
+/// Returns the command to set up the fixture of the test program.
+///
+/// \return The command line; empty if there is no setup command.
+std::string
+model::metadata::setup(void) const
+{
+    if (_pimpl->props.is_set("setup")) {
+        return _pimpl->props.lookup< config::string_node >("setup");
+    } else {
+        return "";
+    }
+}
+
+
+/// Returns the command to tear down the fixture of the test program.
+///
+/// \return The command line; empty if there is no teardown command.
+std::string
+model::metadata::teardown(void) const
+{
+    if (_pimpl->props.is_set("teardown")) {
+        return _pimpl->props.lookup< config::string_node >("teardown");
+    } else {
+        return "";
+    }
+}
+
+
 /// Returns the timeout of the test.
 ///
 /// \return A time delta; should be compared to default_timeout to see if it has
@@ -594,6 +708,21 @@ model::metadata::timeout(void) const
 }
 
 
+/// Returns the directory with which to populate the work directory of tests.
+///
+/// \return The path to the template directory, possibly relative to the
+/// directory of the test program; empty if there is no template.
+std::string
+model::metadata::work_template(void) const
+{
+    if (_pimpl->props.is_set("work_template")) {
+        return _pimpl->props.lookup< config::string_node >("work_template");
+    } else {
+        return "";
+    }
+}
+
+
 /// Externalizes the metadata to a set of key/value textual pairs.
 ///
 /// \return A key/value representation of the metadata.
@@ -875,6 +1004,22 @@ model::metadata_builder::set_custom(const model::properties_map& props)
 }
 
 
+/// Sets the test programs that must complete before this one starts.
+///
+/// \param names Set of test program names, relative to the root of the test
+///     suite.
+///
+/// \return A reference to this builder.
+///
+/// \throw model::error If the value is invalid.
+model::metadata_builder&
+model::metadata_builder::set_depends_on(const model::strings_set& names)
+{
+    set< config::strings_set_node >(_pimpl->props, "depends_on", names);
+    return *this;
+}
+
+
 /// Sets the description of the test.
 ///
 /// \param description Textual description of the test.
@@ -920,6 +1065,20 @@ model::metadata_builder::set_is_exclusive(const bool exclusive)
 }
 
 
+/// Sets the file that lists the test cases of the test program.
+///
+/// \param file The path to the manifest.
+///
+/// \return A reference to this builder.
+///
+/// \throw model::error If the value is invalid.
+model::metadata_builder&
+model::metadata_builder::set_manifest(const std::string& file)
+{
+    set< config::string_node >(_pimpl->props, "manifest", file);
+    return *this;
+}
+
 /// Sets the list of configuration variables needed by the test.
 ///
 /// \param vars Set of configuration variables.
@@ -1010,6 +1169,37 @@ model::metadata_builder::set_required_user(const std::string& user)
 }
 
 
+/// Sets the resource the test is known to be bound by.
+///
+/// \param resource_class One of cpu, io, memory or empty if unknown.
+///
+/// \return A reference to this builder.
+///
+/// \throw model::error If the value is invalid.
+model::metadata_builder&
+model::metadata_builder::set_resource_class(const std::string& resource_class)
+{
+    set< resource_class_node >(_pimpl->props, "resource_class",
+                               resource_class);
+    return *this;
+}
+
+
+/// Sets the command to set up the fixture of the test program.
+///
+/// \param command The command line to run.
+///
+/// \return A reference to this builder.
+///
+/// \throw model::error If the value is invalid.
+model::metadata_builder&
+model::metadata_builder::set_setup(const std::string& command)
+{
+    set< config::string_node >(_pimpl->props, "setup", command);
+    return *this;
+}
+
+
 /// Sets a metadata property by name from its textual representation.
 ///
 /// \param key The property to set.
@@ -1026,6 +1216,8 @@ model::metadata_builder::set_string(const std::string& key,
         _pimpl->props.set_string(key, value);
     } catch (const config::unknown_key_error& e) {
         throw model::format_error(F("Unknown metadata property %s") % key);
+    } catch (const config::invalid_key_value& e) {
+        throw model::format_error(e.what());
     } catch (const config::value_error& e) {
         throw model::format_error(
             F("Invalid value for metadata property %s: %s") % key % e.what());
@@ -1034,6 +1226,21 @@ model::metadata_builder::set_string(const std::string& key,
 }
 
 
+/// Sets the command to tear down the fixture of the test program.
+///
+/// \param command The command line to run.
+///
+/// \return A reference to this builder.
+///
+/// \throw model::error If the value is invalid.
+model::metadata_builder&
+model::metadata_builder::set_teardown(const std::string& command)
+{
+    set< config::string_node >(_pimpl->props, "teardown", command);
+    return *this;
+}
+
+
 /// Sets the timeout of the test.
 ///
 /// \param timeout The timeout to set.
@@ -1049,6 +1256,21 @@ model::metadata_builder::set_timeout(const datetime::delta& timeout)
 }
 
 
+/// Sets the directory with which to populate the work directory of tests.
+///
+/// \param directory The path to the template directory.
+///
+/// \return A reference to this builder.
+///
+/// \throw model::error If the value is invalid.
+model::metadata_builder&
+model::metadata_builder::set_work_template(const std::string& directory)
+{
+    set< config::string_node >(_pimpl->props, "work_template", directory);
+    return *this;
+}
+
+
 /// Creates a new metadata object.
 ///
 /// \pre This has not yet been called.  We only support calling this function
@@ -66,16 +66,22 @@ public:
     const strings_set& allowed_architectures(void) const;
     const strings_set& allowed_platforms(void) const;
     model::properties_map custom(void) const;
+    strings_set depends_on(void) const;
     const std::string& description(void) const;
     bool has_cleanup(void) const;
     bool is_exclusive(void) const;
+    std::string manifest(void) const;
     const strings_set& required_configs(void) const;
     const utils::units::bytes& required_disk_space(void) const;
     const paths_set& required_files(void) const;
     const utils::units::bytes& required_memory(void) const;
     const paths_set& required_programs(void) const;
     const std::string& required_user(void) const;
+    std::string resource_class(void) const;
+    std::string setup(void) const;
+    std::string teardown(void) const;
     const utils::datetime::delta& timeout(void) const;
+    std::string work_template(void) const;
 
     model::properties_map to_properties(void) const;
 
@@ -109,17 +115,23 @@ public:
     metadata_builder& set_allowed_architectures(const strings_set&);
     metadata_builder& set_allowed_platforms(const strings_set&);
     metadata_builder& set_custom(const model::properties_map&);
+    metadata_builder& set_depends_on(const strings_set&);
     metadata_builder& set_description(const std::string&);
     metadata_builder& set_has_cleanup(const bool);
     metadata_builder& set_is_exclusive(const bool);
+    metadata_builder& set_manifest(const std::string&);
     metadata_builder& set_required_configs(const strings_set&);
     metadata_builder& set_required_disk_space(const utils::units::bytes&);
     metadata_builder& set_required_files(const paths_set&);
     metadata_builder& set_required_memory(const utils::units::bytes&);
     metadata_builder& set_required_programs(const paths_set&);
     metadata_builder& set_required_user(const std::string&);
+    metadata_builder& set_resource_class(const std::string&);
+    metadata_builder& set_setup(const std::string&);
     metadata_builder& set_string(const std::string&, const std::string&);
+    metadata_builder& set_teardown(const std::string&);
     metadata_builder& set_timeout(const utils::datetime::delta&);
+    metadata_builder& set_work_template(const std::string&);
 
     metadata build(void) const;
 };
@@ -32,6 +32,7 @@
 
 #include <atf-c++.hpp>
 
+#include "model/exceptions.hpp"
 #include "model/types.hpp"
 #include "utils/datetime.hpp"
 #include "utils/format/containers.ipp"
@@ -51,6 +52,7 @@ ATF_TEST_CASE_BODY(defaults)
     ATF_REQUIRE(md.allowed_platforms().empty());
     ATF_REQUIRE(md.allowed_platforms().empty());
     ATF_REQUIRE(md.custom().empty());
+    ATF_REQUIRE(md.depends_on().empty());
     ATF_REQUIRE(md.description().empty());
     ATF_REQUIRE(!md.has_cleanup());
     ATF_REQUIRE(!md.is_exclusive());
@@ -60,7 +62,11 @@ ATF_TEST_CASE_BODY(defaults)
     ATF_REQUIRE_EQ(units::bytes(0), md.required_memory());
     ATF_REQUIRE(md.required_programs().empty());
     ATF_REQUIRE(md.required_user().empty());
+    ATF_REQUIRE(md.manifest().empty());
+    ATF_REQUIRE(md.setup().empty());
+    ATF_REQUIRE(md.teardown().empty());
     ATF_REQUIRE(datetime::delta(300, 0) == md.timeout());
+    ATF_REQUIRE(md.work_template().empty());
 }
 
 
@@ -280,7 +286,10 @@ ATF_TEST_CASE_BODY(override_all_with_set_string)
         .set_string("required_memory", "1M")
         .set_string("required_programs", "program /absolute/prog")
         .set_string("required_user", "unprivileged")
+        .set_string("setup", "make-fixture --big")
+        .set_string("teardown", "drop-fixture")
         .set_string("timeout", "45")
+        .set_string("work_template", "data/tree")
         .build();
 
     ATF_REQUIRE(architectures == md.allowed_architectures());
@@ -295,7 +304,10 @@ ATF_TEST_CASE_BODY(override_all_with_set_string)
     ATF_REQUIRE_EQ(memory, md.required_memory());
     ATF_REQUIRE(programs == md.required_programs());
     ATF_REQUIRE_EQ(user, md.required_user());
+    ATF_REQUIRE_EQ("make-fixture --big", md.setup());
+    ATF_REQUIRE_EQ("drop-fixture", md.teardown());
     ATF_REQUIRE(timeout == md.timeout());
+    ATF_REQUIRE_EQ("data/tree", md.work_template());
 }
 
 
@@ -328,6 +340,85 @@ ATF_TEST_CASE_BODY(to_properties)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(to_properties__fixture);
+ATF_TEST_CASE_BODY(to_properties__fixture)
+{
+    const model::metadata md = model::metadata_builder()
+        .set_setup("setup.sh arg")
+        .set_teardown("teardown.sh")
+        .set_work_template("tree")
+        .build();
+    ATF_REQUIRE_EQ("setup.sh arg", md.setup());
+    ATF_REQUIRE_EQ("teardown.sh", md.teardown());
+    ATF_REQUIRE_EQ("tree", md.work_template());
+
+    const model::properties_map props = md.to_properties();
+    ATF_REQUIRE_EQ("setup.sh arg", (*props.find("setup")).second);
+    ATF_REQUIRE_EQ("teardown.sh", (*props.find("teardown")).second);
+    ATF_REQUIRE_EQ("tree", (*props.find("work_template")).second);
+
+    const model::metadata copy = model::metadata_builder(md).build();
+    ATF_REQUIRE(md == copy);
+    ATF_REQUIRE(md != model::metadata_builder().build());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(to_properties__depends_on);
+ATF_TEST_CASE_BODY(to_properties__depends_on)
+{
+    model::strings_set depends_on;
+    depends_on.insert("first_test");
+    depends_on.insert("dir/second_test");
+    const model::metadata md = model::metadata_builder()
+        .set_depends_on(depends_on)
+        .build();
+    ATF_REQUIRE(depends_on == md.depends_on());
+
+    const model::properties_map props = md.to_properties();
+    ATF_REQUIRE_EQ("dir/second_test first_test",
+                   (*props.find("depends_on")).second);
+
+    const model::metadata copy = model::metadata_builder()
+        .set_string("depends_on", "first_test dir/second_test")
+        .build();
+    ATF_REQUIRE(md == copy);
+    ATF_REQUIRE(!model::metadata_builder().build().to_properties().count(
+        "depends_on"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(to_properties__manifest);
+ATF_TEST_CASE_BODY(to_properties__manifest)
+{
+    const model::metadata md = model::metadata_builder()
+        .set_manifest("foo_test.tcs")
+        .build();
+    ATF_REQUIRE_EQ("foo_test.tcs", md.manifest());
+    ATF_REQUIRE_EQ("foo_test.tcs",
+                   (*md.to_properties().find("manifest")).second);
+
+    ATF_REQUIRE(!model::metadata_builder().build().to_properties().count(
+        "manifest"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(to_properties__resource_class);
+ATF_TEST_CASE_BODY(to_properties__resource_class)
+{
+    const model::metadata md = model::metadata_builder()
+        .set_resource_class("io")
+        .build();
+    ATF_REQUIRE_EQ("io", md.resource_class());
+    ATF_REQUIRE_EQ("io", (*md.to_properties().find("resource_class")).second);
+
+    ATF_REQUIRE(model::metadata_builder().build().resource_class().empty());
+    ATF_REQUIRE(!model::metadata_builder().build().to_properties().count(
+        "resource_class"));
+    ATF_REQUIRE_THROW_RE(model::error, "Invalid resource class",
+                         model::metadata_builder().set_string(
+                             "resource_class", "disk"));
+}
+
 ATF_TEST_CASE_WITHOUT_HEAD(operators_eq_and_ne__empty);
 ATF_TEST_CASE_BODY(operators_eq_and_ne__empty)
 {
@@ -446,6 +537,10 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, override_all_with_setters);
     ATF_ADD_TEST_CASE(tcs, override_all_with_set_string);
     ATF_ADD_TEST_CASE(tcs, to_properties);
+    ATF_ADD_TEST_CASE(tcs, to_properties__fixture);
+    ATF_ADD_TEST_CASE(tcs, to_properties__depends_on);
+    ATF_ADD_TEST_CASE(tcs, to_properties__manifest);
+    ATF_ADD_TEST_CASE(tcs, to_properties__resource_class);
 
     ATF_ADD_TEST_CASE(tcs, operators_eq_and_ne__empty);
     ATF_ADD_TEST_CASE(tcs, operators_eq_and_ne__copy);
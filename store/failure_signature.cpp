@@ -0,0 +1,276 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "store/failure_signature.hpp"
+
+#include <vector>
+
+#include "model/test_result.hpp"
+#include "store/exceptions.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/sanity.hpp"
+#include "utils/sqlite/database.hpp"
+#include "utils/sqlite/exceptions.hpp"
+#include "utils/sqlite/statement.ipp"
+#include "utils/text/operations.ipp"
+
+namespace sqlite = utils::sqlite;
+namespace text = utils::text;
+
+
+namespace {
+
+
+/// Maximum length of every line of a signature.
+///
+/// Longer lines are truncated to keep the signatures of chatty test cases
+/// reasonably sized.
+static const std::size_t max_line_length = 200;
+
+
+/// Checks if a character is a hexadecimal digit.
+///
+/// \param ch The character to check.
+///
+/// \return True if ch is a hexadecimal digit.
+static bool
+is_hex_digit(const char ch)
+{
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') ||
+        (ch >= 'A' && ch <= 'F');
+}
+
+
+/// Checks if a character is a decimal digit.
+///
+/// \param ch The character to check.
+///
+/// \return True if ch is a decimal digit.
+static bool
+is_digit(const char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+
+/// Masks the numbers and addresses in a word.
+///
+/// \param word The word to process; must not contain whitespace.
+///
+/// \return The word with every number replaced by # and every hexadecimal
+/// address replaced by 0x#.
+static std::string
+mask_numbers(const std::string& word)
+{
+    std::string output;
+    std::string::size_type i = 0;
+    while (i < word.length()) {
+        if (word[i] == '0' && i + 2 < word.length() &&
+            (word[i + 1] == 'x' || word[i + 1] == 'X') &&
+            is_hex_digit(word[i + 2])) {
+            output += "0x#";
+            i += 2;
+            while (i < word.length() && is_hex_digit(word[i]))
+                ++i;
+        } else if (is_digit(word[i])) {
+            output += '#';
+            while (i < word.length() && is_digit(word[i]))
+                ++i;
+        } else {
+            output += word[i];
+            ++i;
+        }
+    }
+    return output;
+}
+
+
+/// Masks a word if it looks like a path.
+///
+/// \param word The word to process; must not contain whitespace.
+///
+/// \return The word with the path replaced by <path>, keeping any surrounding
+/// punctuation, or the word with its numbers masked if it is not a path.
+static std::string
+mask_word(const std::string& word)
+{
+    const std::string::size_type begin = word.find_first_not_of("\"'`([{<");
+    const std::string::size_type end = word.find_last_not_of("\"'`)]}>,.:;!?");
+    if (begin == std::string::npos || end == std::string::npos || end < begin)
+        return mask_numbers(word);
+
+    const std::string core = word.substr(begin, end - begin + 1);
+    if (core.find('/') == std::string::npos)
+        return mask_numbers(word);
+
+    return word.substr(0, begin) + "<path>" + word.substr(end + 1);
+}
+
+
+}  // anonymous namespace
+
+
+/// Number of trailing lines of stderr that are part of a failure signature.
+const std::size_t store::detail::signature_stderr_lines = 5;
+
+
+/// Masks the parts of a piece of text that usually vary across test cases.
+///
+/// \param input The text to process.  Should be a single line.
+///
+/// \return The text with its paths, hexadecimal addresses and numbers masked
+/// and with any sequence of whitespace collapsed to a single space.
+std::string
+store::detail::mask_variable_text(const std::string& input)
+{
+    std::string output;
+    std::string::size_type pos = input.find_first_not_of(" \t\r\n");
+    while (pos != std::string::npos) {
+        std::string::size_type end = input.find_first_of(" \t\r\n", pos);
+        if (end == std::string::npos)
+            end = input.length();
+
+        if (!output.empty())
+            output += ' ';
+        output += mask_word(input.substr(pos, end - pos));
+
+        pos = input.find_first_not_of(" \t\r\n", end);
+    }
+    return output;
+}
+
+
+/// Extracts the last non-blank lines of a text.
+///
+/// \param contents The text to process.
+/// \param max_lines The maximum number of lines to return.
+///
+/// \return The requested lines, separated by newlines.
+std::string
+store::detail::stderr_tail(const std::string& contents,
+                           const std::size_t max_lines)
+{
+    const std::vector< std::string > all_lines = text::split(contents, '\n');
+
+    std::vector< std::string > lines;
+    for (std::vector< std::string >::const_reverse_iterator
+             iter = all_lines.rbegin(); iter != all_lines.rend() &&
+             lines.size() < max_lines; ++iter) {
+        if ((*iter).find_first_not_of(" \t\r") != std::string::npos)
+            lines.insert(lines.begin(), *iter);
+    }
+    return text::join(lines, "\n");
+}
+
+
+/// Checks whether a database contains the failure signatures table.
+///
+/// Results files created before failure signatures were introduced lack it.
+///
+/// \param db The database to check.
+///
+/// \return True if the table exists.
+///
+/// \throw sqlite::error If there is a problem querying the database.
+bool
+store::detail::has_failure_signatures(sqlite::database& db)
+{
+    sqlite::statement stmt = db.create_statement(
+        "SELECT name FROM sqlite_master "
+        "WHERE type == 'table' AND name == 'failure_signatures'");
+    return stmt.step();
+}
+
+
+/// Creates the failure signatures table in a database.
+///
+/// \param db The database in which to create the table.  Nothing is done if the
+///     table already exists.
+///
+/// \throw store::error If the table cannot be created.
+void
+store::detail::create_failure_signatures(sqlite::database& db)
+{
+    try {
+        db.exec("CREATE TABLE IF NOT EXISTS failure_signatures ("
+                "    test_case_id INTEGER PRIMARY KEY REFERENCES test_cases, "
+                "    signature TEXT NOT NULL); "
+                "CREATE INDEX IF NOT EXISTS index_failure_signatures "
+                "    ON failure_signatures (signature)");
+    } catch (const sqlite::error& e) {
+        throw store::error(F("Cannot create failure signatures table: %s") %
+                           e.what());
+    }
+}
+
+
+/// Checks whether a test result deserves a failure signature.
+///
+/// \param result The result to check.
+///
+/// \return True if the result represents a failure.
+bool
+store::has_failure_signature(const model::test_result& result)
+{
+    return result.type() == model::test_result_broken ||
+        result.type() == model::test_result_failed;
+}
+
+
+/// Computes the signature of a test failure.
+///
+/// \pre has_failure_signature(result) must be true.
+///
+/// \param result The result of the test case.
+/// \param stderr_contents The stderr of the test case, or just its last lines.
+///
+/// \return The signature of the failure, which is made of one line for the
+/// reason of the result followed by one line for each of the last lines of
+/// stderr.
+std::string
+store::failure_signature(const model::test_result& result,
+                         const std::string& stderr_contents)
+{
+    PRE(has_failure_signature(result));
+
+    std::vector< std::string > lines;
+    lines.push_back(detail::mask_variable_text(result.reason()));
+    const std::vector< std::string > tail = text::split(
+        detail::stderr_tail(stderr_contents, detail::signature_stderr_lines),
+        '\n');
+    for (std::vector< std::string >::const_iterator iter = tail.begin();
+         iter != tail.end(); ++iter) {
+        lines.push_back(detail::mask_variable_text(*iter));
+    }
+
+    for (std::vector< std::string >::iterator iter = lines.begin();
+         iter != lines.end(); ++iter) {
+        if ((*iter).length() > max_line_length)
+            (*iter).erase(max_line_length);
+    }
+    return text::join(lines, "\n");
+}
@@ -0,0 +1,71 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/// \file store/failure_signature.hpp
+/// Computation and storage of the signatures of test failures.
+///
+/// A failure signature is a normalized summary of why a test case failed.  It
+/// is built from the reason of the result and the last lines written to
+/// stderr, with the parts that usually vary across test cases (numbers,
+/// addresses and paths) masked.  Test cases that fail for the same underlying
+/// cause, such as a broken shared library, end up with the same signature.
+
+#if !defined(STORE_FAILURE_SIGNATURE_HPP)
+#define STORE_FAILURE_SIGNATURE_HPP
+
+#include <cstddef>
+#include <string>
+
+#include "model/test_result_fwd.hpp"
+#include "utils/sqlite/database_fwd.hpp"
+
+namespace store {
+
+
+namespace detail {
+
+
+extern const std::size_t signature_stderr_lines;
+
+
+std::string mask_variable_text(const std::string&);
+std::string stderr_tail(const std::string&, const std::size_t);
+
+bool has_failure_signatures(utils::sqlite::database&);
+void create_failure_signatures(utils::sqlite::database&);
+
+
+}  // namespace detail
+
+
+bool has_failure_signature(const model::test_result&);
+std::string failure_signature(const model::test_result&, const std::string&);
+
+
+}  // namespace store
+
+#endif  // !defined(STORE_FAILURE_SIGNATURE_HPP)
@@ -0,0 +1,310 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "store/failure_signature.hpp"
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "model/context.hpp"
+#include "model/metadata.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
+#include "utils/sqlite/database.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace logging = utils::logging;
+namespace sqlite = utils::sqlite;
+
+
+namespace {
+
+
+/// Creates a results file with test cases that fail in various ways.
+///
+/// The first two test cases fail for the same reason but with messages that
+/// differ in their paths and numbers; the third one fails for a different
+/// reason and the fourth one passes.
+///
+/// \param file The results file to create.
+static void
+populate(const fs::path& file)
+{
+    store::write_backend backend = store::write_backend::open_rw(file);
+    store::write_transaction tx = backend.start_write();
+
+    tx.put_context(model::context(fs::path("/foo/bar"),
+                                  std::map< std::string, std::string >()));
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 10, 00, 0);
+    const datetime::timestamp end_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 15, 30, 0);
+
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("dir/prog"), fs::path("/the/root"), "suite")
+        .add_test_case("first").add_test_case("second")
+        .add_test_case("third").add_test_case("fourth").build();
+    const int64_t tp_id = tx.put_test_program(test_program);
+
+    const int64_t first_id = tx.put_test_case(test_program, "first", tp_id);
+    atf::utils::create_file("err.txt", "Loading /usr/lib/libfoo.so.1\n"
+                            "Segmentation fault at 0x7fff1234\n");
+    tx.put_test_case_file("__STDERR__", fs::path("err.txt"), first_id);
+    tx.put_result(model::test_result(model::test_result_broken,
+                                     "Received signal 11"),
+                  first_id, start_time, end_time);
+
+    const int64_t second_id = tx.put_test_case(test_program, "second", tp_id);
+    atf::utils::create_file("err.txt", "Loading /opt/lib/libfoo.so.2\n"
+                            "Segmentation fault at 0xdeadbeef\n");
+    tx.put_test_case_file("__STDERR__", fs::path("err.txt"), second_id);
+    tx.put_result(model::test_result(model::test_result_broken,
+                                     "Received signal 11"),
+                  second_id, start_time, end_time);
+
+    const int64_t third_id = tx.put_test_case(test_program, "third", tp_id);
+    tx.put_result(model::test_result(model::test_result_failed,
+                                     "Expected 3 but got 4"),
+                  third_id, start_time, end_time);
+
+    const int64_t fourth_id = tx.put_test_case(test_program, "fourth", tp_id);
+    tx.put_result(model::test_result(model::test_result_passed),
+                  fourth_id, start_time, end_time);
+
+    tx.commit();
+    backend.close();
+}
+
+
+/// Gets the failure signatures of all the test cases in a results file.
+///
+/// \param file The results file to query.
+///
+/// \return A map of test case names to their signatures.
+static std::map< std::string, std::string >
+get_signatures(const fs::path& file)
+{
+    store::read_backend backend = store::read_backend::open_ro(file);
+    store::read_transaction tx = backend.start_read();
+
+    std::map< std::string, std::string > signatures;
+    for (store::results_iterator iter = tx.get_results(); iter; ++iter)
+        signatures[iter.test_case_name()] = iter.failure_signature();
+    return signatures;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(mask_variable_text__nothing);
+ATF_TEST_CASE_BODY(mask_variable_text__nothing)
+{
+    ATF_REQUIRE_EQ("", store::detail::mask_variable_text(""));
+    ATF_REQUIRE_EQ("Some text", store::detail::mask_variable_text(
+                       "Some text"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(mask_variable_text__numbers);
+ATF_TEST_CASE_BODY(mask_variable_text__numbers)
+{
+    ATF_REQUIRE_EQ("Expected # but got #, errno=#",
+                   store::detail::mask_variable_text(
+                       "Expected 3 but got 1234, errno=28"));
+    ATF_REQUIRE_EQ("pointer 0x# is invalid (0x#)",
+                   store::detail::mask_variable_text(
+                       "pointer 0x7fffDEAD is invalid (0xa)"));
+    ATF_REQUIRE_EQ("file_#.txt #x", store::detail::mask_variable_text(
+                       "file_42.txt 0x"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(mask_variable_text__paths);
+ATF_TEST_CASE_BODY(mask_variable_text__paths)
+{
+    ATF_REQUIRE_EQ("Cannot open <path>: No such file",
+                   store::detail::mask_variable_text(
+                       "Cannot open /tmp/kyua.1234/foo: No such file"));
+    ATF_REQUIRE_EQ("File '<path>' (at <path>) is empty",
+                   store::detail::mask_variable_text(
+                       "File 'a/b' (at ./work/dir) is empty"));
+    ATF_REQUIRE_EQ("Ratio <path> is too low", store::detail::mask_variable_text(
+                       "Ratio 1/2 is too low"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(mask_variable_text__whitespace);
+ATF_TEST_CASE_BODY(mask_variable_text__whitespace)
+{
+    ATF_REQUIRE_EQ("a b c", store::detail::mask_variable_text(
+                       "  a \t b\r\n c  "));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(stderr_tail);
+ATF_TEST_CASE_BODY(stderr_tail)
+{
+    ATF_REQUIRE_EQ("", store::detail::stderr_tail("", 3));
+    ATF_REQUIRE_EQ("a\nb", store::detail::stderr_tail("a\nb\n", 3));
+    ATF_REQUIRE_EQ("c\nd\ne", store::detail::stderr_tail(
+                       "a\nb\nc\n\nd\n  \ne\n\n", 3));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(has_failure_signature);
+ATF_TEST_CASE_BODY(has_failure_signature)
+{
+    using model::test_result;
+    ATF_REQUIRE(store::has_failure_signature(
+        test_result(model::test_result_broken, "foo")));
+    ATF_REQUIRE(store::has_failure_signature(
+        test_result(model::test_result_failed, "foo")));
+    ATF_REQUIRE(!store::has_failure_signature(
+        test_result(model::test_result_expected_failure, "foo")));
+    ATF_REQUIRE(!store::has_failure_signature(
+        test_result(model::test_result_passed)));
+    ATF_REQUIRE(!store::has_failure_signature(
+        test_result(model::test_result_skipped, "foo")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(failure_signature__reason_only);
+ATF_TEST_CASE_BODY(failure_signature__reason_only)
+{
+    ATF_REQUIRE_EQ("Expected # but got #", store::failure_signature(
+        model::test_result(model::test_result_failed, "Expected 3 but got 4"),
+        ""));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(failure_signature__with_stderr);
+ATF_TEST_CASE_BODY(failure_signature__with_stderr)
+{
+    const model::test_result result(model::test_result_broken,
+                                    "Premature exit; exit status 1");
+
+    std::string stderr_contents;
+    for (int i = 0; i < 10; ++i)
+        stderr_contents += "Line " + std::string(1, 'a' + i) + "\n";
+    ATF_REQUIRE_EQ("Premature exit; exit status #\n"
+                   "Line f\nLine g\nLine h\nLine i\nLine j",
+                   store::failure_signature(result, stderr_contents));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(failure_signature__long_lines);
+ATF_TEST_CASE_BODY(failure_signature__long_lines)
+{
+    const model::test_result result(model::test_result_failed,
+                                    std::string(300, 'x'));
+    ATF_REQUIRE_EQ(std::string(200, 'x') + "\n" + std::string(200, 'y'),
+                   store::failure_signature(result, std::string(250, 'y')));
+}
+
+
+ATF_TEST_CASE(stored_at_write_time);
+ATF_TEST_CASE_HEAD(stored_at_write_time)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(stored_at_write_time)
+{
+    populate(fs::path("test.db"));
+
+    const std::map< std::string, std::string > signatures = get_signatures(
+        fs::path("test.db"));
+    ATF_REQUIRE_EQ(4, signatures.size());
+    ATF_REQUIRE_EQ("Received signal #\n"
+                   "Loading <path>\n"
+                   "Segmentation fault at 0x#",
+                   signatures.find("first")->second);
+    ATF_REQUIRE_EQ(signatures.find("first")->second,
+                   signatures.find("second")->second);
+    ATF_REQUIRE_EQ("Expected # but got #", signatures.find("third")->second);
+    ATF_REQUIRE_EQ("", signatures.find("fourth")->second);
+}
+
+
+ATF_TEST_CASE(computed_at_read_time);
+ATF_TEST_CASE_HEAD(computed_at_read_time)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(computed_at_read_time)
+{
+    populate(fs::path("test.db"));
+    const std::map< std::string, std::string > exp_signatures = get_signatures(
+        fs::path("test.db"));
+
+    {
+        sqlite::database db = sqlite::database::open(
+            fs::path("test.db"), sqlite::open_readwrite);
+        ATF_REQUIRE(store::detail::has_failure_signatures(db));
+        db.exec("DROP TABLE failure_signatures");
+        ATF_REQUIRE(!store::detail::has_failure_signatures(db));
+        db.close();
+    }
+
+    ATF_REQUIRE(exp_signatures == get_signatures(fs::path("test.db")));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, mask_variable_text__nothing);
+    ATF_ADD_TEST_CASE(tcs, mask_variable_text__numbers);
+    ATF_ADD_TEST_CASE(tcs, mask_variable_text__paths);
+    ATF_ADD_TEST_CASE(tcs, mask_variable_text__whitespace);
+    ATF_ADD_TEST_CASE(tcs, stderr_tail);
+    ATF_ADD_TEST_CASE(tcs, has_failure_signature);
+    ATF_ADD_TEST_CASE(tcs, failure_signature__reason_only);
+    ATF_ADD_TEST_CASE(tcs, failure_signature__with_stderr);
+    ATF_ADD_TEST_CASE(tcs, failure_signature__long_lines);
+    ATF_ADD_TEST_CASE(tcs, stored_at_write_time);
+    ATF_ADD_TEST_CASE(tcs, computed_at_read_time);
+}
@@ -0,0 +1,203 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "store/interference.hpp"
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "model/context.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
+#include "utils/sqlite/database.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace logging = utils::logging;
+namespace sqlite = utils::sqlite;
+
+using utils::optional;
+
+
+namespace {
+
+
+/// Creates a results file with two test cases.
+///
+/// Only the first test case is recorded as suspected of interference.
+///
+/// \param file The results file to create.
+static void
+populate(const fs::path& file)
+{
+    store::write_backend backend = store::write_backend::open_rw(file);
+    store::write_transaction tx = backend.start_write();
+
+    tx.put_context(model::context(fs::path("/foo/bar"),
+                                  std::map< std::string, std::string >()));
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 10, 00, 0);
+    const datetime::timestamp end_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 15, 30, 0);
+
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("dir/prog"), fs::path("/the/root"), "suite")
+        .add_test_case("first").add_test_case("second").build();
+    const int64_t tp_id = tx.put_test_program(test_program);
+
+    std::vector< std::string > overlapping;
+    overlapping.push_back("dir/prog:second");
+    overlapping.push_back("dir/other:main");
+
+    const int64_t first_id = tx.put_test_case(test_program, "first", tp_id);
+    tx.put_result(model::test_result(model::test_result_passed),
+                  first_id, start_time, end_time);
+    tx.put_interference(first_id,
+                        model::test_result(model::test_result_failed,
+                                           "Port in use"),
+                        overlapping);
+
+    const int64_t second_id = tx.put_test_case(test_program, "second", tp_id);
+    tx.put_result(model::test_result(model::test_result_passed),
+                  second_id, start_time, end_time);
+
+    tx.commit();
+    backend.close();
+}
+
+
+/// Interference of a test case as recorded in a results file.
+typedef std::pair< optional< model::test_result >,
+                   std::vector< std::string > > interference_pair;
+
+
+/// Gets the interference of all the test cases in a results file.
+///
+/// \param file The results file to query.
+///
+/// \return A map of test case names to their interference.
+static std::map< std::string, interference_pair >
+get_interference(const fs::path& file)
+{
+    store::read_backend backend = store::read_backend::open_ro(file);
+    store::read_transaction tx = backend.start_read();
+
+    std::map< std::string, interference_pair > interference;
+    for (store::results_iterator iter = tx.get_results(); iter; ++iter) {
+        ATF_REQUIRE(iter.result() ==
+                    model::test_result(model::test_result_passed));
+        interference[iter.test_case_name()] = interference_pair(
+            iter.interference(), iter.interfering_tests());
+    }
+    return interference;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE(stored_at_write_time);
+ATF_TEST_CASE_HEAD(stored_at_write_time)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(stored_at_write_time)
+{
+    populate(fs::path("test.db"));
+
+    const std::map< std::string, interference_pair > interference =
+        get_interference(fs::path("test.db"));
+    ATF_REQUIRE_EQ(2, interference.size());
+
+    const interference_pair& first = interference.find("first")->second;
+    ATF_REQUIRE(first.first);
+    ATF_REQUIRE(model::test_result(model::test_result_failed, "Port in use") ==
+                first.first.get());
+    ATF_REQUIRE_EQ(2, first.second.size());
+    ATF_REQUIRE_EQ("dir/prog:second", first.second[0]);
+    ATF_REQUIRE_EQ("dir/other:main", first.second[1]);
+
+    const interference_pair& second = interference.find("second")->second;
+    ATF_REQUIRE(!second.first);
+    ATF_REQUIRE(second.second.empty());
+}
+
+
+ATF_TEST_CASE(missing_table);
+ATF_TEST_CASE_HEAD(missing_table)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(missing_table)
+{
+    populate(fs::path("test.db"));
+
+    {
+        sqlite::database db = sqlite::database::open(
+            fs::path("test.db"), sqlite::open_readwrite);
+        ATF_REQUIRE(store::detail::has_interference(db));
+        db.exec("DROP TABLE interference");
+        ATF_REQUIRE(!store::detail::has_interference(db));
+        db.close();
+    }
+
+    const std::map< std::string, interference_pair > interference =
+        get_interference(fs::path("test.db"));
+    ATF_REQUIRE_EQ(2, interference.size());
+    for (std::map< std::string, interference_pair >::const_iterator
+             iter = interference.begin(); iter != interference.end(); ++iter) {
+        ATF_REQUIRE(!(*iter).second.first);
+        ATF_REQUIRE((*iter).second.second.empty());
+    }
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, stored_at_write_time);
+    ATF_ADD_TEST_CASE(tcs, missing_table);
+}
@@ -30,6 +30,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <functional>
 
 #include "store/exceptions.hpp"
 #include "utils/datetime.hpp"
@@ -56,6 +57,39 @@ using utils::optional;
 namespace {
 
 
+/// Finds the results files of all past runs of the given test suite.
+///
+/// \param test_suite Identifier of the test suite to query.
+///
+/// \return Names of the located databases within the store directory, sorted
+/// from the most recent to the oldest.
+///
+/// \throw fs::system_error If the store directory cannot be read.
+/// \throw text::regex_error If the test suite yields an invalid pattern.
+static std::vector< std::string >
+find_all(const std::string& test_suite)
+{
+    const text::regex preg = text::regex::compile(
+        F("^results.%s.[0-9]{8}-[0-9]{6}-[0-9]{6}.db$") % test_suite, 0);
+
+    std::vector< std::string > names;
+
+    const fs::directory dir(layout::query_store_dir());
+    for (fs::directory::const_iterator iter = dir.begin();
+         iter != dir.end(); ++iter) {
+        const text::regex_matches matches = preg.match(iter->name);
+        if (matches) {
+            names.push_back(iter->name);
+        } else {
+            // Not a database file; skip.
+        }
+    }
+
+    std::sort(names.begin(), names.end(), std::greater< std::string >());
+    return names;
+}
+
+
 /// Finds the results file for the latest run of the given test suite.
 ///
 /// \param test_suite Identifier of the test suite to query.
@@ -69,30 +103,13 @@ find_latest(const std::string& test_suite)
 {
     const fs::path store_dir = layout::query_store_dir();
     try {
-        const text::regex preg = text::regex::compile(
-            F("^results.%s.[0-9]{8}-[0-9]{6}-[0-9]{6}.db$") % test_suite, 0);
-
-        std::string latest;
-
-        const fs::directory dir(store_dir);
-        for (fs::directory::const_iterator iter = dir.begin();
-             iter != dir.end(); ++iter) {
-            const text::regex_matches matches = preg.match(iter->name);
-            if (matches) {
-                if (latest.empty() || iter->name > latest) {
-                    latest = iter->name;
-                }
-            } else {
-                // Not a database file; skip.
-            }
-        }
-
-        if (latest.empty())
+        const std::vector< std::string > names = find_all(test_suite);
+        if (names.empty())
             throw store::error(
                 F("No previous results file found for test suite %s")
                 % test_suite);
 
-        return store_dir / latest;
+        return store_dir / names[0];
     } catch (const fs::system_error& e) {
         LW(F("Failed to open store dir %s: %s") % store_dir % e.what());
         throw store::error(F("No previous results file found for test suite %s")
@@ -172,6 +189,35 @@ layout::find_results(const std::string& id)
 }
 
 
+/// Resolves the results files of the most recent runs of a test suite.
+///
+/// \param test_suite Identifier of the test suite to query.
+/// \param max_files Maximum number of results files to return.
+///
+/// \return Paths to the located databases, sorted from the most recent to the
+/// oldest.  Empty if there are none.
+std::vector< fs::path >
+layout::find_history(const std::string& test_suite, const std::size_t max_files)
+{
+    const fs::path store_dir = query_store_dir();
+
+    std::vector< fs::path > files;
+    try {
+        const std::vector< std::string > names = find_all(test_suite);
+        for (std::vector< std::string >::const_iterator iter = names.begin();
+             iter != names.end() && files.size() < max_files; ++iter) {
+            files.push_back(store_dir / *iter);
+        }
+    } catch (const fs::system_error& e) {
+        LD(F("Failed to open store dir %s: %s") % store_dir % e.what());
+    } catch (const text::regex_error& e) {
+        LW(F("Cannot look for past results of %s: %s") % test_suite %
+           e.what());
+    }
+    return files;
+}
+
+
 /// Computes the path to a new database for the given test suite.
 ///
 /// \param id Identifier of the test suite to create.
@@ -58,7 +58,9 @@
 
 #include "store/layout_fwd.hpp"
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 #include "utils/datetime_fwd.hpp"
 #include "utils/fs/path_fwd.hpp"
@@ -71,6 +73,8 @@ extern const char* results_auto_create_name;
 extern const char* results_auto_open_name;
 
 utils::fs::path find_results(const std::string&);
+std::vector< utils::fs::path > find_history(const std::string&,
+                                            const std::size_t);
 results_id_file_pair new_db(const std::string&, const utils::fs::path&);
 utils::fs::path new_db_for_migration(const utils::fs::path&,
                                      const utils::datetime::timestamp&);
@@ -33,6 +33,7 @@ extern "C" {
 }
 
 #include <iostream>
+#include <vector>
 
 #include <atf-c++.hpp>
 
@@ -227,6 +228,42 @@ ATF_TEST_CASE_BODY(find_results__not_found)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(find_history__some);
+ATF_TEST_CASE_BODY(find_history__some)
+{
+    const fs::path store_dir = layout::query_store_dir();
+    fs::mkdir_p(store_dir, 0755);
+
+    const std::string test_suite = layout::test_suite_for_path(
+        fs::current_path());
+    const std::string base = (store_dir / (
+        "results." + test_suite + ".")).str();
+
+    atf::utils::create_file(base + "20140613-194515-000000.db", "");
+    atf::utils::create_file(base + "20140614-194515-123456.db", "");
+    atf::utils::create_file(base + "20130614-194515-999999.db", "");
+    atf::utils::create_file((store_dir / "results.other.db").str(), "");
+
+    std::vector< fs::path > exp_files;
+    exp_files.push_back(fs::path(base + "20140614-194515-123456.db"));
+    exp_files.push_back(fs::path(base + "20140613-194515-000000.db"));
+    ATF_REQUIRE(exp_files == layout::find_history(test_suite, 2));
+
+    exp_files.push_back(fs::path(base + "20130614-194515-999999.db"));
+    ATF_REQUIRE(exp_files == layout::find_history(test_suite, 10));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(find_history__none);
+ATF_TEST_CASE_BODY(find_history__none)
+{
+    ATF_REQUIRE(layout::find_history("foo", 10).empty());
+
+    fs::mkdir_p(layout::query_store_dir(), 0755);
+    ATF_REQUIRE(layout::find_history("foo", 10).empty());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(new_db__new);
 ATF_TEST_CASE_BODY(new_db__new)
 {
@@ -336,6 +373,9 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, find_results__id_with_timestamp);
     ATF_ADD_TEST_CASE(tcs, find_results__not_found);
 
+    ATF_ADD_TEST_CASE(tcs, find_history__some);
+    ATF_ADD_TEST_CASE(tcs, find_history__none);
+
     ATF_ADD_TEST_CASE(tcs, new_db__new);
     ATF_ADD_TEST_CASE(tcs, new_db__explicit);
 
@@ -276,6 +276,7 @@ store::migrate_schema(const utils::fs::path& file)
                       "supported version %s") % version_from % version_to);
     }
 
+    const detail::in_use_marker marker(file);
     detail::backup_database(file, version_from);
 
     int i;
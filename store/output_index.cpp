@@ -0,0 +1,240 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "store/output_index.hpp"
+
+#include "store/exceptions.hpp"
+#include "store/metadata.hpp"
+#include "store/read_backend.hpp"
+#include "store/write_backend.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/sanity.hpp"
+#include "utils/sqlite/database.hpp"
+#include "utils/sqlite/exceptions.hpp"
+#include "utils/sqlite/statement.ipp"
+#include "utils/sqlite/transaction.hpp"
+
+namespace fs = utils::fs;
+namespace sqlite = utils::sqlite;
+
+
+/// Name of the index source used for the reasons of the test results.
+///
+/// Test case files are indexed under their own name (e.g. __STDOUT__), so this
+/// follows the same naming scheme to not clash with them.
+const char* const store::detail::reason_source = "__REASON__";
+
+
+namespace {
+
+
+/// Adds a piece of text to the output index.
+///
+/// \param db The database containing the index.
+/// \param entry_id The identifier of the text in output_index_contents.
+/// \param test_case_id The test case the text belongs to.
+/// \param source The name of the text; see output_match::source.
+/// \param contents The text to index.
+///
+/// \throw sqlite::error If there is a problem writing to the database.
+static void
+put_output_index_entry(sqlite::database& db, const int64_t entry_id,
+                       const int64_t test_case_id, const std::string& source,
+                       const std::string& contents)
+{
+    sqlite::statement stmt = db.create_statement(
+        "INSERT INTO output_index (rowid, contents, test_case_id, source) "
+        "VALUES (:entry_id, :contents, :test_case_id, :source)");
+    stmt.bind(":entry_id", entry_id);
+    stmt.bind(":contents", contents);
+    stmt.bind(":test_case_id", test_case_id);
+    stmt.bind(":source", source);
+    stmt.step_without_results();
+}
+
+
+}  // anonymous namespace
+
+
+/// Checks whether a database contains the output index.
+///
+/// \param db The database to check.
+///
+/// \return True if the index exists.
+///
+/// \throw sqlite::error If there is a problem querying the database.
+bool
+store::detail::has_output_index(sqlite::database& db)
+{
+    sqlite::statement stmt = db.create_statement(
+        "SELECT name FROM sqlite_master "
+        "WHERE type == 'table' AND name == 'output_index'");
+    return stmt.step();
+}
+
+
+/// Creates the output index in a database.
+///
+/// The index does not store a copy of the indexed texts: it is an external
+/// content table backed by the output_index_contents view, which exposes the
+/// files of the test cases and the reasons of their results.  Each text is
+/// identified by the negated identifier of its file or by the identifier of the
+/// test case for reasons, and the expression index lets the view find files by
+/// that identifier.
+///
+/// \param db The database in which to create the index.  Nothing is done if the
+///     index already exists.
+///
+/// \throw store::error If the index cannot be created, most likely because
+///     SQLite has not been built with FTS5.
+void
+store::detail::create_output_index(sqlite::database& db)
+{
+    try {
+        db.exec("CREATE INDEX IF NOT EXISTS output_index_files "
+                "ON test_case_files (-file_id)");
+        db.exec(F("CREATE VIEW IF NOT EXISTS output_index_contents AS "
+                  "SELECT -test_case_files.file_id AS entry_id, "
+                  "    files.contents AS contents, "
+                  "    test_case_files.test_case_id AS test_case_id, "
+                  "    test_case_files.file_name AS source "
+                  "FROM test_case_files "
+                  "    JOIN files ON test_case_files.file_id = files.file_id "
+                  "UNION ALL "
+                  "SELECT test_case_id AS entry_id, "
+                  "    result_reason AS contents, "
+                  "    test_case_id, "
+                  "    '%s' AS source "
+                  "FROM test_results "
+                  "WHERE result_reason IS NOT NULL") % reason_source);
+        db.exec("CREATE VIRTUAL TABLE IF NOT EXISTS output_index USING fts5("
+                "contents, "
+                "test_case_id UNINDEXED, "
+                "source UNINDEXED, "
+                "content='output_index_contents', "
+                "content_rowid='entry_id')");
+    } catch (const sqlite::error& e) {
+        throw store::error(F("Cannot create output index: %s") % e.what());
+    }
+}
+
+
+/// Adds a file of a test case to the output index.
+///
+/// \pre The index exists in the database.
+///
+/// \param db The database containing the index.
+/// \param file_id The identifier of the file in the files table.
+/// \param test_case_id The test case the file belongs to.
+/// \param name The name of the file within the test case.
+/// \param contents The contents of the file.
+///
+/// \throw sqlite::error If there is a problem writing to the database.
+void
+store::detail::put_output_index_file(sqlite::database& db,
+                                     const int64_t file_id,
+                                     const int64_t test_case_id,
+                                     const std::string& name,
+                                     const std::string& contents)
+{
+    put_output_index_entry(db, -file_id, test_case_id, name, contents);
+}
+
+
+/// Adds the reason of a test result to the output index.
+///
+/// \pre The index exists in the database.
+///
+/// \param db The database containing the index.
+/// \param test_case_id The test case the result belongs to.
+/// \param reason The reason of the result.
+///
+/// \throw sqlite::error If there is a problem writing to the database.
+void
+store::detail::put_output_index_reason(sqlite::database& db,
+                                       const int64_t test_case_id,
+                                       const std::string& reason)
+{
+    put_output_index_entry(db, test_case_id, test_case_id, reason_source,
+                           reason);
+}
+
+
+/// Indexes the output of all the test cases in a results file.
+///
+/// The index is created and populated from the contents of the results file if
+/// it does not exist yet.  Results files that already have an index are left
+/// untouched: once the index exists, every text stored in the file is indexed
+/// at write time.
+///
+/// \param file The results file to index.
+///
+/// \return The number of texts added to the index.
+///
+/// \throw store::error If there is any problem updating the results file.
+std::size_t
+store::index_output(const fs::path& file)
+{
+    const detail::in_use_marker marker(file);
+    sqlite::database db = detail::open_and_setup(file, sqlite::open_readwrite);
+
+    const int version = metadata::fetch_latest(db).schema_version();
+    if (version < detail::current_schema_version)
+        throw old_schema_error(version);
+    else if (version > detail::current_schema_version)
+        throw integrity_error(
+            F("Database at schema version %s, which is newer than the "
+              "supported version %s")
+            % version % detail::current_schema_version);
+
+    try {
+        if (detail::has_output_index(db)) {
+            LI(F("Output index of %s is already up to date") % file);
+            return 0;
+        }
+
+        sqlite::transaction tx = db.begin_transaction();
+
+        detail::create_output_index(db);
+        db.exec("INSERT INTO output_index (output_index) VALUES ('rebuild')");
+
+        sqlite::statement stmt = db.create_statement(
+            "SELECT COUNT(*) FROM output_index_contents");
+        const bool has_row = stmt.step();
+        INV(has_row);
+        const std::size_t count = static_cast< std::size_t >(
+            stmt.column_int64(0));
+
+        tx.commit();
+
+        LI(F("Added %s entries to the output index of %s") % count % file);
+        return count;
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot index output of %s: %s") % file % e.what());
+    }
+}
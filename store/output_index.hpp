@@ -0,0 +1,117 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/// \file store/output_index.hpp
+/// Full-text index over the output of the test cases in a results file.
+///
+/// The index is optional: it is only present in results files that were
+/// written with output indexing enabled or that have been indexed afterwards
+/// with index_output().  It requires SQLite to be built with FTS5.
+
+#if !defined(STORE_OUTPUT_INDEX_HPP)
+#define STORE_OUTPUT_INDEX_HPP
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <cstddef>
+#include <string>
+
+#include "utils/fs/path.hpp"
+#include "utils/sqlite/database_fwd.hpp"
+
+namespace store {
+
+
+namespace detail {
+
+
+extern const char* const reason_source;
+
+
+bool has_output_index(utils::sqlite::database&);
+void create_output_index(utils::sqlite::database&);
+void put_output_index_file(utils::sqlite::database&, const int64_t,
+                           const int64_t, const std::string&,
+                           const std::string&);
+void put_output_index_reason(utils::sqlite::database&, const int64_t,
+                             const std::string&);
+
+
+}  // namespace detail
+
+
+/// Tuple describing a match of a query against the output index.
+class output_match {
+public:
+    /// Identifier of the test case that matched.
+    int64_t test_case_id;
+
+    /// Relative path to the test program containing the test case.
+    utils::fs::path test_program;
+
+    /// Name of the test case that matched.
+    std::string test_case_name;
+
+    /// Name of the indexed text that matched.
+    ///
+    /// This is the name of the test case file (e.g. __STDOUT__) or
+    /// detail::reason_source for the reason of the result.
+    std::string source;
+
+    /// Fragment of the matching text with the matched terms highlighted.
+    std::string snippet;
+
+    /// Initializer for the tuple's fields.
+    ///
+    /// \param test_case_id_ Identifier of the test case that matched.
+    /// \param test_program_ Relative path to the test program.
+    /// \param test_case_name_ Name of the test case that matched.
+    /// \param source_ Name of the indexed text that matched.
+    /// \param snippet_ Fragment of the matching text.
+    output_match(const int64_t test_case_id_,
+                 const utils::fs::path& test_program_,
+                 const std::string& test_case_name_,
+                 const std::string& source_,
+                 const std::string& snippet_) :
+        test_case_id(test_case_id_),
+        test_program(test_program_),
+        test_case_name(test_case_name_),
+        source(source_),
+        snippet(snippet_)
+    {
+    }
+};
+
+
+std::size_t index_output(const utils::fs::path&);
+
+
+}  // namespace store
+
+#endif  // !defined(STORE_OUTPUT_INDEX_HPP)
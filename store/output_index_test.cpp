@@ -0,0 +1,268 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "store/output_index.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+#include "model/context.hpp"
+#include "model/metadata.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/exceptions.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
+#include "utils/sqlite/database.hpp"
+#include "utils/sqlite/statement.ipp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace logging = utils::logging;
+namespace sqlite = utils::sqlite;
+
+
+namespace {
+
+
+/// Creates a results file with a few test cases that write some output.
+///
+/// \param file The results file to create.
+/// \param index Whether to create the output index at write time.
+static void
+populate(const fs::path& file, const bool index)
+{
+    store::write_backend backend = store::write_backend::open_rw(file);
+    if (index)
+        backend.create_output_index();
+    store::write_transaction tx = backend.start_write();
+
+    tx.put_context(model::context(fs::path("/foo/bar"),
+                                  std::map< std::string, std::string >()));
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 10, 00, 0);
+    const datetime::timestamp end_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 15, 30, 0);
+
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("dir/prog"), fs::path("/the/root"), "suite")
+        .add_test_case("first").add_test_case("second")
+        .add_test_case("third").build();
+    const int64_t tp_id = tx.put_test_program(test_program);
+
+    const int64_t first_id = tx.put_test_case(test_program, "first", tp_id);
+    atf::utils::create_file("out.txt", "Writing to /tmp/foo\nDone\n");
+    tx.put_test_case_file("__STDOUT__", fs::path("out.txt"), first_id);
+    tx.put_result(model::test_result(model::test_result_passed), first_id,
+                  start_time, end_time);
+
+    const int64_t second_id = tx.put_test_case(test_program, "second", tp_id);
+    atf::utils::create_file("out.txt", "Writing to /tmp/bar\n");
+    tx.put_test_case_file("__STDOUT__", fs::path("out.txt"), second_id);
+    atf::utils::create_file("err.txt", "write failed: ENOSPC\n");
+    tx.put_test_case_file("__STDERR__", fs::path("err.txt"), second_id);
+    tx.put_result(model::test_result(model::test_result_failed,
+                                     "Disk is full"),
+                  second_id, start_time, end_time);
+
+    const int64_t third_id = tx.put_test_case(test_program, "third", tp_id);
+    tx.put_result(model::test_result(model::test_result_broken,
+                                     "Received ENOSPC from the disk"),
+                  third_id, start_time, end_time);
+
+    tx.commit();
+    backend.close();
+}
+
+
+/// Searches the output of the test cases in a results file.
+///
+/// \param file The results file to query.
+/// \param query The query to search for.
+///
+/// \return The matches as strings of the form test_case_id:source:snippet.
+static std::vector< std::string >
+search(const fs::path& file, const std::string& query)
+{
+    store::read_backend backend = store::read_backend::open_ro(file);
+    store::read_transaction tx = backend.start_read();
+    const std::vector< store::output_match > matches = tx.search_output(query);
+
+    std::vector< std::string > raw_matches;
+    for (std::vector< store::output_match >::const_iterator iter =
+             matches.begin(); iter != matches.end(); ++iter) {
+        raw_matches.push_back(F("%s:%s:%s:%s") % (*iter).test_program %
+                              (*iter).test_case_name % (*iter).source %
+                              (*iter).snippet);
+    }
+    return raw_matches;
+}
+
+
+/// Checks whether a results file contains an output index.
+///
+/// \param file The results file to query.
+///
+/// \return True if the index exists.
+static bool
+has_index(const fs::path& file)
+{
+    store::read_backend backend = store::read_backend::open_ro(file);
+    store::read_transaction tx = backend.start_read();
+    return tx.has_output_index();
+}
+
+
+/// Checks whether the output index of a results file holds a copy of the texts.
+///
+/// \param file The results file to query.
+///
+/// \return True if the index has its own content table.
+static bool
+has_copy(const fs::path& file)
+{
+    store::read_backend backend = store::read_backend::open_ro(file);
+    sqlite::statement stmt = backend.database().create_statement(
+        "SELECT name FROM sqlite_master WHERE name == 'output_index_content'");
+    return stmt.step();
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE(write_time);
+ATF_TEST_CASE_HEAD(write_time)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_time)
+{
+    populate(fs::path("test.db"), true);
+    ATF_REQUIRE(has_index(fs::path("test.db")));
+    ATF_REQUIRE(!has_copy(fs::path("test.db")));
+
+    std::vector< std::string > exp_matches;
+    exp_matches.push_back("dir/prog:second:__STDERR__:write failed: "
+                          "[ENOSPC]\n");
+    exp_matches.push_back("dir/prog:third:__REASON__:Received [ENOSPC] from "
+                          "the disk");
+    ATF_REQUIRE(exp_matches == search(fs::path("test.db"), "enospc"));
+
+    exp_matches.clear();
+    exp_matches.push_back("dir/prog:first:__STDOUT__:Writing to /[tmp/foo]\n"
+                          "Done\n");
+    ATF_REQUIRE(exp_matches == search(fs::path("test.db"), "\"tmp foo\""));
+
+    ATF_REQUIRE(search(fs::path("test.db"), "something").empty());
+}
+
+
+ATF_TEST_CASE(index_output__not_indexed);
+ATF_TEST_CASE_HEAD(index_output__not_indexed)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(index_output__not_indexed)
+{
+    populate(fs::path("test.db"), false);
+    ATF_REQUIRE(!has_index(fs::path("test.db")));
+
+    ATF_REQUIRE_EQ(5, store::index_output(fs::path("test.db")));
+    ATF_REQUIRE(has_index(fs::path("test.db")));
+    ATF_REQUIRE(!has_copy(fs::path("test.db")));
+
+    std::vector< std::string > exp_matches;
+    exp_matches.push_back("dir/prog:second:__REASON__:[Disk] is [full]");
+    ATF_REQUIRE(exp_matches == search(fs::path("test.db"), "disk full"));
+
+    ATF_REQUIRE_EQ(0, store::index_output(fs::path("test.db")));
+    ATF_REQUIRE(exp_matches == search(fs::path("test.db"), "disk full"));
+}
+
+
+ATF_TEST_CASE(index_output__already_indexed);
+ATF_TEST_CASE_HEAD(index_output__already_indexed)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(index_output__already_indexed)
+{
+    populate(fs::path("test.db"), true);
+    ATF_REQUIRE_EQ(0, store::index_output(fs::path("test.db")));
+    ATF_REQUIRE_EQ(2, search(fs::path("test.db"), "ENOSPC").size());
+}
+
+
+ATF_TEST_CASE(index_output__missing);
+ATF_TEST_CASE_HEAD(index_output__missing)
+{
+    logging::set_inmemory();
+}
+ATF_TEST_CASE_BODY(index_output__missing)
+{
+    ATF_REQUIRE_THROW_RE(store::error, "Cannot open",
+                         store::index_output(fs::path("missing.db")));
+}
+
+
+ATF_TEST_CASE(search_output__invalid_query);
+ATF_TEST_CASE_HEAD(search_output__invalid_query)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(search_output__invalid_query)
+{
+    populate(fs::path("test.db"), true);
+    ATF_REQUIRE_THROW_RE(store::error, "Cannot search output for 'foo AND'",
+                         search(fs::path("test.db"), "foo AND"));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, write_time);
+    ATF_ADD_TEST_CASE(tcs, index_output__not_indexed);
+    ATF_ADD_TEST_CASE(tcs, index_output__already_indexed);
+    ATF_ADD_TEST_CASE(tcs, index_output__missing);
+    ATF_ADD_TEST_CASE(tcs, search_output__invalid_query);
+}
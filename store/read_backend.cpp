@@ -28,12 +28,22 @@
 
 #include "store/read_backend.hpp"
 
+extern "C" {
+#include <sys/stat.h>
+
+#include <stdint.h>
+}
+
+#include <algorithm>
+
 #include "store/exceptions.hpp"
 #include "store/metadata.hpp"
 #include "store/read_transaction.hpp"
 #include "store/write_backend.hpp"
 #include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/logging/macros.hpp"
 #include "utils/noncopyable.hpp"
 #include "utils/sqlite/database.hpp"
 #include "utils/sqlite/exceptions.hpp"
@@ -42,6 +52,55 @@ namespace fs = utils::fs;
 namespace sqlite = utils::sqlite;
 
 
+namespace {
+
+
+/// Lower bound for the page cache of read-only databases, in KiB.
+static const int64_t min_read_cache_kb = 2 * 1024;
+
+
+/// Upper bound for the page cache of read-only databases, in KiB.
+static const int64_t max_read_cache_kb = 256 * 1024;
+
+
+/// Checks if a database file is possibly being modified by another process.
+///
+/// Every writer that modifies a results file in place flags it with an in-use
+/// marker for as long as it has the file open; see detail::in_use_marker.  A
+/// journal next to the database also means that a writer is active or that it
+/// crashed and left a hot journal behind.  In all these cases we must let
+/// SQLite do its usual locking and recovery.
+///
+/// \param file The database file to check.
+///
+/// \return True if the database may change while we read it.
+static bool
+may_be_in_use(const fs::path& file)
+{
+    return fs::exists(fs::path(file.str() + "-journal")) ||
+        fs::exists(fs::path(file.str() + "-wal")) ||
+        fs::exists(store::detail::in_use_marker_file(file));
+}
+
+
+/// Queries the size of a file.
+///
+/// \param file The file to query.
+///
+/// \return The size of the file in bytes, or 0 if it cannot be determined.
+static int64_t
+file_size(const fs::path& file)
+{
+    struct ::stat sb;
+    if (::stat(file.c_str(), &sb) == -1)
+        return 0;
+    return sb.st_size;
+}
+
+
+}  // anonymous namespace
+
+
 /// Opens a database and defines session pragmas.
 ///
 /// This auxiliary function ensures that, every time we open a SQLite database,
@@ -66,6 +125,37 @@ store::detail::open_and_setup(const fs::path& file, const int flags)
 }
 
 
+/// Tunes a database connection that will only be used for reading.
+///
+/// Reports scan whole results files, which can be multiple gigabytes in size,
+/// so the default page cache of SQLite is too small for them and we end up
+/// being bound by read(2) calls.  Instead, map the file into memory and size
+/// the page cache according to the file.
+///
+/// All of these settings are hints: older versions of SQLite silently ignore
+/// the pragmas they do not know about.
+///
+/// \param db The database to tune.
+/// \param file_size The size of the database file in bytes.
+///
+/// \throw store::error If there is a problem applying the settings.
+void
+store::detail::setup_for_reads(sqlite::database& db, const int64_t file_size)
+{
+    const int64_t cache_kb = std::min(max_read_cache_kb,
+        std::max(min_read_cache_kb, file_size / 1024 / 8));
+    try {
+        db.exec("PRAGMA query_only = ON");
+        db.exec("PRAGMA temp_store = MEMORY");
+        db.exec(F("PRAGMA cache_size = -%s") % cache_kb);
+        db.exec(F("PRAGMA mmap_size = %s") % file_size);
+    } catch (const sqlite::error& e) {
+        throw store::error(F("Cannot set up database for reading: %s") %
+                           e.what());
+    }
+}
+
+
 /// Internal implementation for the backend.
 struct store::read_backend::impl : utils::noncopyable {
     /// The SQLite database this backend talks to.
@@ -119,6 +209,10 @@ store::read_backend::~read_backend(void)
 
 /// Opens a database in read-only mode.
 ///
+/// The database is accessed with the usual SQLite locking, so the returned
+/// backend remains valid even if the file is modified later on.  Use this for
+/// long-lived readers.
+///
 /// \param file The database file to be opened.
 ///
 /// \return The backend representation.
@@ -128,6 +222,35 @@ store::read_backend
 store::read_backend::open_ro(const fs::path& file)
 {
     sqlite::database db = detail::open_and_setup(file, sqlite::open_readonly);
+    detail::setup_for_reads(db, file_size(file));
+    return read_backend(new impl(db, metadata::fetch_latest(db)));
+}
+
+
+/// Opens a database in read-only mode for a one-shot read.
+///
+/// Results files that are not being modified are opened as immutable, which
+/// avoids all file locking while reading them.  The caller must not keep the
+/// backend open for longer than it takes to read the results: nothing stops a
+/// writer from modifying the file after this check.
+///
+/// \param file The database file to be opened.
+///
+/// \return The backend representation.
+///
+/// \throw store::error If there is any problem opening the database.
+store::read_backend
+store::read_backend::open_ro_immutable(const fs::path& file)
+{
+    int flags = sqlite::open_readonly;
+    if (may_be_in_use(file))
+        LI(F("Results file %s may be in use; not opening as immutable")
+           % file);
+    else
+        flags |= sqlite::open_immutable;
+
+    sqlite::database db = detail::open_and_setup(file, flags);
+    detail::setup_for_reads(db, file_size(file));
     return read_backend(new impl(db, metadata::fetch_latest(db)));
 }
 
@@ -34,6 +34,10 @@
 
 #include "store/read_backend_fwd.hpp"
 
+extern "C" {
+#include <stdint.h>
+}
+
 #include <memory>
 
 #include "store/read_transaction_fwd.hpp"
@@ -47,6 +51,7 @@ namespace detail {
 
 
 utils::sqlite::database open_and_setup(const utils::fs::path&, const int);
+void setup_for_reads(utils::sqlite::database&, const int64_t);
 
 
 }  // anonymous namespace
@@ -65,6 +70,7 @@ public:
     ~read_backend(void);
 
     static read_backend open_ro(const utils::fs::path&);
+    static read_backend open_ro_immutable(const utils::fs::path&);
     void close(void);
 
     utils::sqlite::database& database(void);
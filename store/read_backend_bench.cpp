@@ -0,0 +1,224 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file store/read_backend_bench.cpp
+/// Benchmark for the scanning of results files as done by reports.
+///
+/// This program populates a synthetic results file with a configurable number
+/// of test results (1M by default) and then measures how long it takes to open
+/// it and to walk all of its results in the same way the report drivers do.
+/// It also reports the heap allocations of the store and of the scan per
+/// result, which should not grow unexpectedly from one change to another.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "model/context.hpp"
+#include "model/metadata.hpp"
+#include "model/test_case.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/heap_stats.hpp"
+#include "utils/logging/operations.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace heap_stats = utils::heap_stats;
+namespace logging = utils::logging;
+
+
+namespace {
+
+
+/// Default number of results to put in the synthetic results file.
+static const long default_num_results = 1000000;
+
+
+/// Number of test cases to put in every synthetic test program.
+static const long cases_per_program = 100;
+
+
+/// Prints the duration and the heap usage of a benchmark phase.
+///
+/// \param phase Name of the phase being reported.
+/// \param start The time the phase started at.
+/// \param num_results The number of results processed by the phase.
+/// \param heap_phase The heap_stats phase whose allocations to report.  The
+///     counters must have been reset when the benchmark phase started.
+static void
+report(const char* phase, const datetime::timestamp& start,
+       const long num_results, const heap_stats::phase heap_phase)
+{
+    const int64_t usecs = (datetime::timestamp::now() - start)
+        .to_microseconds();
+    std::cout << F("%s: %s results in %s.%06ss (%s us/result)\n")
+        % phase % num_results % (usecs / 1000000) % (usecs % 1000000)
+        % (num_results == 0 ? 0 : usecs / num_results);
+
+    const heap_stats::counters counters = heap_stats::get(heap_phase);
+    std::cout << F("%s: %s allocations (%s/result), %s bytes (%s/result), "
+                   "%s bytes peak\n")
+        % phase % counters.allocations
+        % (num_results == 0 ? 0 : counters.allocations / num_results)
+        % counters.bytes
+        % (num_results == 0 ? 0 : counters.bytes / num_results)
+        % counters.peak;
+}
+
+
+/// Populates a new results file with synthetic data.
+///
+/// \param file The results file to create.
+/// \param num_results The number of test results to store.
+static void
+populate(const fs::path& file, const long num_results)
+{
+    store::write_backend backend = store::write_backend::open_rw(file);
+    store::write_transaction tx = backend.start_write();
+
+    tx.put_context(model::context(fs::path("/bench"),
+                                  std::map< std::string, std::string >()));
+
+    const datetime::timestamp start_time =
+        datetime::timestamp::from_values(2026, 1, 1, 0, 0, 0, 0);
+    const datetime::timestamp end_time = start_time + datetime::delta(1, 0);
+
+    for (long done = 0; done < num_results; done += cases_per_program) {
+        const long num_cases = std::min(cases_per_program,
+                                        num_results - done);
+
+        model::test_cases_map_builder test_cases;
+        for (long i = 0; i < num_cases; ++i)
+            test_cases.add(F("case_%s") % i);
+        const model::test_program program(
+            "atf", fs::path(F("dir%s/program_%s_test") % (done / 10000) % done),
+            fs::path("/bench/root"), "bench", model::metadata_builder().build(),
+            test_cases.build());
+
+        const int64_t program_id = tx.put_test_program(program);
+        for (long i = 0; i < num_cases; ++i) {
+            const int64_t case_id = tx.put_test_case(
+                program, F("case_%s") % i, program_id);
+            const model::test_result result = (done + i) % 10 == 0 ?
+                model::test_result(model::test_result_failed,
+                                   F("Synthetic failure %s") % (done + i)) :
+                model::test_result(model::test_result_passed);
+            tx.put_result(result, case_id, start_time, end_time);
+        }
+    }
+
+    tx.commit();
+    backend.close();
+}
+
+
+/// Walks all the results in a results file as a report would.
+///
+/// \param file The results file to scan.
+///
+/// \return The number of results found.
+static long
+scan(const fs::path& file)
+{
+    heap_stats::scoped_phase phase(heap_stats::phase_report);
+
+    store::read_backend backend = store::read_backend::open_ro_immutable(file);
+    store::read_transaction tx = backend.start_read();
+
+    long count = 0;
+    for (store::results_iterator iter = tx.get_results(); iter; ++iter) {
+        (void)iter.test_program();
+        (void)iter.test_case_name();
+        (void)iter.result();
+        (void)iter.start_time();
+        (void)iter.end_time();
+        ++count;
+    }
+
+    tx.finish();
+    backend.close();
+    return count;
+}
+
+
+}  // anonymous namespace
+
+
+/// Program entry point.
+///
+/// \param argc Number of command-line arguments.
+/// \param argv The command-line arguments.  The only optional argument is the
+///     number of results to generate.
+///
+/// \return An exit code.
+int
+main(const int argc, const char* const* const argv)
+{
+    logging::set_persistency("warning", fs::path("/dev/null"));
+
+    long num_results = default_num_results;
+    if (argc > 1)
+        num_results = std::atol(argv[1]);
+
+    const fs::path file("read_backend_bench.db");
+    if (fs::exists(file))
+        fs::unlink(file);
+
+    heap_stats::reset();
+    datetime::timestamp start = datetime::timestamp::now();
+    populate(file, num_results);
+    report("populate", start, num_results, heap_stats::phase_store);
+
+    // Do the scan twice to tell apart the cost of a cold and a warm cache.
+    for (int i = 0; i < 2; ++i) {
+        heap_stats::reset();
+        start = datetime::timestamp::now();
+        const long count = scan(file);
+        report(i == 0 ? "scan (first)" : "scan (second)", start, count,
+               heap_stats::phase_report);
+        if (count != num_results) {
+            std::cerr << F("Expected %s results but found %s\n")
+                % num_results % count;
+            return EXIT_FAILURE;
+        }
+    }
+
+    fs::unlink(file);
+    return EXIT_SUCCESS;
+}
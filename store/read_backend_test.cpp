@@ -75,6 +75,20 @@ ATF_TEST_CASE_BODY(detail__open_and_setup__missing_file)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(detail__setup_for_reads);
+ATF_TEST_CASE_BODY(detail__setup_for_reads)
+{
+    sqlite::database db = sqlite::database::open(
+        fs::path("test.db"), sqlite::open_readwrite | sqlite::open_create);
+    db.exec("CREATE TABLE one (foo INTEGER PRIMARY KEY AUTOINCREMENT);");
+
+    store::detail::setup_for_reads(db, 1024 * 1024 * 1024);
+    db.exec("SELECT * FROM one;");
+    ATF_REQUIRE_THROW(sqlite::error,
+                      db.exec("INSERT INTO one (foo) VALUES (12);"));
+}
+
+
 ATF_TEST_CASE(read_backend__open_ro__ok);
 ATF_TEST_CASE_HEAD(read_backend__open_ro__ok)
 {
@@ -94,6 +108,100 @@ ATF_TEST_CASE_BODY(read_backend__open_ro__ok)
 }
 
 
+ATF_TEST_CASE(read_backend__open_ro__locks);
+ATF_TEST_CASE_HEAD(read_backend__open_ro__locks)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(read_backend__open_ro__locks)
+{
+    store::write_backend::open_rw(fs::path("test.db"));  // Create database.
+    ATF_REQUIRE(!fs::exists(fs::path("test.db.in-use")));
+
+    // Hold a lock without writing anything so that there is no journal.  A
+    // database opened as immutable ignores the lock.
+    sqlite::database writer = sqlite::database::open(
+        fs::path("test.db"), sqlite::open_readwrite);
+    writer.exec("BEGIN EXCLUSIVE");
+    ATF_REQUIRE(!fs::exists(fs::path("test.db-journal")));
+    ATF_REQUIRE_THROW(store::error,
+                      store::read_backend::open_ro(fs::path("test.db")));
+    writer.exec("ROLLBACK");
+
+    store::read_backend backend = store::read_backend::open_ro(
+        fs::path("test.db"));
+    backend.database().exec("SELECT * FROM metadata");
+}
+
+
+ATF_TEST_CASE(read_backend__open_ro_immutable__ok);
+ATF_TEST_CASE_HEAD(read_backend__open_ro_immutable__ok)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(read_backend__open_ro_immutable__ok)
+{
+    store::write_backend::open_rw(fs::path("test.db"));  // Create database.
+
+    sqlite::database writer = sqlite::database::open(
+        fs::path("test.db"), sqlite::open_readwrite);
+    writer.exec("BEGIN EXCLUSIVE");
+    store::read_backend backend = store::read_backend::open_ro_immutable(
+        fs::path("test.db"));
+    backend.database().exec("SELECT * FROM metadata");
+    writer.exec("ROLLBACK");
+}
+
+
+ATF_TEST_CASE(read_backend__open_ro_immutable__journal);
+ATF_TEST_CASE_HEAD(read_backend__open_ro_immutable__journal)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(read_backend__open_ro_immutable__journal)
+{
+    store::write_backend::open_rw(fs::path("test.db"));  // Create database.
+    atf::utils::create_file("test.db-journal", "");
+    store::read_backend backend = store::read_backend::open_ro_immutable(
+        fs::path("test.db"));
+    backend.database().exec("SELECT * FROM metadata");
+}
+
+
+ATF_TEST_CASE(read_backend__open_ro_immutable__in_use_marker);
+ATF_TEST_CASE_HEAD(read_backend__open_ro_immutable__in_use_marker)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(read_backend__open_ro_immutable__in_use_marker)
+{
+    store::write_backend::open_rw(fs::path("test.db"));  // Create database.
+
+    // The lock is only honored if the marker makes open_ro_immutable() fall
+    // back to a regular read-only database.
+    sqlite::database writer = sqlite::database::open(
+        fs::path("test.db"), sqlite::open_readwrite);
+    writer.exec("BEGIN EXCLUSIVE");
+    {
+        const store::detail::in_use_marker marker(fs::path("test.db"));
+        ATF_REQUIRE(fs::exists(fs::path("test.db.in-use")));
+        ATF_REQUIRE_THROW(store::error,
+                          store::read_backend::open_ro_immutable(
+                              fs::path("test.db")));
+    }
+    ATF_REQUIRE(!fs::exists(fs::path("test.db.in-use")));
+    writer.exec("ROLLBACK");
+
+    store::read_backend backend = store::read_backend::open_ro_immutable(
+        fs::path("test.db"));
+    backend.database().exec("SELECT * FROM metadata");
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(read_backend__open_ro__missing_file);
 ATF_TEST_CASE_BODY(read_backend__open_ro__missing_file)
 {
@@ -144,8 +252,13 @@ ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, detail__open_and_setup__ok);
     ATF_ADD_TEST_CASE(tcs, detail__open_and_setup__missing_file);
+    ATF_ADD_TEST_CASE(tcs, detail__setup_for_reads);
 
     ATF_ADD_TEST_CASE(tcs, read_backend__open_ro__ok);
+    ATF_ADD_TEST_CASE(tcs, read_backend__open_ro__locks);
+    ATF_ADD_TEST_CASE(tcs, read_backend__open_ro_immutable__ok);
+    ATF_ADD_TEST_CASE(tcs, read_backend__open_ro_immutable__journal);
+    ATF_ADD_TEST_CASE(tcs, read_backend__open_ro_immutable__in_use_marker);
     ATF_ADD_TEST_CASE(tcs, read_backend__open_ro__missing_file);
     ATF_ADD_TEST_CASE(tcs, read_backend__open_ro__integrity_error);
     ATF_ADD_TEST_CASE(tcs, read_backend__close);
@@ -33,7 +33,11 @@ extern "C" {
 }
 
 #include <map>
+#include <set>
+#include <sstream>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "model/context.hpp"
 #include "model/metadata.hpp"
@@ -42,7 +46,11 @@ extern "C" {
 #include "model/test_result.hpp"
 #include "store/dbtypes.hpp"
 #include "store/exceptions.hpp"
+#include "store/failure_signature.hpp"
+#include "store/interference.hpp"
+#include "store/output_index.hpp"
 #include "store/read_backend.hpp"
+#include "store/resource_usage.hpp"
 #include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
@@ -54,11 +62,14 @@ extern "C" {
 #include "utils/sqlite/exceptions.hpp"
 #include "utils/sqlite/statement.ipp"
 #include "utils/sqlite/transaction.hpp"
+#include "utils/units.hpp"
 
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
 namespace sqlite = utils::sqlite;
+namespace units = utils::units;
 
+using utils::none;
 using utils::optional;
 
 
@@ -150,6 +161,11 @@ get_file(sqlite::database& db, const int64_t file_id)
 
 /// Gets all the test cases within a particular test program.
 ///
+/// The metadata of all test cases is fetched in the same query as the test
+/// cases themselves.  Test programs with many test cases are common and issuing
+/// one query per test case to get its metadata dominates the cost of loading
+/// them otherwise.
+///
 /// \param db The database to query the information from.
 /// \param test_program_id The identifier of the test program whose test cases
 ///     to query.
@@ -163,16 +179,33 @@ get_test_cases(sqlite::database& db, const int64_t test_program_id)
     model::test_cases_map_builder test_cases;
 
     sqlite::statement stmt = db.create_statement(
-        "SELECT name, metadata_id "
-        "FROM test_cases WHERE test_program_id == :test_program_id");
+        "SELECT test_cases.test_case_id, test_cases.name, "
+        "    metadatas.property_name, metadatas.property_value "
+        "FROM test_cases "
+        "    LEFT JOIN metadatas "
+        "    ON test_cases.metadata_id == metadatas.metadata_id "
+        "WHERE test_cases.test_program_id == :test_program_id "
+        "ORDER BY test_cases.test_case_id");
     stmt.bind(":test_program_id", test_program_id);
-    while (stmt.step()) {
+
+    bool valid = stmt.step();
+    while (valid) {
+        const int64_t test_case_id = stmt.safe_column_int64("test_case_id");
         const std::string name = stmt.safe_column_text("name");
-        const int64_t metadata_id = stmt.safe_column_int64("metadata_id");
 
-        const model::metadata metadata = get_metadata(db, metadata_id);
+        model::metadata_builder builder;
+        do {
+            if (stmt.column_type(stmt.column_id("property_name")) !=
+                sqlite::type_null) {
+                builder.set_string(stmt.safe_column_text("property_name"),
+                                   stmt.safe_column_text("property_value"));
+            }
+            valid = stmt.step();
+        } while (valid &&
+                 stmt.safe_column_int64("test_case_id") == test_case_id);
+
         LD(F("Loaded test case '%s'") % name);
-        test_cases.add(name, metadata);
+        test_cases.add(name, builder.build());
     }
 
     return test_cases.build();
@@ -255,6 +288,15 @@ struct store::results_iterator::impl : utils::noncopyable {
     /// The store backend we are dealing with.
     store::read_backend _backend;
 
+    /// Whether the results file contains precomputed failure signatures.
+    bool _has_signatures;
+
+    /// Whether the results file contains the resource usage of test cases.
+    bool _has_usage;
+
+    /// Whether the results file records test cases suspected of interference.
+    bool _has_interference;
+
     /// The statement to iterate on.
     sqlite::statement _stmt;
 
@@ -267,21 +309,63 @@ struct store::results_iterator::impl : utils::noncopyable {
 
     /// Constructor.
     ///
+    /// The iterator is not valid until start() is called, which gives the
+    /// caller a chance to bind any parameters referenced by the filter.
+    ///
     /// \param backend_ The store backend implementation.
-    impl(store::read_backend& backend_) :
+    /// \param filter SQL expression to restrict the results to return, to be
+    ///     placed in a WHERE clause.  May refer to the columns of the
+    ///     test_programs, test_cases and test_results tables.
+    impl(store::read_backend& backend_, const std::string& filter) :
         _backend(backend_),
+        _has_signatures(detail::has_failure_signatures(backend_.database())),
+        _has_usage(detail::has_resource_usage(backend_.database())),
+        _has_interference(detail::has_interference(backend_.database())),
         _stmt(backend_.database().create_statement(
             "SELECT test_programs.test_program_id, "
             "    test_programs.interface, "
             "    test_cases.test_case_id, test_cases.name, "
             "    test_results.result_type, test_results.result_reason, "
-            "    test_results.start_time, test_results.end_time "
+            "    test_results.start_time, test_results.end_time, " +
+            std::string(_has_signatures ?
+                        "failure_signatures.signature, " :
+                        "NULL AS signature, ") +
+            std::string(_has_usage ?
+                        "resource_usage.cpu_time, resource_usage.max_rss, " :
+                        "NULL AS cpu_time, NULL AS max_rss, ") +
+            std::string(_has_interference ?
+                        "interference.result_type AS interference_type, "
+                        "interference.result_reason AS interference_reason, "
+                        "interference.overlapping " :
+                        "NULL AS interference_type, "
+                        "NULL AS interference_reason, "
+                        "NULL AS overlapping ") +
             "FROM test_programs "
             "    JOIN test_cases "
             "    ON test_programs.test_program_id = test_cases.test_program_id "
             "    JOIN test_results "
-            "    ON test_cases.test_case_id = test_results.test_case_id "
-            "ORDER BY test_programs.absolute_path, test_cases.name"))
+            "    ON test_cases.test_case_id = test_results.test_case_id " +
+            std::string(_has_signatures ?
+                        "    LEFT JOIN failure_signatures "
+                        "    ON test_cases.test_case_id = "
+                        "        failure_signatures.test_case_id " : "") +
+            std::string(_has_usage ?
+                        "    LEFT JOIN resource_usage "
+                        "    ON test_cases.test_case_id = "
+                        "        resource_usage.test_case_id " : "") +
+            std::string(_has_interference ?
+                        "    LEFT JOIN interference "
+                        "    ON test_cases.test_case_id = "
+                        "        interference.test_case_id " : "") +
+            "WHERE " + filter + " "
+            "ORDER BY test_programs.absolute_path, test_cases.name")),
+        _valid(false)
+    {
+    }
+
+    /// Positions the iterator on the first result.
+    void
+    start(void)
     {
         _valid = _stmt.step();
     }
@@ -342,6 +426,17 @@ store::results_iterator::test_program(void) const
 }
 
 
+/// Gets the identifier of the test case pointed by the iterator.
+///
+/// \return An identifier, unique within the results file, that can later be
+/// passed to read_transaction::get_result().
+int64_t
+store::results_iterator::test_case_id(void) const
+{
+    return _pimpl->_stmt.safe_column_int64("test_case_id");
+}
+
+
 /// Gets the name of the test case pointed by the iterator.
 ///
 /// The caller can look up the test case data by using the find() method on the
@@ -437,6 +532,103 @@ store::results_iterator::stderr_contents(void) const
 }
 
 
+/// Gets the signature of the failure of the current result.
+///
+/// Results files created before failure signatures were introduced do not
+/// store them, in which case the signature is computed on the fly.
+///
+/// \return The signature of the failure, or an empty string if the result is
+/// not a failure.
+std::string
+store::results_iterator::failure_signature(void) const
+{
+    const model::test_result test_result = result();
+    if (!has_failure_signature(test_result))
+        return "";
+
+    if (_pimpl->_has_signatures) {
+        const int column = _pimpl->_stmt.column_id("signature");
+        if (_pimpl->_stmt.column_type(column) == sqlite::type_text)
+            return _pimpl->_stmt.column_text(column);
+    }
+    return store::failure_signature(test_result, stderr_contents());
+}
+
+
+/// Gets the CPU time consumed by the test case of the current result.
+///
+/// \return The user and system CPU time, or none if the results file does not
+/// record it for this test case.
+optional< datetime::delta >
+store::results_iterator::cpu_time(void) const
+{
+    const int column = _pimpl->_stmt.column_id("cpu_time");
+    if (_pimpl->_stmt.column_type(column) == sqlite::type_null)
+        return none;
+    return utils::make_optional(column_delta(_pimpl->_stmt, "cpu_time"));
+}
+
+
+/// Gets the peak resident memory used by the test case of the current result.
+///
+/// \return The maximum resident set size, or none if the results file does
+/// not record it for this test case.
+optional< units::bytes >
+store::results_iterator::max_rss(void) const
+{
+    const int column = _pimpl->_stmt.column_id("max_rss");
+    if (_pimpl->_stmt.column_type(column) == sqlite::type_null)
+        return none;
+    return utils::make_optional(units::bytes(static_cast< uint64_t >(
+        _pimpl->_stmt.column_int64(column))));
+}
+
+
+/// Gets the result of the concurrent execution of a suspicious test case.
+///
+/// Test cases that failed while running concurrently with others but passed
+/// when re-run on their own are suspected of suffering from interference.  The
+/// result of the current test case is that of the latter execution.
+///
+/// \return The result of the execution that ran concurrently with others, or
+/// none if the test case is not suspected of suffering from interference.
+///
+/// \throw integrity_error If the data in the database is invalid.
+optional< model::test_result >
+store::results_iterator::interference(void) const
+{
+    const int column = _pimpl->_stmt.column_id("interference_type");
+    if (_pimpl->_stmt.column_type(column) == sqlite::type_null)
+        return none;
+    return utils::make_optional(parse_result(
+        _pimpl->_stmt, "interference_type", "interference_reason"));
+}
+
+
+/// Gets the test cases that ran concurrently with a suspicious test case.
+///
+/// \return The identifiers of the test cases, in the form program:case, that
+/// overlapped with the execution that failed.  Empty if the test case is not
+/// suspected of suffering from interference.
+std::vector< std::string >
+store::results_iterator::interfering_tests(void) const
+{
+    std::vector< std::string > tests;
+
+    const int column = _pimpl->_stmt.column_id("overlapping");
+    if (_pimpl->_stmt.column_type(column) == sqlite::type_null)
+        return tests;
+
+    std::istringstream input(_pimpl->_stmt.column_text(column));
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty())
+            tests.push_back(line);
+    }
+    return tests;
+}
+
+
 /// Internal implementation for a store read-only transaction.
 struct store::read_transaction::impl : utils::noncopyable {
     /// The backend instance.
@@ -524,9 +716,239 @@ store::results_iterator
 store::read_transaction::get_results(void)
 {
     try {
-        return results_iterator(std::shared_ptr< results_iterator::impl >(
-           new results_iterator::impl(_pimpl->_backend)));
+        std::shared_ptr< results_iterator::impl > iter(
+            new results_iterator::impl(_pimpl->_backend, "1"));
+        iter->start();
+        return results_iterator(iter);
     } catch (const sqlite::error& e) {
         throw error(e.what());
     }
 }
+
+
+/// Creates a new iterator to scan the test results of some types only.
+///
+/// The filtering happens within the database so that the results of other
+/// types are never loaded.
+///
+/// \param types The result types to return.
+///
+/// \return The constructed iterator.
+///
+/// \throw error If there is any problem constructing the iterator.
+store::results_iterator
+store::read_transaction::get_results(
+    const std::set< model::test_result_type >& types)
+{
+    std::string filter;
+    for (std::size_t i = 0; i < types.size(); ++i) {
+        if (!filter.empty())
+            filter += ", ";
+        filter += F(":type%s") % i;
+    }
+    filter = F("test_results.result_type IN (%s)") % filter;
+
+    try {
+        std::shared_ptr< results_iterator::impl > iter(
+            new results_iterator::impl(_pimpl->_backend, filter));
+        std::size_t i = 0;
+        for (std::set< model::test_result_type >::const_iterator type =
+                 types.begin(); type != types.end(); ++type, ++i) {
+            const std::string param = F(":type%s") % i;
+            bind_test_result_type(iter->_stmt, param.c_str(), *type);
+        }
+        iter->start();
+        return results_iterator(iter);
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+}
+
+
+/// Creates an iterator pointing to the result of a single test case.
+///
+/// \param test_case_id The identifier of the test case to query, as returned by
+///     results_iterator::test_case_id().
+///
+/// \return The constructed iterator, which is invalid if the test case does not
+/// exist or does not have a result.
+///
+/// \throw error If there is any problem constructing the iterator.
+store::results_iterator
+store::read_transaction::get_result(const int64_t test_case_id)
+{
+    try {
+        std::shared_ptr< results_iterator::impl > iter(
+            new results_iterator::impl(
+                _pimpl->_backend,
+                "test_cases.test_case_id == :test_case_id"));
+        iter->_stmt.bind(":test_case_id", test_case_id);
+        iter->start();
+        return results_iterator(iter);
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+}
+
+
+/// Counts the number of test results of each type.
+///
+/// \return A map of result types to the number of test cases with such result.
+/// Types without any results are not present.
+///
+/// \throw error If there is any problem querying the database.
+std::map< model::test_result_type, std::size_t >
+store::read_transaction::count_results(void)
+{
+    std::map< model::test_result_type, std::size_t > counts;
+    try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "SELECT result_type, COUNT(*) AS count FROM test_results "
+            "GROUP BY result_type");
+        while (stmt.step()) {
+            counts[column_test_result_type(stmt, "result_type")] =
+                static_cast< std::size_t >(stmt.safe_column_int64("count"));
+        }
+    } catch (const sqlite::error& e) {
+        throw error(F("Error counting results: %s") % e.what());
+    }
+    return counts;
+}
+
+
+/// Gets the size of a file attached to a test case.
+///
+/// \param test_case_id The identifier of the test case.
+/// \param filename The name of the file to query; for example, __STDOUT__ or
+///     __STDERR__.
+///
+/// \return The size of the file in bytes, or none if the test case has no
+/// such file.
+///
+/// \throw error If there is any problem querying the database.
+optional< int64_t >
+store::read_transaction::get_test_case_file_size(const int64_t test_case_id,
+                                                 const std::string& filename)
+{
+    try {
+        // length() does not need to load the contents of blobs.
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "SELECT length(files.contents) AS size "
+            "FROM test_case_files "
+            "    JOIN files ON test_case_files.file_id = files.file_id "
+            "WHERE test_case_files.test_case_id == :test_case_id "
+            "    AND test_case_files.file_name == :file_name");
+        stmt.bind(":test_case_id", test_case_id);
+        stmt.bind(":file_name", filename);
+        if (!stmt.step())
+            return none;
+        return utils::make_optional(stmt.safe_column_int64("size"));
+    } catch (const sqlite::error& e) {
+        throw error(F("Error querying file %s: %s") % filename % e.what());
+    }
+}
+
+
+/// Gets a range of the contents of a file attached to a test case.
+///
+/// Only the requested bytes are loaded into memory, which allows reading huge
+/// files piece by piece.
+///
+/// \param test_case_id The identifier of the test case.
+/// \param filename The name of the file to query; for example, __STDOUT__ or
+///     __STDERR__.
+/// \param offset The position of the first byte to return.
+/// \param length The maximum number of bytes to return.
+///
+/// \return The requested bytes, which may be fewer than length if the end of
+/// the file is reached, or empty if the test case has no such file.
+///
+/// \throw error If there is any problem querying the database.
+std::string
+store::read_transaction::get_test_case_file_chunk(const int64_t test_case_id,
+                                                  const std::string& filename,
+                                                  const int64_t offset,
+                                                  const int64_t length)
+{
+    PRE(offset >= 0);
+    PRE(length >= 0);
+
+    try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "SELECT file_id FROM test_case_files "
+            "WHERE test_case_id == :test_case_id AND file_name == :file_name");
+        stmt.bind(":test_case_id", test_case_id);
+        stmt.bind(":file_name", filename);
+        if (!stmt.step())
+            return "";
+        return _pimpl->_db.read_blob("files", "contents",
+                                     stmt.safe_column_int64("file_id"),
+                                     offset,
+                                     static_cast< std::size_t >(length));
+    } catch (const sqlite::error& e) {
+        throw error(F("Error reading file %s: %s") % filename % e.what());
+    }
+}
+
+
+/// Checks whether the results file contains an output index.
+///
+/// \return True if search_output() can be used.
+///
+/// \throw error If there is any problem querying the database.
+bool
+store::read_transaction::has_output_index(void)
+{
+    try {
+        return detail::has_output_index(_pimpl->_db);
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+}
+
+
+/// Searches the output of the test cases for a query.
+///
+/// \pre The results file contains an output index.
+///
+/// \param query The query to search for, in the syntax of FTS5 queries.  In
+///     its simplest form, this is a list of words that must all appear in the
+///     same text.
+///
+/// \return The texts that matched the query, sorted by test program and test
+/// case name.
+///
+/// \throw error If the query is invalid or if there is any problem querying
+///     the database.
+std::vector< store::output_match >
+store::read_transaction::search_output(const std::string& query)
+{
+    std::vector< output_match > matches;
+    try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "SELECT output_index.test_case_id AS test_case_id, "
+            "    test_programs.relative_path, test_cases.name, "
+            "    output_index.source AS source, "
+            "    snippet(output_index, 0, '[', ']', '...', 12) AS snippet "
+            "FROM output_index "
+            "    JOIN test_cases "
+            "    ON output_index.test_case_id = test_cases.test_case_id "
+            "    JOIN test_programs "
+            "    ON test_cases.test_program_id = test_programs.test_program_id "
+            "WHERE output_index MATCH :query "
+            "ORDER BY test_programs.absolute_path, test_cases.name, "
+            "    output_index.source");
+        stmt.bind(":query", query);
+        while (stmt.step()) {
+            matches.push_back(output_match(
+                stmt.safe_column_int64("test_case_id"),
+                fs::path(stmt.safe_column_text("relative_path")),
+                stmt.safe_column_text("name"),
+                stmt.safe_column_text("source"),
+                stmt.safe_column_text("snippet")));
+        }
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot search output for '%s': %s") % query % e.what());
+    }
+    return matches;
+}
@@ -38,15 +38,22 @@ extern "C" {
 #include <stdint.h>
 }
 
+#include <cstddef>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "model/context_fwd.hpp"
 #include "model/test_program_fwd.hpp"
 #include "model/test_result_fwd.hpp"
+#include "store/output_index.hpp"
 #include "store/read_backend_fwd.hpp"
 #include "store/read_transaction_fwd.hpp"
 #include "utils/datetime_fwd.hpp"
+#include "utils/optional_fwd.hpp"
+#include "utils/units_fwd.hpp"
 
 namespace store {
 
@@ -82,6 +89,7 @@ public:
     operator bool(void) const;
 
     const model::test_program_ptr test_program(void) const;
+    int64_t test_case_id(void) const;
     std::string test_case_name(void) const;
     model::test_result result(void) const;
     utils::datetime::timestamp start_time(void) const;
@@ -89,6 +97,11 @@ public:
 
     std::string stdout_contents(void) const;
     std::string stderr_contents(void) const;
+    std::string failure_signature(void) const;
+    utils::optional< utils::datetime::delta > cpu_time(void) const;
+    utils::optional< utils::units::bytes > max_rss(void) const;
+    utils::optional< model::test_result > interference(void) const;
+    std::vector< std::string > interfering_tests(void) const;
 };
 
 
@@ -112,6 +125,16 @@ public:
 
     model::context get_context(void);
     results_iterator get_results(void);
+    results_iterator get_results(const std::set< model::test_result_type >&);
+    results_iterator get_result(const int64_t);
+    std::map< model::test_result_type, std::size_t > count_results(void);
+    utils::optional< int64_t > get_test_case_file_size(const int64_t,
+                                                       const std::string&);
+    std::string get_test_case_file_chunk(const int64_t, const std::string&,
+                                         const int64_t, const int64_t);
+
+    bool has_output_index(void);
+    std::vector< output_match > search_output(const std::string&);
 };
 
 
@@ -29,7 +29,9 @@
 #include "store/read_transaction.hpp"
 
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include <atf-c++.hpp>
 
@@ -42,6 +44,7 @@
 #include "store/write_backend.hpp"
 #include "store/write_transaction.hpp"
 #include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/operations.hpp"
 #include "utils/optional.ipp"
@@ -54,6 +57,57 @@ namespace logging = utils::logging;
 namespace sqlite = utils::sqlite;
 
 
+namespace {
+
+
+/// Creates a results file with one test case for each given result.
+///
+/// Test case number i is named "case<i>" and its stdout contains "out<i>".
+///
+/// \param file The results file to create.
+/// \param results The results of the test cases to store.
+///
+/// \return The identifiers of the stored test cases, in the same order as the
+/// results.
+static std::vector< int64_t >
+populate(const fs::path& file, const std::vector< model::test_result >& results)
+{
+    store::write_backend backend = store::write_backend::open_rw(file);
+    store::write_transaction tx = backend.start_write();
+
+    tx.put_context(model::context(fs::path("/foo/bar"),
+                                  std::map< std::string, std::string >()));
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 10, 00, 0);
+    const datetime::timestamp end_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 15, 30, 0);
+
+    model::test_program_builder builder(
+        "plain", fs::path("prog"), fs::path("/the/root"), "suite");
+    for (std::size_t i = 0; i < results.size(); ++i)
+        builder.add_test_case(F("case%s") % i);
+    const model::test_program test_program = builder.build();
+    const int64_t tp_id = tx.put_test_program(test_program);
+
+    std::vector< int64_t > ids;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const int64_t tc_id = tx.put_test_case(test_program, F("case%s") % i,
+                                               tp_id);
+        atf::utils::create_file("out.txt", F("out%s") % i);
+        tx.put_test_case_file("__STDOUT__", fs::path("out.txt"), tc_id);
+        tx.put_result(results[i], tc_id, start_time, end_time);
+        ids.push_back(tc_id);
+    }
+
+    tx.commit();
+    backend.close();
+    return ids;
+}
+
+
+}  // anonymous namespace
+
 ATF_TEST_CASE(get_context__missing);
 ATF_TEST_CASE_HEAD(get_context__missing)
 {
@@ -251,6 +305,130 @@ ATF_TEST_CASE_BODY(get_results__many)
 }
 
 
+ATF_TEST_CASE(get_results__by_type);
+ATF_TEST_CASE_HEAD(get_results__by_type)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_results__by_type)
+{
+    std::vector< model::test_result > results;
+    results.push_back(model::test_result(model::test_result_passed));
+    results.push_back(model::test_result(model::test_result_failed, "A"));
+    results.push_back(model::test_result(model::test_result_skipped, "B"));
+    results.push_back(model::test_result(model::test_result_failed, "C"));
+    populate(fs::path("test.db"), results);
+
+    store::read_backend backend = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx = backend.start_read();
+
+    std::set< model::test_result_type > types;
+    ATF_REQUIRE(!tx.get_results(types));
+
+    types.insert(model::test_result_failed);
+    types.insert(model::test_result_skipped);
+    store::results_iterator iter = tx.get_results(types);
+    ATF_REQUIRE(iter);
+    ATF_REQUIRE_EQ("case1", iter.test_case_name());
+    ATF_REQUIRE_EQ(results[1], iter.result());
+    ATF_REQUIRE(++iter);
+    ATF_REQUIRE_EQ("case2", iter.test_case_name());
+    ATF_REQUIRE_EQ(results[2], iter.result());
+    ATF_REQUIRE(++iter);
+    ATF_REQUIRE_EQ("case3", iter.test_case_name());
+    ATF_REQUIRE_EQ(results[3], iter.result());
+    ATF_REQUIRE(!++iter);
+}
+
+
+ATF_TEST_CASE(get_result);
+ATF_TEST_CASE_HEAD(get_result)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_result)
+{
+    std::vector< model::test_result > results;
+    results.push_back(model::test_result(model::test_result_passed));
+    results.push_back(model::test_result(model::test_result_broken, "A"));
+    const std::vector< int64_t > ids = populate(fs::path("test.db"), results);
+
+    store::read_backend backend = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx = backend.start_read();
+
+    store::results_iterator iter = tx.get_result(ids[1]);
+    ATF_REQUIRE(iter);
+    ATF_REQUIRE_EQ(ids[1], iter.test_case_id());
+    ATF_REQUIRE_EQ("case1", iter.test_case_name());
+    ATF_REQUIRE_EQ(results[1], iter.result());
+    ATF_REQUIRE_EQ("out1", iter.stdout_contents());
+    ATF_REQUIRE(!++iter);
+
+    ATF_REQUIRE(!tx.get_result(ids[1] + 100));
+}
+
+
+ATF_TEST_CASE(count_results);
+ATF_TEST_CASE_HEAD(count_results)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(count_results)
+{
+    std::vector< model::test_result > results;
+    results.push_back(model::test_result(model::test_result_passed));
+    results.push_back(model::test_result(model::test_result_failed, "A"));
+    results.push_back(model::test_result(model::test_result_passed));
+    populate(fs::path("test.db"), results);
+
+    store::read_backend backend = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx = backend.start_read();
+
+    std::map< model::test_result_type, std::size_t > exp_counts;
+    exp_counts[model::test_result_passed] = 2;
+    exp_counts[model::test_result_failed] = 1;
+    ATF_REQUIRE(exp_counts == tx.count_results());
+}
+
+
+ATF_TEST_CASE(get_test_case_file);
+ATF_TEST_CASE_HEAD(get_test_case_file)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(get_test_case_file)
+{
+    std::vector< model::test_result > results;
+    for (int i = 0; i < 12; ++i)
+        results.push_back(model::test_result(model::test_result_passed));
+    const std::vector< int64_t > ids = populate(fs::path("test.db"), results);
+
+    store::read_backend backend = store::read_backend::open_ro(
+        fs::path("test.db"));
+    store::read_transaction tx = backend.start_read();
+
+    ATF_REQUIRE_EQ(5, tx.get_test_case_file_size(ids[11], "__STDOUT__").get());
+    ATF_REQUIRE(!tx.get_test_case_file_size(ids[11], "__STDERR__"));
+
+    ATF_REQUIRE_EQ("out11",
+                   tx.get_test_case_file_chunk(ids[11], "__STDOUT__", 0, 5));
+    ATF_REQUIRE_EQ("t1",
+                   tx.get_test_case_file_chunk(ids[11], "__STDOUT__", 2, 2));
+    ATF_REQUIRE_EQ("11",
+                   tx.get_test_case_file_chunk(ids[11], "__STDOUT__", 3, 10));
+    ATF_REQUIRE(tx.get_test_case_file_chunk(ids[11], "__STDOUT__", 5,
+                                            10).empty());
+    ATF_REQUIRE(tx.get_test_case_file_chunk(ids[11], "__STDERR__", 0,
+                                            10).empty());
+}
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, get_context__missing);
@@ -259,4 +437,8 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, get_results__none);
     ATF_ADD_TEST_CASE(tcs, get_results__many);
+    ATF_ADD_TEST_CASE(tcs, get_results__by_type);
+    ATF_ADD_TEST_CASE(tcs, get_result);
+    ATF_ADD_TEST_CASE(tcs, count_results);
+    ATF_ADD_TEST_CASE(tcs, get_test_case_file);
 }
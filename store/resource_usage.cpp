@@ -0,0 +1,75 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "store/resource_usage.hpp"
+
+#include "store/exceptions.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/sqlite/database.hpp"
+#include "utils/sqlite/exceptions.hpp"
+#include "utils/sqlite/statement.ipp"
+
+namespace sqlite = utils::sqlite;
+
+
+/// Checks whether a database contains the resource usage table.
+///
+/// \param db The database to check.
+///
+/// \return True if the table exists.
+///
+/// \throw sqlite::error If there is a problem querying the database.
+bool
+store::detail::has_resource_usage(sqlite::database& db)
+{
+    sqlite::statement stmt = db.create_statement(
+        "SELECT name FROM sqlite_master "
+        "WHERE type == 'table' AND name == 'resource_usage'");
+    return stmt.step();
+}
+
+
+/// Creates the resource usage table in a database.
+///
+/// \param db The database in which to create the table.  Nothing is done if the
+///     table already exists.
+///
+/// \throw store::error If the table cannot be created.
+void
+store::detail::create_resource_usage(sqlite::database& db)
+{
+    try {
+        db.exec("CREATE TABLE IF NOT EXISTS resource_usage ("
+                "    test_case_id INTEGER PRIMARY KEY REFERENCES test_cases, "
+                "    cpu_time INTEGER NOT NULL, "
+                "    max_rss INTEGER NOT NULL)");
+    } catch (const sqlite::error& e) {
+        throw store::error(F("Cannot create resource usage table: %s") %
+                           e.what());
+    }
+}
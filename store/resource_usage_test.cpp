@@ -0,0 +1,192 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "store/resource_usage.hpp"
+
+extern "C" {
+#include <stdint.h>
+}
+
+#include <map>
+#include <string>
+
+#include <atf-c++.hpp>
+
+#include "model/context.hpp"
+#include "model/test_program.hpp"
+#include "model/test_result.hpp"
+#include "store/read_backend.hpp"
+#include "store/read_transaction.hpp"
+#include "store/write_backend.hpp"
+#include "store/write_transaction.hpp"
+#include "utils/datetime.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/operations.hpp"
+#include "utils/optional.ipp"
+#include "utils/sqlite/database.hpp"
+#include "utils/units.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace logging = utils::logging;
+namespace sqlite = utils::sqlite;
+namespace units = utils::units;
+
+using utils::optional;
+
+
+namespace {
+
+
+/// Creates a results file with two test cases.
+///
+/// Only the first test case has its resource usage recorded.
+///
+/// \param file The results file to create.
+static void
+populate(const fs::path& file)
+{
+    store::write_backend backend = store::write_backend::open_rw(file);
+    store::write_transaction tx = backend.start_write();
+
+    tx.put_context(model::context(fs::path("/foo/bar"),
+                                  std::map< std::string, std::string >()));
+
+    const datetime::timestamp start_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 10, 00, 0);
+    const datetime::timestamp end_time = datetime::timestamp::from_values(
+        2016, 01, 30, 22, 15, 30, 0);
+
+    const model::test_program test_program = model::test_program_builder(
+        "plain", fs::path("dir/prog"), fs::path("/the/root"), "suite")
+        .add_test_case("first").add_test_case("second").build();
+    const int64_t tp_id = tx.put_test_program(test_program);
+
+    const int64_t first_id = tx.put_test_case(test_program, "first", tp_id);
+    tx.put_result(model::test_result(model::test_result_passed),
+                  first_id, start_time, end_time);
+    tx.put_resource_usage(first_id, datetime::delta(12, 345),
+                          units::bytes(300 * units::MB));
+
+    const int64_t second_id = tx.put_test_case(test_program, "second", tp_id);
+    tx.put_result(model::test_result(model::test_result_passed),
+                  second_id, start_time, end_time);
+
+    tx.commit();
+    backend.close();
+}
+
+
+/// Resource usage of a test case as recorded in a results file.
+typedef std::pair< optional< datetime::delta >,
+                   optional< units::bytes > > usage_pair;
+
+
+/// Gets the resource usage of all the test cases in a results file.
+///
+/// \param file The results file to query.
+///
+/// \return A map of test case names to their resource usage.
+static std::map< std::string, usage_pair >
+get_usage(const fs::path& file)
+{
+    store::read_backend backend = store::read_backend::open_ro(file);
+    store::read_transaction tx = backend.start_read();
+
+    std::map< std::string, usage_pair > usage;
+    for (store::results_iterator iter = tx.get_results(); iter; ++iter)
+        usage[iter.test_case_name()] = usage_pair(iter.cpu_time(),
+                                                  iter.max_rss());
+    return usage;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE(stored_at_write_time);
+ATF_TEST_CASE_HEAD(stored_at_write_time)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(stored_at_write_time)
+{
+    populate(fs::path("test.db"));
+
+    const std::map< std::string, usage_pair > usage = get_usage(
+        fs::path("test.db"));
+    ATF_REQUIRE_EQ(2, usage.size());
+
+    const usage_pair& first = usage.find("first")->second;
+    ATF_REQUIRE(first.first);
+    ATF_REQUIRE_EQ(datetime::delta(12, 345), first.first.get());
+    ATF_REQUIRE(first.second);
+    ATF_REQUIRE_EQ(units::bytes(300 * units::MB), first.second.get());
+
+    const usage_pair& second = usage.find("second")->second;
+    ATF_REQUIRE(!second.first);
+    ATF_REQUIRE(!second.second);
+}
+
+
+ATF_TEST_CASE(missing_table);
+ATF_TEST_CASE_HEAD(missing_table)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(missing_table)
+{
+    populate(fs::path("test.db"));
+
+    {
+        sqlite::database db = sqlite::database::open(
+            fs::path("test.db"), sqlite::open_readwrite);
+        ATF_REQUIRE(store::detail::has_resource_usage(db));
+        db.exec("DROP TABLE resource_usage");
+        ATF_REQUIRE(!store::detail::has_resource_usage(db));
+        db.close();
+    }
+
+    const std::map< std::string, usage_pair > usage = get_usage(
+        fs::path("test.db"));
+    ATF_REQUIRE_EQ(2, usage.size());
+    for (std::map< std::string, usage_pair >::const_iterator
+             iter = usage.begin(); iter != usage.end(); ++iter) {
+        ATF_REQUIRE(!(*iter).second.first);
+        ATF_REQUIRE(!(*iter).second.second);
+    }
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, stored_at_write_time);
+    ATF_ADD_TEST_CASE(tcs, missing_table);
+}
@@ -28,17 +28,25 @@
 
 #include "store/write_backend.hpp"
 
+#include <fstream>
 #include <stdexcept>
 
 #include "store/exceptions.hpp"
+#include "store/failure_signature.hpp"
+#include "store/interference.hpp"
 #include "store/metadata.hpp"
+#include "store/output_index.hpp"
 #include "store/read_backend.hpp"
+#include "store/resource_usage.hpp"
 #include "store/write_transaction.hpp"
 #include "utils/env.hpp"
 #include "utils/format/macros.hpp"
+#include "utils/fs/exceptions.hpp"
+#include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/noncopyable.hpp"
+#include "utils/optional.ipp"
 #include "utils/sanity.hpp"
 #include "utils/stream.hpp"
 #include "utils/sqlite/database.hpp"
@@ -48,6 +56,9 @@
 namespace fs = utils::fs;
 namespace sqlite = utils::sqlite;
 
+using utils::none;
+using utils::optional;
+
 
 /// The current schema version.
 ///
@@ -130,15 +141,66 @@ store::detail::initialize(sqlite::database& db)
 }
 
 
+/// Calculates the path to the in-use marker of a results file.
+///
+/// \param file The results file.
+///
+/// \return The path to the marker, which lives next to the results file.
+fs::path
+store::detail::in_use_marker_file(const fs::path& file)
+{
+    return fs::path(file.str() + ".in-use");
+}
+
+
+/// Creates the in-use marker of a results file.
+///
+/// \param file The results file about to be modified.
+///
+/// \throw store::error If the marker cannot be created.
+store::detail::in_use_marker::in_use_marker(const fs::path& file) :
+    _marker(in_use_marker_file(file).str())
+{
+    std::ofstream output(_marker.c_str());
+    if (!output)
+        throw error(F("Cannot create %s") % _marker);
+}
+
+
+/// Removes the in-use marker of a results file.
+store::detail::in_use_marker::~in_use_marker(void)
+{
+    try {
+        fs::unlink(fs::path(_marker));
+    } catch (const fs::error& e) {
+        LW(F("Failed to remove %s: %s") % _marker % e.what());
+    }
+}
+
+
 /// Internal implementation for the backend.
 struct store::write_backend::impl : utils::noncopyable {
+    /// Marker of the results file, removed once the databases are closed.
+    std::shared_ptr< detail::in_use_marker > marker;
+
     /// The SQLite database this backend talks to.
     sqlite::database database;
 
+    /// The on-disk database to which to save the staged database, if any.
+    optional< sqlite::database > staging_target;
+
     /// Constructor.
     ///
+    /// \param marker_ Marker of the results file.
     /// \param database_ The SQLite database instance.
-    impl(sqlite::database& database_) : database(database_)
+    /// \param staging_target_ If not none, the on-disk database to which to
+    ///     save database, which must then be an in-memory database.
+    impl(const std::shared_ptr< detail::in_use_marker >& marker_,
+         sqlite::database& database_,
+         const optional< sqlite::database >& staging_target_ = none) :
+        marker(marker_),
+        database(database_),
+        staging_target(staging_target_)
     {
     }
 };
@@ -161,6 +223,9 @@ store::write_backend::~write_backend(void)
 
 /// Opens a database in read-write mode and creates it if necessary.
 ///
+/// The file is flagged as in use until the backend is closed; see
+/// detail::in_use_marker.
+///
 /// \param file The database file to be opened.
 ///
 /// \return The backend representation.
@@ -170,21 +235,109 @@ store::write_backend::~write_backend(void)
 store::write_backend
 store::write_backend::open_rw(const fs::path& file)
 {
+    std::shared_ptr< detail::in_use_marker > marker(
+        new detail::in_use_marker(file));
     sqlite::database db = detail::open_and_setup(
         file, sqlite::open_readwrite | sqlite::open_create);
     if (!empty_database(db))
         throw error(F("%s already exists and is not empty; cannot open "
                       "for write") % file);
     detail::initialize(db);
-    return write_backend(new impl(db));
+    detail::create_failure_signatures(db);
+    detail::create_resource_usage(db);
+    detail::create_interference(db);
+    return write_backend(new impl(marker, db));
+}
+
+
+/// Opens a new database that is staged in memory.
+///
+/// All writes go to an in-memory database, which is only saved to the file
+/// when flush() is called.  This avoids any disk I/O while the database is
+/// being populated at the cost of losing the changes since the last flush if
+/// the process dies.  As with open_rw(), the file is flagged as in use until
+/// the backend is closed.
+///
+/// \param file The database file to be created.
+///
+/// \return The backend representation.
+///
+/// \throw store::error If there is any problem opening or creating
+///     the database.
+store::write_backend
+store::write_backend::open_staged(const fs::path& file)
+{
+    std::shared_ptr< detail::in_use_marker > marker(
+        new detail::in_use_marker(file));
+    sqlite::database target = detail::open_and_setup(
+        file, sqlite::open_readwrite | sqlite::open_create);
+    if (!empty_database(target))
+        throw error(F("%s already exists and is not empty; cannot open "
+                      "for write") % file);
+
+    sqlite::database db = sqlite::database::in_memory();
+    try {
+        db.exec("PRAGMA foreign_keys = ON");
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot set up staging database: %s") % e.what());
+    }
+    detail::initialize(db);
+    detail::create_failure_signatures(db);
+    detail::create_resource_usage(db);
+    detail::create_interference(db);
+
+    write_backend backend(new impl(marker, db, utils::make_optional(target)));
+    backend.flush();
+    return backend;
 }
 
 
 /// Closes the SQLite database.
+///
+/// Any changes to a staged database that have not been flushed are lost.
 void
 store::write_backend::close(void)
 {
     _pimpl->database.close();
+    if (_pimpl->staging_target)
+        _pimpl->staging_target.get().close();
+    _pimpl->marker.reset();
+}
+
+
+/// Saves a staged database to its file.
+///
+/// Only committed changes are saved.  This is a no-op for databases that are
+/// not staged.
+///
+/// \throw store::error If the database cannot be saved.
+void
+store::write_backend::flush(void)
+{
+    if (!_pimpl->staging_target)
+        return;
+
+    LD("Saving staged database");
+    try {
+        _pimpl->database.backup_to(_pimpl->staging_target.get());
+    } catch (const sqlite::error& e) {
+        throw error(F("Cannot save staged database to %s: %s") %
+                    _pimpl->staging_target.get().db_filename().get() %
+                    e.what());
+    }
+}
+
+
+/// Creates the output index in the database.
+///
+/// Transactions started after this call add the output of the test cases and
+/// the reasons of their results to the index as they are stored.
+///
+/// \throw store::error If the index cannot be created.
+void
+store::write_backend::create_output_index(void)
+{
+    detail::create_output_index(_pimpl->database);
 }
 
 
@@ -35,10 +35,12 @@
 #include "store/write_backend_fwd.hpp"
 
 #include <memory>
+#include <string>
 
 #include "store/metadata_fwd.hpp"
 #include "store/write_transaction_fwd.hpp"
 #include "utils/fs/path_fwd.hpp"
+#include "utils/noncopyable.hpp"
 #include "utils/sqlite/database_fwd.hpp"
 
 namespace store {
@@ -49,6 +51,21 @@ namespace detail {
 
 utils::fs::path schema_file(void);
 metadata initialize(utils::sqlite::database&);
+utils::fs::path in_use_marker_file(const utils::fs::path&);
+
+
+/// Flags a results file as being modified in place while this object lives.
+///
+/// Readers check for the marker to decide whether the results file can be
+/// opened as immutable; see read_backend::open_ro_immutable().
+class in_use_marker : utils::noncopyable {
+    /// Path to the marker file.
+    std::string _marker;
+
+public:
+    explicit in_use_marker(const utils::fs::path&);
+    ~in_use_marker(void);
+};
 
 
 }  // anonymous namespace
@@ -69,7 +86,11 @@ public:
     ~write_backend(void);
 
     static write_backend open_rw(const utils::fs::path&);
+    static write_backend open_staged(const utils::fs::path&);
     void close(void);
+    void flush(void);
+
+    void create_output_index(void);
 
     utils::sqlite::database& database(void);
     write_transaction start_write(void);
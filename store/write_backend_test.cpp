@@ -34,6 +34,7 @@
 #include "store/metadata.hpp"
 #include "utils/datetime.hpp"
 #include "utils/env.hpp"
+#include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/operations.hpp"
 #include "utils/sqlite/database.hpp"
@@ -188,6 +189,95 @@ ATF_TEST_CASE_BODY(write_backend__close)
 }
 
 
+ATF_TEST_CASE(write_backend__in_use_marker);
+ATF_TEST_CASE_HEAD(write_backend__in_use_marker)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_backend__in_use_marker)
+{
+    {
+        store::write_backend backend = store::write_backend::open_rw(
+            fs::path("rw.db"));
+        ATF_REQUIRE(fs::exists(fs::path("rw.db.in-use")));
+        backend.close();
+        ATF_REQUIRE(!fs::exists(fs::path("rw.db.in-use")));
+    }
+
+    {
+        store::write_backend backend = store::write_backend::open_staged(
+            fs::path("staged.db"));
+        ATF_REQUIRE(fs::exists(fs::path("staged.db.in-use")));
+    }
+    ATF_REQUIRE(!fs::exists(fs::path("staged.db.in-use")));
+}
+
+
+ATF_TEST_CASE(write_backend__open_staged__flush);
+ATF_TEST_CASE_HEAD(write_backend__open_staged__flush)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_backend__open_staged__flush)
+{
+    store::write_backend backend = store::write_backend::open_staged(
+        fs::path("test.db"));
+    backend.database().exec("CREATE TABLE staged (a INTEGER)");
+
+    {
+        sqlite::database db = sqlite::database::open(fs::path("test.db"),
+                                                     sqlite::open_readonly);
+        db.exec("SELECT * FROM metadata");
+        ATF_REQUIRE_THROW(sqlite::error, db.exec("SELECT * FROM staged"));
+    }
+
+    backend.flush();
+
+    {
+        sqlite::database db = sqlite::database::open(fs::path("test.db"),
+                                                     sqlite::open_readonly);
+        db.exec("SELECT * FROM metadata");
+        db.exec("SELECT * FROM staged");
+    }
+}
+
+
+ATF_TEST_CASE(write_backend__open_staged__error_if_not_empty);
+ATF_TEST_CASE_HEAD(write_backend__open_staged__error_if_not_empty)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_backend__open_staged__error_if_not_empty)
+{
+    {
+        sqlite::database db = sqlite::database::open(
+            fs::path("test.db"), sqlite::open_readwrite | sqlite::open_create);
+        store::detail::initialize(db);
+    }
+    ATF_REQUIRE_THROW_RE(store::error, "test.db already exists",
+                         store::write_backend::open_staged(
+                             fs::path("test.db")));
+}
+
+
+ATF_TEST_CASE(write_backend__flush__not_staged);
+ATF_TEST_CASE_HEAD(write_backend__flush__not_staged)
+{
+    logging::set_inmemory();
+    set_md_var("require.files", store::detail::schema_file().c_str());
+}
+ATF_TEST_CASE_BODY(write_backend__flush__not_staged)
+{
+    store::write_backend backend = store::write_backend::open_rw(
+        fs::path("test.db"));
+    backend.flush();
+    backend.database().exec("SELECT * FROM metadata");
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, detail__initialize__ok);
@@ -200,5 +290,9 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, write_backend__open_rw__ok_if_empty);
     ATF_ADD_TEST_CASE(tcs, write_backend__open_rw__error_if_not_empty);
     ATF_ADD_TEST_CASE(tcs, write_backend__open_rw__create_missing);
+    ATF_ADD_TEST_CASE(tcs, write_backend__open_staged__flush);
+    ATF_ADD_TEST_CASE(tcs, write_backend__open_staged__error_if_not_empty);
+    ATF_ADD_TEST_CASE(tcs, write_backend__flush__not_staged);
     ATF_ADD_TEST_CASE(tcs, write_backend__close);
+    ATF_ADD_TEST_CASE(tcs, write_backend__in_use_marker);
 }
@@ -34,6 +34,9 @@ extern "C" {
 
 #include <fstream>
 #include <map>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "model/context.hpp"
 #include "model/metadata.hpp"
@@ -43,10 +46,13 @@ extern "C" {
 #include "model/types.hpp"
 #include "store/dbtypes.hpp"
 #include "store/exceptions.hpp"
+#include "store/failure_signature.hpp"
+#include "store/output_index.hpp"
 #include "store/write_backend.hpp"
 #include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/heap_stats.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/noncopyable.hpp"
 #include "utils/optional.ipp"
@@ -56,10 +62,13 @@ extern "C" {
 #include "utils/sqlite/exceptions.hpp"
 #include "utils/sqlite/statement.ipp"
 #include "utils/sqlite/transaction.hpp"
+#include "utils/units.hpp"
 
 namespace datetime = utils::datetime;
 namespace fs = utils::fs;
+namespace heap_stats = utils::heap_stats;
 namespace sqlite = utils::sqlite;
+namespace units = utils::units;
 
 using utils::none;
 using utils::optional;
@@ -68,6 +77,10 @@ using utils::optional;
 namespace {
 
 
+/// Number of trailing bytes of stderr to consider for failure signatures.
+static const int64_t stderr_tail_bytes = 4096;
+
+
 /// Stores the environment variables of a context.
 ///
 /// \param db The SQLite database.
@@ -146,12 +159,13 @@ put_metadata(sqlite::database& db, const model::metadata& md)
 ///
 /// \param db The database into which to store the file.
 /// \param path Path to the file to be stored.
+/// \param [out] contents The contents of the file, if it was stored.
 ///
 /// \return The identifier of the stored file, or none if the file was empty.
 ///
 /// \throw sqlite::error If there are problems writing to the database.
 static optional< int64_t >
-put_file(sqlite::database& db, const fs::path& path)
+put_file(sqlite::database& db, const fs::path& path, std::string& contents)
 {
     std::ifstream input(path.c_str());
     if (!input)
@@ -171,7 +185,7 @@ put_file(sqlite::database& db, const fs::path& path)
     // consumption if we decide to store arbitrary files in the database (other
     // than stdout or stderr).  Should this happen, we need to investigate a
     // better way to feel blobs into SQLite.
-    const std::string contents = utils::read_stream(input);
+    contents = utils::read_stream(input);
 
     sqlite::statement stmt = db.create_statement(
         "INSERT INTO files (contents) VALUES (:contents)");
@@ -182,6 +196,44 @@ put_file(sqlite::database& db, const fs::path& path)
 }
 
 
+/// Fetches the last bytes of the stderr of a test case.
+///
+/// \param db The database to query.
+/// \param test_case_id The test case whose stderr to fetch.
+///
+/// \return The last few kilobytes of stderr, starting at a line boundary, or
+/// an empty string if the test case has not stored its stderr (yet).
+///
+/// \throw sqlite::error If there is a problem querying the database.
+static std::string
+get_stderr_tail(sqlite::database& db, const int64_t test_case_id)
+{
+    sqlite::statement stmt = db.create_statement(
+        "SELECT files.file_id, length(files.contents) AS size "
+        "FROM test_case_files "
+        "    JOIN files ON test_case_files.file_id = files.file_id "
+        "WHERE test_case_files.test_case_id == :test_case_id "
+        "    AND test_case_files.file_name == '__STDERR__'");
+    stmt.bind(":test_case_id", test_case_id);
+    if (!stmt.step())
+        return "";
+
+    const int64_t size = stmt.safe_column_int64("size");
+    const int64_t offset = size > stderr_tail_bytes ?
+        size - stderr_tail_bytes : 0;
+    std::string tail = db.read_blob("files", "contents",
+                                    stmt.safe_column_int64("file_id"), offset,
+                                    static_cast< std::size_t >(size - offset));
+    if (offset > 0) {
+        // Discard the first line, which is most likely incomplete.
+        const std::string::size_type newline = tail.find('\n');
+        tail.erase(0, newline == std::string::npos ? tail.length() :
+                   newline + 1);
+    }
+    return tail;
+}
+
+
 }  // anonymous namespace
 
 
@@ -196,13 +248,17 @@ struct store::write_transaction::impl : utils::noncopyable {
     /// The backing SQLite transaction.
     sqlite::transaction _tx;
 
+    /// Whether to add the output of the test cases to the output index.
+    bool _index_output;
+
     /// Opens a transaction.
     ///
     /// \param backend_ The backend this transaction is connected to.
     impl(write_backend& backend_) :
         _backend(backend_),
         _db(backend_.database()),
-        _tx(backend_.database().begin_transaction())
+        _tx(backend_.database().begin_transaction()),
+        _index_output(detail::has_output_index(_db))
     {
     }
 };
@@ -229,6 +285,8 @@ store::write_transaction::~write_transaction(void)
 void
 store::write_transaction::commit(void)
 {
+    heap_stats::scoped_phase phase(heap_stats::phase_store);
+
     try {
         _pimpl->_tx.commit();
     } catch (const sqlite::error& e) {
@@ -262,6 +320,8 @@ store::write_transaction::rollback(void)
 void
 store::write_transaction::put_context(const model::context& context)
 {
+    heap_stats::scoped_phase phase(heap_stats::phase_store);
+
     try {
         sqlite::statement stmt = _pimpl->_db.create_statement(
             "INSERT INTO contexts (cwd) VALUES (:cwd)");
@@ -289,6 +349,8 @@ int64_t
 store::write_transaction::put_test_program(
     const model::test_program& test_program)
 {
+    heap_stats::scoped_phase phase(heap_stats::phase_store);
+
     try {
         const int64_t metadata_id = put_metadata(
             _pimpl->_db, test_program.get_metadata());
@@ -333,6 +395,8 @@ store::write_transaction::put_test_case(const model::test_program& test_program,
                                         const std::string& test_case_name,
                                         const int64_t test_program_id)
 {
+    heap_stats::scoped_phase phase(heap_stats::phase_store);
+
     const model::test_case& test_case = test_program.find(test_case_name);
 
     try {
@@ -370,14 +434,22 @@ store::write_transaction::put_test_case_file(const std::string& name,
                                              const fs::path& path,
                                              const int64_t test_case_id)
 {
+    heap_stats::scoped_phase phase(heap_stats::phase_store);
+
     LD(F("Storing %s (%s) of test case %s") % name % path % test_case_id);
     try {
-        const optional< int64_t > file_id = put_file(_pimpl->_db, path);
+        std::string contents;
+        const optional< int64_t > file_id = put_file(_pimpl->_db, path,
+                                                     contents);
         if (!file_id) {
             LD("Not storing empty file");
             return none;
         }
 
+        if (_pimpl->_index_output)
+            detail::put_output_index_file(_pimpl->_db, file_id.get(),
+                                          test_case_id, name, contents);
+
         sqlite::statement stmt = _pimpl->_db.create_statement(
             "INSERT INTO test_case_files (test_case_id, file_name, file_id) "
             "VALUES (:test_case_id, :file_name, :file_id)");
@@ -395,6 +467,10 @@ store::write_transaction::put_test_case_file(const std::string& name,
 
 /// Puts a result into the database.
 ///
+/// If the result is a failure, its signature is computed and stored too.  The
+/// signature includes the last lines of the stderr of the test case, so the
+/// stderr should be stored with put_test_case_file() before calling this.
+///
 /// \pre The result has not been put yet.
 /// \post The result is stored into the database with a new identifier.
 ///
@@ -412,6 +488,8 @@ store::write_transaction::put_result(const model::test_result& result,
                                      const datetime::timestamp& start_time,
                                      const datetime::timestamp& end_time)
 {
+    heap_stats::scoped_phase phase(heap_stats::phase_store);
+
     try {
         sqlite::statement stmt = _pimpl->_db.create_statement(
             "INSERT INTO test_results (test_case_id, result_type, "
@@ -433,8 +511,101 @@ store::write_transaction::put_result(const model::test_result& result,
         stmt.step_without_results();
         const int64_t result_id = _pimpl->_db.last_insert_rowid();
 
+        if (_pimpl->_index_output && !result.reason().empty())
+            detail::put_output_index_reason(_pimpl->_db, test_case_id,
+                                            result.reason());
+
+        if (has_failure_signature(result)) {
+            sqlite::statement signature_stmt = _pimpl->_db.create_statement(
+                "INSERT INTO failure_signatures (test_case_id, signature) "
+                "VALUES (:test_case_id, :signature)");
+            signature_stmt.bind(":test_case_id", test_case_id);
+            signature_stmt.bind(":signature", failure_signature(
+                result, get_stderr_tail(_pimpl->_db, test_case_id)));
+            signature_stmt.step_without_results();
+        }
+
         return result_id;
     } catch (const sqlite::error& e) {
         throw error(e.what());
     }
 }
+
+
+/// Puts the resources consumed by a test case into the database.
+///
+/// \pre The resource usage of the test case has not been put yet.
+///
+/// \param test_case_id The test case the usage corresponds to.
+/// \param cpu_time The user and system CPU time consumed by the test case.
+/// \param max_rss The peak resident memory used by the test case.
+///
+/// \throw error If there is any problem when talking to the database.
+void
+store::write_transaction::put_resource_usage(const int64_t test_case_id,
+                                             const datetime::delta& cpu_time,
+                                             const units::bytes& max_rss)
+{
+    heap_stats::scoped_phase phase(heap_stats::phase_store);
+
+    try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "INSERT INTO resource_usage (test_case_id, cpu_time, max_rss) "
+            "VALUES (:test_case_id, :cpu_time, :max_rss)");
+        stmt.bind(":test_case_id", test_case_id);
+        store::bind_delta(stmt, ":cpu_time", cpu_time);
+        stmt.bind(":max_rss", static_cast< int64_t >(
+            static_cast< uint64_t >(max_rss)));
+        stmt.step_without_results();
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+}
+
+
+/// Records that a test case is suspected of suffering from interference.
+///
+/// \pre The interference of the test case has not been put yet.
+///
+/// \param test_case_id The test case that failed when run concurrently with
+///     others but not on its own.
+/// \param concurrent_result The result of the execution of the test case that
+///     ran concurrently with others.
+/// \param overlapping The identifiers of the test cases that ran at the same
+///     time as the concurrent execution.
+///
+/// \throw error If there is any problem when talking to the database.
+void
+store::write_transaction::put_interference(
+    const int64_t test_case_id, const model::test_result& concurrent_result,
+    const std::vector< std::string >& overlapping)
+{
+    heap_stats::scoped_phase phase(heap_stats::phase_store);
+
+    std::ostringstream joined;
+    for (std::vector< std::string >::const_iterator iter = overlapping.begin();
+         iter != overlapping.end(); ++iter) {
+        if (iter != overlapping.begin())
+            joined << '\n';
+        joined << *iter;
+    }
+
+    try {
+        sqlite::statement stmt = _pimpl->_db.create_statement(
+            "INSERT INTO interference (test_case_id, result_type, "
+            "                          result_reason, overlapping) "
+            "VALUES (:test_case_id, :result_type, :result_reason, "
+            "        :overlapping)");
+        stmt.bind(":test_case_id", test_case_id);
+        store::bind_test_result_type(stmt, ":result_type",
+                                     concurrent_result.type());
+        if (concurrent_result.reason().empty())
+            stmt.bind(":result_reason", sqlite::null());
+        else
+            stmt.bind(":result_reason", concurrent_result.reason());
+        stmt.bind(":overlapping", joined.str());
+        stmt.step_without_results();
+    } catch (const sqlite::error& e) {
+        throw error(e.what());
+    }
+}
@@ -40,6 +40,7 @@ extern "C" {
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "model/context_fwd.hpp"
 #include "model/test_program_fwd.hpp"
@@ -48,6 +49,7 @@ extern "C" {
 #include "utils/datetime_fwd.hpp"
 #include "utils/fs/path_fwd.hpp"
 #include "utils/optional_fwd.hpp"
+#include "utils/units_fwd.hpp"
 
 namespace store {
 
@@ -81,6 +83,10 @@ public:
     int64_t put_result(const model::test_result&, const int64_t,
                        const utils::datetime::timestamp&,
                        const utils::datetime::timestamp&);
+    void put_resource_usage(const int64_t, const utils::datetime::delta&,
+                            const utils::units::bytes&);
+    void put_interference(const int64_t, const model::test_result&,
+                          const std::vector< std::string >&);
 };
 
 
@@ -34,6 +34,8 @@ extern "C" {
 #include <time.h>
 }
 
+#include <atomic>
+#include <mutex>
 #include <stdexcept>
 
 #include "utils/format/macros.hpp"
@@ -54,6 +56,17 @@ namespace {
 static optional< datetime::timestamp > mock_now = none;
 
 
+/// Whether mock_now holds a value.
+///
+/// This allows now() to skip the locking of mock_now_mutex when there is no
+/// mock time, which is always the case outside of tests.
+static std::atomic< bool > mock_now_set(false);
+
+
+/// Serializes accesses to mock_now from different threads.
+static std::mutex mock_now_mutex;
+
+
 }  // anonymous namespace
 
 
@@ -362,8 +375,11 @@ datetime::timestamp::from_values(const int year, const int month,
 datetime::timestamp
 datetime::timestamp::now(void)
 {
-    if (mock_now)
-        return mock_now.get();
+    if (mock_now_set.load()) {
+        std::lock_guard< std::mutex > lock(mock_now_mutex);
+        if (mock_now)
+            return mock_now.get();
+    }
 
     ::timeval data;
     {
@@ -437,8 +453,8 @@ datetime::set_mock_now(const int year, const int month,
                        const int minute, const int second,
                        const int microsecond)
 {
-    mock_now = timestamp::from_values(year, month, day, hour, minute, second,
-                                      microsecond);
+    set_mock_now(timestamp::from_values(year, month, day, hour, minute, second,
+                                        microsecond));
 }
 
 
@@ -448,7 +464,9 @@ datetime::set_mock_now(const int year, const int month,
 void
 datetime::set_mock_now(const timestamp& mock_now_)
 {
+    std::lock_guard< std::mutex > lock(mock_now_mutex);
     mock_now = mock_now_;
+    mock_now_set = true;
 }
 
 
@@ -35,6 +35,8 @@ extern "C" {
 
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <atf-c++.hpp>
 
@@ -305,6 +307,36 @@ ATF_TEST_CASE_BODY(timestamp__now__mock)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(timestamp__now__mock_concurrent);
+ATF_TEST_CASE_BODY(timestamp__now__mock_concurrent)
+{
+    const datetime::timestamp ts1 = datetime::timestamp::from_values(
+        2011, 2, 21, 18, 5, 10, 0);
+    const datetime::timestamp ts2 = datetime::timestamp::from_values(
+        2012, 3, 22, 19, 6, 11, 0);
+    datetime::set_mock_now(ts1);
+
+    std::vector< std::thread > threads;
+    std::vector< int > unexpected(4, 0);
+    for (std::size_t i = 0; i < unexpected.size(); ++i) {
+        threads.push_back(std::thread([i, &unexpected, &ts1, &ts2] {
+            for (int j = 0; j < 1000; ++j) {
+                const datetime::timestamp now = datetime::timestamp::now();
+                if (now != ts1 && now != ts2)
+                    ++unexpected[i];
+            }
+        }));
+    }
+    for (int j = 0; j < 1000; ++j)
+        datetime::set_mock_now(j % 2 == 0 ? ts2 : ts1);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (std::size_t i = 0; i < unexpected.size(); ++i)
+        ATF_REQUIRE_EQ(0, unexpected[i]);
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(timestamp__now__real);
 ATF_TEST_CASE_BODY(timestamp__now__real)
 {
@@ -574,6 +606,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, timestamp__copy);
     ATF_ADD_TEST_CASE(tcs, timestamp__from_microseconds);
     ATF_ADD_TEST_CASE(tcs, timestamp__now__mock);
+    ATF_ADD_TEST_CASE(tcs, timestamp__now__mock_concurrent);
     ATF_ADD_TEST_CASE(tcs, timestamp__now__real);
     ATF_ADD_TEST_CASE(tcs, timestamp__now__granularity);
     ATF_ADD_TEST_CASE(tcs, timestamp__strftime);
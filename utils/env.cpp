@@ -32,9 +32,14 @@
 #  include "config.h"
 #endif
 
+extern "C" {
+#include <pthread.h>
+}
+
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <stdexcept>
 
 #include "utils/format/macros.hpp"
@@ -42,6 +47,7 @@
 #include "utils/fs/path.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/optional.ipp"
+#include "utils/sanity.hpp"
 
 namespace fs = utils::fs;
 
@@ -54,6 +60,72 @@ extern "C" {
 }
 
 
+namespace {
+
+
+/// Serializes all accesses to the environment of the process.
+///
+/// The libc functions to query and modify the environment are not safe to call
+/// concurrently.  This lock must not be held while logging to keep it a leaf in
+/// the lock order.
+static std::mutex env_mutex;
+
+
+/// Holds env_mutex across calls to fork(2).
+///
+/// This ensures that the child process, which usually modifies its environment
+/// before exec'ing a test program, does not inherit the lock in a locked state
+/// from a thread that does not exist in the child.
+class env_fork_guard {
+    /// Acquires the lock before forking.
+    static void
+    prepare(void)
+    {
+        env_mutex.lock();
+    }
+
+    /// Releases the lock after forking, both in the parent and in the child.
+    static void
+    release(void)
+    {
+        env_mutex.unlock();
+    }
+
+public:
+    /// Registers the fork handlers.
+    env_fork_guard(void)
+    {
+        const int ret = ::pthread_atfork(prepare, release, release);
+        INV(ret == 0);
+    }
+};
+
+
+/// Registration of the fork handlers for env_mutex at startup.
+static env_fork_guard fork_guard;
+
+
+/// Gets the value of an environment variable.
+///
+/// \param name The name of the environment variable to query.
+///
+/// \return The value of the environment variable if it is defined, or none
+/// otherwise.
+static optional< std::string >
+locked_getenv(const std::string& name)
+{
+    std::lock_guard< std::mutex > lock(env_mutex);
+    const char* value = std::getenv(name.c_str());
+    if (value == NULL)
+        return none;
+    else
+        return utils::make_optional(std::string(value));
+}
+
+
+}  // anonymous namespace
+
+
 /// Gets all environment variables.
 ///
 /// \return A mapping of (name, value) pairs describing the environment
@@ -62,6 +134,7 @@ std::map< std::string, std::string >
 utils::getallenv(void)
 {
     std::map< std::string, std::string > allenv;
+    std::lock_guard< std::mutex > lock(env_mutex);
     for (char** envp = environ; *envp != NULL; envp++) {
         const std::string oneenv = *envp;
         const std::string::size_type pos = oneenv.find('=');
@@ -84,14 +157,13 @@ utils::getallenv(void)
 optional< std::string >
 utils::getenv(const std::string& name)
 {
-    const char* value = std::getenv(name.c_str());
-    if (value == NULL) {
+    const optional< std::string > value = locked_getenv(name);
+    if (!value) {
         LD(F("Environment variable '%s' is not defined") % name);
-        return none;
     } else {
-        LD(F("Environment variable '%s' is '%s'") % name % value);
-        return utils::make_optional(std::string(value));
+        LD(F("Environment variable '%s' is '%s'") % name % value.get());
     }
+    return value;
 }
 
 
@@ -105,14 +177,14 @@ std::string
 utils::getenv_with_default(const std::string& name,
                            const std::string& default_value)
 {
-    const char* value = std::getenv(name.c_str());
-    if (value == NULL) {
+    const optional< std::string > value = locked_getenv(name);
+    if (!value) {
         LD(F("Environment variable '%s' is not defined; using default '%s'") %
            name % default_value);
         return default_value;
     } else {
-        LD(F("Environment variable '%s' is '%s'") % name % value);
-        return value;
+        LD(F("Environment variable '%s' is '%s'") % name % value.get());
+        return value.get();
     }
 }
 
@@ -150,6 +222,7 @@ void
 utils::setenv(const std::string& name, const std::string& val)
 {
     LD(F("Setting environment variable '%s' to '%s'") % name % val);
+    std::lock_guard< std::mutex > lock(env_mutex);
 #if defined(HAVE_SETENV)
     if (::setenv(name.c_str(), val.c_str(), 1) == -1) {
         const int original_errno = errno;
@@ -180,6 +253,7 @@ void
 utils::unsetenv(const std::string& name)
 {
     LD(F("Unsetting environment variable '%s'") % name);
+    std::lock_guard< std::mutex > lock(env_mutex);
 #if defined(HAVE_UNSETENV)
     if (::unsetenv(name.c_str()) == -1) {
         const int original_errno = errno;
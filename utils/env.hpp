@@ -32,6 +32,11 @@
 /// These utility functions wrap the system functions to manipulate the
 /// environment in a portable way and expose their arguments and return values
 /// in a C++-friendly manner.
+///
+/// All the functions in this module can be called concurrently from different
+/// threads and from child processes created while other threads use them.
+/// Calling the libc functions to access the environment directly bypasses
+/// these guarantees.
 
 #if !defined(UTILS_ENV_HPP)
 #define UTILS_ENV_HPP
@@ -28,8 +28,12 @@
 
 #include "utils/env.hpp"
 
+#include <thread>
+#include <vector>
+
 #include <atf-c++.hpp>
 
+#include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/optional.ipp"
 
@@ -140,6 +144,34 @@ ATF_TEST_CASE_BODY(setenv)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(setenv__concurrent);
+ATF_TEST_CASE_BODY(setenv__concurrent)
+{
+    std::vector< std::thread > threads;
+    std::vector< int > mismatches(4, 0);
+    for (std::size_t i = 0; i < mismatches.size(); ++i) {
+        threads.push_back(std::thread([i, &mismatches] {
+            const std::string name = F("TEST_VARIABLE_%s") % i;
+            for (int j = 0; j < 1000; ++j) {
+                const std::string value = F("value-%s") % j;
+                utils::setenv(name, value);
+                if (utils::getenv(name).get() != value)
+                    ++mismatches[i];
+                (void)utils::getallenv();
+            }
+        }));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (std::size_t i = 0; i < mismatches.size(); ++i) {
+        ATF_REQUIRE_EQ(0, mismatches[i]);
+        ATF_REQUIRE_EQ("value-999",
+                       utils::getenv(F("TEST_VARIABLE_%s") % i).get());
+    }
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(unsetenv);
 ATF_TEST_CASE_BODY(unsetenv)
 {
@@ -162,6 +194,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, get_home__invalid);
 
     ATF_ADD_TEST_CASE(tcs, setenv);
+    ATF_ADD_TEST_CASE(tcs, setenv__concurrent);
 
     ATF_ADD_TEST_CASE(tcs, unsetenv);
 }
@@ -33,6 +33,10 @@
 #endif
 
 extern "C" {
+#if defined(HAVE_LINUX_FS_H)
+#   include <linux/fs.h>
+#endif
+#include <sys/ioctl.h>
 #include <sys/param.h>
 #if defined(HAVE_SYS_MOUNT_H)
 #   include <sys/mount.h>
@@ -46,18 +50,25 @@ extern "C" {
 #endif
 #include <sys/wait.h>
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 }
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "utils/auto_array.ipp"
+#include "utils/datetime.hpp"
 #include "utils/defs.hpp"
 #include "utils/env.hpp"
 #include "utils/format/macros.hpp"
@@ -69,6 +80,7 @@ extern "C" {
 #include "utils/sanity.hpp"
 #include "utils/units.hpp"
 
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
 namespace units = utils::units;
 
@@ -316,6 +328,387 @@ safe_stat(const fs::path& path)
 }
 
 
+/// Copies the contents of an open file with plain reads and writes.
+///
+/// \param input File descriptor to read from.
+/// \param output File descriptor to write to.
+/// \param source Path to the input file, for error reporting.
+/// \param target Path to the output file, for error reporting.
+///
+/// \throw system_error If there is any error during the copy.
+static void
+copy_contents(const int input, const int output, const fs::path& source,
+              const fs::path& target)
+{
+    char buffer[64 * 1024];
+    for (;;) {
+        const ssize_t length = ::read(input, buffer, sizeof(buffer));
+        if (length == 0) {
+            break;
+        } else if (length == -1) {
+            if (errno == EINTR)
+                continue;
+            const int original_errno = errno;
+            throw fs::system_error(F("Error while reading input file %s") %
+                                   source, original_errno);
+        }
+
+        ssize_t done = 0;
+        while (done < length) {
+            const ssize_t written = ::write(output, buffer + done,
+                                            length - done);
+            if (written == -1) {
+                if (errno == EINTR)
+                    continue;
+                const int original_errno = errno;
+                throw fs::system_error(F("Error while writing output file %s")
+                                       % target, original_errno);
+            }
+            done += written;
+        }
+    }
+}
+
+
+/// Copies the contents of an open file avoiding data copies if possible.
+///
+/// We first try to share the data extents of the input file with the output
+/// file (a "reflink" copy), which is instantaneous on file systems that
+/// support it.  Failing that, we let the kernel copy the data without bouncing
+/// it through user space.  And, as a last resort, we copy the data ourselves.
+///
+/// \param input File descriptor to read from.
+/// \param output File descriptor to write to.  Must refer to an empty file.
+/// \param source Path to the input file, for error reporting.
+/// \param target Path to the output file, for error reporting.
+///
+/// \throw system_error If there is any error during the copy.
+static void
+clone_contents(const int input, const int output, const fs::path& source,
+               const fs::path& target)
+{
+#if defined(FICLONE)
+    if (::ioctl(output, FICLONE, input) != -1)
+        return;
+#endif
+
+#if defined(HAVE_COPY_FILE_RANGE)
+    bool copied_any = false;
+    for (;;) {
+        const ssize_t length = ::copy_file_range(input, NULL, output, NULL,
+                                                 1024 * 1024 * 1024, 0);
+        if (length == 0) {
+            return;
+        } else if (length == -1) {
+            if (errno == EINTR)
+                continue;
+            // These indicate that the kernel or the file systems involved
+            // cannot do the copy, in which case we fall back to doing it
+            // ourselves.  This is only safe if no data was written yet.
+            if (!copied_any && (errno == ENOSYS || errno == EXDEV ||
+                                errno == EINVAL || errno == EOPNOTSUPP))
+                break;
+            const int original_errno = errno;
+            throw fs::system_error(F("Failed to copy %s to %s") % source %
+                                   target, original_errno);
+        }
+        copied_any = true;
+    }
+#endif
+
+    copy_contents(input, output, source, target);
+}
+
+
+/// Copies a regular file, preserving its permissions.
+///
+/// \param source The file to copy.
+/// \param target The new file to create.  Must not exist.
+/// \param mode The permissions of the new file.
+///
+/// \throw system_error If there is any error during the copy.
+static void
+clone_file(const fs::path& source, const fs::path& target, const int mode)
+{
+    const int input = ::open(source.c_str(), O_RDONLY);
+    if (input == -1) {
+        const int original_errno = errno;
+        throw fs::system_error(F("Cannot open copy source %s") % source,
+                               original_errno);
+    }
+
+    const int output = ::open(target.c_str(), O_WRONLY | O_CREAT | O_EXCL,
+                              0600);
+    if (output == -1) {
+        const int original_errno = errno;
+        ::close(input);
+        throw fs::system_error(F("Cannot create copy target %s") % target,
+                               original_errno);
+    }
+
+    try {
+        clone_contents(input, output, source, target);
+        if (::fchmod(output, mode) == -1) {
+            const int original_errno = errno;
+            throw fs::system_error(F("Cannot set permissions of %s") % target,
+                                   original_errno);
+        }
+    } catch (...) {
+        ::close(output);
+        ::close(input);
+        throw;
+    }
+    ::close(output);
+    ::close(input);
+}
+
+
+/// Recursively copies the contents of a directory into another.
+///
+/// \param source The directory to copy.
+/// \param target The directory in which to place the copies.  Must exist.
+///
+/// \throw error If the source contains a file type we do not know how to copy.
+/// \throw system_error If there is any error during the copy.
+static void
+clone_tree(const fs::path& source, const fs::path& target)
+{
+    const fs::directory dir(source);
+    for (fs::directory::const_iterator iter = dir.begin(); iter != dir.end();
+         ++iter) {
+        if (iter->name == "." || iter->name == "..")
+            continue;
+
+        const fs::path source_entry = source / iter->name;
+        const fs::path target_entry = target / iter->name;
+
+        const struct ::stat sb = safe_stat(source_entry);
+        if (S_ISDIR(sb.st_mode)) {
+            // Create the directory writable by us so that we can populate it
+            // even if the original is read-only, and fix its mode later.
+            fs::mkdir(target_entry, 0700);
+            clone_tree(source_entry, target_entry);
+            if (::chmod(target_entry.c_str(), sb.st_mode & 07777) == -1) {
+                const int original_errno = errno;
+                throw fs::system_error(F("Cannot set permissions of %s") %
+                                       target_entry, original_errno);
+            }
+        } else if (S_ISREG(sb.st_mode)) {
+            clone_file(source_entry, target_entry, sb.st_mode & 07777);
+        } else if (S_ISLNK(sb.st_mode)) {
+            std::vector< char > buffer(sb.st_size + 1);
+            const ssize_t length = ::readlink(source_entry.c_str(), &buffer[0],
+                                              buffer.size());
+            if (length == -1) {
+                const int original_errno = errno;
+                throw fs::system_error(F("Cannot read symlink %s") %
+                                       source_entry, original_errno);
+            }
+            const std::string link_target(&buffer[0], length);
+            if (::symlink(link_target.c_str(), target_entry.c_str()) == -1) {
+                const int original_errno = errno;
+                throw fs::system_error(F("Cannot create symlink %s") %
+                                       target_entry, original_errno);
+            }
+        } else {
+            throw fs::error(F("Cannot copy %s: unsupported file type") %
+                            source_entry);
+        }
+    }
+}
+
+
+/// Identifier of a directory used to detect cycles when walking a tree.
+typedef std::pair< ::dev_t, ::ino_t > directory_id;
+
+
+/// Searches for a file in the subdirectories of an already-open directory.
+///
+/// Directories are processed with fd-relative system calls so that we neither
+/// build nor resolve full paths for every visited entry.  The type of the
+/// entries is taken from the directory listing when the file system provides
+/// it and fstatat(2) is only used as a fallback or to resolve symlinks.
+///
+/// \param dirfd File descriptor of the directory to scan.  This function takes
+///     ownership of it and closes it before returning.
+/// \param display_path Path to the directory, for error reporting and to
+///     construct the returned paths.  This is relative to the walk root.
+/// \param name Name of the file to look for.
+/// \param depth Depth of the directory being scanned; 0 is the walk root.
+/// \param max_depth Maximum depth of the directories to inspect, if any.
+/// \param [in,out] ancestors Identifiers of the directories being walked,
+///     used to detect symlink loops.
+/// \param [in,out] matches Accumulator for the found files.
+///
+/// \throw fs::system_error If the directory cannot be read.
+static void
+find_in_subdirectories_at(const int dirfd, const fs::path& display_path,
+                          const std::string& name, const int depth,
+                          const optional< int >& max_depth,
+                          std::set< directory_id >& ancestors,
+                          std::vector< fs::path >& matches)
+{
+    ::DIR* dir = ::fdopendir(dirfd);
+    if (dir == NULL) {
+        const int original_errno = errno;
+        ::close(dirfd);
+        throw fs::system_error(F("fdopendir(%s) failed") % display_path,
+                               original_errno);
+    }
+
+    // Sort the subdirectory names so that the order of the results does not
+    // depend on the order in which the file system returns the entries.
+    std::set< std::string > subdirs;
+    ::dirent* de;
+    while ((errno = 0, de = ::readdir(dir)) != NULL) {
+        const std::string entry(de->d_name);
+        if (entry == "." || entry == "..")
+            continue;
+
+#if defined(DT_DIR)
+        if (de->d_type == DT_DIR) {
+            subdirs.insert(entry);
+            continue;
+        } else if (de->d_type != DT_UNKNOWN && de->d_type != DT_LNK) {
+            continue;
+        }
+#endif
+
+        struct ::stat sb;
+        if (::fstatat(::dirfd(dir), entry.c_str(), &sb, 0) == -1) {
+            LD(F("Ignoring unreachable entry %s") % (display_path / entry));
+            continue;
+        }
+        if (S_ISDIR(sb.st_mode))
+            subdirs.insert(entry);
+    }
+    if (errno != 0) {
+        const int original_errno = errno;
+        ::closedir(dir);
+        throw fs::system_error(F("readdir(%s) failed") % display_path,
+                               original_errno);
+    }
+
+    for (std::set< std::string >::const_iterator iter = subdirs.begin();
+         iter != subdirs.end(); ++iter) {
+        const fs::path subdir_path = display_path == fs::path(".") ?
+            fs::path(*iter) : display_path / *iter;
+
+        const int subdirfd = ::openat(::dirfd(dir), iter->c_str(),
+                                      O_RDONLY | O_DIRECTORY);
+        if (subdirfd == -1) {
+            LW(F("Skipping unreadable directory %s: %s") % subdir_path %
+               std::strerror(errno));
+            continue;
+        }
+
+        struct ::stat sb;
+        if (::fstat(subdirfd, &sb) == -1) {
+            LW(F("Skipping unreadable directory %s: %s") % subdir_path %
+               std::strerror(errno));
+            ::close(subdirfd);
+            continue;
+        }
+        const directory_id subdir_id(sb.st_dev, sb.st_ino);
+        if (ancestors.find(subdir_id) != ancestors.end()) {
+            LW(F("Skipping directory %s to avoid a loop") % subdir_path);
+            ::close(subdirfd);
+            continue;
+        }
+
+        if (::fstatat(subdirfd, name.c_str(), &sb, 0) != -1 &&
+            S_ISREG(sb.st_mode)) {
+            matches.push_back(subdir_path / name);
+            ::close(subdirfd);
+        } else if (max_depth && depth + 1 >= max_depth.get()) {
+            ::close(subdirfd);
+        } else {
+            ancestors.insert(subdir_id);
+            try {
+                find_in_subdirectories_at(subdirfd, subdir_path, name,
+                                          depth + 1, max_depth, ancestors,
+                                          matches);
+            } catch (...) {
+                ::closedir(dir);
+                throw;
+            }
+            ancestors.erase(subdir_id);
+        }
+    }
+
+    ::closedir(dir);
+}
+
+
+#if !defined(HAVE_GETMNTINFO)
+/// Decodes the octal escapes in a field of /proc/self/mountinfo.
+///
+/// \param field The raw field, in which characters like spaces and newlines
+///     are represented as \\ooo sequences.
+///
+/// \return The decoded field.
+static std::string
+unescape_mountinfo(const std::string& field)
+{
+    std::string decoded;
+    for (std::string::size_type i = 0; i < field.length(); ++i) {
+        if (field[i] == '\\' && i + 3 < field.length() &&
+            field.substr(i + 1, 3).find_first_not_of("01234567") ==
+            std::string::npos) {
+            decoded += static_cast< char >(
+                std::strtol(field.substr(i + 1, 3).c_str(), NULL, 8));
+            i += 3;
+        } else {
+            decoded += field[i];
+        }
+    }
+    return decoded;
+}
+#endif
+
+
+/// Lists the mount points of all the file systems in the mount table.
+///
+/// \return The mount points as absolute paths.
+///
+/// \throw fs::error If the mount table cannot be queried.
+static std::vector< std::string >
+list_mount_points(void)
+{
+    std::vector< std::string > mount_points;
+#if defined(HAVE_GETMNTINFO)
+#   if defined(__NetBSD__)
+    struct ::statvfs* mounts;
+#   else
+    struct ::statfs* mounts;
+#   endif
+    const int count = ::getmntinfo(&mounts, MNT_NOWAIT);
+    if (count == 0) {
+        const int original_errno = errno;
+        throw fs::system_error("getmntinfo failed", original_errno);
+    }
+    for (int i = 0; i < count; ++i)
+        mount_points.push_back(mounts[i].f_mntonname);
+#else
+    const char* mountinfo = "/proc/self/mountinfo";
+    std::ifstream input(mountinfo);
+    if (!input)
+        throw fs::error(F("Cannot open %s to list the mount points") %
+                        mountinfo);
+
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::string id, parent_id, device, root, mount_point;
+        if (!(fields >> id >> parent_id >> device >> root >> mount_point))
+            throw fs::error(F("Invalid line in %s: %s") % mountinfo % line);
+        mount_points.push_back(unescape_mountinfo(mount_point));
+    }
+#endif
+    return mount_points;
+}
+
+
 }  // anonymous namespace
 
 
@@ -348,6 +741,25 @@ fs::copy(const fs::path& source, const fs::path& target)
 }
 
 
+/// Recursively copies the contents of a directory into another.
+///
+/// Regular files are cloned when the file system supports it so that their
+/// data is only duplicated when either copy is modified.  Directories, regular
+/// files and symbolic links are copied along with their permissions; any other
+/// file type causes an error.  Ownership and timestamps are not preserved.
+///
+/// \param source The directory to copy.
+/// \param target The directory in which to place the copies.  Must exist and
+///     must not contain any of the entries in source.
+///
+/// \throw error If there is a problem copying any file.
+void
+fs::copy_tree(const fs::path& source, const fs::path& target)
+{
+    clone_tree(source, target);
+}
+
+
 /// Queries the path to the current directory.
 ///
 /// \return The path to the current directory.
@@ -422,6 +834,54 @@ fs::find_in_path(const char* name)
 }
 
 
+/// Locates the topmost copies of a file in the subdirectories of a tree.
+///
+/// The tree is walked depth-first and the subdirectories of each directory are
+/// visited in lexicographical order, so the results are deterministic.  Once a
+/// subdirectory is found to contain the file, the walk does not descend into
+/// it any further: the file is expected to take care of its own subtree.  The
+/// root directory itself is not checked for the file.
+///
+/// Symbolic links to directories are followed, but directories that are
+/// already being walked are skipped to prevent infinite loops.  Directories
+/// that cannot be opened are ignored.
+///
+/// \param root The directory in which to start the search.
+/// \param name The name of the file to look for.
+/// \param max_depth Maximum number of directory levels below root to inspect;
+///     1 means that only the immediate subdirectories are checked.  If none, the
+///     walk is unbounded.
+///
+/// \return The paths to the found files, relative to root.
+///
+/// \throw fs::system_error If the root directory cannot be read.
+std::vector< fs::path >
+fs::find_in_subdirectories(const fs::path& root, const std::string& name,
+                           const optional< int >& max_depth)
+{
+    PRE(!max_depth || max_depth.get() >= 0);
+
+    std::vector< fs::path > matches;
+    if (max_depth && max_depth.get() == 0)
+        return matches;
+
+    const int rootfd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY);
+    if (rootfd == -1) {
+        const int original_errno = errno;
+        throw fs::system_error(F("open(%s) failed") % root, original_errno);
+    }
+
+    struct ::stat sb;
+    std::set< directory_id > ancestors;
+    if (::fstat(rootfd, &sb) != -1)
+        ancestors.insert(directory_id(sb.st_dev, sb.st_ino));
+
+    find_in_subdirectories_at(rootfd, fs::path("."), name, 0, max_depth,
+                              ancestors, matches);
+    return matches;
+}
+
+
 /// Calculates the free space in a given file system.
 ///
 /// \param path Path to a file in the file system for which to check the free
@@ -614,6 +1074,82 @@ fs::mkstemp(const std::string& path_template)
 }
 
 
+/// Queries the last modification time of a file.
+///
+/// \param path The file to query.  Symbolic links are followed.
+///
+/// \return The modification time, with a resolution of microseconds if the
+/// system reports sub-second modification times or of seconds otherwise.
+///
+/// \throw fs::system_error If the call to stat(2) fails.
+datetime::timestamp
+fs::modification_time(const fs::path& path)
+{
+    struct ::stat sb;
+    if (::stat(path.c_str(), &sb) == -1) {
+        const int original_errno = errno;
+        throw fs::system_error(F("Cannot get information about %s") % path,
+                               original_errno);
+    }
+#if defined(HAVE_STRUCT_STAT_ST_MTIM)
+    const int64_t nanoseconds = sb.st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    const int64_t nanoseconds = sb.st_mtimespec.tv_nsec;
+#else
+    const int64_t nanoseconds = 0;
+#endif
+    return datetime::timestamp::from_microseconds(
+        static_cast< int64_t >(sb.st_mtime) * 1000000 + nanoseconds / 1000);
+}
+
+
+/// Lists the file systems mounted below a directory.
+///
+/// The list comes from the mount table and not from a scan of the directory,
+/// so it does not descend into the mounted file systems and it is finite even
+/// if a file system is mounted within itself.
+///
+/// \param directory The directory to look under.
+///
+/// \return The mount points strictly below the directory, resolved to their
+/// real paths.  Nested mount points come before the ones that contain them, so
+/// that the file systems can be unmounted in order.
+///
+/// \throw fs::error If the directory does not exist or if the mount table
+///     cannot be queried.
+std::vector< fs::path >
+fs::mount_points_under(const fs::path& directory)
+{
+    char* real_directory = ::realpath(directory.c_str(), NULL);
+    if (real_directory == NULL) {
+        const int original_errno = errno;
+        throw fs::system_error(F("Cannot resolve %s") % directory,
+                               original_errno);
+    }
+    std::string prefix(real_directory);
+    std::free(real_directory);
+    if (prefix != "/")
+        prefix += '/';
+
+    std::vector< std::string > mount_points;
+    const std::vector< std::string > all_mount_points = list_mount_points();
+    for (std::vector< std::string >::const_iterator iter =
+             all_mount_points.begin(); iter != all_mount_points.end(); ++iter) {
+        if ((*iter).length() > prefix.length() &&
+            (*iter).compare(0, prefix.length(), prefix) == 0)
+            mount_points.push_back(*iter);
+    }
+    // A mount point sorts after any of its ancestors.
+    std::sort(mount_points.rbegin(), mount_points.rend());
+
+    std::vector< fs::path > paths;
+    for (std::vector< std::string >::const_iterator iter =
+             mount_points.begin(); iter != mount_points.end(); ++iter)
+        paths.push_back(fs::path(*iter));
+    return paths;
+}
+
+
 /// Mounts a temporary file system with unlimited size.
 ///
 /// \param in_mount_point The path on which the file system will be mounted.
@@ -37,7 +37,9 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
+#include "utils/datetime_fwd.hpp"
 #include "utils/fs/directory_fwd.hpp"
 #include "utils/fs/path_fwd.hpp"
 #include "utils/optional_fwd.hpp"
@@ -48,15 +50,20 @@ namespace fs {
 
 
 void copy(const fs::path&, const fs::path&);
+void copy_tree(const fs::path&, const fs::path&);
 path current_path(void);
 bool exists(const fs::path&);
 utils::optional< path > find_in_path(const char*);
+std::vector< path > find_in_subdirectories(const path&, const std::string&,
+                                           const utils::optional< int >&);
 utils::units::bytes free_disk_space(const fs::path&);
 bool is_directory(const fs::path&);
 void mkdir(const path&, const int);
 void mkdir_p(const path&, const int);
 fs::path mkdtemp_public(const std::string&);
 fs::path mkstemp(const std::string&);
+utils::datetime::timestamp modification_time(const fs::path&);
+std::vector< path > mount_points_under(const path&);
 void mount_tmpfs(const path&);
 void mount_tmpfs(const path&, const units::bytes&);
 void rm_r(const path&);
@@ -31,6 +31,7 @@
 extern "C" {
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 
 #include <dirent.h>
@@ -48,6 +49,7 @@ extern "C" {
 
 #include <atf-c++.hpp>
 
+#include "utils/datetime.hpp"
 #include "utils/env.hpp"
 #include "utils/format/containers.ipp"
 #include "utils/format/macros.hpp"
@@ -59,10 +61,12 @@ extern "C" {
 #include "utils/stream.hpp"
 #include "utils/units.hpp"
 
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
 namespace passwd = utils::passwd;
 namespace units = utils::units;
 
+using utils::none;
 using utils::optional;
 
 
@@ -145,6 +149,87 @@ ATF_TEST_CASE_BODY(copy__fail_create)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(copy_tree__ok);
+ATF_TEST_CASE_BODY(copy_tree__ok)
+{
+    fs::mkdir(fs::path("source"), 0755);
+    atf::utils::create_file("source/file", "Top-level file");
+    ATF_REQUIRE(::chmod("source/file", 0750) != -1);
+    fs::mkdir(fs::path("source/dir"), 0755);
+    atf::utils::create_file("source/dir/nested", "Nested file");
+    fs::mkdir(fs::path("source/read-only"), 0755);
+    atf::utils::create_file("source/read-only/file", "");
+    ATF_REQUIRE(::chmod("source/read-only", 0555) != -1);
+    ATF_REQUIRE(::symlink("dir/nested", "source/link") != -1);
+
+    fs::mkdir(fs::path("target"), 0755);
+    fs::copy_tree(fs::path("source"), fs::path("target"));
+
+    ATF_REQUIRE(atf::utils::compare_file("target/file", "Top-level file"));
+    ATF_REQUIRE(atf::utils::compare_file("target/dir/nested", "Nested file"));
+    ATF_REQUIRE(atf::utils::compare_file("target/read-only/file", ""));
+    ATF_REQUIRE(atf::utils::compare_file("target/link", "Nested file"));
+
+    struct ::stat sb;
+    ATF_REQUIRE(::stat("target/file", &sb) != -1);
+    ATF_REQUIRE_EQ(0750, sb.st_mode & 07777);
+    ATF_REQUIRE(::stat("target/read-only", &sb) != -1);
+    ATF_REQUIRE_EQ(0555, sb.st_mode & 07777);
+    ATF_REQUIRE(::lstat("target/link", &sb) != -1);
+    ATF_REQUIRE(S_ISLNK(sb.st_mode));
+
+    // Modifying the copy must not affect the original.
+    atf::utils::create_file("target/file", "Modified");
+    ATF_REQUIRE(atf::utils::compare_file("source/file", "Top-level file"));
+
+    ATF_REQUIRE(::chmod("source/read-only", 0755) != -1);
+    ATF_REQUIRE(::chmod("target/read-only", 0755) != -1);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(copy_tree__large_file);
+ATF_TEST_CASE_BODY(copy_tree__large_file)
+{
+    fs::mkdir(fs::path("source"), 0755);
+    std::string contents;
+    for (int i = 0; i < 100000; ++i)
+        contents += F("Line %s\n") % i;
+    atf::utils::create_file("source/big", contents);
+
+    fs::mkdir(fs::path("target"), 0755);
+    fs::copy_tree(fs::path("source"), fs::path("target"));
+    ATF_REQUIRE(atf::utils::compare_file("target/big", contents));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(copy_tree__unsupported_type);
+ATF_TEST_CASE_BODY(copy_tree__unsupported_type)
+{
+    fs::mkdir(fs::path("source"), 0755);
+    ATF_REQUIRE(::mkfifo("source/fifo", 0644) != -1);
+
+    fs::mkdir(fs::path("target"), 0755);
+    ATF_REQUIRE_THROW_RE(fs::error, "Cannot copy source/fifo: unsupported",
+                         fs::copy_tree(fs::path("source"),
+                                       fs::path("target")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(copy_tree__fail_exists);
+ATF_TEST_CASE_BODY(copy_tree__fail_exists)
+{
+    fs::mkdir(fs::path("source"), 0755);
+    atf::utils::create_file("source/file", "New contents");
+
+    fs::mkdir(fs::path("target"), 0755);
+    atf::utils::create_file("target/file", "Do not override");
+    ATF_REQUIRE_THROW_RE(fs::error, "Cannot create copy target target/file",
+                         fs::copy_tree(fs::path("source"),
+                                       fs::path("target")));
+    ATF_REQUIRE(atf::utils::compare_file("target/file", "Do not override"));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(current_path__ok);
 ATF_TEST_CASE_BODY(current_path__ok)
 {
@@ -258,6 +343,94 @@ ATF_TEST_CASE_BODY(find_in_path__always_absolute)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(find_in_subdirectories__none);
+ATF_TEST_CASE_BODY(find_in_subdirectories__none)
+{
+    fs::mkdir(fs::path("root"), 0755);
+    atf::utils::create_file("root/Kyuafile", "");
+    fs::mkdir(fs::path("root/dir1"), 0755);
+    atf::utils::create_file("root/dir1/other", "");
+    fs::mkdir(fs::path("root/dir2"), 0755);
+    fs::mkdir(fs::path("root/dir2/Kyuafile"), 0755);
+
+    ATF_REQUIRE(fs::find_in_subdirectories(fs::path("root"), "Kyuafile",
+                                           none).empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(find_in_subdirectories__some);
+ATF_TEST_CASE_BODY(find_in_subdirectories__some)
+{
+    fs::mkdir_p(fs::path("root/c"), 0755);
+    atf::utils::create_file("root/c/Kyuafile", "");
+    fs::mkdir_p(fs::path("root/a/b/c"), 0755);
+    atf::utils::create_file("root/a/b/Kyuafile", "");
+    atf::utils::create_file("root/a/b/c/Kyuafile", "");
+    fs::mkdir_p(fs::path("root/b/x"), 0755);
+    fs::mkdir_p(fs::path("root/b/y"), 0755);
+    atf::utils::create_file("root/b/y/Kyuafile", "");
+    atf::utils::create_file("root/b/z", "");
+
+    std::vector< fs::path > exp_files;
+    exp_files.push_back(fs::path("a/b/Kyuafile"));
+    exp_files.push_back(fs::path("b/y/Kyuafile"));
+    exp_files.push_back(fs::path("c/Kyuafile"));
+    ATF_REQUIRE_EQ(exp_files,
+                   fs::find_in_subdirectories(fs::path("root"), "Kyuafile",
+                                              none));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(find_in_subdirectories__max_depth);
+ATF_TEST_CASE_BODY(find_in_subdirectories__max_depth)
+{
+    fs::mkdir_p(fs::path("root/a/b/c"), 0755);
+    atf::utils::create_file("root/a/b/c/Kyuafile", "");
+    fs::mkdir_p(fs::path("root/d"), 0755);
+    atf::utils::create_file("root/d/Kyuafile", "");
+
+    ATF_REQUIRE(fs::find_in_subdirectories(
+        fs::path("root"), "Kyuafile", utils::make_optional(0)).empty());
+
+    std::vector< fs::path > exp_files;
+    exp_files.push_back(fs::path("d/Kyuafile"));
+    ATF_REQUIRE_EQ(exp_files,
+                   fs::find_in_subdirectories(fs::path("root"), "Kyuafile",
+                                              utils::make_optional(2)));
+
+    exp_files.insert(exp_files.begin(), fs::path("a/b/c/Kyuafile"));
+    ATF_REQUIRE_EQ(exp_files,
+                   fs::find_in_subdirectories(fs::path("root"), "Kyuafile",
+                                              utils::make_optional(3)));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(find_in_subdirectories__symlinks);
+ATF_TEST_CASE_BODY(find_in_subdirectories__symlinks)
+{
+    fs::mkdir_p(fs::path("root/real"), 0755);
+    fs::mkdir_p(fs::path("elsewhere/dir"), 0755);
+    atf::utils::create_file("elsewhere/dir/Kyuafile", "");
+    ATF_REQUIRE(::symlink("../elsewhere", "root/link") != -1);
+    ATF_REQUIRE(::symlink("..", "root/real/loop") != -1);
+
+    std::vector< fs::path > exp_files;
+    exp_files.push_back(fs::path("link/dir/Kyuafile"));
+    ATF_REQUIRE_EQ(exp_files,
+                   fs::find_in_subdirectories(fs::path("root"), "Kyuafile",
+                                              none));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(find_in_subdirectories__fail);
+ATF_TEST_CASE_BODY(find_in_subdirectories__fail)
+{
+    ATF_REQUIRE_THROW_RE(fs::system_error, "open\\(missing\\) failed",
+                         fs::find_in_subdirectories(fs::path("missing"),
+                                                    "Kyuafile", none));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(free_disk_space__ok__smoke);
 ATF_TEST_CASE_BODY(free_disk_space__ok__smoke)
 {
@@ -565,6 +738,90 @@ ATF_TEST_CASE_BODY(mkstemp)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(modification_time__ok);
+ATF_TEST_CASE_BODY(modification_time__ok)
+{
+    atf::utils::create_file("file", "");
+    struct ::timeval times[2];
+    times[0].tv_sec = 1000000000;
+    times[0].tv_usec = 0;
+    times[1].tv_sec = 1234567890;
+    times[1].tv_usec = 500000;
+    ATF_REQUIRE(::utimes("file", times) != -1);
+
+    const int64_t exp_seconds = int64_t(1234567890) * 1000000;
+    const datetime::timestamp mtime = fs::modification_time(fs::path("file"));
+    // The sub-second part is only reported by some systems.
+    if (mtime.to_microseconds() != exp_seconds)
+        ATF_REQUIRE_EQ(datetime::timestamp::from_microseconds(
+                           exp_seconds + 500000), mtime);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(modification_time__fail);
+ATF_TEST_CASE_BODY(modification_time__fail)
+{
+    ATF_REQUIRE_THROW_RE(fs::system_error, "Cannot get information about "
+                         "missing",
+                         fs::modification_time(fs::path("missing")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(mount_points_under__none);
+ATF_TEST_CASE_BODY(mount_points_under__none)
+{
+    fs::mkdir_p(fs::path("dir/subdir"), 0755);
+    ATF_REQUIRE(fs::mount_points_under(fs::path("dir")).empty());
+}
+
+
+ATF_TEST_CASE_WITH_CLEANUP(mount_points_under__nested)
+ATF_TEST_CASE_HEAD(mount_points_under__nested)
+{
+    set_md_var("require.user", "root");
+}
+ATF_TEST_CASE_BODY(mount_points_under__nested)
+{
+    fs::mkdir_p(fs::path("dir/outer"), 0755);
+    try {
+        fs::mount_tmpfs(fs::path("dir/outer"));
+    } catch (const fs::unsupported_operation_error& e) {
+        ATF_SKIP(e.what());
+    }
+    atf::utils::create_file("outer-mounted", "");
+    fs::mkdir(fs::path("dir/outer/inner"), 0755);
+    fs::mount_tmpfs(fs::path("dir/outer/inner"));
+    atf::utils::create_file("inner-mounted", "");
+
+    const fs::path dir = fs::current_path() / "dir";
+    std::vector< fs::path > exp_mount_points;
+    exp_mount_points.push_back(dir / "outer/inner");
+    exp_mount_points.push_back(dir / "outer");
+    ATF_REQUIRE(exp_mount_points == fs::mount_points_under(fs::path("dir")));
+    ATF_REQUIRE(fs::mount_points_under(fs::path("dir/outer/inner")).empty());
+
+    fs::unmount(fs::path("dir/outer/inner"));
+    fs::unlink(fs::path("inner-mounted"));
+    fs::unmount(fs::path("dir/outer"));
+    fs::unlink(fs::path("outer-mounted"));
+    ATF_REQUIRE(fs::mount_points_under(fs::path("dir")).empty());
+}
+ATF_TEST_CASE_CLEANUP(mount_points_under__nested)
+{
+    cleanup_mount_point(fs::path("inner-mounted"),
+                        fs::path("dir/outer/inner"));
+    cleanup_mount_point(fs::path("outer-mounted"), fs::path("dir/outer"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(mount_points_under__fail);
+ATF_TEST_CASE_BODY(mount_points_under__fail)
+{
+    ATF_REQUIRE_THROW_RE(fs::system_error, "Cannot resolve missing",
+                         fs::mount_points_under(fs::path("missing")));
+}
+
+
 static void
 test_mount_tmpfs_ok(const units::bytes& size)
 {
@@ -772,6 +1029,11 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, copy__fail_open);
     ATF_ADD_TEST_CASE(tcs, copy__fail_create);
 
+    ATF_ADD_TEST_CASE(tcs, copy_tree__ok);
+    ATF_ADD_TEST_CASE(tcs, copy_tree__large_file);
+    ATF_ADD_TEST_CASE(tcs, copy_tree__unsupported_type);
+    ATF_ADD_TEST_CASE(tcs, copy_tree__fail_exists);
+
     ATF_ADD_TEST_CASE(tcs, current_path__ok);
     ATF_ADD_TEST_CASE(tcs, current_path__enoent);
 
@@ -784,6 +1046,12 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, find_in_path__current_directory);
     ATF_ADD_TEST_CASE(tcs, find_in_path__always_absolute);
 
+    ATF_ADD_TEST_CASE(tcs, find_in_subdirectories__none);
+    ATF_ADD_TEST_CASE(tcs, find_in_subdirectories__some);
+    ATF_ADD_TEST_CASE(tcs, find_in_subdirectories__max_depth);
+    ATF_ADD_TEST_CASE(tcs, find_in_subdirectories__symlinks);
+    ATF_ADD_TEST_CASE(tcs, find_in_subdirectories__fail);
+
     ATF_ADD_TEST_CASE(tcs, free_disk_space__ok__smoke);
     ATF_ADD_TEST_CASE(tcs, free_disk_space__ok__real);
     ATF_ADD_TEST_CASE(tcs, free_disk_space__fail);
@@ -805,6 +1073,13 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, mkstemp);
 
+    ATF_ADD_TEST_CASE(tcs, modification_time__ok);
+    ATF_ADD_TEST_CASE(tcs, modification_time__fail);
+
+    ATF_ADD_TEST_CASE(tcs, mount_points_under__none);
+    ATF_ADD_TEST_CASE(tcs, mount_points_under__nested);
+    ATF_ADD_TEST_CASE(tcs, mount_points_under__fail);
+
     ATF_ADD_TEST_CASE(tcs, mount_tmpfs__ok__default_size);
     ATF_ADD_TEST_CASE(tcs, mount_tmpfs__ok__explicit_size);
     ATF_ADD_TEST_CASE(tcs, mount_tmpfs__fail);
@@ -0,0 +1,191 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "utils/heap_stats.hpp"
+
+#include <atomic>
+
+#include "utils/sanity.hpp"
+
+namespace heap_stats = utils::heap_stats;
+
+
+namespace {
+
+
+/// Atomic counters of the heap usage of a phase.
+///
+/// These are updated from within operator new, so they must never allocate
+/// memory themselves.
+struct atomic_counters {
+    /// Number of allocations done in the phase.
+    std::atomic< uint64_t > allocations;
+
+    /// Number of bytes allocated in the phase.
+    std::atomic< uint64_t > bytes;
+
+    /// Largest size of the heap seen while allocating in the phase.
+    std::atomic< uint64_t > peak;
+};
+
+
+/// Whether the allocation hooks are linked into the program.
+static std::atomic< bool > hooked(false);
+
+
+/// Number of bytes currently allocated through the hooks.
+static std::atomic< uint64_t > live_bytes(0);
+
+
+/// Counters of every phase, indexed by the phase enumeration.
+static atomic_counters phase_counters[heap_stats::num_phases];
+
+
+/// Phase active in the calling thread.
+static thread_local heap_stats::phase current_phase = heap_stats::phase_other;
+
+
+}  // anonymous namespace
+
+
+/// Enters a phase.
+///
+/// \param phase_ The phase to attribute the allocations of this thread to.
+heap_stats::scoped_phase::scoped_phase(const phase phase_) :
+    _old_phase(current_phase)
+{
+    current_phase = phase_;
+}
+
+
+/// Leaves the phase and restores the one active before it.
+heap_stats::scoped_phase::~scoped_phase(void)
+{
+    current_phase = _old_phase;
+}
+
+
+/// Checks whether the allocation hooks are linked into the program.
+///
+/// \return True if the counters reflect the heap usage of the program; false
+/// if they are always zero.
+bool
+heap_stats::available(void)
+{
+    return hooked.load(std::memory_order_relaxed);
+}
+
+
+/// Gets the counters of a phase.
+///
+/// \param phase_ The phase to query.
+///
+/// \return The counters of the phase since the start of the program or since
+/// the last call to reset().
+heap_stats::counters
+heap_stats::get(const phase phase_)
+{
+    PRE(static_cast< std::size_t >(phase_) < num_phases);
+    const atomic_counters& data = phase_counters[phase_];
+    counters result;
+    result.allocations = data.allocations.load(std::memory_order_relaxed);
+    result.bytes = data.bytes.load(std::memory_order_relaxed);
+    result.peak = data.peak.load(std::memory_order_relaxed);
+    return result;
+}
+
+
+/// Gets the user-facing name of a phase.
+///
+/// \param phase_ The phase to query.
+///
+/// \return The name of the phase.
+const char*
+heap_stats::name(const phase phase_)
+{
+    switch (phase_) {
+    case phase_other: return "other";
+    case phase_load: return "load";
+    case phase_list: return "list";
+    case phase_schedule: return "schedule";
+    case phase_store: return "store";
+    case phase_report: return "report";
+    }
+    UNREACHABLE;
+}
+
+
+/// Clears the counters of all phases.
+///
+/// The size of the heap is not reset, so the peak of a phase after a reset
+/// still accounts for the memory allocated before it.
+void
+heap_stats::reset(void)
+{
+    for (std::size_t i = 0; i < num_phases; ++i) {
+        phase_counters[i].allocations.store(0, std::memory_order_relaxed);
+        phase_counters[i].bytes.store(0, std::memory_order_relaxed);
+        phase_counters[i].peak.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+/// Records that the allocation hooks are linked into the program.
+void
+heap_stats::detail::mark_available(void)
+{
+    hooked.store(true, std::memory_order_relaxed);
+}
+
+
+/// Records a heap allocation in the phase of the calling thread.
+///
+/// \param size The size of the allocation.
+void
+heap_stats::detail::record_allocation(const std::size_t size)
+{
+    atomic_counters& data = phase_counters[current_phase];
+    data.allocations.fetch_add(1, std::memory_order_relaxed);
+    data.bytes.fetch_add(size, std::memory_order_relaxed);
+
+    const uint64_t live = live_bytes.fetch_add(
+        size, std::memory_order_relaxed) + size;
+    uint64_t peak = data.peak.load(std::memory_order_relaxed);
+    while (live > peak && !data.peak.compare_exchange_weak(
+               peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+
+/// Records the release of a heap allocation.
+///
+/// \param size The size of the allocation.
+void
+heap_stats::detail::record_deallocation(const std::size_t size)
+{
+    live_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
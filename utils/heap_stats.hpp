@@ -0,0 +1,109 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/// \file utils/heap_stats.hpp
+/// Accounting of the heap allocations of the program by execution phase.
+///
+/// The counters are only updated if the program is linked with
+/// utils/heap_stats_hooks.cpp, which replaces the global operator new and
+/// operator delete.  That file is not part of the utils library so that
+/// programs embedding it do not get their allocator replaced; see available()
+/// to check if the hooks are in place.
+///
+/// Allocations are attributed to the phase active in the calling thread, as
+/// set by the innermost live scoped_phase object.
+
+#if !defined(UTILS_HEAP_STATS_HPP)
+#define UTILS_HEAP_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utils/noncopyable.hpp"
+
+namespace utils {
+namespace heap_stats {
+
+
+/// Phases of the execution to which heap allocations are attributed.
+enum phase {
+    phase_other = 0,
+    phase_load,
+    phase_list,
+    phase_schedule,
+    phase_store,
+    phase_report,
+};
+
+
+/// Number of values in the phase enumeration.
+const std::size_t num_phases = phase_report + 1;
+
+
+/// Counters of the heap usage of a phase.
+struct counters {
+    /// Number of allocations done in the phase.
+    uint64_t allocations;
+
+    /// Number of bytes allocated in the phase.
+    uint64_t bytes;
+
+    /// Largest size of the heap seen while allocating in the phase.
+    uint64_t peak;
+};
+
+
+/// Sets the phase of the calling thread for the lifetime of the object.
+class scoped_phase : noncopyable {
+    /// The phase to restore on destruction.
+    phase _old_phase;
+
+public:
+    explicit scoped_phase(const phase);
+    ~scoped_phase(void);
+};
+
+
+bool available(void);
+counters get(const phase);
+const char* name(const phase);
+void reset(void);
+
+
+namespace detail {
+
+
+void mark_available(void);
+void record_allocation(const std::size_t);
+void record_deallocation(const std::size_t);
+
+
+}  // namespace detail
+}  // namespace heap_stats
+}  // namespace utils
+
+#endif  // !defined(UTILS_HEAP_STATS_HPP)
@@ -0,0 +1,406 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/// \file utils/heap_stats_hooks.cpp
+/// Replacements of the global allocation functions to feed utils::heap_stats.
+///
+/// This file must be linked directly into the programs that want to account
+/// for their heap usage, not into a library: the linker would otherwise only
+/// pick it up by chance.  Every allocation is prefixed by a header that holds
+/// its size so that deallocations can be accounted for as well.
+///
+/// The sized and over-aligned variants of the allocation functions are only
+/// replaced when the compiler supports them, which is the only case in which
+/// it can emit calls to them.
+
+extern "C" {
+#include <stdlib.h>
+}
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "utils/heap_stats.hpp"
+
+namespace heap_stats = utils::heap_stats;
+
+
+namespace {
+
+
+/// Space reserved in front of every allocation to store its size.
+///
+/// This keeps the memory returned to the caller suitably aligned for any type.
+static const std::size_t header_size = alignof(std::max_align_t);
+
+
+/// Computes the space reserved in front of an allocation.
+///
+/// \param alignment The alignment requested by the caller.
+///
+/// \return The size of the header, which is a multiple of the alignment so
+/// that the memory returned to the caller keeps it.
+static std::size_t
+header_size_for(const std::size_t alignment)
+{
+    return std::max(header_size, alignment);
+}
+
+
+/// Allocates memory and records the allocation.
+///
+/// \param size The number of bytes requested by the caller.
+/// \param alignment The alignment requested by the caller.  Must be a power
+///     of two.
+///
+/// \return The allocated memory or NULL if there is not enough memory.
+static void*
+allocate(std::size_t size, const std::size_t alignment)
+{
+    if (size == 0)
+        size = 1;
+    const std::size_t offset = header_size_for(alignment);
+    void* raw;
+    if (alignment <= header_size) {
+        raw = std::malloc(offset + size);
+    } else {
+        if (::posix_memalign(&raw, alignment, offset + size) != 0)
+            raw = NULL;
+    }
+    if (raw == NULL)
+        return NULL;
+    *static_cast< std::size_t* >(raw) = size;
+    heap_stats::detail::record_allocation(size);
+    return static_cast< char* >(raw) + offset;
+}
+
+
+/// Allocates memory as operator new does.
+///
+/// \param size The number of bytes requested by the caller.
+/// \param alignment The alignment requested by the caller.
+///
+/// \return The allocated memory.
+///
+/// \throw std::bad_alloc If there is not enough memory and the new handler,
+///     if any, cannot free any.
+static void*
+allocate_or_throw(const std::size_t size, const std::size_t alignment)
+{
+    for (;;) {
+        void* memory = allocate(size, alignment);
+        if (memory != NULL)
+            return memory;
+        const std::new_handler handler = std::get_new_handler();
+        if (handler == NULL)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+
+/// Allocates memory as the non-throwing operator new does.
+///
+/// \param size The number of bytes requested by the caller.
+/// \param alignment The alignment requested by the caller.
+///
+/// \return The allocated memory or NULL if there is not enough memory.
+static void*
+allocate_or_null(const std::size_t size, const std::size_t alignment)
+{
+    try {
+        return allocate_or_throw(size, alignment);
+    } catch (const std::bad_alloc& unused_error) {
+        return NULL;
+    }
+}
+
+
+/// Releases memory obtained from allocate() and records the deallocation.
+///
+/// \param memory The memory to release; may be NULL.
+/// \param alignment The alignment passed to allocate().
+static void
+deallocate(void* memory, const std::size_t alignment)
+{
+    if (memory == NULL)
+        return;
+    void* raw = static_cast< char* >(memory) - header_size_for(alignment);
+    heap_stats::detail::record_deallocation(*static_cast< std::size_t* >(raw));
+    std::free(raw);
+}
+
+
+/// Registers the hooks with the heap_stats module at startup.
+static struct hooks_registrar {
+    /// Constructor.
+    hooks_registrar(void)
+    {
+        heap_stats::detail::mark_available();
+    }
+} registrar;
+
+
+}  // anonymous namespace
+
+
+/// Replacement of the global operator new.
+///
+/// \param size The number of bytes to allocate.
+///
+/// \return The allocated memory.
+void*
+operator new(std::size_t size)
+{
+    return allocate_or_throw(size, header_size);
+}
+
+
+/// Replacement of the global operator new[].
+///
+/// \param size The number of bytes to allocate.
+///
+/// \return The allocated memory.
+void*
+operator new[](std::size_t size)
+{
+    return allocate_or_throw(size, header_size);
+}
+
+
+/// Replacement of the global non-throwing operator new.
+///
+/// \param size The number of bytes to allocate.
+///
+/// \return The allocated memory or NULL if there is not enough memory.
+void*
+operator new(std::size_t size, const std::nothrow_t& /* unused */) throw()
+{
+    return allocate_or_null(size, header_size);
+}
+
+
+/// Replacement of the global non-throwing operator new[].
+///
+/// \param size The number of bytes to allocate.
+///
+/// \return The allocated memory or NULL if there is not enough memory.
+void*
+operator new[](std::size_t size, const std::nothrow_t& /* unused */) throw()
+{
+    return allocate_or_null(size, header_size);
+}
+
+
+/// Replacement of the global operator delete.
+///
+/// \param memory The memory to release.
+void
+operator delete(void* memory) throw()
+{
+    deallocate(memory, header_size);
+}
+
+
+/// Replacement of the global operator delete[].
+///
+/// \param memory The memory to release.
+void
+operator delete[](void* memory) throw()
+{
+    deallocate(memory, header_size);
+}
+
+
+/// Replacement of the global non-throwing operator delete.
+///
+/// \param memory The memory to release.
+void
+operator delete(void* memory, const std::nothrow_t& /* unused */) throw()
+{
+    deallocate(memory, header_size);
+}
+
+
+/// Replacement of the global non-throwing operator delete[].
+///
+/// \param memory The memory to release.
+void
+operator delete[](void* memory, const std::nothrow_t& /* unused */) throw()
+{
+    deallocate(memory, header_size);
+}
+
+
+#if defined(__cpp_sized_deallocation)
+/// Replacement of the global sized operator delete.
+///
+/// \param memory The memory to release.
+void
+operator delete(void* memory, std::size_t /* size */) throw()
+{
+    deallocate(memory, header_size);
+}
+
+
+/// Replacement of the global sized operator delete[].
+///
+/// \param memory The memory to release.
+void
+operator delete[](void* memory, std::size_t /* size */) throw()
+{
+    deallocate(memory, header_size);
+}
+#endif
+
+
+#if defined(__cpp_aligned_new)
+/// Replacement of the global over-aligned operator new.
+///
+/// \param size The number of bytes to allocate.
+/// \param alignment The alignment of the memory to allocate.
+///
+/// \return The allocated memory.
+void*
+operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocate_or_throw(size, static_cast< std::size_t >(alignment));
+}
+
+
+/// Replacement of the global over-aligned operator new[].
+///
+/// \param size The number of bytes to allocate.
+/// \param alignment The alignment of the memory to allocate.
+///
+/// \return The allocated memory.
+void*
+operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocate_or_throw(size, static_cast< std::size_t >(alignment));
+}
+
+
+/// Replacement of the global non-throwing over-aligned operator new.
+///
+/// \param size The number of bytes to allocate.
+/// \param alignment The alignment of the memory to allocate.
+///
+/// \return The allocated memory or NULL if there is not enough memory.
+void*
+operator new(std::size_t size, std::align_val_t alignment,
+             const std::nothrow_t& /* unused */) throw()
+{
+    return allocate_or_null(size, static_cast< std::size_t >(alignment));
+}
+
+
+/// Replacement of the global non-throwing over-aligned operator new[].
+///
+/// \param size The number of bytes to allocate.
+/// \param alignment The alignment of the memory to allocate.
+///
+/// \return The allocated memory or NULL if there is not enough memory.
+void*
+operator new[](std::size_t size, std::align_val_t alignment,
+               const std::nothrow_t& /* unused */) throw()
+{
+    return allocate_or_null(size, static_cast< std::size_t >(alignment));
+}
+
+
+/// Replacement of the global over-aligned operator delete.
+///
+/// \param memory The memory to release.
+/// \param alignment The alignment the memory was allocated with.
+void
+operator delete(void* memory, std::align_val_t alignment) throw()
+{
+    deallocate(memory, static_cast< std::size_t >(alignment));
+}
+
+
+/// Replacement of the global over-aligned operator delete[].
+///
+/// \param memory The memory to release.
+/// \param alignment The alignment the memory was allocated with.
+void
+operator delete[](void* memory, std::align_val_t alignment) throw()
+{
+    deallocate(memory, static_cast< std::size_t >(alignment));
+}
+
+
+/// Replacement of the global non-throwing over-aligned operator delete.
+///
+/// \param memory The memory to release.
+/// \param alignment The alignment the memory was allocated with.
+void
+operator delete(void* memory, std::align_val_t alignment,
+                const std::nothrow_t& /* unused */) throw()
+{
+    deallocate(memory, static_cast< std::size_t >(alignment));
+}
+
+
+/// Replacement of the global non-throwing over-aligned operator delete[].
+///
+/// \param memory The memory to release.
+/// \param alignment The alignment the memory was allocated with.
+void
+operator delete[](void* memory, std::align_val_t alignment,
+                  const std::nothrow_t& /* unused */) throw()
+{
+    deallocate(memory, static_cast< std::size_t >(alignment));
+}
+
+
+/// Replacement of the global sized over-aligned operator delete.
+///
+/// \param memory The memory to release.
+/// \param alignment The alignment the memory was allocated with.
+void
+operator delete(void* memory, std::size_t /* size */,
+                std::align_val_t alignment) throw()
+{
+    deallocate(memory, static_cast< std::size_t >(alignment));
+}
+
+
+/// Replacement of the global sized over-aligned operator delete[].
+///
+/// \param memory The memory to release.
+/// \param alignment The alignment the memory was allocated with.
+void
+operator delete[](void* memory, std::size_t /* size */,
+                  std::align_val_t alignment) throw()
+{
+    deallocate(memory, static_cast< std::size_t >(alignment));
+}
+#endif
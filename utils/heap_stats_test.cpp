@@ -0,0 +1,230 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "utils/heap_stats.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+namespace heap_stats = utils::heap_stats;
+
+
+// This test program is linked with utils/heap_stats_hooks.cpp.
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(available);
+ATF_TEST_CASE_BODY(available)
+{
+    ATF_REQUIRE(heap_stats::available());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(scoped_phase__counts);
+ATF_TEST_CASE_BODY(scoped_phase__counts)
+{
+    heap_stats::reset();
+    {
+        heap_stats::scoped_phase phase(heap_stats::phase_store);
+        std::unique_ptr< char[] > first(new char[1000]);
+        std::unique_ptr< char[] > second(new char[3000]);
+    }
+
+    const heap_stats::counters store = heap_stats::get(
+        heap_stats::phase_store);
+    ATF_REQUIRE_EQ(2, store.allocations);
+    ATF_REQUIRE_EQ(4000, store.bytes);
+    ATF_REQUIRE(store.peak >= 4000);
+
+    const heap_stats::counters report = heap_stats::get(
+        heap_stats::phase_report);
+    ATF_REQUIRE_EQ(0, report.allocations);
+    ATF_REQUIRE_EQ(0, report.bytes);
+    ATF_REQUIRE_EQ(0, report.peak);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(scoped_phase__nested);
+ATF_TEST_CASE_BODY(scoped_phase__nested)
+{
+    heap_stats::reset();
+    {
+        heap_stats::scoped_phase outer(heap_stats::phase_schedule);
+        {
+            heap_stats::scoped_phase inner(heap_stats::phase_store);
+            delete new int(1);
+        }
+        delete new int(2);
+        delete new int(3);
+    }
+
+    ATF_REQUIRE_EQ(1, heap_stats::get(heap_stats::phase_store).allocations);
+    ATF_REQUIRE_EQ(2, heap_stats::get(heap_stats::phase_schedule).allocations);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(peak__tracks_frees);
+ATF_TEST_CASE_BODY(peak__tracks_frees)
+{
+    heap_stats::reset();
+
+    uint64_t first_peak;
+    {
+        heap_stats::scoped_phase phase(heap_stats::phase_list);
+        std::vector< char* > blocks;
+        for (int i = 0; i < 10; ++i)
+            blocks.push_back(new char[100000]);
+        for (std::vector< char* >::iterator iter = blocks.begin();
+             iter != blocks.end(); ++iter)
+            delete [] *iter;
+        first_peak = heap_stats::get(heap_stats::phase_list).peak;
+        ATF_REQUIRE(first_peak >= 1000000);
+
+        // Allocating and freeing one block at a time must not raise the peak,
+        // as the memory of the previous blocks has been released.
+        for (int i = 0; i < 10; ++i)
+            delete [] new char[100000];
+    }
+    ATF_REQUIRE_EQ(first_peak, heap_stats::get(heap_stats::phase_list).peak);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(sized_delete);
+ATF_TEST_CASE_BODY(sized_delete)
+{
+#if defined(__cpp_sized_deallocation)
+    heap_stats::reset();
+
+    uint64_t first_peak;
+    {
+        heap_stats::scoped_phase phase(heap_stats::phase_report);
+        ::operator delete(::operator new(100), 100);
+        first_peak = heap_stats::get(heap_stats::phase_report).peak;
+
+        // The peak only stays put if the deallocations are accounted for.
+        for (int i = 0; i < 9; ++i)
+            ::operator delete(::operator new(100), 100);
+    }
+
+    const heap_stats::counters report = heap_stats::get(
+        heap_stats::phase_report);
+    ATF_REQUIRE_EQ(10, report.allocations);
+    ATF_REQUIRE_EQ(1000, report.bytes);
+    ATF_REQUIRE_EQ(first_peak, report.peak);
+#else
+    ATF_SKIP("The compiler does not support sized deallocation");
+#endif
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(over_aligned);
+ATF_TEST_CASE_BODY(over_aligned)
+{
+#if defined(__cpp_aligned_new)
+    struct alignas(256) aligned_block {
+        char data[300];
+    };
+
+    heap_stats::reset();
+
+    uint64_t first_peak;
+    {
+        heap_stats::scoped_phase phase(heap_stats::phase_load);
+        aligned_block* blocks = new (std::nothrow) aligned_block[2];
+        ATF_REQUIRE(blocks != NULL);
+        ATF_REQUIRE_EQ(0, reinterpret_cast< std::uintptr_t >(blocks) % 256);
+        delete [] blocks;
+        first_peak = heap_stats::get(heap_stats::phase_load).peak;
+
+        // The peak only stays put if the deallocations are accounted for.
+        for (int i = 0; i < 10; ++i) {
+            std::unique_ptr< aligned_block > block(new aligned_block);
+            ATF_REQUIRE_EQ(0, reinterpret_cast< std::uintptr_t >(
+                block.get()) % 256);
+        }
+    }
+
+    const heap_stats::counters load = heap_stats::get(heap_stats::phase_load);
+    ATF_REQUIRE_EQ(11, load.allocations);
+    ATF_REQUIRE_EQ(12 * sizeof(aligned_block), load.bytes);
+    ATF_REQUIRE_EQ(first_peak, load.peak);
+#else
+    ATF_SKIP("The compiler does not support over-aligned allocations");
+#endif
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(reset);
+ATF_TEST_CASE_BODY(reset)
+{
+    {
+        heap_stats::scoped_phase phase(heap_stats::phase_load);
+        const std::string text(1000, 'x');
+    }
+    ATF_REQUIRE(heap_stats::get(heap_stats::phase_load).allocations > 0);
+
+    heap_stats::reset();
+    ATF_REQUIRE_EQ(0, heap_stats::get(heap_stats::phase_load).allocations);
+    ATF_REQUIRE_EQ(0, heap_stats::get(heap_stats::phase_load).bytes);
+    ATF_REQUIRE_EQ(0, heap_stats::get(heap_stats::phase_load).peak);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(name);
+ATF_TEST_CASE_BODY(name)
+{
+    ATF_REQUIRE_EQ(std::string("other"),
+                   heap_stats::name(heap_stats::phase_other));
+    ATF_REQUIRE_EQ(std::string("load"),
+                   heap_stats::name(heap_stats::phase_load));
+    ATF_REQUIRE_EQ(std::string("list"),
+                   heap_stats::name(heap_stats::phase_list));
+    ATF_REQUIRE_EQ(std::string("schedule"),
+                   heap_stats::name(heap_stats::phase_schedule));
+    ATF_REQUIRE_EQ(std::string("store"),
+                   heap_stats::name(heap_stats::phase_store));
+    ATF_REQUIRE_EQ(std::string("report"),
+                   heap_stats::name(heap_stats::phase_report));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, available);
+    ATF_ADD_TEST_CASE(tcs, scoped_phase__counts);
+    ATF_ADD_TEST_CASE(tcs, scoped_phase__nested);
+    ATF_ADD_TEST_CASE(tcs, peak__tracks_frees);
+    ATF_ADD_TEST_CASE(tcs, sized_delete);
+    ATF_ADD_TEST_CASE(tcs, over_aligned);
+    ATF_ADD_TEST_CASE(tcs, reset);
+    ATF_ADD_TEST_CASE(tcs, name);
+}
@@ -29,9 +29,13 @@
 #include "utils/logging/operations.hpp"
 
 extern "C" {
+#include <pthread.h>
+#include <signal.h>
 #include <unistd.h>
 }
 
+#include <cstddef>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -40,6 +44,7 @@ extern "C" {
 #include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/noncopyable.hpp"
 #include "utils/optional.ipp"
 #include "utils/sanity.hpp"
 #include "utils/stream.hpp"
@@ -78,9 +83,19 @@ using utils::optional;
 /// stderr and the process forks and wants to keep those child channels
 /// unpolluted.
 ///
+/// Alternatively, the application can call set_persistency_on_demand() in step 3
+/// to keep the messages in memory until a warning or an error is logged, so that
+/// short-lived processes that run without trouble do not create a log file.
+///
 /// The call to set_inmemory() should only be performed by the user-facing
 /// application.  Tests should skip this call so that the logging messages go to
 /// stderr by default, thus generating a useful log to debug the tests.
+///
+/// All functions in this module can be called concurrently from different
+/// threads and from child processes created while other threads are logging.
+/// They must not be called from signal handlers because they allocate memory
+/// and take locks, neither of which is async-signal-safe.  The only exception
+/// is flush_pending(), which crash handlers can call as a last resort.
 
 
 namespace {
@@ -90,8 +105,19 @@ namespace {
 static const char* timestamp_format = "%Y%m%d-%H%M%S";
 
 
+/// Maximum number of log entries to hold in memory for a pending log file.
+///
+/// Once the backlog grows past this size, the log file is created even if no
+/// warning or error has happened so that long-running commands do not keep
+/// their whole log in memory.
+static const std::size_t max_pending_backlog = 10000;
+
+
 /// Mutable global state.
 struct global_state {
+    /// Serializes all accesses to the other fields.
+    std::mutex mutex;
+
     /// Current log level.
     logging::level log_level;
 
@@ -107,6 +133,9 @@ struct global_state {
     /// Stream to the currently open log file.
     std::auto_ptr< std::ostream > logfile;
 
+    /// File to open on the first warning or error, if persistency is deferred.
+    optional< fs::path > pending_logfile;
+
     global_state() :
         log_level(logging::level_debug),
         auto_set_persistency(true)
@@ -115,31 +144,219 @@ struct global_state {
 };
 
 
-/// Single instance of the mutable global state.
+/// Gets the singleton instance of global_state.
 ///
-/// Note that this is a raw pointer that we intentionally leak.  We must do
-/// this, instead of making all of the singleton's members static values,
+/// Note that the instance is a raw pointer that we intentionally leak.  We must
+/// do this, instead of making all of the singleton's members static values,
 /// because we want other destructors in the program to be able to log critical
 /// conditions.  If we use complex types in this translation unit, they may be
 /// destroyed before the logging methods in the destructors get a chance to run
 /// thus resulting in a premature crash.  By using a plain pointer, we ensure
 /// this state never gets cleaned up.
-static struct global_state* globals_singleton = NULL;
-
-
-/// Gets the singleton instance of global_state.
 ///
 /// \return A pointer to the unique global_state instance.
 static struct global_state*
 get_globals(void)
 {
-    if (globals_singleton == NULL) {
-        globals_singleton = new global_state();
-    }
+    // The initialization of function-level statics is thread-safe.
+    static struct global_state* globals_singleton = new global_state();
     return globals_singleton;
 }
 
 
+/// Acquires the lock of the global state before forking.
+static void
+lock_for_fork(void)
+{
+    get_globals()->mutex.lock();
+}
+
+
+/// Releases the lock of the global state in the parent after forking.
+static void
+unlock_after_fork(void)
+{
+    get_globals()->mutex.unlock();
+}
+
+
+/// Releases the lock of the global state in the child after forking.
+///
+/// The child, in which the thread that might have been logging does not exist,
+/// must be able to log.  However, it must not create the pending log file of
+/// the parent: doing so would truncate the file if the parent had already
+/// created it, and would duplicate the backlog otherwise.  The child therefore
+/// drops the pending log file and its copy of the backlog.
+static void
+reset_after_fork(void)
+{
+    struct global_state* globals = get_globals();
+    if (globals->pending_logfile) {
+        globals->pending_logfile = none;
+        globals->backlog.clear();
+    }
+    globals->mutex.unlock();
+}
+
+
+/// Exclusive access to the global state.
+///
+/// The signals for which the program may install handlers are blocked while the
+/// lock is held.  Signal handlers must not log, but this keeps a handler that
+/// does so by mistake from deadlocking by interrupting the thread that holds
+/// the lock.
+class locked_globals : utils::noncopyable {
+    /// The global state.
+    struct global_state* _globals;
+
+    /// Signal mask to restore when releasing the lock.
+    ::sigset_t _old_sigmask;
+
+    /// Whether the lock is held or not.
+    bool _locked;
+
+    /// Blocks signals and registers the fork handlers, if not yet done.
+    void
+    prepare(void)
+    {
+        ::sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGALRM);
+        sigaddset(&mask, SIGHUP);
+        sigaddset(&mask, SIGINT);
+        sigaddset(&mask, SIGTERM);
+        const int ret = ::pthread_sigmask(SIG_BLOCK, &mask, &_old_sigmask);
+        INV(ret == 0);
+
+        static std::once_flag fork_handlers;
+        std::call_once(fork_handlers, [] {
+            const int ret2 = ::pthread_atfork(lock_for_fork,
+                                              unlock_after_fork,
+                                              reset_after_fork);
+            INV(ret2 == 0);
+        });
+    }
+
+public:
+    /// Acquires the lock.
+    locked_globals(void) :
+        _globals(get_globals())
+    {
+        prepare();
+        _globals->mutex.lock();
+        _locked = true;
+    }
+
+    /// Tries to acquire the lock without waiting for it.
+    ///
+    /// Use locked() to check if the lock was acquired.
+    explicit locked_globals(const std::try_to_lock_t&) :
+        _globals(get_globals())
+    {
+        prepare();
+        _locked = _globals->mutex.try_lock();
+    }
+
+    /// Releases the lock.
+    ~locked_globals(void)
+    {
+        if (_locked)
+            _globals->mutex.unlock();
+        const int ret = ::pthread_sigmask(SIG_SETMASK, &_old_sigmask, NULL);
+        INV(ret == 0);
+    }
+
+    /// Checks if the lock is held.
+    ///
+    /// \return True if the global state can be accessed.
+    bool
+    locked(void) const
+    {
+        return _locked;
+    }
+
+    /// Accesses the global state.
+    ///
+    /// \return A pointer to the unique global_state instance.
+    struct global_state*
+    operator->(void)
+    {
+        return _globals;
+    }
+};
+
+
+/// Parses the name of a log level.
+///
+/// \param name The name of the log level.
+///
+/// \return The parsed log level.
+///
+/// \throw std::range_error If the given log level is invalid.
+static logging::level
+parse_level(const std::string& name)
+{
+    // Update doc/troubleshooting.info if you change the log levels.
+    if (name == "debug")
+        return logging::level_debug;
+    else if (name == "error")
+        return logging::level_error;
+    else if (name == "info")
+        return logging::level_info;
+    else if (name == "warning")
+        return logging::level_warning;
+    else
+        throw std::range_error(F("Unrecognized log level '%s'") % name);
+}
+
+
+/// Opens the log file and flushes the in-memory log to it.
+///
+/// \param globals The locked global state.
+/// \param path The file to write the logs to.
+///
+/// \throw std::runtime_error If the given file cannot be created.
+static void
+open_logfile_locked(locked_globals& globals, const fs::path& path)
+{
+    PRE(globals->logfile.get() == NULL);
+
+    globals->pending_logfile = none;
+    try {
+        globals->logfile = utils::open_ostream(path);
+    } catch (const std::runtime_error& unused_error) {
+        throw std::runtime_error(F("Failed to create log file %s") % path);
+    }
+
+    for (std::vector< std::pair< logging::level, std::string > >::const_iterator
+         iter = globals->backlog.begin(); iter != globals->backlog.end();
+         ++iter) {
+        if ((*iter).first <= globals->log_level)
+            (*globals->logfile) << (*iter).second << '\n';
+    }
+    globals->logfile->flush();
+    globals->backlog.clear();
+}
+
+
+/// Makes the log persistent.
+///
+/// \param globals The locked global state.
+/// \param new_level The new log level.
+/// \param path The file to write the logs to.
+///
+/// \throw std::range_error If the given log level is invalid.
+/// \throw std::runtime_error If the given file cannot be created.
+static void
+set_persistency_locked(locked_globals& globals, const std::string& new_level,
+                       const fs::path& path)
+{
+    globals->auto_set_persistency = false;
+    globals->log_level = parse_level(new_level);
+    open_logfile_locked(globals, path);
+}
+
+
 /// Converts a level to a printable character.
 ///
 /// \param level The level to convert.
@@ -176,7 +393,7 @@ level_to_char(const logging::level level)
 fs::path
 logging::generate_log_name(const fs::path& logdir, const std::string& progname)
 {
-    struct global_state* globals = get_globals();
+    locked_globals globals;
 
     if (!globals->first_timestamp)
         globals->first_timestamp = datetime::timestamp::now();
@@ -199,9 +416,9 @@ void
 logging::log(const level message_level, const char* file, const int line,
              const std::string& user_message)
 {
-    struct global_state* globals = get_globals();
-
     const datetime::timestamp now = datetime::timestamp::now();
+
+    locked_globals globals;
     if (!globals->first_timestamp)
         globals->first_timestamp = now;
 
@@ -210,13 +427,25 @@ logging::log(const level message_level, const char* file, const int line,
         // application should call set_inmemory() by itself during
         // initialization to avoid this, so that it has explicit control on how
         // the call to set_persistency() happens.
-        set_persistency("debug", fs::path("/dev/stderr"));
+        set_persistency_locked(globals, "debug", fs::path("/dev/stderr"));
         globals->auto_set_persistency = false;
     }
 
     if (message_level > globals->log_level)
         return;
 
+    if (globals->pending_logfile && (message_level <= logging::level_warning ||
+                                     globals->backlog.size() >=
+                                     max_pending_backlog)) {
+        const fs::path path = globals->pending_logfile.get();
+        try {
+            open_logfile_locked(globals, path);
+        } catch (const std::runtime_error& unused_error) {
+            // There is nowhere to report this error to, and the caller is not
+            // expecting one either.  Keep the log in memory.
+        }
+    }
+
     // Update doc/troubleshooting.texi if you change the log format.
     const std::string message = F("%s %s %s %s:%s: %s") %
         now.strftime(timestamp_format) % level_to_char(message_level) %
@@ -231,6 +460,28 @@ logging::log(const level message_level, const char* file, const int line,
 }
 
 
+/// Creates the pending log file, if any, and flushes the in-memory log to it.
+///
+/// This is intended to be called when the program is about to die abnormally,
+/// such as from a crash handler, so that the log referenced in the error
+/// messages exists.  To be safe in that context, this does nothing if the
+/// logging state is locked, as the lock holder may be the crashing thread.
+void
+logging::flush_pending(void)
+{
+    locked_globals globals(std::try_to_lock);
+    if (!globals.locked() || !globals->pending_logfile)
+        return;
+
+    const fs::path path = globals->pending_logfile.get();
+    try {
+        open_logfile_locked(globals, path);
+    } catch (const std::runtime_error& unused_error) {
+        // Nothing else we can do; see the equivalent code in log().
+    }
+}
+
+
 /// Sets the logging to record messages in memory for later flushing.
 ///
 /// Can be called after set_persistency to flush logs and set recording to be
@@ -238,9 +489,10 @@ logging::log(const level message_level, const char* file, const int line,
 void
 logging::set_inmemory(void)
 {
-    struct global_state* globals = get_globals();
+    locked_globals globals;
 
     globals->auto_set_persistency = false;
+    globals->pending_logfile = none;
 
     if (globals->logfile.get() != NULL) {
         INV(globals->backlog.empty());
@@ -268,36 +520,59 @@ logging::set_inmemory(void)
 void
 logging::set_persistency(const std::string& new_level, const fs::path& path)
 {
-    struct global_state* globals = get_globals();
-
-    globals->auto_set_persistency = false;
+    locked_globals globals;
+    set_persistency_locked(globals, new_level, path);
+}
 
-    PRE(globals->logfile.get() == NULL);
 
-    // Update doc/troubleshooting.info if you change the log levels.
-    if (new_level == "debug")
-        globals->log_level = level_debug;
-    else if (new_level == "error")
-        globals->log_level = level_error;
-    else if (new_level == "info")
-        globals->log_level = level_info;
-    else if (new_level == "warning")
-        globals->log_level = level_warning;
-    else
-        throw std::range_error(F("Unrecognized log level '%s'") % new_level);
+/// Makes the log persistent once there is something worth looking at.
+///
+/// This is like set_persistency() but, instead of creating the log file right
+/// away, keeps the log entries in memory until the first warning or error is
+/// logged, until the in-memory log grows too large or until flush_pending() is
+/// called.  The in-memory log is flushed to disk at that point and the log file
+/// is written to directly from then on.  If none of these happen, the log file
+/// is never created.
+///
+/// Child processes forked while the log file is pending do not inherit it: the
+/// entries they log are kept in memory only.
+///
+/// Any log entries above the provided new_level are discarded.
+///
+/// \param new_level The new log level.
+/// \param path The file to write the logs to.  If it cannot be created when
+///     needed, the log entries are kept in memory.
+///
+/// \throw std::range_error If the given log level is invalid.
+void
+logging::set_persistency_on_demand(const std::string& new_level,
+                                   const fs::path& path)
+{
+    locked_globals globals;
 
-    try {
-        globals->logfile = utils::open_ostream(path);
-    } catch (const std::runtime_error& unused_error) {
-        throw std::runtime_error(F("Failed to create log file %s") % path);
-    }
+    PRE(globals->logfile.get() == NULL);
+    globals->auto_set_persistency = false;
+    globals->log_level = parse_level(new_level);
+    globals->pending_logfile = path;
 
+    std::vector< std::pair< logging::level, std::string > > backlog;
+    bool has_problems = false;
     for (std::vector< std::pair< logging::level, std::string > >::const_iterator
          iter = globals->backlog.begin(); iter != globals->backlog.end();
          ++iter) {
-        if ((*iter).first <= globals->log_level)
-            (*globals->logfile) << (*iter).second << '\n';
+        if ((*iter).first <= globals->log_level) {
+            backlog.push_back(*iter);
+            if ((*iter).first <= logging::level_warning)
+                has_problems = true;
+        }
+    }
+    globals->backlog.swap(backlog);
+
+    if (has_problems) {
+        try {
+            open_logfile_locked(globals, path);
+        } catch (const std::runtime_error& unused_error) {
+            // Keep the log in memory; see the equivalent code in log().
+        }
     }
-    globals->logfile->flush();
-    globals->backlog.clear();
 }
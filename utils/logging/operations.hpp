@@ -43,9 +43,11 @@ namespace logging {
 
 
 fs::path generate_log_name(const fs::path&, const std::string&);
+void flush_pending(void);
 void log(const level, const char*, const int, const std::string&);
 void set_inmemory(void);
 void set_persistency(const std::string&, const fs::path&);
+void set_persistency_on_demand(const std::string&, const fs::path&);
 
 
 }  // namespace logging
@@ -29,11 +29,17 @@
 #include "utils/logging/operations.hpp"
 
 extern "C" {
+#include <sys/types.h>
+#include <sys/wait.h>
+
 #include <unistd.h>
 }
 
+#include <cstdlib>
 #include <fstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <atf-c++.hpp>
 
@@ -124,6 +130,40 @@ ATF_TEST_CASE_BODY(log)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(log__concurrent);
+ATF_TEST_CASE_BODY(log__concurrent)
+{
+    logging::set_persistency("debug", fs::path("test.log"));
+
+    datetime::set_mock_now(2011, 2, 21, 18, 30, 0, 0);
+    std::vector< std::thread > threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.push_back(std::thread([i] {
+            for (int j = 0; j < 250; ++j)
+                logging::log(logging::level_info, "file", i,
+                             F("Message %s") % j);
+        }));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    std::ifstream input("test.log");
+    ATF_REQUIRE(input);
+
+    const pid_t pid = ::getpid();
+
+    int count = 0;
+    std::string line;
+    while (std::getline(input, line).good()) {
+        ATF_REQUIRE_MATCH(
+            (F("^20110221-183000 I %s file:[0-3]: Message [0-9]+$") %
+             pid).str(), line);
+        ++count;
+    }
+    ATF_REQUIRE_EQ(1000, count);
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(set_inmemory__reset);
 ATF_TEST_CASE_BODY(set_inmemory__reset)
 {
@@ -336,12 +376,143 @@ ATF_TEST_CASE_BODY(set_persistency__fail)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(set_persistency_on_demand__no_problems);
+ATF_TEST_CASE_BODY(set_persistency_on_demand__no_problems)
+{
+    logging::set_inmemory();
+    logging::log(logging::level_debug, "file", 1, "Debug before");
+    logging::set_persistency_on_demand("debug", fs::path("test.log"));
+    logging::log(logging::level_info, "file", 2, "Info after");
+
+    ATF_REQUIRE(!fs::exists(fs::path("test.log")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(set_persistency_on_demand__first_warning);
+ATF_TEST_CASE_BODY(set_persistency_on_demand__first_warning)
+{
+    logging::set_inmemory();
+    datetime::set_mock_now(2011, 3, 19, 11, 40, 0, 100);
+    logging::log(logging::level_debug, "file1", 11, "Debug 1");
+    logging::set_persistency_on_demand("info", fs::path("test.log"));
+
+    datetime::set_mock_now(2011, 3, 19, 11, 40, 1, 100);
+    logging::log(logging::level_info, "file2", 22, "Info 1");
+    ATF_REQUIRE(!fs::exists(fs::path("test.log")));
+
+    datetime::set_mock_now(2011, 3, 19, 11, 40, 2, 100);
+    logging::log(logging::level_warning, "file3", 33, "Warning 1");
+    ATF_REQUIRE(fs::exists(fs::path("test.log")));
+
+    datetime::set_mock_now(2011, 3, 19, 11, 40, 3, 100);
+    logging::log(logging::level_info, "file4", 44, "Info 2");
+
+    std::ifstream input("test.log");
+    ATF_REQUIRE(input);
+
+    const pid_t pid = ::getpid();
+
+    std::string line;
+    ATF_REQUIRE(std::getline(input, line).good());
+    ATF_REQUIRE_EQ(
+        (F("20110319-114001 I %s file2:22: Info 1") % pid).str(), line);
+    ATF_REQUIRE(std::getline(input, line).good());
+    ATF_REQUIRE_EQ(
+        (F("20110319-114002 W %s file3:33: Warning 1") % pid).str(), line);
+    ATF_REQUIRE(std::getline(input, line).good());
+    ATF_REQUIRE_EQ(
+        (F("20110319-114003 I %s file4:44: Info 2") % pid).str(), line);
+    ATF_REQUIRE(!std::getline(input, line));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(set_persistency_on_demand__warning_in_backlog);
+ATF_TEST_CASE_BODY(set_persistency_on_demand__warning_in_backlog)
+{
+    logging::set_inmemory();
+    logging::log(logging::level_error, "file", 1, "Error before");
+    logging::set_persistency_on_demand("warning", fs::path("test.log"));
+
+    ATF_REQUIRE(fs::exists(fs::path("test.log")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(set_persistency_on_demand__fail);
+ATF_TEST_CASE_BODY(set_persistency_on_demand__fail)
+{
+    logging::set_inmemory();
+
+    ATF_REQUIRE_THROW_RE(std::range_error, "'foobar'",
+                         logging::set_persistency_on_demand(
+                             "foobar", fs::path("log")));
+
+    logging::set_persistency_on_demand("debug",
+                                       fs::path("missing/dir/test.log"));
+    logging::log(logging::level_error, "file", 1, "Error message");
+    ATF_REQUIRE(!fs::exists(fs::path("missing")));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(set_persistency_on_demand__large_backlog);
+ATF_TEST_CASE_BODY(set_persistency_on_demand__large_backlog)
+{
+    logging::set_inmemory();
+    logging::set_persistency_on_demand("info", fs::path("test.log"));
+    for (int i = 0; i < 9999; ++i)
+        logging::log(logging::level_info, "file", i, "Info");
+    ATF_REQUIRE(!fs::exists(fs::path("test.log")));
+    logging::log(logging::level_info, "file", 1, "Info");
+    logging::log(logging::level_info, "file", 2, "Last info");
+    ATF_REQUIRE(atf::utils::grep_file("file:2: Last info", "test.log"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(set_persistency_on_demand__fork);
+ATF_TEST_CASE_BODY(set_persistency_on_demand__fork)
+{
+    logging::set_inmemory();
+    logging::set_persistency_on_demand("info", fs::path("test.log"));
+    logging::log(logging::level_info, "file", 1, "Parent info");
+
+    const pid_t pid = ::fork();
+    ATF_REQUIRE(pid != -1);
+    if (pid == 0) {
+        logging::log(logging::level_warning, "file", 2, "Child warning");
+        ::_exit(fs::exists(fs::path("test.log")) ?
+                EXIT_FAILURE : EXIT_SUCCESS);
+    }
+    int status;
+    ATF_REQUIRE(::waitpid(pid, &status, 0) != -1);
+    ATF_REQUIRE(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    ATF_REQUIRE(!fs::exists(fs::path("test.log")));
+
+    logging::log(logging::level_warning, "file", 3, "Parent warning");
+    ATF_REQUIRE(atf::utils::grep_file("file:1: Parent info", "test.log"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(flush_pending);
+ATF_TEST_CASE_BODY(flush_pending)
+{
+    logging::set_inmemory();
+    logging::set_persistency_on_demand("info", fs::path("test.log"));
+    logging::log(logging::level_info, "file", 1, "Info");
+    ATF_REQUIRE(!fs::exists(fs::path("test.log")));
+    logging::flush_pending();
+    ATF_REQUIRE(atf::utils::grep_file("file:1: Info", "test.log"));
+
+    logging::flush_pending();
+    ATF_REQUIRE(atf::utils::grep_file("file:1: Info", "test.log"));
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, generate_log_name__before_log);
     ATF_ADD_TEST_CASE(tcs, generate_log_name__after_log);
 
     ATF_ADD_TEST_CASE(tcs, log);
+    ATF_ADD_TEST_CASE(tcs, log__concurrent);
 
     ATF_ADD_TEST_CASE(tcs, set_inmemory__reset);
 
@@ -351,4 +522,13 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, set_persistency__some_backlog__info);
     ATF_ADD_TEST_CASE(tcs, set_persistency__some_backlog__warning);
     ATF_ADD_TEST_CASE(tcs, set_persistency__fail);
+
+    ATF_ADD_TEST_CASE(tcs, set_persistency_on_demand__no_problems);
+    ATF_ADD_TEST_CASE(tcs, set_persistency_on_demand__first_warning);
+    ATF_ADD_TEST_CASE(tcs, set_persistency_on_demand__warning_in_backlog);
+    ATF_ADD_TEST_CASE(tcs, set_persistency_on_demand__fail);
+    ATF_ADD_TEST_CASE(tcs, set_persistency_on_demand__large_backlog);
+    ATF_ADD_TEST_CASE(tcs, set_persistency_on_demand__fork);
+
+    ATF_ADD_TEST_CASE(tcs, flush_pending);
 }
@@ -34,21 +34,33 @@
 
 extern "C" {
 #include <sys/types.h>
+#include <sys/file.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 
+#include <fcntl.h>
 #include <signal.h>
+#include <unistd.h>
 }
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <forward_list>
 #include <fstream>
+#include <iostream>
 #include <map>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/auto_cleaners.hpp"
+#include "utils/fs/directory.hpp"
 #include "utils/fs/exceptions.hpp"
 #include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
@@ -85,10 +97,424 @@ namespace {
 static const char* work_directory_template = PACKAGE_TARNAME ".XXXXXX";
 
 
+/// Prefix of the names of the directories created from the template.
+static const char* work_directory_prefix = PACKAGE_TARNAME ".";
+
+
+/// Name of the file in the root work directory that identifies its owner.
+static const char* owner_marker_name = "owner";
+
+
 /// Mapping of active subprocess PIDs to their execution data.
 typedef std::map< int, executor::exec_handle > exec_handles_map;
 
 
+/// Queries the start time of a process.
+///
+/// The start time is used to tell apart a process from a later one that got
+/// the same PID, so its value is opaque and only valid for comparisons.
+///
+/// \param pid The process to query.
+///
+/// \return The start time of the process, or none if it is unknown.
+static optional< std::string >
+process_start_time(const int pid)
+{
+    // Only Linux exposes this information in a way that is easy to get to.
+    // Elsewhere, we just rely on the PID.
+    std::ifstream input((F("/proc/%s/stat") % pid).str().c_str());
+    std::string line;
+    if (!std::getline(input, line))
+        return none;
+
+    // The command name is in parenthesis and can contain spaces, so parse
+    // the fields after it.  The first of these is the 3rd field of the line
+    // and the start time is the 22nd.
+    const std::string::size_type pos = line.rfind(')');
+    if (pos == std::string::npos)
+        return none;
+    std::istringstream fields(line.substr(pos + 1));
+    std::string field;
+    for (int i = 3; i <= 22; ++i) {
+        if (!(fields >> field))
+            return none;
+    }
+    return utils::make_optional(field);
+}
+
+
+/// Identifies the PID space in which the current process lives.
+///
+/// PIDs and process start times are only meaningful within the PID namespace
+/// of a single boot of a single host, but the temporary directory may be
+/// shared across containers or over the network.  The identity is composed of
+/// the host name, the boot identifier and the inode of the PID namespace, any
+/// of which is "-" if unknown.
+///
+/// \return The identity as a single line of space-separated words.
+static std::string
+pid_space_identity(void)
+{
+    char hostname[256];
+    if (::gethostname(hostname, sizeof(hostname)) == -1)
+        std::strcpy(hostname, "-");
+    hostname[sizeof(hostname) - 1] = '\0';
+
+    std::string boot_id;
+    std::ifstream input("/proc/sys/kernel/random/boot_id");
+    if (!(input >> boot_id))
+        boot_id = "-";
+
+    std::string pid_namespace = "-";
+    struct ::stat sb;
+    if (::stat("/proc/self/ns/pid", &sb) != -1)
+        pid_namespace = F("%s") % sb.st_ino;
+
+    return F("%s %s %s") % hostname % boot_id % pid_namespace;
+}
+
+
+/// Records the current process as the owner of a root work directory.
+///
+/// \param directory The root work directory.
+static void
+write_owner_marker(const fs::path& directory)
+{
+    const fs::path marker = directory / owner_marker_name;
+    std::ofstream output(marker.c_str());
+    const optional< std::string > start_time = process_start_time(::getpid());
+    output << F("%s %s %s\n") % ::getpid() %
+        (start_time ? start_time.get() : "-") % pid_space_identity();
+    if (!output)
+        LW(F("Failed to write owner marker %s") % marker);
+}
+
+
+/// Checks if the owner of a root work directory is gone.
+///
+/// \param directory The root work directory.
+///
+/// \return True if the owner recorded in the directory is dead or if its PID
+/// now belongs to a different process; false if the owner is alive, if the
+/// owner lives in a different host, boot or PID namespace, or if the directory
+/// has no valid owner marker.
+static bool
+is_orphaned(const fs::path& directory)
+{
+    std::ifstream input((directory / owner_marker_name).c_str());
+    int pid;
+    std::string start_time;
+    if (!(input >> pid >> start_time) || pid <= 0)
+        return false;
+    std::string identity;
+    if (!std::getline(input, identity) || identity.empty() ||
+        identity.substr(1) != pid_space_identity())
+        return false;
+
+    if (::kill(pid, 0) == -1 && errno == ESRCH)
+        return true;
+    if (start_time == "-")
+        return false;
+    const optional< std::string > current_start_time =
+        process_start_time(pid);
+    return current_start_time && current_start_time.get() != start_time;
+}
+
+
+/// Unmounts any file systems left mounted within a directory.
+///
+/// \param directory The directory to clean up.
+///
+/// \throw fs::error If any file system cannot be unmounted.
+static void
+unmount_all(const fs::path& directory)
+{
+    const std::vector< fs::path > mount_points = fs::mount_points_under(
+        directory);
+    for (std::vector< fs::path >::const_iterator iter = mount_points.begin();
+         iter != mount_points.end(); ++iter) {
+        LI(F("Unmounting leftover file system %s") % *iter);
+        fs::unmount(*iter);
+    }
+}
+
+
+/// Deletes a root work directory if its owner is gone.
+///
+/// The owner marker is locked while the directory is processed so that
+/// concurrent executors do not try to delete the same directory at once.
+///
+/// \param directory The root work directory to check.
+///
+/// \throw fs::error If the directory cannot be deleted.
+static void
+reclaim_if_orphaned(const fs::path& directory)
+{
+    const fs::path marker = directory / owner_marker_name;
+    const int fd = ::open(marker.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+    if (::flock(fd, LOCK_EX | LOCK_NB) == -1 || !is_orphaned(directory)) {
+        ::close(fd);
+        return;
+    }
+
+    LI(F("Reclaiming orphaned work directory %s") % directory);
+    try {
+        unmount_all(directory);
+        fs::rm_r(directory);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+
+/// Deletes the root work directories left behind by dead executors.
+///
+/// \param tmpdir The directory in which executors create their roots.
+static void
+reclaim_orphans(const fs::path& tmpdir)
+{
+    const std::string prefix(work_directory_prefix);
+    const fs::directory dir(tmpdir);
+    for (fs::directory::const_iterator iter = dir.begin(); iter != dir.end();
+         ++iter) {
+        if (iter->name.compare(0, prefix.length(), prefix) != 0)
+            continue;
+
+        const fs::path entry = tmpdir / iter->name;
+        struct ::stat sb;
+        if (::lstat(entry.c_str(), &sb) == -1 || !S_ISDIR(sb.st_mode) ||
+            sb.st_uid != ::geteuid())
+            continue;
+
+        try {
+            reclaim_if_orphaned(entry);
+        } catch (const fs::error& e) {
+            LW(F("Failed to reclaim orphaned work directory %s: %s") % entry %
+               e.what());
+        }
+    }
+}
+
+
+/// Deletes the root work directories left behind by dead executors.
+///
+/// The work happens in a detached subprocess so that it does not delay the
+/// execution of any new subprocesses and so that the subprocess is never
+/// seen by the wait calls of the executor.
+///
+/// \param tmpdir The directory in which executors create their roots.
+static void
+reclaim_orphans_in_background(const fs::path& tmpdir)
+{
+    std::cout.flush();
+    std::cerr.flush();
+
+    const pid_t pid = ::fork();
+    if (pid == -1) {
+        LW(F("Cannot fork to reclaim orphaned work directories: %s") %
+           std::strerror(errno));
+        return;
+    } else if (pid == 0) {
+        if (::fork() != 0)
+            ::_exit(EXIT_SUCCESS);
+
+        (void)::setsid();
+        const int fd = ::open("/dev/null", O_RDWR);
+        if (fd != -1) {
+            (void)::dup2(fd, STDIN_FILENO);
+            (void)::dup2(fd, STDOUT_FILENO);
+            (void)::dup2(fd, STDERR_FILENO);
+            if (fd > STDERR_FILENO)
+                ::close(fd);
+        }
+        try {
+            reclaim_orphans(tmpdir);
+        } catch (const fs::error& e) {
+            LW(F("Failed to scan %s for orphaned work directories: %s") %
+               tmpdir % e.what());
+        }
+        ::_exit(EXIT_SUCCESS);
+    }
+
+    int status;
+    while (::waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+        // Retry.
+    }
+}
+
+
+/// Maximum time to wait for killed subprocesses to die during cleanup.
+static const datetime::delta reap_timeout(10, 0);
+
+
+/// Maximum number of processes to use to delete control directories.
+static const std::size_t max_removal_workers = 8;
+
+
+/// Waits for a collection of killed subprocesses to terminate.
+///
+/// The subprocesses are polled concurrently, so the time this takes is bound by
+/// the slowest subprocess to die instead of the sum of all of them.  Any
+/// subprocess that does not die before the timeout is abandoned.
+///
+/// \param pids The subprocesses to wait for.
+/// \param timeout Maximum time to wait for.
+static void
+reap_all(std::vector< int > pids, const datetime::delta& timeout)
+{
+    const datetime::timestamp deadline = datetime::timestamp::now() + timeout;
+    useconds_t delay = 1000;
+    for (;;) {
+        std::vector< int >::iterator iter = pids.begin();
+        while (iter != pids.end()) {
+            int status;
+            const pid_t pid = ::waitpid(*iter, &status, WNOHANG);
+            if (pid == 0) {
+                ++iter;
+            } else if (pid == -1 && errno == EINTR) {
+                // Try again in the next round.
+                ++iter;
+            } else {
+                if (pid == -1) {
+                    // Should not happen.
+                    LW(F("Failed to wait for PID %s") % *iter);
+                }
+                iter = pids.erase(iter);
+            }
+        }
+        if (pids.empty())
+            break;
+
+        if (datetime::timestamp::now() >= deadline) {
+            LW(F("Gave up waiting for %s subprocesses to die after %s "
+                 "seconds") % pids.size() % timeout.seconds);
+            break;
+        }
+        ::usleep(delay);
+        delay = std::min(delay * 2, static_cast< useconds_t >(100000));
+    }
+}
+
+
+/// Deletes a subset of a collection of directories.
+///
+/// \param directories The directories to delete.
+/// \param first Index of the first directory to delete.
+/// \param stride Distance between the indexes of the directories to delete.
+///
+/// \return True if all directories were deleted; false otherwise.
+static bool
+remove_some(const std::vector< fs::path >& directories, const std::size_t first,
+            const std::size_t stride)
+{
+    bool ok = true;
+    for (std::size_t i = first; i < directories.size(); i += stride) {
+        const fs::path& directory = directories[i];
+        if (!fs::exists(directory))
+            continue;
+        try {
+            fs::rm_r(directory);
+        } catch (const fs::error& e) {
+            LE(F("Failed to clean up subprocess work directory %s: %s") %
+               directory % e.what());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+
+/// Deletes a collection of directories concurrently.
+///
+/// The directories are distributed among a bunch of subprocesses so that the
+/// deletion of large trees proceeds in parallel.  Any directory that a worker
+/// fails to delete is retried from the current process, and errors are only
+/// logged.
+///
+/// \param directories The directories to delete.
+static void
+remove_all(const std::vector< fs::path >& directories)
+{
+    const std::size_t num_workers = std::min(max_removal_workers,
+                                             directories.size());
+    if (num_workers <= 1) {
+        (void)remove_some(directories, 0, 1);
+        return;
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector< pid_t > workers;
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        const pid_t pid = ::fork();
+        if (pid == -1) {
+            LW(F("Cannot fork to delete work directories: %s") %
+               std::strerror(errno));
+            // Deleted below by the retry loop.
+        } else if (pid == 0) {
+            ::_exit(remove_some(directories, i, num_workers) ?
+                    EXIT_SUCCESS : EXIT_FAILURE);
+        } else {
+            workers.push_back(pid);
+        }
+    }
+
+    bool retry = workers.size() < num_workers;
+    for (std::vector< pid_t >::const_iterator iter = workers.begin();
+         iter != workers.end(); ++iter) {
+        int status;
+        pid_t pid;
+        while ((pid = ::waitpid(*iter, &status, 0)) == -1 && errno == EINTR) {
+            // Retry.
+        }
+        if (pid == -1) {
+            LW(F("Failed to wait for PID %s") % *iter);
+            retry = true;
+        } else if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            retry = true;
+        }
+    }
+
+    if (retry)
+        (void)remove_some(directories, 0, 1);
+}
+
+
+/// Recursively changes the ownership of the contents of a directory.
+///
+/// The directory itself is left untouched as isolate_child() takes care of it
+/// from within the subprocess.
+///
+/// \param directory The directory to process.
+/// \param user The user to give the files to.
+///
+/// \throw fs::system_error If the ownership of any file cannot be changed.
+static void
+chown_tree(const fs::path& directory, const passwd::user& user)
+{
+    const fs::directory dir(directory);
+    for (fs::directory::const_iterator iter = dir.begin(); iter != dir.end();
+         ++iter) {
+        if (iter->name == "." || iter->name == "..")
+            continue;
+
+        const fs::path entry = directory / iter->name;
+        if (::lchown(entry.c_str(), user.uid, user.gid) == -1) {
+            const int original_errno = errno;
+            throw fs::system_error(F("Cannot change owner of %s") % entry,
+                                   original_errno);
+        }
+        if (fs::is_directory(entry))
+            chown_tree(entry, user);
+    }
+}
+
+
 }  // anonymous namespace
 
 
@@ -567,6 +993,7 @@ struct utils::process::executor::executor_handle::impl : utils::noncopyable {
         stale_exec_handles(),
         cleaned(false)
     {
+        write_owner_marker(root_work_directory->directory());
     }
 
     /// Destructor.
@@ -589,38 +1016,34 @@ struct utils::process::executor::executor_handle::impl : utils::noncopyable {
     {
         PRE(!cleaned);
 
+        // Kill all subprocesses before waiting for any of them so that they
+        // all die at once; waiting for each in turn makes the cleanup of a
+        // run with many subprocesses in flight take forever.
+        std::vector< int > pids;
+        std::vector< fs::path > directories;
         for (exec_handles_map::const_iterator iter = all_exec_handles.begin();
              iter != all_exec_handles.end(); ++iter) {
-            const int& pid = (*iter).first;
-            const exec_handle& data = (*iter).second;
-
-            process::terminate_group(pid);
-            int status;
-            if (::waitpid(pid, &status, 0) == -1) {
-                // Should not happen.
-                LW(F("Failed to wait for PID %s") % pid);
-            }
-
-            try {
-                fs::rm_r(data.control_directory());
-            } catch (const fs::error& e) {
-                LE(F("Failed to clean up subprocess work directory %s: %s") %
-                   data.control_directory() % e.what());
-            }
+            process::terminate_group((*iter).first);
+            pids.push_back((*iter).first);
+            directories.push_back((*iter).second.control_directory());
         }
+        reap_all(pids, reap_timeout);
         all_exec_handles.clear();
 
         for (auto iter : stale_exec_handles) {
             // The process already exited, so no need to kill and wait.
-            try {
-                fs::rm_r(iter.control_directory());
-            } catch (const fs::error& e) {
-                LE(F("Failed to clean up stale subprocess work directory "
-                    "%s: %s") % iter.control_directory() % e.what());
-            }
+            directories.push_back(iter.control_directory());
         }
         stale_exec_handles.clear();
 
+        remove_all(directories);
+
+        try {
+            fs::unlink(root_work_directory->directory() / owner_marker_name);
+        } catch (const fs::error& e) {
+            LW(F("Failed to delete owner marker: %s") % e.what());
+        }
+
         try {
             // The following only causes the work directory to be deleted, not
             // any of its contents, so we expect this to always succeed.  This
@@ -714,6 +1137,21 @@ executor::executor_handle::root_work_directory(void) const
 }
 
 
+/// Deletes the root work directories left behind by dead executors.
+///
+/// The scan happens in a detached subprocess and looks for roots next to the
+/// root of this executor that belong to the same user and whose owner is gone
+/// from the current host.  It is not done implicitly during setup because only
+/// long-lived users of the executor, like the execution of a test suite, should
+/// pay for it.
+void
+executor::executor_handle::reclaim_orphans(void)
+{
+    reclaim_orphans_in_background(
+        _pimpl->root_work_directory->directory().branch_path());
+}
+
+
 /// Cleans up the executor state.
 ///
 /// This function should be called explicitly as it provides the means to
@@ -745,9 +1183,20 @@ executor::setup(void)
 
 /// Pre-helper for the spawn() method.
 ///
+/// \param work_template If not none, directory whose contents to copy into
+///     the work directory of the subprocess.
+/// \param unprivileged_user If not none, user that will own the copies of the
+///     template.
+///
 /// \return The created control directory for the subprocess.
+///
+/// \throw fs::error If the work directory cannot be populated.  The control
+///     directory is deleted in this case, so the caller can retry the spawn
+///     without a template.
 fs::path
-executor::executor_handle::spawn_pre(void)
+executor::executor_handle::spawn_pre(
+    const optional< fs::path >& work_template,
+    const optional< passwd::user >& unprivileged_user)
 {
     signals::check_interrupt();
 
@@ -756,7 +1205,29 @@ executor::executor_handle::spawn_pre(void)
     const fs::path control_directory =
         _pimpl->root_work_directory->directory() /
         (F("%s") % _pimpl->last_subprocess);
-    fs::mkdir_p(control_directory / detail::work_subdir, 0755);
+    const fs::path work_directory = control_directory / detail::work_subdir;
+    fs::mkdir_p(work_directory, 0755);
+
+    if (work_template) {
+        // The copy happens here, in the parent, so that any errors can be
+        // reported to the caller.  This serializes the population of the work
+        // directories of concurrent subprocesses, but file cloning keeps this
+        // cheap where supported.
+        LD(F("Populating %s from %s") % work_directory % work_template.get());
+        try {
+            fs::copy_tree(work_template.get(), work_directory);
+            if (unprivileged_user && passwd::current_user().is_root())
+                chown_tree(work_directory, unprivileged_user.get());
+        } catch (const fs::error& e) {
+            try {
+                fs::rm_r(control_directory);
+            } catch (const fs::error& e2) {
+                LW(F("Failed to delete partially populated directory %s: %s")
+                   % control_directory % e2.what());
+            }
+            throw;
+        }
+    }
 
     return control_directory;
 }
@@ -879,6 +1350,22 @@ executor::executor_handle::wait_any(void)
 }
 
 
+/// Checks for the completion of any forked process without blocking.
+///
+/// \return An object describing a terminated subprocess, or none if all
+/// subprocesses are still running.
+optional< executor::exit_handle >
+executor::executor_handle::try_wait_any(void)
+{
+    signals::check_interrupt();
+    const optional< process::status > status = process::try_wait_any();
+    if (!status)
+        return none;
+    return utils::make_optional(_pimpl->post_wait(status.get().dead_pid(),
+                                                  status.get()));
+}
+
+
 /// Checks if an interrupt has fired.
 ///
 /// Calls to this function should be sprinkled in strategic places through the
@@ -55,7 +55,8 @@
 ///
 /// Processes executed in this manner have access to two different "unique"
 /// directories: the first is the "work directory", which is an empty directory
-/// that acts as the subprocess' work directory; the second is the "control
+/// (or a copy of a template directory given to spawn()) that acts as the
+/// subprocess' work directory; the second is the "control
 /// directory", which is the location where the in-process code may place files
 /// that are not clobbered by activities in the work directory.
 
@@ -181,7 +182,9 @@ class executor_handle {
     friend executor_handle setup(void);
     executor_handle(void) throw();
 
-    utils::fs::path spawn_pre(void);
+    utils::fs::path spawn_pre(
+        const utils::optional< utils::fs::path >&,
+        const utils::optional< utils::passwd::user >&);
     exec_handle spawn_post(const utils::fs::path&,
                            const utils::fs::path&,
                            const utils::fs::path&,
@@ -199,6 +202,7 @@ public:
 
     const utils::fs::path& root_work_directory(void) const;
 
+    void reclaim_orphans(void);
     void cleanup(void);
 
     template< class Hook >
@@ -206,6 +210,7 @@ public:
                       const datetime::delta&,
                       const utils::optional< utils::passwd::user >,
                       const utils::optional< utils::fs::path > = utils::none,
+                      const utils::optional< utils::fs::path > = utils::none,
                       const utils::optional< utils::fs::path > = utils::none);
 
     template< class Hook >
@@ -215,6 +220,7 @@ public:
 
     exit_handle wait(const exec_handle);
     exit_handle wait_any(void);
+    utils::optional< exit_handle > try_wait_any(void);
 
     void check_interrupt(void) const;
 };
@@ -110,6 +110,8 @@ public:
 ///     test case.
 /// \param stderr_target If not none, file to which to write the stderr of the
 ///     test case.
+/// \param work_template If not none, directory whose contents to copy into
+///     the work directory of the subprocess before running it.
 ///
 /// \return A handle for the background operation.  Used to match the result of
 /// the execution returned by wait_any() with this invocation.
@@ -120,9 +122,11 @@ executor::executor_handle::spawn(
     const datetime::delta& timeout,
     const optional< passwd::user > unprivileged_user,
     const optional< fs::path > stdout_target,
-    const optional< fs::path > stderr_target)
+    const optional< fs::path > stderr_target,
+    const optional< fs::path > work_template)
 {
-    const fs::path unique_work_directory = spawn_pre();
+    const fs::path unique_work_directory = spawn_pre(work_template,
+                                                     unprivileged_user);
 
     const fs::path stdout_path = stdout_target ?
         stdout_target.get() : (unique_work_directory / detail::stdout_name);
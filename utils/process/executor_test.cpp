@@ -50,6 +50,7 @@ extern "C" {
 #include "utils/env.hpp"
 #include "utils/format/containers.ipp"
 #include "utils/format/macros.hpp"
+#include "utils/fs/exceptions.hpp"
 #include "utils/fs/operations.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/optional.ipp"
@@ -207,6 +208,37 @@ child_pause(const fs::path& /* control_directory */)
 }
 
 
+/// Subprocess that populates its work directory and then blocks.
+class child_populate_and_pause {
+    /// Number of files to create.
+    std::size_t _num_files;
+
+public:
+    /// Constructor.
+    ///
+    /// \param num_files Number of files to create.
+    child_populate_and_pause(const std::size_t num_files) :
+        _num_files(num_files)
+    {
+    }
+
+    /// Runs the subprocess.
+    ///
+    /// \param control_directory Directory where the "populated" cookie is
+    ///     created once all files exist.
+    void
+    operator()(const fs::path& control_directory)
+        UTILS_NORETURN
+    {
+        fs::mkdir(fs::path("tree"), 0755);
+        for (std::size_t i = 0; i < _num_files; ++i)
+            atf::utils::create_file(F("tree/file%s") % i, "some contents\n");
+        atf::utils::create_file((control_directory / "populated").str(), "");
+        child_pause(control_directory);
+    }
+};
+
+
 static void child_print(const fs::path&) UTILS_NORETURN;
 
 
@@ -308,6 +340,8 @@ child_validate_isolation(const fs::path& /* control_directory */)
 ///     test case.
 /// \param stderr_target If not none, file to which to write the stderr of the
 ///     test case.
+/// \param work_template If not none, directory with which to populate the
+///     work directory of the child.
 ///
 /// \return The exec handle for the spawned binary.
 template< class Hook >
@@ -316,10 +350,12 @@ do_spawn(executor::executor_handle& handle, Hook hook,
          const datetime::delta& timeout = infinite_timeout,
          const optional< passwd::user > unprivileged_user = none,
          const optional< fs::path > stdout_target = none,
-         const optional< fs::path > stderr_target = none)
+         const optional< fs::path > stderr_target = none,
+         const optional< fs::path > work_template = none)
 {
     const executor::exec_handle exec_handle = handle.spawn< Hook >(
-        hook, timeout, unprivileged_user, stdout_target, stderr_target);
+        hook, timeout, unprivileged_user, stdout_target, stderr_target,
+        work_template);
     return exec_handle;
 }
 
@@ -391,6 +427,26 @@ ATF_TEST_CASE_BODY(integration__run_one)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(integration__try_wait_any);
+ATF_TEST_CASE_BODY(integration__try_wait_any)
+{
+    executor::executor_handle handle = executor::setup();
+
+    const executor::exec_handle exec_handle = do_spawn(handle, child_sleep(1));
+
+    ATF_REQUIRE(!handle.try_wait_any());
+
+    optional< executor::exit_handle > exit_handle;
+    while (!(exit_handle = handle.try_wait_any()))
+        ::usleep(10000);
+    ATF_REQUIRE_EQ(exec_handle.pid(), exit_handle.get().original_pid());
+    require_exit(EXIT_SUCCESS, exit_handle.get().status());
+    exit_handle.get().cleanup();
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__run_many);
 ATF_TEST_CASE_BODY(integration__run_many)
 {
@@ -556,6 +612,40 @@ ATF_TEST_CASE_BODY(integration__files)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(integration__work_template);
+ATF_TEST_CASE_BODY(integration__work_template)
+{
+    fs::mkdir(fs::path("template"), 0755);
+    fs::mkdir(fs::path("template/subdir"), 0755);
+    atf::utils::create_file("template/subdir/data", "Template contents");
+
+    executor::executor_handle handle = executor::setup();
+
+    for (int i = 0; i < 2; ++i)
+        do_spawn(handle, child_create_cookie("subdir/cookie"),
+                 infinite_timeout, none, none, none,
+                 utils::make_optional(fs::path("template")));
+
+    for (int i = 0; i < 2; ++i) {
+        executor::exit_handle exit_handle = handle.wait_any();
+        require_exit(EXIT_SUCCESS, exit_handle.status());
+
+        const fs::path work_directory = exit_handle.work_directory();
+        ATF_REQUIRE(atf::utils::compare_file(
+            (work_directory / "subdir/data").str(), "Template contents"));
+        ATF_REQUIRE(atf::utils::file_exists(
+            (work_directory / "subdir/cookie").str()));
+
+        exit_handle.cleanup();
+        ATF_REQUIRE(!atf::utils::file_exists(work_directory.str()));
+    }
+
+    ATF_REQUIRE(!atf::utils::file_exists("template/subdir/cookie"));
+
+    handle.cleanup();
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(integration__followup);
 ATF_TEST_CASE_BODY(integration__followup)
 {
@@ -752,6 +842,213 @@ ATF_TEST_CASE_BODY(integration__auto_cleanup)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(integration__cleanup__many_in_flight);
+ATF_TEST_CASE_BODY(integration__cleanup__many_in_flight)
+{
+    static const std::size_t num_children = 64;
+
+    executor::executor_handle handle = executor::setup();
+    const fs::path root_work_directory = handle.root_work_directory();
+
+    std::vector< int > pids;
+    std::vector< fs::path > cookies;
+    for (std::size_t i = 0; i < num_children; ++i) {
+        const executor::exec_handle exec_handle = do_spawn(
+            handle, child_populate_and_pause(200));
+        pids.push_back(exec_handle.pid());
+        cookies.push_back(exec_handle.control_directory() / "populated");
+    }
+    for (std::vector< fs::path >::const_iterator iter = cookies.begin();
+         iter != cookies.end(); ++iter) {
+        while (!atf::utils::file_exists((*iter).str()))
+            ::usleep(10000);
+    }
+
+    const datetime::timestamp start = datetime::timestamp::now();
+    handle.cleanup();
+    const datetime::delta elapsed = datetime::timestamp::now() - start;
+    // How long the cleanup takes depends too much on the machine to check it
+    // by default, so only do so if the user tells us what to expect.
+    if (has_config_var("cleanup_max_seconds")) {
+        const int max_seconds = text::to_type< int >(
+            get_config_var("cleanup_max_seconds"));
+        ATF_REQUIRE(elapsed < datetime::delta(max_seconds, 0));
+    }
+
+    for (std::vector< int >::const_iterator iter = pids.begin();
+         iter != pids.end(); ++iter) {
+        ensure_dead(*iter);
+    }
+    ATF_REQUIRE(!atf::utils::file_exists(root_work_directory.str()));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__owner_marker);
+ATF_TEST_CASE_BODY(integration__owner_marker)
+{
+    executor::executor_handle handle = executor::setup();
+    const fs::path root_work_directory = handle.root_work_directory();
+    ATF_REQUIRE(atf::utils::grep_file(F("^%s ") % ::getpid(),
+                                      (root_work_directory / "owner").str()));
+    handle.cleanup();
+    ATF_REQUIRE(!atf::utils::file_exists(root_work_directory.str()));
+}
+
+
+/// Creates a fake root work directory as left behind by an executor.
+///
+/// \param directory The root work directory to create.
+/// \param owner Contents of the owner marker, or none to not create one.
+static void
+create_fake_root(const fs::path& directory, const optional< std::string > owner)
+{
+    fs::mkdir_p(directory / "1/work/subdir", 0755);
+    atf::utils::create_file((directory / "1/work/subdir/file").str(), "foo\n");
+    if (owner)
+        atf::utils::create_file((directory / "owner").str(), owner.get());
+}
+
+
+/// Waits for a file to disappear.
+///
+/// \param file The file to wait for.
+///
+/// \return True if the file disappeared within a reasonable time; false
+/// otherwise.
+static bool
+wait_for_removal(const fs::path& file)
+{
+    for (int attempts = 100; attempts > 0; --attempts) {
+        if (!fs::exists(file))
+            return true;
+        ::usleep(100000);
+    }
+    return !fs::exists(file);
+}
+
+
+/// Creates a process that exits immediately and waits for it.
+///
+/// \return The PID of the process, which is not in use any longer.
+static pid_t
+find_dead_pid(void)
+{
+    const pid_t pid = ::fork();
+    ATF_REQUIRE(pid != -1);
+    if (pid == 0)
+        ::_exit(EXIT_SUCCESS);
+    int status;
+    ATF_REQUIRE(::waitpid(pid, &status, 0) != -1);
+    return pid;
+}
+
+
+/// Gets the host identity recorded in the owner marker of an executor.
+///
+/// \param handle The executor whose marker to read.
+///
+/// \return The identity, which follows the PID and the start time of the owner.
+static std::string
+host_identity(executor::executor_handle& handle)
+{
+    std::ifstream marker((handle.root_work_directory() / "owner").c_str());
+    std::string identity;
+    ATF_REQUIRE(std::getline(marker, identity));
+    for (int i = 0; i < 2; ++i)
+        identity = identity.substr(identity.find(' ') + 1);
+    return identity;
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(integration__reclaim_orphans);
+ATF_TEST_CASE_BODY(integration__reclaim_orphans)
+{
+    const fs::path tmpdir = fs::current_path() / "tmp";
+    fs::mkdir(tmpdir, 0755);
+    utils::setenv("TMPDIR", tmpdir.str());
+
+    const pid_t dead_pid = find_dead_pid();
+
+    executor::executor_handle handle = executor::setup();
+    const std::string identity = host_identity(handle);
+
+    const std::string dead_owner = F("%s - %s\n") % dead_pid % identity;
+    const std::string live_owner = F("%s - %s\n") % ::getpid() % identity;
+    const std::string reused_owner = F("%s 1 %s\n") % ::getpid() % identity;
+    const std::string foreign_owner = F("%s - other-host - -\n") % dead_pid;
+    const std::string legacy_owner = F("%s -\n") % dead_pid;
+    create_fake_root(tmpdir / "kyua.orphan", utils::make_optional(dead_owner));
+    create_fake_root(tmpdir / "kyua.reused",
+                     utils::make_optional(reused_owner));
+    create_fake_root(tmpdir / "kyua.alive", utils::make_optional(live_owner));
+    create_fake_root(tmpdir / "kyua.foreign",
+                     utils::make_optional(foreign_owner));
+    create_fake_root(tmpdir / "kyua.legacy",
+                     utils::make_optional(legacy_owner));
+    create_fake_root(tmpdir / "kyua.unowned", none);
+    create_fake_root(tmpdir / "other", utils::make_optional(dead_owner));
+
+    handle.reclaim_orphans();
+
+    ATF_REQUIRE(wait_for_removal(tmpdir / "kyua.orphan"));
+    if (fs::exists(fs::path("/proc/self/stat"))) {
+        // Only supported where we can query the start time of a process.
+        ATF_REQUIRE(wait_for_removal(tmpdir / "kyua.reused"));
+    }
+    ATF_REQUIRE(fs::exists(tmpdir / "kyua.alive"));
+    ATF_REQUIRE(fs::exists(tmpdir / "kyua.foreign"));
+    ATF_REQUIRE(fs::exists(tmpdir / "kyua.legacy"));
+    ATF_REQUIRE(fs::exists(tmpdir / "kyua.unowned"));
+    ATF_REQUIRE(fs::exists(tmpdir / "other"));
+    ATF_REQUIRE(fs::exists(handle.root_work_directory()));
+
+    handle.cleanup();
+}
+
+
+ATF_TEST_CASE_WITH_CLEANUP(integration__reclaim_orphans__mounted);
+ATF_TEST_CASE_HEAD(integration__reclaim_orphans__mounted)
+{
+    set_md_var("require.user", "root");
+}
+ATF_TEST_CASE_BODY(integration__reclaim_orphans__mounted)
+{
+    const fs::path tmpdir = fs::current_path() / "tmp";
+    fs::mkdir(tmpdir, 0755);
+    utils::setenv("TMPDIR", tmpdir.str());
+
+    executor::executor_handle handle = executor::setup();
+    const fs::path orphan = tmpdir / "kyua.orphan";
+    const std::string dead_owner = F("%s - %s\n") % find_dead_pid() %
+        host_identity(handle);
+    create_fake_root(orphan, utils::make_optional(dead_owner));
+
+    const fs::path outer = orphan / "1/work/outer";
+    fs::mkdir(outer, 0755);
+    try {
+        fs::mount_tmpfs(outer);
+    } catch (const fs::unsupported_operation_error& e) {
+        ATF_SKIP(e.what());
+    }
+    fs::mkdir(outer / "inner", 0755);
+    fs::mount_tmpfs(outer / "inner");
+    atf::utils::create_file((outer / "inner/file").str(), "");
+
+    handle.reclaim_orphans();
+
+    ATF_REQUIRE(wait_for_removal(orphan));
+    handle.cleanup();
+}
+ATF_TEST_CASE_CLEANUP(integration__reclaim_orphans__mounted)
+{
+    const fs::path outer = fs::current_path() / "tmp/kyua.orphan/1/work/outer";
+    if (fs::exists(outer / "inner/file"))
+        fs::unmount(outer / "inner");
+    if (fs::exists(outer / "inner"))
+        fs::unmount(outer);
+}
+
+
 /// Ensures that interrupting an executor cleans things up correctly.
 ///
 /// This test scenario is tricky.  We spawn a master child process that runs the
@@ -921,11 +1218,13 @@ ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, integration__run_one);
     ATF_ADD_TEST_CASE(tcs, integration__run_many);
+    ATF_ADD_TEST_CASE(tcs, integration__try_wait_any);
 
     ATF_ADD_TEST_CASE(tcs, integration__parameters_and_output);
     ATF_ADD_TEST_CASE(tcs, integration__custom_output_files);
     ATF_ADD_TEST_CASE(tcs, integration__timestamps);
     ATF_ADD_TEST_CASE(tcs, integration__files);
+    ATF_ADD_TEST_CASE(tcs, integration__work_template);
 
     ATF_ADD_TEST_CASE(tcs, integration__followup);
 
@@ -933,6 +1232,10 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, integration__timeouts);
     ATF_ADD_TEST_CASE(tcs, integration__unprivileged_user);
     ATF_ADD_TEST_CASE(tcs, integration__auto_cleanup);
+    ATF_ADD_TEST_CASE(tcs, integration__cleanup__many_in_flight);
+    ATF_ADD_TEST_CASE(tcs, integration__owner_marker);
+    ATF_ADD_TEST_CASE(tcs, integration__reclaim_orphans);
+    ATF_ADD_TEST_CASE(tcs, integration__reclaim_orphans__mounted);
     ATF_ADD_TEST_CASE(tcs, integration__signal_handling);
     ATF_ADD_TEST_CASE(tcs, integration__isolate_child_is_called);
     ATF_ADD_TEST_CASE(tcs, integration__process_group_is_terminated);
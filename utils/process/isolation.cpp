@@ -29,6 +29,8 @@
 #include "utils/process/isolation.hpp"
 
 extern "C" {
+#include <sys/types.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 
 #include <grp.h>
@@ -101,6 +103,35 @@ do_chown(const fs::path& file, const uid_t uid, const gid_t gid)
 }
 
 
+/// Lowers a resource limit of the current process.
+///
+/// If the new limit is higher than the current hard limit, the current hard
+/// limit is kept instead because the process cannot raise it.
+///
+/// \param resource The resource to limit.
+/// \param name The name of the resource, for error reporting purposes.
+/// \param soft The new soft limit.
+/// \param hard The new hard limit.  Must not be lower than soft.
+static void
+set_limit(const int resource, const char* name, const uint64_t soft,
+          const uint64_t hard)
+{
+    PRE(soft <= hard);
+
+    struct ::rlimit rl;
+    if (::getrlimit(resource, &rl) == -1)
+        fail(F("getrlimit(%s) failed") % name, errno);
+
+    if (rl.rlim_max == RLIM_INFINITY || hard < rl.rlim_max)
+        rl.rlim_max = static_cast< rlim_t >(hard);
+    rl.rlim_cur = soft < rl.rlim_max ? static_cast< rlim_t >(soft) :
+        rl.rlim_max;
+
+    if (::setrlimit(resource, &rl) == -1)
+        fail(F("setrlimit(%s, %s) failed") % name % rl.rlim_cur, errno);
+}
+
+
 /// Resets the environment of the process to a known state.
 ///
 /// \param work_directory Path to the work directory being used.
@@ -205,3 +236,48 @@ process::isolate_path(const optional< passwd::user >& unprivileged_user,
         do_chown(file, user.uid, ::getgid());
     }
 }
+
+
+/// Constructs a set of limits that leaves all resources unrestricted.
+process::resource_limits::resource_limits(void) :
+    memory(0), file_size(0), open_files(0), processes(0)
+{
+}
+
+
+/// Applies resource limits to the current process.
+///
+/// This is intended to be called from a subprocess after isolate_child() and
+/// right before invoking an external binary, which inherits the limits.  If
+/// there is any error, the process is terminated with an error code.
+///
+/// Limits that the host system does not support are silently ignored.
+///
+/// \param limits The limits to apply.
+void
+process::limit_resources(const resource_limits& limits)
+{
+    if (limits.memory > 0) {
+#if defined(RLIMIT_AS)
+        set_limit(RLIMIT_AS, "RLIMIT_AS", limits.memory, limits.memory);
+#endif
+        set_limit(RLIMIT_DATA, "RLIMIT_DATA", limits.memory, limits.memory);
+    }
+
+    if (limits.file_size > 0) {
+        set_limit(RLIMIT_FSIZE, "RLIMIT_FSIZE", limits.file_size,
+                  limits.file_size);
+    }
+
+    if (limits.open_files > 0) {
+        set_limit(RLIMIT_NOFILE, "RLIMIT_NOFILE", limits.open_files,
+                  limits.open_files);
+    }
+
+#if defined(RLIMIT_NPROC)
+    if (limits.processes > 0) {
+        set_limit(RLIMIT_NPROC, "RLIMIT_NPROC", limits.processes,
+                  limits.processes);
+    }
+#endif
+}
@@ -35,6 +35,8 @@
 #if !defined(UTILS_PROCESS_ISOLATION_HPP)
 #define UTILS_PROCESS_ISOLATION_HPP
 
+#include <cstdint>
+
 #include "utils/fs/path_fwd.hpp"
 #include "utils/optional_fwd.hpp"
 #include "utils/passwd_fwd.hpp"
@@ -46,12 +48,39 @@ namespace process {
 extern const int exit_isolation_failure;
 
 
+/// Limits on the resources that an isolated process can consume.
+///
+/// Limits set to zero are left as inherited from the parent process.  Limits
+/// higher than the hard limits of the parent are capped to those.
+struct resource_limits {
+    /// Maximum size of the address space and of the data segment, in bytes.
+    uint64_t memory;
+
+    /// Maximum size of the files written, in bytes.  The process gets a
+    /// SIGXFSZ when it tries to grow a file past this size.
+    uint64_t file_size;
+
+    /// Maximum number of open file descriptors.
+    unsigned long open_files;
+
+    /// Maximum number of processes of the user running the process.
+    ///
+    /// Beware that the kernel counts all the processes of the real user, not
+    /// only the descendants of the limited process.
+    unsigned long processes;
+
+    resource_limits(void);
+};
+
+
 void isolate_child(const utils::optional< utils::passwd::user >&,
                    const utils::fs::path&);
 
 void isolate_path(const utils::optional< utils::passwd::user >&,
                   const utils::fs::path&);
 
+void limit_resources(const resource_limits&);
+
 
 }  // namespace process
 }  // namespace utils
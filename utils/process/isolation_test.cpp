@@ -33,10 +33,12 @@ extern "C" {
 #include <sys/resource.h>
 #include <sys/stat.h>
 
+#include <signal.h>
 #include <unistd.h>
 }
 
 #include <cerrno>
+#include <cstddef>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -598,6 +600,123 @@ ATF_TEST_CASE_BODY(isolate_path__drop_privileges_only_gid)
 }
 
 
+/// Subprocess that writes past its file size limit.
+///
+/// \post Terminates due to SIGXFSZ if the limit is enforced; exits with
+/// success otherwise.
+static void
+check_file_size_limit(void)
+{
+    process::resource_limits limits;
+    limits.file_size = 1024;
+    process::limit_resources(limits);
+
+    std::ofstream output("file");
+    for (int i = 0; i < 2048; ++i)
+        output << 'x';
+    output.close();
+    std::exit(EXIT_SUCCESS);
+}
+
+
+/// Subprocess that prints the resulting limits.
+///
+/// \post The stdout of the subprocess contains the soft and hard limits of the
+/// number of open files and maximum memory, in this order, one per line.
+static void
+print_limits(void)
+{
+    process::resource_limits limits;
+    limits.open_files = 50;
+    limits.memory = 1024 * 1024 * 1024;
+    process::limit_resources(limits);
+
+    const int resources[] = { RLIMIT_NOFILE, RLIMIT_DATA };
+    for (std::size_t i = 0; i < sizeof(resources) / sizeof(resources[0]);
+         ++i) {
+        struct ::rlimit rl;
+        if (::getrlimit(resources[i], &rl) == -1)
+            std::exit(EXIT_FAILURE);
+        std::cout << rl.rlim_cur << ' ' << rl.rlim_max << '\n';
+    }
+    std::exit(EXIT_SUCCESS);
+}
+
+
+/// Subprocess that requests a limit above its current hard limit.
+///
+/// \post Exits with success if the hard limit has been respected; failure
+/// otherwise.
+static void
+check_limit_above_hard(void)
+{
+    struct ::rlimit rl;
+    if (::getrlimit(RLIMIT_NOFILE, &rl) == -1)
+        std::exit(EXIT_FAILURE);
+    rl.rlim_max = rl.rlim_cur = 40;
+    if (::setrlimit(RLIMIT_NOFILE, &rl) == -1)
+        std::exit(EXIT_FAILURE);
+
+    process::resource_limits limits;
+    limits.open_files = 100;
+    process::limit_resources(limits);
+
+    if (::getrlimit(RLIMIT_NOFILE, &rl) == -1)
+        std::exit(EXIT_FAILURE);
+    std::exit(rl.rlim_cur == 40 && rl.rlim_max == 40 ?
+              EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(limit_resources__none);
+ATF_TEST_CASE_BODY(limit_resources__none)
+{
+    struct ::rlimit before;
+    ATF_REQUIRE(::getrlimit(RLIMIT_NOFILE, &before) != -1);
+    process::limit_resources(process::resource_limits());
+    struct ::rlimit after;
+    ATF_REQUIRE(::getrlimit(RLIMIT_NOFILE, &after) != -1);
+    ATF_REQUIRE_EQ(before.rlim_cur, after.rlim_cur);
+    ATF_REQUIRE_EQ(before.rlim_max, after.rlim_max);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(limit_resources__values);
+ATF_TEST_CASE_BODY(limit_resources__values)
+{
+    const process::status status = fork_and_run(print_limits);
+    ATF_REQUIRE(status.exited());
+    ATF_REQUIRE_EQ(EXIT_SUCCESS, status.exitstatus());
+
+    std::ifstream input("subprocess.stdout");
+    unsigned long soft, hard;
+    ATF_REQUIRE(input >> soft >> hard);
+    ATF_REQUIRE_EQ(50UL, soft);
+    ATF_REQUIRE_EQ(50UL, hard);
+    ATF_REQUIRE(input >> soft >> hard);
+    ATF_REQUIRE_EQ(1024UL * 1024 * 1024, soft);
+    ATF_REQUIRE_EQ(1024UL * 1024 * 1024, hard);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(limit_resources__file_size_exceeded);
+ATF_TEST_CASE_BODY(limit_resources__file_size_exceeded)
+{
+    const process::status status = fork_and_run(check_file_size_limit);
+    ATF_REQUIRE(status.signaled());
+    ATF_REQUIRE_EQ(SIGXFSZ, status.termsig());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(limit_resources__capped_to_hard_limit);
+ATF_TEST_CASE_BODY(limit_resources__capped_to_hard_limit)
+{
+    const process::status status = fork_and_run(check_limit_above_hard);
+    ATF_REQUIRE(status.exited());
+    ATF_REQUIRE_EQ(EXIT_SUCCESS, status.exitstatus());
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, isolate_child__clean_environment);
@@ -619,4 +738,9 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, isolate_path__drop_privileges);
     ATF_ADD_TEST_CASE(tcs, isolate_path__drop_privileges_only_uid);
     ATF_ADD_TEST_CASE(tcs, isolate_path__drop_privileges_only_gid);
+
+    ATF_ADD_TEST_CASE(tcs, limit_resources__none);
+    ATF_ADD_TEST_CASE(tcs, limit_resources__values);
+    ATF_ADD_TEST_CASE(tcs, limit_resources__file_size_exceeded);
+    ATF_ADD_TEST_CASE(tcs, limit_resources__capped_to_hard_limit);
 }
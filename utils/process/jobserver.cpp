@@ -0,0 +1,443 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "utils/process/jobserver.hpp"
+
+extern "C" {
+#include <sys/stat.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+}
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/optional.ipp"
+#include "utils/process/exceptions.hpp"
+#include "utils/sanity.hpp"
+#include "utils/text/exceptions.hpp"
+#include "utils/text/operations.ipp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace process = utils::process;
+namespace text = utils::text;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Token written to jobservers created by us.
+static const char token_char = '+';
+
+
+/// Extracts the jobserver specification from the value of MAKEFLAGS.
+///
+/// \param makeflags The value of the MAKEFLAGS environment variable.
+///
+/// \return The value of the last --jobserver-auth (or --jobserver-fds, as
+/// used by GNU make before 4.2) flag, or none if there is no such flag.
+static optional< std::string >
+find_auth(const std::string& makeflags)
+{
+    static const char* const prefixes[] = {
+        "--jobserver-auth=", "--jobserver-fds=", NULL };
+
+    optional< std::string > auth;
+    const std::vector< std::string > words = text::split(makeflags, ' ');
+    for (std::vector< std::string >::const_iterator iter = words.begin();
+         iter != words.end(); ++iter) {
+        // Anything after a lone "--" are variable definitions, not flags.
+        if (*iter == "--")
+            break;
+        for (const char* const* prefix = prefixes; *prefix != NULL;
+             ++prefix) {
+            if (iter->compare(0, std::strlen(*prefix), *prefix) == 0)
+                auth = iter->substr(std::strlen(*prefix));
+        }
+    }
+    return auth;
+}
+
+
+/// Checks if a file descriptor is open and refers to a pipe or a FIFO.
+///
+/// \param fd The file descriptor to check.
+///
+/// \return True if the file descriptor can be used to talk to a jobserver.
+static bool
+is_pipe(const int fd)
+{
+    struct ::stat sb;
+    return ::fstat(fd, &sb) != -1 && S_ISFIFO(sb.st_mode);
+}
+
+
+/// Opens a private, non-blocking descriptor for the read end of a pipe.
+///
+/// Setting O_NONBLOCK on an inherited descriptor would affect all the other
+/// processes sharing it, which may not be prepared for it.  Instead, we try to
+/// reopen the pipe through the file descriptor file system, which yields a new
+/// open file description.
+///
+/// \param fd The inherited descriptor of the read end of the pipe.
+///
+/// \return The new descriptor, or none if the system cannot reopen the pipe.
+static optional< int >
+reopen_nonblocking(const int fd)
+{
+    const fs::path fd_file(F("/dev/fd/%s") % fd);
+    const int new_fd = ::open(fd_file.c_str(), O_RDONLY | O_NONBLOCK);
+    if (new_fd == -1)
+        return none;
+
+    struct ::stat old_sb, new_sb;
+    if (::fstat(fd, &old_sb) == -1 || ::fstat(new_fd, &new_sb) == -1 ||
+        old_sb.st_dev != new_sb.st_dev || old_sb.st_ino != new_sb.st_ino) {
+        ::close(new_fd);
+        return none;
+    }
+    (void)::fcntl(new_fd, F_SETFD, FD_CLOEXEC);
+    return utils::make_optional(new_fd);
+}
+
+
+}  // anonymous namespace
+
+
+/// Internal implementation for the jobserver class.
+struct utils::process::jobserver::impl : utils::noncopyable {
+    /// Descriptor from which to read tokens.
+    int read_fd;
+
+    /// Whether read_fd was opened by us and thus needs to be closed.
+    bool close_read_fd;
+
+    /// Whether read_fd is in non-blocking mode.
+    bool nonblocking;
+
+    /// Descriptor to which to write tokens back.
+    int write_fd;
+
+    /// Whether write_fd was opened by us and thus needs to be closed.
+    bool close_write_fd;
+
+    /// Path to the FIFO we created and need to delete, if any.
+    optional< fs::path > fifo;
+
+    /// Number of tokens we put in the jobserver we created, if any.
+    std::size_t tokens;
+
+    /// Tokens currently held by this process, in the order acquired.
+    std::vector< char > held;
+
+    /// Constructor.
+    ///
+    /// \param read_fd_ Descriptor from which to read tokens.
+    /// \param close_read_fd_ Whether read_fd_ is owned by the new object.
+    /// \param nonblocking_ Whether read_fd_ is in non-blocking mode.
+    /// \param write_fd_ Descriptor to which to write tokens back.
+    /// \param close_write_fd_ Whether write_fd_ is owned by the new object.
+    impl(const int read_fd_, const bool close_read_fd_,
+         const bool nonblocking_, const int write_fd_,
+         const bool close_write_fd_) :
+        read_fd(read_fd_), close_read_fd(close_read_fd_),
+        nonblocking(nonblocking_), write_fd(write_fd_),
+        close_write_fd(close_write_fd_), tokens(0)
+    {
+    }
+
+    /// Destructor.
+    ~impl(void)
+    {
+        if (close_read_fd)
+            ::close(read_fd);
+        if (close_write_fd && write_fd != read_fd)
+            ::close(write_fd);
+        if (fifo && ::unlink(fifo.get().c_str()) == -1)
+            LW(F("Failed to delete jobserver FIFO %s: %s") % fifo.get() %
+               std::strerror(errno));
+    }
+};
+
+
+/// Constructor.
+///
+/// \param pimpl Pointer to the internal implementation.
+process::jobserver::jobserver(impl* pimpl) :
+    _pimpl(pimpl)
+{
+}
+
+
+/// Destructor; returns any held tokens to the jobserver.
+process::jobserver::~jobserver(void)
+{
+    while (!_pimpl->held.empty())
+        release();
+}
+
+
+/// Connects to the jobserver described in the flags passed down by make.
+///
+/// \param makeflags The value of the MAKEFLAGS environment variable.
+///
+/// \return A new jobserver client, or NULL if the flags do not describe a
+/// jobserver or if the jobserver is not reachable from this process.  The
+/// latter happens when make does not consider us a recursive make and thus
+/// closes its jobserver descriptors before running us.
+///
+/// \throw process::error If the jobserver specification is malformed.
+/// \throw process::system_error If the jobserver FIFO cannot be opened.
+std::auto_ptr< process::jobserver >
+process::jobserver::join(const std::string& makeflags)
+{
+    const optional< std::string > auth = find_auth(makeflags);
+    if (!auth)
+        return std::auto_ptr< jobserver >();
+
+    if (auth.get().compare(0, 5, "fifo:") == 0) {
+        const fs::path fifo(auth.get().substr(5));
+        const int fd = ::open(fifo.c_str(), O_RDWR | O_NONBLOCK);
+        if (fd == -1) {
+            const int original_errno = errno;
+            throw process::system_error(F("Cannot open jobserver FIFO %s") %
+                                        fifo, original_errno);
+        }
+        (void)::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        LI(F("Joined jobserver at FIFO %s") % fifo);
+        return std::auto_ptr< jobserver >(new jobserver(
+            new impl(fd, true, true, fd, true)));
+    }
+
+    const std::string::size_type comma = auth.get().find(',');
+    int read_fd, write_fd;
+    try {
+        if (comma == std::string::npos)
+            throw text::value_error("Missing comma");
+        read_fd = text::to_type< int >(auth.get().substr(0, comma));
+        write_fd = text::to_type< int >(auth.get().substr(comma + 1));
+    } catch (const text::value_error& e) {
+        throw process::error(F("Invalid jobserver specification '%s' in "
+                               "MAKEFLAGS") % auth.get());
+    }
+
+    if (!is_pipe(read_fd) || !is_pipe(write_fd)) {
+        LW(F("Ignoring jobserver on descriptors %s,%s because they are not "
+             "open; is the recipe that runs us marked as recursive?") %
+           read_fd % write_fd);
+        return std::auto_ptr< jobserver >();
+    }
+
+    LI(F("Joined jobserver on descriptors %s,%s") % read_fd % write_fd);
+    const optional< int > private_fd = reopen_nonblocking(read_fd);
+    if (private_fd)
+        return std::auto_ptr< jobserver >(new jobserver(
+            new impl(private_fd.get(), true, true, write_fd, false)));
+    else
+        return std::auto_ptr< jobserver >(new jobserver(
+            new impl(read_fd, false, false, write_fd, false)));
+}
+
+
+/// Creates a new jobserver backed by a FIFO.
+///
+/// The new object acts as a client of the created jobserver too.
+///
+/// \param fifo Path to the FIFO to create.  Must not exist.
+/// \param tokens Number of tokens to preload the jobserver with; i.e. the
+///     number of jobs that can run concurrently minus one.
+///
+/// \return The new jobserver.
+///
+/// \throw process::system_error If the FIFO cannot be created.
+std::auto_ptr< process::jobserver >
+process::jobserver::create(const fs::path& fifo, const std::size_t tokens)
+{
+    // The FIFO must be usable by test cases running as a different user.
+    if (::mkfifo(fifo.c_str(), 0600) == -1 ||
+        ::chmod(fifo.c_str(), 0666) == -1) {
+        const int original_errno = errno;
+        throw process::system_error(F("Cannot create jobserver FIFO %s") %
+                                    fifo, original_errno);
+    }
+
+    const int fd = ::open(fifo.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd == -1) {
+        const int original_errno = errno;
+        (void)::unlink(fifo.c_str());
+        throw process::system_error(F("Cannot open jobserver FIFO %s") %
+                                    fifo, original_errno);
+    }
+    (void)::fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    std::auto_ptr< impl > pimpl(new impl(fd, true, true, fd, true));
+    pimpl->fifo = fifo;
+    pimpl->tokens = tokens;
+
+    const std::vector< char > buffer(tokens, token_char);
+    std::size_t done = 0;
+    while (done < tokens) {
+        const ssize_t written = ::write(fd, &buffer[done], tokens - done);
+        if (written == -1) {
+            if (errno == EINTR)
+                continue;
+            const int original_errno = errno;
+            throw process::system_error(F("Cannot fill jobserver FIFO %s") %
+                                        fifo, original_errno);
+        }
+        done += written;
+    }
+
+    LI(F("Created jobserver at FIFO %s with %s tokens") % fifo % tokens);
+    return std::auto_ptr< jobserver >(new jobserver(pimpl.release()));
+}
+
+
+/// Returns the MAKEFLAGS value that points children to this jobserver.
+///
+/// \pre The jobserver must have been created by create().
+///
+/// \return A value for the MAKEFLAGS environment variable.
+std::string
+process::jobserver::makeflags(void) const
+{
+    PRE(_pimpl->fifo);
+    return F("-j%s --jobserver-auth=fifo:%s") % (_pimpl->tokens + 1) %
+        _pimpl->fifo.get();
+}
+
+
+/// Returns the number of tokens currently held by this process.
+///
+/// \return A count of tokens, not including the implicit one.
+std::size_t
+process::jobserver::held(void) const
+{
+    return _pimpl->held.size();
+}
+
+
+/// Takes a token from the jobserver if one is available.
+///
+/// \return True if a token was acquired; false if none was available.
+///
+/// \throw process::system_error If the jobserver cannot be read.
+bool
+process::jobserver::try_acquire(void)
+{
+    return try_acquire(datetime::delta());
+}
+
+
+/// Takes a token from the jobserver, waiting for one for a limited time.
+///
+/// If the read descriptor could not be made non-blocking, we first check if
+/// there is data available and only then read it.  Another process may steal
+/// the token in between, in which case this waits until a token is returned.
+///
+/// \param timeout Maximum time to wait for a token to become available.
+///
+/// \return True if a token was acquired; false if none was available.
+///
+/// \throw process::system_error If the jobserver cannot be read.
+bool
+process::jobserver::try_acquire(const datetime::delta& timeout)
+{
+    if (!_pimpl->nonblocking || timeout > datetime::delta()) {
+        ::pollfd pfd;
+        pfd.fd = _pimpl->read_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        const int ret = ::poll(&pfd, 1, static_cast< int >(
+            timeout.to_microseconds() / 1000));
+        if (ret == 0 || (ret == -1 && errno == EINTR)) {
+            return false;
+        } else if (ret == -1) {
+            const int original_errno = errno;
+            throw process::system_error("Failed to poll the jobserver",
+                                        original_errno);
+        }
+    }
+
+    for (;;) {
+        char token;
+        const ssize_t ret = ::read(_pimpl->read_fd, &token, 1);
+        if (ret == 1) {
+            _pimpl->held.push_back(token);
+            LD(F("Acquired jobserver token; holding %s") %
+               _pimpl->held.size());
+            return true;
+        } else if (ret == 0) {
+            LD("Jobserver is gone");
+            return false;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return false;
+        } else if (errno != EINTR) {
+            const int original_errno = errno;
+            throw process::system_error("Failed to read from the jobserver",
+                                        original_errno);
+        }
+    }
+}
+
+
+/// Returns the most recently acquired token to the jobserver.
+///
+/// Errors are logged but otherwise ignored because there is nothing we can do
+/// to recover the token and failing would only make things worse.
+///
+/// \pre At least one token must be held.
+void
+process::jobserver::release(void)
+{
+    PRE(!_pimpl->held.empty());
+    const char token = _pimpl->held.back();
+    _pimpl->held.pop_back();
+
+    for (;;) {
+        if (::write(_pimpl->write_fd, &token, 1) == 1)
+            break;
+        if (errno != EINTR) {
+            LW(F("Failed to return token to the jobserver: %s") %
+               std::strerror(errno));
+            break;
+        }
+    }
+    LD(F("Released jobserver token; holding %s") % _pimpl->held.size());
+}
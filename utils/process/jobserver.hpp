@@ -0,0 +1,87 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file utils/process/jobserver.hpp
+/// Participation in the job control protocol of GNU make.
+///
+/// GNU make coordinates the parallelism of recursive invocations through a
+/// "jobserver": a pipe or named FIFO preloaded with one token (a byte) per
+/// job that may run in addition to the one each process implicitly owns.
+/// Processes take a token before starting an extra job and write it back
+/// once the job completes.  The location of the jobserver is passed down to
+/// children in the MAKEFLAGS environment variable.
+
+#if !defined(UTILS_PROCESS_JOBSERVER_HPP)
+#define UTILS_PROCESS_JOBSERVER_HPP
+
+#include "utils/process/jobserver_fwd.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "utils/datetime_fwd.hpp"
+#include "utils/fs/path_fwd.hpp"
+#include "utils/noncopyable.hpp"
+
+namespace utils {
+namespace process {
+
+
+/// Client of, and optionally owner of, a jobserver.
+///
+/// Any tokens held by an object of this class are returned to the jobserver
+/// when the object is destroyed.
+class jobserver : noncopyable {
+    struct impl;
+
+    /// Pointer to the internal implementation.
+    std::auto_ptr< impl > _pimpl;
+
+    explicit jobserver(impl*);
+
+public:
+    ~jobserver(void);
+
+    static std::auto_ptr< jobserver > join(const std::string&);
+    static std::auto_ptr< jobserver > create(const fs::path&,
+                                             const std::size_t);
+
+    std::string makeflags(void) const;
+    std::size_t held(void) const;
+
+    bool try_acquire(void);
+    bool try_acquire(const datetime::delta&);
+    void release(void);
+};
+
+
+}  // namespace process
+}  // namespace utils
+
+#endif  // !defined(UTILS_PROCESS_JOBSERVER_HPP)
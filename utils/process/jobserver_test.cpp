@@ -0,0 +1,279 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "utils/process/jobserver.hpp"
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include <atf-c++.hpp>
+
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/process/exceptions.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace process = utils::process;
+
+
+namespace {
+
+
+/// Reads all the bytes available in a pipe without blocking.
+///
+/// \param fd The read end of the pipe.
+///
+/// \return The bytes read.
+static std::string
+drain(const int fd)
+{
+    const int flags = ::fcntl(fd, F_GETFL);
+    ATF_REQUIRE(flags != -1);
+    ATF_REQUIRE(::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1);
+
+    std::string data;
+    char buffer[16];
+    ssize_t length;
+    while ((length = ::read(fd, buffer, sizeof(buffer))) > 0)
+        data.append(buffer, length);
+    return data;
+}
+
+
+/// Exercises a jobserver client connected to a pipe.
+///
+/// \param flag Name of the flag that passes the pipe descriptors.
+static void
+do_join_fds_test(const char* flag)
+{
+    int fds[2];
+    ATF_REQUIRE(::pipe(fds) != -1);
+    ATF_REQUIRE(::write(fds[1], "ab", 2) == 2);
+
+    {
+        std::auto_ptr< process::jobserver > jobserver =
+            process::jobserver::join(F("-j3 %s=%s,%s") % flag % fds[0] %
+                                     fds[1]);
+        ATF_REQUIRE(jobserver.get() != NULL);
+
+        ATF_REQUIRE(jobserver->try_acquire());
+        ATF_REQUIRE(jobserver->try_acquire());
+        ATF_REQUIRE(!jobserver->try_acquire());
+        ATF_REQUIRE_EQ(2, jobserver->held());
+
+        // The inherited descriptor must remain in blocking mode for others.
+        ATF_REQUIRE((::fcntl(fds[0], F_GETFL) & O_NONBLOCK) == 0);
+
+        jobserver->release();
+        ATF_REQUIRE_EQ(1, jobserver->held());
+        ATF_REQUIRE_EQ("b", drain(fds[0]));
+    }
+    // The destructor returns the remaining token.
+    ATF_REQUIRE_EQ("a", drain(fds[0]));
+
+    // The inherited descriptors must not be closed.
+    ATF_REQUIRE(::fcntl(fds[0], F_GETFD) != -1);
+    ATF_REQUIRE(::fcntl(fds[1], F_GETFD) != -1);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(join__no_jobserver);
+ATF_TEST_CASE_BODY(join__no_jobserver)
+{
+    ATF_REQUIRE(process::jobserver::join("").get() == NULL);
+    ATF_REQUIRE(process::jobserver::join("-j4").get() == NULL);
+    ATF_REQUIRE(process::jobserver::join("ks -- X=1").get() == NULL);
+    ATF_REQUIRE(process::jobserver::join(
+        "-j4 -- X=--jobserver-auth=3,4").get() == NULL);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(join__invalid);
+ATF_TEST_CASE_BODY(join__invalid)
+{
+    ATF_REQUIRE_THROW_RE(process::error, "Invalid jobserver.*'foo'",
+                         process::jobserver::join("--jobserver-auth=foo"));
+    ATF_REQUIRE_THROW_RE(process::error, "Invalid jobserver.*'3,x'",
+                         process::jobserver::join("--jobserver-auth=3,x"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(join__closed_fds);
+ATF_TEST_CASE_BODY(join__closed_fds)
+{
+    int fds[2];
+    ATF_REQUIRE(::pipe(fds) != -1);
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    ATF_REQUIRE(process::jobserver::join(
+        F("-j3 --jobserver-auth=%s,%s") % fds[0] % fds[1]).get() == NULL);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(join__fds);
+ATF_TEST_CASE_BODY(join__fds)
+{
+    do_join_fds_test("--jobserver-auth");
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(join__legacy_fds);
+ATF_TEST_CASE_BODY(join__legacy_fds)
+{
+    do_join_fds_test("--jobserver-fds");
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(create_and_join__fifo);
+ATF_TEST_CASE_BODY(create_and_join__fifo)
+{
+    const fs::path fifo = fs::current_path() / "jobserver";
+
+    std::auto_ptr< process::jobserver > server = process::jobserver::create(
+        fifo, 2);
+    ATF_REQUIRE_EQ((F("-j3 --jobserver-auth=fifo:%s") % fifo).str(),
+                   server->makeflags());
+
+    {
+        std::auto_ptr< process::jobserver > client = process::jobserver::join(
+            server->makeflags());
+        ATF_REQUIRE(client.get() != NULL);
+        ATF_REQUIRE(client->try_acquire());
+        ATF_REQUIRE(client->try_acquire());
+        ATF_REQUIRE(!client->try_acquire());
+        ATF_REQUIRE(!server->try_acquire());
+        client->release();
+        ATF_REQUIRE(server->try_acquire());
+        ATF_REQUIRE(!client->try_acquire());
+    }
+    ATF_REQUIRE(server->try_acquire());
+    ATF_REQUIRE_EQ(2, server->held());
+    ATF_REQUIRE(!server->try_acquire());
+
+    server.reset();
+    ATF_REQUIRE(!fs::exists(fifo));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(try_acquire__timeout);
+ATF_TEST_CASE_BODY(try_acquire__timeout)
+{
+    std::auto_ptr< process::jobserver > server = process::jobserver::create(
+        fs::path("jobserver"), 1);
+    ATF_REQUIRE(server->try_acquire(datetime::delta(1, 0)));
+
+    const datetime::timestamp start = datetime::timestamp::now();
+    ATF_REQUIRE(!server->try_acquire(datetime::delta(0, 200000)));
+    ATF_REQUIRE(datetime::timestamp::now() - start >=
+                datetime::delta(0, 150000));
+    ATF_REQUIRE_EQ(1, server->held());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(try_acquire__timeout_returned);
+ATF_TEST_CASE_BODY(try_acquire__timeout_returned)
+{
+    int fds[2];
+    ATF_REQUIRE(::pipe(fds) != -1);
+
+    std::auto_ptr< process::jobserver > jobserver = process::jobserver::join(
+        F("-j2 --jobserver-auth=%s,%s") % fds[0] % fds[1]);
+    ATF_REQUIRE(jobserver.get() != NULL);
+    ATF_REQUIRE(!jobserver->try_acquire());
+
+    const pid_t pid = ::fork();
+    ATF_REQUIRE(pid != -1);
+    if (pid == 0) {
+        ::usleep(100000);
+        std::exit(::write(fds[1], "a", 1) == 1 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    ATF_REQUIRE(jobserver->try_acquire(datetime::delta(10, 0)));
+    ATF_REQUIRE_EQ(1, jobserver->held());
+    int status;
+    ATF_REQUIRE_EQ(pid, ::waitpid(pid, &status, 0));
+    ATF_REQUIRE(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+
+    jobserver.reset();
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(create__no_tokens);
+ATF_TEST_CASE_BODY(create__no_tokens)
+{
+    std::auto_ptr< process::jobserver > server = process::jobserver::create(
+        fs::path("jobserver"), 0);
+    ATF_REQUIRE_EQ("-j1 --jobserver-auth=fifo:jobserver", server->makeflags());
+    ATF_REQUIRE(!server->try_acquire());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(create__fail);
+ATF_TEST_CASE_BODY(create__fail)
+{
+    ATF_REQUIRE_THROW_RE(process::system_error,
+                         "Cannot create jobserver FIFO missing/fifo",
+                         process::jobserver::create(fs::path("missing/fifo"),
+                                                    1));
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, join__no_jobserver);
+    ATF_ADD_TEST_CASE(tcs, join__invalid);
+    ATF_ADD_TEST_CASE(tcs, join__closed_fds);
+    ATF_ADD_TEST_CASE(tcs, join__fds);
+    ATF_ADD_TEST_CASE(tcs, join__legacy_fds);
+
+    ATF_ADD_TEST_CASE(tcs, create_and_join__fifo);
+    ATF_ADD_TEST_CASE(tcs, try_acquire__timeout);
+    ATF_ADD_TEST_CASE(tcs, try_acquire__timeout_returned);
+    ATF_ADD_TEST_CASE(tcs, create__no_tokens);
+    ATF_ADD_TEST_CASE(tcs, create__fail);
+}
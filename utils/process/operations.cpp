@@ -30,6 +30,8 @@
 
 extern "C" {
 #include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 
 #include <signal.h>
@@ -41,18 +43,26 @@ extern "C" {
 #include <cstring>
 #include <iostream>
 
+#include "utils/datetime.hpp"
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
 #include "utils/logging/macros.hpp"
+#include "utils/optional.ipp"
 #include "utils/process/exceptions.hpp"
 #include "utils/process/system.hpp"
 #include "utils/process/status.hpp"
 #include "utils/sanity.hpp"
 #include "utils/signals/interrupts.hpp"
+#include "utils/units.hpp"
 
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
 namespace process = utils::process;
 namespace signals = utils::signals;
+namespace units = utils::units;
+
+using utils::none;
+using utils::optional;
 
 
 /// Maximum number of arguments supported by exec.
@@ -66,23 +76,55 @@ namespace signals = utils::signals;
 namespace {
 
 
+/// Converts the maximum resident set size reported by the system to bytes.
+///
+/// \param maxrss The ru_maxrss field of a struct rusage.
+///
+/// \return The size in bytes.
+static units::bytes
+maxrss_to_bytes(const long maxrss)
+{
+#if defined(__APPLE__)
+    // Darwin reports this field in bytes instead of kilobytes.
+    return units::bytes(static_cast< uint64_t >(maxrss));
+#else
+    return units::bytes(static_cast< uint64_t >(maxrss) * units::KB);
+#endif
+}
+
+
 /// Exception-based, type-improved version of wait(2).
 ///
-/// \return The PID of the terminated process and its termination status.
+/// The resource usage of the terminated process is collected with wait4(2) and
+/// attached to the returned status.
+///
+/// \param block Whether to wait for a process to terminate if none has yet.
+///
+/// \return The PID of the terminated process and its termination status, or
+/// none if block is false and no process has terminated.
 ///
 /// \throw process::system_error If the call to wait(2) fails.
-static process::status
-safe_wait(void)
+static optional< process::status >
+safe_wait(const bool block)
 {
-    LD("Waiting for any child process");
+    LD(block ? "Waiting for any child process" :
+       "Checking for any terminated child process");
     int stat_loc;
-    const pid_t pid = ::wait(&stat_loc);
+    struct ::rusage usage;
+    const pid_t pid = ::wait4(-1, &stat_loc, block ? 0 : WNOHANG, &usage);
     if (pid == -1) {
         const int original_errno = errno;
         throw process::system_error("Failed to wait for any child process",
                                     original_errno);
+    } else if (pid == 0) {
+        INV(!block);
+        return none;
     }
-    return process::status(pid, stat_loc);
+    const datetime::delta cpu_time =
+        datetime::delta(usage.ru_utime.tv_sec, usage.ru_utime.tv_usec) +
+        datetime::delta(usage.ru_stime.tv_sec, usage.ru_stime.tv_usec);
+    return utils::make_optional(process::status(
+        pid, stat_loc, cpu_time, maxrss_to_bytes(usage.ru_maxrss)));
 }
 
 
@@ -123,9 +165,28 @@ safe_waitpid(const pid_t pid)
 /// \param args The arguments to pass to the binary, without the program name.
 void
 process::exec(const fs::path& program, const args_vector& args) throw()
+{
+    exec(program, args, args_vector());
+}
+
+
+/// Executes an external binary under a wrapper command.
+///
+/// This behaves like exec() but runs the given wrapper command instead of the
+/// requested binary, passing the path to the binary and its arguments as the
+/// trailing arguments of the wrapper.
+///
+/// \param program The binary to execute.
+/// \param args The arguments to pass to the binary, without the program name.
+/// \param wrapper The command to run, including the name of its binary as its
+///     first item, or an empty vector to disable wrapping.  The binary is
+///     searched for in the PATH if it does not contain any slashes.
+void
+process::exec(const fs::path& program, const args_vector& args,
+              const args_vector& wrapper) throw()
 {
     try {
-        exec_unsafe(program, args);
+        exec_unsafe(program, args, wrapper);
     } catch (const system_error& error) {
         // Error message already printed by exec_unsafe.
         std::abort();
@@ -153,28 +214,58 @@ process::exec(const fs::path& program, const args_vector& args) throw()
 void
 process::exec_unsafe(const fs::path& program, const args_vector& args)
 {
-    PRE(args.size() < MAX_ARGS);
+    exec_unsafe(program, args, args_vector());
+}
+
+
+/// Executes an external binary under a wrapper command.
+///
+/// This behaves like exec_unsafe() but runs the given wrapper command instead
+/// of the requested binary, passing the path to the binary and its arguments
+/// as the trailing arguments of the wrapper.  This is useful to run programs
+/// under tools like profilers or nice(1).
+///
+/// \param program The binary to execute.
+/// \param args The arguments to pass to the binary, without the program name.
+/// \param wrapper The command to run, including the name of its binary as its
+///     first item, or an empty vector to disable wrapping.  The binary is
+///     searched for in the PATH if it does not contain any slashes.
+///
+/// \throw system_error If the exec(2) call fails.
+void
+process::exec_unsafe(const fs::path& program, const args_vector& args,
+                     const args_vector& wrapper)
+{
+    PRE(wrapper.size() + args.size() < MAX_ARGS);
+    const char* const name = wrapper.empty() ?
+        program.c_str() : wrapper[0].c_str();
     int original_errno = 0;
     try {
         const char* argv[MAX_ARGS + 1];
 
-        argv[0] = program.c_str();
+        args_vector::size_type argc = 0;
+        for (args_vector::size_type i = 0; i < wrapper.size(); i++)
+            argv[argc++] = wrapper[i].c_str();
+        argv[argc++] = program.c_str();
         for (args_vector::size_type i = 0; i < args.size(); i++)
-            argv[1 + i] = args[i].c_str();
-        argv[1 + args.size()] = NULL;
+            argv[argc++] = args[i].c_str();
+        argv[argc] = NULL;
 
-        const int ret = ::execv(program.c_str(),
-                                (char* const*)(unsigned long)(const void*)argv);
+        // The wrapper is looked up in the PATH for convenience, but the
+        // program never is, to match the behavior of the unwrapped case.
+        const int ret = wrapper.empty() ?
+            ::execv(name, (char* const*)(unsigned long)(const void*)argv) :
+            ::execvp(name, (char* const*)(unsigned long)(const void*)argv);
         original_errno = errno;
         INV(ret == -1);
-        std::cerr << "Failed to execute " << program << ": "
+        std::cerr << "Failed to execute " << name << ": "
                   << std::strerror(original_errno) << "\n";
     } catch (const std::runtime_error& error) {
-        std::cerr << "Failed to execute " << program << ": "
+        std::cerr << "Failed to execute " << name << ": "
                   << error.what() << "\n";
         std::abort();
     } catch (...) {
-        std::cerr << "Failed to execute " << program << "; got unexpected "
+        std::cerr << "Failed to execute " << name << "; got unexpected "
             "exception during exec\n";
         std::abort();
     }
@@ -182,7 +273,7 @@ process::exec_unsafe(const fs::path& program, const args_vector& args)
     // We must do this here to prevent our exception from being caught by the
     // generic handlers above.
     INV(original_errno != 0);
-    throw system_error("Failed to execute " + program.str(), original_errno);
+    throw system_error(F("Failed to execute %s") % name, original_errno);
 }
 
 
@@ -264,10 +355,28 @@ process::wait(const int pid)
 process::status
 process::wait_any(void)
 {
-    const process::status status = safe_wait();
+    const process::status status = safe_wait(true).get();
     {
         signals::interrupts_inhibiter inhibiter;
         signals::remove_pid_to_kill(status.dead_pid());
     }
     return status;
 }
+
+
+/// Checks for the completion of any subprocess without blocking.
+///
+/// \return The termination status of a child process that terminated, or none
+/// if all child processes are still running.
+///
+/// \throw process::system_error If the call to wait(2) fails.
+optional< process::status >
+process::try_wait_any(void)
+{
+    const optional< process::status > status = safe_wait(false);
+    if (status) {
+        signals::interrupts_inhibiter inhibiter;
+        signals::remove_pid_to_kill(status.get().dead_pid());
+    }
+    return status;
+}
@@ -36,6 +36,7 @@
 
 #include "utils/defs.hpp"
 #include "utils/fs/path_fwd.hpp"
+#include "utils/optional_fwd.hpp"
 #include "utils/process/status_fwd.hpp"
 
 namespace utils {
@@ -43,11 +44,16 @@ namespace process {
 
 
 void exec(const utils::fs::path&, const args_vector&) throw() UTILS_NORETURN;
+void exec(const utils::fs::path&, const args_vector&,
+          const args_vector&) throw() UTILS_NORETURN;
 void exec_unsafe(const utils::fs::path&, const args_vector&) UTILS_NORETURN;
+void exec_unsafe(const utils::fs::path&, const args_vector&,
+                 const args_vector&) UTILS_NORETURN;
 void terminate_group(const int);
 void terminate_self_with(const status&) UTILS_NORETURN;
 status wait(const int);
 status wait_any(void);
+utils::optional< status > try_wait_any(void);
 
 
 }  // namespace process
@@ -37,21 +37,30 @@ extern "C" {
 }
 
 #include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include <atf-c++.hpp>
 
+#include "utils/datetime.hpp"
 #include "utils/defs.hpp"
 #include "utils/format/containers.ipp"
 #include "utils/fs/path.hpp"
+#include "utils/optional.ipp"
 #include "utils/process/child.ipp"
 #include "utils/process/exceptions.hpp"
 #include "utils/process/status.hpp"
 #include "utils/stacktrace.hpp"
 #include "utils/test_utils.ipp"
+#include "utils/units.hpp"
 
+namespace datetime = utils::datetime;
 namespace fs = utils::fs;
 namespace process = utils::process;
+namespace units = utils::units;
+
+using utils::optional;
 
 
 namespace {
@@ -106,6 +115,39 @@ public:
 };
 
 
+/// Body for a subprocess that runs exec() under a wrapper.
+class child_exec_wrapped {
+    /// Command to wrap the execution with.
+    const process::args_vector _wrapper;
+
+    /// Path to the binary to exec.
+    const fs::path _program;
+
+    /// Arguments to the binary, not including argv[0].
+    const process::args_vector _args;
+
+public:
+    /// Constructor.
+    ///
+    /// \param wrapper Command to wrap the execution with.
+    /// \param program Path to the binary to exec.
+    /// \param args Arguments to the binary, not including argv[0].
+    child_exec_wrapped(const process::args_vector& wrapper,
+                       const fs::path& program,
+                       const process::args_vector& args) :
+        _wrapper(wrapper), _program(program), _args(args)
+    {
+    }
+
+    /// Body for the subprocess.
+    void
+    operator()(void)
+    {
+        process::exec(_program, _args, _wrapper);
+    }
+};
+
+
 /// Body for a process that returns a specific exit code.
 ///
 /// \tparam ExitStatus The exit status for the subprocess.
@@ -117,6 +159,26 @@ child_exit(void)
 }
 
 
+/// Body for a process that uses a known amount of memory and CPU time.
+static void
+child_consume(void)
+{
+    const std::size_t size = 32 * 1024 * 1024;
+    char* buffer = static_cast< char* >(std::malloc(size));
+    if (buffer == NULL)
+        std::exit(EXIT_FAILURE);
+    std::memset(buffer, 1, size);
+
+    const datetime::timestamp start = datetime::timestamp::now();
+    volatile unsigned long counter = 0;
+    while (datetime::timestamp::now() - start < datetime::delta(0, 200000))
+        counter += buffer[counter % size];
+
+    std::free(buffer);
+    std::exit(EXIT_SUCCESS);
+}
+
+
 static void suspend(void) UTILS_NORETURN;
 
 
@@ -226,6 +288,47 @@ ATF_TEST_CASE_BODY(exec__fail)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(exec__wrapper);
+ATF_TEST_CASE_BODY(exec__wrapper)
+{
+    process::args_vector wrapper;
+    wrapper.push_back("sh");
+    wrapper.push_back("-c");
+    wrapper.push_back("echo \"wrapped $#\"; exec \"${0}\" \"${@}\"");
+
+    process::args_vector args;
+    args.push_back("print-args");
+    args.push_back("foo");
+
+    std::auto_ptr< process::child > child = process::child::fork_files(
+        child_exec_wrapped(wrapper, get_helpers(this), args),
+        fs::path("stdout"), fs::path("stderr"));
+    const process::status status = child->wait();
+    ATF_REQUIRE(status.exited());
+    ATF_REQUIRE_EQ(EXIT_SUCCESS, status.exitstatus());
+    ATF_REQUIRE(atf::utils::grep_file("^wrapped 2$", "stdout"));
+    ATF_REQUIRE(atf::utils::grep_file("argv\\[1\\] = print-args", "stdout"));
+    ATF_REQUIRE(atf::utils::grep_file("argv\\[2\\] = foo", "stdout"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(exec__wrapper_fail);
+ATF_TEST_CASE_BODY(exec__wrapper_fail)
+{
+    utils::avoid_coredump_on_crash();
+
+    std::auto_ptr< process::child > child = process::child::fork_files(
+        child_exec_wrapped(process::args_vector(1, "non-existent-wrapper"),
+                           get_helpers(this), process::args_vector()),
+        fs::path("stdout"), fs::path("stderr"));
+    const process::status status = child->wait();
+    ATF_REQUIRE(status.signaled());
+    ATF_REQUIRE_EQ(SIGABRT, status.termsig());
+    ATF_REQUIRE(atf::utils::grep_file(
+        "Failed to execute non-existent-wrapper", "stderr"));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(exec_unsafe__no_args);
 ATF_TEST_CASE_BODY(exec_unsafe__no_args)
 {
@@ -432,6 +535,21 @@ ATF_TEST_CASE_BODY(wait_any__many)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(wait_any__resource_usage);
+ATF_TEST_CASE_BODY(wait_any__resource_usage)
+{
+    process::child::fork_capture(child_consume);
+
+    const process::status status = process::wait_any();
+    ATF_REQUIRE(status.exited());
+    ATF_REQUIRE_EQ(EXIT_SUCCESS, status.exitstatus());
+    ATF_REQUIRE(status.cpu_time());
+    ATF_REQUIRE(status.cpu_time().get() >= datetime::delta(0, 100000));
+    ATF_REQUIRE(status.max_rss());
+    ATF_REQUIRE(status.max_rss().get() >= units::bytes(32 * units::MB));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(wait_any__none_is_failure);
 ATF_TEST_CASE_BODY(wait_any__none_is_failure)
 {
@@ -445,11 +563,59 @@ ATF_TEST_CASE_BODY(wait_any__none_is_failure)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(try_wait_any__running);
+ATF_TEST_CASE_BODY(try_wait_any__running)
+{
+    std::auto_ptr< process::child > child = process::child::fork_capture(
+        suspend);
+    const pid_t pid = child->pid();
+
+    ATF_REQUIRE(!process::try_wait_any());
+
+    ATF_REQUIRE(::kill(pid, SIGKILL) != -1);
+    const process::status status = process::wait(pid);
+    ATF_REQUIRE(status.signaled());
+    ATF_REQUIRE_EQ(SIGKILL, status.termsig());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(try_wait_any__terminated);
+ATF_TEST_CASE_BODY(try_wait_any__terminated)
+{
+    std::auto_ptr< process::child > child = process::child::fork_capture(
+        child_exit< 15 >);
+    const pid_t pid = child->pid();
+    child.reset();  // Ensure there is no conflict between destructor and wait.
+
+    optional< process::status > status;
+    while (!(status = process::try_wait_any()))
+        ::usleep(10000);
+    ATF_REQUIRE_EQ(pid, status.get().dead_pid());
+    ATF_REQUIRE(status.get().exited());
+    ATF_REQUIRE_EQ(15, status.get().exitstatus());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(try_wait_any__none_is_failure);
+ATF_TEST_CASE_BODY(try_wait_any__none_is_failure)
+{
+    try {
+        (void)process::try_wait_any();
+        fail("Expected exception but none raised");
+    } catch (const process::system_error& e) {
+        ATF_REQUIRE(atf::utils::grep_string("Failed to wait", e.what()));
+        ATF_REQUIRE_EQ(ECHILD, e.original_errno());
+    }
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, exec__no_args);
     ATF_ADD_TEST_CASE(tcs, exec__some_args);
     ATF_ADD_TEST_CASE(tcs, exec__fail);
+    ATF_ADD_TEST_CASE(tcs, exec__wrapper);
+    ATF_ADD_TEST_CASE(tcs, exec__wrapper_fail);
 
     ATF_ADD_TEST_CASE(tcs, exec_unsafe__no_args);
     ATF_ADD_TEST_CASE(tcs, exec_unsafe__some_args);
@@ -467,5 +633,10 @@ ATF_INIT_TEST_CASES(tcs)
 
     ATF_ADD_TEST_CASE(tcs, wait_any__one);
     ATF_ADD_TEST_CASE(tcs, wait_any__many);
+    ATF_ADD_TEST_CASE(tcs, wait_any__resource_usage);
     ATF_ADD_TEST_CASE(tcs, wait_any__none_is_failure);
+
+    ATF_ADD_TEST_CASE(tcs, try_wait_any__running);
+    ATF_ADD_TEST_CASE(tcs, try_wait_any__terminated);
+    ATF_ADD_TEST_CASE(tcs, try_wait_any__none_is_failure);
 }
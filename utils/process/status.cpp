@@ -36,7 +36,9 @@ extern "C" {
 #include "utils/optional.ipp"
 #include "utils/sanity.hpp"
 
+namespace datetime = utils::datetime;
 namespace process = utils::process;
+namespace units = utils::units;
 
 using utils::none;
 using utils::optional;
@@ -62,6 +64,30 @@ process::status::status(const int dead_pid_, int stat_loc) :
 }
 
 
+/// Constructs a new status object based on the results of wait4(2).
+///
+/// \param dead_pid_ The PID of the process this status belonged to.
+/// \param stat_loc The status value returnd by wait4(2).
+/// \param cpu_time_ The user and system CPU time consumed by the process and
+///     its awaited children.
+/// \param max_rss_ The peak resident memory of the process or of its largest
+///     awaited child.
+process::status::status(const int dead_pid_, int stat_loc,
+                        const datetime::delta& cpu_time_,
+                        const units::bytes& max_rss_) :
+    _dead_pid(dead_pid_),
+    _exited(WIFEXITED(stat_loc) ?
+            optional< int >(WEXITSTATUS(stat_loc)) : none),
+    _signaled(WIFSIGNALED(stat_loc) ?
+              optional< std::pair< int, bool > >(
+                  std::make_pair(WTERMSIG(stat_loc), WCOREDUMP(stat_loc))) :
+                  none),
+    _cpu_time(cpu_time_),
+    _max_rss(max_rss_)
+{
+}
+
+
 /// Constructs a new status object based on fake values.
 ///
 /// \param exited_ If not none, specifies the exit status of the program.
@@ -180,6 +206,28 @@ process::status::coredump(void) const
 }
 
 
+/// Returns the CPU time consumed by the process.
+///
+/// \return The user and system CPU time, or none if the status was not
+/// obtained along with the resource usage of the process.
+const optional< datetime::delta >&
+process::status::cpu_time(void) const
+{
+    return _cpu_time;
+}
+
+
+/// Returns the peak resident memory used by the process.
+///
+/// \return The maximum resident set size, or none if the status was not
+/// obtained along with the resource usage of the process.
+const optional< units::bytes >&
+process::status::max_rss(void) const
+{
+    return _max_rss;
+}
+
+
 /// Injects the object into a stream.
 ///
 /// \param output The stream into which to inject the object.
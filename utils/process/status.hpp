@@ -37,7 +37,9 @@
 #include <ostream>
 #include <utility>
 
+#include "utils/datetime.hpp"
 #include "utils/optional.ipp"
+#include "utils/units.hpp"
 
 namespace utils {
 namespace process {
@@ -57,10 +59,17 @@ class status {
     /// The signal that terminated the program, if any, and if it dumped core.
     optional< std::pair< int, bool > > _signaled;
 
+    /// The CPU time consumed by the process and its awaited children, if known.
+    optional< datetime::delta > _cpu_time;
+
+    /// The peak resident memory of the process or its children, if known.
+    optional< units::bytes > _max_rss;
+
     status(const optional< int >&, const optional< std::pair< int, bool > >&);
 
 public:
     status(const int, int);
+    status(const int, int, const datetime::delta&, const units::bytes&);
     static status fake_exited(const int);
     static status fake_signaled(const int, const bool);
 
@@ -72,6 +81,9 @@ public:
     bool signaled(void) const;
     int termsig(void) const;
     bool coredump(void) const;
+
+    const optional< datetime::delta >& cpu_time(void) const;
+    const optional< units::bytes >& max_rss(void) const;
 };
 
 
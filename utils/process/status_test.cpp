@@ -39,7 +39,12 @@ extern "C" {
 
 #include <atf-c++.hpp>
 
+#include "utils/datetime.hpp"
 #include "utils/test_utils.ipp"
+#include "utils/units.hpp"
+
+namespace datetime = utils::datetime;
+namespace units = utils::units;
 
 using utils::process::status;
 
@@ -116,6 +121,27 @@ ATF_TEST_CASE_BODY(fake_signaled)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(resource_usage__none);
+ATF_TEST_CASE_BODY(resource_usage__none)
+{
+    ATF_REQUIRE(!status::fake_exited(0).cpu_time());
+    ATF_REQUIRE(!status::fake_exited(0).max_rss());
+    ATF_REQUIRE(!status(1, 0).cpu_time());
+    ATF_REQUIRE(!status(1, 0).max_rss());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(resource_usage__some);
+ATF_TEST_CASE_BODY(resource_usage__some)
+{
+    const status with_usage(1, 0, datetime::delta(3, 500),
+                            units::bytes(10 * units::MB));
+    ATF_REQUIRE(with_usage.exited());
+    ATF_REQUIRE_EQ(datetime::delta(3, 500), with_usage.cpu_time().get());
+    ATF_REQUIRE_EQ(units::bytes(10 * units::MB), with_usage.max_rss().get());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(output__exitstatus);
 ATF_TEST_CASE_BODY(output__exitstatus)
 {
@@ -198,6 +224,8 @@ ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, fake_exited);
     ATF_ADD_TEST_CASE(tcs, fake_signaled);
+    ATF_ADD_TEST_CASE(tcs, resource_usage__none);
+    ATF_ADD_TEST_CASE(tcs, resource_usage__some);
 
     ATF_ADD_TEST_CASE(tcs, output__exitstatus);
     ATF_ADD_TEST_CASE(tcs, output__signaled_without_core);
@@ -0,0 +1,237 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "utils/process/usage.hpp"
+
+extern "C" {
+#include <stdint.h>
+#include <unistd.h>
+}
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "utils/fs/directory.hpp"
+#include "utils/fs/exceptions.hpp"
+#include "utils/fs/operations.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/fs/path.hpp"
+#include "utils/logging/macros.hpp"
+
+namespace datetime = utils::datetime;
+namespace fs = utils::fs;
+namespace process = utils::process;
+namespace units = utils::units;
+
+using utils::none;
+using utils::optional;
+
+
+namespace {
+
+
+/// Location of the process file system.
+static const fs::path proc_dir("/proc");
+
+
+/// Details of a single process as extracted from /proc/<pid>/stat.
+struct proc_stat {
+    /// Identifier of the process group the process belongs to.
+    int pgrp;
+
+    /// User and system CPU time consumed by the process, in clock ticks.
+    unsigned long ticks;
+
+    /// Resident set size of the process, in pages.
+    long rss_pages;
+};
+
+
+/// Parses the contents of a /proc/<pid>/stat file.
+///
+/// \param file Path to the file to parse.
+///
+/// \return The parsed details, or none if the file cannot be read (which
+/// happens if the process terminated in the meantime) or is invalid.
+static optional< proc_stat >
+read_proc_stat(const fs::path& file)
+{
+    std::ifstream input(file.c_str());
+    if (!input)
+        return none;
+    std::string line;
+    if (!std::getline(input, line))
+        return none;
+
+    // The second field holds the name of the command in parenthesis, which may
+    // contain arbitrary characters including spaces and parenthesis.  Skip
+    // over it by looking for the last closing parenthesis.
+    const std::string::size_type end_comm = line.rfind(')');
+    if (end_comm == std::string::npos)
+        return none;
+    std::istringstream fields(line.substr(end_comm + 1));
+
+    // Field numbers as documented in proc(5); the first two fields were
+    // consumed above.
+    std::string state;
+    long ppid, pgrp;
+    fields >> state >> ppid >> pgrp;
+    std::string ignored;
+    for (int i = 6; i <= 13; ++i)
+        fields >> ignored;
+    unsigned long utime, stime;
+    fields >> utime >> stime;
+    for (int i = 16; i <= 23; ++i)
+        fields >> ignored;
+    long rss;
+    fields >> rss;
+    if (fields.fail())
+        return none;
+
+    proc_stat stat;
+    stat.pgrp = static_cast< int >(pgrp);
+    stat.ticks = utime + stime;
+    stat.rss_pages = rss;
+    return utils::make_optional(stat);
+}
+
+
+/// Parses the contents of a /proc/<pid>/io file.
+///
+/// \param file Path to the file to parse.
+///
+/// \return The bytes read from and written to storage, or none if the file
+/// cannot be read, which is often the case for processes owned by other users.
+static optional< std::pair< uint64_t, uint64_t > >
+read_proc_io(const fs::path& file)
+{
+    std::ifstream input(file.c_str());
+    if (!input)
+        return none;
+
+    optional< uint64_t > read_bytes, write_bytes;
+    std::string name;
+    uint64_t value;
+    while (input >> name >> value) {
+        if (name == "read_bytes:")
+            read_bytes = value;
+        else if (name == "write_bytes:")
+            write_bytes = value;
+    }
+    if (!read_bytes || !write_bytes)
+        return none;
+    return utils::make_optional(std::make_pair(read_bytes.get(),
+                                               write_bytes.get()));
+}
+
+
+}  // anonymous namespace
+
+
+/// Constructor for an empty usage record.
+process::group_usage::group_usage(void) :
+    processes(0),
+    read_bytes(units::bytes()),
+    write_bytes(units::bytes())
+{
+}
+
+
+/// Checks whether resource usage can be sampled on this system.
+///
+/// \return True if the /proc file system is available.
+bool
+process::usage_supported(void)
+{
+    return fs::exists(proc_dir / "self" / "stat");
+}
+
+
+/// Samples the resources consumed by a set of process groups.
+///
+/// This walks the process table once regardless of the number of groups
+/// requested, so it is cheap enough to be called periodically.
+///
+/// \param pgids The identifiers of the process groups to sample.
+///
+/// \return The usage of every process group with at least one live process.
+/// Groups without live processes are not included.  The result is empty if
+/// usage_supported() is false.
+process::group_usage_map
+process::sample_groups_usage(const std::set< int >& pgids)
+{
+    group_usage_map usages;
+    if (pgids.empty())
+        return usages;
+
+    const long ticks_per_second = ::sysconf(_SC_CLK_TCK);
+    const long page_size = ::sysconf(_SC_PAGESIZE);
+
+    try {
+        const fs::directory dir(proc_dir);
+        for (fs::directory::const_iterator iter = dir.begin();
+             iter != dir.end(); ++iter) {
+            const std::string& name = iter->name;
+            if (name.empty() ||
+                name.find_first_not_of("0123456789") != std::string::npos)
+                continue;
+
+            const optional< proc_stat > stat = read_proc_stat(
+                proc_dir / name / "stat");
+            if (!stat || pgids.find(stat.get().pgrp) == pgids.end())
+                continue;
+
+            group_usage& usage = usages[stat.get().pgrp];
+            ++usage.processes;
+            usage.cpu_time += datetime::delta::from_microseconds(
+                static_cast< int64_t >(stat.get().ticks) * 1000000 /
+                ticks_per_second);
+            usage.rss = units::bytes(
+                usage.rss + static_cast< uint64_t >(stat.get().rss_pages) *
+                page_size);
+
+            const optional< std::pair< uint64_t, uint64_t > > io =
+                read_proc_io(proc_dir / name / "io");
+            if (io && usage.read_bytes && usage.write_bytes) {
+                usage.read_bytes = units::bytes(usage.read_bytes.get() +
+                                                io.get().first);
+                usage.write_bytes = units::bytes(usage.write_bytes.get() +
+                                                 io.get().second);
+            } else {
+                usage.read_bytes = none;
+                usage.write_bytes = none;
+            }
+        }
+    } catch (const fs::error& e) {
+        LD(F("Cannot sample process usage: %s") % e.what());
+        usages.clear();
+    }
+    return usages;
+}
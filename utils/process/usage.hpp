@@ -0,0 +1,85 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file utils/process/usage.hpp
+/// Sampling of the resources consumed by running process groups.
+///
+/// The information is obtained from the /proc file system, so these functions
+/// are only functional on systems that provide a Linux-compatible one.
+
+#if !defined(UTILS_PROCESS_USAGE_HPP)
+#define UTILS_PROCESS_USAGE_HPP
+
+#include <cstddef>
+#include <map>
+#include <set>
+
+#include "utils/datetime.hpp"
+#include "utils/optional.ipp"
+#include "utils/units.hpp"
+
+namespace utils {
+namespace process {
+
+
+/// Resources consumed by the live processes of a process group.
+///
+/// Note that the resources consumed by processes that have already exited are
+/// not accounted for.
+struct group_usage {
+    /// Number of live processes in the group.
+    std::size_t processes;
+
+    /// User and system CPU time consumed by the processes.
+    datetime::delta cpu_time;
+
+    /// Resident memory used by the processes.
+    units::bytes rss;
+
+    /// Bytes read from storage by the processes, if known.
+    optional< units::bytes > read_bytes;
+
+    /// Bytes written to storage by the processes, if known.
+    optional< units::bytes > write_bytes;
+
+    group_usage(void);
+};
+
+
+/// Mapping of process group identifiers to their resource usage.
+typedef std::map< int, group_usage > group_usage_map;
+
+
+bool usage_supported(void);
+group_usage_map sample_groups_usage(const std::set< int >&);
+
+
+}  // namespace process
+}  // namespace utils
+
+#endif  // !defined(UTILS_PROCESS_USAGE_HPP)
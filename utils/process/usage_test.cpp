@@ -0,0 +1,149 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "utils/process/usage.hpp"
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <signal.h>
+#include <unistd.h>
+}
+
+#include <cstdlib>
+
+#include <atf-c++.hpp>
+
+#include "utils/datetime.hpp"
+
+namespace datetime = utils::datetime;
+namespace process = utils::process;
+
+
+namespace {
+
+
+/// Skips the calling test case if usage sampling is not supported.
+static void
+require_usage_supported(void)
+{
+    if (!process::usage_supported())
+        ATF_SKIP("Sampling process usage is not supported on this system");
+}
+
+
+/// Spawns a subprocess in its own process group that burns some CPU time.
+///
+/// \return The PID of the subprocess, which is also its process group.
+static pid_t
+spawn_busy_group(void)
+{
+    int fds[2];
+    ATF_REQUIRE(::pipe(fds) != -1);
+
+    const pid_t pid = ::fork();
+    ATF_REQUIRE(pid != -1);
+    if (pid == 0) {
+        ::close(fds[0]);
+        ::setpgid(0, 0);
+        const datetime::timestamp start = datetime::timestamp::now();
+        while (datetime::timestamp::now() - start < datetime::delta(0, 200000))
+            continue;
+        if (::write(fds[1], "x", 1) != 1)
+            std::abort();
+        for (;;)
+            ::pause();
+    }
+    ::close(fds[1]);
+    char buffer;
+    ATF_REQUIRE_EQ(1, ::read(fds[0], &buffer, 1));
+    ::close(fds[0]);
+    return pid;
+}
+
+
+}  // anonymous namespace
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(sample_groups_usage__none);
+ATF_TEST_CASE_BODY(sample_groups_usage__none)
+{
+    ATF_REQUIRE(process::sample_groups_usage(std::set< int >()).empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(sample_groups_usage__unknown);
+ATF_TEST_CASE_BODY(sample_groups_usage__unknown)
+{
+    require_usage_supported();
+
+    std::set< int > pgids;
+    pgids.insert(-1);
+    ATF_REQUIRE(process::sample_groups_usage(pgids).empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(sample_groups_usage__some);
+ATF_TEST_CASE_BODY(sample_groups_usage__some)
+{
+    require_usage_supported();
+
+    const pid_t pid = spawn_busy_group();
+
+    std::set< int > pgids;
+    pgids.insert(pid);
+    pgids.insert(::getpgrp());
+    const process::group_usage_map usages = process::sample_groups_usage(
+        pgids);
+
+    ::kill(pid, SIGKILL);
+    int status;
+    (void)::waitpid(pid, &status, 0);
+
+    ATF_REQUIRE_EQ(2, usages.size());
+
+    const process::group_usage& child = usages.find(pid)->second;
+    ATF_REQUIRE_EQ(1, child.processes);
+    ATF_REQUIRE(child.cpu_time >= datetime::delta(0, 100000));
+    ATF_REQUIRE(child.rss > 0);
+    ATF_REQUIRE(child.read_bytes);
+    ATF_REQUIRE(child.write_bytes);
+
+    const process::group_usage& self = usages.find(::getpgrp())->second;
+    ATF_REQUIRE(self.processes >= 1);
+    ATF_REQUIRE(self.rss > 0);
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, sample_groups_usage__none);
+    ATF_ADD_TEST_CASE(tcs, sample_groups_usage__unknown);
+    ATF_ADD_TEST_CASE(tcs, sample_groups_usage__some);
+}
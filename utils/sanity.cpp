@@ -44,6 +44,9 @@ extern "C" {
 
 #include "utils/format/macros.hpp"
 #include "utils/logging/macros.hpp"
+#include "utils/logging/operations.hpp"
+
+namespace logging = utils::logging;
 
 
 namespace {
@@ -87,6 +90,10 @@ crash_handler(const int signo)
 {
     PRE(!logfile.empty());
 
+    // The log file may not have been created yet if its creation was deferred
+    // until needed.  It is needed now.
+    logging::flush_pending();
+
     err_write(F("*** Fatal signal %s received\n") % signo);
     err_write(F("*** Log file is %s\n") % logfile);
     err_write(F("*** Please report this problem to %s detailing what you were "
@@ -40,11 +40,14 @@ extern "C" {
 
 #include "utils/format/macros.hpp"
 #include "utils/fs/path.hpp"
+#include "utils/logging/macros.hpp"
+#include "utils/logging/operations.hpp"
 #include "utils/process/child.ipp"
 #include "utils/process/status.hpp"
 #include "utils/test_utils.ipp"
 
 namespace fs = utils::fs;
+namespace logging = utils::logging;
 namespace process = utils::process;
 
 
@@ -302,6 +305,28 @@ ATF_TEST_CASE_BODY(install_crash_handlers__sigsegv)
 }
 
 
+static void
+do_crash_handler_pending_log_test(void)
+{
+    logging::set_inmemory();
+    logging::set_persistency_on_demand("info", fs::path("test-log.txt"));
+    LI("Message before the crash");
+    utils::install_crash_handlers("test-log.txt");
+    ::kill(::getpid(), SIGSEGV);
+    std::exit(EXIT_FAILURE);
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(install_crash_handlers__pending_log);
+ATF_TEST_CASE_BODY(install_crash_handlers__pending_log)
+{
+    const process::status status = run_test(do_crash_handler_pending_log_test);
+    ATF_REQUIRE(status.signaled());
+    ATF_REQUIRE(atf::utils::grep_file("Message before the crash",
+                                      "test-log.txt"));
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, inv__holds);
@@ -319,4 +344,5 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, install_crash_handlers__sigabrt);
     ATF_ADD_TEST_CASE(tcs, install_crash_handlers__sigbus);
     ATF_ADD_TEST_CASE(tcs, install_crash_handlers__sigsegv);
+    ATF_ADD_TEST_CASE(tcs, install_crash_handlers__pending_log);
 }
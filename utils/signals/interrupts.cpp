@@ -35,10 +35,11 @@ extern "C" {
 #include <unistd.h>
 }
 
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
-#include <set>
 
+#include "utils/format/macros.hpp"
 #include "utils/logging/macros.hpp"
 #include "utils/process/operations.hpp"
 #include "utils/sanity.hpp"
@@ -53,15 +54,21 @@ namespace {
 
 
 /// The interrupt signal that fired, or -1 if none.
-static volatile int fired_signal = -1;
+static std::atomic< int > fired_signal(-1);
 
 
-/// Collection of PIDs.
-typedef std::set< pid_t > pids_set;
+/// Maximum number of processes that can be registered to be killed at once.
+static const std::size_t max_pids_to_kill = 4096;
 
 
 /// List of processes to kill upon reception of a signal.
-static pids_set pids_to_kill;
+///
+/// This is a fixed-size table of slots, in which a value of zero denotes an
+/// unused slot, instead of a dynamic collection because the signal handler
+/// must be able to scan it while other threads register and unregister
+/// processes: lock-free atomic operations are the only synchronization
+/// primitives that are safe to use from within a signal handler.
+static std::atomic< pid_t > pids_to_kill[max_pids_to_kill];
 
 
 /// Programmer status for the SIGHUP signal.
@@ -73,15 +80,17 @@ static std::auto_ptr< signals::programmer > sigterm_handler;
 
 
 /// Signal mask to restore after exiting a signal inhibited section.
-static sigset_t global_old_sigmask;
+///
+/// Signal masks are per-thread, and so is this.
+static thread_local sigset_t global_old_sigmask;
 
 
 /// Whether there is an interrupts_handler object in existence or not.
-static bool interrupts_handler_active = false;
+static std::atomic< bool > interrupts_handler_active(false);
 
 
-/// Whether there is an interrupts_inhibiter object in existence or not.
-static std::size_t interrupts_inhibiter_active = 0;
+/// Whether there is an interrupts_inhibiter object in the current thread.
+static thread_local std::size_t interrupts_inhibiter_active = 0;
 
 
 /// Generic handler to capture interrupt signals.
@@ -107,13 +116,30 @@ signal_handler(const int signo)
 
     fired_signal = signo;
 
-    for (pids_set::const_iterator iter = pids_to_kill.begin();
-        iter != pids_to_kill.end(); ++iter) {
-        process::terminate_group(*iter);
+    for (std::size_t i = 0; i < max_pids_to_kill; ++i) {
+        const pid_t pid = pids_to_kill[i].load();
+        if (pid != 0)
+            process::terminate_group(pid);
     }
 }
 
 
+/// Looks for the slot in pids_to_kill that holds a given value.
+///
+/// \param pid The value to look for; zero to look for an unused slot.
+///
+/// \return The index of the slot, or max_pids_to_kill if not found.
+static std::size_t
+find_pid_slot(const pid_t pid)
+{
+    for (std::size_t i = 0; i < max_pids_to_kill; ++i) {
+        if (pids_to_kill[i].load() == pid)
+            return i;
+    }
+    return max_pids_to_kill;
+}
+
+
 /// Installs signal handlers for potential interrupts.
 ///
 /// \pre Must not have been called before.
@@ -155,7 +181,7 @@ cleanup_handlers(void)
 /// Masks the signals installed by setup_handlers().
 ///
 /// \param[out] old_sigmask The old signal mask to save via the
-///     \code oset \endcode argument with sigprocmask(2).
+///     \code oset \endcode argument with pthread_sigmask(3).
 static void
 mask_signals(sigset_t* old_sigmask)
 {
@@ -165,20 +191,20 @@ mask_signals(sigset_t* old_sigmask)
     sigaddset(&mask, SIGHUP);
     sigaddset(&mask, SIGINT);
     sigaddset(&mask, SIGTERM);
-    const int ret = ::sigprocmask(SIG_BLOCK, &mask, old_sigmask);
-    INV(ret != -1);
+    const int ret = ::pthread_sigmask(SIG_BLOCK, &mask, old_sigmask);
+    INV(ret == 0);
 }
 
 
 /// Resets the signal masking put in place by mask_signals().
 ///
 /// \param[in] old_sigmask The old signal mask to restore via the
-///     \code set \endcode argument with sigprocmask(2).
+///     \code set \endcode argument with pthread_sigmask(3).
 static void
 unmask_signals(sigset_t* old_sigmask)
 {
-    const int ret = ::sigprocmask(SIG_SETMASK, old_sigmask, NULL);
-    INV(ret != -1);
+    const int ret = ::pthread_sigmask(SIG_SETMASK, old_sigmask, NULL);
+    INV(ret == 0);
 }
 
 
@@ -189,7 +215,7 @@ unmask_signals(sigset_t* old_sigmask)
 signals::interrupts_handler::interrupts_handler(void) :
     _programmed(false)
 {
-    PRE(!interrupts_handler_active);
+    PRE(!interrupts_handler_active.load());
     setup_handlers();
     _programmed = true;
     interrupts_handler_active = true;
@@ -233,6 +259,10 @@ signals::interrupts_handler::unprogram(void)
 
 
 /// Constructor that sets up signal masking.
+///
+/// The masking only affects the calling thread.  Signals delivered to the
+/// process while the mask is in place are handled by any other thread that does
+/// not have them masked, or are left pending otherwise.
 signals::interrupts_inhibiter::interrupts_inhibiter(void)
 {
     sigset_t old_sigmask;
@@ -250,7 +280,7 @@ signals::interrupts_inhibiter::~interrupts_inhibiter(void)
     if (interrupts_inhibiter_active > 1) {
         --interrupts_inhibiter_active;
     } else {
-        interrupts_inhibiter_active = false;
+        interrupts_inhibiter_active = 0;
         unmask_signals(&global_old_sigmask);
     }
 }
@@ -269,11 +299,9 @@ signals::interrupts_inhibiter::~interrupts_inhibiter(void)
 void
 signals::check_interrupt(void)
 {
-    if (fired_signal != -1) {
-        const int original_fired_signal = fired_signal;
-        fired_signal = -1;
+    const int original_fired_signal = fired_signal.exchange(-1);
+    if (original_fired_signal != -1)
         throw interrupted_error(original_fired_signal);
-    }
 }
 
 
@@ -283,12 +311,21 @@ signals::check_interrupt(void)
 /// that the call call to fork() and the addition of the PID happen atomically.
 ///
 /// \param pid The PID of the child process.  Must not have been yet regsitered.
+///
+/// \throw error If there are too many processes registered already.
 void
 signals::add_pid_to_kill(const pid_t pid)
 {
     PRE(interrupts_inhibiter_active);
-    PRE(pids_to_kill.find(pid) == pids_to_kill.end());
-    pids_to_kill.insert(pid);
+    PRE(pid > 0);
+    PRE(find_pid_slot(pid) == max_pids_to_kill);
+    for (std::size_t i = 0; i < max_pids_to_kill; ++i) {
+        pid_t expected = 0;
+        if (pids_to_kill[i].compare_exchange_strong(expected, pid))
+            return;
+    }
+    throw error(F("Cannot track more than %s child processes") %
+                max_pids_to_kill);
 }
 
 
@@ -304,6 +341,7 @@ void
 signals::remove_pid_to_kill(const pid_t pid)
 {
     PRE(interrupts_inhibiter_active);
-    PRE(pids_to_kill.find(pid) != pids_to_kill.end());
-    pids_to_kill.erase(pid);
+    const std::size_t slot = find_pid_slot(pid);
+    PRE(slot != max_pids_to_kill);
+    pids_to_kill[slot] = 0;
 }
@@ -35,6 +35,7 @@ extern "C" {
 
 #include <cstdlib>
 #include <iostream>
+#include <thread>
 
 #include <atf-c++.hpp>
 
@@ -224,6 +225,42 @@ ATF_TEST_CASE_BODY(interrupts_handler__kill_children)
 }
 
 
+ATF_TEST_CASE(interrupts_handler__kill_children_of_threads);
+ATF_TEST_CASE_HEAD(interrupts_handler__kill_children_of_threads)
+{
+    set_md_var("timeout", "10");
+}
+ATF_TEST_CASE_BODY(interrupts_handler__kill_children_of_threads)
+{
+    std::auto_ptr< process::child > child1;
+    std::auto_ptr< process::child > child2;
+
+    signals::interrupts_handler interrupts;
+
+    std::thread thread1([&child1] {
+        child1 = process::child::fork_files(
+            pause_child, fs::path("/dev/stdout"), fs::path("/dev/stderr"));
+    });
+    std::thread thread2([&child2] {
+        child2 = process::child::fork_files(
+            pause_child, fs::path("/dev/stdout"), fs::path("/dev/stderr"));
+    });
+    thread1.join();
+    thread2.join();
+
+    // The children were registered from different threads, but the signal
+    // handler has to see both of them.
+    ::kill(::getpid(), SIGHUP);
+
+    const process::status status1 = child1->wait();
+    ATF_REQUIRE(status1.signaled());
+    ATF_REQUIRE_EQ(SIGKILL, status1.termsig());
+    const process::status status2 = child2->wait();
+    ATF_REQUIRE(status2.signaled());
+    ATF_REQUIRE_EQ(SIGKILL, status2.termsig());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(interrupts_inhibiter__sigalrm);
 ATF_TEST_CASE_BODY(interrupts_inhibiter__sigalrm)
 {
@@ -258,6 +295,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, interrupts_handler__sigint);
     ATF_ADD_TEST_CASE(tcs, interrupts_handler__sigterm);
     ATF_ADD_TEST_CASE(tcs, interrupts_handler__kill_children);
+    ATF_ADD_TEST_CASE(tcs, interrupts_handler__kill_children_of_threads);
 
     ATF_ADD_TEST_CASE(tcs, interrupts_inhibiter__sigalrm);
     ATF_ADD_TEST_CASE(tcs, interrupts_inhibiter__sighup);
@@ -34,8 +34,10 @@ extern "C" {
 #include <signal.h>
 }
 
+#include <atomic>
 #include <cerrno>
 #include <map>
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -184,10 +186,17 @@ class global_state : utils::noncopyable {
 
     /// Adjusts the global system timer to point to the next activation.
     ///
+    /// This does not log because it runs from the SIGALRM handler: the logging
+    /// module takes locks and is not async-signal-safe.  Callers that do not
+    /// run in a signal handler context can log the returned activation.
+    ///
     /// \param now The current timestamp.
     ///
+    /// \return The new activation of the system timer, or none if the system
+    /// timer was left untouched.
+    ///
     /// \throw system_error If the programming fails.
-    void
+    optional< datetime::timestamp >
     reprogram_system_timer(
         const datetime::timestamp& now,
         const signals::interrupts_inhibiter& /* inhibiter */)
@@ -196,7 +205,7 @@ class global_state : utils::noncopyable {
             // Nothing to do.  We can reach this case if all the existing timers
             // are in the past and they all fired.  Just ignore the request and
             // leave the global timer as is.
-            return;
+            return none;
         }
 
         // While fire() prunes old entries from the list of timers, it is
@@ -213,7 +222,7 @@ class global_state : utils::noncopyable {
             if (iter == _all_timers.end()) {
                 // Nothing to do.  We can reach this case if all the existing
                 // timers are in the past but they have not yet fired.
-                return;
+                return none;
             }
             PRE(!(*iter).second.empty());
             next = (*iter).first;
@@ -222,10 +231,31 @@ class global_state : utils::noncopyable {
         if (next < _timer_activation || now > _timer_activation) {
             INV(next >= now);
             const datetime::delta delta = next - now;
-            LD(F("Reprogramming timer; firing on %s; now is %s") % next % now);
             safe_setitimer(delta, NULL);
             _timer_activation = next;
+            return utils::make_optional(next);
         }
+        return none;
+    }
+
+    /// Adjusts the global system timer and logs the change, if any.
+    ///
+    /// This must not be called from a signal handler context.
+    ///
+    /// \param now The current timestamp.
+    /// \param inhibiter Proof that signals are inhibited.
+    ///
+    /// \throw system_error If the programming fails.
+    void
+    reprogram_system_timer_and_log(
+        const datetime::timestamp& now,
+        const signals::interrupts_inhibiter& inhibiter)
+    {
+        const optional< datetime::timestamp > next = reprogram_system_timer(
+            now, inhibiter);
+        if (next)
+            LD(F("Reprogrammed timer; firing on %s; now is %s") % next.get() %
+               now);
     }
 
 public:
@@ -295,7 +325,7 @@ public:
         signals::interrupts_inhibiter inhibiter;
 
         add_to_all_timers(timer);
-        reprogram_system_timer(now, inhibiter);
+        reprogram_system_timer_and_log(now, inhibiter);
     }
 
     /// Unprograms a timer.
@@ -318,7 +348,8 @@ public:
         if (_all_timers.empty()) {
             return false;
         } else {
-            reprogram_system_timer(datetime::timestamp::now(), inhibiter);
+            reprogram_system_timer_and_log(datetime::timestamp::now(),
+                                           inhibiter);
             return true;
         }
     }
@@ -327,6 +358,8 @@ public:
     ///
     /// Active timers are all those that fire on or before 'now'.
     ///
+    /// This runs from the SIGALRM handler, so it must not log.
+    ///
     /// \param now The current time.
     void
     fire(const datetime::timestamp& now)
@@ -335,7 +368,7 @@ public:
         {
             signals::interrupts_inhibiter inhibiter;
             to_run = compute_timers_to_run_and_prune_old(now, inhibiter);
-            reprogram_system_timer(now, inhibiter);
+            (void)reprogram_system_timer(now, inhibiter);
         }
 
         for (timers_vector::iterator iter = to_run.begin();
@@ -350,6 +383,16 @@ public:
 static std::auto_ptr< global_state > globals;
 
 
+/// Serializes accesses to the global state from different threads.
+///
+/// Threads must only acquire this lock while they have signals inhibited so
+/// that the SIGALRM handler cannot interrupt a thread that holds it.  The
+/// handler may then wait for the lock without deadlocking because the holder is
+/// necessarily a different thread.  The lock is recursive because the timer
+/// callbacks, which run with the lock held, may program or unprogram timers.
+static std::recursive_mutex globals_mutex;
+
+
 /// SIGALRM handler for the timer implementation.
 ///
 /// \param signo The signal received; must be SIGALRM.
@@ -357,7 +400,15 @@ static void
 sigalrm_handler(const int signo)
 {
     PRE(signo == SIGALRM);
-    globals->fire(datetime::timestamp::now());
+    const int original_errno = errno;
+    {
+        std::lock_guard< std::recursive_mutex > lock(globals_mutex);
+        // Another thread may have unprogrammed the last timer while we were
+        // waiting for the lock.
+        if (globals.get() != NULL)
+            globals->fire(datetime::timestamp::now());
+    }
+    errno = original_errno;
 }
 
 
@@ -393,9 +444,9 @@ struct utils::signals::timer::impl : utils::noncopyable {
 
     /// Whether this timer has fired already or not.
     ///
-    /// This is updated from an interrupt context, hence why it is marked
-    /// volatile.
-    volatile bool fired;
+    /// This is updated from an interrupt context, possibly on a thread other
+    /// than the one that owns the timer, hence why it is atomic.
+    std::atomic< bool > fired;
 
     /// Constructor.
     ///
@@ -421,6 +472,7 @@ struct utils::signals::timer::impl : utils::noncopyable {
 signals::timer::timer(const datetime::delta& delta)
 {
     signals::interrupts_inhibiter inhibiter;
+    std::lock_guard< std::recursive_mutex > lock(globals_mutex);
 
     const datetime::timestamp now = datetime::timestamp::now();
     _pimpl.reset(new impl(now + delta));
@@ -440,6 +492,7 @@ signals::timer::timer(const datetime::delta& delta)
 signals::timer::~timer(void)
 {
     signals::interrupts_inhibiter inhibiter;
+    std::lock_guard< std::recursive_mutex > lock(globals_mutex);
 
     if (_pimpl->programmed) {
         LW("Auto-destroying still-programmed signals::timer object");
@@ -519,6 +572,7 @@ void
 signals::timer::unprogram(void)
 {
     signals::interrupts_inhibiter inhibiter;
+    std::lock_guard< std::recursive_mutex > lock(globals_mutex);
 
     if (!_pimpl->programmed) {
         // We cannot assert that the timer is not programmed because it might
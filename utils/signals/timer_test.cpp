@@ -35,6 +35,7 @@ extern "C" {
 
 #include <cstddef>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 #include <atf-c++.hpp>
@@ -371,6 +372,29 @@ ATF_TEST_CASE_BODY(unprogram)
 }
 
 
+ATF_TEST_CASE(program_concurrent);
+ATF_TEST_CASE_HEAD(program_concurrent)
+{
+    set_md_var("timeout", "20");
+}
+ATF_TEST_CASE_BODY(program_concurrent)
+{
+    std::vector< std::thread > threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.push_back(std::thread([i] {
+            for (int j = 0; j < 5; ++j) {
+                signals::timer timer(datetime::delta(0, 10000 * (i + j + 1)));
+                while (!timer.fired())
+                    ::usleep(100);
+                timer.unprogram();
+            }
+        }));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+
 ATF_TEST_CASE(infinitesimal);
 ATF_TEST_CASE_HEAD(infinitesimal)
 {
@@ -422,5 +446,6 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, expire_before_firing);
     ATF_ADD_TEST_CASE(tcs, reprogram_from_scratch);
     ATF_ADD_TEST_CASE(tcs, unprogram);
+    ATF_ADD_TEST_CASE(tcs, program_concurrent);
     ATF_ADD_TEST_CASE(tcs, infinitesimal);
 }
@@ -52,6 +52,47 @@ using utils::none;
 using utils::optional;
 
 
+namespace {
+
+
+/// Maximum number of times to retry a backup step on a locked destination.
+static const int backup_max_attempts = 50;
+
+
+/// Time to wait between retries of a backup step, in milliseconds.
+static const int backup_retry_delay_ms = 100;
+
+
+/// Constructs a SQLite URI to open a file in immutable mode.
+///
+/// \param file The path to the database file.
+///
+/// \return A "file:" URI with all the special characters in the path escaped
+/// and with the immutable query parameter set.
+static std::string
+immutable_uri(const fs::path& file)
+{
+    static const char* hex = "0123456789abcdef";
+
+    std::string uri = "file:";
+    for (std::string::const_iterator iter = file.str().begin();
+         iter != file.str().end(); ++iter) {
+        const unsigned char ch = *iter;
+        if (ch == '%' || ch == '?' || ch == '#') {
+            uri += '%';
+            uri += hex[ch >> 4];
+            uri += hex[ch & 0x0f];
+        } else
+            uri += ch;
+    }
+    uri += "?immutable=1";
+    return uri;
+}
+
+
+}  // anonymous namespace
+
+
 /// Internal implementation for sqlite::database.
 struct utils::sqlite::database::impl : utils::noncopyable {
     /// Path to the database as seen at construction time.
@@ -96,6 +137,8 @@ struct utils::sqlite::database::impl : utils::noncopyable {
     ///
     /// \param file The path to the database file to be opened.
     /// \param flags The flags to be passed to the open routine.
+    /// \param display_name The name of the database to use in error messages,
+    ///     or NULL to use file.  Useful when file is a URI.
     ///
     /// \return The opened database.
     ///
@@ -103,7 +146,8 @@ struct utils::sqlite::database::impl : utils::noncopyable {
     ///     database.
     /// \throw api_error If there is any problem opening the database.
     static ::sqlite3*
-    safe_open(const char* file, const int flags)
+    safe_open(const char* file, const int flags,
+              const char* display_name = NULL)
     {
         ::sqlite3* db;
         const int error = ::sqlite3_open_v2(file, &db, flags, NULL);
@@ -111,8 +155,8 @@ struct utils::sqlite::database::impl : utils::noncopyable {
             if (db == NULL)
                 throw std::bad_alloc();
             else {
-                sqlite::database error_db(utils::make_optional(fs::path(file)),
-                                          db, true);
+                sqlite::database error_db(utils::make_optional(fs::path(
+                    display_name == NULL ? file : display_name)), db, true);
                 throw sqlite::api_error::from_database(error_db,
                                                        "sqlite3_open_v2");
             }
@@ -208,8 +252,20 @@ sqlite::database::open(const fs::path& file, int open_flags)
         flags |= SQLITE_OPEN_CREATE;
         open_flags &= ~open_create;
     }
+    const bool immutable = open_flags & open_immutable;
+    open_flags &= ~open_immutable;
     PRE(open_flags == 0);
-
+    PRE_MSG(!immutable || flags == SQLITE_OPEN_READONLY,
+            "Immutable databases can only be opened in read-only mode");
+
+#if SQLITE_VERSION_NUMBER >= 3008000
+    if (immutable) {
+        return database(utils::make_optional(file),
+                        impl::safe_open(immutable_uri(file).c_str(),
+                                        flags | SQLITE_OPEN_URI, file.c_str()),
+                        true);
+    }
+#endif
     return database(utils::make_optional(file),
                     impl::safe_open(file.c_str(), flags), true);
 }
@@ -326,3 +382,87 @@ sqlite::database::last_insert_rowid(void)
 {
     return ::sqlite3_last_insert_rowid(_pimpl->db);
 }
+
+
+/// Reads a range of bytes from a blob without loading the whole value.
+///
+/// This uses the incremental blob I/O of SQLite, so it is suitable to read
+/// huge values piece by piece.
+///
+/// \param table The name of the table holding the blob.
+/// \param column The name of the column holding the blob.
+/// \param rowid The row identifier of the row holding the blob.
+/// \param offset The position of the first byte to read.
+/// \param length The maximum number of bytes to read.
+///
+/// \return The requested bytes.  The result is shorter than length if the end
+/// of the blob is reached and empty if offset is past the end.
+///
+/// \throw api_error If the blob cannot be opened or read.
+std::string
+sqlite::database::read_blob(const char* table, const char* column,
+                            const int64_t rowid, const int64_t offset,
+                            const std::size_t length)
+{
+    PRE(offset >= 0);
+
+    ::sqlite3_blob* blob;
+    if (::sqlite3_blob_open(_pimpl->db, "main", table, column, rowid, 0,
+                            &blob) != SQLITE_OK)
+        throw api_error::from_database(*this, "sqlite3_blob_open");
+
+    const int64_t size = ::sqlite3_blob_bytes(blob);
+    std::string data;
+    if (offset < size) {
+        const int64_t available = size - offset;
+        data.resize(static_cast< int64_t >(length) < available ?
+                    length : static_cast< std::size_t >(available));
+        if (!data.empty() &&
+            ::sqlite3_blob_read(blob, &data[0], static_cast< int >(data.size()),
+                                static_cast< int >(offset)) != SQLITE_OK) {
+            const api_error error = api_error::from_database(
+                *this, "sqlite3_blob_read");
+            ::sqlite3_blob_close(blob);
+            throw error;
+        }
+    }
+
+    ::sqlite3_blob_close(blob);
+    return data;
+}
+
+
+/// Copies the contents of this database into another one.
+///
+/// This uses the online backup API of SQLite, so the destination is replaced
+/// atomically: readers of the destination see either its old contents or the
+/// new ones, and a crash in the middle of the copy leaves the old contents
+/// behind.
+///
+/// \param destination The database to overwrite.
+///
+/// \throw api_error If the copy fails or if the destination stays locked for
+///     too long.
+void
+sqlite::database::backup_to(database& destination)
+{
+    ::sqlite3_backup* backup = ::sqlite3_backup_init(
+        destination._pimpl->db, "main", _pimpl->db, "main");
+    if (backup == NULL)
+        throw api_error::from_database(destination, "sqlite3_backup_init");
+
+    int attempts = backup_max_attempts;
+    int error;
+    do {
+        error = ::sqlite3_backup_step(backup, -1);
+        if (error == SQLITE_BUSY || error == SQLITE_LOCKED) {
+            --attempts;
+            ::sqlite3_sleep(backup_retry_delay_ms);
+        }
+    } while ((error == SQLITE_BUSY || error == SQLITE_LOCKED) && attempts > 0);
+
+    // sqlite3_backup_finish() records any error from the steps above in the
+    // destination database, so it is safe to use it for error reporting.
+    if (::sqlite3_backup_finish(backup) != SQLITE_OK || error != SQLITE_DONE)
+        throw api_error::from_database(destination, "sqlite3_backup_step");
+}
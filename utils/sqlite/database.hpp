@@ -43,6 +43,7 @@ extern "C" {
 
 #include <cstddef>
 #include <memory>
+#include <string>
 
 #include "utils/fs/path_fwd.hpp"
 #include "utils/optional_fwd.hpp"
@@ -60,6 +61,12 @@ static const int open_readonly = 1 << 0;
 static const int open_readwrite = 1 << 1;
 /// Constant for the database::open flags: create on open.
 static const int open_create = 1 << 2;
+/// Constant for the database::open flags: the file will not change while open.
+///
+/// This is only valid in combination with open_readonly and allows SQLite to
+/// skip all locking and change detection.  Silently ignored if the SQLite
+/// library in use does not support immutable databases.
+static const int open_immutable = 1 << 3;
 
 
 /// A RAII model for the SQLite 3 database.
@@ -102,6 +109,10 @@ public:
     statement create_statement(const std::string&);
 
     int64_t last_insert_rowid(void);
+    std::string read_blob(const char*, const char*, const int64_t,
+                          const int64_t, const std::size_t);
+
+    void backup_to(database&);
 };
 
 
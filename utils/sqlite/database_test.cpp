@@ -81,6 +81,40 @@ ATF_TEST_CASE_BODY(open__readonly__fail)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(open__immutable__ok);
+ATF_TEST_CASE_BODY(open__immutable__ok)
+{
+    fs::mkdir(fs::path("dir?with#special%chars"), 0755);
+    const fs::path file("dir?with#special%chars/test.db");
+    {
+        sqlite::database db = sqlite::database::open(file,
+            sqlite::open_readwrite | sqlite::open_create);
+        create_test_table(raw(db));
+    }
+    {
+        sqlite::database db = sqlite::database::open(file,
+            sqlite::open_readonly | sqlite::open_immutable);
+        ATF_REQUIRE_EQ(file, db.db_filename().get());
+        verify_test_table(raw(db));
+    }
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(open__immutable__fail);
+ATF_TEST_CASE_BODY(open__immutable__fail)
+{
+    try {
+        sqlite::database::open(fs::path("missing.db"),
+                               sqlite::open_readonly | sqlite::open_immutable);
+        fail("api_error not raised");
+    } catch (const sqlite::api_error& e) {
+        ATF_REQUIRE_EQ("sqlite3_open_v2", e.api_function());
+        ATF_REQUIRE_EQ(fs::path("missing.db"), e.db_filename().get());
+    }
+    ATF_REQUIRE(!fs::exists(fs::path("missing.db")));
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(open__create__ok);
 ATF_TEST_CASE_BODY(open__create__ok)
 {
@@ -255,12 +289,86 @@ ATF_TEST_CASE_BODY(last_insert_rowid)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(read_blob__ok);
+ATF_TEST_CASE_BODY(read_blob__ok)
+{
+    sqlite::database db = sqlite::database::in_memory();
+    db.exec("CREATE TABLE test (a INTEGER PRIMARY KEY, b BLOB)");
+    db.exec("INSERT INTO test VALUES (3, X'0001020304050607')");
+
+    ATF_REQUIRE_EQ(std::string("\x00\x01\x02", 3),
+                   db.read_blob("test", "b", 3, 0, 3));
+    ATF_REQUIRE_EQ(std::string("\x05\x06\x07", 3),
+                   db.read_blob("test", "b", 3, 5, 100));
+    ATF_REQUIRE(db.read_blob("test", "b", 3, 8, 10).empty());
+    ATF_REQUIRE(db.read_blob("test", "b", 3, 20, 10).empty());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(read_blob__fail);
+ATF_TEST_CASE_BODY(read_blob__fail)
+{
+    sqlite::database db = sqlite::database::in_memory();
+    db.exec("CREATE TABLE test (a INTEGER PRIMARY KEY, b BLOB)");
+    db.exec("INSERT INTO test VALUES (3, X'00')");
+
+    ATF_REQUIRE_THROW_RE(sqlite::api_error, "no such rowid",
+                         db.read_blob("test", "b", 4, 0, 1));
+    ATF_REQUIRE_THROW_RE(sqlite::api_error, "no such column",
+                         db.read_blob("test", "c", 3, 0, 1));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(backup_to__ok);
+ATF_TEST_CASE_BODY(backup_to__ok)
+{
+    sqlite::database source = sqlite::database::in_memory();
+    source.exec("CREATE TABLE test (a INTEGER PRIMARY KEY, b TEXT)");
+    source.exec("INSERT INTO test VALUES (1, 'first')");
+
+    sqlite::database destination = sqlite::database::open(
+        fs::path("test.db"), sqlite::open_readwrite | sqlite::open_create);
+    destination.exec("CREATE TABLE old (a INTEGER)");
+    source.backup_to(destination);
+    source.exec("INSERT INTO test VALUES (2, 'second')");
+    source.backup_to(destination);
+    destination.close();
+
+    sqlite::database db = sqlite::database::open(fs::path("test.db"),
+                                                 sqlite::open_readonly);
+    sqlite::statement stmt = db.create_statement(
+        "SELECT group_concat(b) FROM test");
+    ATF_REQUIRE(stmt.step());
+    ATF_REQUIRE_EQ("first,second", stmt.column_text(0));
+    ATF_REQUIRE_THROW(sqlite::error, db.exec("SELECT * FROM old"));
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(backup_to__fail);
+ATF_TEST_CASE_BODY(backup_to__fail)
+{
+    sqlite::database source = sqlite::database::in_memory();
+    source.exec("CREATE TABLE test (a INTEGER)");
+
+    {
+        sqlite::database db = sqlite::database::open(
+            fs::path("test.db"), sqlite::open_readwrite | sqlite::open_create);
+        db.exec("CREATE TABLE test (a INTEGER)");
+    }
+    sqlite::database destination = sqlite::database::open(
+        fs::path("test.db"), sqlite::open_readonly);
+    ATF_REQUIRE_THROW(sqlite::api_error, source.backup_to(destination));
+}
+
+
 ATF_INIT_TEST_CASES(tcs)
 {
     ATF_ADD_TEST_CASE(tcs, in_memory);
 
     ATF_ADD_TEST_CASE(tcs, open__readonly__ok);
     ATF_ADD_TEST_CASE(tcs, open__readonly__fail);
+    ATF_ADD_TEST_CASE(tcs, open__immutable__ok);
+    ATF_ADD_TEST_CASE(tcs, open__immutable__fail);
     ATF_ADD_TEST_CASE(tcs, open__create__ok);
     ATF_ADD_TEST_CASE(tcs, open__create__fail);
 
@@ -284,4 +392,10 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, create_statement__fail);
 
     ATF_ADD_TEST_CASE(tcs, last_insert_rowid);
+
+    ATF_ADD_TEST_CASE(tcs, read_blob__ok);
+    ATF_ADD_TEST_CASE(tcs, read_blob__fail);
+
+    ATF_ADD_TEST_CASE(tcs, backup_to__ok);
+    ATF_ADD_TEST_CASE(tcs, backup_to__fail);
 }
@@ -32,7 +32,10 @@ extern "C" {
 #include <sqlite3.h>
 }
 
+#include <cstring>
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "utils/defs.hpp"
 #include "utils/format/macros.hpp"
@@ -111,6 +114,17 @@ struct utils::sqlite::statement::impl : utils::noncopyable {
     /// Cache for the column names in a statement; lazily initialized.
     std::map< std::string, int > column_cache;
 
+    /// Cache of recently-resolved column name pointers to their identifiers.
+    ///
+    /// Callers almost always query columns by passing string literals, so
+    /// remembering the pointers we have already resolved lets us skip the
+    /// construction of a std::string and the lookup in column_cache for every
+    /// cell that is read.  The pointers are only used as a hint: an entry is
+    /// only valid if the pointed-to name also matches.
+    std::vector< std::pair< const char*,
+                            std::map< std::string, int >::const_iterator > >
+        column_hints;
+
     /// Constructor.
     ///
     /// \param db_ The database this statement belongs to.  Be aware that we
@@ -250,6 +264,17 @@ sqlite::statement::column_type(const int index)
 int
 sqlite::statement::column_id(const char* name)
 {
+    typedef std::map< std::string, int >::const_iterator cache_iterator;
+    typedef std::vector< std::pair< const char*, cache_iterator > > hints_vector;
+
+    hints_vector& hints = _pimpl->column_hints;
+    for (hints_vector::const_iterator iter = hints.begin();
+         iter != hints.end(); ++iter) {
+        if ((*iter).first == name &&
+            std::strcmp(name, (*iter).second->first.c_str()) == 0)
+            return (*iter).second->second;
+    }
+
     std::map< std::string, int >& cache = _pimpl->column_cache;
 
     if (cache.empty()) {
@@ -260,11 +285,15 @@ sqlite::statement::column_id(const char* name)
         }
     }
 
-    const std::map< std::string, int >::const_iterator iter = cache.find(name);
+    const cache_iterator iter = cache.find(name);
     if (iter == cache.end())
         throw invalid_column_error(_pimpl->db.db_filename(), name);
-    else
-        return (*iter).second;
+
+    // Bound the number of hints so that callers passing dynamically-allocated
+    // names cannot grow the cache indefinitely.
+    if (hints.size() < cache.size() * 2)
+        hints.push_back(std::make_pair(name, iter));
+    return (*iter).second;
 }
 
 
@@ -201,6 +201,33 @@ ATF_TEST_CASE_BODY(column_id__ok)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(column_id__reused_names);
+ATF_TEST_CASE_BODY(column_id__reused_names)
+{
+    sqlite::database db = sqlite::database::in_memory();
+    db.exec("CREATE TABLE foo (bar INTEGER PRIMARY KEY, "
+            "                  baz INTEGER);"
+            "INSERT INTO foo VALUES (1, 2);");
+    sqlite::statement stmt = db.create_statement("SELECT * FROM foo");
+    ATF_REQUIRE(stmt.step());
+
+    // Reuse the same buffer for different names to ensure that the lookups do
+    // not just rely on the address of the names.
+    char name[4];
+    std::strcpy(name, "bar");
+    ATF_REQUIRE_EQ(0, stmt.column_id(name));
+    std::strcpy(name, "baz");
+    ATF_REQUIRE_EQ(1, stmt.column_id(name));
+    std::strcpy(name, "bar");
+    ATF_REQUIRE_EQ(0, stmt.column_id(name));
+
+    const std::string other_name("baz");
+    ATF_REQUIRE_EQ(1, stmt.column_id(other_name.c_str()));
+    ATF_REQUIRE_EQ(1, stmt.column_id("baz"));
+    ATF_REQUIRE(!stmt.step());
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(column_id__missing);
 ATF_TEST_CASE_BODY(column_id__missing)
 {
@@ -738,6 +765,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, column_type__out_of_range);
 
     ATF_ADD_TEST_CASE(tcs, column_id__ok);
+    ATF_ADD_TEST_CASE(tcs, column_id__reused_names);
     ATF_ADD_TEST_CASE(tcs, column_id__missing);
 
     ATF_ADD_TEST_CASE(tcs, column_blob);
@@ -28,6 +28,12 @@
 
 #include "utils/text/operations.ipp"
 
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
+#include <cstring>
+#include <ostream>
 #include <sstream>
 
 #include "utils/format/macros.hpp"
@@ -36,6 +42,210 @@
 namespace text = utils::text;
 
 
+namespace {
+
+
+/// Checks if a character has to be escaped to be placed in an XML document.
+///
+/// The list of XML special characters is specified here:
+///     http://www.w3.org/TR/xml11/#charsets
+///
+/// \param c The character to check.
+///
+/// \return True if the character needs escaping; false otherwise.
+static bool
+needs_escaping(const unsigned char c)
+{
+    return (c == '"' || c == '&' || c == '<' || c == '>' || c == '\'' ||
+            (c >= 0x01 && c <= 0x08) ||
+            (c >= 0x0B && c <= 0x0C) ||
+            (c >= 0x0E && c <= 0x1F) ||
+            (c >= 0x7F && c <= 0x84) ||
+            (c >= 0x86 && c <= 0x9F));
+}
+
+
+#if defined(__SSE2__)
+/// Computes which bytes of a block need escaping.
+///
+/// This is a vectorized version of needs_escaping() and must be kept in sync
+/// with it.
+///
+/// \param block The 16 bytes to check.
+///
+/// \return A mask with all bits set for the bytes that need escaping.
+static __m128i
+needs_escaping(const __m128i block)
+{
+    // Bytes in the [0x00,0x1F] range except for NUL, tab, LF and CR.
+    const __m128i low = _mm_set1_epi8(0x1F);
+    __m128i mask = _mm_cmpeq_epi8(_mm_min_epu8(block, low), block);
+    mask = _mm_andnot_si128(
+        _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_setzero_si128()),
+                         _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')),
+                         _mm_cmpeq_epi8(block, _mm_set1_epi8('\r')))),
+        mask);
+
+    // Bytes in the [0x7F,0x9F] range except for NEL.
+    const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8(0x7F));
+    const __m128i high = _mm_andnot_si128(
+        _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast< char >(0x85))),
+        _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(0x20)), shifted));
+    mask = _mm_or_si128(mask, high);
+
+    // Characters that have their own entity.
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(block, _mm_set1_epi8('"')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(block, _mm_set1_epi8('&')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(block, _mm_set1_epi8('<')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(block, _mm_set1_epi8('>')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(block, _mm_set1_epi8('\'')));
+    return mask;
+}
+#endif
+
+
+/// Computes the length of the prefix of a buffer that needs no escaping.
+///
+/// \param data The buffer to scan.
+/// \param length The length of the buffer.
+///
+/// \return The number of leading bytes that can be copied verbatim.
+static std::size_t
+safe_prefix(const char* data, const std::size_t length)
+{
+    std::size_t pos = 0;
+#if defined(__SSE2__)
+    for (; pos + sizeof(__m128i) <= length; pos += sizeof(__m128i)) {
+        const __m128i block = _mm_loadu_si128(
+            reinterpret_cast< const __m128i* >(data + pos));
+        const int mask = _mm_movemask_epi8(needs_escaping(block));
+        if (mask != 0)
+            return pos + __builtin_ctz(mask);
+    }
+#endif
+    while (pos < length &&
+           !needs_escaping(static_cast< unsigned char >(data[pos])))
+        ++pos;
+    return pos;
+}
+
+
+/// Adapter to append escaped text to a string.
+class string_sink {
+    /// The string to append to.
+    std::string& _output;
+
+public:
+    /// Constructor.
+    ///
+    /// \param output_ The string to append to.
+    explicit string_sink(std::string& output_) : _output(output_)
+    {
+    }
+
+    /// Appends a buffer to the output.
+    ///
+    /// \param data The buffer to append.
+    /// \param length The length of the buffer.
+    void
+    append(const char* data, const std::size_t length)
+    {
+        _output.append(data, length);
+    }
+};
+
+
+/// Adapter to write escaped text to a stream.
+class stream_sink {
+    /// The stream to write to.
+    std::ostream& _output;
+
+public:
+    /// Constructor.
+    ///
+    /// \param output_ The stream to write to.
+    explicit stream_sink(std::ostream& output_) : _output(output_)
+    {
+    }
+
+    /// Appends a buffer to the output.
+    ///
+    /// \param data The buffer to append.
+    /// \param length The length of the buffer.
+    void
+    append(const char* data, const std::size_t length)
+    {
+        _output.write(data, length);
+    }
+};
+
+
+/// Escapes a single character.
+///
+/// \param c The character to escape.  needs_escaping(c) must be true.
+/// \param [in,out] sink The adapter to write the escaped character to.
+template< class Sink >
+static void
+escape_char(const char c, Sink& sink)
+{
+    switch (c) {
+    case '"': sink.append("&quot;", 6); break;
+    case '&': sink.append("&amp;", 5); break;
+    case '<': sink.append("&lt;", 4); break;
+    case '>': sink.append("&gt;", 4); break;
+    case '\'': sink.append("&apos;", 6); break;
+    default: {
+        // for RestrictedChar characters, escape them
+        // as '&amp;#[decimal ASCII value];'
+        // so that in the XML file we will see the escaped
+        // character.
+        char entity[32];
+        char* last = entity + sizeof(entity);
+        *--last = ';';
+        std::string::size_type value =
+            static_cast< std::string::size_type >(c);
+        do {
+            *--last = static_cast< char >('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        static const char prefix[] = "&amp;#";
+        last -= sizeof(prefix) - 1;
+        std::memcpy(last, prefix, sizeof(prefix) - 1);
+        sink.append(last, entity + sizeof(entity) - last);
+    }
+    }
+}
+
+
+/// Escapes a string, copying runs of safe characters in bulk.
+///
+/// \param in The input to quote.
+/// \param [in,out] sink The adapter to write the quoted text to.
+template< class Sink >
+static void
+escape_into(const std::string& in, Sink& sink)
+{
+    const char* data = in.data();
+    const std::size_t length = in.length();
+
+    std::size_t pos = 0;
+    while (pos < length) {
+        const std::size_t safe = safe_prefix(data + pos, length - pos);
+        sink.append(data + pos, safe);
+        pos += safe;
+        if (pos < length) {
+            escape_char(data[pos], sink);
+            ++pos;
+        }
+    }
+}
+
+
+}  // anonymous namespace
+
+
 /// Replaces XML special characters from an input string.
 ///
 /// The list of XML special characters is specified here:
@@ -47,37 +257,26 @@ namespace text = utils::text;
 std::string
 text::escape_xml(const std::string& in)
 {
-    std::ostringstream quoted;
+    std::string quoted;
+    quoted.reserve(in.length());
+    string_sink sink(quoted);
+    escape_into(in, sink);
+    return quoted;
+}
 
-    for (std::string::const_iterator it = in.begin();
-         it != in.end(); ++it) {
-        unsigned char c = (unsigned char)*it;
-        if (c == '"') {
-            quoted << "&quot;";
-        } else if (c == '&') {
-            quoted << "&amp;";
-        } else if (c == '<') {
-            quoted << "&lt;";
-        } else if (c == '>') {
-            quoted << "&gt;";
-        } else if (c == '\'') {
-            quoted << "&apos;";
-        } else if ((c >= 0x01 && c <= 0x08) ||
-                   (c >= 0x0B && c <= 0x0C) ||
-                   (c >= 0x0E && c <= 0x1F) ||
-                   (c >= 0x7F && c <= 0x84) ||
-                   (c >= 0x86 && c <= 0x9F)) {
-            // for RestrictedChar characters, escape them
-            // as '&amp;#[decimal ASCII value];'
-            // so that in the XML file we will see the escaped
-            // character.
-            quoted << "&amp;#" << static_cast< std::string::size_type >(*it)
-                   << ";";
-        } else {
-            quoted << *it;
-        }
-    }
-    return quoted.str();
+
+/// Writes a string to a stream replacing XML special characters.
+///
+/// This is equivalent to writing the result of escape_xml(in) to the stream
+/// but does not build the quoted copy of the input in memory.
+///
+/// \param output The stream to write to.
+/// \param in The input to quote.
+void
+text::escape_xml(std::ostream& output, const std::string& in)
+{
+    stream_sink sink(output);
+    escape_into(in, sink);
 }
 
 
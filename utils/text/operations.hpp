@@ -33,6 +33,7 @@
 #define UTILS_TEXT_OPERATIONS_HPP
 
 #include <cstddef>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -41,6 +42,7 @@ namespace text {
 
 
 std::string escape_xml(const std::string&);
+void escape_xml(std::ostream&, const std::string&);
 std::string quote(const std::string&, const char);
 
 
@@ -0,0 +1,151 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file utils/text/operations_bench.cpp
+/// Benchmark for the escaping of XML special characters.
+///
+/// This program generates a synthetic test output of a configurable size (64 MB
+/// by default) that resembles the logs that reports embed and then measures how
+/// long it takes to escape it into a string and into a stream.
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "utils/datetime.hpp"
+#include "utils/format/macros.hpp"
+#include "utils/text/operations.hpp"
+
+namespace datetime = utils::datetime;
+namespace text = utils::text;
+
+
+namespace {
+
+
+/// Default size of the synthetic input, in bytes.
+static const long default_size = 64 * 1024 * 1024;
+
+
+/// Number of times to repeat every measurement.
+static const int rounds = 5;
+
+
+/// Prints the duration of a benchmark phase.
+///
+/// \param phase Name of the phase being reported.
+/// \param start The time the phase started at.
+/// \param size The number of bytes processed by the phase.
+static void
+report(const char* phase, const datetime::timestamp& start, const long size)
+{
+    const int64_t usecs = (datetime::timestamp::now() - start)
+        .to_microseconds();
+    std::cout << F("%s: %s bytes in %s.%06ss (%s MB/s)\n")
+        % phase % size % (usecs / 1000000) % (usecs % 1000000)
+        % (usecs == 0 ? 0 : size / usecs);
+}
+
+
+/// Generates a synthetic test output.
+///
+/// The output consists of lines of plain text with an occasional character
+/// that needs escaping, as is typical of compiler and test logs.
+///
+/// \param size The number of bytes to generate.
+///
+/// \return The generated text.
+static std::string
+generate(const long size)
+{
+    static const char* lines[] = {
+        "Running test case with a fairly long line of plain output text\n",
+        "    expected: value == 3; got: value == 4 in foo.cpp:123\n",
+        "Checking that 'a' < 'b' && \"c\" > \"d\" holds\n",
+        "\tprogress: 42% done, no special characters here at all\n",
+        "\x1b[1mbold terminal escape\x1b[0m\n",
+    };
+    static const std::size_t num_lines = sizeof(lines) / sizeof(lines[0]);
+
+    std::string output;
+    output.reserve(size);
+    for (std::size_t i = 0; output.length() < static_cast< std::size_t >(size);
+         ++i) {
+        output += lines[(i * 7) % num_lines];
+    }
+    output.resize(size);
+    return output;
+}
+
+
+}  // anonymous namespace
+
+
+/// Program entry point.
+///
+/// \param argc Number of command-line arguments.
+/// \param argv The command-line arguments.  The only optional argument is the
+///     size of the input to escape in bytes.
+///
+/// \return An exit code.
+int
+main(const int argc, const char* const* const argv)
+{
+    long size = default_size;
+    if (argc > 1)
+        size = std::atol(argv[1]);
+
+    const std::string input = generate(size);
+
+    std::string::size_type expected_length = 0;
+    for (int i = 0; i < rounds; ++i) {
+        const datetime::timestamp start = datetime::timestamp::now();
+        const std::string output = text::escape_xml(input);
+        report("escape to string", start, size);
+        expected_length = output.length();
+    }
+
+    std::ofstream null("/dev/null");
+    if (!null) {
+        std::cerr << "Cannot open /dev/null\n";
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < rounds; ++i) {
+        const datetime::timestamp start = datetime::timestamp::now();
+        text::escape_xml(null, input);
+        null.flush();
+        report("escape to stream", start, size);
+    }
+
+    if (expected_length < input.length()) {
+        std::cerr << "Escaped output is shorter than its input\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
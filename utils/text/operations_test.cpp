@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -43,6 +44,63 @@ namespace text = utils::text;
 namespace {
 
 
+/// Reference implementation of text::escape_xml() for differential testing.
+///
+/// This is a straightforward character-by-character implementation of the
+/// escaping rules that the optimized code must match exactly.
+///
+/// \param in The input to quote.
+///
+/// \return A quoted string without any XML special characters.
+static std::string
+reference_escape_xml(const std::string& in)
+{
+    std::ostringstream quoted;
+
+    for (std::string::const_iterator it = in.begin();
+         it != in.end(); ++it) {
+        unsigned char c = (unsigned char)*it;
+        if (c == '"') {
+            quoted << "&quot;";
+        } else if (c == '&') {
+            quoted << "&amp;";
+        } else if (c == '<') {
+            quoted << "&lt;";
+        } else if (c == '>') {
+            quoted << "&gt;";
+        } else if (c == '\'') {
+            quoted << "&apos;";
+        } else if ((c >= 0x01 && c <= 0x08) ||
+                   (c >= 0x0B && c <= 0x0C) ||
+                   (c >= 0x0E && c <= 0x1F) ||
+                   (c >= 0x7F && c <= 0x84) ||
+                   (c >= 0x86 && c <= 0x9F)) {
+            quoted << "&amp;#" << static_cast< std::string::size_type >(*it)
+                   << ";";
+        } else {
+            quoted << *it;
+        }
+    }
+    return quoted.str();
+}
+
+
+/// Checks that both forms of text::escape_xml() match the reference.
+///
+/// \param in The input to quote.
+static void
+check_escape_xml(const std::string& in)
+{
+    const std::string expected = reference_escape_xml(in);
+    ATF_REQUIRE(expected == text::escape_xml(in));
+
+    std::ostringstream output;
+    output << "prefix";
+    text::escape_xml(output, in);
+    ATF_REQUIRE(output.str() == "prefix" + expected);
+}
+
+
 /// Tests text::refill() on an input string with a range of widths.
 ///
 /// \param expected The expected refilled paragraph.
@@ -96,6 +154,61 @@ ATF_TEST_CASE_BODY(escape_xml__some_escaping)
 }
 
 
+ATF_TEST_CASE_WITHOUT_HEAD(escape_xml__stream);
+ATF_TEST_CASE_BODY(escape_xml__stream)
+{
+    std::ostringstream output;
+    text::escape_xml(output, "");
+    ATF_REQUIRE_EQ("", output.str());
+    text::escape_xml(output, "a <b> & 'c'");
+    ATF_REQUIRE_EQ("a &lt;b&gt; &amp; &apos;c&apos;", output.str());
+    text::escape_xml(output, "\b\"");
+    ATF_REQUIRE_EQ("a &lt;b&gt; &amp; &apos;c&apos;&amp;#8;&quot;",
+                   output.str());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(escape_xml__all_bytes);
+ATF_TEST_CASE_BODY(escape_xml__all_bytes)
+{
+    // Place every byte at every offset within a block so that both the
+    // vectorized and the scalar scanners see it.
+    for (int c = 0; c < 256; ++c) {
+        for (std::size_t offset = 0; offset < 40; ++offset) {
+            std::string in(40, 'x');
+            in[offset] = static_cast< char >(c);
+            check_escape_xml(in);
+            check_escape_xml(in.substr(0, offset + 1));
+        }
+    }
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(escape_xml__differential);
+ATF_TEST_CASE_BODY(escape_xml__differential)
+{
+    static const char alphabet[] = "abc \t\n\r\"&<>'\x01\x08\x0b\x1f\x7f"
+        "\x80\x84\x85\x86\x9f\xa0\xff";
+    const std::string chars(alphabet, sizeof(alphabet) - 1);
+
+    unsigned long seed = 1;
+    for (std::size_t length = 0; length < 300; ++length) {
+        for (int density = 1; density <= 64; density *= 4) {
+            std::string in;
+            for (std::size_t i = 0; i < length; ++i) {
+                seed = seed * 1103515245 + 12345;
+                const unsigned long value = (seed >> 16) & 0x7fff;
+                if (value % density == 0)
+                    in += chars[value % chars.length()];
+                else
+                    in += static_cast< char >('a' + value % 26);
+            }
+            check_escape_xml(in);
+        }
+    }
+}
+
+
 ATF_TEST_CASE_WITHOUT_HEAD(quote__empty);
 ATF_TEST_CASE_BODY(quote__empty)
 {
@@ -398,6 +511,9 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, escape_xml__empty);
     ATF_ADD_TEST_CASE(tcs, escape_xml__no_escaping);
     ATF_ADD_TEST_CASE(tcs, escape_xml__some_escaping);
+    ATF_ADD_TEST_CASE(tcs, escape_xml__stream);
+    ATF_ADD_TEST_CASE(tcs, escape_xml__all_bytes);
+    ATF_ADD_TEST_CASE(tcs, escape_xml__differential);
 
     ATF_ADD_TEST_CASE(tcs, quote__empty);
     ATF_ADD_TEST_CASE(tcs, quote__no_escaping);
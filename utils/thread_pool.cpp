@@ -0,0 +1,208 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "utils/thread_pool.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils/logging/macros.hpp"
+#include "utils/sanity.hpp"
+#include "utils/signals/interrupts.hpp"
+
+namespace signals = utils::signals;
+
+
+/// Internal implementation for thread_pool.
+struct utils::thread_pool::impl : utils::noncopyable {
+    /// Protects all the fields below.
+    std::mutex mutex;
+
+    /// Signaled when new tasks are queued or when the pool is shutting down.
+    std::condition_variable work_available;
+
+    /// Signaled when the pool becomes idle.
+    std::condition_variable work_done;
+
+    /// Tasks waiting for a worker.
+    std::deque< task > pending;
+
+    /// Number of tasks being run by the workers.
+    std::size_t running;
+
+    /// First exception raised by a task since the last call to wait().
+    std::exception_ptr first_error;
+
+    /// Whether the workers have to terminate once the queue is empty.
+    bool stopping;
+
+    /// The worker threads.
+    std::vector< std::thread > workers;
+
+    /// Constructor.
+    impl(void) :
+        running(0),
+        stopping(false)
+    {
+    }
+
+    /// Body of every worker thread.
+    void
+    worker(void)
+    {
+        // Leave the handling of signals to the threads not in the pool, which
+        // are the ones that know how to react to them.
+        signals::interrupts_inhibiter inhibiter;
+
+        std::unique_lock< std::mutex > lock(mutex);
+        for (;;) {
+            work_available.wait(lock, [this] {
+                return stopping || !pending.empty(); });
+            if (pending.empty()) {
+                INV(stopping);
+                break;
+            }
+
+            const task current = pending.front();
+            pending.pop_front();
+            ++running;
+
+            lock.unlock();
+            std::exception_ptr error;
+            try {
+                current();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+
+            if (error && !first_error)
+                first_error = error;
+            --running;
+            if (running == 0 && pending.empty())
+                work_done.notify_all();
+        }
+    }
+};
+
+
+/// Constructor; starts the worker threads.
+///
+/// \param num_threads Number of worker threads to start.  Must be positive.
+///
+/// \throw std::system_error If any of the threads cannot be created.
+utils::thread_pool::thread_pool(const std::size_t num_threads) :
+    _pimpl(new impl())
+{
+    PRE(num_threads > 0);
+
+    try {
+        for (std::size_t i = 0; i < num_threads; ++i)
+            _pimpl->workers.push_back(
+                std::thread(&impl::worker, _pimpl.get()));
+    } catch (...) {
+        {
+            std::lock_guard< std::mutex > lock(_pimpl->mutex);
+            _pimpl->stopping = true;
+        }
+        _pimpl->work_available.notify_all();
+        for (std::thread& worker : _pimpl->workers)
+            worker.join();
+        throw;
+    }
+}
+
+
+/// Destructor; runs any pending tasks and stops the worker threads.
+///
+/// Errors raised by the tasks that have not yet been collected by wait() are
+/// lost.  The caller should call wait() on its own to process them.
+utils::thread_pool::~thread_pool(void)
+{
+    {
+        std::lock_guard< std::mutex > lock(_pimpl->mutex);
+        _pimpl->stopping = true;
+    }
+    _pimpl->work_available.notify_all();
+    for (std::thread& worker : _pimpl->workers)
+        worker.join();
+
+    if (_pimpl->first_error)
+        LW("Destroying thread_pool with uncollected task errors");
+}
+
+
+/// Gets the number of worker threads in the pool.
+///
+/// \return The number of threads given to the constructor.
+std::size_t
+utils::thread_pool::size(void) const
+{
+    return _pimpl->workers.size();
+}
+
+
+/// Queues a task to run in the pool.
+///
+/// \param new_task The task to run.  Exceptions raised by the task are reported
+///     by the next call to wait().
+void
+utils::thread_pool::submit(const task& new_task)
+{
+    {
+        std::lock_guard< std::mutex > lock(_pimpl->mutex);
+        PRE(!_pimpl->stopping);
+        _pimpl->pending.push_back(new_task);
+    }
+    _pimpl->work_available.notify_one();
+}
+
+
+/// Waits until all queued tasks have completed.
+///
+/// \throw Any exception raised by the tasks that completed since the previous
+///     call to this function.  If more than one task failed, only the error of
+///     the first one to complete is reported.
+void
+utils::thread_pool::wait(void)
+{
+    std::exception_ptr error;
+    {
+        std::unique_lock< std::mutex > lock(_pimpl->mutex);
+        _pimpl->work_done.wait(lock, [this] {
+            return _pimpl->running == 0 && _pimpl->pending.empty(); });
+        error = _pimpl->first_error;
+        _pimpl->first_error = std::exception_ptr();
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
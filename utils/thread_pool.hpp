@@ -0,0 +1,86 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file utils/thread_pool.hpp
+/// Fixed-size pool of worker threads.
+///
+/// The modules of the utils library can be used from several threads at once
+/// with the following rules:
+///
+/// * The environment (utils::env), the logging facilities (utils::logging), the
+///   mock time (utils::datetime) and the registry of processes to kill on an
+///   interrupt (utils::signals::add_pid_to_kill) are internally synchronized.
+///
+/// * Signal masks are per-thread: a signals::interrupts_inhibiter only blocks
+///   signals in the thread that creates it.  Threads of this pool run with
+///   interrupts inhibited so that signal handlers never run on them.
+///
+/// * Any other object must not be accessed concurrently from more than one
+///   thread unless its documentation says otherwise.
+
+#if !defined(UTILS_THREAD_POOL_HPP)
+#define UTILS_THREAD_POOL_HPP
+
+#include "utils/thread_pool_fwd.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "utils/noncopyable.hpp"
+
+namespace utils {
+
+
+/// Fixed-size pool of worker threads that run queued tasks.
+///
+/// Tasks run in the order in which they are submitted, though several of them
+/// may run at once in different threads.
+class thread_pool : noncopyable {
+    struct impl;
+
+    /// Pointer to the shared internal implementation.
+    std::auto_ptr< impl > _pimpl;
+
+public:
+    /// Type of the tasks that run on the pool.
+    typedef std::function< void (void) > task;
+
+    explicit thread_pool(const std::size_t);
+    ~thread_pool(void);
+
+    std::size_t size(void) const;
+
+    void submit(const task&);
+    void wait(void);
+};
+
+
+}  // namespace utils
+
+#endif  // !defined(UTILS_THREAD_POOL_HPP)
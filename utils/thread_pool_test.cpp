@@ -0,0 +1,141 @@
+// Copyright 2026 The Kyua Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors
+//   may be used to endorse or promote products derived from this software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "utils/thread_pool.hpp"
+
+extern "C" {
+#include <signal.h>
+}
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <atf-c++.hpp>
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(size);
+ATF_TEST_CASE_BODY(size)
+{
+    utils::thread_pool pool(3);
+    ATF_REQUIRE_EQ(3, pool.size());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(submit__run_all);
+ATF_TEST_CASE_BODY(submit__run_all)
+{
+    std::vector< std::atomic< int > > counters(100);
+    for (std::atomic< int >& counter : counters)
+        counter = 0;
+
+    utils::thread_pool pool(4);
+    for (std::size_t i = 0; i < counters.size(); ++i)
+        pool.submit([&counters, i] { ++counters[i]; });
+    pool.wait();
+
+    for (const std::atomic< int >& counter : counters)
+        ATF_REQUIRE_EQ(1, counter.load());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(wait__reuse);
+ATF_TEST_CASE_BODY(wait__reuse)
+{
+    std::atomic< int > counter(0);
+
+    utils::thread_pool pool(2);
+    for (int round = 1; round <= 3; ++round) {
+        for (int i = 0; i < 10; ++i)
+            pool.submit([&counter] { ++counter; });
+        pool.wait();
+        ATF_REQUIRE_EQ(round * 10, counter.load());
+    }
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(wait__error);
+ATF_TEST_CASE_BODY(wait__error)
+{
+    std::atomic< int > counter(0);
+
+    utils::thread_pool pool(2);
+    pool.submit([] { throw std::runtime_error("Task failed"); });
+    for (int i = 0; i < 10; ++i)
+        pool.submit([&counter] { ++counter; });
+    ATF_REQUIRE_THROW_RE(std::runtime_error, "Task failed", pool.wait());
+    ATF_REQUIRE_EQ(10, counter.load());
+
+    // The error is only reported once.
+    pool.wait();
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(destructor__run_pending);
+ATF_TEST_CASE_BODY(destructor__run_pending)
+{
+    std::atomic< int > counter(0);
+    {
+        utils::thread_pool pool(1);
+        for (int i = 0; i < 50; ++i)
+            pool.submit([&counter] { ++counter; });
+    }
+    ATF_REQUIRE_EQ(50, counter.load());
+}
+
+
+ATF_TEST_CASE_WITHOUT_HEAD(workers__signals_inhibited);
+ATF_TEST_CASE_BODY(workers__signals_inhibited)
+{
+    std::atomic< bool > blocked(false);
+
+    utils::thread_pool pool(1);
+    pool.submit([&blocked] {
+        ::sigset_t mask;
+        ATF_REQUIRE(::pthread_sigmask(SIG_BLOCK, NULL, &mask) == 0);
+        blocked = sigismember(&mask, SIGINT) && sigismember(&mask, SIGTERM);
+    });
+    pool.wait();
+
+    ATF_REQUIRE(blocked.load());
+}
+
+
+ATF_INIT_TEST_CASES(tcs)
+{
+    ATF_ADD_TEST_CASE(tcs, size);
+
+    ATF_ADD_TEST_CASE(tcs, submit__run_all);
+
+    ATF_ADD_TEST_CASE(tcs, wait__reuse);
+    ATF_ADD_TEST_CASE(tcs, wait__error);
+
+    ATF_ADD_TEST_CASE(tcs, destructor__run_pending);
+
+    ATF_ADD_TEST_CASE(tcs, workers__signals_inhibited);
+}